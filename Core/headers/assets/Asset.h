@@ -1,5 +1,6 @@
 #pragma once
 #include "util/UUID.h"
+#include <atomic>
 
 namespace SNAKE {
 	class Asset {
@@ -9,20 +10,45 @@ namespace SNAKE {
 		virtual ~Asset() = default;
 
 		uint64_t GetRefCount() const noexcept {
-			return ref_count;
+			return ref_count.load(std::memory_order_acquire);
 		}
 
 		UUID<uint64_t> uuid;
 
+		// Set through AssetManager::SetFilepath so the asset can be found by it
 		std::string filepath;
 
 		std::string name = "Unnamed asset";
 
+		// Hash of the data the asset was loaded from for content-addressed assets (meshes, textures), 0 otherwise, see AssetManager::SetContentHash
+		uint64_t content_hash = 0;
+
 	private:
-		// Number of AssetRef objects referencing this asset
-		uint64_t ref_count = 0;
+		// Number of AssetRef objects referencing this asset, AssetRefs are created and destroyed on JobSystem workers too
+		// A new reference is always made from an existing one or a pointer the thread already has, so incrementing needs no ordering
+		std::atomic<uint64_t> ref_count = 0;
+
+		void AddRef() noexcept {
+			ref_count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Orders the releasing thread's use of the asset before whoever sees the count drop, e.g. AssetManager::DeleteAsset's check
+		void Release() noexcept {
+			ref_count.fetch_sub(1, std::memory_order_acq_rel);
+		}
+
+		// Key of the asset in AssetManager's path index, empty if it isn't indexed
+		std::string indexed_path;
+
+		// Position in AssetManager's list of assets of the same type
+		uint32_t type_list_idx = 0;
+
+		// AssetHandle<T>::value of the asset, see AssetManager::GetHandle
+		uint32_t handle = 0;
 
 		template <typename T> friend class AssetRef;
+		template <std::derived_from<Asset> T> friend struct AssetTypeList;
+		friend class AssetManager;
 	};
 
 	template<typename AssetT>
@@ -30,27 +56,28 @@ namespace SNAKE {
 	public:
 		AssetRef() = delete;
 
-		~AssetRef() { if (p_asset) p_asset->ref_count--; }
-		AssetRef(AssetT& _asset) : p_asset(&_asset) { p_asset->ref_count++; };
-		AssetRef(AssetT* _asset) : p_asset(_asset) { if (p_asset) p_asset->ref_count++; };
-		AssetRef(const AssetRef& other) : p_asset(other.p_asset) { if (p_asset) p_asset->ref_count++; };
+		~AssetRef() { if (p_asset) p_asset->Release(); }
+		AssetRef(AssetT& _asset) : p_asset(&_asset) { p_asset->AddRef(); };
+		AssetRef(AssetT* _asset) : p_asset(_asset) { if (p_asset) p_asset->AddRef(); };
+		AssetRef(const AssetRef& other) : p_asset(other.p_asset) { if (p_asset) p_asset->AddRef(); };
 		AssetRef(AssetRef&& other) noexcept : p_asset(other.p_asset) { other.p_asset = nullptr; };
 		AssetRef& operator=(const AssetRef& other) {
 			if (this == &other)
 				return *this;
 
-			if (p_asset) p_asset->ref_count--;
+			// Added first so the count never drops to zero between the two when both refer to the same asset
+			if (other.p_asset) other.p_asset->AddRef();
+			if (p_asset) p_asset->Release();
 			p_asset = other.p_asset;
-			if (p_asset) p_asset->ref_count++;
 			return *this;
 		};
 
 		void SetAsset(AssetT* _asset) {
+			_asset->AddRef();
 			if (p_asset) 
-				p_asset->ref_count--;
+				p_asset->Release();
 
 			p_asset = _asset;
-			_asset->ref_count++;
 		}
 
 		AssetT* get() const {
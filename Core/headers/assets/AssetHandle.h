@@ -0,0 +1,120 @@
+#pragma once
+#include "assets/Asset.h"
+#include "util/util.h"
+
+namespace SNAKE {
+	/*
+	32-bit reference to an asset of concrete type T for hot render data, resolve it with AssetManager::Resolve where the asset is used.
+	Unlike AssetRef it doesn't keep a count, a handle to a deleted asset resolves to nullptr instead.
+	The low INDEX_BITS are a slot in T's AssetHandleTable, the rest the slot's generation when the handle was made, 0 is the null handle.
+	*/
+	template<std::derived_from<Asset> T>
+	class AssetHandle {
+	public:
+		AssetHandle() = default;
+		explicit AssetHandle(uint32_t _value) : value(_value) {}
+
+		uint32_t GetIndex() const {
+			return value & INDEX_MASK;
+		}
+
+		uint32_t GetGeneration() const {
+			return value >> INDEX_BITS;
+		}
+
+		explicit operator bool() const {
+			return value != 0;
+		}
+
+		bool operator==(const AssetHandle& other) const = default;
+
+		uint32_t value = 0;
+
+		inline static constexpr uint32_t INDEX_BITS = 20;
+		inline static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+		inline static constexpr uint32_t MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+	};
+
+	/*
+	Slots for the handles of every asset of type T, owned by AssetManager which adds and removes assets with its lifecycle mutex held.
+	Resolve is lock-free so render jobs can call it while assets are created and deleted:
+	- Slots live in fixed pages that are never moved or freed
+	- Remove clears the pointer and bumps the generation before a later Add can reuse the slot, Resolve reads the pointer before the generation,
+	  so a stale handle either sees the generation change or the pointer of the asset it was made for, which AssetManager only destroys once
+	  frames in flight that could hold the handle have finished
+	- Freed slots are reused oldest first so a slot's generation wraps as slowly as possible
+	*/
+	template<std::derived_from<Asset> T>
+	class AssetHandleTable {
+	public:
+		~AssetHandleTable() {
+			for (auto& page : m_pages) {
+				delete[] page.load(std::memory_order_relaxed);
+			}
+		}
+
+		AssetHandle<T> Add(T* p_asset) {
+			uint32_t index;
+			if (m_free_slots.empty()) {
+				index = m_num_slots++;
+				SNK_ASSERT_ARG(index <= AssetHandle<T>::INDEX_MASK, "AssetHandleTable full");
+
+				auto& page = m_pages[index / PAGE_SIZE];
+				if (!page.load(std::memory_order_relaxed))
+					page.store(new Slot[PAGE_SIZE], std::memory_order_release);
+			}
+			else {
+				index = m_free_slots.front();
+				m_free_slots.pop_front();
+			}
+
+			auto& slot = GetSlot(index);
+			uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+			slot.p_asset.store(p_asset, std::memory_order_release);
+
+			return AssetHandle<T>{ (generation << AssetHandle<T>::INDEX_BITS) | index };
+		}
+
+		void Remove(AssetHandle<T> handle) {
+			auto& slot = GetSlot(handle.GetIndex());
+			SNK_ASSERT(slot.generation.load(std::memory_order_relaxed) == handle.GetGeneration());
+
+			slot.p_asset.store(nullptr, std::memory_order_relaxed);
+
+			// Generation 0 is skipped so handle 0 is never valid
+			uint32_t generation = handle.GetGeneration() == AssetHandle<T>::MAX_GENERATION ? 1 : handle.GetGeneration() + 1;
+			slot.generation.store(generation, std::memory_order_release);
+			m_free_slots.push_back(handle.GetIndex());
+		}
+
+		T* Resolve(AssetHandle<T> handle) const {
+			if (!handle)
+				return nullptr;
+
+			auto* p_page = m_pages[handle.GetIndex() / PAGE_SIZE].load(std::memory_order_acquire);
+			if (!p_page)
+				return nullptr;
+
+			auto& slot = p_page[handle.GetIndex() % PAGE_SIZE];
+			T* p_asset = slot.p_asset.load(std::memory_order_acquire);
+			return slot.generation.load(std::memory_order_acquire) == handle.GetGeneration() ? p_asset : nullptr;
+		}
+
+	private:
+		struct Slot {
+			std::atomic<T*> p_asset = nullptr;
+			std::atomic<uint32_t> generation = 1;
+		};
+
+		Slot& GetSlot(uint32_t index) {
+			return m_pages[index / PAGE_SIZE].load(std::memory_order_relaxed)[index % PAGE_SIZE];
+		}
+
+		inline static constexpr uint32_t PAGE_SIZE = 4096;
+		inline static constexpr uint32_t NUM_PAGES = (AssetHandle<T>::INDEX_MASK + 1) / PAGE_SIZE;
+
+		std::array<std::atomic<Slot*>, NUM_PAGES> m_pages{};
+		uint32_t m_num_slots = 0;
+		std::deque<uint32_t> m_free_slots;
+	};
+}
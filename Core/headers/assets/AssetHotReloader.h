@@ -0,0 +1,168 @@
+#pragma once
+#include "assets/AssetLoader.h"
+#include "rendering/MeshBufferManager.h"
+#include "events/EventManager.h"
+#include "util/FileWatcher.h"
+#include <unordered_set>
+
+namespace SNAKE {
+	struct AssetHotReloadStats {
+		// Assets whose new data was applied
+		uint32_t num_reloaded = 0;
+
+		// Reads that found the same content as what's loaded, like files the editor has just saved
+		uint32_t num_unchanged = 0;
+		uint32_t num_failed = 0;
+
+		// Texture data staged and mesh data queued for upload
+		uint64_t bytes_uploaded = 0;
+	};
+
+	/*
+	Watches the project's asset directory with a FileWatcher and reloads textures, materials and mesh data whose files change, without reloading the project.
+	A changed file is read and decoded on a JobSystem worker, then applied on frame start in place so nothing referencing the asset has to change:
+	- Textures get a new image swapped in with their descriptor rewritten at the same bindless index and dispatch an UPDATED AssetEvent,
+	  the old image is destroyed once no frame in flight can be sampling it. Textures TextureResidencyManager streams are registered again with only their tail uploaded
+	- Materials are updated and dispatch MaterialUpdateEvent
+	- Mesh data is handed to MeshBufferManager::QueueMeshReload, which uploads it to fresh ranges and patches the mesh's MeshEntryData
+	Files whose content hash matches what's loaded are only read as far as needed to tell.
+	Assets AssetStreamer is still loading are reloaded once they're resident.
+	*/
+	class AssetHotReloader {
+	public:
+		static void Init() { Get().I_Init(); }
+
+		// Stops watching, waits for reads in progress and destroys retired images, call before AssetManager::Shutdown
+		static void Shutdown();
+
+		// Stops watching any previous directory, returns false if 'directory' couldn't be watched
+		static bool WatchDirectory(const std::string& directory);
+
+		// Reads the asset's file again and applies it on a later frame start, as if the file had changed
+		// No effect for assets that aren't textures, materials or mesh data, or weren't loaded from a file
+		static void Reload(Asset* p_asset);
+
+		static const AssetHotReloadStats& GetStats() {
+			return Get().m_stats;
+		}
+
+		// Changes seen while disabled are dropped
+		inline static bool enabled = true;
+
+	private:
+		static AssetHotReloader& Get() {
+			static AssetHotReloader instance;
+			return instance;
+		}
+
+		void I_Init();
+
+		enum class ReloadType {
+			TEXTURE_2D,
+			MATERIAL,
+			MESH_DATA,
+		};
+
+		struct ReloadRequest {
+			// Never dereferenced on workers, the asset can be deleted while its file is read
+			Asset* p_asset = nullptr;
+			ReloadType type;
+			std::string filepath;
+
+			// Identifies the reload so results for a deleted asset are never applied to a new one at the same address
+			uint64_t id = 0;
+
+			// What's loaded, a file with the same content and UUID is reported unchanged
+			uint64_t uuid = 0;
+			uint64_t content_hash = 0;
+
+			// Textures, TextureResidencyManager streams the asset's mips
+			bool managed_residency = false;
+		};
+
+		struct ReloadedAsset {
+			Asset* p_asset = nullptr;
+			ReloadType type;
+			uint64_t id = 0;
+			bool success = false;
+			bool unchanged = false;
+
+			std::string name;
+
+			// Textures, the full spec and every stored mip from resident_top on, see AssetStreamer::LoadedAsset
+			AssetLoader::Texture2DFileContents file_contents;
+			Image2DSpec spec;
+			uint32_t resident_top = 0;
+			bool managed_residency = false;
+			uint64_t upload_size = 0;
+
+			AssetLoader::MaterialFileContents material;
+
+			PreparedMeshUpload mesh_upload;
+		};
+
+		struct RetiredImage {
+			std::unique_ptr<Image2D> p_image;
+			uint64_t frame;
+		};
+
+		// Frame start, applies reloads whose files have been read then starts reloading files that changed
+		void Update();
+
+		// Returns false if p_asset isn't a type that can be reloaded or has no file
+		static bool GetReloadType(Asset* p_asset, ReloadType& type);
+
+		void StartReload(Asset* p_asset, ReloadType type);
+
+		// Run on a worker, nothing is written to the asset
+		static ReloadedAsset ReadTexture2D(const ReloadRequest& request);
+		static ReloadedAsset ReadMaterial(const ReloadRequest& request);
+		static ReloadedAsset ReadMeshData(const ReloadRequest& request);
+
+		void ApplyReloads();
+
+		void PollInFlightBatches();
+
+		// Creates the new image and stages its mips, it's swapped in once the batch is submitted
+		std::unique_ptr<Image2D> StageTexture(ReloadedAsset& reloaded, UploadBatch& batch);
+
+		// Swaps the staged image into the texture and rewrites its descriptor, the batch staging it must have been submitted
+		void SwapTexture(Texture2DAsset* p_tex, std::unique_ptr<Image2D> p_image, ReloadedAsset& reloaded);
+
+		// Returns false if the file matched what's loaded so nothing was changed
+		static bool ApplyMaterial(MaterialAsset* p_mat, const AssetLoader::MaterialFileContents& contents);
+
+		void OnAssetDestroyed(Asset* p_asset);
+
+		FileWatcher m_watcher;
+
+		// Assets being read -> their reload ID
+		std::unordered_map<Asset*, uint64_t> m_in_progress;
+
+		// Changed again while being read, they're read once more after the first read is applied
+		std::unordered_set<Asset*> m_changed_again;
+
+		// Not resident yet, reloaded once AssetStreamer has loaded them
+		std::unordered_set<Asset*> m_waiting;
+
+		uint64_t m_next_reload_id = 0;
+
+		// Incremented every frame start
+		uint64_t m_frame = 0;
+
+		// Guards m_reloaded and m_num_reading, which workers touch
+		std::mutex m_mux;
+		std::vector<ReloadedAsset> m_reloaded;
+		uint32_t m_num_reading = 0;
+
+		std::vector<RetiredImage> m_retired;
+
+		// Submitted batches are kept alive until their fence signals
+		std::vector<std::unique_ptr<UploadBatch>> m_in_flight_batches;
+
+		AssetHotReloadStats m_stats;
+
+		EventListener m_frame_start_listener;
+		EventListener m_asset_event_listener;
+	};
+}
@@ -2,22 +2,104 @@
 #include "assets/MeshData.h"
 #include "TextureAssets.h"
 #include "MaterialAsset.h"
+#include "assets/TextureEncoder.h"
+#include "assets/Texture2DFile.h"
+#include "util/MappedFile.h"
+#include <span>
 
 namespace SNAKE {
+	class UploadBatch;
+	struct Job;
+
 	class AssetLoader {
 	public:
+		// A .tex2d file's data past its header, see Texture2DFile.h
+		struct Texture2DFileContents {
+			// Kept mapped so mips are staged straight from it
+			std::unique_ptr<MappedFile> p_file;
+
+			uint64_t content_hash = 0;
+
+			// Texel data of every mip in the spec's format, points into p_file, empty for files in the pre-versioned layout until DecodeLegacyTexture2D
+			std::vector<std::span<const std::byte>> mips;
+
+			// Pre-versioned layout only, the source image file
+			std::vector<std::byte> raw_file_data;
+
+			// Pre-versioned layout only, RGBA8 mips decoded and generated from raw_file_data that 'mips' points into
+			std::vector<std::vector<std::byte>> decoded_mips;
+		};
+
+		// A .mat file's fields, texture UUIDs are INVALID_UUID for unset slots
+		struct MaterialFileContents {
+			std::string name;
+			glm::vec3 albedo{ 1, 1, 1 };
+			float emissive = 0.f;
+			float roughness = 0.5f;
+			float metallic = 0.f;
+			float ao = 0.2f;
+
+			// Albedo, normal, roughness, metallic, ao
+			std::array<uint64_t, 5> texture_uuids{};
+		};
+
+		// A LoadTextureFromFile started by BeginTextureLoadFromFile, the worker fills everything after p_job
+		struct PendingTextureLoad {
+			AssetRef<Texture2DAsset> tex;
+			std::string filepath;
+			TextureEncoder::Usage usage = TextureEncoder::Usage::ALBEDO;
+			Job* p_job = nullptr;
+
+			uint64_t content_hash = 0;
+			glm::uvec2 size{ 0, 0 };
+
+			// RGBA8, empty if the file couldn't be read or decoded
+			std::vector<std::vector<std::byte>> mips;
+			const char* p_failure_reason = nullptr;
+		};
+
+		// An image file (.png, .jpg etc) to load as a texture
+		struct TextureFileLoad {
+			std::string filepath;
+			TextureEncoder::Usage usage = TextureEncoder::Usage::ALBEDO;
+		};
+
+		// A material read from a model file by ImportModelFile, no asset is created for it
+		struct ImportedMaterial {
+			// texture_uuids are left unset, name is the model's name for the material which may not be a valid filename
+			MaterialFileContents contents;
+
+			// False if the model sets none of albedo, roughness or metallic, LoadMeshDataFromRawFile uses the core material for these
+			bool properties_set = false;
+
+			// Ordered as MaterialFileContents::texture_uuids, filepath is empty for slots without a texture
+			std::array<TextureFileLoad, 5> textures;
+		};
+
 		// Returns formatted filename (not path, just filename) for p_asset for serialization
 		// file_extension shouldn't include a "."
 		inline static std::string GenAssetFilename(Asset* p_asset, const std::string& file_extension) {
-			return std::format("{}_{}.{}", p_asset->name, p_asset->uuid(), file_extension);
+			return GenAssetFilename(p_asset->name, p_asset->uuid(), file_extension);
 		}
 
-		// Serializes mesh data asset along with all raw mesh data (vertex data etc) required to load it
-		static void SerializeMeshDataBinary(const std::string& output_filepath, const MeshData& data, MeshDataAsset& asset);
+		inline static std::string GenAssetFilename(const std::string& name, uint64_t uuid, const std::string& file_extension) {
+			return std::format("{}_{}.{}", name, uuid, file_extension);
+		}
+
+		// Serializes mesh data asset along with all raw mesh data (vertex data etc) required to load it, see MeshDataFile.h for the layout
+		// If compress is true, sections that compress well enough to be worth decompressing on load are stored compressed
+		// Off by default, compressed sections can't be staged from the mapping and only load faster from slow disks, see MESH_DATA_COMPRESSION_BENCHMARK
+		static void SerializeMeshDataBinary(const std::string& output_filepath, const MeshData& data, MeshDataAsset& asset, bool compress = false);
+
+		// As SerializeMeshDataBinary without an asset, safe from any thread
+		static void WriteMeshDataFile(const std::string& output_filepath, const MeshData& data, uint64_t uuid, const std::string& name, bool compress = false);
 
 		// Serializes material to binary file, may switch to json later given the small size
 		static void SerializeMaterialBinary(const std::string& output_filepath, MaterialAsset& asset);
 
+		// Writes a .mat file ReadMaterialFile reads back as 'contents', safe from any thread
+		static void WriteMaterialFile(const std::string& output_filepath, uint64_t uuid, const MaterialFileContents& contents);
+
 		// Creates a json file at output_filepath containing asset data (source data asset etc)
 		static void SerializeStaticMeshAsset(const std::string& output_filepath, StaticMeshAsset& asset);
 
@@ -26,30 +108,128 @@ namespace SNAKE {
 
 		// Serializes texture asset and image data to output_filepath
 		// filepath_raw should be a path to the image file (.jpg, .png, etc) the texture was loaded from
+		// The image is block compressed for 'usage' with every mip level, see TextureEncoder
 		static void SerializeTexture2DBinaryFromRawFile(const std::string& output_filepath, Texture2DAsset& asset, 
-			const std::string& filepath_raw);
+			const std::string& filepath_raw, TextureEncoder::Usage usage);
+
+		// As SerializeTexture2DBinaryFromRawFile without an asset, safe from any thread as nothing touches the GPU
+		// The content hash is calculated for hash_format, the format the texture is loaded as when imported from filepath_raw directly
+		// Returns false if the image file couldn't be read or decoded
+		static bool WriteTexture2DFileFromRawFile(const std::string& output_filepath, uint64_t uuid, const std::string& name,
+			const std::string& filepath_raw, TextureEncoder::Usage usage, vk::Format hash_format);
 
 		// Serializes texture asset data to output_filepath
-		// Will keep image data the same in the asset file, will only overwrite texture parameters (format etc)
+		// Will keep image data the same in the asset file, will only overwrite texture parameters (name etc)
+		// Files in the pre-versioned layout are rewritten in the current one, encoded for FindTextureUsage(asset)
 		static void SerializeTexture2DBinary(const std::string& output_filepath, Texture2DAsset& asset);
 
+		// NORMAL if any material uses 'tex' as a normal map, ALBEDO if one uses it as albedo or it's sRGB, MASK otherwise
+		static TextureEncoder::Usage FindTextureUsage(Texture2DAsset& tex);
+
+		// If a texture with identical content is already loaded the file's UUID becomes an alias of it and it's returned instead
 		static Texture2DAsset* DeserializeTexture2D(const std::string& filepath);
 
+		// Reads a .tex2d file's header, and the image data stored after it if p_contents isn't null
+		// Only the pages holding the header are read if p_contents is null
+		static bool ReadTexture2DFile(const std::string& filepath, uint64_t& uuid, std::string& name, Image2DSpec& spec, Texture2DFileContents* p_contents = nullptr);
+
 		static MaterialAsset* DeserializeMaterial(const std::string& filepath);
 
+		// Reads a .mat file without creating or touching any asset, safe from any thread
+		static bool ReadMaterialFile(const std::string& filepath, uint64_t& uuid, MaterialFileContents& contents);
+
+		// Writes the file's fields into 'asset' and resolves its textures, doesn't dispatch an update event
+		static void ApplyMaterialFileContents(MaterialAsset& asset, const MaterialFileContents& contents);
+
+		// The file is memory mapped and its uncompressed vertex streams staged straight from the mapping, files in the pre-versioned layout are rewritten in the current one
 		static MeshDataAsset* DeserializeMeshData(const std::string& filepath);
 
+		// Parse a mapped .meshdata file with a MeshDataFileHeader, 'data' takes ownership of the mapping and its streams point into it
+		// If metadata_only is true only the metadata section is read (submeshes, counts, materials, LODs), the mapping is closed on return
+		// Safe from any thread, nothing touches the GPU or AssetManager
+		static bool ReadMeshDataFile(std::unique_ptr<MappedFile> p_file, const std::string& filepath, MeshData& data, uint64_t& uuid, std::string& name,
+			bool metadata_only = false);
+
 		// Loads mesh_data_asset's gpu buffers, materials etc from "data"
 		//static void LoadMeshFromData(AssetRef<MeshDataAsset> mesh_data_asset, MeshData& data);
 		
 		// Creates and loads a MeshData struct from a raw 3d model file supported by assimp (.obj, .fbx etc)
 		static std::unique_ptr<MeshData> LoadMeshDataFromRawFile(const std::string& filepath, bool load_materials_and_textures = true);
 
-		// Loads texture data from raw image file supported by stb_image (.png, .jpg etc)
-		static bool LoadTextureFromFile(AssetRef<Texture2DAsset> tex, vk::Format fmt);
+		// Imports geometry from a raw 3d model file with tangents, LODs, optimised ordering and meshlets, and reads its materials into p_materials if it isn't null
+		// Nothing touches the GPU or AssetManager so it's safe from any thread, data.materials and data.textures are left empty
+		static std::unique_ptr<MeshData> ImportModelFile(const std::string& filepath, std::vector<ImportedMaterial>* p_materials = nullptr);
+
+		// Loads texture data from raw image file supported by stb_image (.png, .jpg etc), in TextureEncoder::GetSourceFormat(usage) with mips generated for 'usage'
+		static bool LoadTextureFromFile(AssetRef<Texture2DAsset> tex, TextureEncoder::Usage usage);
+
+		// LoadTextureFromFile split so the file is read, decoded and mipmapped on a JobSystem worker while the caller does other work
+		// EndTextureLoad waits for the worker then creates and uploads the image, the texture mustn't be used before it returns
+		[[nodiscard]] static std::unique_ptr<PendingTextureLoad> BeginTextureLoadFromFile(AssetRef<Texture2DAsset> tex, TextureEncoder::Usage usage);
+		static bool EndTextureLoad(PendingTextureLoad& load);
+
+		// Returns [TextureRef, is_texture_newly_created], an already loaded texture is returned if one has identical content (file bytes and format)
+		// TextureRef is null if the file couldn't be loaded
+		static std::pair<AssetRef<Texture2DAsset>, bool> CreateOrGetTextureFromFile(const std::string& filepath, TextureEncoder::Usage usage);
+
+		// As CreateOrGetTextureFromFile for every load, results are in the same order as 'loads'
+		// Files are read and decoded in parallel on the JobSystem, new textures are decoded and uploaded in chunks of up to TEXTURE_DECODE_BUDGET_BYTES
+		// Files whose content is already loaded, or appears earlier in 'loads', aren't decoded
+		static std::vector<std::pair<AssetRef<Texture2DAsset>, bool>> CreateOrGetTexturesFromFiles(const std::vector<TextureFileLoad>& loads);
+
+		// Decoded texels CreateOrGetTexturesFromFiles stages in one UploadBatch, about two chunks are alive at once
+		inline static constexpr uint64_t TEXTURE_DECODE_BUDGET_BYTES = 512ull * 1024 * 1024;
+
+		// Content hash of a texture loaded from an image file's bytes, the decoded texels only depend on these and the format
+		static uint64_t CalculateTextureContentHash(const std::vector<std::byte>& raw_file_data, vk::Format fmt);
 
 	private:
-		// Returns [TextureRef, is_texture_newly_created]
-		static std::pair<AssetRef<Texture2DAsset>, bool> CreateOrGetTextureFromMaterial(const std::string& dir, aiTextureType type, aiMaterial* p_material);
+		// True if the file was written before MeshDataFileHeader existed
+		static bool IsLegacyMeshDataFile(MappedFile& file);
+
+		// Parse a .meshdata file written before the header and section table existed
+		static bool ReadLegacyMeshDataFile(const std::string& filepath, MeshData& data, uint64_t& uuid, std::string& name);
+
+		// Checks every submesh and LOD range lies within the streams and every index within its submesh's vertices
+		// A corrupt file would otherwise have MeshletBuilder or the GPU read out of bounds
+		static bool ValidateMeshDataRanges(const MeshData& data, const std::string& filepath);
+
+		// Checks every submesh's meshlet range lies within the meshlets and every meshlet's indices within its submesh
+		static bool ValidateMeshlets(const MeshData& data, const std::string& filepath);
+
+		// Fills 'load' with the material's texture of 'type', returns false if it has none or the file doesn't exist
+		static bool GetMaterialTextureLoad(const std::string& dir, aiTextureType type, aiMaterial* p_material, TextureFileLoad& load);
+
+		// Spec of a texture loaded from an image file
+		static Image2DSpec CreateTextureSpec(vk::Format format, glm::uvec2 size, uint32_t mip_levels);
+
+		// Decodes an image file to RGBA8 and generates the rest of its mip chain for 'usage', 'mips' is empty on failure
+		static std::vector<std::vector<std::byte>> DecodeTextureMips(const std::vector<std::byte>& raw_file_data, TextureEncoder::Usage usage, glm::uvec2& size);
+
+		// Fills contents.mips for a file in the pre-versioned layout from its source image, which must match 'spec'
+		// Safe to call from any thread, nothing touches the GPU
+		static bool DecodeLegacyTexture2D(const std::string& filepath, const Image2DSpec& spec, Texture2DFileContents& contents);
+
+		// RGBA8 bytes of an image file's full mip chain once decoded, read from its header, 0 if stb_image can't read it
+		static uint64_t GetDecodedTextureSize(const std::vector<std::byte>& raw_file_data);
+
+		// Bytes of every mip level in 'spec'
+		static uint64_t GetTextureGPUSize(const Image2DSpec& spec);
+
+		// True if the file was written before Texture2DFileHeader existed
+		static bool IsLegacyTexture2DFile(MappedFile& file);
+
+		// Encodes and writes a .tex2d file in the current layout from the texture's top mip as RGBA8 texels
+		static void WriteTexture2DFile(const std::string& output_filepath, uint64_t uuid, const std::string& name, const std::byte* p_rgba, glm::uvec2 size,
+			uint64_t content_hash, TextureEncoder::Usage usage);
+
+		// Lays out a .tex2d file, header.mip_levels and header.name_size are set from 'mips' and 'name'
+		static std::vector<std::byte> BuildTexture2DFile(Texture2DFileHeader header, const std::string& name, const std::vector<std::span<const std::byte>>& mips);
+
+		// Stages every stored mip, leaving the image ready to sample, it must already be created with contents' spec
+		static void StageTextureMips(Texture2DAsset& tex, const Texture2DFileContents& contents, UploadBatch& batch);
+
+		friend class AssetStreamer;
+		friend class AssetHotReloader;
 	};
 }
\ No newline at end of file
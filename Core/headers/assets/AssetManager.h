@@ -5,11 +5,20 @@
 #include "assets/ResourceBufferManagers.h"
 #include "assets/MeshData.h"
 #include "rendering/MeshBufferManager.h"
+#include "assets/AssetTable.h"
+#include "assets/AssetHandle.h"
+#include "assets/AssetTypeList.h"
+#include "assets/DeferredDeletionQueue.h"
+#include <span>
+#include <typeindex>
 
 namespace SNAKE {
 	enum class AssetEventType {
 		CREATED,
-		DESTROYED
+		DESTROYED,
+		// The asset's GPU resources were replaced in place, e.g. a texture's image swapped for one with different mips
+		// Views and descriptors created from the old resources stay valid only until frames in flight finish
+		UPDATED,
 	};
 
 	struct AssetEvent : public Event {
@@ -19,9 +28,33 @@ namespace SNAKE {
 		Asset* p_asset;
 	};
 
+	// Totals for data that wasn't loaded or written again because identical content was already loaded
+	struct ContentDedupStats {
+		uint32_t num_textures = 0;
+		uint32_t num_meshes = 0;
+
+		// Texture memory not allocated for duplicates, meshes sharing GPU data are counted in MeshBufferStats
+		uint64_t texture_bytes_saved = 0;
+
+		// Asset file data not written for duplicate imports
+		uint64_t disk_bytes_saved = 0;
+	};
+
+	/*
+	Owns every asset, indexed by UUID, content hash, filepath and type.
+	Lookups, SetFilepath/SetContentHash/AddAlias and AssetRefs are safe from JobSystem workers.
+	Creating and deleting assets is main thread only. Their CREATED/DESTROYED events are dispatched synchronously to listeners that own
+	main thread state without locking it (the global material and texture buffers, MeshBufferManager, AssetStreamer, TextureResidencyManager).
+	Workers that produce assets return their data to the main thread to be created there, as AssetStreamer does.
+	A deleted asset can't be found anymore, but it's only destroyed once frames in flight when it was deleted have finished, so raw pointers
+	held by those frames' render data stay valid.
+	*/
 	class AssetManager {
 	public:
 		friend class AssetLoader;
+		friend class AssetStreamer;
+		friend class TextureResidencyManager;
+		friend class AssetHotReloader;
 
 		inline static AssetManager& Get() {
 			static AssetManager instance;
@@ -31,6 +64,7 @@ namespace SNAKE {
 		static void Init() { Get().I_Init(); }
 		static void Shutdown();
 
+		// Main thread only, the asset is destroyed MAX_FRAMES_IN_FLIGHT frame starts later, see DestroyDeletedAssets
 		static void DeleteAsset(Asset* asset);
 		static void DeleteAsset(uint64_t uuid);
 
@@ -43,9 +77,14 @@ namespace SNAKE {
 			EventManagerG::DispatchEvent(AssetEvent{ AssetEventType::DESTROYED, p_asset });
 		}
 
+		// Main thread only
 		template<std::derived_from<Asset> AssetT, typename... Args>
 		static AssetRef<AssetT> CreateAsset(uint64_t uuid = 0, Args&&... args) {
-			if (Get().m_assets.contains(uuid)) {
+			auto& manager = Get();
+			SNK_DBG_ASSERT(std::this_thread::get_id() == manager.m_main_thread);
+			std::scoped_lock l(manager.m_lifecycle_mux);
+
+			if (manager.m_assets.Contains(uuid)) {
 				SNK_CORE_ERROR("AssetManager::CreateAsset failed, UUID conflict: '{}'", uuid);
 				return GetAsset<AssetT>(uuid);
 			}
@@ -54,7 +93,14 @@ namespace SNAKE {
 				uuid = UUID<uint64_t>()();
 
 			auto* p_asset = new AssetT(uuid, std::forward<Args>(args)...);
-			Get().m_assets[uuid] = p_asset;
+			manager.m_assets.Insert(uuid, p_asset);
+			{
+				std::unique_lock il(manager.m_index_mux);
+				manager.GetTypeList<AssetT>().Add(p_asset, IsCoreAssetUUID(uuid));
+			}
+
+			if (!p_asset->filepath.empty())
+				SetFilepath(p_asset, p_asset->filepath);
 
 			Get().OnAssetAdd(AssetRef(p_asset));
 
@@ -73,12 +119,20 @@ namespace SNAKE {
 
 		template<std::derived_from<Asset> T>
 		static T* GetAssetRaw(uint64_t uuid) {
-			if (!Get().m_assets.contains(uuid)) {
+			auto& manager = Get();
+			{
+				std::shared_lock l(manager.m_index_mux);
+				if (auto it = manager.m_aliases.find(uuid); it != manager.m_aliases.end())
+					uuid = it->second;
+			}
+
+			auto* p_found = manager.m_assets.Find(uuid);
+			if (!p_found) {
 				SNK_CORE_ERROR("AssetManager::GetAsset failed, UUID '{}' doesn't exist in AssetManager", uuid);
 				return nullptr;
 			}
 
-			auto* p_asset = dynamic_cast<T*>(Get().m_assets[uuid]);
+			auto* p_asset = dynamic_cast<T*>(p_found);
 			if (p_asset == nullptr) {
 				SNK_CORE_ERROR("AssetManager::GetAsset failed '{}', wrong asset type", uuid);
 			}
@@ -86,6 +140,30 @@ namespace SNAKE {
 			return p_asset;
 		}
 
+		// Returns a loaded asset of type T whose content_hash is 'hash', nullptr if there isn't one
+		template<std::derived_from<Asset> T>
+		static T* FindAssetByContentHash(uint64_t hash) {
+			std::shared_lock l(Get().m_index_mux);
+			auto [begin, end] = Get().m_content_index.equal_range(hash);
+			for (auto it = begin; it != end; it++) {
+				if (auto* p_casted = dynamic_cast<T*>(it->second))
+					return p_casted;
+			}
+
+			return nullptr;
+		}
+
+		// Sets the asset's content_hash and indexes it so identical data loaded later can reuse the asset
+		static void SetContentHash(Asset* p_asset, uint64_t hash);
+
+		// Makes 'uuid' resolve to 'p_asset', used when a deserialized asset's content is identical to one already loaded
+		// The alias is removed when p_asset is deleted
+		static void AddAlias(uint64_t uuid, Asset* p_asset);
+
+		static ContentDedupStats& GetContentDedupStats() {
+			return Get().m_content_dedup_stats;
+		}
+
 		template<std::derived_from<Asset> T>
 		static AssetRef<T> GetAsset(uint64_t uuid) {
 			return AssetRef<T>{	GetAssetRaw<T>(uuid) };
@@ -93,45 +171,79 @@ namespace SNAKE {
 
 		template<std::derived_from<Asset> T>
 		static AssetRef<T> GetAsset(const std::string& filepath) {
-			for (auto& [uuid, p_asset] : Get().m_assets) {
-				if (std::filesystem::equivalent(p_asset->filepath, filepath)) {
-					if (auto* p_casted = dynamic_cast<T*>(p_asset)) {
-						return AssetRef<T>(p_casted);
-					}
-					else {
-						SNK_CORE_ERROR("AssetManager::GetAsset failed '{}', wrong asset type", p_asset->filepath);
-					}
-				}
+			auto key = CanonicalisePath(filepath);
+
+			std::shared_lock l(Get().m_index_mux);
+			auto [begin, end] = Get().m_path_index.equal_range(key);
+			for (auto it = begin; it != end; it++) {
+				if (auto* p_casted = dynamic_cast<T*>(it->second))
+					return AssetRef<T>(p_casted);
 			}
 
-			SNK_CORE_ERROR("AssetManager::GetAsset failed, filepath '{}' doesn't exist in AssetManager", filepath);
+			if (begin != end)
+				SNK_CORE_ERROR("AssetManager::GetAsset failed '{}', wrong asset type", filepath);
+			else
+				SNK_CORE_ERROR("AssetManager::GetAsset failed, filepath '{}' doesn't exist in AssetManager", filepath);
+
 			return nullptr;
 		}
 
-		template<std::derived_from<Asset> T, bool IncludeCoreAssets = false>
-		static std::vector<T*> GetView() {
-			std::vector<T*> ret;
-			for (auto& [uuid, p_asset] : Get().m_assets) {
-				if constexpr (!IncludeCoreAssets) {
-					if (IsCoreAssetUUID(uuid))
-						continue;
-				}
-
-				if (auto* p_casted = dynamic_cast<T*>(p_asset))
-					ret.push_back(p_casted);
+		// Every asset loaded from 'filepath', of any type, empty without an error if there are none
+		static std::vector<Asset*> GetAssetsAtPath(const std::string& filepath) {
+			auto key = CanonicalisePath(filepath);
+
+			std::shared_lock l(Get().m_index_mux);
+			auto [begin, end] = Get().m_path_index.equal_range(key);
+
+			std::vector<Asset*> assets;
+			for (auto it = begin; it != end; it++) {
+				assets.push_back(it->second);
 			}
-			return ret;
+
+			return assets;
+		}
+
+		// Sets the asset's filepath and indexes it so GetAsset can find the asset by it, an empty path removes it from the index
+		static void SetFilepath(Asset* p_asset, const std::string& filepath);
+
+		// Key paths are indexed by, absolute and normalized with symlinks resolved as far as the path exists
+		static std::string CanonicalisePath(const std::string& filepath);
+
+		// All assets whose concrete type is T, core assets first
+		// The span is invalidated by creating or deleting an asset of type T, copy it into a vector to do either while iterating
+		// It isn't locked, so assets of type T mustn't be created or deleted by other threads while it's in use
+		template<std::derived_from<Asset> T, bool IncludeCoreAssets = false>
+		static std::span<T* const> GetView() {
+			auto* p_list = Get().FindTypeList<T>();
+			if (!p_list)
+				return {};
+
+			std::span<T* const> view = p_list->assets;
+			if constexpr (!IncludeCoreAssets)
+				view = view.subspan(p_list->num_core);
+
+			return view;
+		}
+
+		// p_asset's concrete type must be T
+		template<std::derived_from<Asset> T>
+		static AssetHandle<T> GetHandle(const T* p_asset) {
+			SNK_DBG_ASSERT(typeid(*p_asset) == typeid(T));
+			return AssetHandle<T>{ p_asset->handle };
+		}
+
+		// nullptr for the null handle or if the asset has been deleted, lock-free so it's cheap enough for per-draw use
+		template<std::derived_from<Asset> T>
+		static T* Resolve(AssetHandle<T> handle) {
+			return GetHandleTable<T>().Resolve(handle);
 		}
 
 		static void Clear() {
 			std::vector<uint64_t> deletion_queue;
-			auto& assets = Get().m_assets;
-			for (auto [uuid, p_asset] : assets) {
-				if (IsCoreAssetUUID(uuid))
-					continue;
-				else
+			Get().m_assets.ForEach([&](uint64_t uuid, [[maybe_unused]] Asset* p_asset) {
+				if (!IsCoreAssetUUID(uuid))
 					deletion_queue.push_back(uuid);
-			}
+			});
 
 			for (auto uuid : deletion_queue) {
 				DeleteAsset(uuid);
@@ -162,11 +274,85 @@ namespace SNAKE {
 
 		void InitGlobalBufferManagers();
 
+		// Frame start, destroys assets deleted MAX_FRAMES_IN_FLIGHT frames ago, the fences waited on since cover every frame that could use them
+		void DestroyDeletedAssets();
+
+		// Removes the asset's content and path index entries, any aliases of it and its type list entry
+		void UnindexAsset(Asset* p_asset);
+
+		// These expect m_index_mux to be held exclusively
+		void SetContentHashLocked(Asset* p_asset, uint64_t hash);
+		void RemovePathIndexEntry(Asset* p_asset);
+
+		// Also registers handles, so an asset's handle resolves exactly while it's listed
+		template<std::derived_from<Asset> T>
+		struct HandledAssetTypeList : public AssetTypeList<T> {
+			void Add(T* p_asset, bool core) {
+				AssetTypeList<T>::Add(p_asset, core);
+				p_asset->handle = GetHandleTable<T>().Add(p_asset).value;
+			}
+
+			void Remove(Asset* p_asset) override {
+				AssetTypeList<T>::Remove(p_asset);
+				GetHandleTable<T>().Remove(AssetHandle<T>{ p_asset->handle });
+				p_asset->handle = 0;
+			}
+		};
+
+		template<std::derived_from<Asset> T>
+		static AssetHandleTable<T>& GetHandleTable() {
+			static AssetHandleTable<T> table;
+			return table;
+		}
+
+		template<std::derived_from<Asset> T>
+		HandledAssetTypeList<T>* FindTypeList() {
+			auto it = m_type_lists.find(typeid(T));
+			return it == m_type_lists.end() ? nullptr : static_cast<HandledAssetTypeList<T>*>(it->second.get());
+		}
+
+		template<std::derived_from<Asset> T>
+		HandledAssetTypeList<T>& GetTypeList() {
+			auto& p_list = m_type_lists[typeid(T)];
+			if (!p_list)
+				p_list = std::make_unique<HandledAssetTypeList<T>>();
+
+			return *static_cast<HandledAssetTypeList<T>*>(p_list.get());
+		}
+
 		GlobalTextureBufferManager m_global_tex_buffer_manager;
 		GlobalMaterialBufferManager m_global_material_buffer_manager;
 		std::shared_ptr<DescriptorSetSpec> m_global_tex_mat_descriptor_spec = nullptr;
 
-		std::unordered_map<uint64_t, Asset*> m_assets;
+		AssetTable m_assets;
+
+		// Held while creating or deleting an asset, recursive as CREATED/DESTROYED listeners may create or delete assets themselves
+		// Also guards m_deleted_assets
+		std::recursive_mutex m_lifecycle_mux;
+
+		// The only thread that may create or delete assets, set on first use and again by Init
+		std::thread::id m_main_thread = std::this_thread::get_id();
+
+		DeferredDeletionQueue m_deleted_assets{ MAX_FRAMES_IN_FLIGHT };
+
+		EventListener m_frame_start_listener;
+
+		// Guards the indices below, written on create/delete and by the index setters, read by every lookup
+		mutable std::shared_mutex m_index_mux;
+
+		// content_hash -> asset, several assets can share a hash (e.g. meshes with identical geometry but different materials)
+		std::unordered_multimap<uint64_t, Asset*> m_content_index;
+
+		// CanonicalisePath(filepath) -> asset, several assets can share a path, GetAsset returns the one of the requested type
+		std::unordered_multimap<std::string, Asset*> m_path_index;
+
+		// Concrete asset type -> AssetTypeList of that type
+		std::unordered_map<std::type_index, std::unique_ptr<IAssetTypeList>> m_type_lists;
+
+		// Alias UUID -> UUID of the asset it resolves to
+		std::unordered_map<uint64_t, uint64_t> m_aliases;
+
+		ContentDedupStats m_content_dedup_stats;
 
 	};
 }
\ No newline at end of file
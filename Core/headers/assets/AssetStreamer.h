@@ -0,0 +1,196 @@
+#pragma once
+#include "assets/MeshData.h"
+#include "assets/TextureAssets.h"
+#include "assets/AssetLoader.h"
+#include "rendering/MeshBufferManager.h"
+#include "events/EventManager.h"
+
+namespace SNAKE {
+	struct AssetStreamerStats {
+		uint32_t num_requests = 0;
+		uint32_t num_resident = 0;
+		uint32_t num_failed = 0;
+
+		// Streamed textures found identical to a loaded one once read, their UUIDs became aliases of it
+		uint32_t num_deduplicated = 0;
+
+		uint64_t bytes_uploaded = 0;
+
+		// Frames where loaded assets were left for the next frame because the upload budget ran out
+		uint32_t num_budget_limited_frames = 0;
+	};
+
+	/*
+	Loads textures and mesh data in the background instead of blocking until their data is uploaded.
+	Requesting an asset reads only its header and creates it straight away so materials, static meshes and scenes can reference it.
+	Until it's resident a texture's descriptor index shows the default texture and a mesh has no submeshes, so nothing draws it.
+	File reads, decompression, decoding and derived data are done on JobSystem workers, highest priority first.
+	Uploads happen on frame start in priority order, within upload_budget_bytes per frame.
+	Materials and static meshes only hold references and are small, they're loaded synchronously with AssetLoader.
+	*/
+	class AssetStreamer {
+	public:
+		// Higher loads first, requests with equal priority load in request order
+		enum Priority : uint32_t {
+			BACKGROUND = 0,
+			DEFAULT = 100,
+			// Referenced by the open scene
+			VISIBLE = 200,
+		};
+
+		static void Init() { Get().I_Init(); }
+
+		// Waits for loads in progress to finish and drops everything not yet resident, call before AssetManager::Shutdown
+		static void Shutdown();
+
+		// Returns nullptr if the file's header couldn't be read
+		// Textures identical to a loaded one become aliases of it once loaded, as with AssetLoader::DeserializeTexture2D
+		static Texture2DAsset* RequestTexture2D(const std::string& filepath, uint32_t priority = DEFAULT);
+
+		// Files in the pre-versioned layout are loaded synchronously, see AssetLoader::DeserializeMeshData
+		static MeshDataAsset* RequestMeshData(const std::string& filepath, uint32_t priority = DEFAULT);
+
+		// No effect if the asset isn't waiting to load or upload
+		static void SetPriority(Asset* p_asset, uint32_t priority);
+
+		// Raises every asset the scene's static meshes use (mesh data, materials' textures) to 'priority'
+		static void PrioritiseScene(class Scene& scene, uint32_t priority = VISIBLE);
+
+		// Assets that weren't streamed are always resident, assets that failed to load never are
+		static bool IsResident(Asset* p_asset);
+
+		// Requests not yet resident, including failed ones
+		static uint32_t GetNumPending();
+
+		static const AssetStreamerStats& GetStats() {
+			return Get().m_stats;
+		}
+
+		// Bytes staged for upload per frame, at least one asset is uploaded each frame even if it's larger
+		inline static uint64_t upload_budget_bytes = 64 * 1024 * 1024;
+
+		// Workers loading at once, the rest of the JobSystem is left free for frame work
+		inline static uint32_t max_concurrent_loads = glm::max(std::thread::hardware_concurrency() / 2, 1u);
+
+		// How many uploads, taken in order, fit in 'budget' bytes, always at least one if there are any
+		static size_t GetNumWithinBudget(const std::vector<uint64_t>& upload_sizes, uint64_t budget);
+
+	private:
+		static AssetStreamer& Get() {
+			static AssetStreamer instance;
+			return instance;
+		}
+
+		void I_Init();
+
+		enum class RequestState {
+			QUEUED,
+			LOADING,
+			// Loaded on a worker, waiting for upload on frame start
+			LOADED,
+			// Handed to MeshBufferManager, resident on MeshDataLoadedEvent
+			UPLOADING,
+			FAILED,
+		};
+
+		enum class RequestType {
+			TEXTURE_2D,
+			MESH_DATA,
+		};
+
+		struct Request {
+			// Never dereferenced on workers, the asset can be deleted while it loads
+			Asset* p_asset = nullptr;
+			RequestType type;
+			std::string filepath;
+
+			// Also orders equal priorities, and identifies the request so results for a deleted asset are never applied to a new one at the same address
+			uint64_t id = 0;
+			uint32_t priority = DEFAULT;
+			RequestState state = RequestState::QUEUED;
+		};
+
+		struct QueueKey {
+			uint32_t priority;
+			uint64_t id;
+
+			bool operator<(const QueueKey& other) const {
+				return priority != other.priority ? priority > other.priority : id < other.id;
+			}
+		};
+
+		struct LoadedAsset {
+			Asset* p_asset = nullptr;
+			uint64_t request_id = 0;
+			bool success = false;
+
+			// Bytes staged when uploaded, counted against upload_budget_bytes
+			uint64_t upload_size = 0;
+
+			// Textures, every stored mip from resident_top on, or for files in the pre-versioned layout every mip decoded and generated from the source image
+			AssetLoader::Texture2DFileContents file_contents;
+			uint64_t content_hash = 0;
+
+			// Finest level in file_contents, the levels above it are left to TextureResidencyManager if managed_residency is set
+			uint32_t resident_top = 0;
+			bool managed_residency = false;
+
+			// Mesh data
+			PreparedMeshUpload mesh_upload;
+		};
+
+		// Runs on a worker, loads queued requests highest priority first until the queue is empty
+		void LoadQueued();
+
+		// Read and decode on the worker, nothing is written to the asset
+		static LoadedAsset LoadTexture2D(const Request& request);
+		static LoadedAsset LoadMeshData(const Request& request);
+
+		// Starts loading jobs up to max_concurrent_loads, m_mux must be held
+		void StartJobs();
+
+		// Locks m_mux
+		void SetState(Asset* p_asset, RequestState state);
+
+		// Frame start, uploads loaded assets in priority order until the budget is used
+		void UploadLoadedAssets();
+
+		void PollInFlightBatches();
+
+		// Creates the image and stages its mips from resident_top on, returns false if it was a duplicate and was merged into an already loaded texture instead
+		bool StageTexture(Texture2DAsset* p_tex, LoadedAsset& loaded, UploadBatch& batch);
+
+		// Points every material using p_duplicate at p_existing, deletes p_duplicate and makes its UUID an alias of p_existing
+		static void MergeDuplicateTexture(Texture2DAsset* p_duplicate, Texture2DAsset* p_existing);
+
+		void OnResident(Asset* p_asset);
+
+		void OnAssetDestroyed(Asset* p_asset);
+
+		// Adds the request and starts a job for it if one is free
+		void Enqueue(Asset* p_asset, RequestType type, const std::string& filepath, uint32_t priority);
+
+		// Guards everything below that workers touch
+		mutable std::mutex m_mux;
+
+		// Every request not yet resident
+		std::unordered_map<Asset*, Request> m_requests;
+
+		// QUEUED requests, highest priority first
+		std::map<QueueKey, Asset*> m_queue;
+
+		std::vector<LoadedAsset> m_loaded;
+
+		// Submitted texture batches are kept alive until their fence signals, main thread only
+		std::vector<std::unique_ptr<UploadBatch>> m_in_flight_batches;
+
+		uint64_t m_next_request_id = 0;
+		uint32_t m_num_active_jobs = 0;
+
+		AssetStreamerStats m_stats;
+
+		EventListener m_frame_start_listener;
+		EventListener m_asset_event_listener;
+		EventListener m_mesh_data_loaded_listener;
+	};
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "assets/Asset.h"
+#include <shared_mutex>
+
+namespace SNAKE {
+	/*
+	UUID -> asset map that JobSystem workers can look assets up in while other threads add and remove them.
+	It's split into shards by UUID, each behind its own shared_mutex, so lookups only contend with writes to the same shard.
+	*/
+	class AssetTable {
+	public:
+		Asset* Find(uint64_t uuid) const {
+			auto& shard = GetShard(uuid);
+			std::shared_lock l(shard.mux);
+
+			auto it = shard.assets.find(uuid);
+			return it == shard.assets.end() ? nullptr : it->second;
+		}
+
+		bool Contains(uint64_t uuid) const {
+			return Find(uuid) != nullptr;
+		}
+
+		// Returns false without inserting if 'uuid' is already taken
+		bool Insert(uint64_t uuid, Asset* p_asset) {
+			auto& shard = GetShard(uuid);
+			std::unique_lock l(shard.mux);
+			return shard.assets.emplace(uuid, p_asset).second;
+		}
+
+		// Returns the removed asset, nullptr if there wasn't one
+		Asset* Erase(uint64_t uuid) {
+			auto& shard = GetShard(uuid);
+			std::unique_lock l(shard.mux);
+
+			auto it = shard.assets.find(uuid);
+			if (it == shard.assets.end())
+				return nullptr;
+
+			auto* p_asset = it->second;
+			shard.assets.erase(it);
+			return p_asset;
+		}
+
+		// Shards are locked one at a time, assets added or removed by other threads meanwhile may or may not be visited
+		// 'func' must not add or remove assets itself
+		template<typename F>
+		void ForEach(F&& func) const {
+			for (auto& shard : m_shards) {
+				std::shared_lock l(shard.mux);
+				for (auto& [uuid, p_asset] : shard.assets) {
+					func(uuid, p_asset);
+				}
+			}
+		}
+
+		size_t Size() const {
+			size_t size = 0;
+			for (auto& shard : m_shards) {
+				std::shared_lock l(shard.mux);
+				size += shard.assets.size();
+			}
+
+			return size;
+		}
+
+	private:
+		static constexpr uint32_t NUM_SHARDS = 16;
+
+		// Padded so threads locking neighbouring shards don't share a cache line
+		struct alignas(64) Shard {
+			mutable std::shared_mutex mux;
+			std::unordered_map<uint64_t, Asset*> assets;
+		};
+
+		const Shard& GetShard(uint64_t uuid) const {
+			// Core asset UUIDs are small and sequential, the rest random, mixing spreads both
+			return m_shards[((uuid * 0x9E3779B97F4A7C15ull) >> 32) % NUM_SHARDS];
+		}
+
+		Shard& GetShard(uint64_t uuid) {
+			return const_cast<Shard&>(std::as_const(*this).GetShard(uuid));
+		}
+
+		std::array<Shard, NUM_SHARDS> m_shards;
+	};
+}
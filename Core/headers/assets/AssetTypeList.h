@@ -0,0 +1,57 @@
+#pragma once
+#include "assets/Asset.h"
+#include "util/util.h"
+
+namespace SNAKE {
+	struct IAssetTypeList {
+		virtual ~IAssetTypeList() = default;
+		virtual void Remove(Asset* p_asset) = 0;
+	};
+
+	/*
+	Assets of one concrete type, core assets are kept in [0, num_core) so views with and without them are contiguous.
+	Each asset stores its position in the list, so adding and removing are O(1), removing moves the last asset into the gap.
+	Not synchronised, AssetManager guards its lists with its index mutex.
+	*/
+	template<std::derived_from<Asset> T>
+	struct AssetTypeList : public IAssetTypeList {
+		std::vector<T*> assets;
+		uint32_t num_core = 0;
+
+		void Add(T* p_asset, bool core) {
+			Place(p_asset, (uint32_t)assets.size());
+			if (core)
+				Swap(num_core++, p_asset->type_list_idx);
+		}
+
+		// Fills the gap with the last asset of the same region, then the gap a core asset leaves with the last asset
+		void Remove(Asset* p_asset) override {
+			uint32_t hole = p_asset->type_list_idx;
+			SNK_ASSERT(hole < assets.size() && assets[hole] == p_asset);
+
+			if (hole < num_core) {
+				Place(assets[--num_core], hole);
+				hole = num_core;
+			}
+
+			Place(assets.back(), hole);
+			assets.pop_back();
+		}
+
+	private:
+		void Place(T* p_asset, uint32_t idx) {
+			if (idx == assets.size())
+				assets.push_back(p_asset);
+			else
+				assets[idx] = p_asset;
+
+			p_asset->type_list_idx = idx;
+		}
+
+		void Swap(uint32_t a, uint32_t b) {
+			T* p_a = assets[a];
+			Place(assets[b], a);
+			Place(p_a, b);
+		}
+	};
+}
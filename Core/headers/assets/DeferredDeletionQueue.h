@@ -0,0 +1,64 @@
+#pragma once
+#include "assets/Asset.h"
+
+namespace SNAKE {
+	/*
+	Assets that have been deleted but not destroyed yet, each is handed back 'frames_delay' frame starts after it was pushed.
+	With the delay set to the number of frames in flight, the fences waited on by then cover every frame that could still reference the asset.
+	Not synchronised, AssetManager guards its queue with its lifecycle mutex.
+	*/
+	class DeferredDeletionQueue {
+	public:
+		explicit DeferredDeletionQueue(uint32_t frames_delay) : m_frames_delay(frames_delay) {}
+
+		void Push(Asset* p_asset) {
+			m_deleted.push_back(DeletedAsset{ p_asset, m_frame });
+		}
+
+		// Call on frame start, returns the assets that are now safe to destroy, which the caller then owns
+		std::vector<Asset*> AdvanceFrame() {
+			m_frame++;
+
+			std::vector<Asset*> due;
+			std::erase_if(m_deleted, [&](const DeletedAsset& deleted) {
+				if (m_frame < deleted.frame + m_frames_delay)
+					return false;
+
+				due.push_back(deleted.p_asset);
+				return true;
+			});
+
+			return due;
+		}
+
+		// Returns every queued asset regardless of when it was pushed, for when nothing can reference them anymore (e.g. the device is idle)
+		std::vector<Asset*> TakeAll() {
+			std::vector<Asset*> all;
+			for (auto& deleted : m_deleted) {
+				all.push_back(deleted.p_asset);
+			}
+
+			m_deleted.clear();
+			return all;
+		}
+
+		// Number of AdvanceFrame calls so far
+		uint64_t GetFrame() const {
+			return m_frame;
+		}
+
+		size_t Size() const {
+			return m_deleted.size();
+		}
+
+	private:
+		struct DeletedAsset {
+			Asset* p_asset;
+			uint64_t frame;
+		};
+
+		std::vector<DeletedAsset> m_deleted;
+		uint64_t m_frame = 0;
+		uint32_t m_frames_delay;
+	};
+}
@@ -6,19 +6,24 @@
 #include "resources/S_VkBuffer.h"
 #include "core/VkCommon.h"
 #include "assets/MaterialAsset.h"
+#include "util/ExtraMath.h"
+#include "util/MappedFile.h"
+#include "assets/MeshLayout.h"
 
 namespace SNAKE {
-	struct Submesh {
-		unsigned int num_indices = 0;
-		unsigned int num_vertices = 0;
-		unsigned int base_vertex = 0;
-		unsigned int base_index = 0;
-		unsigned int material_index = 0;
+	// Reduced triangle soup used for software occlusion rasterisation, indices are into positions
+	struct OccluderMeshData {
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
 	};
 
 	struct MeshData {
 		MeshData() = default;
 		~MeshData() {
+			// Streams pointing into a mapped file are released with it
+			if (p_mapped_file)
+				return;
+
 			delete[] positions;
 			delete[] normals;
 			delete[] tangents;
@@ -41,6 +46,36 @@ namespace SNAKE {
 		aiVector3D* tangents = nullptr;
 		aiVector2D* tex_coords = nullptr;
 		unsigned* indices = nullptr;
+
+		// Set when positions, normals, tangents, tex_coords and indices point into a mapped .meshdata file instead of owned arrays
+		// They must not be reallocated then, the mapping is copy-on-write so writing through them is safe
+		std::unique_ptr<MappedFile> p_mapped_file;
+
+		// Streams stored compressed in the mapped file point into these instead
+		std::vector<std::unique_ptr<std::byte[]>> decompressed_sections;
+
+		// Simplified levels of detail, lods[0] is LOD 1. Their indices are stored in 'indices' after every full detail submesh
+		std::vector<MeshLOD> lods;
+
+		// Clusters of each submesh's full detail triangles, see MeshletBuilder
+		std::vector<Meshlet> meshlets;
+
+		// Parallel to submeshes
+		std::vector<SubmeshMeshlets> submesh_meshlets;
+
+		// Maximum number of simplified levels generated on import, not counting full detail
+		inline static constexpr uint32_t MAX_LODS = 4;
+
+		// Object-space bounds of each submesh, calculated from positions
+		std::vector<ExtraMath::AABB> CalculateSubmeshAABBs() const;
+
+		// Simplifies every submesh into a single occluder mesh by clustering vertices into a grid_resolution^3 grid over the mesh bounds
+		// Each cluster is replaced by the average of its vertices and triangles that collapse are dropped
+		OccluderMeshData GenerateOccluderMesh(uint32_t grid_resolution = 32) const;
+
+		// Hash of everything uploaded to the GPU (vertex streams, indices, submesh/LOD ranges and meshlets) but not materials or textures
+		// Meshes with equal hashes share their GPU data, see MeshBufferManager
+		uint64_t CalculateContentHash() const;
 	};
 
 	struct MeshDataAsset : public Asset {
@@ -53,6 +88,20 @@ namespace SNAKE {
 		unsigned num_indices = 0;
 		unsigned num_vertices = 0;
 
+		// Object-space bounds of each submesh, parallel to submeshes
+		std::vector<ExtraMath::AABB> submesh_aabbs;
+
+		// Simplified levels of detail, lods[0] is LOD 1
+		std::vector<MeshLOD> lods;
+
+		std::vector<Meshlet> meshlets;
+
+		// Parallel to submeshes
+		std::vector<SubmeshMeshlets> submesh_meshlets;
+
+		// Simplified geometry rasterised when an instance of this mesh is flagged as an occluder
+		OccluderMeshData occluder_mesh;
+
 		// Memory managed by MeshBufferManager
 		std::vector<class BLAS*> submesh_blas_array;
 	};
@@ -0,0 +1,55 @@
+#pragma once
+
+namespace SNAKE {
+	/*
+	.meshdata layout: a MeshDataFileHeader, header.num_sections MeshDataFileSection entries, then the sections each starting at a multiple of SECTION_ALIGNMENT.
+	Vertex streams, indices and meshlets are stored raw so they're copied from a mapped file straight into staging memory, unless flagged COMPRESSED.
+	Compressed sections are a Compression chunked stream, decompressed in parallel on load into buffers owned by MeshData.
+	Files written before the header existed start with the asset UUID instead of MAGIC, they're read with the old layout and rewritten on load.
+	*/
+	enum class MeshDataSectionType : uint32_t {
+		// ByteSerializer data: name, submeshes, num_vertices, num_indices, materials, textures, then the LOD count and each LOD's error and submeshes
+		METADATA,
+		POSITIONS,
+		NORMALS,
+		TANGENTS,
+		TEX_COORDS,
+		INDICES,
+		// Optional, meshlets are built on load if missing
+		MESHLETS,
+		SUBMESH_MESHLETS,
+		NUM_TYPES
+	};
+
+	struct MeshDataFileSection {
+		enum Flags : uint32_t {
+			COMPRESSED = 1 << 0,
+		};
+
+		// Sections of types this build doesn't know are skipped
+		MeshDataSectionType type;
+
+		// Flags, always 0 in version 1 files
+		uint32_t flags = 0;
+
+		// From the start of the file, size is the stored (compressed if COMPRESSED) size
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct MeshDataFileHeader {
+		std::array<char, 8> magic = MAGIC;
+
+		// Files with a higher version than VERSION are rejected
+		uint32_t version = VERSION;
+		uint32_t num_sections = 0;
+
+		uint64_t uuid = 0;
+
+		inline static constexpr std::array<char, 8> MAGIC = { 'S', 'N', 'K', 'M', 'E', 'S', 'H', '\0' };
+		inline static constexpr uint32_t VERSION = 2;
+		inline static constexpr uint64_t SECTION_ALIGNMENT = 64;
+	};
+
+	static_assert(sizeof(MeshDataFileHeader) == 24 && sizeof(MeshDataFileSection) == 24);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+namespace SNAKE {
+	// Index, LOD and meshlet ranges of a mesh, kept apart from MeshData so code that only walks ranges doesn't need assimp or Vulkan
+
+	struct Submesh {
+		unsigned int num_indices = 0;
+		unsigned int num_vertices = 0;
+		unsigned int base_vertex = 0;
+		unsigned int base_index = 0;
+		unsigned int material_index = 0;
+	};
+
+	// Range of a simplified submesh's indices in MeshData::indices, indices are local to the submesh's base_vertex like Submesh
+	struct SubmeshLOD {
+		unsigned base_index = 0;
+		unsigned num_indices = 0;
+	};
+
+	struct MeshLOD {
+		// Largest object-space distance between this level and the full detail surface, used to select the level by projected size
+		float error = 0.f;
+
+		// Parallel to MeshData::submeshes
+		std::vector<SubmeshLOD> submeshes;
+	};
+
+	// Cluster of at most MeshletBuilder::MAX_TRIANGLES triangles using at most MeshletBuilder::MAX_VERTICES vertices
+	// Its triangles are a contiguous run of its submesh's full detail indices, so a meshlet can be drawn as an index range
+	// Laid out for std430 so the array can be uploaded as is
+	struct Meshlet {
+		// Object-space bounding sphere
+		glm::vec3 center{ 0 };
+		float radius = 0.f;
+
+		// Every triangle is backfacing from a viewpoint p if dot(normalize(cone_apex - p), cone_axis) >= cone_cutoff
+		// A cutoff above 1 means the normals are too spread out for the meshlet to ever be backface culled
+		glm::vec3 cone_apex{ 0 };
+		float cone_cutoff = 2.f;
+
+		glm::vec3 cone_axis{ 0, 0, 1 };
+		uint32_t num_vertices = 0;
+
+		// Range in MeshData::indices
+		uint32_t base_index = 0;
+		uint32_t num_indices = 0;
+
+		uint32_t submesh_idx = 0;
+		uint32_t padding = 0;
+	};
+
+	static_assert(sizeof(Meshlet) == 64);
+
+	// Range of a submesh's meshlets in MeshData::meshlets
+	struct SubmeshMeshlets {
+		uint32_t first_meshlet = 0;
+		uint32_t num_meshlets = 0;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "assets/MeshData.h"
+
+namespace SNAKE {
+	/*
+	Import-time reordering of mesh triangles and vertices for the GPU, never changes the set of triangles drawn.
+	Triangles are ordered for the post-transform vertex cache (Forsyth), then clusters of them are sorted to reduce overdraw (Tipsify style),
+	finally vertices are reordered into the order they are first referenced so vertex fetch reads memory linearly.
+	*/
+	class MeshOptimizer {
+	public:
+		// Results of simulating a FIFO post-transform vertex cache over an index list
+		struct VertexCacheStats {
+			uint32_t num_triangles = 0;
+			uint32_t num_vertices_referenced = 0;
+			uint32_t num_misses = 0;
+
+			// Average cache miss ratio, transformed vertices per triangle (0.5 is the best possible for large regular meshes, 3 the worst)
+			float GetACMR() const {
+				return num_triangles ? (float)num_misses / num_triangles : 0.f;
+			}
+
+			// Average transform to vertex ratio, 1 means every vertex is transformed exactly once
+			float GetATVR() const {
+				return num_vertices_referenced ? (float)num_misses / num_vertices_referenced : 0.f;
+			}
+
+			VertexCacheStats& operator+=(const VertexCacheStats& other) {
+				num_triangles += other.num_triangles;
+				num_vertices_referenced += other.num_vertices_referenced;
+				num_misses += other.num_misses;
+				return *this;
+			}
+		};
+
+		struct Report {
+			// Full detail indices of every submesh
+			VertexCacheStats before;
+			VertexCacheStats after;
+		};
+
+		static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size = SIMULATED_CACHE_SIZE);
+
+		// Returns the triangles of 'indices' in an order that maximises post-transform cache hits
+		static std::vector<uint32_t> OptimizeVertexCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices);
+
+		// Splits cache optimised 'indices' into clusters and orders them so outward facing clusters, which tend to occlude the rest, draw first
+		// Clusters are only split where the resulting ACMR stays within 'threshold' times the input's
+		static std::vector<uint32_t> OptimizeOverdraw(const aiVector3D* positions, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices, float threshold = 1.05f);
+
+		// Reorders the vertices of every submesh into the order the full detail indices, then each LOD's, first reference them
+		// Vertices referenced by no triangle are kept at the end of their submesh
+		static void OptimizeVertexFetch(MeshData& data);
+
+		// Runs every stage on each submesh, LOD index ranges are cache optimised too, overdraw ordering only applies to full detail
+		static Report OptimizeMesh(MeshData& data, float overdraw_threshold = 1.05f);
+
+		// Approximates the post-transform cache of current hardware when reporting and clustering
+		inline static constexpr uint32_t SIMULATED_CACHE_SIZE = 16;
+	};
+}
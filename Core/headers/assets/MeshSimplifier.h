@@ -0,0 +1,25 @@
+#pragma once
+#include "assets/MeshData.h"
+
+namespace SNAKE {
+	/*
+	Quadric error metric edge collapse simplifier used to generate mesh LODs on import.
+	Vertices are only collapsed onto other existing vertices, so simplified index lists reuse the original vertex data unchanged.
+	Vertices on open borders, attribute seams (split vertices) and non-manifold edges are locked so levels never open cracks.
+	*/
+	class MeshSimplifier {
+	public:
+		// Simplifies a triangle list, indices are into 'positions'
+		// Stops once the result has at most 'target_index_count' indices or the cheapest remaining collapse exceeds 'max_error'
+		// out_error (optional) receives the largest object-space error introduced, an upper bound on the distance from the original surface
+		static std::vector<uint32_t> Simplify(const aiVector3D* positions, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices,
+			uint32_t target_index_count, float max_error = std::numeric_limits<float>::max(), float* out_error = nullptr);
+
+		// Generates up to MeshData::MAX_LODS levels, each targeting 'reduction' times the triangles of the previous one
+		// Simplified indices are appended to data.indices (increasing num_indices) and described by data.lods
+		static void GenerateLODs(MeshData& data, float reduction = 0.5f);
+
+		// Generation stops at the first level keeping more than this fraction of the previous level's triangles
+		inline static constexpr float MAX_LOD_TRIANGLE_RATIO = 0.8f;
+	};
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "assets/MeshData.h"
+
+namespace SNAKE {
+	/*
+	Splits the full detail triangles of each submesh into meshlets used for per-cluster culling.
+	Triangles are taken in their existing order, which after MeshOptimizer is already spatially coherent, so meshlets are index ranges
+	and building them never changes the index data.
+	*/
+	class MeshletBuilder {
+	public:
+		// Replaces data.meshlets and data.submesh_meshlets
+		static void BuildMeshlets(MeshData& data);
+
+		// Bounding sphere and normal cone of a triangle list, indices are into 'positions'
+		static void ComputeBounds(const aiVector3D* positions, const uint32_t* indices, uint32_t num_indices, Meshlet& meshlet);
+
+		inline static constexpr uint32_t MAX_VERTICES = 64;
+		inline static constexpr uint32_t MAX_TRIANGLES = 124;
+	};
+}
@@ -6,6 +6,42 @@
 #include "core/DescriptorBuffer.h"
 
 namespace SNAKE {
+	/*
+	Hands out indices into a bindless table, a released index is only handed out again once every frame that could have read it has finished on the GPU.
+	Indices are reused before the table grows, most recently freed first.
+	*/
+	class BindlessSlotAllocator {
+	public:
+		uint32_t Allocate();
+
+		// 'frame' is the VkContext::GetCurrentFrameIdx() the index stopped being used in
+		void Release(uint32_t index, uint64_t frame);
+
+		// Call once per frame, indices released MAX_FRAMES_IN_FLIGHT or more frames before 'frame' become free
+		void Reclaim(uint64_t frame);
+
+		// One past the largest index ever allocated, the size the table needs
+		uint32_t GetHighWater() const {
+			return m_next_index;
+		}
+
+		uint32_t GetNumAllocated() const {
+			return m_next_index - (uint32_t)(m_free_indices.size() + m_released.size());
+		}
+
+	private:
+		struct ReleasedIndex {
+			uint32_t index;
+			uint64_t frame;
+		};
+
+		std::vector<uint32_t> m_free_indices;
+
+		// In release order, so frames are ascending
+		std::deque<ReleasedIndex> m_released;
+
+		uint32_t m_next_index = 0;
+	};
 
 	class GlobalMaterialBufferManager {
 	public:
@@ -17,6 +53,9 @@ namespace SNAKE {
 		// Will probably use up the space for something in the future anyway
 		inline static constexpr uint32_t material_size = sizeof(uint32_t) * 8 * 2;
 
+		// Materials the buffers are created for, they double whenever more are registered
+		inline static constexpr uint32_t INITIAL_CAPACITY = 4096;
+
 		std::array<std::shared_ptr<DescriptorBuffer>, MAX_FRAMES_IN_FLIGHT> descriptor_buffers{};
 
 		S_VkBuffer& GetMaterialUBO(FrameInFlightIndex idx) {
@@ -28,11 +67,17 @@ namespace SNAKE {
 
 		void UpdateMaterialUBO();
 
+		// Releases the material's index, its data is left in the buffers until the index is reused
+		void UnregisterMaterial(MaterialAsset* p_mat);
+
 		EventListener m_material_asset_event_listener;
 		EventListener m_material_update_event_listener;
 		EventListener m_frame_start_listener;
-		// Current index to write to 
-		uint16_t m_current_index = 0;
+
+		BindlessSlotAllocator m_slots;
+
+		// Materials m_material_ubos are sized for, each frame in flight's buffer grows to it on that frame's start
+		uint32_t m_capacity = INITIAL_CAPACITY;
 
 		std::array<S_VkBuffer, MAX_FRAMES_IN_FLIGHT> m_material_ubos;
 
@@ -45,16 +90,44 @@ namespace SNAKE {
 	public:
 		void Init(const std::array<std::shared_ptr<DescriptorBuffer>, MAX_FRAMES_IN_FLIGHT>& buffers);
 
+		// Writes the texture's descriptor, an index is only assigned if it doesn't have one from RegisterPlaceholder
 		void RegisterTexture(AssetRef<Texture2DAsset> tex);
 
+		// Assigns tex an index with placeholder's image bound to it until RegisterTexture is called for tex
+		// Used for textures that are still loading, materials can reference them and never need updating once they load
+		void RegisterPlaceholder(AssetRef<Texture2DAsset> tex, AssetRef<Texture2DAsset> placeholder);
+
+		// Most textures the descriptor array can grow to, declared as its size in the descriptor set layout
+		static uint32_t GetMaxTextures();
+
 		std::array<std::shared_ptr<DescriptorBuffer>, MAX_FRAMES_IN_FLIGHT> descriptor_buffers{};
+
+		// Descriptors the buffers are created for, they double whenever more textures are registered
+		inline static constexpr uint32_t INITIAL_CAPACITY = 4096;
+
 	private:
 		void RegisterTexturesInternal();
 
-		uint16_t m_current_index = 0;
+		uint32_t AllocateIndex();
+
+		// Releases the texture's index, its descriptor is left in place until the index is reused
+		void UnregisterTexture(Texture2DAsset* p_tex);
+
+		BindlessSlotAllocator m_slots;
+
+		// Descriptors each frame in flight's buffer grows to on that frame's start
+		uint32_t m_capacity = INITIAL_CAPACITY;
 
 		EventListener m_frame_start_listener;
+		EventListener m_asset_event_listener;
+
+		struct PendingRegistration {
+			uint32_t global_index;
+
+			// Texture whose image is written to global_index
+			AssetRef<Texture2DAsset> image_source;
+		};
 
-		std::unordered_map<FrameInFlightIndex, std::vector<AssetRef<Texture2DAsset>>> m_textures_to_register;
+		std::unordered_map<FrameInFlightIndex, std::vector<PendingRegistration>> m_textures_to_register;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include "core/VkIncl.h"
+
+namespace SNAKE {
+	/*
+	.tex2d layout: a Texture2DFileHeader, header.mip_levels Texture2DFileMip entries, the name, then each mip's texel data starting at a multiple of MIP_ALIGNMENT.
+	Mips are stored in header.format (block compressed, see TextureEncoder) and uploaded from the mapped file as they are, nothing is decoded on load.
+	Files written before the header existed start with the asset UUID and hold the source image file (.png, .jpg etc), it's decoded and mipmapped on the CPU when loaded.
+	*/
+	struct Texture2DFileMip {
+		// From the start of the file
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct Texture2DFileHeader {
+		std::array<char, 8> magic = MAGIC;
+
+		// Files with a higher version than VERSION are rejected
+		uint32_t version = VERSION;
+		vk::Format format = vk::Format::eUndefined;
+
+		uint64_t uuid = 0;
+
+		// Of the source image file and the uncompressed format it was imported as, so identical imports are found whether loaded from a .tex2d or not
+		uint64_t content_hash = 0;
+
+		glm::uvec2 size{ 0, 0 };
+		uint32_t mip_levels = 0;
+
+		// Bytes of the name stored after the mip table
+		uint32_t name_size = 0;
+
+		inline static constexpr std::array<char, 8> MAGIC = { 'S', 'N', 'K', 'T', 'E', 'X', '2', 'D' };
+		inline static constexpr uint32_t VERSION = 1;
+		inline static constexpr uint64_t MIP_ALIGNMENT = 64;
+	};
+
+	static_assert(sizeof(Texture2DFileHeader) == 48 && sizeof(Texture2DFileMip) == 16);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "core/VkIncl.h"
+#include <bit>
+
+namespace SNAKE {
+	/*
+	Import-time mip generation and block compression of RGBA8 textures to BC1/BC3/BC5/BC7 so they're uploaded as stored, every mip included, instead of decoded on load.
+	Endpoints are fitted along each block's principal axis then refined by least squares against the chosen indices, index selection uses SSE.
+	Blocks are independent so rows of them are encoded in parallel on the JobSystem.
+	BC7 only uses mode 6 (one subset, 7777 endpoints with a p-bit each, 4 bit indices), fast to search and good on the smooth content most textures are.
+	*/
+	class TextureEncoder {
+	public:
+		// How a texture is sampled, decides the format it's encoded to
+		enum class Usage : uint32_t {
+			// sRGB colour, BC7
+			ALBEDO,
+			// Tangent space XY in RG, Z is reconstructed in shaders, BC5
+			NORMAL,
+			// Linear data such as roughness, metallic or AO, BC1, or BC3 if any texel isn't opaque
+			MASK,
+		};
+
+		static vk::Format SelectFormat(Usage usage, bool has_alpha);
+
+		// True for formats SelectFormat can return, the only ones .tex2d files are written in
+		static bool IsSelectableFormat(vk::Format format);
+
+		// Uncompressed format textures with 'usage' are loaded as before they're encoded
+		static vk::Format GetSourceFormat(Usage usage) {
+			return usage == Usage::ALBEDO ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+		}
+
+		// 'format' must be one SelectFormat can return, edge blocks of sizes that aren't a multiple of 4 repeat the last row/column
+		static std::vector<std::byte> Encode(const std::byte* p_rgba, uint32_t width, uint32_t height, vk::Format format);
+
+		// RGBA8 levels below p_rgba down to 1x1, GetNumMips(width, height) - 1 of them
+		// Each level is downsampled from the last in linear space with a Kaiser windowed sinc, edges clamped
+		// ALBEDO colour is converted from sRGB and weighted by alpha so transparent texels don't bleed, NORMAL vectors are renormalised every level
+		// Rows are filtered in bands of MIP_ROWS_PER_JOB on the JobSystem, only the source rows a band reads are converted to float
+		static std::vector<std::vector<std::byte>> GenerateMips(const std::byte* p_rgba, uint32_t width, uint32_t height, Usage usage);
+
+		static bool HasAlpha(const std::byte* p_rgba, uint32_t width, uint32_t height);
+
+		static bool IsBlockCompressed(vk::Format format);
+
+		// Bytes of one mip level, block compressed formats round up to whole blocks
+		// Only BCn and the RGBA8 source formats are supported, anything else asserts and returns 0
+		static uint64_t GetMipSize(vk::Format format, uint32_t width, uint32_t height);
+
+		// Full chain down to 1x1
+		static uint32_t GetNumMips(uint32_t width, uint32_t height) {
+			return (uint32_t)std::bit_width(glm::max(width, height));
+		}
+
+		// Rows of blocks encoded per job
+		inline static constexpr uint32_t BLOCK_ROWS_PER_JOB = 4;
+
+		// Rows of a mip level filtered per job
+		inline static constexpr uint32_t MIP_ROWS_PER_JOB = 16;
+
+		// Radius of the mip filter in destination texels, and its window's shape (higher is smoother with less ringing)
+		inline static constexpr float KAISER_WIDTH = 2.f;
+		inline static constexpr float KAISER_ALPHA = 4.f;
+
+	private:
+		// Each takes 16 RGBA8 texels in row order
+		static void EncodeBlockBC1(const uint8_t* p_texels, std::byte* p_out);
+		static void EncodeBlockBC3(const uint8_t* p_texels, std::byte* p_out);
+		static void EncodeBlockBC5(const uint8_t* p_texels, std::byte* p_out);
+		static void EncodeBlockBC7(const uint8_t* p_texels, std::byte* p_out);
+	};
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "assets/TextureAssets.h"
+#include "assets/TextureResidencyPolicy.h"
+#include "assets/AssetLoader.h"
+#include "rendering/UploadBatch.h"
+#include "events/EventManager.h"
+
+namespace SNAKE {
+	struct TextureResidencyStats {
+		uint32_t num_textures = 0;
+		uint64_t resident_bytes = 0;
+
+		// Changes applied, by whether they added or removed mips
+		uint32_t num_streamed_in = 0;
+		uint32_t num_evicted = 0;
+		uint32_t num_failed = 0;
+
+		uint64_t bytes_uploaded = 0;
+	};
+
+	/*
+	Streams the mips of textures loaded by AssetStreamer in and out within a VRAM budget, the policy itself is TextureResidencyPolicy.
+	AssetStreamer only uploads a texture's mip tail (levels no larger than MAX_TAIL_SIZE) then registers it here, CullingSystem requests
+	the mip each visible texture is sampled at from its screen coverage.
+	A change reads the mips that will be resident from the mapped .tex2d on a JobSystem worker, then on frame start an image holding just those
+	is created and uploaded, swapped into the texture and its bindless descriptor rewritten at the same index, then an UPDATED AssetEvent is dispatched.
+	The replaced image is destroyed once no frame in flight can still be sampling it.
+	Textures not loaded through AssetStreamer (pre-versioned files, imported images) are always fully resident and aren't counted against the budget.
+	*/
+	class TextureResidencyManager {
+	public:
+		static void Init() { Get().I_Init(); }
+
+		// Waits for reads in progress and destroys retired images, call before AssetManager::Shutdown
+		static void Shutdown();
+
+		// p_tex's image holds the levels of the full texture 'full_spec' describes from tail_top on
+		static void Register(Texture2DAsset* p_tex, const std::string& filepath, const Image2DSpec& full_spec, uint32_t tail_top);
+
+		// Stops managing p_tex, leaving its image with whatever levels it holds, mips being read for it are dropped
+		// No effect if p_tex isn't registered, called automatically when a registered texture is deleted
+		static void Unregister(Texture2DAsset* p_tex);
+
+		static bool IsRegistered(Texture2DAsset* p_tex) {
+			return Get().m_textures.contains(p_tex);
+		}
+
+		// 'mip' is a level of the full texture, no effect if p_tex isn't registered
+		static void RequestMip(Texture2DAsset* p_tex, uint32_t mip);
+
+		// Requests the mip with about one texel per pixel if the texture is stretched once across 'pixels'
+		static void RequestScreenCoverage(Texture2DAsset* p_tex, float pixels);
+
+		// Finest level of a texture that's always resident
+		static uint32_t GetTailTop(const Image2DSpec& full_spec);
+
+		// Spec of the image holding levels from 'top' on
+		static Image2DSpec GetResidentSpec(const Image2DSpec& full_spec, uint32_t top);
+
+		static void SetBudget(uint64_t bytes) {
+			Get().m_policy.budget_bytes = bytes;
+		}
+
+		static uint64_t GetBudget() {
+			return Get().m_policy.budget_bytes;
+		}
+
+		static const TextureResidencyStats& GetStats() {
+			return Get().m_stats;
+		}
+
+		// Largest dimension of the finest level that's always resident
+		inline static constexpr uint32_t MAX_TAIL_SIZE = 128;
+
+	private:
+		static TextureResidencyManager& Get() {
+			static TextureResidencyManager instance;
+			return instance;
+		}
+
+		void I_Init();
+
+		struct ManagedTexture {
+			std::string filepath;
+			Image2DSpec full_spec;
+			TextureResidencyPolicy::TextureID id;
+
+			// Identifies the registration so mips read for a deleted texture are never applied to a new one at the same address
+			uint64_t registration;
+		};
+
+		struct LoadedMips {
+			Texture2DAsset* p_tex = nullptr;
+			uint64_t registration = 0;
+			uint32_t top_mip = 0;
+			bool success = false;
+
+			// Levels from top_mip on point into the mapped file
+			AssetLoader::Texture2DFileContents contents;
+		};
+
+		struct RetiredImage {
+			std::unique_ptr<Image2D> p_image;
+			uint64_t frame;
+		};
+
+		// Frame start, applies changes whose mips have been read then plans new ones
+		void Update();
+
+		void ApplyLoadedMips();
+
+		void PollInFlightBatches();
+
+		// Starts a worker reading the levels of p_tex from top_mip on
+		void StartRead(Texture2DAsset* p_tex, const ManagedTexture& managed, uint32_t top_mip);
+
+		// Runs on a worker
+		static LoadedMips ReadMips(const std::string& filepath, const Image2DSpec& full_spec, uint32_t top_mip);
+
+		void OnAssetDestroyed(Asset* p_asset);
+
+		TextureResidencyPolicy m_policy;
+		std::unordered_map<Texture2DAsset*, ManagedTexture> m_textures;
+
+		// Indexed by TextureResidencyPolicy::TextureID, null for free IDs
+		std::vector<Texture2DAsset*> m_textures_by_id;
+		uint64_t m_next_registration = 0;
+
+		// Incremented every frame start, requests are counted in the frame they're made
+		uint64_t m_frame = 0;
+
+		// Guards m_loaded and m_num_reading, which workers touch
+		std::mutex m_mux;
+		std::vector<LoadedMips> m_loaded;
+		uint32_t m_num_reading = 0;
+
+		std::vector<RetiredImage> m_retired;
+
+		// Submitted batches are kept alive until their fence signals
+		std::vector<std::unique_ptr<UploadBatch>> m_in_flight_batches;
+
+		TextureResidencyStats m_stats;
+
+		EventListener m_frame_start_listener;
+		EventListener m_asset_event_listener;
+	};
+}
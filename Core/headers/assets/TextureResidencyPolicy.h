@@ -0,0 +1,90 @@
+#pragma once
+
+namespace SNAKE {
+	/*
+	Decides which mip levels of streamed textures are resident within a memory budget, it knows nothing about Vulkan so it can be driven by a simulated budget.
+	Every texture keeps its mip tail (tail_top down to the last level) resident, that's all it has when added.
+	Each frame textures are requested at the finest mip they're sampled at, Update then plans changes:
+	- Textures requested finer than what's resident stream up to the request, most recently requested first, within max_stream_bytes_per_update
+	- If that would exceed budget_bytes, mips finer than a texture's own request are dropped first, then textures requested less recently than the one
+	  streaming in lose everything above their tail, least recently requested first
+	A texture with a change in flight isn't changed again until CompleteChange is called for it.
+	*/
+	class TextureResidencyPolicy {
+	public:
+		using TextureID = uint32_t;
+
+		struct Change {
+			TextureID id;
+
+			// Finest resident mip once the change is applied, every level from it to the last is resident
+			uint32_t top_mip;
+		};
+
+		// 'mip_sizes' are the bytes of each level, finest first
+		TextureID AddTexture(const std::vector<uint64_t>& mip_sizes, uint32_t tail_top, uint64_t frame);
+
+		void RemoveTexture(TextureID id);
+
+		// The finest mip requested for a texture in a frame is kept, requests from earlier frames are replaced
+		void Request(TextureID id, uint32_t mip, uint64_t frame);
+
+		// Plans this frame's changes, resident sizes are counted as if they were already applied
+		std::vector<Change> Update(uint64_t frame);
+
+		// Call once a change from Update has been applied, or with the mip that is actually resident if it couldn't be
+		void CompleteChange(TextureID id, uint32_t resident_top);
+
+		uint32_t GetResidentTop(TextureID id) const {
+			return m_textures[id].resident_top;
+		}
+
+		bool IsChangePending(TextureID id) const {
+			return m_textures[id].pending;
+		}
+
+		uint64_t GetResidentBytes() const {
+			return m_resident_bytes;
+		}
+
+		uint32_t GetNumTextures() const {
+			return (uint32_t)(m_textures.size() - m_free_ids.size());
+		}
+
+		uint64_t budget_bytes = 1024ull * 1024 * 1024;
+
+		// At least one change is planned per update even if it's larger
+		uint64_t max_stream_bytes_per_update = 64 * 1024 * 1024;
+
+		// Frames a request keeps a texture's mips wanted for, after that its mips above the tail can be evicted
+		uint32_t request_lifetime_frames = 60;
+
+	private:
+		struct Texture {
+			// Bytes of every level from index i to the last, with a trailing 0
+			std::vector<uint64_t> bytes_from;
+
+			uint32_t tail_top = 0;
+			uint32_t resident_top = 0;
+			uint32_t requested_top = 0;
+			uint64_t last_request_frame = 0;
+
+			bool pending = false;
+			bool alive = false;
+		};
+
+		// The mip a texture should have resident, its tail once its request has expired
+		uint32_t GetDesiredTop(const Texture& tex, uint64_t frame) const;
+
+		void SetResidentTop(TextureID id, uint32_t top, std::vector<Change>& changes);
+
+		// Evicts until 'needed' bytes are freed or nothing else can be, returns the bytes freed
+		// Beyond mips finer than their own request, only textures last requested before 'protect_frame' lose mips
+		uint64_t Evict(uint64_t needed, uint64_t frame, uint64_t protect_frame, TextureID exclude, std::vector<Change>& changes);
+
+		std::vector<Texture> m_textures;
+		std::vector<TextureID> m_free_ids;
+
+		uint64_t m_resident_bytes = 0;
+	};
+}
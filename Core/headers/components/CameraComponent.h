@@ -1,4 +1,5 @@
 #include "Component.h"
+#include "scene/Entity.h"
 #include "events/EventManager.h"
 #include "events/EventsCommon.h"
 
@@ -18,6 +19,11 @@ namespace SNAKE {
 			return proj;
 		}
 
+		glm::mat4 GetViewMatrix() {
+			auto* p_transform = GetEntity()->GetComponent<TransformComponent>();
+			return glm::lookAt(p_transform->GetPosition(), p_transform->GetPosition() + p_transform->forward, glm::vec3(0.f, 1.f, 0.f));
+		}
+
 		// Makes camera active in scene (rendering done from this cameras perspective)
 		void MakeActive() {
 			EventManagerG::DispatchEvent(ComponentEvent<CameraComponent>(this, ComponentEventType::UPDATED));
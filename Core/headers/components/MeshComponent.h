@@ -38,9 +38,20 @@ namespace SNAKE {
 			return materials;
 		}
 
+		// Occluders are rasterised into the CPU occlusion buffers used by CullingSystem, should be set on large solid meshes like walls
+		void SetOccluder(bool _occluder) {
+			occluder = _occluder;
+			EventManagerG::DispatchEvent(ComponentEvent<StaticMeshComponent>(this, ComponentEventType::UPDATED));
+		}
+
+		bool IsOccluder() const {
+			return occluder;
+		}
+
 	private:
 		AssetRef<StaticMeshAsset> mesh_asset{ nullptr };
 		std::vector<AssetRef<MaterialAsset>> materials;
+		bool occluder = false;
 
 		friend class SceneSerializer;
 		friend class EntityEditor;
@@ -13,7 +13,7 @@ namespace SNAKE {
 		DescriptorSetSpec& operator=(const DescriptorSetSpec& other) = delete;
 
 		DescriptorSetSpec(DescriptorSetSpec&& other) noexcept :
-			m_layout_bindings(std::move(other.m_layout_bindings)), m_layout(std::move(other.m_layout)),
+			m_layout_bindings(std::move(other.m_layout_bindings)), m_binding_flags(std::move(other.m_binding_flags)), m_layout(std::move(other.m_layout)),
 			m_binding_offsets(std::move(other.m_binding_offsets)) {}
 
 		DescriptorSetSpec& GenDescriptorLayout();
@@ -24,7 +24,9 @@ namespace SNAKE {
 
 		vk::DescriptorType GetDescriptorTypeAtBinding(unsigned binding) const;
 
-		DescriptorSetSpec& AddDescriptor(unsigned binding_point, vk::DescriptorType type, vk::ShaderStageFlags flags, uint32_t descriptor_count = 1);
+		// A binding with eVariableDescriptorCount must be the last, descriptor_count is then the most it can hold, see DescriptorBuffer::CreateBuffer
+		DescriptorSetSpec& AddDescriptor(unsigned binding_point, vk::DescriptorType type, vk::ShaderStageFlags flags, uint32_t descriptor_count = 1,
+			vk::DescriptorBindingFlags binding_flags = {});
 
 		vk::DescriptorSetLayout GetLayout() const;
 
@@ -32,9 +34,16 @@ namespace SNAKE {
 		using BindingIndex = uint32_t;
 		BindingOffset GetBindingOffset(BindingIndex binding_index) const;
 
+		// Size of a set whose variable count binding holds 'variable_descriptor_count' descriptors, aligned for use in a descriptor buffer
+		// The full size if there's no variable count binding
+		size_t GetAlignedSize(uint32_t variable_descriptor_count) const;
+
 	private:
 		std::vector<vk::DescriptorSetLayoutBinding> m_layout_bindings;
 
+		// Parallel to m_layout_bindings
+		std::vector<vk::DescriptorBindingFlags> m_binding_flags;
+
 		vk::UniqueDescriptorSetLayout m_layout;
 		
 		std::unordered_map<BindingIndex, BindingOffset> m_binding_offsets;
@@ -54,9 +63,19 @@ namespace SNAKE {
 
 		DescriptorBuffer(DescriptorBuffer&& other) noexcept :
 			descriptor_buffer(std::move(other.descriptor_buffer)),
-			mp_descriptor_spec(std::move(other.mp_descriptor_spec)) {}
+			mp_descriptor_spec(std::move(other.mp_descriptor_spec)),
+			m_num_sets(other.m_num_sets), m_set_stride(other.m_set_stride), m_variable_descriptor_count(other.m_variable_descriptor_count) {}
+
+		// Sets with a variable count binding are created holding 'variable_descriptor_count' descriptors in it, or the most it can hold if not given
+		void CreateBuffer(uint32_t num_sets, std::optional<uint32_t> variable_descriptor_count = std::nullopt);
 
-		void CreateBuffer(uint32_t num_sets);
+		// Grows the variable count binding of a single set buffer to hold at least 'count' descriptors, keeping every descriptor written
+		// The buffer is replaced, it must not be in use by the GPU
+		void GrowVariableDescriptorCount(uint32_t count);
+
+		uint32_t GetVariableDescriptorCount() const {
+			return m_variable_descriptor_count;
+		}
 
 		void LinkResource(S_VkResource const* p_resource, DescriptorGetInfo& get_info, unsigned binding_idx, unsigned set_buffer_idx, uint32_t array_idx = 0 );
 
@@ -82,6 +101,10 @@ namespace SNAKE {
 		std::weak_ptr<const DescriptorSetSpec> mp_descriptor_spec;
 		std::vector<std::unordered_map<uint32_t, ResourceLinkInfo>> m_resource_link_infos;
 		vk::BufferUsageFlags m_usage_flags;
+
+		uint32_t m_num_sets = 0;
+		size_t m_set_stride = 0;
+		uint32_t m_variable_descriptor_count = 0;
 	};
 
 }
\ No newline at end of file
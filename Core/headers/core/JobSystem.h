@@ -80,6 +80,57 @@ namespace SNAKE {
 			return job;
 		}
 
+		// Splits [0, count) into chunks of chunk_size and calls func(begin, end) for each, blocks until all chunks are finished
+		// The calling thread processes chunks too, so this is safe to call from inside a job
+		static void ParallelFor(uint32_t count, uint32_t chunk_size, const std::function<void(uint32_t, uint32_t)>& func) {
+			SNK_DBG_ASSERT(chunk_size > 0);
+			uint32_t num_chunks = (count + chunk_size - 1) / chunk_size;
+
+			if (num_chunks <= 1) {
+				if (count > 0)
+					func(0, count);
+				return;
+			}
+
+			struct ParallelForState {
+				std::function<void(uint32_t, uint32_t)> func;
+				uint32_t count;
+				uint32_t chunk_size;
+				uint32_t num_chunks;
+				std::atomic_uint32_t next_chunk = 0;
+				std::atomic_uint32_t finished_chunks = 0;
+			};
+
+			// Shared so jobs which only start after every chunk has been claimed can still safely exit
+			auto p_state = std::make_shared<ParallelForState>();
+			p_state->func = func;
+			p_state->count = count;
+			p_state->chunk_size = chunk_size;
+			p_state->num_chunks = num_chunks;
+
+			auto run_chunks = [](ParallelForState& state) {
+				uint32_t chunk;
+				while ((chunk = state.next_chunk.fetch_add(1)) < state.num_chunks) {
+					uint32_t begin = chunk * state.chunk_size;
+					state.func(begin, std::min(begin + state.chunk_size, state.count));
+					state.finished_chunks.fetch_add(1, std::memory_order_release);
+				}
+			};
+
+			uint32_t num_jobs = std::min(num_chunks - 1, (uint32_t)Get().m_threads.size());
+			for (uint32_t i = 0; i < num_jobs; i++) {
+				auto* p_job = CreateJob();
+				p_job->func = [p_state, run_chunks]([[maybe_unused]] Job const* p_this) { run_chunks(*p_state); };
+				Execute(p_job);
+			}
+
+			run_chunks(*p_state);
+
+			while (p_state->finished_chunks.load(std::memory_order_acquire) != num_chunks) {
+				std::this_thread::yield();
+			}
+		}
+
 	private:
 		void ShutdownImpl() {
 			m_is_running = false;
@@ -126,11 +177,13 @@ namespace SNAKE {
 				std::this_thread::yield();
 			}
 
+			// A waited on job can be deleted by WaitOn as soon as it's marked finished
+			bool is_waited_on = job->is_waited_on;
 			job->unfinished_jobs.fetch_sub(1);
 
 			m_thread_jobs[id] = nullptr;
 
-			if (!job->is_waited_on) {
+			if (!is_waited_on) {
 				if (job->p_parent)
 					job->p_parent->unfinished_jobs.fetch_sub(1);
 
@@ -74,6 +74,12 @@ namespace SNAKE {
 			return *this;
 		}
 
+		// Adds an attribute read from a binding added with AddVertexBinding, for interleaved vertex formats
+		GraphicsPipelineBuilder& AddVertexAttribute(const vk::VertexInputAttributeDescription& attribute_desc) {
+			vertex_attribute_descriptions.push_back(attribute_desc);
+			return *this;
+		}
+
 		void Build();
 
 		PipelineLayoutBuilder pipeline_layout_builder;
@@ -0,0 +1,85 @@
+#pragma once
+#include "core/VkContext.h"
+
+namespace SNAKE {
+	// Timeline semaphore value signalled once an upload has finished, a default constructed ticket is always complete
+	struct UploadTicket {
+		uint64_t value = 0;
+	};
+
+	/*
+	Submits uploads to the dedicated transfer queue if the device has one, the graphics queue otherwise.
+	Every submission signals the next value of a timeline semaphore, returned as an UploadTicket, the CPU never waits on submit.
+	With a dedicated queue a graphics queue submission waiting on the transfer is made straight after, it holds the acquire half of any
+	ownership transfers and a barrier ordering all later graphics work after the upload, and signals the ticket.
+	Thread-safe.
+	*/
+	class UploadEngine {
+	public:
+		static UploadEngine& Get() {
+			static UploadEngine s_instance;
+			return s_instance;
+		}
+
+		static void Init() {
+			Get().IInit();
+		}
+
+		// Waits for every submitted upload, the device must still be alive
+		static void Shutdown() {
+			Get().IShutdown();
+		}
+
+		using RecordFunc = std::function<void(vk::CommandBuffer cmd)>;
+
+		// 'record_transfer' records the copies and, with a dedicated queue, release barriers for resources changing queue family
+		// 'record_acquire' records the matching acquire barriers on the graphics queue, it is only called if UsesDedicatedQueue is true
+		UploadTicket Submit(const RecordFunc& record_transfer, const RecordFunc& record_acquire = {});
+
+		bool IsComplete(UploadTicket ticket) const;
+
+		void Wait(UploadTicket ticket) const;
+
+		bool UsesDedicatedQueue() const {
+			return VkContext::GetLogicalDevice().HasDedicatedTransferQueue();
+		}
+
+		uint32_t GetNumInFlight() {
+			std::scoped_lock l(m_mux);
+			return (uint32_t)m_in_flight.size();
+		}
+
+	private:
+		UploadEngine() = default;
+		UploadEngine(const UploadEngine& other) = delete;
+
+		void IInit();
+		void IShutdown();
+
+		// Frees command buffers of finished submissions, m_mux must be held
+		void CollectCompleted();
+
+		vk::UniqueCommandBuffer AllocateCommandBuffer(vk::CommandPool pool);
+
+		struct InFlightSubmission {
+			uint64_t value = 0;
+			vk::UniqueCommandBuffer transfer_cmd;
+			vk::UniqueCommandBuffer acquire_cmd;
+		};
+
+		std::mutex m_mux;
+
+		uint64_t m_last_submitted_value = 0;
+		std::vector<InFlightSubmission> m_in_flight;
+
+		// Signalled by the graphics queue once an upload is complete and visible to it, ticket values refer to this
+		vk::UniqueSemaphore m_timeline;
+
+		// Signalled by the dedicated transfer queue with the same values, waited on by the acquire submissions
+		vk::UniqueSemaphore m_transfer_timeline;
+
+		// Command pools aren't thread-safe, these are only used with m_mux held
+		vk::UniqueCommandPool m_transfer_pool;
+		vk::UniqueCommandPool m_graphics_pool;
+	};
+}
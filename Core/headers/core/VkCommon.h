@@ -8,6 +8,9 @@ namespace SNAKE {
 		std::optional<uint32_t> graphics_family;
 		std::optional<uint32_t> present_family;
 
+		// Only set if the device has a transfer-only family, uploads fall back to the graphics queue otherwise
+		std::optional<uint32_t> transfer_family;
+
 		bool IsComplete() {
 			return graphics_family.has_value() && present_family.has_value();
 		}
@@ -26,6 +26,34 @@ namespace SNAKE {
 			m_graphics_mux.unlock();
 		}
 
+		// Only valid if HasDedicatedTransferQueue returns true
+		void SubmitTransfer(const vk::SubmitInfo& info, std::optional<vk::Fence> fence = std::nullopt) {
+			SNK_ASSERT(m_transfer_queue);
+			m_transfer_mux.lock();
+			SNK_CHECK_VK_RESULT(m_transfer_queue.submit(info, fence.has_value() ? fence.value() : VK_NULL_HANDLE));
+			m_transfer_mux.unlock();
+		}
+
+		void TransferQueueWaitIdle() {
+			SNK_ASSERT(m_transfer_queue);
+			m_transfer_mux.lock();
+			SNK_CHECK_VK_RESULT(m_transfer_queue.waitIdle());
+			m_transfer_mux.unlock();
+		}
+
+		bool HasDedicatedTransferQueue() const {
+			return m_transfer_family.has_value();
+		}
+
+		uint32_t GetGraphicsFamily() const {
+			return m_graphics_family;
+		}
+
+		// Falls back to the graphics family if there is no dedicated transfer queue
+		uint32_t GetTransferFamily() const {
+			return m_transfer_family.value_or(m_graphics_family);
+		}
+
 		vk::Result SubmitPresentation(const vk::PresentInfoKHR& info) {
 			m_present_mux.lock();
 			auto res = m_presentation_queue.presentKHR(info);
@@ -36,9 +64,14 @@ namespace SNAKE {
 	private:
 		std::mutex m_graphics_mux;
 		std::mutex m_present_mux;
+		std::mutex m_transfer_mux;
 
 		vk::Queue m_graphics_queue;
 		vk::Queue m_presentation_queue;
+		vk::Queue m_transfer_queue;
+
+		uint32_t m_graphics_family = 0;
+		std::optional<uint32_t> m_transfer_family;
 		friend class VkContext;
 		friend class ImGuiLayer;
 	};
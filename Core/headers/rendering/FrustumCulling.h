@@ -0,0 +1,51 @@
+#pragma once
+
+namespace SNAKE {
+	// World-space bounding boxes stored as structure-of-arrays so four boxes can be tested per SIMD iteration
+	// Arrays are padded to a multiple of 4, padding boxes are never reported as visible
+	struct CullingBoundsSoA {
+		void Resize(uint32_t count);
+
+		void Set(uint32_t idx, const glm::vec3& center, const glm::vec3& extents) {
+			center_x[idx] = center.x;
+			center_y[idx] = center.y;
+			center_z[idx] = center.z;
+			extent_x[idx] = extents.x;
+			extent_y[idx] = extents.y;
+			extent_z[idx] = extents.z;
+		}
+
+		uint32_t GetCount() const {
+			return m_count;
+		}
+
+		std::vector<float> center_x;
+		std::vector<float> center_y;
+		std::vector<float> center_z;
+		std::vector<float> extent_x;
+		std::vector<float> extent_y;
+		std::vector<float> extent_z;
+
+	private:
+		uint32_t m_count = 0;
+	};
+
+	using FrustumPlanes = std::array<glm::vec4, 6>;
+
+	class FrustumCuller {
+	public:
+		// Appends the indices of boxes in [begin, end) that intersect the frustum to out_visible, in ascending order
+		// begin must be a multiple of 4
+		static void CullRange(const CullingBoundsSoA& bounds, const FrustumPlanes& planes, uint32_t begin, uint32_t end, std::vector<uint32_t>& out_visible);
+
+		// One box at a time, what CullRange does without SSE, kept available so both paths can be compared
+		static void CullRangeScalar(const CullingBoundsSoA& bounds, const FrustumPlanes& planes, uint32_t begin, uint32_t end, std::vector<uint32_t>& out_visible);
+
+		// Culls bounds against every view in 'views', splitting the work into JobSystem jobs, blocks until finished
+		// out_visible[i] receives the ascending visible indices for views[i]
+		static void CullParallel(const CullingBoundsSoA& bounds, const std::vector<FrustumPlanes>& views, std::vector<std::vector<uint32_t>>& out_visible);
+
+		// Number of boxes handled by a single job in CullParallel
+		inline static constexpr uint32_t JOB_CHUNK_SIZE = 16384;
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "core/VkIncl.h"
+#include "core/VkCommon.h"
+#include "resources/S_VkBuffer.h"
+#include "rendering/IndirectDrawBuilder.h"
+
+namespace SNAKE {
+	// Per frame-in-flight GPU buffers that an IndirectDrawBuilder's output is uploaded to
+	class IndirectDrawBuffers {
+	public:
+		void Init();
+
+		// Copies the builder's commands and instance data into this frame's buffers, growing them if needed
+		void Upload(const IndirectDrawBuilder& builder, FrameInFlightIndex fif);
+
+		// Fills 'sources' with the ranges and MeshBufferManager offsets of each snapshot mesh range that has visible items, for IndirectDrawBuilder::AddVisibleItems
+		static void ResolveMeshSources(const struct SceneSnapshotData& snapshot, const CullingSystem::VisibleList& visible, std::vector<IndirectDrawBuilder::MeshDrawSource>& sources);
+
+		S_VkBuffer& GetCommandBuffer(FrameInFlightIndex fif) {
+			return m_command_buffers[fif];
+		}
+
+		S_VkBuffer& GetInstanceBuffer(FrameInFlightIndex fif) {
+			return m_instance_buffers[fif];
+		}
+
+		uint32_t GetDrawCount(FrameInFlightIndex fif) const {
+			return m_draw_counts[fif];
+		}
+
+		inline static constexpr uint32_t INITIAL_CAPACITY = 4096;
+
+	private:
+		std::array<S_VkBuffer, MAX_FRAMES_IN_FLIGHT> m_command_buffers;
+		std::array<S_VkBuffer, MAX_FRAMES_IN_FLIGHT> m_instance_buffers;
+		std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> m_draw_counts{};
+	};
+}
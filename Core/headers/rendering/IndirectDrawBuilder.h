@@ -0,0 +1,81 @@
+#pragma once
+#include "assets/MeshLayout.h"
+#include "scene/CullingSystem.h"
+#include <span>
+
+namespace SNAKE {
+	// Per-instance data read in shaders with gl_InstanceIndex, matches DrawInstanceData in "InstanceData.glsl"
+	struct DrawInstanceData {
+		uint32_t transform_idx;
+		uint32_t material_idx;
+		uint32_t quantisation_idx;
+	};
+
+	// Same layout as VkDrawIndexedIndirectCommand so commands can be copied into an indirect buffer as is, see IndirectDrawBuffers
+	struct DrawIndexedCommand {
+		uint32_t index_count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t vertex_offset;
+		uint32_t first_instance;
+	};
+
+	/*
+	Builds a list of indexed indirect draw commands and the per-instance data they read, entirely on the CPU.
+	Consecutive draws of the same submesh are merged into one instanced command, materials are part of the instance data so they don't split batches.
+	Offsets are global into MeshBufferManager's buffers, so they must be bound at offset 0.
+	Meshes are passed in already resolved, so building needs no device or AssetManager, IndirectDrawBuffers resolves them and uploads the output.
+	*/
+	class IndirectDrawBuilder {
+	public:
+		struct SubmeshDrawInfo {
+			// Global index into the mesh index buffer
+			uint32_t first_index;
+			uint32_t index_count;
+
+			// Global vertex offset into the mesh vertex buffers
+			int32_t vertex_offset;
+
+			// Global index of the submesh's SubmeshQuantisation, see MeshBufferManager
+			uint32_t quantisation_idx = 0;
+		};
+
+		// A mesh's ranges from its MeshDataAsset and where its data starts in MeshBufferManager's buffers (MeshEntryData)
+		struct MeshDrawSource {
+			std::span<const Submesh> submeshes;
+			std::span<const MeshLOD> lods;
+			std::span<const Meshlet> meshlets;
+
+			uint32_t data_start_indices_idx = 0;
+			uint32_t data_start_vertex_idx = 0;
+			uint32_t quantisation_start_idx = 0;
+		};
+
+		void Reset();
+
+		// Appends one instance of a submesh, merged into the previous command if it draws the same submesh
+		void AddDraw(const SubmeshDrawInfo& submesh, uint32_t transform_idx, uint32_t material_idx);
+
+		// Adds every visible item at its selected level of detail, items in each mesh range are reordered by (submesh, lod) so instances of a submesh level form one command
+		// Items culled per meshlet get their own commands covering only their visible meshlets
+		// 'meshes' is parallel to snapshot.mesh_ranges, entries of ranges without visible items aren't read
+		void AddVisibleItems(const struct SceneSnapshotData& snapshot, std::span<const MeshDrawSource> meshes, const std::vector<CullingSystem::DrawItem>& draw_items,
+			const CullingSystem::VisibleList& visible);
+
+		const std::vector<DrawIndexedCommand>& GetCommands() const {
+			return m_commands;
+		}
+
+		const std::vector<DrawInstanceData>& GetInstanceData() const {
+			return m_instance_data;
+		}
+
+	private:
+		std::vector<DrawIndexedCommand> m_commands;
+		std::vector<DrawInstanceData> m_instance_data;
+
+		// Reused between AddVisibleItems calls to sort range items by (submesh, lod)
+		std::vector<uint32_t> m_sorted_items;
+		std::vector<uint32_t> m_bucket_offsets;
+	};
+}
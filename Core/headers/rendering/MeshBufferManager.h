@@ -1,5 +1,10 @@
 #pragma once
 #include "resources/S_VkBuffer.h"
+#include "events/EventsCommon.h"
+#include "util/RangeAllocator.h"
+#include "rendering/UploadBatch.h"
+#include "assets/MeshData.h"
+#include "util/VertexEncoding.h"
 
 namespace SNAKE {
 	struct MeshEntryData {
@@ -8,47 +13,305 @@ namespace SNAKE {
 
 		uint32_t num_indices;
 		uint32_t num_vertices;
+
+		// First of the mesh's per-submesh SubmeshQuantisation entries
+		uint32_t quantisation_start_idx;
+		uint32_t num_submeshes;
+
+		// First of the mesh's Meshlets in the meshlet buffer, their index ranges are relative to data_start_indices_idx
+		uint32_t meshlet_start_idx;
+		uint32_t num_meshlets;
+
+		// MeshData::CalculateContentHash of the data, meshes with equal hashes have identical entries
+		uint64_t content_hash;
+	};
+
+	// Dispatched when defragmentation moves a mesh's data, anything that cached its MeshEntryData offsets must refresh them
+	struct MeshDataMovedEvent : public Event {
+		MeshDataMovedEvent(struct MeshDataAsset* _p_mesh_data) : p_mesh_data(_p_mesh_data) {}
+
+		MeshDataAsset* p_mesh_data;
+	};
+
+	// Dispatched once a mesh's data is allocated and its submeshes etc. are filled in, it can be drawn from then on
+	struct MeshDataLoadedEvent : public Event {
+		MeshDataLoadedEvent(struct MeshDataAsset* _p_mesh_data) : p_mesh_data(_p_mesh_data) {}
+
+		MeshDataAsset* p_mesh_data;
+	};
+
+	// Everything an upload derives from a MeshData, generating it is the expensive part of queueing an upload so it can be done on any thread
+	struct PreparedMeshUpload {
+		std::unique_ptr<MeshData> p_data;
+		std::vector<ExtraMath::AABB> submesh_aabbs;
+		OccluderMeshData occluder_mesh;
+		std::vector<CompactVertex> compact_vertices;
+		uint64_t content_hash = 0;
+	};
+
+	struct MeshBufferStats {
+		uint32_t num_meshes = 0;
+		uint32_t num_grows = 0;
+		uint32_t num_defrag_moves = 0;
+		uint32_t num_upload_batches = 0;
+
+		// Bytes copied by buffer resizes, stays linear in the data loaded as capacity doubles
+		uint64_t bytes_copied_on_grow = 0;
+
+		uint64_t bytes_staged = 0;
+
+		// Loaded meshes using the GPU data of an identical mesh instead of their own, and the bytes that saves
+		uint32_t num_shared_meshes = 0;
+		uint64_t bytes_shared = 0;
+
+		// Loaded meshes whose data was replaced
+		uint32_t num_reloads = 0;
 	};
 
+	/*
+	Owns the global vertex and index buffers every mesh is drawn from.
+	Meshes are sub-allocated from them with a RangeAllocator per buffer, buffers double in capacity when full.
+	Unloaded ranges are only reused once every frame in flight that could reference them has finished.
+	Vertices are stored in one of two formats, fixed at Init by use_compact_vertex_format:
+	float - separate position, normal, tex coord and tangent streams
+	compact - the float position stream plus an interleaved CompactVertex stream, quantised against its submesh's AABB, every pass decodes the rest from it
+	Positions stay as floats in both as they're the input for BLAS builds, raytracing and the depth-only passes.
+	Meshlet bounds are uploaded to a storage buffer for GPU-side cluster culling, the CPU culls with the copies kept on MeshDataAsset.
+	Uploads queued with QueueMeshUpload are staged together and submitted as one UploadBatch on frame start, without waiting on it.
+	Meshes are content-addressed, a mesh whose data hashes equal to a loaded one shares its ranges and BLAS, which are released when the last user unloads.
+	*/
 	class MeshBufferManager {
 	public:
 		void Init();
 
-		void LoadMeshFromData(struct MeshDataAsset* p_mesh_data_asset, struct MeshData& data);
+		// Allocates and submits the mesh's copies immediately without waiting on them, it can be drawn from once this returns
+		// MeshDataLoadedEvent is dispatched on the first frame start after the copies have completed
+		void LoadMeshFromData(MeshDataAsset* p_mesh_data_asset, MeshData& data);
+
+		// Thread-safe, the mesh is uploaded in the batch submitted on the next frame start
+		// The asset must not be drawn until IsMeshLoaded returns true
+		void QueueMeshUpload(MeshDataAsset* p_mesh_data_asset, std::unique_ptr<MeshData> p_data);
+		void QueueMeshUpload(MeshDataAsset* p_mesh_data_asset, PreparedMeshUpload&& upload);
+
+		// Thread-safe, replaces the data of a loaded mesh in the batch submitted on the next frame start, then dispatches MeshDataLoadedEvent again
+		// The new data is allocated fresh ranges and MeshDataMovedEvent is dispatched too, the old ranges are released once frames in flight are done with them
+		// Same as QueueMeshUpload if the mesh isn't loaded, no effect if its content hash is unchanged
+		void QueueMeshReload(MeshDataAsset* p_mesh_data_asset, PreparedMeshUpload&& upload);
+
+		// Thread-safe, only reads the vertex format which is fixed after Init
+		PreparedMeshUpload PrepareMeshUpload(std::unique_ptr<MeshData> p_data) const;
 
+		// Bytes StageMesh will copy for the upload
+		uint64_t GetUploadSize(const PreparedMeshUpload& upload) const;
+
+		// Replaces the asset's materials with the ones with these UUIDs, any that don't exist are replaced with the default material
+		static void ResolveMaterials(MeshDataAsset* p_mesh_data_asset, const std::vector<uint64_t>& material_uuids);
+
+		bool IsMeshLoaded(MeshDataAsset* p_mesh_data_asset) const;
+
+		// Called automatically when a MeshDataAsset is destroyed
 		void UnloadMesh(MeshDataAsset* p_mesh_data_asset);
 
+		// Moves up to 'max_moves' ranges from the end of the buffers into free ranges nearer the start, patching their MeshEntryData
+		// The copies are submitted to the UploadEngine without waiting, nothing is moved while uploads or a previous pass's copies are in flight
+		// Runs on frame start if defragmentation_enabled is true
+		void Defragment(uint32_t max_moves);
+
+		// Frees every pending unloaded range and BLAS immediately, the device must be idle
+		void ReleasePendingNow();
+
 		const MeshEntryData& GetEntryData(MeshDataAsset* p_mesh_data_asset) const {
 			SNK_ASSERT(m_entries.contains(p_mesh_data_asset));
 			return m_entries.at(p_mesh_data_asset);
 		}
 
 		struct MeshBuffers {
-			MeshBuffers(S_VkBuffer& pos_buf, S_VkBuffer& norm_buf, S_VkBuffer& tan_buf, S_VkBuffer& tex_buf, S_VkBuffer& idx_buf) :
-				position_buf(pos_buf), normal_buf(norm_buf), tangent_buf(tan_buf), tex_coord_buf(tex_buf), indices_buf(idx_buf) {}
+			MeshBuffers(S_VkBuffer& pos_buf, S_VkBuffer& norm_buf, S_VkBuffer& tan_buf, S_VkBuffer& tex_buf, S_VkBuffer& idx_buf, S_VkBuffer& compact_buf, S_VkBuffer& quant_buf,
+				S_VkBuffer& _meshlet_buf) :
+				position_buf(pos_buf), normal_buf(norm_buf), tangent_buf(tan_buf), tex_coord_buf(tex_buf), indices_buf(idx_buf), compact_vertex_buf(compact_buf), quantisation_buf(quant_buf),
+				meshlet_buf(_meshlet_buf) {}
 
 			S_VkBuffer& position_buf;
+
+			// Float format only, never created in compact mode
 			S_VkBuffer& normal_buf;
 			S_VkBuffer& tangent_buf;
 			S_VkBuffer& tex_coord_buf;
+
 			S_VkBuffer& indices_buf;
+
+			// CompactVertex stream, compact format only, same vertex offsets as the position stream
+			S_VkBuffer& compact_vertex_buf;
+
+			// SubmeshQuantisation array indexed with MeshEntryData::quantisation_start_idx + submesh index
+			S_VkBuffer& quantisation_buf;
+
+			// Meshlet array indexed with MeshEntryData::meshlet_start_idx + meshlet index
+			S_VkBuffer& meshlet_buf;
 		};
 
 		MeshBuffers GetMeshBuffers() {
-			return { m_position_buf, m_normal_buf , m_tangent_buf , m_tex_coord_buf , m_index_buf };
+			return { m_position_buf, m_normal_buf , m_tangent_buf , m_tex_coord_buf , m_index_buf, m_compact_vertex_buf, m_quantisation_buf, m_meshlet_buf };
+		}
+
+		const RangeAllocator& GetVertexAllocator() const {
+			return m_vertex_allocator;
+		}
+
+		const RangeAllocator& GetIndexAllocator() const {
+			return m_index_allocator;
+		}
+
+		const MeshBufferStats& GetStats() const {
+			return m_stats;
+		}
+
+		// Format vertices are stored in from Init on
+		bool UsesCompactVertexFormat() const {
+			return m_compact_vertex_format;
+		}
+
+		// Bytes of buffer memory a vertex takes in the format in use
+		uint32_t GetStoredVertexSize() const {
+			return m_compact_vertex_format ? COMPACT_STORED_VERTEX_SIZE : FLOAT_VERTEX_SIZE;
 		}
 
+		bool defragmentation_enabled = true;
+
+		// Store vertices in the compact format, only read by Init so it must be set before AssetManager::Init
+		bool use_compact_vertex_format = false;
+
+		// Bytes a vertex shader fetches per vertex in each format
+		inline static constexpr uint32_t FLOAT_VERTEX_SIZE = sizeof(aiVector3D) * 3 + sizeof(aiVector2D);
+		inline static constexpr uint32_t COMPACT_VERTEX_SIZE = sizeof(CompactVertex);
+
+		// The compact format keeps the float position stream alongside the CompactVertex stream
+		inline static constexpr uint32_t COMPACT_STORED_VERTEX_SIZE = sizeof(aiVector3D) + sizeof(CompactVertex);
+
+		// Capacities in vertices/indices the buffers are created with
+		inline static constexpr uint32_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+		inline static constexpr uint32_t INITIAL_INDEX_CAPACITY = 1 << 18;
+		inline static constexpr uint32_t INITIAL_SUBMESH_CAPACITY = 1 << 12;
+		inline static constexpr uint32_t INITIAL_MESHLET_CAPACITY = 1 << 14;
+
+		inline static constexpr uint32_t DEFRAG_MOVES_PER_FRAME = 4;
+
 	private:
-		uint32_t m_total_vertices = 0;
-		uint32_t m_total_indices = 0;
+		// Copies everything but the GPU data from 'data' into the asset, resolves its materials and indexes its content hash
+		void PrepareMeshAsset(MeshDataAsset* p_mesh_data_asset, const MeshData& data, std::vector<ExtraMath::AABB>&& submesh_aabbs, OccluderMeshData&& occluder_mesh,
+			uint64_t content_hash);
+
+		// Builds BLAS and allocates vertex/index ranges, growing buffers if needed
+		// Returns false if the mesh shares the data of a loaded mesh with the same content hash instead, it then needs no copies staged
+		bool AllocateMesh(MeshDataAsset* p_mesh_data_asset, MeshData& data, uint64_t content_hash);
+
+		// Builds a BLAS for every submesh of the asset, which must already be prepared from 'data'
+		static void BuildSubmeshBLAS(MeshDataAsset* p_mesh_data_asset, MeshData& data);
+
+		// Drops the asset's entry, releasing its ranges and BLAS once frames in flight are done with them unless another mesh shares them
+		void ReleaseMeshData(MeshDataAsset* p_mesh_data_asset);
+
+		// Adds copies of every vertex stream and the indices into the ranges allocated by AllocateMesh
+		void StageMesh(UploadBatch& batch, MeshDataAsset* p_mesh_data_asset, const MeshData& data, const std::vector<CompactVertex>& compact_vertices);
+
+		// Bytes of every buffer range an entry uses
+		uint64_t GetGPUSize(const MeshEntryData& entry) const;
+
+		// Every vertex stream created for the format in use, with the size of its elements
+		std::vector<std::pair<S_VkBuffer*, uint32_t>> GetVertexStreams();
+
+		static std::vector<CompactVertex> EncodeCompactVertices(const MeshData& data, const std::vector<ExtraMath::AABB>& submesh_aabbs);
+
+		void FlushQueuedUploads();
+
+		// Frees completed batches and dispatches MeshDataLoadedEvent for LoadMeshFromData meshes whose copies have completed
+		void PollInFlightBatches();
+
+		// Waits for every upload and defragmentation copy in flight, growing recreates the buffers they write
+		void WaitForBufferCopies();
+
+		// Grow to at least min_capacity, doubling the current capacity if that is larger
+		void GrowVertexBuffers(uint32_t min_capacity);
+		void GrowIndexBuffer(uint32_t min_capacity);
+		void GrowQuantisationBuffer(uint32_t min_capacity);
+		void GrowMeshletBuffer(uint32_t min_capacity);
+
+		void ProcessPendingReleases();
+
+		struct PendingRelease {
+			uint32_t vertex_offset = 0;
+			uint32_t num_vertices = 0;
+			uint32_t index_offset = 0;
+			uint32_t num_indices = 0;
+			uint32_t quantisation_offset = 0;
+			uint32_t num_submeshes = 0;
+			uint32_t meshlet_offset = 0;
+			uint32_t num_meshlets = 0;
+			std::vector<class BLAS*> blas_array;
+
+			// Frame starts left until no frame in flight can reference the data
+			uint32_t frames_remaining = MAX_FRAMES_IN_FLIGHT;
+
+			// Defragmentation copies reading the ranges, they aren't reused until it's complete
+			UploadTicket ticket;
+		};
+
+		std::vector<PendingRelease> m_pending_releases;
+
+		struct QueuedUpload {
+			MeshDataAsset* p_mesh_data_asset = nullptr;
+			PreparedMeshUpload upload;
+
+			// Queued with QueueMeshReload, the mesh may already be loaded
+			bool reload = false;
+		};
+
+		std::mutex m_queued_uploads_mux;
+		std::vector<QueuedUpload> m_queued_uploads;
+
+		// Submitted batches are kept alive until their fence signals
+		std::vector<std::unique_ptr<UploadBatch>> m_in_flight_batches;
+
+		// Meshes loaded with LoadMeshFromData, MeshDataLoadedEvent is dispatched for them once their ticket completes
+		struct PendingLoadedEvent {
+			MeshDataAsset* p_mesh_data_asset = nullptr;
+			UploadTicket ticket;
+		};
+
+		std::vector<PendingLoadedEvent> m_pending_loaded_events;
 
 		std::unordered_map<MeshDataAsset*, MeshEntryData> m_entries;
 
+		// Content hash -> every loaded mesh sharing the ranges stored for it
+		std::unordered_map<uint64_t, std::vector<MeshDataAsset*>> m_shared_data;
+
+		RangeAllocator m_vertex_allocator;
+		RangeAllocator m_index_allocator;
+		RangeAllocator m_quantisation_allocator;
+		RangeAllocator m_meshlet_allocator;
+
+		MeshBufferStats m_stats;
+
+		bool m_compact_vertex_format = false;
+
+		// (capacity, used, free ranges) of each allocator the last time Defragment found nothing it could move
+		std::tuple<uint32_t, uint32_t, uint32_t> m_defrag_stalled_vertex_state{};
+		std::tuple<uint32_t, uint32_t, uint32_t> m_defrag_stalled_index_state{};
+
+		// Copies of the last Defragment pass
+		UploadTicket m_defrag_ticket;
+
 		S_VkBuffer m_position_buf;
 		S_VkBuffer m_normal_buf;
 		S_VkBuffer m_tex_coord_buf;
 		S_VkBuffer m_tangent_buf;
 		S_VkBuffer m_index_buf;
+		S_VkBuffer m_compact_vertex_buf;
+		S_VkBuffer m_quantisation_buf;
+		S_VkBuffer m_meshlet_buf;
+
+		EventListener m_asset_event_listener;
+		EventListener m_frame_start_listener;
 	};
 
-}
\ No newline at end of file
+}
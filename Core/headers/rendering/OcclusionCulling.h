@@ -0,0 +1,85 @@
+#pragma once
+#include "rendering/FrustumCulling.h"
+
+namespace SNAKE {
+	/*
+	Low resolution software depth buffer that occluder triangles are rasterised into, followed by a max-depth (Hi-Z) pyramid
+	that bounding boxes are conservatively tested against. Depth uses the 0-1 range with 0 being nearest, cleared to 1.
+	Everything runs on the CPU so it can be used from jobs without touching the GPU.
+	*/
+	class OcclusionBuffer {
+	public:
+		// Width is rounded up to a multiple of 4 so rows can be rasterised four pixels at a time
+		void Init(uint32_t width, uint32_t height);
+
+		// Clears depth and any triangles queued by AddOccluder
+		void Clear();
+
+		// Transforms triangles into screen space with 'proj_view_model' and queues them for Rasterize
+		// Triangles crossing the near plane are dropped, which can only make the buffer less occluding
+		void AddOccluder(const glm::mat4& proj_view_model, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+
+		// Rasterises queued triangles with rows split between JobSystem jobs, then builds the Hi-Z pyramid
+		void Rasterize();
+
+		// Returns false only if the box is fully behind occluder depth
+		bool IsVisible(const glm::mat4& proj_view, const glm::vec3& center, const glm::vec3& extents) const;
+
+		// Appends the indices in 'in' (bounds indices) that pass IsVisible to 'out', preserving order
+		void TestVisible(const CullingBoundsSoA& bounds, const glm::mat4& proj_view, const std::vector<uint32_t>& in, std::vector<uint32_t>& out) const;
+
+		uint32_t GetWidth() const {
+			return m_width;
+		}
+
+		uint32_t GetHeight() const {
+			return m_height;
+		}
+
+		uint32_t GetNumTriangles() const {
+			return (uint32_t)m_triangles.size();
+		}
+
+		// Full resolution depth, row-major
+		const std::vector<float>& GetDepth() const {
+			return m_hiz[0];
+		}
+
+		// Level 0 is GetDepth(), the last level is 1x1
+		uint32_t GetNumLevels() const {
+			return (uint32_t)m_hiz.size();
+		}
+
+		const std::vector<float>& GetLevel(uint32_t level) const {
+			return m_hiz[level];
+		}
+
+		glm::uvec2 GetLevelSize(uint32_t level) const {
+			return m_level_sizes[level];
+		}
+
+		// Rows rasterised by a single job in Rasterize
+		inline static constexpr uint32_t JOB_ROW_COUNT = 16;
+
+	private:
+		struct ScreenTriangle {
+			// xy = pixels, z = depth, counter-clockwise in pixel space
+			glm::vec3 v[3];
+			float min_y;
+			float max_y;
+		};
+
+		void RasterizeRows(uint32_t row_begin, uint32_t row_end);
+
+		void BuildHiZ();
+
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+
+		std::vector<ScreenTriangle> m_triangles;
+
+		// Level 0 is the depth buffer, each further level stores the max depth of a 2x2 region of the previous one
+		std::vector<std::vector<float>> m_hiz;
+		std::vector<glm::uvec2> m_level_sizes;
+	};
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "resources/S_VkBuffer.h"
+#include "core/UploadEngine.h"
+
+namespace SNAKE {
+	/*
+	Packs any number of buffer and image uploads into mapped staging buffers and submits every copy in a single UploadEngine submission.
+	Data is copied once, straight into the staging memory, staging buffers are allocated as the batch grows starting from 'staging_size_hint'.
+	Anything submitted to the graphics queue after Submit sees the uploaded data without waiting on the ticket.
+	Buffers written while in use on the graphics queue must be created with transfer_queue_shared, images get ownership transfers.
+	Destroying a submitted batch waits for it, keep batches alive until IsComplete rather than blocking on them.
+	*/
+	class UploadBatch {
+	public:
+		// The first staging buffer is at least staging_size_hint bytes, pass the total if it's known so one buffer holds everything
+		explicit UploadBatch(vk::DeviceSize staging_size_hint = 0) : m_staging_size_hint(staging_size_hint) {}
+		UploadBatch(const UploadBatch& other) = delete;
+		UploadBatch& operator=(const UploadBatch& other) = delete;
+
+		~UploadBatch();
+
+		// Copies 'size' bytes from p_data into the batch, written to 'dst' at 'dst_offset' once submitted
+		void AddBufferCopy(vk::Buffer dst, vk::DeviceSize dst_offset, const void* p_data, vk::DeviceSize size);
+
+		// Copies tightly packed texel data into one mip level of a 2D colour image
+		// Existing contents of every mip level of the image are discarded, all levels are left in 'final_layout'
+		void AddImageCopy(vk::Image dst, uint32_t mip_level, uint32_t width, uint32_t height, const void* p_data, vk::DeviceSize size, vk::ImageLayout final_layout);
+
+		// Uploads the staged data and submits every copy, doesn't wait for them to complete
+		void Submit();
+
+		// True once a submitted batch has finished executing on the GPU, the batch can then be destroyed
+		bool IsComplete() const;
+
+		// Blocks until the submitted copies have finished
+		void Wait() const;
+
+		bool IsEmpty() const {
+			return m_copies.empty() && m_image_copies.empty();
+		}
+
+		bool IsSubmitted() const {
+			return m_submitted;
+		}
+
+		UploadTicket GetTicket() const {
+			return m_ticket;
+		}
+
+		vk::DeviceSize GetStagedSize() const {
+			return m_staged_size;
+		}
+
+		uint32_t GetNumCopies() const {
+			return (uint32_t)(m_copies.size() + m_image_copies.size());
+		}
+
+	private:
+		struct StagingLocation {
+			vk::Buffer buffer;
+			vk::DeviceSize offset;
+		};
+
+		// Copies data into the mapped staging buffer with space for it, allocating another if none has
+		StagingLocation Stage(const void* p_data, vk::DeviceSize size);
+
+		void RecordCopies(vk::CommandBuffer cmd);
+
+		// Records either the release (transfer queue) or acquire (graphics queue) half of the image ownership transfers
+		// Without a dedicated transfer queue this is just the layout transition
+		void RecordImageFinalBarriers(vk::CommandBuffer cmd, bool acquire);
+
+		struct Copy {
+			vk::Buffer src;
+			vk::Buffer dst;
+			vk::BufferCopy region;
+		};
+
+		struct ImageCopy {
+			vk::Buffer src;
+			vk::Image dst;
+			vk::BufferImageCopy region;
+			vk::ImageLayout final_layout;
+		};
+
+		struct StagingBuffer {
+			// Heap allocated as S_VkBuffer can't be moved once mapped
+			std::unique_ptr<S_VkBuffer> p_buf;
+			std::byte* p_mapped = nullptr;
+			vk::DeviceSize size = 0;
+			vk::DeviceSize used = 0;
+		};
+
+		// Smallest staging buffer allocated, each new one is at least twice the size of the last
+		inline static constexpr vk::DeviceSize MIN_STAGING_BUFFER_SIZE = 64 * 1024;
+
+		vk::DeviceSize m_staging_size_hint = 0;
+		vk::DeviceSize m_staged_size = 0;
+		std::vector<StagingBuffer> m_staging_buffers;
+
+		std::vector<Copy> m_copies;
+		std::vector<ImageCopy> m_image_copies;
+
+		UploadTicket m_ticket;
+		bool m_submitted = false;
+	};
+}
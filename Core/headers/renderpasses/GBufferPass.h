@@ -4,6 +4,7 @@
 #include "core/Pipelines.h"
 #include "core/VkCommands.h"
 #include "rendering/RenderCommon.h"
+#include "rendering/IndirectDrawBuffers.h"
 #include "scene/Scene.h"
 
 
@@ -12,7 +13,8 @@ namespace SNAKE {
 	class GBufferPass {
 	public:
 		struct GBufferPC {
-			uint32_t transform_idx;
+			// Particles only, the particle mesh's SubmeshQuantisation when drawing compact vertices
+			uint32_t quantisation_idx;
 			uint32_t material_idx;
 			glm::uvec2 render_resolution;
 			glm::vec2 jitter_offset;
@@ -25,9 +27,14 @@ namespace SNAKE {
 		// output_size - The size of the final colour output image produced in the pipeline (if DLSS is enabled this is different from the size of the gbuffer resources)
 		void RecordCommandBuffer(GBufferResources& output, Scene& scene, glm::uvec2 output_size, vk::CommandBuffer buf);
 	private:
+		// Both read the vertex format MeshBufferManager was initialised with
 		GraphicsPipeline m_mesh_pipeline;
 		GraphicsPipeline m_particle_pipeline;
 
 		std::array<DescriptorBuffer, MAX_FRAMES_IN_FLIGHT> m_descriptor_buffers;
+
+		IndirectDrawBuilder m_draw_builder;
+		IndirectDrawBuffers m_draw_buffers;
+		std::vector<IndirectDrawBuilder::MeshDrawSource> m_mesh_sources;
 	};
 }
\ No newline at end of file
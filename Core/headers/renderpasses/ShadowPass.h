@@ -6,6 +6,8 @@
 #include "core/VkCommon.h"
 #include "rendering/RenderCommon.h"
 #include "resources/Images.h"
+#include "core/DescriptorBuffer.h"
+#include "rendering/IndirectDrawBuffers.h"
 
 namespace SNAKE {
 	struct RenderableComponent : Component {
@@ -13,7 +15,7 @@ namespace SNAKE {
 	};
 	class ShadowPass {
 	public:
-		void Init();
+		void Init(class Scene& scene);
 
 		void RecordCommandBuffers(class Scene& scene, const struct SceneSnapshotData& data);
 
@@ -24,5 +26,12 @@ namespace SNAKE {
 		std::array<CommandBuffer, MAX_FRAMES_IN_FLIGHT> m_cmd_buffers;
 
 		GraphicsPipeline m_pipeline;
+
+		// Set 0, transforms and the instance data written by m_draw_builder
+		std::array<DescriptorBuffer, MAX_FRAMES_IN_FLIGHT> m_descriptor_buffers;
+
+		IndirectDrawBuilder m_draw_builder;
+		IndirectDrawBuffers m_draw_buffers;
+		std::vector<IndirectDrawBuilder::MeshDrawSource> m_mesh_sources;
 	};
 }
\ No newline at end of file
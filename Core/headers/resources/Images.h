@@ -53,7 +53,12 @@ namespace SNAKE {
 
 		void DestroyImage();
 
-		void GenerateMipmaps(vk::ImageLayout start_layout);
+		// Exchanges the image, its view, sampler and spec with 'other', both must own their images
+		// Lets an image that may still be in use be replaced without moving the object holding it
+		void Swap(Image2D& other);
+
+		// Records into buf if provided, otherwise submits and waits on a single time command buffer
+		void GenerateMipmaps(vk::ImageLayout start_layout, vk::CommandBuffer buf = {});
 
 		void RefreshDescriptorGetInfo(DescriptorGetInfo& info) const override;
 
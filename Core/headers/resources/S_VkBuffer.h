@@ -28,7 +28,9 @@ namespace SNAKE {
 			DispatchResourceEvent(S_VkResourceEvent::ResourceEventType::DELETE);
 		}
 
-		void CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags flags = 0);
+		// transfer_queue_shared: buffer is written by the dedicated transfer queue (if one exists) while in use on the graphics queue,
+		// created with concurrent sharing so no ownership transfers are needed
+		void CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags flags = 0, bool transfer_queue_shared = false);
 		
 		void Resize(size_t new_size);
 
@@ -68,6 +70,7 @@ namespace SNAKE {
 	private:
 		vk::BufferUsageFlags m_usage = vk::BufferUsageFlagBits(0);
 		VmaAllocationCreateFlags m_alloc_create_flags = 0;
+		bool m_transfer_queue_shared = false;
 		// Mapped ptr, nullptr if not mapped
 		void* p_data = nullptr;
 	};
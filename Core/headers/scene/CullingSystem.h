@@ -0,0 +1,197 @@
+#pragma once
+#include "System.h"
+#include "events/EventManager.h"
+#include "rendering/FrustumCulling.h"
+#include "rendering/OcclusionCulling.h"
+
+namespace SNAKE {
+	/*
+	Frustum culls every (instance, submesh) pair in the scene snapshot on frame start, producing a visible list per view.
+	Instances flagged as occluders are then rasterised into a software depth buffer per view and the frustum visible items are tested against it.
+	The occlusion stage runs as a job alongside the update job, GetVisibleList waits for it to finish.
+	Each visible item is then assigned the coarsest level of detail whose simplification error projects below lod_screen_error in that view.
+	Full detail items with enough meshlets are finally culled per meshlet, against the frustum and, for the camera, with the meshlet's backface cone.
+	The textures of items in the camera's frustum are requested from TextureResidencyManager at the mip their projected size needs.
+	Must be added after SceneSnapshotSystem so it sees the snapshot for the current frame.
+	*/
+	class CullingSystem : public System {
+	public:
+		enum class CullView : uint8_t {
+			CAMERA,
+			DIR_LIGHT,
+			COUNT
+		};
+
+		struct DrawItem {
+			// Index into SceneSnapshotData::static_mesh_data
+			uint32_t instance_idx;
+			uint32_t submesh_idx;
+		};
+
+		struct VisibleList {
+			// Ascending indices into GetDrawItems()
+			std::vector<uint32_t> items;
+
+			// items[range_starts[r]] to items[range_starts[r + 1]] belong to SceneSnapshotData::mesh_ranges[r]
+			std::vector<uint32_t> range_starts;
+
+			// Level of detail of each item, parallel to items. 0 is full detail, n uses MeshDataAsset::lods[n - 1]
+			std::vector<uint8_t> lods;
+
+			struct MeshletRange {
+				uint32_t start;
+				uint32_t count;
+			};
+
+			// Visible meshlets of each item, parallel to items, meshlets[start] to meshlets[start + count] are indices into MeshDataAsset::meshlets
+			// Items that weren't culled per meshlet have start == WHOLE_ITEM and are drawn whole
+			std::vector<MeshletRange> meshlet_ranges;
+			std::vector<uint32_t> meshlets;
+
+			inline static constexpr uint32_t WHOLE_ITEM = std::numeric_limits<uint32_t>::max();
+		};
+
+		struct CullingStats {
+			uint32_t num_tested = 0;
+			std::array<uint32_t, (size_t)CullView::COUNT> num_visible{};
+			std::array<uint32_t, (size_t)CullView::COUNT> num_occluded{};
+			std::array<uint32_t, (size_t)CullView::COUNT> num_simplified{};
+			std::array<uint32_t, (size_t)CullView::COUNT> num_meshlets_tested{};
+			std::array<uint32_t, (size_t)CullView::COUNT> num_meshlets_culled{};
+			std::array<uint32_t, (size_t)CullView::COUNT> num_meshlet_triangles_culled{};
+			uint32_t num_occluder_triangles = 0;
+			float bounds_update_ms = 0.f;
+			float cull_ms = 0.f;
+			float occlusion_ms = 0.f;
+		};
+
+		void OnSystemAdd() override;
+
+		void OnSystemRemove() override;
+
+		const std::vector<DrawItem>& GetDrawItems() const {
+			return m_draw_items;
+		}
+
+		// Blocks until this frame's occlusion job has finished
+		const VisibleList& GetVisibleList(CullView view) {
+			WaitForOcclusion();
+			return m_visible_lists[(size_t)view];
+		}
+
+		// Blocks until this frame's occlusion job has finished
+		const CullingStats& GetStats() {
+			WaitForOcclusion();
+			return m_stats;
+		}
+
+		const OcclusionBuffer& GetOcclusionBuffer(CullView view) {
+			WaitForOcclusion();
+			return m_occlusion_buffers[(size_t)view];
+		}
+
+		// If false every draw item is reported as visible
+		bool enabled = true;
+
+		// If false only frustum culling is performed
+		bool occlusion_enabled = true;
+
+		// If false every item is drawn at full detail
+		bool lod_selection_enabled = true;
+
+		// Largest simplification error allowed on screen, as a fraction of the view's height (0.001 is ~1 pixel at 1080p)
+		float lod_screen_error = 0.001f;
+
+		// If false visible items are always drawn whole
+		bool meshlet_culling_enabled = true;
+
+		// If false streamed textures are never requested beyond their mip tail
+		bool texture_streaming_requests = true;
+
+		// Submeshes with fewer meshlets are drawn whole, splitting their draws would cost more than the triangles saved
+		inline static constexpr uint32_t MIN_MESHLETS_FOR_CULLING = 8;
+
+		// Resolution of the software depth buffer for each view
+		inline static constexpr glm::uvec2 CAMERA_OCCLUSION_RES{ 320, 180 };
+		inline static constexpr glm::uvec2 DIR_LIGHT_OCCLUSION_RES{ 256, 256 };
+
+	private:
+		void RebuildDrawItems(const struct SceneSnapshotData& snapshot);
+
+		void UpdateBounds(const SceneSnapshotData& snapshot);
+
+		void Cull();
+
+		void UpdateViewMatrices();
+
+		std::vector<FrustumPlanes> GetViewPlanes() const;
+
+		void ComputeRangeStarts(VisibleList& list) const;
+
+		// Fills list.lods for the view, list.range_starts must be up to date
+		void SelectLODs(CullView view, VisibleList& list);
+
+		// Fills list.meshlet_ranges and list.meshlets for the view, list.lods must be up to date
+		void CullMeshlets(CullView view, VisibleList& list);
+
+		void DispatchOcclusionJob(const SceneSnapshotData& snapshot);
+
+		// Requests the textures of every item in the camera's frustum at the mip their projected bounding sphere covers, runs before occlusion culling
+		// UV tiling isn't known, a texture is assumed to be stretched once across the item
+		void RequestTextureMips(const SceneSnapshotData& snapshot);
+
+		void WaitForOcclusion() const {
+			while (!m_occlusion_ready.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+		}
+
+		std::vector<DrawItem> m_draw_items;
+
+		// Index of the first draw item of each snapshot mesh range, with a trailing end index
+		std::vector<uint32_t> m_range_item_starts;
+
+		// Mesh data of each snapshot mesh range, resolved in UpdateBounds
+		std::vector<const struct MeshDataAsset*> m_range_meshes;
+
+		// Largest axis scale of each snapshot instance's transform, scales mesh LOD errors into world space
+		std::vector<float> m_instance_scales;
+
+		// Transform of each snapshot instance, captured on frame start for meshlet culling
+		std::vector<glm::mat4> m_instance_transforms;
+
+		// World-space camera position, only valid if m_view_valid is true for CullView::CAMERA
+		glm::vec3 m_camera_position{ 0 };
+
+		uint64_t m_snapshot_version = std::numeric_limits<uint64_t>::max();
+
+		CullingBoundsSoA m_bounds;
+
+		std::array<VisibleList, (size_t)CullView::COUNT> m_visible_lists;
+		std::vector<std::vector<uint32_t>> m_cull_output;
+
+		CullingStats m_stats;
+
+		// Projection-view matrix of each view, only valid if m_view_valid is true
+		std::array<glm::mat4, (size_t)CullView::COUNT> m_view_matrices;
+		std::array<bool, (size_t)CullView::COUNT> m_view_valid{};
+
+		struct OccluderInstance {
+			uint32_t instance_idx;
+			const struct OccluderMeshData* p_mesh;
+
+			// Captured on frame start so the occlusion job never reads transforms the update job is writing
+			glm::mat4 transform;
+		};
+
+		std::vector<OccluderInstance> m_occluders;
+		std::array<OcclusionBuffer, (size_t)CullView::COUNT> m_occlusion_buffers;
+		std::atomic_bool m_occlusion_ready = true;
+
+		// Swapchain height, converts projected sizes to pixels for texture requests
+		float m_view_height = 1080.f;
+
+		EventListener m_frame_start_listener;
+		EventListener m_swapchain_invalidate_listener;
+	};
+}
@@ -10,6 +10,9 @@ namespace SNAKE {
 
 		void UpdateLightSSBO();
 
+		// Projection-view matrix the directional light shadow map is rendered with
+		glm::mat4 GetDirLightTransform() const;
+
 		std::array<DescriptorBuffer, MAX_FRAMES_IN_FLIGHT> light_descriptor_buffers;
 		std::array<S_VkBuffer, MAX_FRAMES_IN_FLIGHT> light_ssbos;
 	private:
@@ -49,6 +49,7 @@ namespace SNAKE {
 
 		EventListener m_mesh_event_listener;
 		EventListener m_transform_event_listener;
+		EventListener m_mesh_data_moved_listener;
 		EventListener m_frame_start_event_listener;
 	};
 
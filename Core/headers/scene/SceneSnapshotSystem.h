@@ -2,31 +2,51 @@
 #include "System.h"
 #include "events/EventManager.h"
 #include "assets/MaterialAsset.h"
+#include "assets/MeshData.h"
+#include "assets/AssetHandle.h"
 
 namespace SNAKE {
 	struct SceneSnapshotData {
+		// A group of instances sharing the same mesh and the same set of materials
 		struct MeshRange {
-			MeshRange(uint64_t uuid, uint32_t _start_idx, uint32_t _count) : mesh_uuid(uuid), start_idx(_start_idx), count(_count) {};
-			uint64_t mesh_uuid;
+			MeshRange(AssetHandle<StaticMeshAsset> _mesh, uint32_t _start_idx, uint32_t _count, uint32_t _material_start_idx) :
+				mesh(_mesh), start_idx(_start_idx), count(_count), material_start_idx(_material_start_idx) {};
+
+			AssetHandle<StaticMeshAsset> mesh;
 			uint32_t start_idx;
 			uint32_t count;
+
+			// Start of this ranges material set in material_indices and materials, index with Submesh::material_index
+			uint32_t material_start_idx;
 		};
 
 		struct MeshRenderData {
-			MeshRenderData(const std::vector<AssetRef<MaterialAsset>>& m, uint32_t _transform_buffer_idx) : material_vec(m), transform_buffer_idx(_transform_buffer_idx) {}
-			// A copy of material pointers for this mesh
-			std::vector<AssetRef<MaterialAsset>> material_vec;
+			MeshRenderData(uint32_t _transform_buffer_idx, class Entity* _entity) : transform_buffer_idx(_transform_buffer_idx), p_entity(_entity) {}
 			uint32_t transform_buffer_idx;
+			Entity* p_entity;
 		};
 
 		void Reset() {
 			size_t prev_range_size = mesh_ranges.size();
 			size_t prev_sm_size = static_mesh_data.size();
+			size_t prev_mat_size = material_indices.size();
 
 			mesh_ranges.clear();
 			mesh_ranges.reserve(prev_range_size);
 			static_mesh_data.clear();
 			static_mesh_data.reserve(prev_sm_size);
+			material_indices.clear();
+			material_indices.reserve(prev_mat_size);
+			materials.clear();
+			materials.reserve(prev_mat_size);
+		}
+
+		uint32_t GetMaterialIdx(const MeshRange& range, uint32_t material_index) const {
+			return material_indices[range.material_start_idx + material_index];
+		}
+
+		AssetHandle<MaterialAsset> GetMaterial(const MeshRange& range, uint32_t material_index) const {
+			return materials[range.material_start_idx + material_index];
 		}
 
 		std::vector<MeshRange> mesh_ranges;
@@ -34,20 +54,80 @@ namespace SNAKE {
 		// Vector sorted into groups of transforms for each mesh
 		std::vector<MeshRenderData> static_mesh_data;
 
+		// Global material buffer indices (GlobalMaterialBufferManager) for each range's material set
+		std::vector<uint32_t> material_indices;
+
+		// Parallel to material_indices, for CPU-side use of the materials
+		std::vector<AssetHandle<MaterialAsset>> materials;
+
+		// Incremented every time the snapshot is rebuilt, lets consumers cache data derived from the ranges
+		uint64_t version = 0;
 	};
 
+	/*
+	Maintains a persistent draw list grouped by (mesh, material set), updated only from StaticMeshComponent events.
+	The flat SceneSnapshotData is only rebuilt on frame start if the draw list changed, no sorting or asset refcounting happens per frame.
+	*/
 	class SceneSnapshotSystem : public System {
 	public:
 		void OnSystemAdd() override;
 
+		void OnSystemRemove() override;
+
 		const SceneSnapshotData& GetSnapshotData() const {
 			return m_snapshot_data;
 		}
 	private:
+		struct BatchKey {
+			AssetHandle<StaticMeshAsset> mesh;
+			std::vector<uint32_t> material_indices;
+
+			bool operator==(const BatchKey& other) const = default;
+		};
+
+		struct BatchKeyHasher {
+			size_t operator()(const BatchKey& key) const {
+				size_t seed = std::hash<uint32_t>()(key.mesh.value);
+				for (auto idx : key.material_indices) {
+					seed ^= std::hash<uint32_t>()(idx) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+				}
+				return seed;
+			}
+		};
+
+		struct DrawBatch {
+			BatchKey key;
+
+			// Materials of key.material_indices
+			std::vector<AssetHandle<MaterialAsset>> materials;
+
+			// Parallel arrays, instances are swap-removed
+			std::vector<uint32_t> transform_indices;
+			std::vector<class Entity*> entities;
+		};
+
+		struct InstanceLocation {
+			uint32_t batch_idx;
+			uint32_t slot;
+		};
+
+		void AddInstance(class StaticMeshComponent* p_mesh);
+
+		void RemoveInstance(Entity* p_entity);
+
 		void TakeSceneSnapshot();
 
+		std::vector<DrawBatch> m_batches;
+		std::unordered_map<BatchKey, uint32_t, BatchKeyHasher> m_batch_lookup;
+		std::unordered_map<Entity*, InstanceLocation> m_instance_locations;
+
+		// Set whenever m_batches changes, cleared once the snapshot is rebuilt
+		bool m_dirty = true;
+
 		SceneSnapshotData m_snapshot_data;
 
 		EventListener m_frame_start_listener;
+		EventListener m_mesh_event_listener;
+		EventListener m_mesh_data_loaded_listener;
 	};
-}
\ No newline at end of file
+}
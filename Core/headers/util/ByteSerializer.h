@@ -104,6 +104,11 @@ namespace SNAKE {
 			m_pos += size;
 		}
 
+		// True once every byte has been read, used to detect optional trailing data missing from older files
+		bool AtEnd() const {
+			return m_pos >= m_data_size;
+		}
+
 	private:
 		std::byte* m_data;
 		size_t m_data_size;
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace SNAKE {
+	/*
+	LZ4 block format compression, greedy single-pass matching so encoding is fast enough to run at import and decoding runs at memory speed.
+	Chunked streams split data into independently decodable chunks so they can be compressed and decompressed in parallel on the JobSystem.
+
+	Chunked stream layout:
+	uint64 uncompressed size, uint32 chunk size, uint32 number of chunks, a uint32 stored size per chunk, then the chunks back to back.
+	A chunk whose stored size equals its uncompressed size is stored raw, used when compressing it saved nothing.
+	*/
+	class Compression {
+	public:
+		// Largest size CompressBlock can produce for 'size' input bytes
+		static size_t CompressBound(size_t size);
+
+		// Returns the compressed size, or 0 if it wouldn't fit in dst_capacity
+		static size_t CompressBlock(const std::byte* p_src, size_t src_size, std::byte* p_dst, size_t dst_capacity);
+
+		// Returns false if the block is malformed or doesn't decode to exactly dst_size bytes, never reads or writes out of bounds
+		static bool DecompressBlock(const std::byte* p_src, size_t src_size, std::byte* p_dst, size_t dst_size);
+
+		static std::vector<std::byte> CompressChunked(const std::byte* p_src, size_t src_size, uint32_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+		// Returns false if the stream is malformed or its uncompressed size isn't dst_size
+		static bool DecompressChunked(const std::byte* p_src, size_t src_size, std::byte* p_dst, size_t dst_size);
+
+		// Uncompressed size stored in a chunked stream's header, 0 if src_size is too small to hold one
+		static uint64_t GetChunkedUncompressedSize(const std::byte* p_src, size_t src_size);
+
+		inline static constexpr uint32_t DEFAULT_CHUNK_SIZE = 1 << 18;
+	};
+}
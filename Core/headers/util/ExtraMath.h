@@ -22,6 +22,27 @@ namespace SNAKE {
 			Plane near_plane;
 		};
 
+		struct AABB {
+			glm::vec3 min{ std::numeric_limits<float>::max() };
+			glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+			void Extend(const glm::vec3& p) {
+				min = glm::min(min, p);
+				max = glm::max(max, p);
+			}
+
+			glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+			glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+			bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		};
+
+		// Transforms a box given as center/extents by an affine matrix, outputs the center/extents of the world-space box enclosing it
+		static void TransformAABB(const glm::mat4& m, const glm::vec3& center, const glm::vec3& extents, glm::vec3& out_center, glm::vec3& out_extents);
+
+		// Extracts planes (xyz = normal pointing inwards, w = distance) from a projection-view matrix with a 0-1 depth range
+		// Order: left, right, bottom, top, near, far
+		static std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& proj_view);
+
 
 		// Returns a quaternion that rotates v onto w by factor "interp" (0-1)
 		static glm::quat MapVectorTransform(const glm::vec3& v, const glm::vec3& w, float interp = 1.f);
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+
+namespace SNAKE {
+	/*
+	Reports files written under a directory tree, polled without blocking.
+	On Linux it's backed by inotify, a file is reported once it's closed after writing or renamed into the tree so half-written files aren't seen.
+	Elsewhere the tree is rescanned for changed write times at most every SCAN_INTERVAL.
+	Directories created after Watch are watched too, files deleted aren't reported.
+	*/
+	class FileWatcher {
+	public:
+		FileWatcher() = default;
+		~FileWatcher() { Stop(); }
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		// Stops watching any previous directory, returns false and logs an error if 'directory' couldn't be watched
+		bool Watch(const std::string& directory);
+
+		void Stop();
+
+		// Paths of files written since the last call, each listed once
+		std::vector<std::string> Poll();
+
+		bool IsWatching() const {
+			return !m_directory.empty();
+		}
+
+		const std::string& GetDirectory() const {
+			return m_directory;
+		}
+
+		inline static constexpr std::chrono::milliseconds SCAN_INTERVAL{ 500 };
+
+	private:
+		// Watches 'directory' and every directory below it, files already inside are added to 'changed' if it isn't null
+		void AddDirectory(const std::filesystem::path& directory, std::vector<std::string>* p_changed);
+
+		std::string m_directory;
+
+#if defined (__linux__)
+		int m_inotify_fd = -1;
+
+		// Watch descriptor -> directory it watches
+		std::unordered_map<int, std::filesystem::path> m_watched_directories;
+#else
+		std::unordered_map<std::string, std::filesystem::file_time_type> m_write_times;
+		std::chrono::steady_clock::time_point m_last_scan;
+#endif
+	};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace SNAKE {
+	/*
+	Streaming 64-bit content hash, an implementation of XXH64 so hashes match the reference xxHash library.
+	Used to content-address asset data, it isn't cryptographic.
+	*/
+	class Hasher {
+	public:
+		Hasher(uint64_t seed = 0);
+
+		void Update(const void* p_data, size_t size);
+
+		// Hashes the bytes of a trivially copyable value, including any padding, so only use types without it
+		template<typename T>
+		void Value(const T& val) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			Update(&val, sizeof(T));
+		}
+
+		// Hashes the size then the bytes of every element
+		template<typename T>
+		void Container(const std::vector<T>& vec) {
+			Value((uint64_t)vec.size());
+			Update(vec.data(), vec.size() * sizeof(T));
+		}
+
+		// Doesn't modify the state, more data can be added afterwards
+		uint64_t Digest() const;
+
+		static uint64_t Hash(const void* p_data, size_t size, uint64_t seed = 0);
+
+	private:
+		std::array<uint64_t, 4> m_accumulators;
+
+		// Input that didn't fill a 32 byte stripe yet
+		std::array<std::byte, 32> m_buffer;
+		uint32_t m_buffer_size = 0;
+
+		uint64_t m_total_size = 0;
+		uint64_t m_seed;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+namespace SNAKE {
+	/*
+	Read-only file mapped into memory, copy-on-write so the view can be written without the changes ever reaching the file.
+	Lets large binary assets be read in place instead of copied into heap buffers first.
+	*/
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Maps the whole file, returns false and logs an error on failure
+		bool Open(const std::string& filepath);
+
+		void Close();
+
+		bool IsOpen() const {
+			return mp_data != nullptr;
+		}
+
+		std::byte* data() {
+			return mp_data;
+		}
+
+		size_t size() const {
+			return m_size;
+		}
+
+	private:
+		std::byte* mp_data = nullptr;
+		size_t m_size = 0;
+
+		// Windows file and file mapping handles, unused elsewhere
+		void* mp_file_handle = nullptr;
+		void* mp_mapping_handle = nullptr;
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+namespace SNAKE {
+	/*
+	Free-list allocator handing out ranges of [0, capacity), doesn't own any memory itself.
+	Used to sub-allocate element ranges in large GPU buffers. Allocation is best-fit, freed ranges are merged with free neighbours.
+	*/
+	class RangeAllocator {
+	public:
+		void Init(uint32_t capacity);
+
+		// Returns the offset of a free range of 'count' elements, or INVALID_OFFSET if no free range is large enough
+		uint32_t Allocate(uint32_t count);
+
+		// Like Allocate but returns the lowest free range that ends at or before 'limit', used to move ranges towards the start
+		uint32_t AllocateBelow(uint32_t count, uint32_t limit);
+
+		void Free(uint32_t offset, uint32_t count);
+
+		// Extends the capacity, new space is merged into the free range ending at the old capacity if there is one
+		void Grow(uint32_t new_capacity);
+
+		uint32_t GetCapacity() const {
+			return m_capacity;
+		}
+
+		uint32_t GetUsed() const {
+			return m_used;
+		}
+
+		uint32_t GetNumFreeRanges() const {
+			return (uint32_t)m_free_by_offset.size();
+		}
+
+		// True if all free space is a single range at the end
+		bool IsCompact() const {
+			return m_free_by_offset.empty() || (m_free_by_offset.size() == 1 && m_free_by_offset.begin()->first + m_free_by_offset.begin()->second == m_capacity);
+		}
+
+		uint32_t GetLargestFreeRange() const {
+			return m_free_by_size.empty() ? 0 : m_free_by_size.rbegin()->first;
+		}
+
+		inline static constexpr uint32_t INVALID_OFFSET = std::numeric_limits<uint32_t>::max();
+
+	private:
+		void InsertFreeRange(uint32_t offset, uint32_t count);
+
+		void EraseFreeRange(std::map<uint32_t, uint32_t>::iterator it);
+
+		uint32_t m_capacity = 0;
+		uint32_t m_used = 0;
+
+		// offset -> count
+		std::map<uint32_t, uint32_t> m_free_by_offset;
+
+		// (count, offset), ordered for best-fit lookups and so a range is erased by exact lookup rather than scanning ranges of equal size
+		std::set<std::pair<uint32_t, uint32_t>> m_free_by_size;
+	};
+}
@@ -0,0 +1,224 @@
+#pragma once
+#include "core/VkIncl.h"
+#include "util/ExtraMath.h"
+
+namespace SNAKE {
+	/*
+	Interleaved, quantised vertex, 20 bytes against 44 for the four float streams.
+	Matches the COMPACT_VERTICES inputs of the vertex shaders and CompactVertexData in "VertexEncoding.glsl", which decodes both.
+	*/
+	struct CompactVertex {
+		// unorm16 xyz relative to the submesh AABB, w is the tangent sign (0 = -1, max = +1)
+		uint16_t position[4];
+
+		// snorm16 octahedral encoded unit vectors
+		int16_t normal[2];
+
+		// float16
+		uint16_t tex_coord[2];
+
+		int16_t tangent[2];
+
+		// Passes reading positions from the float stream bind this after it, at 'binding'
+		[[nodiscard]] constexpr inline static vk::VertexInputBindingDescription GetBindingDescription(uint32_t binding = 0) {
+			vk::VertexInputBindingDescription desc{};
+			desc.binding = binding;
+			desc.stride = sizeof(CompactVertex);
+			desc.inputRate = vk::VertexInputRate::eVertex;
+			return desc;
+		}
+
+		[[nodiscard]] constexpr inline static std::array<vk::VertexInputAttributeDescription, 4> GetAttributeDescriptions(uint32_t binding = 0) {
+			std::array<vk::VertexInputAttributeDescription, 4> descs{};
+
+			descs[0].binding = binding;
+			descs[0].location = 0;
+			descs[0].format = vk::Format::eR16G16B16A16Unorm;
+			descs[0].offset = offsetof(CompactVertex, position);
+
+			descs[1].binding = binding;
+			descs[1].location = 1;
+			descs[1].format = vk::Format::eR16G16Snorm;
+			descs[1].offset = offsetof(CompactVertex, normal);
+
+			descs[2].binding = binding;
+			descs[2].location = 2;
+			descs[2].format = vk::Format::eR16G16Sfloat;
+			descs[2].offset = offsetof(CompactVertex, tex_coord);
+
+			descs[3].binding = binding;
+			descs[3].location = 3;
+			descs[3].format = vk::Format::eR16G16Snorm;
+			descs[3].offset = offsetof(CompactVertex, tangent);
+
+			return descs;
+		}
+	};
+
+	static_assert(sizeof(CompactVertex) == 20);
+
+	// Dequantisation range of one submesh, matches SubmeshQuantisation in "VertexEncoding.glsl"
+	struct SubmeshQuantisation {
+		glm::vec4 min;
+		glm::vec4 extent;
+	};
+
+	class VertexEncoding {
+	public:
+		// Maps a unit vector onto the [-1, 1] square by projecting it onto an octahedron and folding the lower half over the upper
+		static glm::vec2 OctEncode(glm::vec3 n) {
+			n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+			glm::vec2 p{ n.x, n.y };
+
+			if (n.z < 0.f)
+				p = (1.f - glm::abs(glm::vec2{ p.y, p.x })) * glm::vec2{ p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f };
+
+			return p;
+		}
+
+		static glm::vec3 OctDecode(glm::vec2 p) {
+			glm::vec3 n{ p.x, p.y, 1.f - glm::abs(p.x) - glm::abs(p.y) };
+			float t = glm::max(-n.z, 0.f);
+			n.x += n.x >= 0.f ? -t : t;
+			n.y += n.y >= 0.f ? -t : t;
+			return glm::normalize(n);
+		}
+
+		static int16_t PackSnorm16(float v) {
+			return (int16_t)std::lround(glm::clamp(v, -1.f, 1.f) * 32767.f);
+		}
+
+		static float UnpackSnorm16(int16_t v) {
+			return glm::max(v / 32767.f, -1.f);
+		}
+
+		static uint16_t PackUnorm16(float v) {
+			return (uint16_t)std::lround(glm::clamp(v, 0.f, 1.f) * 65535.f);
+		}
+
+		static float UnpackUnorm16(uint16_t v) {
+			return v / 65535.f;
+		}
+
+		// Round to nearest even, out of range values become infinity and NaN is preserved
+		static uint16_t PackHalf(float v) {
+			uint32_t bits;
+			memcpy(&bits, &v, sizeof(float));
+
+			uint32_t sign = (bits >> 16) & 0x8000;
+			uint32_t abs_bits = bits & 0x7FFFFFFF;
+
+			if (abs_bits >= 0x7F800000)
+				return (uint16_t)(sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x200 : 0));
+
+			// Largest float that rounds below half infinity
+			if (abs_bits >= 0x477FF000)
+				return (uint16_t)(sign | 0x7C00);
+
+			// Subnormal half, shift the mantissa with the implicit bit and round
+			if (abs_bits < 0x38800000) {
+				if (abs_bits < 0x33000000)
+					return (uint16_t)sign;
+
+				uint32_t exponent = abs_bits >> 23;
+				uint32_t mantissa = (abs_bits & 0x7FFFFF) | 0x800000;
+				uint32_t shift = 126 - exponent;
+				uint32_t half_mantissa = mantissa >> shift;
+				uint32_t remainder = mantissa & ((1u << shift) - 1);
+				uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+					half_mantissa++;
+
+				return (uint16_t)(sign | half_mantissa);
+			}
+
+			uint32_t rebased = abs_bits - 0x38000000;
+			uint32_t half = rebased >> 13;
+			uint32_t remainder = rebased & 0x1FFF;
+			if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+				half++;
+
+			return (uint16_t)(sign | half);
+		}
+
+		static float UnpackHalf(uint16_t h) {
+			uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+			uint32_t exponent = (h >> 10) & 0x1F;
+			uint32_t mantissa = h & 0x3FF;
+
+			uint32_t bits;
+			if (exponent == 0x1F) {
+				bits = sign | 0x7F800000 | (mantissa << 13);
+			}
+			else if (exponent != 0) {
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+			else if (mantissa != 0) {
+				// Subnormal, normalise into a float
+				exponent = 113;
+				while (!(mantissa & 0x400)) {
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+			}
+			else {
+				bits = sign;
+			}
+
+			float ret;
+			memcpy(&ret, &bits, sizeof(float));
+			return ret;
+		}
+
+		static SubmeshQuantisation GetQuantisation(const ExtraMath::AABB& aabb) {
+			// Flat submeshes still need a non-zero extent on every axis to avoid dividing by zero
+			glm::vec3 extent = glm::max(aabb.max - aabb.min, glm::vec3(1e-6f));
+			return SubmeshQuantisation{ glm::vec4(aabb.min, 0.f), glm::vec4(extent, 0.f) };
+		}
+
+		static CompactVertex Encode(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& tangent, float tangent_sign,
+			const glm::vec2& tex_coord, const SubmeshQuantisation& quantisation) {
+			CompactVertex v;
+
+			glm::vec3 local = (position - glm::vec3(quantisation.min)) / glm::vec3(quantisation.extent);
+			v.position[0] = PackUnorm16(local.x);
+			v.position[1] = PackUnorm16(local.y);
+			v.position[2] = PackUnorm16(local.z);
+			v.position[3] = tangent_sign < 0.f ? 0 : std::numeric_limits<uint16_t>::max();
+
+			// Zero vectors can't be projected, any direction is as wrong as another
+			glm::vec2 oct_normal = glm::dot(normal, normal) > 0.f ? OctEncode(normal) : glm::vec2(0.f);
+			glm::vec2 oct_tangent = glm::dot(tangent, tangent) > 0.f ? OctEncode(tangent) : glm::vec2(0.f);
+			v.normal[0] = PackSnorm16(oct_normal.x);
+			v.normal[1] = PackSnorm16(oct_normal.y);
+			v.tangent[0] = PackSnorm16(oct_tangent.x);
+			v.tangent[1] = PackSnorm16(oct_tangent.y);
+
+			v.tex_coord[0] = PackHalf(tex_coord.x);
+			v.tex_coord[1] = PackHalf(tex_coord.y);
+
+			return v;
+		}
+
+		struct DecodedVertex {
+			glm::vec3 position;
+			glm::vec3 normal;
+			glm::vec3 tangent;
+			float tangent_sign;
+			glm::vec2 tex_coord;
+		};
+
+		// CPU mirror of the shader side decode
+		static DecodedVertex Decode(const CompactVertex& v, const SubmeshQuantisation& quantisation) {
+			DecodedVertex ret;
+			glm::vec3 local{ UnpackUnorm16(v.position[0]), UnpackUnorm16(v.position[1]), UnpackUnorm16(v.position[2]) };
+			ret.position = glm::vec3(quantisation.min) + local * glm::vec3(quantisation.extent);
+			ret.tangent_sign = v.position[3] == 0 ? -1.f : 1.f;
+			ret.normal = OctDecode({ UnpackSnorm16(v.normal[0]), UnpackSnorm16(v.normal[1]) });
+			ret.tangent = OctDecode({ UnpackSnorm16(v.tangent[0]), UnpackSnorm16(v.tangent[1]) });
+			ret.tex_coord = { UnpackHalf(v.tex_coord[0]), UnpackHalf(v.tex_coord[1]) };
+			return ret;
+		}
+	};
+}
@@ -1,21 +1,33 @@
 #version 450
+#define SNAKE_PERMUTATIONS(COMPACT_VERTICES)
 
 #include "LightBuffers.glsl"
 
 #define TRANSFORM_BUFFER_DESCRIPTOR_SET_IDX 0
 #include "Transforms.glsl"
 
-layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_normal;
+#define INSTANCE_DATA_DESCRIPTOR_SET_IDX 0
+#define INSTANCE_DATA_DESCRIPTOR_BINDING 2
+#include "InstanceData.glsl"
 
-layout(push_constant) uniform pc {
-    uint transform_idx;
-} push;
+layout(location = 0) in vec3 in_position;
 
+#ifdef COMPACT_VERTICES
+// Normal of the CompactVertex stream, positions still come from the float stream
+layout(location = 1) in vec2 in_oct_normal;
+#include "VertexEncoding.glsl"
+#else
+layout(location = 1) in vec3 in_normal;
+#endif
 
 layout(location = 0) out vec3 out_normal;
 
+#define TRANSFORM transforms.m[instance_data.d[gl_InstanceIndex].transform_idx]
+
 void main() {
-    out_normal = transpose(inverse(mat3(transforms.m[push.transform_idx]))) * in_normal;
-    gl_Position = ssbo_light_data.dir_light.light_transform * transforms.m[push.transform_idx] * vec4(in_position, 1.0);
+#ifdef COMPACT_VERTICES
+    vec3 in_normal = OctDecode(in_oct_normal);
+#endif
+    out_normal = transpose(inverse(mat3(TRANSFORM))) * in_normal;
+    gl_Position = ssbo_light_data.dir_light.light_transform * TRANSFORM * vec4(in_position, 1.0);
 }
\ No newline at end of file
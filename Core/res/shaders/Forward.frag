@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : enable
 
 layout(location = 0) out vec4 out_colour;
 layout(set = 3, binding = 0) uniform sampler2D depth_tex;
@@ -44,7 +45,7 @@ void main() {
 
     vec3 n;
     if (material.normal_tex_idx != INVALID_GLOBAL_INDEX) {
-        n = normalize(vs_tbn * normalize(texture(textures[material.normal_tex_idx], vs_tex_coord).xyz * 2.0 - 1.0));
+        n = normalize(vs_tbn * SampleTangentNormal(material.normal_tex_idx, vs_tex_coord));
     } else {
         n = normalize(vs_normal);
     }
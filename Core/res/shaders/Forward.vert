@@ -1,9 +1,19 @@
 #version 450
+#define SNAKE_PERMUTATIONS(COMPACT_VERTICES)
 
 layout(location = 0) in vec3 in_position;
+
+#ifdef COMPACT_VERTICES
+// Everything but the position from the CompactVertex stream, positions still come from the float stream
+layout(location = 1) in vec2 in_oct_normal;
+layout(location = 2) in vec2 in_tex_coord;
+layout(location = 3) in vec2 in_oct_tangent;
+#include "VertexEncoding.glsl"
+#else
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec2 in_tex_coord;
 layout(location = 3) in vec3 in_tangent;
+#endif
 
 layout(location = 5) out mat3 vs_tbn;
 layout(location = 1) out vec2 vs_tex_coord;
@@ -36,6 +46,11 @@ mat3 CalculateTbnMatrix(vec3 _t, vec3 _n) {
 }
 
 void main() {
+#ifdef COMPACT_VERTICES
+    vec3 in_normal = OctDecode(in_oct_normal);
+    vec3 in_tangent = OctDecode(in_oct_tangent);
+#endif
+
     vec3 world_pos = vec4(TRANSFORM * vec4(in_position, 1.0)).xyz;
 
     vs_world_pos = world_pos;
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : enable
 #define SNAKE_PERMUTATIONS(MESH,PARTICLE)
 
 layout(location = 0) out vec4 out_albedo;
@@ -22,7 +23,7 @@ layout(location = 9) in vec4 vs_current_clip_pos;
 #include "Particle.glsl"
 
 layout(push_constant) uniform pc {
-    uint transform_idx;
+    uint quantisation_idx;
     uint material_idx;
     uint render_resolution_x;
     uint render_resolution_y;
@@ -38,17 +39,24 @@ layout(set = 2, binding = 3) buffer ParticleBufPrev { Particle ptcls[]; } ptcl_b
 layout(location = 10) in flat uint vs_instance_idx;
 #endif
 
+#ifdef MESH
+layout(location = 11) in flat uint vs_material_idx;
+#define MATERIAL_IDX vs_material_idx
+#else
+#define MATERIAL_IDX push.material_idx
+#endif
+
 vec2 CalcVelocity(vec4 current_clip_pos, vec4 old_clip_pos) {;
     return ((old_clip_pos.xy / old_clip_pos.w) - (current_clip_pos.xy / current_clip_pos.w)) * 0.5;
 }
 
 
 void main() {
-    Material material = material_ubo.materials[push.material_idx];
+    Material material = material_ubo.materials[MATERIAL_IDX];
 
     vec3 n;
     if (material.normal_tex_idx != INVALID_GLOBAL_INDEX) {
-        n = normalize(vs_tbn * normalize(texture(textures[material.normal_tex_idx], vs_tex_coord).xyz * 2.0 - 1.0));
+        n = normalize(vs_tbn * SampleTangentNormal(material.normal_tex_idx, vs_tex_coord));
     } else {
         n = normalize(vs_normal);
     }
@@ -1,12 +1,20 @@
 #version 450
-#define SNAKE_PERMUTATIONS(MESH,PARTICLE)
+#define SNAKE_PERMUTATIONS(MESH,PARTICLE,COMPACT_VERTICES)
 
 #if defined MESH || defined PARTICLE
 
+#ifdef COMPACT_VERTICES
+// Interleaved CompactVertex stream, see "VertexEncoding.h"
+layout(location = 0) in vec4 in_quantised_position;
+layout(location = 1) in vec2 in_oct_normal;
+layout(location = 2) in vec2 in_tex_coord;
+layout(location = 3) in vec2 in_oct_tangent;
+#else
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec2 in_tex_coord;
 layout(location = 3) in vec3 in_tangent;
+#endif
 
 layout(location = 1) out vec2 vs_tex_coord;
 layout(location = 2) out vec3 vs_normal;
@@ -20,6 +28,10 @@ layout(location = 9) out vec4 vs_current_clip_pos;
 layout(location = 10) out flat uint vs_instance_idx;
 #endif
 
+#ifdef MESH
+layout(location = 11) out flat uint vs_material_idx;
+#endif
+
 #include "CommonUBO.glsl"
 #include "Particle.glsl"
 
@@ -29,8 +41,17 @@ layout(location = 10) out flat uint vs_instance_idx;
 layout(set = 2, binding = 2) buffer ParticleBuf { Particle ptcls[]; } ptcl_buf;
 layout(set = 2, binding = 3) buffer ParticleBufPrev { Particle ptcls[]; } ptcl_buf_prev_frame;
 
+#define INSTANCE_DATA_DESCRIPTOR_SET_IDX 2
+#define INSTANCE_DATA_DESCRIPTOR_BINDING 4
+#include "InstanceData.glsl"
+
+#define SUBMESH_QUANTISATION_DESCRIPTOR_SET_IDX 2
+#define SUBMESH_QUANTISATION_DESCRIPTOR_BINDING 5
+#include "VertexEncoding.glsl"
+
 layout(push_constant) uniform pc {
-    uint transform_idx;
+    // Particles only, the SubmeshQuantisation of the particle mesh
+    uint quantisation_idx;
     uint material_idx;
     uint render_resolution_x;
     uint render_resolution_y;
@@ -38,7 +59,8 @@ layout(push_constant) uniform pc {
 } push;
 
 #ifdef MESH
-#define TRANSFORM transforms.m[push.transform_idx]
+#define TRANSFORM_IDX instance_data.d[gl_InstanceIndex].transform_idx
+#define TRANSFORM transforms.m[TRANSFORM_IDX]
 #endif
 
 #ifdef PARTICLE
@@ -46,7 +68,7 @@ layout(push_constant) uniform pc {
 #define PREV_PTCL ptcl_buf_prev_frame.ptcls[gl_InstanceIndex]
 #endif
 
-mat3 CalculateTbnMatrix(vec3 _t, vec3 _n) {
+mat3 CalculateTbnMatrix(vec3 _t, vec3 _n, float tangent_sign) {
 #ifdef MESH
 vec3 t = normalize(mat3(TRANSFORM) * _t);
 vec3 n = normalize(mat3(TRANSFORM) * _n);
@@ -56,7 +78,7 @@ vec3 n = normalize(_n);
 #endif
 
 	t = normalize(t - dot(t, n) * n);
-	vec3 b = cross(n, t);
+	vec3 b = cross(n, t) * tangent_sign;
 
 	mat3 tbn = mat3(t, b, n);
 
@@ -64,10 +86,25 @@ vec3 n = normalize(_n);
 }
 
 void main() {
+#ifdef COMPACT_VERTICES
+#ifdef MESH
+    SubmeshQuantisation quantisation = submesh_quantisation.q[instance_data.d[gl_InstanceIndex].quantisation_idx];
+#elif defined PARTICLE
+    SubmeshQuantisation quantisation = submesh_quantisation.q[push.quantisation_idx];
+#endif
+    vec3 in_position = quantisation.min.xyz + in_quantised_position.xyz * quantisation.extent.xyz;
+    vec3 in_normal = OctDecode(in_oct_normal);
+    vec3 in_tangent = OctDecode(in_oct_tangent);
+    float tangent_sign = in_quantised_position.w > 0.5 ? 1.0 : -1.0;
+#else
+    float tangent_sign = 1.0;
+#endif
+
 #ifdef MESH
     vec3 current_frame_world_pos = vec4(TRANSFORM * vec4(in_position, 1.0)).xyz;
-    vec3 prev_frame_world_pos = vec4(transforms_prev_frame.m[push.transform_idx] * vec4(in_position, 1.0)).xyz;
+    vec3 prev_frame_world_pos = vec4(transforms_prev_frame.m[TRANSFORM_IDX] * vec4(in_position, 1.0)).xyz;
     vs_normal = transpose(inverse(mat3(TRANSFORM))) * in_normal;
+    vs_material_idx = instance_data.d[gl_InstanceIndex].material_idx;
 #elif defined PARTICLE
     vec3 current_frame_world_pos = ACTIVE_PTCL.position_radius.xyz + in_position * 0.1;
     vec3 prev_frame_world_pos = PREV_PTCL.position_radius.xyz + in_position * 0.1;
@@ -79,7 +116,7 @@ void main() {
 
     vs_tex_coord = in_tex_coord;
     vs_tangent = in_tangent;
-    vs_tbn = CalculateTbnMatrix(in_tangent, in_normal);
+    vs_tbn = CalculateTbnMatrix(in_tangent, in_normal, tangent_sign);
 
     vec4 current_frame_clip_pos = common_ubo.proj_view * vec4(current_frame_world_pos, 1.0);
     vec4 prev_frame_clip_pos = common_ubo_prev_frame.proj_view * vec4(prev_frame_world_pos, 1.0);
@@ -0,0 +1,18 @@
+#ifndef INSTANCE_DATA_DESCRIPTOR_SET_IDX
+#error INSTANCE_DATA_DESCRIPTOR_SET_IDX must be defined
+#endif
+
+#ifndef INSTANCE_DATA_DESCRIPTOR_BINDING
+#error INSTANCE_DATA_DESCRIPTOR_BINDING must be defined
+#endif
+
+// Written by IndirectDrawBuilder, indexed with gl_InstanceIndex (includes the indirect command's firstInstance)
+struct DrawInstanceData {
+    uint transform_idx;
+    uint material_idx;
+
+    // Index of the submesh's dequantisation range in MeshBufferManager's quantisation buffer, only read with compact vertices
+    uint quantisation_idx;
+};
+
+layout(set = INSTANCE_DATA_DESCRIPTOR_SET_IDX, binding = INSTANCE_DATA_DESCRIPTOR_BINDING) readonly buffer DrawInstanceDataBuf { DrawInstanceData d[]; } instance_data;
@@ -19,20 +19,29 @@ struct Material {
     uint pad0, pad1, pad2;
 };
 
+// Both tables grow as assets are registered, see GlobalMaterialBufferManager and GlobalTextureBufferManager
+// Shaders including this need GL_EXT_nonuniform_qualifier for the unsized texture array
+
 #ifdef TEX_MAT_DESCRIPTOR_SET_IDX
 
 layout(set = TEX_MAT_DESCRIPTOR_SET_IDX, binding = 0) readonly buffer MaterialUBO {
-    Material materials[4096];
+    Material materials[];
 } material_ubo;
 
-layout(set = TEX_MAT_DESCRIPTOR_SET_IDX, binding = 1) uniform sampler2D textures[4096];
+layout(set = TEX_MAT_DESCRIPTOR_SET_IDX, binding = 1) uniform sampler2D textures[];
 
 #else
 
 layout(set = 1, binding = 0) readonly buffer MaterialUBO {
-    Material materials[4096];
+    Material materials[];
 } material_ubo;
 
-layout(set = 1, binding = 1) uniform sampler2D textures[4096];
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+#endif
 
-#endif
\ No newline at end of file
+// Normal maps can be BC5 which only stores XY, so Z is always reconstructed
+vec3 SampleTangentNormal(uint tex_idx, vec2 uv) {
+    vec2 xy = texture(textures[tex_idx], uv).xy * 2.0 - 1.0;
+    return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
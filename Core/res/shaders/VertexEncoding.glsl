@@ -0,0 +1,54 @@
+// Decoding of the compact vertex format, see "VertexEncoding.h"
+// The quantisation and CompactVertex buffers are only declared if their descriptor set and binding are defined
+
+// Inverse of VertexEncoding::OctEncode
+vec3 OctDecode(vec2 p) {
+    vec3 n = vec3(p.x, p.y, 1.0 - abs(p.x) - abs(p.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+#ifdef SUBMESH_QUANTISATION_DESCRIPTOR_SET_IDX
+
+#ifndef SUBMESH_QUANTISATION_DESCRIPTOR_BINDING
+#error SUBMESH_QUANTISATION_DESCRIPTOR_BINDING must be defined
+#endif
+
+// Written by MeshBufferManager, indexed with DrawInstanceData::quantisation_idx
+struct SubmeshQuantisation {
+    vec4 min;
+    vec4 extent;
+};
+
+layout(set = SUBMESH_QUANTISATION_DESCRIPTOR_SET_IDX, binding = SUBMESH_QUANTISATION_DESCRIPTOR_BINDING) readonly buffer SubmeshQuantisationBuf { SubmeshQuantisation q[]; } submesh_quantisation;
+
+#endif
+
+#ifdef COMPACT_VERTEX_DESCRIPTOR_SET_IDX
+
+#ifndef COMPACT_VERTEX_DESCRIPTOR_BINDING
+#error COMPACT_VERTEX_DESCRIPTOR_BINDING must be defined
+#endif
+
+// CompactVertex read as storage, for shaders that fetch vertices themselves
+struct CompactVertexData {
+    uint position_xy;
+    uint position_zw;
+    uint normal;
+    uint tex_coord;
+    uint tangent;
+};
+
+layout(set = COMPACT_VERTEX_DESCRIPTOR_SET_IDX, binding = COMPACT_VERTEX_DESCRIPTOR_BINDING, std430) readonly buffer CompactVertexBuf { CompactVertexData v[]; } compact_vertices;
+
+vec3 GetCompactNormal(int idx) {
+    return OctDecode(unpackSnorm2x16(compact_vertices.v[idx].normal));
+}
+
+vec2 GetCompactTexCoord(int idx) {
+    return unpackHalf2x16(compact_vertices.v[idx].tex_coord);
+}
+
+#endif
@@ -0,0 +1,416 @@
+#include "pch/pch.h"
+#include "assets/AssetHotReloader.h"
+#include "assets/AssetManager.h"
+#include "assets/AssetStreamer.h"
+#include "assets/TextureResidencyManager.h"
+#include "rendering/UploadBatch.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+namespace {
+	// Same as TextureResidencyManager, a frame in flight samples through a descriptor written on its own frame start
+	constexpr uint64_t RETIRE_FRAMES = 2 * MAX_FRAMES_IN_FLIGHT + 1;
+
+	uint64_t GetTextureUUID(const AssetRef<Texture2DAsset>& tex) {
+		return tex ? tex->uuid() : UUID<uint64_t>::INVALID_UUID;
+	}
+}
+
+void AssetHotReloader::I_Init() {
+	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		Update();
+	};
+
+	m_asset_event_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<AssetEvent const*>(p_event);
+		if (p_casted->type == AssetEventType::DESTROYED)
+			OnAssetDestroyed(p_casted->p_asset);
+	};
+
+	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+	EventManagerG::RegisterListener<AssetEvent>(m_asset_event_listener);
+}
+
+void AssetHotReloader::Shutdown() {
+	auto& reloader = Get();
+	reloader.m_watcher.Stop();
+
+	while (true) {
+		{
+			std::scoped_lock l(reloader.m_mux);
+			if (reloader.m_num_reading == 0)
+				break;
+		}
+
+		std::this_thread::yield();
+	}
+
+	reloader.m_reloaded.clear();
+	reloader.m_in_flight_batches.clear();
+	reloader.m_retired.clear();
+	reloader.m_in_progress.clear();
+	reloader.m_changed_again.clear();
+	reloader.m_waiting.clear();
+}
+
+bool AssetHotReloader::WatchDirectory(const std::string& directory) {
+	if (!Get().m_watcher.Watch(directory))
+		return false;
+
+	SNK_CORE_INFO("Hot reloading assets changed in '{}'", directory);
+	return true;
+}
+
+bool AssetHotReloader::GetReloadType(Asset* p_asset, ReloadType& type) {
+	auto& filepath = p_asset->filepath;
+
+	if (dynamic_cast<Texture2DAsset*>(p_asset) && filepath.ends_with(".tex2d"))
+		type = ReloadType::TEXTURE_2D;
+	else if (dynamic_cast<MaterialAsset*>(p_asset) && filepath.ends_with(".mat"))
+		type = ReloadType::MATERIAL;
+	else if (dynamic_cast<MeshDataAsset*>(p_asset) && filepath.ends_with(".meshdata"))
+		type = ReloadType::MESH_DATA;
+	else
+		return false;
+
+	return true;
+}
+
+void AssetHotReloader::Reload(Asset* p_asset) {
+	auto& reloader = Get();
+
+	ReloadType type;
+	if (!GetReloadType(p_asset, type))
+		return;
+
+	// The read in progress may have missed the change
+	if (reloader.m_in_progress.contains(p_asset)) {
+		reloader.m_changed_again.insert(p_asset);
+		return;
+	}
+
+	// AssetStreamer may have read the file before it changed, it's read again once that's applied
+	if (!AssetStreamer::IsResident(p_asset)) {
+		reloader.m_waiting.insert(p_asset);
+		return;
+	}
+
+	reloader.StartReload(p_asset, type);
+}
+
+void AssetHotReloader::Update() {
+	PollInFlightBatches();
+	ApplyReloads();
+
+	std::erase_if(m_retired, [this](const RetiredImage& retired) { return m_frame >= retired.frame + RETIRE_FRAMES; });
+
+	// Drained while disabled so old changes aren't picked up when it's enabled again
+	for (const auto& path : m_watcher.Poll()) {
+		if (!enabled)
+			continue;
+
+		for (auto* p_asset : AssetManager::GetAssetsAtPath(path)) {
+			Reload(p_asset);
+		}
+	}
+
+	// Assets that failed to stream in stay here until they're deleted
+	std::vector<Asset*> resident;
+	for (auto* p_asset : m_waiting) {
+		if (AssetStreamer::IsResident(p_asset))
+			resident.push_back(p_asset);
+	}
+
+	for (auto* p_asset : resident) {
+		m_waiting.erase(p_asset);
+		Reload(p_asset);
+	}
+
+	m_frame++;
+}
+
+void AssetHotReloader::StartReload(Asset* p_asset, ReloadType type) {
+	ReloadRequest request{
+		.p_asset = p_asset,
+		.type = type,
+		.filepath = p_asset->filepath,
+		.id = m_next_reload_id++,
+		.uuid = p_asset->uuid(),
+		.content_hash = p_asset->content_hash,
+	};
+
+	if (type == ReloadType::TEXTURE_2D)
+		request.managed_residency = TextureResidencyManager::IsRegistered(static_cast<Texture2DAsset*>(p_asset));
+
+	m_in_progress[p_asset] = request.id;
+
+	{
+		std::scoped_lock l(m_mux);
+		m_num_reading++;
+	}
+
+	auto* p_job = JobSystem::CreateJob();
+	p_job->func = [this, request = std::move(request)]([[maybe_unused]] Job const* p_this) {
+		ReloadedAsset reloaded;
+		switch (request.type) {
+		case ReloadType::TEXTURE_2D:
+			reloaded = ReadTexture2D(request);
+			break;
+		case ReloadType::MATERIAL:
+			reloaded = ReadMaterial(request);
+			break;
+		case ReloadType::MESH_DATA:
+			reloaded = ReadMeshData(request);
+			break;
+		}
+
+		reloaded.p_asset = request.p_asset;
+		reloaded.type = request.type;
+		reloaded.id = request.id;
+
+		std::scoped_lock l(m_mux);
+		m_reloaded.push_back(std::move(reloaded));
+		m_num_reading--;
+	};
+
+	JobSystem::Execute(p_job);
+}
+
+AssetHotReloader::ReloadedAsset AssetHotReloader::ReadTexture2D(const ReloadRequest& request) {
+	ReloadedAsset reloaded;
+
+	uint64_t uuid;
+	AssetLoader::Texture2DFileContents contents;
+	if (!AssetLoader::ReadTexture2DFile(request.filepath, uuid, reloaded.name, reloaded.spec, &contents))
+		return reloaded;
+
+	if (uuid != request.uuid) {
+		SNK_CORE_ERROR("AssetHotReloader failed to reload '{}', its UUID changed from '{}' to '{}'", request.filepath, request.uuid, uuid);
+		return reloaded;
+	}
+
+	reloaded.success = true;
+	if (contents.content_hash != 0 && contents.content_hash == request.content_hash) {
+		reloaded.unchanged = true;
+		return reloaded;
+	}
+
+	// As AssetStreamer loads them, a streamed texture only has its tail uploaded again
+	if (contents.mips.empty()) {
+		if (!AssetLoader::DecodeLegacyTexture2D(request.filepath, reloaded.spec, contents)) {
+			reloaded.success = false;
+			return reloaded;
+		}
+	}
+	else if (request.managed_residency) {
+		reloaded.resident_top = TextureResidencyManager::GetTailTop(reloaded.spec);
+		reloaded.managed_residency = true;
+		contents.mips.erase(contents.mips.begin(), contents.mips.begin() + reloaded.resident_top);
+	}
+
+	// Touching every page reads the file here instead of on the main thread when the mips are staged
+	volatile std::byte sink;
+	for (auto mip : contents.mips) {
+		for (size_t i = 0; i < mip.size(); i += 4096) {
+			sink = mip[i];
+		}
+
+		reloaded.upload_size += mip.size();
+	}
+
+	reloaded.file_contents = std::move(contents);
+	return reloaded;
+}
+
+AssetHotReloader::ReloadedAsset AssetHotReloader::ReadMaterial(const ReloadRequest& request) {
+	ReloadedAsset reloaded;
+
+	uint64_t uuid;
+	if (!AssetLoader::ReadMaterialFile(request.filepath, uuid, reloaded.material))
+		return reloaded;
+
+	if (uuid != request.uuid) {
+		SNK_CORE_ERROR("AssetHotReloader failed to reload '{}', its UUID changed from '{}' to '{}'", request.filepath, request.uuid, uuid);
+		return reloaded;
+	}
+
+	// Materials have no content hash, they're compared field by field when applied
+	reloaded.success = true;
+	return reloaded;
+}
+
+AssetHotReloader::ReloadedAsset AssetHotReloader::ReadMeshData(const ReloadRequest& request) {
+	ReloadedAsset reloaded;
+
+	auto p_file = std::make_unique<MappedFile>();
+	if (!p_file->Open(request.filepath)) {
+		SNK_CORE_ERROR("AssetHotReloader failed to reload mesh data, couldn't map '{}'", request.filepath);
+		return reloaded;
+	}
+
+	// Loading migrates these, one showing up later wasn't written by the engine
+	if (AssetLoader::IsLegacyMeshDataFile(*p_file)) {
+		SNK_CORE_ERROR("AssetHotReloader failed to reload '{}', it's in the pre-versioned .meshdata layout, reload the project to migrate it", request.filepath);
+		return reloaded;
+	}
+
+	auto p_data = std::make_unique<MeshData>();
+	uint64_t uuid;
+	if (!AssetLoader::ReadMeshDataFile(std::move(p_file), request.filepath, *p_data, uuid, reloaded.name))
+		return reloaded;
+
+	if (uuid != request.uuid) {
+		SNK_CORE_ERROR("AssetHotReloader failed to reload '{}', its UUID changed from '{}' to '{}'", request.filepath, request.uuid, uuid);
+		return reloaded;
+	}
+
+	reloaded.success = true;
+	if (p_data->CalculateContentHash() == request.content_hash) {
+		reloaded.unchanged = true;
+		return reloaded;
+	}
+
+	reloaded.mesh_upload = AssetManager::Get().mesh_buffer_manager.PrepareMeshUpload(std::move(p_data));
+	reloaded.upload_size = AssetManager::Get().mesh_buffer_manager.GetUploadSize(reloaded.mesh_upload);
+	return reloaded;
+}
+
+void AssetHotReloader::ApplyReloads() {
+	std::vector<ReloadedAsset> reloaded;
+	{
+		std::scoped_lock l(m_mux);
+		if (m_reloaded.empty())
+			return;
+
+		std::swap(reloaded, m_reloaded);
+	}
+
+	struct StagedTexture {
+		ReloadedAsset* p_reloaded;
+		std::unique_ptr<Image2D> p_image;
+	};
+
+	auto p_batch = std::make_unique<UploadBatch>();
+	std::vector<StagedTexture> staged_textures;
+	std::vector<Asset*> changed_again;
+
+	for (auto& asset : reloaded) {
+		// Dropped if the asset was deleted while its file was read
+		auto it = m_in_progress.find(asset.p_asset);
+		if (it == m_in_progress.end() || it->second != asset.id)
+			continue;
+
+		m_in_progress.erase(it);
+		if (m_changed_again.erase(asset.p_asset))
+			changed_again.push_back(asset.p_asset);
+
+		if (!asset.success) {
+			// The asset keeps what it had before the change
+			m_stats.num_failed++;
+			continue;
+		}
+
+		if (asset.unchanged) {
+			m_stats.num_unchanged++;
+			continue;
+		}
+
+		switch (asset.type) {
+		case ReloadType::TEXTURE_2D:
+			staged_textures.push_back(StagedTexture{ &asset, StageTexture(asset, *p_batch) });
+			continue;
+		case ReloadType::MATERIAL:
+			if (!ApplyMaterial(static_cast<MaterialAsset*>(asset.p_asset), asset.material)) {
+				m_stats.num_unchanged++;
+				continue;
+			}
+			break;
+		case ReloadType::MESH_DATA:
+			asset.p_asset->name = std::move(asset.name);
+			m_stats.bytes_uploaded += asset.upload_size;
+			AssetManager::Get().mesh_buffer_manager.QueueMeshReload(static_cast<MeshDataAsset*>(asset.p_asset), std::move(asset.mesh_upload));
+			break;
+		}
+
+		m_stats.num_reloaded++;
+		SNK_CORE_INFO("Reloaded '{}'", asset.p_asset->filepath);
+	}
+
+	if (!staged_textures.empty()) {
+		p_batch->Submit();
+		m_in_flight_batches.push_back(std::move(p_batch));
+
+		for (auto& staged : staged_textures) {
+			auto& asset = *staged.p_reloaded;
+			SwapTexture(static_cast<Texture2DAsset*>(asset.p_asset), std::move(staged.p_image), asset);
+
+			m_stats.num_reloaded++;
+			SNK_CORE_INFO("Reloaded '{}'", asset.p_asset->filepath);
+		}
+	}
+
+	for (auto* p_asset : changed_again) {
+		Reload(p_asset);
+	}
+}
+
+void AssetHotReloader::PollInFlightBatches() {
+	std::erase_if(m_in_flight_batches, [](const std::unique_ptr<UploadBatch>& p_batch) { return p_batch->IsComplete(); });
+}
+
+std::unique_ptr<Image2D> AssetHotReloader::StageTexture(ReloadedAsset& reloaded, UploadBatch& batch) {
+	auto spec = TextureResidencyManager::GetResidentSpec(reloaded.spec, reloaded.resident_top);
+	auto p_image = std::make_unique<Image2D>(spec);
+	p_image->CreateImage();
+
+	auto& mips = reloaded.file_contents.mips;
+	SNK_ASSERT(mips.size() == spec.mip_levels);
+
+	for (uint32_t i = 0; i < spec.mip_levels; i++) {
+		batch.AddImageCopy(p_image->GetImage(), i, glm::max(spec.size.x >> i, 1u), glm::max(spec.size.y >> i, 1u), mips[i].data(), mips[i].size(),
+			vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+
+	m_stats.bytes_uploaded += reloaded.upload_size;
+	return p_image;
+}
+
+void AssetHotReloader::SwapTexture(Texture2DAsset* p_tex, std::unique_ptr<Image2D> p_image, ReloadedAsset& reloaded) {
+	// Frames already recorded keep sampling the old image until it's retired, as with TextureResidencyManager's swaps
+	p_tex->image.Swap(*p_image);
+	m_retired.push_back(RetiredImage{ std::move(p_image), m_frame });
+	AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(p_tex);
+
+	// Registered again as the full spec may have changed, mips it was reading for the old file are dropped
+	TextureResidencyManager::Unregister(p_tex);
+	if (reloaded.managed_residency)
+		TextureResidencyManager::Register(p_tex, p_tex->filepath, reloaded.spec, reloaded.resident_top);
+
+	p_tex->name = std::move(reloaded.name);
+	AssetManager::SetContentHash(p_tex, reloaded.file_contents.content_hash);
+
+	// Anything else holding the old image's view (editor thumbnails) must recreate it before the image is retired
+	EventManagerG::DispatchEvent(AssetEvent{ AssetEventType::UPDATED, p_tex });
+}
+
+bool AssetHotReloader::ApplyMaterial(MaterialAsset* p_mat, const AssetLoader::MaterialFileContents& contents) {
+	bool unchanged = p_mat->name == contents.name && p_mat->albedo == contents.albedo && p_mat->emissive == contents.emissive &&
+		p_mat->roughness == contents.roughness && p_mat->metallic == contents.metallic && p_mat->ao == contents.ao &&
+		contents.texture_uuids == std::array<uint64_t, 5>{ GetTextureUUID(p_mat->albedo_tex), GetTextureUUID(p_mat->normal_tex), GetTextureUUID(p_mat->roughness_tex),
+			GetTextureUUID(p_mat->metallic_tex), GetTextureUUID(p_mat->ao_tex) };
+
+	if (unchanged)
+		return false;
+
+	AssetLoader::ApplyMaterialFileContents(*p_mat, contents);
+	p_mat->DispatchUpdateEvent();
+	return true;
+}
+
+void AssetHotReloader::OnAssetDestroyed(Asset* p_asset) {
+	// Reads in progress are dropped in ApplyReloads once the asset is gone from m_in_progress
+	m_in_progress.erase(p_asset);
+	m_changed_again.erase(p_asset);
+	m_waiting.erase(p_asset);
+}
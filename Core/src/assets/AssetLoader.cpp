@@ -3,253 +3,836 @@
 #include "assets/AssetManager.h"
 #include "stb_image.h"
 #include "util/ByteSerializer.h"
+#include "util/Hash.h"
+#include "assets/MeshDataFile.h"
+#include "util/Compression.h"
 #include "assets/MeshData.h"
+#include "assets/MeshSimplifier.h"
+#include "assets/MeshOptimizer.h"
+#include "assets/MeshletBuilder.h"
+#include "rendering/UploadBatch.h"
+#include "core/JobSystem.h"
 #include "nlohmann/json.hpp"
+#include <span>
 
 using namespace SNAKE;
 
 void AssetLoader::SerializeTexture2DBinaryFromRawFile(const std::string& output_filepath, Texture2DAsset& asset, 
-	const std::string& filepath_raw) {
+	const std::string& filepath_raw, TextureEncoder::Usage usage) {
 	SNK_ASSERT(output_filepath.ends_with(".tex2d"));
-	asset.filepath = output_filepath;
+	AssetManager::SetFilepath(&asset, output_filepath);
 
-	ByteSerializer ser;
-	auto& spec = asset.image.GetSpec();
-	ser.Value(asset.uuid());
-	ser.Container(asset.name);
-	ser.Value(spec.format);
-	ser.Value(spec.mip_levels);
-	ser.Value(spec.size);
+	// Hashed as the texture was imported so it's still found as a duplicate once loaded from this file
+	WriteTexture2DFileFromRawFile(output_filepath, asset.uuid(), asset.name, filepath_raw, usage, asset.image.GetSpec().format);
+}
+
+bool AssetLoader::WriteTexture2DFileFromRawFile(const std::string& output_filepath, uint64_t uuid, const std::string& name,
+	const std::string& filepath_raw, TextureEncoder::Usage usage, vk::Format hash_format) {
+	SNK_ASSERT(output_filepath.ends_with(".tex2d"));
 
 	std::vector<std::byte> raw_file_data; 
 	if (!files::ReadBinaryFile(filepath_raw, raw_file_data)) {
-		SNK_CORE_ERROR("SerializeTexture2DBinaryFromRawFile failed, couldn't read raw file '{}'", filepath_raw);
-		return;
+		SNK_CORE_ERROR("WriteTexture2DFileFromRawFile failed, couldn't read raw file '{}'", filepath_raw);
+		return false;
 	}
-	ser.Container(raw_file_data);
-	ser.OutputToFile(output_filepath);
+
+	int width, height, channels;
+	stbi_uc* p_pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(raw_file_data.data()), (int)raw_file_data.size(), &width, &height, &channels, 4);
+	if (!p_pixels) {
+		SNK_CORE_ERROR("WriteTexture2DFileFromRawFile failed, couldn't decode '{}': '{}'", filepath_raw, stbi_failure_reason());
+		return false;
+	}
+
+	WriteTexture2DFile(output_filepath, uuid, name, reinterpret_cast<std::byte*>(p_pixels), glm::uvec2(width, height),
+		CalculateTextureContentHash(raw_file_data, hash_format), usage);
+
+	stbi_image_free(p_pixels);
+	return true;
+}
+
+void AssetLoader::WriteTexture2DFile(const std::string& output_filepath, uint64_t uuid, const std::string& name, const std::byte* p_rgba, glm::uvec2 size,
+	uint64_t content_hash, TextureEncoder::Usage usage) {
+	Texture2DFileHeader header;
+	header.format = TextureEncoder::SelectFormat(usage, TextureEncoder::HasAlpha(p_rgba, size.x, size.y));
+	header.uuid = uuid;
+	header.content_hash = content_hash;
+	header.size = size;
+
+	auto rgba_mips = TextureEncoder::GenerateMips(p_rgba, size.x, size.y, usage);
+
+	std::vector<std::vector<std::byte>> encoded_mips;
+	encoded_mips.push_back(TextureEncoder::Encode(p_rgba, size.x, size.y, header.format));
+	for (uint32_t i = 1; i <= rgba_mips.size(); i++) {
+		encoded_mips.push_back(TextureEncoder::Encode(rgba_mips[i - 1].data(), glm::max(size.x >> i, 1u), glm::max(size.y >> i, 1u), header.format));
+	}
+
+	std::vector<std::span<const std::byte>> mips{ encoded_mips.begin(), encoded_mips.end() };
+	auto file = BuildTexture2DFile(header, name, mips);
+	files::WriteBinaryFile(output_filepath, file.data(), file.size());
+}
+
+std::vector<std::byte> AssetLoader::BuildTexture2DFile(Texture2DFileHeader header, const std::string& name, const std::vector<std::span<const std::byte>>& mips) {
+	header.mip_levels = (uint32_t)mips.size();
+	header.name_size = (uint32_t)name.size();
+
+	uint64_t name_offset = sizeof(Texture2DFileHeader) + mips.size() * sizeof(Texture2DFileMip);
+
+	std::vector<Texture2DFileMip> table;
+	uint64_t offset = aligned_size(name_offset + name.size(), Texture2DFileHeader::MIP_ALIGNMENT);
+	for (auto& mip : mips) {
+		table.push_back(Texture2DFileMip{ .offset = offset, .size = mip.size() });
+		offset = aligned_size(offset + mip.size(), Texture2DFileHeader::MIP_ALIGNMENT);
+	}
+
+	// Zero initialised so alignment padding is deterministic
+	std::vector<std::byte> file(offset);
+	std::memcpy(file.data(), &header, sizeof(Texture2DFileHeader));
+	std::memcpy(file.data() + sizeof(Texture2DFileHeader), table.data(), table.size() * sizeof(Texture2DFileMip));
+	std::memcpy(file.data() + name_offset, name.data(), name.size());
+	for (size_t i = 0; i < mips.size(); i++) {
+		std::memcpy(file.data() + table[i].offset, mips[i].data(), mips[i].size());
+	}
+
+	return file;
 }
 
 void AssetLoader::SerializeTexture2DBinary(const std::string& output_filepath, Texture2DAsset& asset) {
 	SNK_ASSERT_ARG(files::PathExists(output_filepath), "Output filepath must already exist (texture must already have been serialized), call SerializeTexture2DBinaryFromRawFile first");
-	
-	std::vector<std::byte> raw_image_data;
-
-	// First fetch and read the existing raw image data
-	{
-		std::vector<std::byte> data;
-		if (!files::ReadBinaryFile(output_filepath, data)) {
-			SNK_CORE_ERROR("SerializeTexture2DBinary failed, couldn't read binary file '{}'", output_filepath);
+
+	uint64_t uuid;
+	std::string name;
+	Image2DSpec spec;
+	Texture2DFileContents contents;
+	if (!ReadTexture2DFile(output_filepath, uuid, name, spec, &contents)) {
+		SNK_CORE_ERROR("SerializeTexture2DBinary failed, couldn't read binary file '{}'", output_filepath);
+		return;
+	}
+
+	if (contents.mips.empty()) {
+		int width, height, channels;
+		stbi_uc* p_pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(contents.raw_file_data.data()), (int)contents.raw_file_data.size(), &width, &height, &channels, 4);
+		if (!p_pixels) {
+			SNK_CORE_ERROR("SerializeTexture2DBinary failed, couldn't decode the image in '{}': '{}'", output_filepath, stbi_failure_reason());
 			return;
 		}
-		ByteDeserializer d{ data.data(), data.size() };
 
-		std::string throwaway_name;
-		size_t throwaway_uuid;
-		Image2DSpec throwaway_spec;
-		d.Value(throwaway_uuid);
-		d.Container(throwaway_name);
-		d.Value(throwaway_spec.format);
-		d.Value(throwaway_spec.mip_levels);
-		d.Value(throwaway_spec.size);
-		d.Container(raw_image_data);
+		SNK_CORE_INFO("Rewriting texture '{}' in the current .tex2d layout, block compressing it", output_filepath);
+		WriteTexture2DFile(output_filepath, asset.uuid(), asset.name, reinterpret_cast<std::byte*>(p_pixels), glm::uvec2(width, height), contents.content_hash, FindTextureUsage(asset));
+		stbi_image_free(p_pixels);
+		return;
 	}
 
-	ByteSerializer ser;
-	auto& spec = asset.image.GetSpec();
-	ser.Value(asset.uuid());
-	ser.Container(asset.name);
-	ser.Value(spec.format);
-	ser.Value(spec.mip_levels);
-	ser.Value(spec.size);
-	files::WriteBinaryFile("TEST.jpg", raw_image_data.data(), raw_image_data.size());
-	ser.Container(raw_image_data);
-	ser.OutputToFile(output_filepath);
+	Texture2DFileHeader header;
+	header.format = spec.format;
+	header.uuid = asset.uuid();
+	header.content_hash = contents.content_hash;
+	header.size = spec.size;
+
+	// Built before writing as the mips point into the mapped file being replaced
+	auto file = BuildTexture2DFile(header, asset.name, contents.mips);
+	contents.p_file->Close();
+	files::WriteBinaryFile(output_filepath, file.data(), file.size());
 }
 
+TextureEncoder::Usage AssetLoader::FindTextureUsage(Texture2DAsset& tex) {
+	bool used_as_albedo = false;
+	for (auto* p_mat : AssetManager::GetView<MaterialAsset, true>()) {
+		if (p_mat->normal_tex.get() == &tex)
+			return TextureEncoder::Usage::NORMAL;
+
+		used_as_albedo |= p_mat->albedo_tex.get() == &tex;
+	}
+
+	auto format = tex.image.GetSpec().format;
+	bool is_srgb = format == vk::Format::eR8G8B8A8Srgb || format == vk::Format::eBc7SrgbBlock;
+	return used_as_albedo || is_srgb ? TextureEncoder::Usage::ALBEDO : TextureEncoder::Usage::MASK;
+}
 
 Texture2DAsset* AssetLoader::DeserializeTexture2D(const std::string& filepath) {
+	uint64_t uuid;
+	std::string name;
+	Image2DSpec spec;
+	Texture2DFileContents contents;
+	if (!ReadTexture2DFile(filepath, uuid, name, spec, &contents))
+		return nullptr;
+
+	// Projects saved before imports were deduplicated can contain identical textures, their UUIDs resolve to the first one loaded
+	uint64_t content_hash = contents.content_hash;
+	if (auto* p_existing = AssetManager::FindAssetByContentHash<Texture2DAsset>(content_hash)) {
+		AssetManager::AddAlias(uuid, p_existing);
+		auto& stats = AssetManager::GetContentDedupStats();
+		stats.num_textures++;
+		stats.texture_bytes_saved += GetTextureGPUSize(p_existing->image.GetSpec());
+		SNK_CORE_INFO("Texture '{}' is identical to '{}', sharing it", filepath, p_existing->filepath);
+		return p_existing;
+	}
+
+	auto& asset = *AssetManager::CreateAsset<Texture2DAsset>(uuid).get();
+	AssetManager::SetFilepath(&asset, filepath);
+	asset.name = std::move(name);
+	asset.uuid = UUID<uint64_t>(uuid);
+
+	if (!contents.mips.empty()) {
+		asset.image.SetSpec(spec);
+		asset.image.CreateImage();
+
+		UploadBatch batch;
+		StageTextureMips(asset, contents, batch);
+		batch.Submit();
+	}
+	else if (DecodeLegacyTexture2D(filepath, spec, contents)) {
+		asset.image.SetSpec(spec);
+		asset.image.CreateImage();
+
+		UploadBatch batch;
+		StageTextureMips(asset, contents, batch);
+		batch.Submit();
+	}
+
+	AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(&asset);
+	AssetManager::SetContentHash(&asset, content_hash);
+	return &asset;
+}
+
+void AssetLoader::StageTextureMips(Texture2DAsset& tex, const Texture2DFileContents& contents, UploadBatch& batch) {
+	auto& spec = tex.image.GetSpec();
+	SNK_ASSERT(contents.mips.size() == spec.mip_levels);
+
+	// Copies to one image are recorded as a single multi-region copy
+	for (uint32_t i = 0; i < contents.mips.size(); i++) {
+		batch.AddImageCopy(tex.image.GetImage(), i, glm::max(spec.size.x >> i, 1u), glm::max(spec.size.y >> i, 1u), contents.mips[i].data(), contents.mips[i].size(),
+			vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+}
+
+bool AssetLoader::DecodeLegacyTexture2D(const std::string& filepath, const Image2DSpec& spec, Texture2DFileContents& contents) {
+	// Legacy files only record the format they were loaded as, sRGB ones were colour
+	auto usage = spec.format == vk::Format::eR8G8B8A8Srgb ? TextureEncoder::Usage::ALBEDO : TextureEncoder::Usage::MASK;
+
+	glm::uvec2 size;
+	contents.decoded_mips = DecodeTextureMips(contents.raw_file_data, usage, size);
+	if (contents.decoded_mips.empty()) {
+		SNK_CORE_ERROR("DecodeLegacyTexture2D failed, couldn't decode the image in '{}': '{}'", filepath, stbi_failure_reason());
+		return false;
+	}
+
+	if (size != spec.size || contents.decoded_mips.size() != spec.mip_levels) {
+		SNK_CORE_ERROR("DecodeLegacyTexture2D failed, image in '{}' is {}x{} but the header says {}x{} with {} mips", filepath, size.x, size.y, spec.size.x, spec.size.y, spec.mip_levels);
+		contents.decoded_mips.clear();
+		return false;
+	}
+
+	contents.mips.assign(contents.decoded_mips.begin(), contents.decoded_mips.end());
+	return true;
+}
+
+Image2DSpec AssetLoader::CreateTextureSpec(vk::Format format, glm::uvec2 size, uint32_t mip_levels) {
+	Image2DSpec spec;
+	spec.format = format;
+	spec.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc;
+	spec.size = size;
+	spec.tiling = vk::ImageTiling::eOptimal;
+	spec.aspect_flags = vk::ImageAspectFlagBits::eColor;
+	spec.mip_levels = mip_levels;
+	return spec;
+}
+
+std::vector<std::vector<std::byte>> AssetLoader::DecodeTextureMips(const std::vector<std::byte>& raw_file_data, TextureEncoder::Usage usage, glm::uvec2& size) {
+	int width, height, channels;
+	// Force 4 channels as most GPUs only support these as samplers
+	stbi_uc* p_pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(raw_file_data.data()), (int)raw_file_data.size(), &width, &height, &channels, 4);
+	if (!p_pixels)
+		return {};
+
+	size = glm::uvec2(width, height);
+	auto* p_rgba = reinterpret_cast<const std::byte*>(p_pixels);
+
+	std::vector<std::vector<std::byte>> mips;
+	mips.emplace_back(p_rgba, p_rgba + (size_t)width * height * 4);
+	std::ranges::move(TextureEncoder::GenerateMips(p_rgba, width, height, usage), std::back_inserter(mips));
+
+	stbi_image_free(p_pixels);
+	return mips;
+}
+
+bool AssetLoader::IsLegacyTexture2DFile(MappedFile& file) {
+	return file.size() < sizeof(Texture2DFileHeader) || std::memcmp(file.data(), Texture2DFileHeader::MAGIC.data(), Texture2DFileHeader::MAGIC.size()) != 0;
+}
+
+bool AssetLoader::ReadTexture2DFile(const std::string& filepath, uint64_t& uuid, std::string& name, Image2DSpec& spec, Texture2DFileContents* p_contents) {
 	SNK_ASSERT(filepath.ends_with(".tex2d"));
-	std::vector<std::byte> data;
-	files::ReadBinaryFile(filepath, data);
 
-	if (data.empty()) {
+	auto p_file = std::make_unique<MappedFile>();
+	if (!p_file->Open(filepath) || p_file->size() == 0) {
 		SNK_CORE_ERROR("DeserializeTexture2D failed, binary data failed to load from file '{}'", filepath);
-		return nullptr;
+		return false;
 	}
 
-	Image2DSpec spec;
 	spec.aspect_flags = vk::ImageAspectFlagBits::eColor;
 	spec.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eSampled;
 	spec.tiling = vk::ImageTiling::eOptimal;
 
-	ByteDeserializer d{ data.data(), data.size() };
-	uint64_t uuid;
-	d.Value(uuid);
-	auto& asset = *AssetManager::CreateAsset<Texture2DAsset>(uuid).get();
-	asset.filepath = filepath;
-	d.Container(asset.name);
-	asset.uuid = UUID<uint64_t>(uuid);
-	d.Value(spec.format);
-	d.Value(spec.mip_levels);
-	d.Value(spec.size);
+	if (IsLegacyTexture2DFile(*p_file)) {
+		ByteDeserializer d{ p_file->data(), p_file->size() };
+		d.Value(uuid);
+		d.Container(name);
+		d.Value(spec.format);
+		d.Value(spec.mip_levels);
+		d.Value(spec.size);
+
+		if (p_contents) {
+			d.Container(p_contents->raw_file_data);
+			p_contents->content_hash = CalculateTextureContentHash(p_contents->raw_file_data, spec.format);
+		}
 
-	std::vector<std::byte> raw_file_data;
-	d.Container(raw_file_data);
-	SNK_CORE_INFO(raw_file_data.size());
+		return true;
+	}
+
+	Texture2DFileHeader header;
+	std::memcpy(&header, p_file->data(), sizeof(Texture2DFileHeader));
 
-	int x, y, channels;
-	auto pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(raw_file_data.data()), (int)raw_file_data.size(), &x, &y, &channels, 4);
-	if (!pixels) 
-		SNK_CORE_ERROR("DeserializeTexture2D failed, stbi load failed '{}'", stbi_failure_reason());
+	if (header.version > Texture2DFileHeader::VERSION) {
+		SNK_CORE_ERROR("DeserializeTexture2D failed, '{}' is format version {} but the newest supported is {}", filepath, header.version, Texture2DFileHeader::VERSION);
+		return false;
+	}
 
-	size_t image_size = x * y * 4;
+	uint64_t name_offset = sizeof(Texture2DFileHeader) + (uint64_t)header.mip_levels * sizeof(Texture2DFileMip);
+	if (header.mip_levels == 0 || header.mip_levels > TextureEncoder::GetNumMips(header.size.x, header.size.y) || name_offset + header.name_size > p_file->size()) {
+		SNK_CORE_ERROR("DeserializeTexture2D failed, '{}' is truncated or has an invalid header", filepath);
+		return false;
+	}
 
-	S_VkBuffer staging_buffer{};
-	staging_buffer.CreateBuffer(image_size, vk::BufferUsageFlagBits::eTransferSrc, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
-	void* p_data = staging_buffer.Map();
-	memcpy(p_data, pixels, (size_t)image_size);
-	staging_buffer.Unmap();
-	delete[] pixels;
+	// Mip sizes and the image are derived from the format, so one the encoder never writes can't be trusted
+	if (!TextureEncoder::IsSelectableFormat(header.format)) {
+		SNK_CORE_ERROR("DeserializeTexture2D failed, '{}' has unsupported format {}", filepath, (uint32_t)header.format);
+		return false;
+	}
 
-	asset.image.SetSpec(spec);
-	asset.image.CreateImage();
+	uuid = header.uuid;
+	name.assign(reinterpret_cast<const char*>(p_file->data() + name_offset), header.name_size);
+	spec.format = header.format;
+	spec.mip_levels = header.mip_levels;
+	spec.size = header.size;
+
+	if (!p_contents)
+		return true;
+
+	p_contents->content_hash = header.content_hash;
+	p_contents->mips.clear();
+	for (uint32_t i = 0; i < header.mip_levels; i++) {
+		Texture2DFileMip mip;
+		std::memcpy(&mip, p_file->data() + sizeof(Texture2DFileHeader) + i * sizeof(Texture2DFileMip), sizeof(Texture2DFileMip));
+
+		uint64_t expected_size = TextureEncoder::GetMipSize(header.format, glm::max(header.size.x >> i, 1u), glm::max(header.size.y >> i, 1u));
+		if (mip.offset > p_file->size() || mip.size > p_file->size() - mip.offset || mip.size != expected_size) {
+			SNK_CORE_ERROR("DeserializeTexture2D failed, '{}' has an invalid mip {} (offset {}, size {})", filepath, i, mip.offset, mip.size);
+			return false;
+		}
 
-	asset.image.TransitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 0, spec.mip_levels);
-	CopyBufferToImage(staging_buffer.buffer, asset.image.GetImage(), spec.size.x, spec.size.y);
-	asset.image.GenerateMipmaps(vk::ImageLayout::eTransferDstOptimal);
-	asset.image.TransitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, 0, spec.mip_levels);
+		p_contents->mips.emplace_back(p_file->data() + mip.offset, mip.size);
+	}
 
-	AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(&asset);
-	return &asset;
+	p_contents->p_file = std::move(p_file);
+	return true;
 }
 
 void AssetLoader::SerializeMaterialBinary(const std::string& output_filepath, MaterialAsset& asset) {
 	SNK_ASSERT(output_filepath.ends_with(".mat"));
-	asset.filepath = output_filepath;
+	AssetManager::SetFilepath(&asset, output_filepath);
+
+	MaterialFileContents contents;
+	contents.name = asset.name;
+	contents.albedo = asset.albedo;
+	contents.emissive = asset.emissive;
+	contents.roughness = asset.roughness;
+	contents.metallic = asset.metallic;
+	contents.ao = asset.ao;
+
+	auto get_uuid = [](const AssetRef<Texture2DAsset>& tex) {
+		return tex ? tex->uuid() : UUID<uint64_t>::INVALID_UUID;
+	};
+
+	contents.texture_uuids = { get_uuid(asset.albedo_tex), get_uuid(asset.normal_tex), get_uuid(asset.roughness_tex), get_uuid(asset.metallic_tex), get_uuid(asset.ao_tex) };
+	WriteMaterialFile(output_filepath, asset.uuid(), contents);
+}
+
+void AssetLoader::WriteMaterialFile(const std::string& output_filepath, uint64_t uuid, const MaterialFileContents& contents) {
+	SNK_ASSERT(output_filepath.ends_with(".mat"));
 	ByteSerializer ser;
-	ser.Value(asset.uuid());
-	ser.Container(asset.name);
-	ser.Value(asset.albedo);
-	ser.Value(asset.emissive);
-	ser.Value(asset.roughness);
-	ser.Value(asset.metallic);
-	ser.Value(asset.ao);
-	ser.Value(asset.albedo_tex ? asset.albedo_tex->uuid() : UUID<uint64_t>::INVALID_UUID);
-	ser.Value(asset.normal_tex ? asset.normal_tex->uuid() : UUID<uint64_t>::INVALID_UUID);
-	ser.Value(asset.roughness_tex ? asset.roughness_tex->uuid() : UUID<uint64_t>::INVALID_UUID);
-	ser.Value(asset.metallic_tex ? asset.metallic_tex->uuid() : UUID<uint64_t>::INVALID_UUID);
-	ser.Value(asset.ao_tex ? asset.ao_tex->uuid() : UUID<uint64_t>::INVALID_UUID);
+	ser.Value(uuid);
+	ser.Container(contents.name);
+	ser.Value(contents.albedo);
+	ser.Value(contents.emissive);
+	ser.Value(contents.roughness);
+	ser.Value(contents.metallic);
+	ser.Value(contents.ao);
+
+	for (auto tex_uuid : contents.texture_uuids) {
+		ser.Value(tex_uuid);
+	}
+
 	ser.OutputToFile(output_filepath);
 }
 
-void AssetLoader::SerializeMeshDataBinary(const std::string& output_filepath, const MeshData& data, MeshDataAsset& asset) {
+void AssetLoader::SerializeMeshDataBinary(const std::string& output_filepath, const MeshData& data, MeshDataAsset& asset, bool compress) {
 	SNK_ASSERT(output_filepath.ends_with(".meshdata"));
-	asset.filepath = output_filepath;
-	ByteSerializer s;
-	s.Value(asset.uuid());
-	s.Container(asset.name);
-	s.Container(data.submeshes);
-	s.Value(data.num_vertices);
-	s.Value(data.num_indices);
-
-	s.Value(reinterpret_cast<const std::byte*>(data.positions), data.num_vertices * sizeof(aiVector3D));
-	s.Value(reinterpret_cast<const std::byte*>(data.normals), data.num_vertices * sizeof(aiVector3D));
-	s.Value(reinterpret_cast<const std::byte*>(data.tangents), data.num_vertices * sizeof(aiVector3D));
-	s.Value(reinterpret_cast<const std::byte*>(data.tex_coords), data.num_vertices * sizeof(aiVector2D));
-	s.Value(reinterpret_cast<const std::byte*>(data.indices), data.num_indices * sizeof(unsigned));
-	
-	s.Container(data.materials);
-	s.Container(data.textures);
-	s.OutputToFile(output_filepath);
+	AssetManager::SetFilepath(&asset, output_filepath);
+	WriteMeshDataFile(output_filepath, data, asset.uuid(), asset.name, compress);
 }
 
+void AssetLoader::WriteMeshDataFile(const std::string& output_filepath, const MeshData& data, uint64_t uuid, const std::string& name, bool compress) {
+	SNK_ASSERT(output_filepath.ends_with(".meshdata"));
+
+	ByteSerializer metadata;
+	metadata.Container(name);
+	metadata.Container(data.submeshes);
+	metadata.Value(data.num_vertices);
+	metadata.Value(data.num_indices);
+	metadata.Container(data.materials);
+	metadata.Container(data.textures);
+
+	metadata.Value((uint32_t)data.lods.size());
+	for (auto& lod : data.lods) {
+		metadata.Value(lod.error);
+		metadata.Container(lod.submeshes);
+	}
+
+	struct SectionData {
+		MeshDataSectionType type;
+		const void* p_data;
+		size_t size;
+		uint32_t flags = 0;
+
+		std::vector<std::byte> compressed;
+	};
+
+	std::array<SectionData, 8> sections{ {
+		{ MeshDataSectionType::METADATA, metadata.data(), metadata.size() },
+		{ MeshDataSectionType::POSITIONS, data.positions, data.num_vertices * sizeof(aiVector3D) },
+		{ MeshDataSectionType::NORMALS, data.normals, data.num_vertices * sizeof(aiVector3D) },
+		{ MeshDataSectionType::TANGENTS, data.tangents, data.num_vertices * sizeof(aiVector3D) },
+		{ MeshDataSectionType::TEX_COORDS, data.tex_coords, data.num_vertices * sizeof(aiVector2D) },
+		{ MeshDataSectionType::INDICES, data.indices, data.num_indices * sizeof(unsigned) },
+		{ MeshDataSectionType::MESHLETS, data.meshlets.data(), data.meshlets.size() * sizeof(Meshlet) },
+		{ MeshDataSectionType::SUBMESH_MESHLETS, data.submesh_meshlets.data(), data.submesh_meshlets.size() * sizeof(SubmeshMeshlets) },
+	} };
+
+	// Compressed sections are decompressed into a heap buffer before staging instead of being staged from the mapping, so they're only kept if the disk read saved is worth it
+	// Metadata is tiny and read on the calling thread before anything else, so it's never compressed
+	constexpr size_t MIN_COMPRESSED_SECTION_SIZE = 16 * 1024;
+	if (compress) {
+		for (auto& section : sections) {
+			if (section.type == MeshDataSectionType::METADATA || section.size < MIN_COMPRESSED_SECTION_SIZE)
+				continue;
+
+			auto compressed = Compression::CompressChunked(reinterpret_cast<const std::byte*>(section.p_data), section.size);
+			if (compressed.size() > section.size - section.size / 8)
+				continue;
+
+			section.compressed = std::move(compressed);
+			section.p_data = section.compressed.data();
+			section.size = section.compressed.size();
+			section.flags |= MeshDataFileSection::COMPRESSED;
+		}
+	}
+
+	MeshDataFileHeader header;
+	header.num_sections = (uint32_t)sections.size();
+	header.uuid = uuid;
+
+	std::vector<MeshDataFileSection> table;
+	uint64_t offset = aligned_size(sizeof(MeshDataFileHeader) + sections.size() * sizeof(MeshDataFileSection), MeshDataFileHeader::SECTION_ALIGNMENT);
+	for (auto& section : sections) {
+		table.push_back(MeshDataFileSection{ .type = section.type, .flags = section.flags, .offset = offset, .size = section.size });
+		offset = aligned_size(offset + section.size, MeshDataFileHeader::SECTION_ALIGNMENT);
+	}
+
+	// Zero initialised so alignment padding is deterministic
+	std::vector<std::byte> file(offset);
+	std::memcpy(file.data(), &header, sizeof(MeshDataFileHeader));
+	std::memcpy(file.data() + sizeof(MeshDataFileHeader), table.data(), table.size() * sizeof(MeshDataFileSection));
+	for (size_t i = 0; i < sections.size(); i++) {
+		if (sections[i].size > 0)
+			std::memcpy(file.data() + table[i].offset, sections[i].p_data, sections[i].size);
+	}
+
+	files::WriteBinaryFile(output_filepath, file.data(), file.size());
+}
+
+bool AssetLoader::IsLegacyMeshDataFile(MappedFile& file) {
+	return file.size() < sizeof(MeshDataFileHeader) || std::memcmp(file.data(), MeshDataFileHeader::MAGIC.data(), MeshDataFileHeader::MAGIC.size()) != 0;
+}
+
+bool AssetLoader::ReadMeshDataFile(std::unique_ptr<MappedFile> p_file, const std::string& filepath, MeshData& data, uint64_t& uuid, std::string& name, bool metadata_only) {
+	MeshDataFileHeader header;
+	std::memcpy(&header, p_file->data(), sizeof(MeshDataFileHeader));
+
+	if (header.version > MeshDataFileHeader::VERSION) {
+		SNK_CORE_ERROR("DeserializeMeshData failed, '{}' is format version {} but the newest supported is {}", filepath, header.version, MeshDataFileHeader::VERSION);
+		return false;
+	}
+
+	uint64_t table_end = sizeof(MeshDataFileHeader) + (uint64_t)header.num_sections * sizeof(MeshDataFileSection);
+	if (table_end > p_file->size()) {
+		SNK_CORE_ERROR("DeserializeMeshData failed, '{}' is truncated", filepath);
+		return false;
+	}
+
+	struct SectionView {
+		// Stored bytes in the mapping
+		std::span<std::byte> stored;
+		bool is_compressed = false;
+
+		// Equal to stored.size() unless compressed
+		uint64_t size = 0;
+	};
+
+	std::array<SectionView, (size_t)MeshDataSectionType::NUM_TYPES> sections;
+	for (uint32_t i = 0; i < header.num_sections; i++) {
+		MeshDataFileSection section;
+		std::memcpy(&section, p_file->data() + sizeof(MeshDataFileHeader) + i * sizeof(MeshDataFileSection), sizeof(MeshDataFileSection));
+
+		if (section.offset < table_end || section.offset > p_file->size() || section.size > p_file->size() - section.offset ||
+			section.offset % MeshDataFileHeader::SECTION_ALIGNMENT != 0) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' has an invalid section (type {}, offset {}, size {})", filepath, (uint32_t)section.type, section.offset, section.size);
+			return false;
+		}
+
+		if (section.type >= MeshDataSectionType::NUM_TYPES)
+			continue;
+
+		auto& view = sections[(size_t)section.type];
+		view.stored = std::span(p_file->data() + section.offset, section.size);
+		view.is_compressed = section.flags & MeshDataFileSection::COMPRESSED;
+		view.size = view.is_compressed ? Compression::GetChunkedUncompressedSize(view.stored.data(), view.stored.size()) : view.stored.size();
+
+		// LZ4 can't expand data more than 255x, anything larger is corrupt and shouldn't be allocated
+		if (view.is_compressed && view.size / 255 > view.stored.size()) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' section {} has an invalid uncompressed size {}", filepath, (uint32_t)section.type, view.size);
+			return false;
+		}
+	}
+
+	// Decompresses straight into p_output, which must be at least sections[type].size bytes
+	auto decompress_section = [&](MeshDataSectionType type, std::byte* p_output) {
+		auto& section = sections[(size_t)type];
+		if (!Compression::DecompressChunked(section.stored.data(), section.stored.size(), p_output, section.size)) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' section {} is corrupt", filepath, (uint32_t)type);
+			return false;
+		}
+
+		return true;
+	};
+
+	auto& metadata = sections[(size_t)MeshDataSectionType::METADATA];
+	if (metadata.size == 0) {
+		SNK_CORE_ERROR("DeserializeMeshData failed, '{}' has no metadata section", filepath);
+		return false;
+	}
+
+	std::vector<std::byte> decompressed_metadata;
+	std::span<std::byte> metadata_bytes = metadata.stored;
+	if (metadata.is_compressed) {
+		decompressed_metadata.resize(metadata.size);
+		if (!decompress_section(MeshDataSectionType::METADATA, decompressed_metadata.data()))
+			return false;
+
+		metadata_bytes = decompressed_metadata;
+	}
+
+	ByteDeserializer d{ metadata_bytes.data(), metadata_bytes.size() };
+	d.Container(name);
+	d.Container(data.submeshes);
+	d.Value(data.num_vertices);
+	d.Value(data.num_indices);
+	d.Container(data.materials);
+	d.Container(data.textures);
+
+	uint32_t num_lods;
+	d.Value(num_lods);
+	data.lods.resize(num_lods);
+	for (auto& lod : data.lods) {
+		d.Value(lod.error);
+		d.Container(lod.submeshes);
+	}
+
+	uuid = header.uuid;
+	if (metadata_only)
+		return true;
+
+	// Uncompressed streams are used in place, the mapping is owned by 'data' from here
+	auto get_stream = [&]<typename T>(MeshDataSectionType type, T*& p_output, size_t count) {
+		auto& section = sections[(size_t)type];
+		if (section.size != count * sizeof(T)) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' section {} is {} bytes, expected {}", filepath, (uint32_t)type, section.size, count * sizeof(T));
+			return false;
+		}
+
+		if (!section.is_compressed) {
+			p_output = reinterpret_cast<T*>(section.stored.data());
+			return true;
+		}
+
+		auto& p_buffer = data.decompressed_sections.emplace_back(std::make_unique_for_overwrite<std::byte[]>(section.size));
+		p_output = reinterpret_cast<T*>(p_buffer.get());
+		return decompress_section(type, p_buffer.get());
+	};
+
+	data.p_mapped_file = std::move(p_file);
+
+	if (!get_stream(MeshDataSectionType::POSITIONS, data.positions, data.num_vertices) || !get_stream(MeshDataSectionType::NORMALS, data.normals, data.num_vertices) ||
+		!get_stream(MeshDataSectionType::TANGENTS, data.tangents, data.num_vertices) || !get_stream(MeshDataSectionType::TEX_COORDS, data.tex_coords, data.num_vertices) ||
+		!get_stream(MeshDataSectionType::INDICES, data.indices, data.num_indices))
+		return false;
+
+	// Copied or decompressed into the vectors
+	auto read_section = [&](MeshDataSectionType type, void* p_output) {
+		auto& section = sections[(size_t)type];
+		if (section.is_compressed)
+			return decompress_section(type, reinterpret_cast<std::byte*>(p_output));
+
+		std::memcpy(p_output, section.stored.data(), section.size);
+		return true;
+	};
+
+	if (!ValidateMeshDataRanges(data, filepath))
+		return false;
+
+	auto& meshlets = sections[(size_t)MeshDataSectionType::MESHLETS];
+	auto& submesh_meshlets = sections[(size_t)MeshDataSectionType::SUBMESH_MESHLETS];
+	if (meshlets.size > 0 && meshlets.size % sizeof(Meshlet) == 0 && submesh_meshlets.size == data.submeshes.size() * sizeof(SubmeshMeshlets)) {
+		data.meshlets.resize(meshlets.size / sizeof(Meshlet));
+		data.submesh_meshlets.resize(data.submeshes.size());
+
+		if (!read_section(MeshDataSectionType::MESHLETS, data.meshlets.data()) || !read_section(MeshDataSectionType::SUBMESH_MESHLETS, data.submesh_meshlets.data()))
+			return false;
+
+		return ValidateMeshlets(data, filepath);
+	}
+
+	MeshletBuilder::BuildMeshlets(data);
+	return true;
+}
+
+bool AssetLoader::ReadLegacyMeshDataFile(const std::string& filepath, MeshData& data, uint64_t& uuid, std::string& name) {
+	std::vector<std::byte> file;
+	files::ReadBinaryFile(filepath, file);
+	if (file.empty()) {
+		SNK_CORE_ERROR("DeserializeMeshData failed, reading filepath '{}' gave no data", filepath);
+		return false;
+	}
+
+	ByteDeserializer d{ file.data(), file.size() };
+	d.Value(uuid);
+	d.Container(name);
+	d.Container(data.submeshes);
+	d.Value(data.num_vertices);
+	d.Value(data.num_indices);
+
+	d.Value(data.positions, 0);
+	d.Value(data.normals, 0);
+	d.Value(data.tangents, 0);
+	d.Value(data.tex_coords, 0);
+	d.Value(data.indices, 0);
+
+	d.Container(data.materials);
+	d.Container(data.textures);
+
+	// Files serialized before LODs were generated end here, they load with full detail only
+	if (!d.AtEnd()) {
+		uint32_t num_lods;
+		d.Value(num_lods);
+		data.lods.resize(num_lods);
+		for (auto& lod : data.lods) {
+			d.Value(lod.error);
+			d.Container(lod.submeshes);
+		}
+	}
+
+	if (!ValidateMeshDataRanges(data, filepath))
+		return false;
+
+	// Meshlets only index existing data, so files serialized before they were stored have them built on load
+	if (!d.AtEnd()) {
+		d.Container(data.meshlets);
+		d.Container(data.submesh_meshlets);
+		return ValidateMeshlets(data, filepath);
+	}
+
+	MeshletBuilder::BuildMeshlets(data);
+	return true;
+}
+
+bool AssetLoader::ValidateMeshDataRanges(const MeshData& data, const std::string& filepath) {
+	for (size_t i = 0; i < data.submeshes.size(); i++) {
+		auto& submesh = data.submeshes[i];
+		if ((uint64_t)submesh.base_vertex + submesh.num_vertices > data.num_vertices || (uint64_t)submesh.base_index + submesh.num_indices > data.num_indices) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' submesh {} is out of range", filepath, i);
+			return false;
+		}
+
+		// Indices are local to the submesh's base_vertex
+		for (unsigned j = submesh.base_index; j < submesh.base_index + submesh.num_indices; j++) {
+			if (data.indices[j] >= submesh.num_vertices) {
+				SNK_CORE_ERROR("DeserializeMeshData failed, '{}' submesh {} has index {} out of range", filepath, i, data.indices[j]);
+				return false;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < data.lods.size(); i++) {
+		auto& lod = data.lods[i];
+		if (lod.submeshes.size() != data.submeshes.size()) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' LOD {} has {} submeshes, expected {}", filepath, i + 1, lod.submeshes.size(), data.submeshes.size());
+			return false;
+		}
+
+		for (size_t j = 0; j < lod.submeshes.size(); j++) {
+			auto& lod_submesh = lod.submeshes[j];
+			if ((uint64_t)lod_submesh.base_index + lod_submesh.num_indices > data.num_indices) {
+				SNK_CORE_ERROR("DeserializeMeshData failed, '{}' LOD {} submesh {} is out of range", filepath, i + 1, j);
+				return false;
+			}
+
+			for (unsigned k = lod_submesh.base_index; k < lod_submesh.base_index + lod_submesh.num_indices; k++) {
+				if (data.indices[k] >= data.submeshes[j].num_vertices) {
+					SNK_CORE_ERROR("DeserializeMeshData failed, '{}' LOD {} submesh {} has index {} out of range", filepath, i + 1, j, data.indices[k]);
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool AssetLoader::ValidateMeshlets(const MeshData& data, const std::string& filepath) {
+	if (data.submesh_meshlets.size() != data.submeshes.size()) {
+		SNK_CORE_ERROR("DeserializeMeshData failed, '{}' has meshlet ranges for {} submeshes, expected {}", filepath, data.submesh_meshlets.size(), data.submeshes.size());
+		return false;
+	}
+
+	for (size_t i = 0; i < data.submesh_meshlets.size(); i++) {
+		auto& range = data.submesh_meshlets[i];
+		if ((uint64_t)range.first_meshlet + range.num_meshlets > data.meshlets.size()) {
+			SNK_CORE_ERROR("DeserializeMeshData failed, '{}' submesh {} meshlet range is out of range", filepath, i);
+			return false;
+		}
+
+		// Meshlets are runs of their submesh's full detail indices, which are already known to be in range
+		auto& submesh = data.submeshes[i];
+		for (uint32_t j = range.first_meshlet; j < range.first_meshlet + range.num_meshlets; j++) {
+			auto& meshlet = data.meshlets[j];
+			if (meshlet.submesh_idx != i || meshlet.base_index < submesh.base_index ||
+				(uint64_t)meshlet.base_index + meshlet.num_indices > (uint64_t)submesh.base_index + submesh.num_indices) {
+				SNK_CORE_ERROR("DeserializeMeshData failed, '{}' meshlet {} is out of range", filepath, j);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
 
 MeshDataAsset* AssetLoader::DeserializeMeshData(const std::string& filepath) {
 	SNK_ASSERT(filepath.ends_with(".meshdata"));
-	std::vector<std::byte> data;
-	files::ReadBinaryFile(filepath, data);
-	if (data.empty()) {
-		SNK_CORE_ERROR("DeserializeMeshData failed, reading filepath '{}' gave no data", filepath);
+
+	auto p_file = std::make_unique<MappedFile>();
+	if (!p_file->Open(filepath)) {
+		SNK_CORE_ERROR("DeserializeMeshData failed, couldn't map '{}'", filepath);
 		return nullptr;
 	}
-	ByteDeserializer d{ data.data(), data.size() };
 
 	MeshData mesh_data;
 	uint64_t uuid;
-	d.Value(uuid);
-	auto& asset = *AssetManager::CreateAsset<MeshDataAsset>(uuid).get();
-	asset.uuid = UUID(uuid);
-	asset.filepath = filepath;
+	std::string name;
 
-	d.Container(asset.name);
-	d.Container(mesh_data.submeshes);
-	d.Value(mesh_data.num_vertices);
-	d.Value(mesh_data.num_indices);
+	bool is_legacy = IsLegacyMeshDataFile(*p_file);
 
-	d.Value(mesh_data.positions, 0);
-	d.Value(mesh_data.normals, 0);
-	d.Value(mesh_data.tangents, 0);
-	d.Value(mesh_data.tex_coords, 0);
-	d.Value(mesh_data.indices, 0);
+	if (is_legacy) {
+		// Unmapped first so the file can be rewritten in the current format
+		p_file->Close();
+		if (!ReadLegacyMeshDataFile(filepath, mesh_data, uuid, name))
+			return nullptr;
+	}
+	else if (!ReadMeshDataFile(std::move(p_file), filepath, mesh_data, uuid, name)) {
+		return nullptr;
+	}
 
-	d.Container(mesh_data.materials);
-	d.Container(mesh_data.textures);
+	auto& asset = *AssetManager::CreateAsset<MeshDataAsset>(uuid).get();
+	asset.uuid = UUID(uuid);
+	AssetManager::SetFilepath(&asset, filepath);
+	asset.name = std::move(name);
 
-	for (size_t i = 0; i < mesh_data.materials.size(); i++) {
-		auto mat = AssetManager::GetAsset<MaterialAsset>(mesh_data.materials[i]);
-		if (!mat) {
-			SNK_CORE_ERROR("Tried loading material '{}' in DeserializeMeshData, UUID not found", mesh_data.materials[i]);
-			mat = AssetManager::GetAsset<MaterialAsset>(AssetManager::CoreAssetIDs::MATERIAL);
-		}
+	// Materials are resolved by LoadMeshFromData
+	AssetManager::Get().mesh_buffer_manager.LoadMeshFromData(&asset, mesh_data);
 
-		asset.materials.push_back(mat);
+	if (is_legacy) {
+		SerializeMeshDataBinary(filepath, mesh_data, asset);
+		SNK_CORE_INFO("Migrated '{}' to .meshdata format version {}", filepath, MeshDataFileHeader::VERSION);
 	}
 
-	AssetManager::Get().mesh_buffer_manager.LoadMeshFromData(&asset, mesh_data);
 	return &asset;
 }
 
 
 MaterialAsset* AssetLoader::DeserializeMaterial(const std::string& filepath) {
+	uint64_t uuid;
+	MaterialFileContents contents;
+	if (!ReadMaterialFile(filepath, uuid, contents))
+		return nullptr;
+
+	auto& asset = *AssetManager::CreateAsset<MaterialAsset>(uuid).get();
+	asset.uuid = UUID(uuid);
+	AssetManager::SetFilepath(&asset, filepath);
+
+	ApplyMaterialFileContents(asset, contents);
+	asset.DispatchUpdateEvent();
+	return &asset;
+}
+
+bool AssetLoader::ReadMaterialFile(const std::string& filepath, uint64_t& uuid, MaterialFileContents& contents) {
 	SNK_ASSERT(filepath.ends_with(".mat"));
 	std::vector<std::byte> data;
 	files::ReadBinaryFile(filepath, data);
 	if (data.empty()) {
-		SNK_CORE_ERROR("DeserializeMaterial failed, reading filepath '{}' gave no data", filepath);
-		return nullptr;
+		SNK_CORE_ERROR("ReadMaterialFile failed, reading filepath '{}' gave no data", filepath);
+		return false;
 	}
 
 	ByteDeserializer d{ data.data(), data.size() };
-
-	size_t uuid;
 	d.Value(uuid);
-	auto& asset = *AssetManager::CreateAsset<MaterialAsset>(uuid).get();
-	asset.uuid = UUID(uuid);
-	asset.filepath = filepath;
-
-	d.Container(asset.name);
-	d.Value(asset.albedo);
-	d.Value(asset.emissive);
-	d.Value(asset.roughness);
-	d.Value(asset.metallic);
-	d.Value(asset.ao);
-	std::array<uint64_t, 5> texture_uuids;
-
-	d.Value(texture_uuids[0]);
-	d.Value(texture_uuids[1]);
-	d.Value(texture_uuids[2]);
-	d.Value(texture_uuids[3]);
-	d.Value(texture_uuids[4]);
-
-	asset.albedo_tex = texture_uuids[0] == UUID<uint64_t>::INVALID_UUID ? nullptr : AssetManager::GetAsset<Texture2DAsset>(texture_uuids[0]);
-	asset.normal_tex = texture_uuids[1] == UUID<uint64_t>::INVALID_UUID ? nullptr : AssetManager::GetAsset<Texture2DAsset>(texture_uuids[1]);
-	asset.roughness_tex = texture_uuids[2] == UUID<uint64_t>::INVALID_UUID ? nullptr : AssetManager::GetAsset<Texture2DAsset>(texture_uuids[2]);
-	asset.metallic_tex = texture_uuids[3] == UUID<uint64_t>::INVALID_UUID ? nullptr : AssetManager::GetAsset<Texture2DAsset>(texture_uuids[3]);
-	asset.ao_tex = texture_uuids[4] == UUID<uint64_t>::INVALID_UUID ? nullptr : AssetManager::GetAsset<Texture2DAsset>(texture_uuids[4]);
+	d.Container(contents.name);
+	d.Value(contents.albedo);
+	d.Value(contents.emissive);
+	d.Value(contents.roughness);
+	d.Value(contents.metallic);
+	d.Value(contents.ao);
+
+	for (auto& tex_uuid : contents.texture_uuids) {
+		d.Value(tex_uuid);
+	}
 
-	asset.DispatchUpdateEvent();
-	return &asset;
+	return true;
+}
+
+void AssetLoader::ApplyMaterialFileContents(MaterialAsset& asset, const MaterialFileContents& contents) {
+	asset.name = contents.name;
+	asset.albedo = contents.albedo;
+	asset.emissive = contents.emissive;
+	asset.roughness = contents.roughness;
+	asset.metallic = contents.metallic;
+	asset.ao = contents.ao;
+
+	auto get_texture = [](uint64_t tex_uuid) {
+		return tex_uuid == UUID<uint64_t>::INVALID_UUID ? nullptr : AssetManager::GetAsset<Texture2DAsset>(tex_uuid);
+	};
+
+	asset.albedo_tex = get_texture(contents.texture_uuids[0]);
+	asset.normal_tex = get_texture(contents.texture_uuids[1]);
+	asset.roughness_tex = get_texture(contents.texture_uuids[2]);
+	asset.metallic_tex = get_texture(contents.texture_uuids[3]);
+	asset.ao_tex = get_texture(contents.texture_uuids[4]);
 }
 
 
@@ -273,7 +856,7 @@ StaticMeshAsset* AssetLoader::DeserializeStaticMeshAsset(const std::string& inpu
 	nlohmann::json j = nlohmann::json::parse(content);
 	try {
 		auto asset = AssetManager::CreateAsset<StaticMeshAsset>(j.at("UUID").template get<uint64_t>());
-		asset->filepath = input_filepath;
+		AssetManager::SetFilepath(asset.get(), input_filepath);
 		uint64_t data_uuid = j.at("DataUUID").template get<uint64_t>();
 		asset->data = AssetManager::GetAsset<MeshDataAsset>(data_uuid);
 
@@ -292,49 +875,300 @@ StaticMeshAsset* AssetLoader::DeserializeStaticMeshAsset(const std::string& inpu
 	}
 }
 
-bool AssetLoader::LoadTextureFromFile(AssetRef<Texture2DAsset> tex, vk::Format fmt) {
-	int width, height, channels;
-	// Force 4 channels as most GPUs only support these as samplers
-	stbi_uc* pixels = stbi_load(tex->filepath.c_str(), &width, &height, &channels, 4);
+bool AssetLoader::LoadTextureFromFile(AssetRef<Texture2DAsset> tex, TextureEncoder::Usage usage) {
+	auto p_load = BeginTextureLoadFromFile(tex, usage);
+	return EndTextureLoad(*p_load);
+}
+
+std::unique_ptr<AssetLoader::PendingTextureLoad> AssetLoader::BeginTextureLoadFromFile(AssetRef<Texture2DAsset> tex, TextureEncoder::Usage usage) {
+	auto p_load = std::make_unique<PendingTextureLoad>();
+	p_load->tex = tex;
+	p_load->filepath = tex->filepath;
+	p_load->usage = usage;
+
+	// Owned by the caller, which can't destroy it before EndTextureLoad has waited on the job
+	p_load->p_job = JobSystem::CreateWaitedOnJob();
+	p_load->p_job->func = [p_load = p_load.get()]([[maybe_unused]] Job const* p_this) {
+		std::vector<std::byte> raw_file_data;
+		if (!files::ReadBinaryFile(p_load->filepath, raw_file_data)) {
+			p_load->p_failure_reason = "couldn't read the file";
+			return;
+		}
+
+		// Filtered on the CPU rather than blitted, so colour is averaged in linear space and normals stay unit length
+		p_load->content_hash = CalculateTextureContentHash(raw_file_data, TextureEncoder::GetSourceFormat(p_load->usage));
+		p_load->mips = DecodeTextureMips(raw_file_data, p_load->usage, p_load->size);
+		if (p_load->mips.empty())
+			p_load->p_failure_reason = stbi_failure_reason();
+	};
+
+	JobSystem::Execute(p_load->p_job);
+	return p_load;
+}
+
+bool AssetLoader::EndTextureLoad(PendingTextureLoad& load) {
+	JobSystem::WaitOn(load.p_job);
+	load.p_job = nullptr;
 
-	if (!pixels) {
+	if (load.mips.empty()) {
+		SNK_CORE_ERROR("LoadTextureFromFile failed for '{}': '{}'", load.filepath, load.p_failure_reason);
 		return false;
 	}
-	vk::DeviceSize image_size = width * height * 4;
 
-	S_VkBuffer staging_buffer{};
-	staging_buffer.CreateBuffer(image_size, vk::BufferUsageFlagBits::eTransferSrc, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
-	void* p_data = staging_buffer.Map();
-	memcpy(p_data, pixels, (size_t)image_size);
-	staging_buffer.Unmap();
+	auto& tex = *load.tex.get();
+	tex.image.SetSpec(CreateTextureSpec(TextureEncoder::GetSourceFormat(load.usage), load.size, (uint32_t)load.mips.size()));
+	tex.image.CreateImage();
 
-	stbi_image_free(pixels);
+	Texture2DFileContents contents;
+	contents.mips.assign(load.mips.begin(), load.mips.end());
 
-	Image2DSpec spec;
-	spec.format = fmt;
-	spec.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc;
-	spec.size.x = width;
-	spec.size.y = height;
-	spec.tiling = vk::ImageTiling::eOptimal;
-	spec.aspect_flags = vk::ImageAspectFlagBits::eColor;
-	spec.mip_levels = static_cast<unsigned>(glm::floor(glm::log2(glm::max((float)spec.size.x, (float)spec.size.y)))) + 1;
+	UploadBatch batch;
+	StageTextureMips(tex, contents, batch);
+	batch.Submit();
 
-	tex->image.SetSpec(spec);
-	tex->image.CreateImage();
+	AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(load.tex);
+	AssetManager::SetContentHash(&tex, load.content_hash);
 
-	tex->image.TransitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::AccessFlagBits::eNone, vk::AccessFlagBits::eTransferWrite, 
-		vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 0, spec.mip_levels);
-	CopyBufferToImage(staging_buffer.buffer, tex->image.GetImage(), width, height);
-	tex->image.GenerateMipmaps(vk::ImageLayout::eTransferDstOptimal);
-	tex->image.TransitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, 0, spec.mip_levels);
+	// Staged so the texels are no longer needed
+	load.mips.clear();
+	return true;
+}
 
+std::pair<AssetRef<Texture2DAsset>, bool> AssetLoader::CreateOrGetTextureFromFile(const std::string& filepath, TextureEncoder::Usage usage) {
+	return CreateOrGetTexturesFromFiles({ TextureFileLoad{ filepath, usage } })[0];
+}
 
-	AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(tex);
+std::vector<std::pair<AssetRef<Texture2DAsset>, bool>> AssetLoader::CreateOrGetTexturesFromFiles(const std::vector<TextureFileLoad>& loads) {
+	struct DecodedTexture {
+		bool read = false;
+		std::vector<std::byte> raw_file_data;
+		uint64_t file_size = 0;
+		uint64_t content_hash = 0;
+
+		// From the image header, every mip level as RGBA8
+		uint64_t decoded_size = 0;
+
+		glm::uvec2 size{ 0, 0 };
+		std::vector<std::vector<std::byte>> mips;
+		const char* p_failure_reason = nullptr;
+	};
+
+	std::vector<DecodedTexture> decoded(loads.size());
+	std::vector<std::pair<AssetRef<Texture2DAsset>, bool>> results(loads.size(), { nullptr, false });
+
+	// Hashed before decoding so content that's already loaded is never decoded
+	JobSystem::ParallelFor((uint32_t)loads.size(), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			auto& texture = decoded[i];
+			texture.read = files::ReadBinaryFile(loads[i].filepath, texture.raw_file_data);
+			if (!texture.read)
+				continue;
+
+			texture.file_size = texture.raw_file_data.size();
+			texture.content_hash = CalculateTextureContentHash(texture.raw_file_data, TextureEncoder::GetSourceFormat(loads[i].usage));
+			texture.decoded_size = GetDecodedTextureSize(texture.raw_file_data);
+		}
+		});
+
+	auto add_duplicate = [&](uint32_t i, Texture2DAsset* p_existing) {
+		auto& stats = AssetManager::GetContentDedupStats();
+		stats.num_textures++;
+		stats.texture_bytes_saved += GetTextureGPUSize(p_existing->image.GetSpec());
+		stats.disk_bytes_saved += decoded[i].file_size;
+		results[i] = { AssetRef(p_existing), false };
+	};
+
+	std::vector<uint32_t> to_decode;
+	// Loads with the same content as an earlier one in 'loads', [index, index of the earlier load]
+	std::vector<std::pair<uint32_t, uint32_t>> repeated;
+	std::unordered_map<uint64_t, uint32_t> first_with_hash;
+
+	for (uint32_t i = 0; i < loads.size(); i++) {
+		// Already logged by ReadBinaryFile
+		if (!decoded[i].read)
+			continue;
+
+		if (auto* p_existing = AssetManager::FindAssetByContentHash<Texture2DAsset>(decoded[i].content_hash)) {
+			add_duplicate(i, p_existing);
+			decoded[i].raw_file_data = {};
+			continue;
+		}
 
-	return true;
+		if (auto [it, inserted] = first_with_hash.try_emplace(decoded[i].content_hash, i); inserted) {
+			to_decode.push_back(i);
+		}
+		else {
+			repeated.emplace_back(i, it->second);
+			decoded[i].raw_file_data = {};
+		}
+	}
+
+	std::vector<Texture2DAsset*> created;
+
+	// Decoded and staged in chunks of at most TEXTURE_DECODE_BUDGET_BYTES, texels are freed as they're staged
+	// The previous chunk's batch uploads while the next decodes and is released before the next is staged, the last is waited on when destroyed on return
+	std::unique_ptr<UploadBatch> p_previous_batch;
+	for (size_t chunk_begin = 0; chunk_begin < to_decode.size();) {
+		// Always at least one texture, however large
+		size_t chunk_end = chunk_begin + 1;
+		uint64_t chunk_size = decoded[to_decode[chunk_begin]].decoded_size;
+		while (chunk_end < to_decode.size() && chunk_size + decoded[to_decode[chunk_end]].decoded_size <= TEXTURE_DECODE_BUDGET_BYTES) {
+			chunk_size += decoded[to_decode[chunk_end]].decoded_size;
+			chunk_end++;
+		}
+
+		JobSystem::ParallelFor((uint32_t)(chunk_end - chunk_begin), 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t j = begin; j < end; j++) {
+				auto& texture = decoded[to_decode[chunk_begin + j]];
+				texture.mips = DecodeTextureMips(texture.raw_file_data, loads[to_decode[chunk_begin + j]].usage, texture.size);
+				if (texture.mips.empty())
+					texture.p_failure_reason = stbi_failure_reason();
+
+				texture.raw_file_data = {};
+			}
+			});
+
+		p_previous_batch.reset();
+		auto p_batch = std::make_unique<UploadBatch>(chunk_size);
+		size_t num_created_before = created.size();
+
+		for (size_t j = chunk_begin; j < chunk_end; j++) {
+			auto i = to_decode[j];
+			auto& texture = decoded[i];
+			if (texture.mips.empty()) {
+				SNK_CORE_ERROR("CreateOrGetTextureFromFile failed, couldn't decode '{}': '{}'", loads[i].filepath, texture.p_failure_reason);
+				continue;
+			}
+
+			auto* p_tex = AssetManager::CreateAsset<Texture2DAsset>().get();
+			AssetManager::SetFilepath(p_tex, loads[i].filepath);
+			p_tex->image.SetSpec(CreateTextureSpec(TextureEncoder::GetSourceFormat(loads[i].usage), texture.size, (uint32_t)texture.mips.size()));
+			p_tex->image.CreateImage();
+
+			Texture2DFileContents contents;
+			contents.mips.assign(texture.mips.begin(), texture.mips.end());
+			StageTextureMips(*p_tex, contents, *p_batch);
+
+			// Staging copies the texels, they can be freed before the batch is submitted
+			texture.mips = {};
+
+			AssetManager::SetContentHash(p_tex, texture.content_hash);
+			created.push_back(p_tex);
+			results[i] = { AssetRef(p_tex), true };
+		}
+
+		p_batch->Submit();
+		for (size_t j = num_created_before; j < created.size(); j++) {
+			AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(created[j]);
+		}
+
+		p_previous_batch = std::move(p_batch);
+		chunk_begin = chunk_end;
+	}
+
+	for (auto [i, first] : repeated) {
+		if (auto* p_first = results[first].first.get())
+			add_duplicate(i, p_first);
+	}
+
+	return results;
+}
+
+uint64_t AssetLoader::GetDecodedTextureSize(const std::vector<std::byte>& raw_file_data) {
+	int width, height, channels;
+	if (!stbi_info_from_memory(reinterpret_cast<const stbi_uc*>(raw_file_data.data()), (int)raw_file_data.size(), &width, &height, &channels))
+		return 0;
+
+	uint64_t size = 0;
+	for (uint32_t i = 0; i < TextureEncoder::GetNumMips(width, height); i++) {
+		size += (uint64_t)glm::max(width >> i, 1) * glm::max(height >> i, 1) * 4;
+	}
+
+	return size;
+}
+
+uint64_t AssetLoader::CalculateTextureContentHash(const std::vector<std::byte>& raw_file_data, vk::Format fmt) {
+	Hasher hasher;
+	hasher.Value(fmt);
+	hasher.Update(raw_file_data.data(), raw_file_data.size());
+	return hasher.Digest();
+}
+
+uint64_t AssetLoader::GetTextureGPUSize(const Image2DSpec& spec) {
+	uint64_t size = 0;
+	for (unsigned i = 0; i < spec.mip_levels; i++) {
+		size += TextureEncoder::GetMipSize(spec.format, glm::max(spec.size.x >> i, 1u), glm::max(spec.size.y >> i, 1u));
+	}
+
+	return size;
 }
 
 std::unique_ptr<MeshData> AssetLoader::LoadMeshDataFromRawFile(const std::string& filepath, bool load_materials_and_textures) {
+	std::vector<ImportedMaterial> imported_materials;
+	auto p_data = ImportModelFile(filepath, load_materials_and_textures ? &imported_materials : nullptr);
+	if (!p_data || !load_materials_and_textures)
+		return p_data;
+
+	p_data->materials.resize(imported_materials.size(), UUID<uint64_t>::INVALID_UUID);
+
+	if (p_data->materials.empty()) {
+		p_data->materials.push_back(AssetManager::CoreAssetIDs::MATERIAL);
+	}
+
+	constexpr AssetRef<Texture2DAsset> MaterialAsset::* TEXTURE_SLOTS[] = {
+		&MaterialAsset::albedo_tex,
+		&MaterialAsset::normal_tex,
+		&MaterialAsset::roughness_tex,
+		&MaterialAsset::metallic_tex,
+		&MaterialAsset::ao_tex,
+	};
+
+	// Every material's textures are loaded together so they decode in parallel, [material index, TEXTURE_SLOTS index] for each load
+	std::vector<TextureFileLoad> texture_loads;
+	std::vector<std::pair<size_t, size_t>> texture_load_slots;
+	for (size_t i = 0; i < imported_materials.size(); i++) {
+		for (size_t slot = 0; slot < std::size(TEXTURE_SLOTS); slot++) {
+			if (auto& load = imported_materials[i].textures[slot]; !load.filepath.empty()) {
+				texture_loads.push_back(load);
+				texture_load_slots.emplace_back(i, slot);
+			}
+		}
+	}
+
+	auto loaded_textures = CreateOrGetTexturesFromFiles(texture_loads);
+	size_t next_texture = 0;
+
+	for (size_t i = 0; i < imported_materials.size(); i++) {
+		auto& imported = imported_materials[i];
+		AssetRef<MaterialAsset> material_asset = AssetManager::CreateAsset<MaterialAsset>();
+
+		for (; next_texture < loaded_textures.size() && texture_load_slots[next_texture].first == i; next_texture++) {
+			auto& [tex, is_newly_created] = loaded_textures[next_texture];
+			if (!tex)
+				continue;
+
+			material_asset.get()->*TEXTURE_SLOTS[texture_load_slots[next_texture].second] = tex;
+			if (is_newly_created) p_data->textures.push_back(tex->uuid());
+		}
+
+		if (!imported.properties_set) {
+			AssetManager::DeleteAsset(material_asset->uuid());
+			material_asset = AssetManager::GetAsset<MaterialAsset>(AssetManager::CoreAssetIDs::MATERIAL);
+		}
+		else {
+			material_asset->albedo = imported.contents.albedo;
+			material_asset->roughness = imported.contents.roughness;
+			material_asset->metallic = imported.contents.metallic;
+		}
+
+		p_data->materials[i] = material_asset->uuid();
+	}
+
+
+	return std::move(p_data);
+}
+
+std::unique_ptr<MeshData> AssetLoader::ImportModelFile(const std::string& filepath, std::vector<ImportedMaterial>* p_materials) {
 	auto p_data = std::make_unique<MeshData>();
 	Assimp::Importer importer;
 
@@ -383,7 +1217,6 @@ std::unique_ptr<MeshData> AssetLoader::LoadMeshDataFromRawFile(const std::string
 		memcpy(p_data_pos + current_vert_offset * sizeof(aiVector3D), submesh.mVertices, submesh.mNumVertices * sizeof(aiVector3D));
 		memcpy(p_data_norm + current_vert_offset * sizeof(aiVector3D), submesh.mNormals, submesh.mNumVertices * sizeof(aiVector3D));
 		memcpy(p_data_tangent + current_vert_offset * sizeof(aiVector3D), submesh.mTangents, submesh.mNumVertices * sizeof(aiVector3D));
-		current_vert_offset += submesh.mNumVertices;
 
 		for (size_t j = 0; j < submesh.mNumFaces; j++) {
 			aiFace& face = submesh.mFaces[j];
@@ -392,76 +1225,66 @@ std::unique_ptr<MeshData> AssetLoader::LoadMeshDataFromRawFile(const std::string
 		}
 
 		for (size_t j = 0; j < submesh.mNumVertices; j++) {
-			memcpy(p_data_tex_coord + j * sizeof(aiVector2D), &submesh.mTextureCoords[0][j], sizeof(aiVector2D));
+			memcpy(p_data_tex_coord + (current_vert_offset + j) * sizeof(aiVector2D), &submesh.mTextureCoords[0][j], sizeof(aiVector2D));
 		}
+
+		current_vert_offset += submesh.mNumVertices;
 	}
 
-	if (!load_materials_and_textures)
-		return std::move(p_data);
+	MeshSimplifier::GenerateLODs(*p_data);
 
-	p_data->materials.resize(p_scene->mNumMaterials, UUID<uint64_t>::INVALID_UUID);
+	// Only reorders triangles and vertices within each submesh and LOD range, so runs after LOD generation
+	auto report = MeshOptimizer::OptimizeMesh(*p_data);
+	SNK_CORE_INFO("Optimised mesh '{}': ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filepath,
+		report.before.GetACMR(), report.after.GetACMR(), report.before.GetATVR(), report.after.GetATVR());
 
-	if (p_data->materials.empty()) {
-		p_data->materials.push_back(AssetManager::CoreAssetIDs::MATERIAL);
-	}
+	// Built from the optimised triangle order, which keeps each meshlet's triangles close together
+	MeshletBuilder::BuildMeshlets(*p_data);
+
+	if (!p_materials)
+		return std::move(p_data);
 
 	auto dir = files::GetFileDirectory(filepath);
 
+	// Ordered as MaterialFileContents::texture_uuids
+	constexpr aiTextureType TEXTURE_TYPES[] = {
+		aiTextureType_BASE_COLOR,
+		aiTextureType_NORMALS,
+		aiTextureType_DIFFUSE_ROUGHNESS,
+		aiTextureType_METALNESS,
+		aiTextureType_AMBIENT_OCCLUSION,
+	};
+
+	p_materials->resize(p_scene->mNumMaterials);
 	for (size_t i = 0; i < p_scene->mNumMaterials; i++) {
 		aiMaterial* p_material = p_scene->mMaterials[i];
-		AssetRef<MaterialAsset> material_asset = AssetManager::CreateAsset<MaterialAsset>();
-
-		bool material_properties_set = false;
+		auto& imported = (*p_materials)[i];
+		imported.contents.name = p_material->GetName().C_Str();
 
-		if (auto [tex, is_newly_created] = CreateOrGetTextureFromMaterial(dir, aiTextureType_BASE_COLOR, p_material); tex) {
-			material_asset->albedo_tex = tex;
-			if (is_newly_created) p_data->textures.push_back(tex->uuid());
-		}
-		if (auto [tex, is_newly_created] = CreateOrGetTextureFromMaterial(dir, aiTextureType_NORMALS, p_material); tex) {
-			material_asset->normal_tex = tex;
-			if (is_newly_created) p_data->textures.push_back(tex->uuid());
-		}
-		if (auto [tex, is_newly_created] = CreateOrGetTextureFromMaterial(dir, aiTextureType_DIFFUSE_ROUGHNESS, p_material); tex) {
-			material_asset->roughness_tex = tex;
-			if (is_newly_created) p_data->textures.push_back(tex->uuid());
-		}
-		if (auto [tex, is_newly_created] = CreateOrGetTextureFromMaterial(dir, aiTextureType_METALNESS, p_material); tex) {
-			material_asset->metallic_tex = tex;
-			if (is_newly_created) p_data->textures.push_back(tex->uuid());
+		// Slots without a texture are left with an empty filepath
+		for (size_t slot = 0; slot < std::size(TEXTURE_TYPES); slot++) {
+			GetMaterialTextureLoad(dir, TEXTURE_TYPES[slot], p_material, imported.textures[slot]);
 		}
-		if (auto [tex, is_newly_created] = CreateOrGetTextureFromMaterial(dir, aiTextureType_AMBIENT_OCCLUSION, p_material); tex) {
-			material_asset->ao_tex = tex;
-			if (is_newly_created) p_data->textures.push_back(tex->uuid());
-		}
-
 
 		aiColor3D base_col(1.f, 1.f, 1.f);
 		if (p_material->Get(AI_MATKEY_BASE_COLOR, base_col) == aiReturn_SUCCESS) {
-			material_asset->albedo = { base_col.r, base_col.g, base_col.b };
-			material_properties_set = true;
+			imported.contents.albedo = { base_col.r, base_col.g, base_col.b };
+			imported.properties_set = true;
 		}
 
 		float roughness;
 		float metallic;
 		if (p_material->Get(AI_MATKEY_ROUGHNESS_FACTOR, roughness) == aiReturn_SUCCESS) {
-			material_asset->roughness = roughness;
-			material_properties_set = true;
+			imported.contents.roughness = roughness;
+			imported.properties_set = true;
 		}
 
 		if (p_material->Get(AI_MATKEY_METALLIC_FACTOR, metallic) == aiReturn_SUCCESS) {
-			material_asset->metallic = metallic;
-			material_properties_set = true;
+			imported.contents.metallic = metallic;
+			imported.properties_set = true;
 		}
-
-		if (!material_properties_set) {
-			AssetManager::DeleteAsset(material_asset->uuid());
-			material_asset = AssetManager::GetAsset<MaterialAsset>(AssetManager::CoreAssetIDs::MATERIAL);
-		}
-
-		p_data->materials[i] = material_asset->uuid();
 	}
 
-
 	return std::move(p_data);
 }
 
@@ -542,9 +1365,7 @@ std::unique_ptr<MeshData> AssetLoader::LoadMeshDataFromRawFile(const std::string
 //
 //}
 
-std::pair<AssetRef<Texture2DAsset>, bool>  AssetLoader::CreateOrGetTextureFromMaterial(const std::string& dir, aiTextureType type, aiMaterial* p_material) {
-	AssetRef<Texture2DAsset> tex = nullptr;
-
+bool AssetLoader::GetMaterialTextureLoad(const std::string& dir, aiTextureType type, aiMaterial* p_material, TextureFileLoad& load) {
 	if (p_material->GetTextureCount(type) > 0) {
 		aiString path;
 
@@ -557,21 +1378,22 @@ std::pair<AssetRef<Texture2DAsset>, bool>  AssetLoader::CreateOrGetTextureFromMa
 
 			full_path = dir + "\\" + p;
 
-			if (auto existing = AssetManager::GetAsset<Texture2DAsset>(full_path)) {
-				return { existing, false };
-			}
-
 			if (!files::PathExists(full_path)) {
-				SNK_CORE_ERROR("CreateOrGetTextureFromMaterial failed, invalid path '{}'", full_path);
-				return { nullptr, false };
+				SNK_CORE_ERROR("GetMaterialTextureLoad failed, invalid path '{}'", full_path);
+				return false;
 			}
 
-			tex = AssetManager::CreateAsset<Texture2DAsset>();
-			vk::Format fmt = type == aiTextureType_BASE_COLOR ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
-			tex->filepath = full_path;
-			AssetLoader::LoadTextureFromFile(tex, fmt);
+			// Textures are found by content, which also covers the same file being referenced again
+			load.filepath = full_path;
+			load.usage = TextureEncoder::Usage::MASK;
+			if (type == aiTextureType_BASE_COLOR)
+				load.usage = TextureEncoder::Usage::ALBEDO;
+			else if (type == aiTextureType_NORMALS)
+				load.usage = TextureEncoder::Usage::NORMAL;
+
+			return true;
 		}
 	}
 
-	return { tex, true };
+	return false;
 }
@@ -8,6 +8,13 @@
 
 namespace SNAKE {
 	void AssetManager::I_Init() {
+		m_main_thread = std::this_thread::get_id();
+
+		m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+			DestroyDeletedAssets();
+		};
+		EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+
 		InitGlobalBufferManagers();
 		LoadCoreAssets();
 	}
@@ -17,13 +24,14 @@ namespace SNAKE {
 		m_global_tex_mat_descriptor_spec = std::make_shared<DescriptorSetSpec>();
 		m_global_tex_mat_descriptor_spec->AddDescriptor(0, vk::DescriptorType::eStorageBuffer,
 			vk::ShaderStageFlagBits::eAll, 1)
-			.AddDescriptor(1, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eAll, 4096);
+			.AddDescriptor(1, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eAll, GlobalTextureBufferManager::GetMaxTextures(),
+				vk::DescriptorBindingFlagBits::eVariableDescriptorCount);
 		m_global_tex_mat_descriptor_spec->GenDescriptorLayout();
 
 		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 			descriptor_buffers[i] = std::make_shared<DescriptorBuffer>();
 			descriptor_buffers[i]->SetDescriptorSpec(m_global_tex_mat_descriptor_spec);
-			descriptor_buffers[i]->CreateBuffer(1);
+			descriptor_buffers[i]->CreateBuffer(1, GlobalTextureBufferManager::INITIAL_CAPACITY);
 		}
 
 		m_global_material_buffer_manager.Init(descriptor_buffers);
@@ -33,13 +41,18 @@ namespace SNAKE {
 
 	void AssetManager::LoadCoreAssets() {
 		auto tex = CreateAsset<Texture2DAsset>(CoreAssetIDs::TEXTURE);
-		tex->filepath = "res/textures/metalgrid1_basecolor.png";
-		AssetLoader::LoadTextureFromFile(tex, vk::Format::eR8G8B8A8Srgb);
+		SetFilepath(tex.get(), "res/textures/metalgrid1_basecolor.png");
+
+		// Decoded and mipmapped on a worker while the core meshes are imported
+		auto p_tex_load = AssetLoader::BeginTextureLoadFromFile(tex, TextureEncoder::Usage::ALBEDO);
+		auto p_sphere_data = AssetLoader::LoadMeshDataFromRawFile("res/meshes/sphere.glb", false);
+		auto p_cube_data = AssetLoader::LoadMeshDataFromRawFile("res/meshes/cube.glb", false);
+		AssetLoader::EndTextureLoad(*p_tex_load);
 
 		//auto normal_tex = CreateAsset<Texture2DAsset>();
 		//normal_tex->name = "NORMAL MAP";
 		//normal_tex->filepath = "res/textures/metalgrid1_normal-ogl.png";
-		//AssetLoader::LoadTextureFromFile(normal_tex, vk::Format::eR8G8B8A8Unorm);
+		//AssetLoader::LoadTextureFromFile(normal_tex, TextureEncoder::Usage::NORMAL);
 
 		auto material = CreateAsset<MaterialAsset>(CoreAssetIDs::MATERIAL);
 		material->albedo_tex = tex;
@@ -50,63 +63,167 @@ namespace SNAKE {
 
 		auto sphere_mesh = CreateAsset<StaticMeshAsset>(CoreAssetIDs::SPHERE_MESH);
 		sphere_mesh->data = CreateAsset<MeshDataAsset>(CoreAssetIDs::SPHERE_MESH_DATA);
-		sphere_mesh->data->filepath = "res/meshes/sphere.glb";
-		auto p_sphere_data = AssetLoader::LoadMeshDataFromRawFile("res/meshes/sphere.glb", false);
+		SetFilepath(sphere_mesh->data.get(), "res/meshes/sphere.glb");
 		AssetManager::Get().mesh_buffer_manager.LoadMeshFromData(sphere_mesh->data.get(), *p_sphere_data);
 		sphere_mesh->data->materials.push_back(material);
 
 		auto cube_mesh = CreateAsset<StaticMeshAsset>(CoreAssetIDs::CUBE_MESH);
 		cube_mesh->data = CreateAsset<MeshDataAsset>(CoreAssetIDs::CUBE_MESH_DATA);
-		cube_mesh->data->filepath = "res/meshes/cube.glb";
-		auto p_cube_data = AssetLoader::LoadMeshDataFromRawFile("res/meshes/cube.glb", false);
+		SetFilepath(cube_mesh->data.get(), "res/meshes/cube.glb");
 		AssetManager::Get().mesh_buffer_manager.LoadMeshFromData(cube_mesh->data.get(), *p_cube_data);
 		cube_mesh->data->materials.push_back(material);
 
 	}
 
 	void AssetManager::Shutdown() {
-		auto& assets = Get().m_assets;
+		auto& manager = Get();
 
-		while (!assets.empty()) {
-			DeleteAsset(assets.begin()->second);
+		std::vector<Asset*> assets;
+		manager.m_assets.ForEach([&]([[maybe_unused]] uint64_t uuid, Asset* p_asset) {
+			assets.push_back(p_asset);
+		});
+
+		for (auto* p_asset : assets) {
+			DeleteAsset(p_asset);
+		}
+
+		// Device is idle on shutdown so deleted assets and unloaded mesh data don't need to wait for frames in flight
+		for (auto* p_asset : manager.m_deleted_assets.TakeAll()) {
+			delete p_asset;
 		}
+
+		manager.mesh_buffer_manager.ReleasePendingNow();
 	}
 
-	void AssetManager::DeleteAsset(Asset* p_asset) {
-		if (!Get().m_assets.contains(p_asset->uuid())) {
-			SNK_CORE_ERROR("AssetManager::DeleteAsset failed '[{}, {}]', UUID doesn't exist in AssetManager", p_asset->uuid(), p_asset->filepath);
-			return;
+	void AssetManager::DestroyDeletedAssets() {
+		std::vector<Asset*> destroyed;
+		{
+			std::scoped_lock l(m_lifecycle_mux);
+			destroyed = m_deleted_assets.AdvanceFrame();
 		}
 
-		if (auto ref_count = p_asset->GetRefCount(); ref_count != 0) {
-			SNK_CORE_WARN("Deleting asset '[{}, {}]' which still has {} references", p_asset->uuid(), p_asset->filepath, ref_count);
+		for (auto* p_asset : destroyed) {
+			delete p_asset;
 		}
+	}
 
-		Get().OnAssetDelete(p_asset);
+	void AssetManager::SetContentHash(Asset* p_asset, uint64_t hash) {
+		std::unique_lock l(Get().m_index_mux);
+		Get().SetContentHashLocked(p_asset, hash);
+	}
+
+	void AssetManager::SetContentHashLocked(Asset* p_asset, uint64_t hash) {
+		auto& index = m_content_index;
+		if (p_asset->content_hash != 0) {
+			auto [begin, end] = index.equal_range(p_asset->content_hash);
+			for (auto it = begin; it != end; it++) {
+				if (it->second == p_asset) {
+					index.erase(it);
+					break;
+				}
+			}
+		}
 
-		Get().m_assets.erase(p_asset->uuid());
-		delete p_asset;
+		p_asset->content_hash = hash;
+		if (hash != 0)
+			index.emplace(hash, p_asset);
 	}
 
+	std::string AssetManager::CanonicalisePath(const std::string& filepath) {
+		std::error_code ec;
+		auto path = std::filesystem::weakly_canonical(filepath, ec);
+		if (ec)
+			path = std::filesystem::absolute(filepath, ec).lexically_normal();
+
+		auto key = path.generic_string();
+#ifdef _WIN32
+		// Matches std::filesystem::equivalent on a case-insensitive filesystem
+		std::ranges::transform(key, key.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+		return key;
+	}
 
-	void AssetManager::DeleteAsset(uint64_t uuid) {
-		auto& assets = Get().m_assets;
+	void AssetManager::RemovePathIndexEntry(Asset* p_asset) {
+		if (p_asset->indexed_path.empty())
+			return;
 
-		if (!assets.contains(uuid)) {
-			SNK_CORE_ERROR("AssetManager::DeleteAsset failed, UUID '{}' doesn't exist in AssetManager", uuid);
+		auto [begin, end] = m_path_index.equal_range(p_asset->indexed_path);
+		for (auto it = begin; it != end; it++) {
+			if (it->second == p_asset) {
+				m_path_index.erase(it);
+				break;
+			}
+		}
+
+		p_asset->indexed_path.clear();
+	}
+
+	void AssetManager::SetFilepath(Asset* p_asset, const std::string& filepath) {
+		auto& manager = Get();
+
+		auto key = filepath.empty() ? std::string{} : CanonicalisePath(filepath);
+
+		std::unique_lock l(manager.m_index_mux);
+		manager.RemovePathIndexEntry(p_asset);
+		p_asset->filepath = filepath;
+
+		// Assets not owned by AssetManager aren't indexed, nothing would remove them again
+		// Checked under the lock, DeleteAsset removes the asset from m_assets before unindexing it
+		if (key.empty() || manager.m_assets.Find(p_asset->uuid()) != p_asset)
+			return;
+
+		p_asset->indexed_path = std::move(key);
+		manager.m_path_index.emplace(p_asset->indexed_path, p_asset);
+	}
+
+	void AssetManager::AddAlias(uint64_t uuid, Asset* p_asset) {
+		if (Get().m_assets.Contains(uuid)) {
+			SNK_CORE_ERROR("AssetManager::AddAlias failed, UUID '{}' belongs to an existing asset", uuid);
 			return;
 		}
 
-		auto* p_asset = assets[uuid];
+		std::unique_lock l(Get().m_index_mux);
+		Get().m_aliases[uuid] = p_asset->uuid();
+	}
+
+	void AssetManager::UnindexAsset(Asset* p_asset) {
+		std::unique_lock l(m_index_mux);
+		SetContentHashLocked(p_asset, 0);
+		RemovePathIndexEntry(p_asset);
+		std::erase_if(m_aliases, [&](const auto& pair) { return pair.second == p_asset->uuid(); });
+		m_type_lists.at(typeid(*p_asset))->Remove(p_asset);
+	}
+
+	void AssetManager::DeleteAsset(Asset* p_asset) {
+		auto& manager = Get();
+		SNK_DBG_ASSERT(std::this_thread::get_id() == manager.m_main_thread);
+		std::scoped_lock l(manager.m_lifecycle_mux);
+
+		if (manager.m_assets.Find(p_asset->uuid()) != p_asset) {
+			SNK_CORE_ERROR("AssetManager::DeleteAsset failed '[{}, {}]', UUID doesn't exist in AssetManager", p_asset->uuid(), p_asset->filepath);
+			return;
+		}
 
 		if (auto ref_count = p_asset->GetRefCount(); ref_count != 0) {
 			SNK_CORE_WARN("Deleting asset '[{}, {}]' which still has {} references", p_asset->uuid(), p_asset->filepath, ref_count);
 		}
 
-		Get().OnAssetDelete(p_asset);
+		manager.OnAssetDelete(p_asset);
+		manager.m_assets.Erase(p_asset->uuid());
+		manager.UnindexAsset(p_asset);
+
+		manager.m_deleted_assets.Push(p_asset);
+	}
+
+
+	void AssetManager::DeleteAsset(uint64_t uuid) {
+		auto* p_asset = Get().m_assets.Find(uuid);
+		if (!p_asset) {
+			SNK_CORE_ERROR("AssetManager::DeleteAsset failed, UUID '{}' doesn't exist in AssetManager", uuid);
+			return;
+		}
 
-		delete assets[uuid];
-		assets.erase(uuid);
+		DeleteAsset(p_asset);
 	}
 
 	
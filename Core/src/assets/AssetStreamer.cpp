@@ -0,0 +1,431 @@
+#include "pch/pch.h"
+#include "assets/AssetStreamer.h"
+#include "assets/AssetManager.h"
+#include "assets/AssetLoader.h"
+#include "assets/TextureResidencyManager.h"
+#include "components/Components.h"
+#include "scene/Scene.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+void AssetStreamer::I_Init() {
+	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		UploadLoadedAssets();
+	};
+
+	m_asset_event_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<AssetEvent const*>(p_event);
+		if (p_casted->type == AssetEventType::DESTROYED)
+			OnAssetDestroyed(p_casted->p_asset);
+	};
+
+	m_mesh_data_loaded_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<MeshDataLoadedEvent const*>(p_event);
+		OnResident(p_casted->p_mesh_data);
+	};
+
+	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+	EventManagerG::RegisterListener<AssetEvent>(m_asset_event_listener);
+	EventManagerG::RegisterListener<MeshDataLoadedEvent>(m_mesh_data_loaded_listener);
+}
+
+void AssetStreamer::Shutdown() {
+	auto& streamer = Get();
+
+	{
+		std::scoped_lock l(streamer.m_mux);
+		streamer.m_queue.clear();
+	}
+
+	// Jobs exit once the queue is empty, after finishing the request they're on
+	while (true) {
+		{
+			std::scoped_lock l(streamer.m_mux);
+			if (streamer.m_num_active_jobs == 0)
+				break;
+		}
+
+		std::this_thread::yield();
+	}
+
+	// Waits for their copies, the images they write to are about to be destroyed
+	streamer.m_in_flight_batches.clear();
+
+	streamer.m_loaded.clear();
+	streamer.m_requests.clear();
+}
+
+Texture2DAsset* AssetStreamer::RequestTexture2D(const std::string& filepath, uint32_t priority) {
+	uint64_t uuid;
+	std::string name;
+	Image2DSpec spec;
+	if (!AssetLoader::ReadTexture2DFile(filepath, uuid, name, spec))
+		return nullptr;
+
+	if (AssetManager::Get().m_assets.Contains(uuid)) {
+		SNK_CORE_ERROR("AssetStreamer::RequestTexture2D failed for '{}', UUID conflict: '{}'", filepath, uuid);
+		return nullptr;
+	}
+
+	auto tex = AssetManager::CreateAsset<Texture2DAsset>(uuid);
+	AssetManager::SetFilepath(tex.get(), filepath);
+	tex->name = std::move(name);
+
+	// Set from the header so the texture can be serialized before it's loaded
+	tex->image.SetSpec(spec);
+
+	AssetManager::Get().m_global_tex_buffer_manager.RegisterPlaceholder(tex, AssetManager::GetAsset<Texture2DAsset>(AssetManager::CoreAssetIDs::TEXTURE));
+	Get().Enqueue(tex.get(), RequestType::TEXTURE_2D, filepath, priority);
+	return tex.get();
+}
+
+MeshDataAsset* AssetStreamer::RequestMeshData(const std::string& filepath, uint32_t priority) {
+	SNK_ASSERT(filepath.ends_with(".meshdata"));
+
+	auto p_file = std::make_unique<MappedFile>();
+	if (!p_file->Open(filepath)) {
+		SNK_CORE_ERROR("AssetStreamer::RequestMeshData failed, couldn't map '{}'", filepath);
+		return nullptr;
+	}
+
+	if (AssetLoader::IsLegacyMeshDataFile(*p_file)) {
+		p_file->Close();
+		return AssetLoader::DeserializeMeshData(filepath);
+	}
+
+	MeshData data;
+	uint64_t uuid;
+	std::string name;
+	if (!AssetLoader::ReadMeshDataFile(std::move(p_file), filepath, data, uuid, name, true))
+		return nullptr;
+
+	if (AssetManager::Get().m_assets.Contains(uuid)) {
+		SNK_CORE_ERROR("AssetStreamer::RequestMeshData failed for '{}', UUID conflict: '{}'", filepath, uuid);
+		return nullptr;
+	}
+
+	auto mesh_data = AssetManager::CreateAsset<MeshDataAsset>(uuid);
+	AssetManager::SetFilepath(mesh_data.get(), filepath);
+	mesh_data->name = std::move(name);
+
+	// Static mesh components copy their mesh's materials when it's set, so these have to be right before the data loads
+	MeshBufferManager::ResolveMaterials(mesh_data.get(), data.materials);
+
+	Get().Enqueue(mesh_data.get(), RequestType::MESH_DATA, filepath, priority);
+	return mesh_data.get();
+}
+
+void AssetStreamer::Enqueue(Asset* p_asset, RequestType type, const std::string& filepath, uint32_t priority) {
+	std::scoped_lock l(m_mux);
+	uint64_t id = m_next_request_id++;
+	m_requests[p_asset] = Request{ .p_asset = p_asset, .type = type, .filepath = filepath, .id = id, .priority = priority };
+	m_queue[QueueKey{ priority, id }] = p_asset;
+	m_stats.num_requests++;
+
+	StartJobs();
+}
+
+void AssetStreamer::StartJobs() {
+	while (m_num_active_jobs < max_concurrent_loads && m_num_active_jobs < m_queue.size()) {
+		m_num_active_jobs++;
+
+		auto* p_job = JobSystem::CreateJob();
+		p_job->func = [this]([[maybe_unused]] Job const* p_this) { LoadQueued(); };
+		JobSystem::Execute(p_job);
+	}
+}
+
+void AssetStreamer::SetPriority(Asset* p_asset, uint32_t priority) {
+	auto& streamer = Get();
+	std::scoped_lock l(streamer.m_mux);
+
+	auto it = streamer.m_requests.find(p_asset);
+	if (it == streamer.m_requests.end())
+		return;
+
+	auto& request = it->second;
+	if (request.state == RequestState::QUEUED) {
+		streamer.m_queue.erase(QueueKey{ request.priority, request.id });
+		streamer.m_queue[QueueKey{ priority, request.id }] = p_asset;
+	}
+
+	// LOADED requests are ordered by this when uploading
+	request.priority = priority;
+}
+
+void AssetStreamer::PrioritiseScene(Scene& scene, uint32_t priority) {
+	for (auto [entity, mesh] : scene.GetRegistry().view<StaticMeshComponent>().each()) {
+		if (auto* p_mesh_data = mesh.GetMeshAsset()->data.get())
+			SetPriority(p_mesh_data, priority);
+
+		for (auto& mat : mesh.GetMaterials()) {
+			for (auto* p_tex : { mat->albedo_tex.get(), mat->normal_tex.get(), mat->roughness_tex.get(), mat->metallic_tex.get(), mat->ao_tex.get() }) {
+				if (p_tex)
+					SetPriority(p_tex, priority);
+			}
+		}
+	}
+}
+
+bool AssetStreamer::IsResident(Asset* p_asset) {
+	std::scoped_lock l(Get().m_mux);
+	return !Get().m_requests.contains(p_asset);
+}
+
+uint32_t AssetStreamer::GetNumPending() {
+	std::scoped_lock l(Get().m_mux);
+	return (uint32_t)Get().m_requests.size();
+}
+
+void AssetStreamer::SetState(Asset* p_asset, RequestState state) {
+	std::scoped_lock l(m_mux);
+	m_requests.at(p_asset).state = state;
+}
+
+void AssetStreamer::LoadQueued() {
+	while (true) {
+		Request request;
+		{
+			std::scoped_lock l(m_mux);
+			if (m_queue.empty()) {
+				m_num_active_jobs--;
+				return;
+			}
+
+			auto* p_asset = m_queue.begin()->second;
+			m_queue.erase(m_queue.begin());
+
+			auto& queued = m_requests.at(p_asset);
+			queued.state = RequestState::LOADING;
+			request = queued;
+		}
+
+		auto loaded = request.type == RequestType::TEXTURE_2D ? LoadTexture2D(request) : LoadMeshData(request);
+		loaded.p_asset = request.p_asset;
+		loaded.request_id = request.id;
+
+		std::scoped_lock l(m_mux);
+
+		// Dropped if the asset was deleted while loading
+		if (auto it = m_requests.find(request.p_asset); it != m_requests.end() && it->second.id == request.id) {
+			it->second.state = RequestState::LOADED;
+			m_loaded.push_back(std::move(loaded));
+		}
+	}
+}
+
+AssetStreamer::LoadedAsset AssetStreamer::LoadTexture2D(const Request& request) {
+	LoadedAsset loaded;
+
+	uint64_t uuid;
+	std::string name;
+	Image2DSpec spec;
+	AssetLoader::Texture2DFileContents contents;
+	if (!AssetLoader::ReadTexture2DFile(request.filepath, uuid, name, spec, &contents))
+		return loaded;
+
+	loaded.content_hash = contents.content_hash;
+
+	// Files in the pre-versioned layout are decoded and mipmapped here so uploading them is the same as any other, they're always fully resident
+	if (contents.mips.empty()) {
+		if (!AssetLoader::DecodeLegacyTexture2D(request.filepath, spec, contents))
+			return loaded;
+	}
+	else {
+		// Only the tail is uploaded, TextureResidencyManager streams in finer mips once the texture is seen
+		loaded.resident_top = TextureResidencyManager::GetTailTop(spec);
+		loaded.managed_residency = true;
+		contents.mips.erase(contents.mips.begin(), contents.mips.begin() + loaded.resident_top);
+	}
+
+	// Touching every page reads the file here instead of on the main thread when the mips are staged
+	volatile std::byte sink;
+	for (auto mip : contents.mips) {
+		for (size_t i = 0; i < mip.size(); i += 4096) {
+			sink = mip[i];
+		}
+
+		loaded.upload_size += mip.size();
+	}
+
+	loaded.file_contents = std::move(contents);
+	loaded.success = true;
+	return loaded;
+}
+
+AssetStreamer::LoadedAsset AssetStreamer::LoadMeshData(const Request& request) {
+	LoadedAsset loaded;
+
+	auto p_file = std::make_unique<MappedFile>();
+	if (!p_file->Open(request.filepath)) {
+		SNK_CORE_ERROR("AssetStreamer failed to load mesh data, couldn't map '{}'", request.filepath);
+		return loaded;
+	}
+
+	auto p_data = std::make_unique<MeshData>();
+	uint64_t uuid;
+	std::string name;
+	if (!AssetLoader::ReadMeshDataFile(std::move(p_file), request.filepath, *p_data, uuid, name))
+		return loaded;
+
+	loaded.mesh_upload = AssetManager::Get().mesh_buffer_manager.PrepareMeshUpload(std::move(p_data));
+	loaded.upload_size = AssetManager::Get().mesh_buffer_manager.GetUploadSize(loaded.mesh_upload);
+	loaded.success = true;
+	return loaded;
+}
+
+size_t AssetStreamer::GetNumWithinBudget(const std::vector<uint64_t>& upload_sizes, uint64_t budget) {
+	size_t num = 0;
+	uint64_t budget_used = 0;
+	for (; num < upload_sizes.size(); num++) {
+		if (num > 0 && budget_used + upload_sizes[num] > budget)
+			break;
+
+		budget_used += upload_sizes[num];
+	}
+
+	return num;
+}
+
+void AssetStreamer::PollInFlightBatches() {
+	std::erase_if(m_in_flight_batches, [](const std::unique_ptr<UploadBatch>& p_batch) { return p_batch->IsComplete(); });
+}
+
+void AssetStreamer::UploadLoadedAssets() {
+	PollInFlightBatches();
+
+	std::vector<LoadedAsset> loaded;
+	{
+		std::scoped_lock l(m_mux);
+		if (m_loaded.empty())
+			return;
+
+		std::swap(loaded, m_loaded);
+		std::ranges::sort(loaded, [this](const LoadedAsset& a, const LoadedAsset& b) {
+			return QueueKey{ m_requests.at(a.p_asset).priority, a.request_id } < QueueKey{ m_requests.at(b.p_asset).priority, b.request_id };
+		});
+
+		std::vector<uint64_t> upload_sizes;
+		for (const auto& asset : loaded) {
+			upload_sizes.push_back(asset.upload_size);
+		}
+
+		size_t num_to_upload = GetNumWithinBudget(upload_sizes, upload_budget_bytes);
+		if (num_to_upload < loaded.size()) {
+			std::move(loaded.begin() + num_to_upload, loaded.end(), std::back_inserter(m_loaded));
+			loaded.erase(loaded.begin() + num_to_upload, loaded.end());
+			m_stats.num_budget_limited_frames++;
+		}
+	}
+
+	uint64_t texture_upload_size = 0;
+	for (const auto& asset : loaded) {
+		if (asset.success && dynamic_cast<Texture2DAsset*>(asset.p_asset))
+			texture_upload_size += asset.upload_size;
+	}
+
+	auto p_batch = std::make_unique<UploadBatch>(texture_upload_size);
+	std::vector<Texture2DAsset*> staged_textures;
+
+	for (auto& asset : loaded) {
+		if (!asset.success) {
+			// Left with its placeholder
+			SetState(asset.p_asset, RequestState::FAILED);
+			m_stats.num_failed++;
+			continue;
+		}
+
+		if (auto* p_tex = dynamic_cast<Texture2DAsset*>(asset.p_asset)) {
+			if (StageTexture(p_tex, asset, *p_batch))
+				staged_textures.push_back(p_tex);
+		}
+		else {
+			SetState(asset.p_asset, RequestState::UPLOADING);
+			m_stats.bytes_uploaded += asset.upload_size;
+			AssetManager::Get().mesh_buffer_manager.QueueMeshUpload(static_cast<MeshDataAsset*>(asset.p_asset), std::move(asset.mesh_upload));
+		}
+	}
+
+	if (staged_textures.empty())
+		return;
+
+	p_batch->Submit();
+	m_in_flight_batches.push_back(std::move(p_batch));
+
+	// Replaces the placeholder descriptor at the index materials already reference
+	for (auto* p_tex : staged_textures) {
+		AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(p_tex);
+		OnResident(p_tex);
+	}
+}
+
+bool AssetStreamer::StageTexture(Texture2DAsset* p_tex, LoadedAsset& loaded, UploadBatch& batch) {
+	// Also catches identical textures uploaded earlier in this batch, their hash is indexed as soon as they're staged
+	if (auto* p_existing = AssetManager::FindAssetByContentHash<Texture2DAsset>(loaded.content_hash)) {
+		auto& stats = AssetManager::GetContentDedupStats();
+		stats.num_textures++;
+		stats.texture_bytes_saved += AssetLoader::GetTextureGPUSize(p_existing->image.GetSpec());
+		m_stats.num_deduplicated++;
+		SNK_CORE_INFO("Texture '{}' is identical to '{}', sharing it", p_tex->filepath, p_existing->filepath);
+
+		MergeDuplicateTexture(p_tex, p_existing);
+		return false;
+	}
+
+	auto full_spec = p_tex->image.GetSpec();
+	p_tex->image.SetSpec(TextureResidencyManager::GetResidentSpec(full_spec, loaded.resident_top));
+	p_tex->image.CreateImage();
+	AssetLoader::StageTextureMips(*p_tex, loaded.file_contents, batch);
+
+	if (loaded.managed_residency)
+		TextureResidencyManager::Register(p_tex, p_tex->filepath, full_spec, loaded.resident_top);
+
+	AssetManager::SetContentHash(p_tex, loaded.content_hash);
+	m_stats.bytes_uploaded += loaded.upload_size;
+	return true;
+}
+
+void AssetStreamer::MergeDuplicateTexture(Texture2DAsset* p_duplicate, Texture2DAsset* p_existing) {
+	for (auto* p_mat : AssetManager::GetView<MaterialAsset, true>()) {
+		bool uses_duplicate = false;
+
+		for (auto* p_tex_ref : { &p_mat->albedo_tex, &p_mat->normal_tex, &p_mat->roughness_tex, &p_mat->metallic_tex, &p_mat->ao_tex }) {
+			if (p_tex_ref->get() == p_duplicate) {
+				*p_tex_ref = AssetRef<Texture2DAsset>(p_existing);
+				uses_duplicate = true;
+			}
+		}
+
+		if (uses_duplicate)
+			p_mat->DispatchUpdateEvent();
+	}
+
+	// Same end state as a duplicate found by AssetLoader::DeserializeTexture2D, the UUID resolves to the existing texture
+	uint64_t uuid = p_duplicate->uuid();
+	AssetManager::DeleteAsset(p_duplicate);
+	AssetManager::AddAlias(uuid, p_existing);
+}
+
+void AssetStreamer::OnResident(Asset* p_asset) {
+	std::scoped_lock l(m_mux);
+
+	// MeshDataLoadedEvent is also dispatched for meshes that weren't streamed
+	if (m_requests.erase(p_asset))
+		m_stats.num_resident++;
+}
+
+void AssetStreamer::OnAssetDestroyed(Asset* p_asset) {
+	std::scoped_lock l(m_mux);
+
+	auto it = m_requests.find(p_asset);
+	if (it == m_requests.end())
+		return;
+
+	// Requests being loaded have their result dropped by the worker once it sees the request is gone
+	if (it->second.state == RequestState::QUEUED)
+		m_queue.erase(QueueKey{ it->second.priority, it->second.id });
+
+	std::erase_if(m_loaded, [&](const LoadedAsset& loaded) { return loaded.p_asset == p_asset; });
+	m_requests.erase(it);
+}
@@ -0,0 +1,105 @@
+#include "pch/pch.h"
+#include "assets/MeshData.h"
+#include "util/Hash.h"
+
+using namespace SNAKE;
+
+std::vector<ExtraMath::AABB> MeshData::CalculateSubmeshAABBs() const {
+	std::vector<ExtraMath::AABB> aabbs(submeshes.size());
+
+	for (size_t i = 0; i < submeshes.size(); i++) {
+		auto& submesh = submeshes[i];
+		auto& aabb = aabbs[i];
+
+		for (unsigned v = submesh.base_vertex; v < submesh.base_vertex + submesh.num_vertices; v++) {
+			aabb.Extend({ positions[v].x, positions[v].y, positions[v].z });
+		}
+
+		// Degenerate submesh, collapse to a point so it still produces valid culling bounds
+		if (!aabb.IsValid())
+			aabb.min = aabb.max = glm::vec3(0);
+	}
+
+	return aabbs;
+}
+
+OccluderMeshData MeshData::GenerateOccluderMesh(uint32_t grid_resolution) const {
+	OccluderMeshData occluder;
+
+	ExtraMath::AABB bounds;
+	for (unsigned v = 0; v < num_vertices; v++) {
+		bounds.Extend({ positions[v].x, positions[v].y, positions[v].z });
+	}
+
+	if (!bounds.IsValid())
+		return occluder;
+
+	glm::vec3 cell_scale = glm::vec3((float)grid_resolution) / glm::max(bounds.max - bounds.min, glm::vec3(1e-6f));
+
+	// Maps grid cell -> occluder vertex, position_sums accumulates the vertices in each cell until averaged
+	std::unordered_map<uint32_t, uint32_t> cell_to_vertex;
+	std::vector<glm::vec3> position_sums;
+	std::vector<uint32_t> cell_counts;
+	std::vector<uint32_t> vertex_remap(num_vertices);
+
+	for (unsigned v = 0; v < num_vertices; v++) {
+		glm::vec3 p{ positions[v].x, positions[v].y, positions[v].z };
+		glm::uvec3 cell = glm::min(glm::uvec3((p - bounds.min) * cell_scale), glm::uvec3(grid_resolution - 1));
+		uint32_t key = cell.x + cell.y * grid_resolution + cell.z * grid_resolution * grid_resolution;
+
+		auto [it, inserted] = cell_to_vertex.try_emplace(key, (uint32_t)position_sums.size());
+		if (inserted) {
+			position_sums.push_back(glm::vec3(0));
+			cell_counts.push_back(0);
+		}
+
+		position_sums[it->second] += p;
+		cell_counts[it->second]++;
+		vertex_remap[v] = it->second;
+	}
+
+	occluder.positions.resize(position_sums.size());
+	for (size_t i = 0; i < position_sums.size(); i++) {
+		occluder.positions[i] = position_sums[i] / (float)cell_counts[i];
+	}
+
+	for (auto& submesh : submeshes) {
+		for (unsigned i = submesh.base_index; i + 2 < submesh.base_index + submesh.num_indices; i += 3) {
+			uint32_t a = vertex_remap[submesh.base_vertex + indices[i]];
+			uint32_t b = vertex_remap[submesh.base_vertex + indices[i + 1]];
+			uint32_t c = vertex_remap[submesh.base_vertex + indices[i + 2]];
+
+			if (a == b || b == c || a == c)
+				continue;
+
+			occluder.indices.push_back(a);
+			occluder.indices.push_back(b);
+			occluder.indices.push_back(c);
+		}
+	}
+
+	return occluder;
+}
+
+uint64_t MeshData::CalculateContentHash() const {
+	Hasher hasher;
+	hasher.Container(submeshes);
+	hasher.Value(num_vertices);
+	hasher.Value(num_indices);
+	hasher.Update(positions, num_vertices * sizeof(aiVector3D));
+	hasher.Update(normals, num_vertices * sizeof(aiVector3D));
+	hasher.Update(tangents, num_vertices * sizeof(aiVector3D));
+	hasher.Update(tex_coords, num_vertices * sizeof(aiVector2D));
+	hasher.Update(indices, num_indices * sizeof(unsigned));
+
+	hasher.Value((uint64_t)lods.size());
+	for (auto& lod : lods) {
+		hasher.Value(lod.error);
+		hasher.Container(lod.submeshes);
+	}
+
+	hasher.Container(meshlets);
+	hasher.Container(submesh_meshlets);
+
+	return hasher.Digest();
+}
@@ -0,0 +1,367 @@
+#include "pch/pch.h"
+#include "assets/MeshOptimizer.h"
+
+using namespace SNAKE;
+
+namespace {
+	// Forsyth's "Linear-Speed Vertex Cache Optimisation" scoring, the modelled cache is larger than the real one so scores fall off smoothly
+	constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	float VertexScore(int32_t cache_position, uint32_t num_live_triangles) {
+		// Vertices with no triangles left to emit should never attract the next triangle
+		if (num_live_triangles == 0)
+			return -1.f;
+
+		float score = 0.f;
+		if (cache_position >= 0) {
+			// The vertices of the last triangle are deliberately scored lower so strips don't turn back on themselves
+			if (cache_position < 3)
+				score = LAST_TRIANGLE_SCORE;
+			else
+				score = glm::pow(1.f - (float)(cache_position - 3) / (FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+
+		// Favour vertices with few triangles left so they are finished off instead of being left stranded
+		return score + VALENCE_BOOST_SCALE * glm::pow((float)num_live_triangles, -VALENCE_BOOST_POWER);
+	}
+
+	// FIFO cache simulation, a vertex is cached if fewer than 'cache_size' misses happened since it was last transformed
+	struct FifoCache {
+		FifoCache(uint32_t num_vertices, uint32_t _cache_size) : timestamps(num_vertices, 0), cache_size(_cache_size), time(_cache_size + 1) {}
+
+		// Returns true on a miss
+		bool Access(uint32_t v) {
+			if (time - timestamps[v] <= cache_size)
+				return false;
+
+			timestamps[v] = time++;
+			return true;
+		}
+
+		// Evicts everything
+		void Flush() {
+			time += cache_size + 1;
+		}
+
+		std::vector<uint32_t> timestamps;
+		uint32_t cache_size;
+		uint32_t time;
+	};
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size) {
+	VertexCacheStats stats;
+	stats.num_triangles = num_indices / 3;
+
+	FifoCache cache{ num_vertices, cache_size };
+	for (uint32_t i = 0; i < stats.num_triangles * 3; i++) {
+		stats.num_misses += cache.Access(indices[i]);
+	}
+
+	stats.num_vertices_referenced = (uint32_t)std::ranges::count_if(cache.timestamps, [](uint32_t timestamp) { return timestamp != 0; });
+	return stats;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices) {
+	uint32_t num_triangles = num_indices / 3;
+	std::vector<uint32_t> output;
+	output.reserve(num_triangles * 3);
+
+	if (num_triangles == 0)
+		return output;
+
+	std::vector<uint32_t> num_live_triangles(num_vertices, 0);
+	for (uint32_t i = 0; i < num_triangles * 3; i++) {
+		num_live_triangles[indices[i]]++;
+	}
+
+	// Triangles using each vertex, the live ones of vertex v are adjacency[adjacency_offsets[v] .. adjacency_offsets[v] + num_live_triangles[v]]
+	std::vector<uint32_t> adjacency_offsets(num_vertices + 1, 0);
+	for (uint32_t v = 0; v < num_vertices; v++) {
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + num_live_triangles[v];
+	}
+
+	std::vector<uint32_t> adjacency(num_triangles * 3);
+	std::vector<uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+	for (uint32_t i = 0; i < num_triangles * 3; i++) {
+		adjacency[fill_offsets[indices[i]]++] = i / 3;
+	}
+
+	std::vector<float> vertex_scores(num_vertices);
+	for (uint32_t v = 0; v < num_vertices; v++) {
+		vertex_scores[v] = VertexScore(-1, num_live_triangles[v]);
+	}
+
+	std::vector<float> triangle_scores(num_triangles);
+	for (uint32_t t = 0; t < num_triangles; t++) {
+		triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+	}
+
+	std::vector<bool> emitted(num_triangles, false);
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> new_cache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	int64_t best_triangle = std::distance(triangle_scores.begin(), std::ranges::max_element(triangle_scores));
+	uint32_t scan_cursor = 0;
+
+	for (uint32_t n = 0; n < num_triangles; n++) {
+		// Nothing in the cache has triangles left, restart from the next unemitted triangle
+		if (best_triangle < 0) {
+			while (emitted[scan_cursor])
+				scan_cursor++;
+
+			best_triangle = scan_cursor;
+		}
+
+		uint32_t t = (uint32_t)best_triangle;
+		const uint32_t* tri = &indices[t * 3];
+		output.insert(output.end(), tri, tri + 3);
+		emitted[t] = true;
+
+		new_cache.clear();
+		for (uint32_t k = 0; k < 3; k++) {
+			uint32_t v = tri[k];
+
+			// Swap remove the triangle from the vertex's live range, degenerate triangles are listed once per use
+			uint32_t live_begin = adjacency_offsets[v];
+			uint32_t live_end = live_begin + num_live_triangles[v];
+			auto it = std::find(adjacency.begin() + live_begin, adjacency.begin() + live_end, t);
+			std::iter_swap(it, adjacency.begin() + live_end - 1);
+			num_live_triangles[v]--;
+
+			if (std::ranges::find(new_cache, v) == new_cache.end())
+				new_cache.push_back(v);
+		}
+
+		// The triangle's vertices move to the front, everything else shifts back behind them
+		size_t num_triangle_vertices = new_cache.size();
+		for (uint32_t v : cache) {
+			if (std::find(new_cache.begin(), new_cache.begin() + num_triangle_vertices, v) == new_cache.begin() + num_triangle_vertices)
+				new_cache.push_back(v);
+		}
+
+		// Rescore everything whose cache position changed, including vertices that just fell out of the cache
+		for (uint32_t i = 0; i < new_cache.size(); i++) {
+			uint32_t v = new_cache[i];
+			int32_t position = i < FORSYTH_CACHE_SIZE ? (int32_t)i : -1;
+
+			float score = VertexScore(position, num_live_triangles[v]);
+			float delta = score - vertex_scores[v];
+			vertex_scores[v] = score;
+
+			for (uint32_t a = adjacency_offsets[v]; a < adjacency_offsets[v] + num_live_triangles[v]; a++) {
+				triangle_scores[adjacency[a]] += delta;
+			}
+		}
+
+		new_cache.resize(glm::min<size_t>(new_cache.size(), FORSYTH_CACHE_SIZE));
+		std::swap(cache, new_cache);
+
+		// Only triangles touching the cache are considered, this keeps each step proportional to the cache size
+		best_triangle = -1;
+		float best_score = -std::numeric_limits<float>::max();
+		for (uint32_t v : cache) {
+			for (uint32_t a = adjacency_offsets[v]; a < adjacency_offsets[v] + num_live_triangles[v]; a++) {
+				if (triangle_scores[adjacency[a]] > best_score) {
+					best_score = triangle_scores[adjacency[a]];
+					best_triangle = adjacency[a];
+				}
+			}
+		}
+	}
+
+	return output;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeOverdraw(const aiVector3D* positions, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices, float threshold) {
+	uint32_t num_triangles = num_indices / 3;
+	if (num_triangles < 2)
+		return std::vector<uint32_t>(indices, indices + num_triangles * 3);
+
+	float mesh_acmr = AnalyzeVertexCache(indices, num_indices, num_vertices).GetACMR();
+
+	// Hard boundaries are triangles where the cache order already restarted (every vertex missed), splitting there costs nothing
+	std::vector<uint32_t> hard_starts;
+	FifoCache cache{ num_vertices, SIMULATED_CACHE_SIZE };
+	for (uint32_t t = 0; t < num_triangles; t++) {
+		uint32_t misses = cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+		if (t == 0 || misses == 3)
+			hard_starts.push_back(t);
+	}
+	hard_starts.push_back(num_triangles);
+
+	// Hard clusters are split further wherever the cluster so far, simulated from a cold cache, is within the ACMR threshold
+	std::vector<uint32_t> cluster_starts;
+	for (size_t h = 0; h + 1 < hard_starts.size(); h++) {
+		uint32_t cluster_start = hard_starts[h];
+		uint32_t cluster_misses = 0;
+		cluster_starts.push_back(cluster_start);
+		cache.Flush();
+
+		for (uint32_t t = hard_starts[h]; t < hard_starts[h + 1]; t++) {
+			cluster_misses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+
+			if (t + 1 < hard_starts[h + 1] && cluster_misses <= threshold * mesh_acmr * (t + 1 - cluster_start)) {
+				cluster_start = t + 1;
+				cluster_misses = 0;
+				cluster_starts.push_back(cluster_start);
+				cache.Flush();
+			}
+		}
+	}
+	cluster_starts.push_back(num_triangles);
+
+	auto pos = [&](uint32_t v) {
+		return glm::vec3(positions[v].x, positions[v].y, positions[v].z);
+	};
+
+	struct Cluster {
+		uint32_t start;
+		uint32_t end;
+		glm::vec3 centroid{ 0 };
+		glm::vec3 normal{ 0 };
+		float sort_key = 0.f;
+	};
+
+	std::vector<Cluster> clusters(cluster_starts.size() - 1);
+	glm::vec3 mesh_centroid{ 0 };
+	float mesh_area = 0.f;
+
+	for (size_t c = 0; c < clusters.size(); c++) {
+		auto& cluster = clusters[c];
+		cluster.start = cluster_starts[c];
+		cluster.end = cluster_starts[c + 1];
+
+		float cluster_area = 0.f;
+		for (uint32_t t = cluster.start; t < cluster.end; t++) {
+			glm::vec3 p0 = pos(indices[t * 3]);
+			glm::vec3 p1 = pos(indices[t * 3 + 1]);
+			glm::vec3 p2 = pos(indices[t * 3 + 2]);
+
+			// Length of the cross product is twice the area, the factor cancels out of every weighted average
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(n);
+
+			cluster.centroid += (p0 + p1 + p2) * (area / 3.f);
+			cluster.normal += n;
+			cluster_area += area;
+		}
+
+		mesh_centroid += cluster.centroid;
+		mesh_area += cluster_area;
+		cluster.centroid = cluster_area > 0.f ? cluster.centroid / cluster_area : pos(indices[cluster.start * 3]);
+	}
+
+	mesh_centroid = mesh_area > 0.f ? mesh_centroid / mesh_area : glm::vec3(0);
+
+	// Clusters facing away from the centre are on the outside of the mesh and cover the clusters behind them
+	for (auto& cluster : clusters) {
+		float normal_length = glm::length(cluster.normal);
+		cluster.sort_key = normal_length > 0.f ? glm::dot(cluster.centroid - mesh_centroid, cluster.normal / normal_length) : 0.f;
+	}
+
+	std::ranges::stable_sort(clusters, [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+	std::vector<uint32_t> output;
+	output.reserve(num_triangles * 3);
+	for (auto& cluster : clusters) {
+		output.insert(output.end(), indices + cluster.start * 3, indices + cluster.end * 3);
+	}
+
+	return output;
+}
+
+namespace {
+	template<typename T>
+	void PermuteVertices(T* p_data, unsigned base_vertex, const std::vector<uint32_t>& remap) {
+		if (!p_data)
+			return;
+
+		std::vector<T> original(p_data + base_vertex, p_data + base_vertex + remap.size());
+		for (size_t v = 0; v < remap.size(); v++) {
+			p_data[base_vertex + remap[v]] = original[v];
+		}
+	}
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData& data) {
+	for (size_t s = 0; s < data.submeshes.size(); s++) {
+		auto& submesh = data.submeshes[s];
+
+		// LOD levels that couldn't be reduced further share the previous level's range, each range must only be remapped once
+		std::vector<SubmeshLOD> ranges{ SubmeshLOD{ submesh.base_index, submesh.num_indices } };
+		for (auto& lod : data.lods) {
+			if (std::ranges::none_of(ranges, [&](const SubmeshLOD& range) { return range.base_index == lod.submeshes[s].base_index; }))
+				ranges.push_back(lod.submeshes[s]);
+		}
+
+		constexpr uint32_t UNASSIGNED = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> remap(submesh.num_vertices, UNASSIGNED);
+		uint32_t next_vertex = 0;
+
+		for (auto& range : ranges) {
+			for (unsigned i = range.base_index; i < range.base_index + range.num_indices; i++) {
+				if (remap[data.indices[i]] == UNASSIGNED)
+					remap[data.indices[i]] = next_vertex++;
+			}
+		}
+
+		for (auto& new_index : remap) {
+			if (new_index == UNASSIGNED)
+				new_index = next_vertex++;
+		}
+
+		for (auto& range : ranges) {
+			for (unsigned i = range.base_index; i < range.base_index + range.num_indices; i++) {
+				data.indices[i] = remap[data.indices[i]];
+			}
+		}
+
+		PermuteVertices(data.positions, submesh.base_vertex, remap);
+		PermuteVertices(data.normals, submesh.base_vertex, remap);
+		PermuteVertices(data.tangents, submesh.base_vertex, remap);
+		PermuteVertices(data.tex_coords, submesh.base_vertex, remap);
+	}
+}
+
+MeshOptimizer::Report MeshOptimizer::OptimizeMesh(MeshData& data, float overdraw_threshold) {
+	Report report;
+	if (!data.positions || !data.indices)
+		return report;
+
+	for (size_t s = 0; s < data.submeshes.size(); s++) {
+		auto& submesh = data.submeshes[s];
+		unsigned* p_indices = data.indices + submesh.base_index;
+
+		report.before += AnalyzeVertexCache(p_indices, submesh.num_indices, submesh.num_vertices);
+
+		auto cache_ordered = OptimizeVertexCache(p_indices, submesh.num_indices, submesh.num_vertices);
+		auto overdraw_ordered = OptimizeOverdraw(data.positions + submesh.base_vertex, submesh.num_vertices, cache_ordered.data(), (uint32_t)cache_ordered.size(), overdraw_threshold);
+		std::ranges::copy(overdraw_ordered, p_indices);
+
+		std::vector<unsigned> optimized_lod_ranges;
+		for (auto& lod : data.lods) {
+			auto& range = lod.submeshes[s];
+			if (range.base_index == submesh.base_index || std::ranges::find(optimized_lod_ranges, range.base_index) != optimized_lod_ranges.end())
+				continue;
+
+			auto lod_ordered = OptimizeVertexCache(data.indices + range.base_index, range.num_indices, submesh.num_vertices);
+			std::ranges::copy(lod_ordered, data.indices + range.base_index);
+			optimized_lod_ranges.push_back(range.base_index);
+		}
+	}
+
+	OptimizeVertexFetch(data);
+
+	for (auto& submesh : data.submeshes) {
+		report.after += AnalyzeVertexCache(data.indices + submesh.base_index, submesh.num_indices, submesh.num_vertices);
+	}
+
+	return report;
+}
@@ -0,0 +1,344 @@
+#include "pch/pch.h"
+#include "assets/MeshSimplifier.h"
+
+#include <queue>
+
+using namespace SNAKE;
+
+namespace {
+	// Symmetric 4x4 error quadric stored as its upper triangle, evaluates to the sum of squared distances from its planes
+	struct Quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+
+		static Quadric FromPlane(const glm::dvec3& n, double d) {
+			Quadric q;
+			q.a00 = n.x * n.x; q.a01 = n.x * n.y; q.a02 = n.x * n.z; q.a03 = n.x * d;
+			q.a11 = n.y * n.y; q.a12 = n.y * n.z; q.a13 = n.y * d;
+			q.a22 = n.z * n.z; q.a23 = n.z * d;
+			q.a33 = d * d;
+			return q;
+		}
+
+		Quadric& operator+=(const Quadric& o) {
+			a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+			a11 += o.a11; a12 += o.a12; a13 += o.a13;
+			a22 += o.a22; a23 += o.a23;
+			a33 += o.a33;
+			return *this;
+		}
+
+		double Evaluate(const glm::dvec3& p) const {
+			return a00 * p.x * p.x + 2.0 * a01 * p.x * p.y + 2.0 * a02 * p.x * p.z + 2.0 * a03 * p.x
+				+ a11 * p.y * p.y + 2.0 * a12 * p.y * p.z + 2.0 * a13 * p.y
+				+ a22 * p.z * p.z + 2.0 * a23 * p.z
+				+ a33;
+		}
+	};
+
+	struct Collapse {
+		double cost;
+		uint32_t from;
+		uint32_t to;
+
+		bool operator>(const Collapse& other) const {
+			return cost > other.cost;
+		}
+	};
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const aiVector3D* positions, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices,
+	uint32_t target_index_count, float max_error, float* out_error) {
+	if (out_error)
+		*out_error = 0.f;
+
+	uint32_t num_triangles = num_indices / 3;
+	std::vector<uint32_t> tris(indices, indices + num_triangles * 3);
+
+	auto pos = [&](uint32_t v) {
+		return glm::dvec3(positions[v].x, positions[v].y, positions[v].z);
+	};
+
+	std::vector<bool> triangle_alive(num_triangles, true);
+	uint32_t num_alive = num_triangles;
+
+	// Vertices on edges not shared by exactly two triangles can't move without opening holes or tearing seams
+	std::unordered_map<uint64_t, uint32_t> edge_counts;
+	edge_counts.reserve(num_triangles * 3);
+
+	for (uint32_t t = 0; t < num_triangles; t++) {
+		uint32_t* tri = &tris[t * 3];
+		if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+			triangle_alive[t] = false;
+			num_alive--;
+			continue;
+		}
+
+		for (uint32_t e = 0; e < 3; e++) {
+			uint32_t a = glm::min(tri[e], tri[(e + 1) % 3]);
+			uint32_t b = glm::max(tri[e], tri[(e + 1) % 3]);
+			edge_counts[((uint64_t)a << 32) | b]++;
+		}
+	}
+
+	std::vector<bool> locked(num_vertices, false);
+	for (auto [key, count] : edge_counts) {
+		if (count != 2) {
+			locked[key >> 32] = true;
+			locked[key & 0xFFFFFFFF] = true;
+		}
+	}
+
+	std::vector<Quadric> quadrics(num_vertices);
+	std::vector<std::vector<uint32_t>> vertex_triangles(num_vertices);
+
+	for (uint32_t t = 0; t < num_triangles; t++) {
+		if (!triangle_alive[t])
+			continue;
+
+		uint32_t* tri = &tris[t * 3];
+		glm::dvec3 p0 = pos(tri[0]);
+		glm::dvec3 n = glm::cross(pos(tri[1]) - p0, pos(tri[2]) - p0);
+		double len = glm::length(n);
+
+		for (uint32_t k = 0; k < 3; k++) {
+			vertex_triangles[tri[k]].push_back(t);
+		}
+
+		// Zero area triangles have no plane, they still constrain topology through vertex_triangles
+		if (len < 1e-12)
+			continue;
+
+		n /= len;
+		Quadric q = Quadric::FromPlane(n, -glm::dot(n, p0));
+		for (uint32_t k = 0; k < 3; k++) {
+			quadrics[tri[k]] += q;
+		}
+	}
+
+	auto collapse_cost = [&](uint32_t from, uint32_t to) {
+		Quadric q = quadrics[from];
+		q += quadrics[to];
+		return glm::max(q.Evaluate(pos(to)), 0.0);
+	};
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+	auto push_edge = [&](uint32_t a, uint32_t b) {
+		if (!locked[a])
+			queue.push(Collapse{ collapse_cost(a, b), a, b });
+		if (!locked[b])
+			queue.push(Collapse{ collapse_cost(b, a), b, a });
+	};
+
+	for (auto [key, count] : edge_counts) {
+		push_edge((uint32_t)(key >> 32), (uint32_t)(key & 0xFFFFFFFF));
+	}
+
+	auto gather_neighbours = [&](uint32_t v, std::vector<uint32_t>& out) {
+		out.clear();
+		for (uint32_t t : vertex_triangles[v]) {
+			if (!triangle_alive[t])
+				continue;
+
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t w = tris[t * 3 + k];
+				if (w != v && std::ranges::find(out, w) == out.end())
+					out.push_back(w);
+			}
+		}
+	};
+
+	std::vector<bool> collapsed(num_vertices, false);
+	std::vector<uint32_t> from_neighbours;
+	std::vector<uint32_t> to_neighbours;
+
+	double max_cost = (double)max_error * (double)max_error;
+	double max_applied_cost = 0.0;
+
+	while (num_alive * 3 > target_index_count && !queue.empty()) {
+		Collapse c = queue.top();
+		queue.pop();
+
+		if (collapsed[c.from] || collapsed[c.to])
+			continue;
+
+		// Quadrics only grow as vertices merge so costs never decrease, stale entries are re-queued with their current cost
+		double cost = collapse_cost(c.from, c.to);
+		if (cost > c.cost * (1.0 + 1e-6) + 1e-12) {
+			queue.push(Collapse{ cost, c.from, c.to });
+			continue;
+		}
+
+		if (cost > max_cost)
+			break;
+
+		gather_neighbours(c.from, from_neighbours);
+		if (std::ranges::find(from_neighbours, c.to) == from_neighbours.end())
+			continue;
+
+		// Link condition, an interior edge shares exactly two neighbours, more means the collapse would create a non-manifold edge
+		gather_neighbours(c.to, to_neighbours);
+		uint32_t num_shared = 0;
+		for (uint32_t w : from_neighbours) {
+			num_shared += std::ranges::find(to_neighbours, w) != to_neighbours.end();
+		}
+
+		if (num_shared != 2)
+			continue;
+
+		// Reject the collapse if any remaining triangle around 'from' would flip or degenerate
+		bool flips = false;
+		glm::dvec3 to_pos = pos(c.to);
+		for (uint32_t t : vertex_triangles[c.from]) {
+			uint32_t* tri = &tris[t * 3];
+			if (!triangle_alive[t] || tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+				continue;
+
+			glm::dvec3 p[3] = { pos(tri[0]), pos(tri[1]), pos(tri[2]) };
+			glm::dvec3 n_old = glm::cross(p[1] - p[0], p[2] - p[0]);
+			for (uint32_t k = 0; k < 3; k++) {
+				if (tri[k] == c.from)
+					p[k] = to_pos;
+			}
+			glm::dvec3 n_new = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+			if (glm::dot(n_old, n_new) <= 0.25 * glm::length(n_old) * glm::length(n_new) || glm::length(n_new) < 1e-12) {
+				flips = true;
+				break;
+			}
+		}
+
+		if (flips)
+			continue;
+
+		for (uint32_t t : vertex_triangles[c.from]) {
+			if (!triangle_alive[t])
+				continue;
+
+			uint32_t* tri = &tris[t * 3];
+			if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+				triangle_alive[t] = false;
+				num_alive--;
+				continue;
+			}
+
+			for (uint32_t k = 0; k < 3; k++) {
+				if (tri[k] == c.from)
+					tri[k] = c.to;
+			}
+			vertex_triangles[c.to].push_back(t);
+		}
+
+		collapsed[c.from] = true;
+		quadrics[c.to] += quadrics[c.from];
+		vertex_triangles[c.from].clear();
+		std::erase_if(vertex_triangles[c.to], [&](uint32_t t) { return !triangle_alive[t]; });
+		max_applied_cost = glm::max(max_applied_cost, cost);
+
+		// Costs around the merged vertex changed, queue them again
+		gather_neighbours(c.to, to_neighbours);
+		for (uint32_t w : to_neighbours) {
+			push_edge(c.to, w);
+		}
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(num_alive * 3);
+	for (uint32_t t = 0; t < num_triangles; t++) {
+		if (!triangle_alive[t])
+			continue;
+
+		for (uint32_t k = 0; k < 3; k++) {
+			SNK_DBG_ASSERT(tris[t * 3 + k] < num_vertices && !collapsed[tris[t * 3 + k]]);
+			output.push_back(tris[t * 3 + k]);
+		}
+	}
+
+	if (out_error)
+		*out_error = (float)glm::sqrt(max_applied_cost);
+
+	return output;
+}
+
+void MeshSimplifier::GenerateLODs(MeshData& data, float reduction) {
+	data.lods.clear();
+	if (data.submeshes.empty() || !data.positions || !data.indices)
+		return;
+
+	ExtraMath::AABB bounds;
+	for (auto& aabb : data.CalculateSubmeshAABBs()) {
+		bounds.Extend(aabb.min);
+		bounds.Extend(aabb.max);
+	}
+	float bounds_diagonal = glm::max(glm::length(bounds.max - bounds.min), 1e-6f);
+
+	std::vector<SubmeshLOD> prev_level(data.submeshes.size());
+	uint32_t full_index_count = 0;
+	for (size_t s = 0; s < data.submeshes.size(); s++) {
+		prev_level[s] = SubmeshLOD{ data.submeshes[s].base_index, data.submeshes[s].num_indices };
+		full_index_count += data.submeshes[s].num_indices;
+	}
+
+	uint32_t prev_index_count = full_index_count;
+	float prev_error = 0.f;
+
+	// Indices of every generated level, appended after the full detail indices once generation finishes
+	std::vector<uint32_t> lod_indices;
+
+	for (uint32_t level = 1; level <= MeshData::MAX_LODS; level++) {
+		MeshLOD lod;
+		lod.error = prev_error;
+		lod.submeshes.resize(data.submeshes.size());
+
+		size_t level_start = lod_indices.size();
+		uint32_t level_index_count = 0;
+
+		for (size_t s = 0; s < data.submeshes.size(); s++) {
+			auto& submesh = data.submeshes[s];
+			uint32_t target = (uint32_t)(submesh.num_indices * glm::pow(reduction, (float)level)) / 3 * 3;
+
+			// Always simplified from full detail so errors are measured against the original surface
+			float error = 0.f;
+			auto simplified = Simplify(data.positions + submesh.base_vertex, submesh.num_vertices, data.indices + submesh.base_index,
+				submesh.num_indices, target, std::numeric_limits<float>::max(), &error);
+
+			if (simplified.size() < prev_level[s].num_indices) {
+				lod.submeshes[s] = SubmeshLOD{ data.num_indices + (unsigned)lod_indices.size(), (unsigned)simplified.size() };
+				lod_indices.insert(lod_indices.end(), simplified.begin(), simplified.end());
+				lod.error = glm::max(lod.error, error);
+			}
+			else {
+				// No further reduction possible (e.g. fully locked by seams), reuse the previous level's indices
+				lod.submeshes[s] = prev_level[s];
+			}
+
+			level_index_count += lod.submeshes[s].num_indices;
+		}
+
+		if (level_index_count > prev_index_count * MAX_LOD_TRIANGLE_RATIO) {
+			lod_indices.resize(level_start);
+			break;
+		}
+
+		SNK_CORE_INFO("Generated mesh LOD {}: {} -> {} triangles ({:.1f}% of full detail), error {:.5f} ({:.3f}% of bounds diagonal)",
+			level, prev_index_count / 3, level_index_count / 3, 100.f * level_index_count / full_index_count, lod.error, 100.f * lod.error / bounds_diagonal);
+
+		prev_level = lod.submeshes;
+		prev_index_count = level_index_count;
+		prev_error = lod.error;
+		data.lods.push_back(std::move(lod));
+	}
+
+	if (lod_indices.empty())
+		return;
+
+	auto* p_indices = new unsigned[data.num_indices + lod_indices.size()];
+	memcpy(p_indices, data.indices, data.num_indices * sizeof(unsigned));
+	memcpy(p_indices + data.num_indices, lod_indices.data(), lod_indices.size() * sizeof(unsigned));
+
+	delete[] data.indices;
+	data.indices = p_indices;
+	data.num_indices += (unsigned)lod_indices.size();
+}
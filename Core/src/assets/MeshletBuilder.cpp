@@ -0,0 +1,153 @@
+#include "pch/pch.h"
+#include "assets/MeshletBuilder.h"
+
+using namespace SNAKE;
+
+void MeshletBuilder::BuildMeshlets(MeshData& data) {
+	data.meshlets.clear();
+	data.submesh_meshlets.clear();
+	data.submesh_meshlets.resize(data.submeshes.size());
+
+	if (!data.positions || !data.indices)
+		return;
+
+	// Meshlet each vertex was last added to, avoids clearing a set between meshlets
+	std::vector<uint32_t> vertex_meshlet;
+
+	for (uint32_t s = 0; s < data.submeshes.size(); s++) {
+		auto& submesh = data.submeshes[s];
+		auto& range = data.submesh_meshlets[s];
+		range.first_meshlet = (uint32_t)data.meshlets.size();
+
+		vertex_meshlet.assign(submesh.num_vertices, std::numeric_limits<uint32_t>::max());
+		const aiVector3D* p_positions = data.positions + submesh.base_vertex;
+
+		Meshlet current;
+		current.base_index = submesh.base_index;
+		current.submesh_idx = s;
+
+		auto finish_meshlet = [&]() {
+			if (current.num_indices == 0)
+				return;
+
+			ComputeBounds(p_positions, data.indices + current.base_index, current.num_indices, current);
+			data.meshlets.push_back(current);
+
+			current = Meshlet{};
+			current.submesh_idx = s;
+		};
+
+		for (unsigned i = submesh.base_index; i + 2 < submesh.base_index + submesh.num_indices; i += 3) {
+			const unsigned* tri = data.indices + i;
+			uint32_t meshlet_id = (uint32_t)data.meshlets.size();
+			uint32_t new_vertices = 0;
+			for (uint32_t k = 0; k < 3; k++) {
+				// Repeated vertices of a degenerate triangle only count once
+				bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+				if (!repeated && vertex_meshlet[tri[k]] != meshlet_id)
+					new_vertices++;
+			}
+
+			if (current.num_vertices + new_vertices > MAX_VERTICES || current.num_indices / 3 + 1 > MAX_TRIANGLES) {
+				finish_meshlet();
+				current.base_index = i;
+				meshlet_id = (uint32_t)data.meshlets.size();
+			}
+
+			for (uint32_t k = 0; k < 3; k++) {
+				if (vertex_meshlet[tri[k]] != meshlet_id) {
+					vertex_meshlet[tri[k]] = meshlet_id;
+					current.num_vertices++;
+				}
+			}
+
+			current.num_indices += 3;
+		}
+
+		finish_meshlet();
+		range.num_meshlets = (uint32_t)data.meshlets.size() - range.first_meshlet;
+	}
+}
+
+void MeshletBuilder::ComputeBounds(const aiVector3D* positions, const uint32_t* indices, uint32_t num_indices, Meshlet& meshlet) {
+	auto pos = [&](uint32_t i) {
+		return glm::vec3(positions[indices[i]].x, positions[indices[i]].y, positions[indices[i]].z);
+	};
+
+	// Ritter's sphere, starting from an approximately most distant pair then growing to cover anything left outside
+	glm::vec3 a = pos(0);
+	float max_dist = -1.f;
+	for (uint32_t i = 0; i < num_indices; i++) {
+		if (float dist = glm::distance(pos(0), pos(i)); dist > max_dist) {
+			max_dist = dist;
+			a = pos(i);
+		}
+	}
+
+	glm::vec3 b = a;
+	max_dist = -1.f;
+	for (uint32_t i = 0; i < num_indices; i++) {
+		if (float dist = glm::distance(a, pos(i)); dist > max_dist) {
+			max_dist = dist;
+			b = pos(i);
+		}
+	}
+
+	glm::vec3 center = (a + b) * 0.5f;
+	float radius = glm::distance(a, b) * 0.5f;
+	for (uint32_t i = 0; i < num_indices; i++) {
+		float dist = glm::distance(center, pos(i));
+		if (dist > radius) {
+			float new_radius = (radius + dist) * 0.5f;
+			center += (pos(i) - center) * ((new_radius - radius) / dist);
+			radius = new_radius;
+		}
+	}
+
+	meshlet.center = center;
+	meshlet.radius = radius;
+
+	// Zero area triangles are never rasterised so they don't constrain the cone
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec3> normal_origins;
+	glm::vec3 normal_sum{ 0 };
+	for (uint32_t i = 0; i + 2 < num_indices; i += 3) {
+		glm::vec3 n = glm::cross(pos(i + 1) - pos(i), pos(i + 2) - pos(i));
+		float len = glm::length(n);
+		if (len <= 0.f)
+			continue;
+
+		normals.push_back(n / len);
+		normal_origins.push_back(pos(i));
+		normal_sum += n / len;
+	}
+
+	meshlet.cone_axis = glm::vec3(0, 0, 1);
+	meshlet.cone_apex = center;
+	meshlet.cone_cutoff = 2.f;
+
+	float axis_length = glm::length(normal_sum);
+	if (normals.empty() || axis_length <= 1e-6f)
+		return;
+
+	glm::vec3 axis = normal_sum / axis_length;
+	float min_dot = 1.f;
+	for (auto& n : normals) {
+		min_dot = glm::min(min_dot, glm::dot(n, axis));
+	}
+
+	// Some normal is 90 degrees or more from the axis, there is always a direction it faces
+	if (min_dot <= 0.f)
+		return;
+
+	// The apex is the furthest point forward along the axis through the sphere center that is behind every triangle's plane
+	float max_t = -std::numeric_limits<float>::max();
+	for (size_t t = 0; t < normals.size(); t++) {
+		max_t = glm::max(max_t, glm::dot(center - normal_origins[t], normals[t]) / glm::dot(axis, normals[t]));
+	}
+
+	// Widening the normal cone's half angle by 90 degrees gives the cone of view directions every triangle faces away from
+	meshlet.cone_axis = axis;
+	meshlet.cone_apex = center - axis * max_t;
+	meshlet.cone_cutoff = glm::sqrt(1.f - min_dot * min_dot);
+}
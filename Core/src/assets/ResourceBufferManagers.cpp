@@ -4,11 +4,33 @@
 
 using namespace SNAKE;
 
+uint32_t BindlessSlotAllocator::Allocate() {
+	if (m_free_indices.empty())
+		return m_next_index++;
+
+	uint32_t index = m_free_indices.back();
+	m_free_indices.pop_back();
+	return index;
+}
+
+void BindlessSlotAllocator::Release(uint32_t index, uint64_t frame) {
+	SNK_ASSERT(index < m_next_index);
+	m_released.push_back(ReleasedIndex{ index, frame });
+}
+
+void BindlessSlotAllocator::Reclaim(uint64_t frame) {
+	// A frame's fence has been waited on by the time the same frame in flight starts again, MAX_FRAMES_IN_FLIGHT frames later
+	while (!m_released.empty() && frame >= m_released.front().frame + MAX_FRAMES_IN_FLIGHT) {
+		m_free_indices.push_back(m_released.front().index);
+		m_released.pop_front();
+	}
+}
+
 void GlobalMaterialBufferManager::Init(const std::array<std::shared_ptr<DescriptorBuffer>, MAX_FRAMES_IN_FLIGHT>& buffers) {
 	descriptor_buffers = buffers;
 	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		m_material_ubos[i].CreateBuffer(4096 * material_size,
-			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+		m_material_ubos[i].CreateBuffer(INITIAL_CAPACITY * material_size,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
 			VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
 
 		auto info = m_material_ubos[i].CreateDescriptorGetInfo();
@@ -24,6 +46,7 @@ void GlobalMaterialBufferManager::Init(const std::array<std::shared_ptr<Descript
 		};
 
 	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		m_slots.Reclaim(VkContext::GetCurrentFrameIdx());
 		UpdateMaterialUBO();
 		};
 
@@ -44,6 +67,8 @@ void GlobalMaterialBufferManager::Init(const std::array<std::shared_ptr<Descript
 					if (register_it != m_materials_to_register[i].end()) 
 						m_materials_to_register[i].erase(register_it);
 				}
+
+				UnregisterMaterial(p_mat);
 			}
 		}
 	};
@@ -58,13 +83,30 @@ void GlobalMaterialBufferManager::RegisterMaterial(AssetRef<MaterialAsset> mater
 		m_materials_to_register[i].push_back(material);
 		m_materials_to_update[i].push_back(material);
 	}
-	material->m_global_buffer_index = m_current_index++;
+	material->m_global_buffer_index = m_slots.Allocate();
+	while (m_slots.GetHighWater() > m_capacity) {
+		m_capacity *= 2;
+	}
+}
+
+void GlobalMaterialBufferManager::UnregisterMaterial(MaterialAsset* p_mat) {
+	if (p_mat->m_global_buffer_index == MaterialAsset::INVALID_GLOBAL_INDEX)
+		return;
+
+	m_slots.Release(p_mat->m_global_buffer_index, VkContext::GetCurrentFrameIdx());
+	p_mat->m_global_buffer_index = MaterialAsset::INVALID_GLOBAL_INDEX;
 }
 
 void GlobalMaterialBufferManager::UpdateMaterialUBO() {
 	auto frame_in_flight_idx = VkContext::GetCurrentFIF();
+	auto& ubo = m_material_ubos[frame_in_flight_idx];
+
+	// This frame in flight's previous frame has finished, so its buffer can be replaced
+	// Resizing dispatches a resource event which relinks the buffer's descriptor
+	if (ubo.alloc_info.size < (vk::DeviceSize)m_capacity * material_size)
+		ubo.Resize((size_t)m_capacity * material_size);
 
-	std::byte* p_data = reinterpret_cast<std::byte*>(m_material_ubos[frame_in_flight_idx].Map());
+	std::byte* p_data = reinterpret_cast<std::byte*>(ubo.Map());
 
 	for (auto& mat_ref : m_materials_to_update[frame_in_flight_idx]) {
 		SNK_ASSERT(mat_ref->GetGlobalBufferIndex() != MaterialAsset::INVALID_GLOBAL_INDEX);
@@ -105,26 +147,83 @@ void GlobalTextureBufferManager::Init(const std::array<std::shared_ptr<Descripto
 	descriptor_buffers = buffers;
 
 	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		m_slots.Reclaim(VkContext::GetCurrentFrameIdx());
 		RegisterTexturesInternal();
 		};
 
+	m_asset_event_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<AssetEvent const*>(p_event);
+		if (auto* p_tex = dynamic_cast<Texture2DAsset*>(p_casted->p_asset); p_tex && p_casted->type == AssetEventType::DESTROYED)
+			UnregisterTexture(p_tex);
+	};
+
 	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+	EventManagerG::RegisterListener<AssetEvent>(m_asset_event_listener);
+}
+
+uint32_t GlobalTextureBufferManager::GetMaxTextures() {
+	auto& limits = VkContext::GetPhysicalDevice().properties.limits;
+	uint32_t device_max = glm::min(glm::min(limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages),
+		glm::min(limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages));
+
+	// Only the descriptors in use are allocated, the layout's size is just an upper bound
+	return glm::max(glm::min(device_max, 1u << 20), INITIAL_CAPACITY);
+}
+
+uint32_t GlobalTextureBufferManager::AllocateIndex() {
+	uint32_t index = m_slots.Allocate();
+	while (m_slots.GetHighWater() > m_capacity) {
+		m_capacity *= 2;
+	}
+
+	SNK_ASSERT_ARG(m_capacity <= GetMaxTextures(), "GlobalTextureBufferManager ran out of texture descriptors");
+	return index;
+}
+
+void GlobalTextureBufferManager::UnregisterTexture(Texture2DAsset* p_tex) {
+	// Registrations still pending would read the deleted image
+	for (auto& [fif, registrations] : m_textures_to_register) {
+		std::erase_if(registrations, [&](const PendingRegistration& registration) {
+			return registration.global_index == p_tex->m_global_index || registration.image_source.get() == p_tex;
+		});
+	}
+
+	if (p_tex->m_global_index == Texture2DAsset::INVALID_GLOBAL_INDEX)
+		return;
+
+	m_slots.Release(p_tex->m_global_index, VkContext::GetCurrentFrameIdx());
+	p_tex->m_global_index = Texture2DAsset::INVALID_GLOBAL_INDEX;
 }
 
 void GlobalTextureBufferManager::RegisterTexture(AssetRef<Texture2DAsset> tex) {
+	if (tex->m_global_index == Texture2DAsset::INVALID_GLOBAL_INDEX)
+		tex->m_global_index = AllocateIndex();
+
 	for (FrameInFlightIndex i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		m_textures_to_register[i].push_back(tex);
+		m_textures_to_register[i].push_back(PendingRegistration{ tex->m_global_index, tex });
+	}
+}
+
+void GlobalTextureBufferManager::RegisterPlaceholder(AssetRef<Texture2DAsset> tex, AssetRef<Texture2DAsset> placeholder) {
+	SNK_ASSERT(tex->m_global_index == Texture2DAsset::INVALID_GLOBAL_INDEX);
+	tex->m_global_index = AllocateIndex();
+
+	for (FrameInFlightIndex i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		m_textures_to_register[i].push_back(PendingRegistration{ tex->m_global_index, placeholder });
 	}
-	tex->m_global_index = m_current_index++;
 }
 
 void GlobalTextureBufferManager::RegisterTexturesInternal() {
 	auto frame_in_flight_idx = VkContext::GetCurrentFIF();
 
-	for (auto& tex : m_textures_to_register[frame_in_flight_idx]) {
-		auto info = tex->image.CreateDescriptorGetInfo(vk::ImageLayout::eShaderReadOnlyOptimal, vk::DescriptorType::eCombinedImageSampler);
-		descriptor_buffers[frame_in_flight_idx]->LinkResource(&tex->image, info, 1, 0, tex->GetGlobalIndex());
-		
+	// This frame in flight's previous frame has finished, so its buffer can be replaced
+	descriptor_buffers[frame_in_flight_idx]->GrowVariableDescriptorCount(m_capacity);
+
+	// In registration order, so a loaded texture overwrites its placeholder if both are pending
+	for (auto& registration : m_textures_to_register[frame_in_flight_idx]) {
+		auto& image = registration.image_source->image;
+		auto info = image.CreateDescriptorGetInfo(vk::ImageLayout::eShaderReadOnlyOptimal, vk::DescriptorType::eCombinedImageSampler);
+		descriptor_buffers[frame_in_flight_idx]->LinkResource(&image, info, 1, 0, registration.global_index);
 	}
 
 	m_textures_to_register[frame_in_flight_idx].clear();
@@ -0,0 +1,738 @@
+#include "pch/pch.h"
+#include "assets/TextureEncoder.h"
+#include "core/JobSystem.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define SNK_BC_SSE
+#include <immintrin.h>
+#endif
+
+using namespace SNAKE;
+
+namespace {
+	// 16 texels split by channel so four at a time fit an SSE register
+	struct BlockTexels {
+		alignas(16) float channels[4][16];
+	};
+
+	BlockTexels ToBlockTexels(const uint8_t* p_texels) {
+		BlockTexels block;
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				block.channels[c][i] = (float)p_texels[i * 4 + c];
+			}
+		}
+
+		return block;
+	}
+
+	// Picks the closest palette entry for every texel, returns the summed squared error
+	// Channels with a weight of 0 are ignored
+	float FindIndices(const BlockTexels& block, const glm::vec4* palette, uint32_t palette_size, glm::vec4 weights, uint8_t* p_indices) {
+		float total_error = 0.f;
+
+#ifdef SNK_BC_SSE
+		for (int i = 0; i < 16; i += 4) {
+			__m128 texels[4];
+			for (int c = 0; c < 4; c++) {
+				texels[c] = _mm_load_ps(&block.channels[c][i]);
+			}
+
+			__m128 best_error = _mm_set1_ps(std::numeric_limits<float>::max());
+			__m128i best_index = _mm_setzero_si128();
+
+			for (uint32_t p = 0; p < palette_size; p++) {
+				__m128 error = _mm_setzero_ps();
+				for (int c = 0; c < 4; c++) {
+					__m128 diff = _mm_sub_ps(texels[c], _mm_set1_ps(palette[p][c]));
+					error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(diff, diff), _mm_set1_ps(weights[c])));
+				}
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, best_error));
+				best_index = _mm_or_si128(_mm_andnot_si128(closer, best_index), _mm_and_si128(closer, _mm_set1_epi32((int)p)));
+				best_error = _mm_min_ps(error, best_error);
+			}
+
+			alignas(16) int32_t indices[4];
+			alignas(16) float errors[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), best_index);
+			_mm_store_ps(errors, best_error);
+
+			for (int j = 0; j < 4; j++) {
+				p_indices[i + j] = (uint8_t)indices[j];
+				total_error += errors[j];
+			}
+		}
+#else
+		for (int i = 0; i < 16; i++) {
+			float best_error = std::numeric_limits<float>::max();
+
+			for (uint32_t p = 0; p < palette_size; p++) {
+				float error = 0.f;
+				for (int c = 0; c < 4; c++) {
+					float diff = block.channels[c][i] - palette[p][c];
+					error += diff * diff * weights[c];
+				}
+
+				if (error < best_error) {
+					best_error = error;
+					p_indices[i] = (uint8_t)p;
+				}
+			}
+
+			total_error += best_error;
+		}
+#endif
+
+		return total_error;
+	}
+
+	// Endpoints spanning the block along its principal axis, in the channels with a non-zero weight
+	std::pair<glm::vec4, glm::vec4> FitEndpoints(const BlockTexels& block, glm::vec4 weights) {
+		glm::vec4 mean{ 0.f };
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				mean[c] += block.channels[c][i] * weights[c];
+			}
+		}
+		mean /= 16.f;
+
+		glm::mat4 covariance{ 0.f };
+		glm::vec4 min{ 255.f }, max{ 0.f };
+		for (int i = 0; i < 16; i++) {
+			glm::vec4 texel;
+			for (int c = 0; c < 4; c++) {
+				texel[c] = block.channels[c][i] * weights[c];
+			}
+
+			min = glm::min(min, texel);
+			max = glm::max(max, texel);
+
+			glm::vec4 d = texel - mean;
+			for (int r = 0; r < 4; r++) {
+				for (int c = 0; c < 4; c++) {
+					covariance[c][r] += d[r] * d[c];
+				}
+			}
+		}
+
+		// Power iteration, seeded with the bounding box diagonal which is usually close already
+		glm::vec4 axis = max - min;
+		for (int i = 0; i < 8; i++) {
+			glm::vec4 next = covariance * axis;
+			float len = glm::length(next);
+			if (len < 1e-6f)
+				break;
+
+			axis = next / len;
+		}
+
+		float axis_len_sq = glm::dot(axis, axis);
+		if (axis_len_sq < 1e-12f)
+			return { mean, mean };
+
+		axis /= glm::sqrt(axis_len_sq);
+
+		float min_proj = std::numeric_limits<float>::max();
+		float max_proj = -std::numeric_limits<float>::max();
+		for (int i = 0; i < 16; i++) {
+			glm::vec4 texel;
+			for (int c = 0; c < 4; c++) {
+				texel[c] = block.channels[c][i] * weights[c];
+			}
+
+			float proj = glm::dot(texel - mean, axis);
+			min_proj = glm::min(min_proj, proj);
+			max_proj = glm::max(max_proj, proj);
+		}
+
+		return { glm::clamp(mean + axis * min_proj, 0.f, 255.f), glm::clamp(mean + axis * max_proj, 0.f, 255.f) };
+	}
+
+	// Least squares endpoints for fixed indices, 'weights_of_e1' is how much of the second endpoint each palette entry is
+	// Returns false if every texel uses the same blend, where the endpoints can't be solved for
+	bool RefineEndpoints(const BlockTexels& block, const uint8_t* p_indices, const float* weights_of_e1, glm::vec4& e0, glm::vec4& e1) {
+		float a = 0.f, b = 0.f, c = 0.f;
+		glm::vec4 x0{ 0.f }, x1{ 0.f };
+
+		for (int i = 0; i < 16; i++) {
+			float t = weights_of_e1[p_indices[i]];
+			float s = 1.f - t;
+			a += s * s;
+			b += s * t;
+			c += t * t;
+
+			glm::vec4 texel{ block.channels[0][i], block.channels[1][i], block.channels[2][i], block.channels[3][i] };
+			x0 += texel * s;
+			x1 += texel * t;
+		}
+
+		float det = a * c - b * b;
+		if (glm::abs(det) < 1e-6f)
+			return false;
+
+		e0 = glm::clamp((x0 * c - x1 * b) / det, 0.f, 255.f);
+		e1 = glm::clamp((x1 * a - x0 * b) / det, 0.f, 255.f);
+		return true;
+	}
+
+	uint16_t QuantizeRGB565(glm::vec4 colour) {
+		auto r = (uint16_t)glm::round(colour.r * 31.f / 255.f);
+		auto g = (uint16_t)glm::round(colour.g * 63.f / 255.f);
+		auto b = (uint16_t)glm::round(colour.b * 31.f / 255.f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	glm::vec4 ExpandRGB565(uint16_t colour) {
+		uint32_t r = (colour >> 11) & 31, g = (colour >> 5) & 63, b = colour & 31;
+		return glm::vec4{ (float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)), 0.f };
+	}
+
+	// Four colour mode, also how BC3 always decodes its colour block
+	void EncodeColourBlock(const BlockTexels& block, std::byte* p_out) {
+		constexpr glm::vec4 RGB_WEIGHTS{ 1.f, 1.f, 1.f, 0.f };
+
+		// Palette order is e0, e1, 2/3 e0 + 1/3 e1, 1/3 e0 + 2/3 e1
+		constexpr float WEIGHTS_OF_E1[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+		auto try_endpoints = [&](glm::vec4 e0, glm::vec4 e1, uint16_t& c0, uint16_t& c1, uint8_t* p_indices) {
+			c0 = QuantizeRGB565(e0);
+			c1 = QuantizeRGB565(e1);
+
+			glm::vec4 palette[4];
+			palette[0] = ExpandRGB565(c0);
+			palette[1] = ExpandRGB565(c1);
+			palette[2] = (palette[0] * 2.f + palette[1]) / 3.f;
+			palette[3] = (palette[0] + palette[1] * 2.f) / 3.f;
+			return FindIndices(block, palette, 4, RGB_WEIGHTS, p_indices);
+		};
+
+		auto [e0, e1] = FitEndpoints(block, RGB_WEIGHTS);
+
+		// Insetting the endpoints slightly lowers the average error, the extremes are rarely worth a palette entry each
+		glm::vec4 inset = (e1 - e0) / 16.f;
+		e0 += inset;
+		e1 -= inset;
+
+		uint16_t c0, c1;
+		uint8_t indices[16];
+		float error = try_endpoints(e0, e1, c0, c1, indices);
+
+		for (int i = 0; i < 2 && error > 0.f; i++) {
+			if (!RefineEndpoints(block, indices, WEIGHTS_OF_E1, e0, e1))
+				break;
+
+			uint16_t refined_c0, refined_c1;
+			uint8_t refined_indices[16];
+			float refined_error = try_endpoints(e0, e1, refined_c0, refined_c1, refined_indices);
+			if (refined_error >= error)
+				break;
+
+			error = refined_error;
+			c0 = refined_c0;
+			c1 = refined_c1;
+			std::memcpy(indices, refined_indices, sizeof(indices));
+		}
+
+		// c0 > c1 selects four colour mode, swapping the endpoints swaps palette entries 0/1 and 2/3
+		// Equal endpoints decode to c0 at index 0 in either mode
+		if (c0 < c1) {
+			std::swap(c0, c1);
+			for (auto& index : indices) {
+				index ^= 1;
+			}
+		}
+		else if (c0 == c1) {
+			std::ranges::fill(indices, 0);
+		}
+
+		uint32_t packed_indices = 0;
+		for (int i = 0; i < 16; i++) {
+			packed_indices |= (uint32_t)indices[i] << (i * 2);
+		}
+
+		std::memcpy(p_out, &c0, 2);
+		std::memcpy(p_out + 2, &c1, 2);
+		std::memcpy(p_out + 4, &packed_indices, 4);
+	}
+
+	// BC4 block of one channel, also the alpha block of BC3 and each channel of BC5
+	void EncodeSingleChannelBlock(const BlockTexels& block, int channel, std::byte* p_out) {
+		float min = 255.f, max = 0.f;
+		for (int i = 0; i < 16; i++) {
+			min = glm::min(min, block.channels[channel][i]);
+			max = glm::max(max, block.channels[channel][i]);
+		}
+
+		// a0 > a1 selects the eight value mode, equal endpoints decode to a0 at index 0
+		auto a0 = (uint8_t)max;
+		auto a1 = (uint8_t)min;
+
+		uint8_t indices[16] = {};
+		if (a0 > a1) {
+			// Palette order is a0, a1, then six values blended from a0 towards a1
+			glm::vec4 palette[8]{};
+			palette[0][channel] = a0;
+			palette[1][channel] = a1;
+			for (int i = 2; i < 8; i++) {
+				palette[i][channel] = ((8 - i) * a0 + (i - 1) * a1) / 7.f;
+			}
+
+			glm::vec4 weights{ 0.f };
+			weights[channel] = 1.f;
+			FindIndices(block, palette, 8, weights, indices);
+		}
+
+		uint64_t packed = (uint64_t)a0 | ((uint64_t)a1 << 8);
+		for (int i = 0; i < 16; i++) {
+			packed |= (uint64_t)indices[i] << (16 + i * 3);
+		}
+
+		std::memcpy(p_out, &packed, 8);
+	}
+
+	// Writes bits LSB first, the order BC7 fields are packed in
+	struct BitWriter {
+		uint64_t bits[2] = { 0, 0 };
+		uint32_t pos = 0;
+
+		void Write(uint32_t val, uint32_t num_bits) {
+			for (uint32_t i = 0; i < num_bits; i++, pos++) {
+				bits[pos / 64] |= (uint64_t)((val >> i) & 1) << (pos % 64);
+			}
+		}
+	};
+
+	constexpr uint32_t BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Endpoint {
+		// 7 bits per channel
+		std::array<uint32_t, 4> quantized;
+		uint32_t p_bit;
+
+		glm::vec4 Expand() const {
+			return glm::vec4{ quantized[0], quantized[1], quantized[2], quantized[3] } * 2.f + (float)p_bit;
+		}
+	};
+
+	// Picks the p-bit the endpoint rounds closest with, it's shared by all four channels
+	BC7Endpoint QuantizeBC7Endpoint(glm::vec4 endpoint) {
+		BC7Endpoint best;
+		float best_error = std::numeric_limits<float>::max();
+
+		for (uint32_t p = 0; p < 2; p++) {
+			BC7Endpoint candidate;
+			candidate.p_bit = p;
+			for (int c = 0; c < 4; c++) {
+				candidate.quantized[c] = (uint32_t)glm::clamp(glm::round((endpoint[c] - (float)p) / 2.f), 0.f, 127.f);
+			}
+
+			glm::vec4 diff = candidate.Expand() - endpoint;
+			float error = glm::dot(diff, diff);
+			if (error < best_error) {
+				best_error = error;
+				best = candidate;
+			}
+		}
+
+		return best;
+	}
+
+	// acc += v * weight for all four channels at once
+	void MulAdd(glm::vec4& acc, const glm::vec4& v, float weight) {
+#ifdef SNK_BC_SSE
+		_mm_storeu_ps(&acc[0], _mm_add_ps(_mm_loadu_ps(&acc[0]), _mm_mul_ps(_mm_loadu_ps(&v[0]), _mm_set1_ps(weight))));
+#else
+		acc += v * weight;
+#endif
+	}
+
+	// Zeroth order modified Bessel function of the first kind, converges well within 20 terms for the alphas used
+	float BesselI0(float x) {
+		float sum = 1.f, term = 1.f;
+		for (int k = 1; k < 20; k++) {
+			term *= (x / (2.f * k)) * (x / (2.f * k));
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	// Windowed sinc, x is in destination texels
+	float KaiserSinc(float x) {
+		constexpr float WIDTH = TextureEncoder::KAISER_WIDTH;
+		if (glm::abs(x) >= WIDTH)
+			return 0.f;
+
+		float sinc = glm::abs(x) < 1e-6f ? 1.f : glm::sin(glm::pi<float>() * x) / (glm::pi<float>() * x);
+		float r = x / WIDTH;
+		return sinc * BesselI0(TextureEncoder::KAISER_ALPHA * glm::sqrt(1.f - r * r)) / BesselI0(TextureEncoder::KAISER_ALPHA);
+	}
+
+	struct FilterTap {
+		// Source texel, clamped to the edge
+		uint32_t index;
+		float weight;
+	};
+
+	// Taps for each destination texel along one axis, weights sum to 1
+	std::vector<std::vector<FilterTap>> ComputeMipFilterTaps(uint32_t src_size, uint32_t dst_size) {
+		std::vector<std::vector<FilterTap>> taps(dst_size);
+
+		// Axes already at 1 texel aren't filtered
+		if (src_size == dst_size) {
+			for (uint32_t i = 0; i < dst_size; i++) {
+				taps[i].push_back(FilterTap{ i, 1.f });
+			}
+
+			return taps;
+		}
+
+		// Not always 2, odd sizes round down
+		float scale = (float)src_size / dst_size;
+
+		for (uint32_t i = 0; i < dst_size; i++) {
+			float centre = (i + 0.5f) * scale;
+			auto first = (int)glm::floor(centre - TextureEncoder::KAISER_WIDTH * scale);
+			auto last = (int)glm::ceil(centre + TextureEncoder::KAISER_WIDTH * scale);
+
+			float total = 0.f;
+			for (int s = first; s <= last; s++) {
+				float weight = KaiserSinc((s + 0.5f - centre) / scale);
+				if (weight == 0.f)
+					continue;
+
+				taps[i].push_back(FilterTap{ (uint32_t)glm::clamp(s, 0, (int)src_size - 1), weight });
+				total += weight;
+			}
+
+			for (auto& tap : taps[i]) {
+				tap.weight /= total;
+			}
+		}
+
+		return taps;
+	}
+
+	float SRGBToLinear(float c) {
+		return c <= 0.04045f ? c / 12.92f : glm::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float c) {
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * glm::pow(c, 1.f / 2.4f) - 0.055f;
+	}
+
+	// Texels to filter, ALBEDO is premultiplied by alpha and NORMAL is unpacked to [-1, 1]
+	void ToLinear(const std::byte* p_rgba, size_t num_texels, TextureEncoder::Usage usage, glm::vec4* p_linear) {
+		static const auto srgb_to_linear = [] {
+			std::array<float, 256> table;
+			for (int i = 0; i < 256; i++) {
+				table[i] = SRGBToLinear(i / 255.f);
+			}
+			return table;
+		}();
+
+		auto* p_texels = reinterpret_cast<const uint8_t*>(p_rgba);
+
+		for (size_t i = 0; i < num_texels; i++) {
+			const uint8_t* p = p_texels + i * 4;
+			float alpha = p[3] / 255.f;
+
+			switch (usage) {
+			case TextureEncoder::Usage::ALBEDO:
+				p_linear[i] = glm::vec4{ srgb_to_linear[p[0]] * alpha, srgb_to_linear[p[1]] * alpha, srgb_to_linear[p[2]] * alpha, alpha };
+				break;
+			case TextureEncoder::Usage::NORMAL:
+				p_linear[i] = glm::vec4{ p[0] / 127.5f - 1.f, p[1] / 127.5f - 1.f, p[2] / 127.5f - 1.f, alpha };
+				break;
+			default:
+				p_linear[i] = glm::vec4{ p[0], p[1], p[2], p[3] } / 255.f;
+			}
+		}
+	}
+
+	// Inverse of ToLinear, NORMAL vectors are renormalised first
+	void FromLinear(const glm::vec4* p_linear, size_t num_texels, TextureEncoder::Usage usage, std::byte* p_rgba) {
+		auto* p_texels = reinterpret_cast<uint8_t*>(p_rgba);
+
+		auto to_byte = [](float unorm) { return (uint8_t)glm::round(glm::clamp(unorm, 0.f, 1.f) * 255.f); };
+
+		for (size_t i = 0; i < num_texels; i++) {
+			glm::vec4 texel = p_linear[i];
+			uint8_t* p = p_texels + i * 4;
+
+			// Kaiser lobes can overshoot, channels are clamped before conversion
+			float alpha = glm::clamp(texel.a, 0.f, 1.f);
+			p[3] = to_byte(alpha);
+
+			switch (usage) {
+			case TextureEncoder::Usage::ALBEDO:
+				for (int c = 0; c < 3; c++) {
+					// Fully transparent texels have no colour left to recover, black is as good as any
+					float colour = alpha > 0.f ? texel[c] / alpha : 0.f;
+					p[c] = to_byte(LinearToSRGB(glm::clamp(colour, 0.f, 1.f)));
+				}
+				break;
+			case TextureEncoder::Usage::NORMAL: {
+				glm::vec3 n{ texel };
+				float len = glm::length(n);
+				n = len > 1e-6f ? n / len : glm::vec3{ 0.f, 0.f, 1.f };
+				for (int c = 0; c < 3; c++) {
+					p[c] = to_byte(n[c] * 0.5f + 0.5f);
+				}
+				break;
+			}
+			default:
+				for (int c = 0; c < 3; c++) {
+					p[c] = to_byte(texel[c]);
+				}
+			}
+		}
+	}
+}
+
+vk::Format TextureEncoder::SelectFormat(Usage usage, bool has_alpha) {
+	switch (usage) {
+	case Usage::ALBEDO:
+		return vk::Format::eBc7SrgbBlock;
+	case Usage::NORMAL:
+		return vk::Format::eBc5UnormBlock;
+	case Usage::MASK:
+	default:
+		return has_alpha ? vk::Format::eBc3UnormBlock : vk::Format::eBc1RgbUnormBlock;
+	}
+}
+
+bool TextureEncoder::IsSelectableFormat(vk::Format format) {
+	for (auto usage : { Usage::ALBEDO, Usage::NORMAL, Usage::MASK }) {
+		if (format == SelectFormat(usage, false) || format == SelectFormat(usage, true))
+			return true;
+	}
+
+	return false;
+}
+
+bool TextureEncoder::IsBlockCompressed(vk::Format format) {
+	return format >= vk::Format::eBc1RgbUnormBlock && format <= vk::Format::eBc7SrgbBlock;
+}
+
+uint64_t TextureEncoder::GetMipSize(vk::Format format, uint32_t width, uint32_t height) {
+	if (format == GetSourceFormat(Usage::ALBEDO) || format == GetSourceFormat(Usage::NORMAL))
+		return (uint64_t)width * height * 4;
+
+	if (!IsBlockCompressed(format)) {
+		SNK_ASSERT_ARG(false, "TextureEncoder::GetMipSize, unsupported format");
+		return 0;
+	}
+
+	bool is_8_byte_block = format <= vk::Format::eBc1RgbaSrgbBlock || format == vk::Format::eBc4UnormBlock || format == vk::Format::eBc4SnormBlock;
+	return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * (is_8_byte_block ? 8 : 16);
+}
+
+bool TextureEncoder::HasAlpha(const std::byte* p_rgba, uint32_t width, uint32_t height) {
+	for (size_t i = 3; i < (size_t)width * height * 4; i += 4) {
+		if (p_rgba[i] != std::byte{ 255 })
+			return true;
+	}
+
+	return false;
+}
+
+void TextureEncoder::EncodeBlockBC1(const uint8_t* p_texels, std::byte* p_out) {
+	EncodeColourBlock(ToBlockTexels(p_texels), p_out);
+}
+
+void TextureEncoder::EncodeBlockBC3(const uint8_t* p_texels, std::byte* p_out) {
+	auto block = ToBlockTexels(p_texels);
+	EncodeSingleChannelBlock(block, 3, p_out);
+	EncodeColourBlock(block, p_out + 8);
+}
+
+void TextureEncoder::EncodeBlockBC5(const uint8_t* p_texels, std::byte* p_out) {
+	auto block = ToBlockTexels(p_texels);
+	EncodeSingleChannelBlock(block, 0, p_out);
+	EncodeSingleChannelBlock(block, 1, p_out + 8);
+}
+
+void TextureEncoder::EncodeBlockBC7(const uint8_t* p_texels, std::byte* p_out) {
+	constexpr glm::vec4 RGBA_WEIGHTS{ 1.f };
+
+	float weights_of_e1[16];
+	for (int i = 0; i < 16; i++) {
+		weights_of_e1[i] = BC7_WEIGHTS_4[i] / 64.f;
+	}
+
+	auto block = ToBlockTexels(p_texels);
+
+	auto try_endpoints = [&](glm::vec4 e0, glm::vec4 e1, BC7Endpoint& q0, BC7Endpoint& q1, uint8_t* p_indices) {
+		q0 = QuantizeBC7Endpoint(e0);
+		q1 = QuantizeBC7Endpoint(e1);
+
+		// Interpolated exactly as decoders do, in integers with rounding
+		glm::vec4 expanded0 = q0.Expand(), expanded1 = q1.Expand();
+		glm::vec4 palette[16];
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				palette[i][c] = (float)(((64 - BC7_WEIGHTS_4[i]) * (uint32_t)expanded0[c] + BC7_WEIGHTS_4[i] * (uint32_t)expanded1[c] + 32) >> 6);
+			}
+		}
+
+		return FindIndices(block, palette, 16, RGBA_WEIGHTS, p_indices);
+	};
+
+	auto [e0, e1] = FitEndpoints(block, RGBA_WEIGHTS);
+
+	BC7Endpoint q0, q1;
+	uint8_t indices[16];
+	float error = try_endpoints(e0, e1, q0, q1, indices);
+
+	for (int i = 0; i < 2 && error > 0.f; i++) {
+		if (!RefineEndpoints(block, indices, weights_of_e1, e0, e1))
+			break;
+
+		BC7Endpoint refined_q0, refined_q1;
+		uint8_t refined_indices[16];
+		float refined_error = try_endpoints(e0, e1, refined_q0, refined_q1, refined_indices);
+		if (refined_error >= error)
+			break;
+
+		error = refined_error;
+		q0 = refined_q0;
+		q1 = refined_q1;
+		std::memcpy(indices, refined_indices, sizeof(indices));
+	}
+
+	// The first texel's index is stored without its top bit, so it must be below 8
+	if (indices[0] >= 8) {
+		std::swap(q0, q1);
+		for (auto& index : indices) {
+			index = 15 - index;
+		}
+	}
+
+	BitWriter writer;
+	writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		writer.Write(q0.quantized[c], 7);
+		writer.Write(q1.quantized[c], 7);
+	}
+	writer.Write(q0.p_bit, 1);
+	writer.Write(q1.p_bit, 1);
+
+	writer.Write(indices[0], 3);
+	for (int i = 1; i < 16; i++) {
+		writer.Write(indices[i], 4);
+	}
+
+	std::memcpy(p_out, writer.bits, 16);
+}
+
+std::vector<std::byte> TextureEncoder::Encode(const std::byte* p_rgba, uint32_t width, uint32_t height, vk::Format format) {
+	void(*encode_block)(const uint8_t*, std::byte*) = nullptr;
+	switch (format) {
+	case vk::Format::eBc1RgbUnormBlock:
+	case vk::Format::eBc1RgbSrgbBlock:
+		encode_block = &EncodeBlockBC1;
+		break;
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc3SrgbBlock:
+		encode_block = &EncodeBlockBC3;
+		break;
+	case vk::Format::eBc5UnormBlock:
+		encode_block = &EncodeBlockBC5;
+		break;
+	case vk::Format::eBc7UnormBlock:
+	case vk::Format::eBc7SrgbBlock:
+		encode_block = &EncodeBlockBC7;
+		break;
+	default:
+		SNK_ASSERT_ARG(false, "TextureEncoder::Encode, unsupported format");
+		return {};
+	}
+
+	uint32_t blocks_x = (width + 3) / 4;
+	uint32_t blocks_y = (height + 3) / 4;
+	uint64_t block_size = GetMipSize(format, 4, 4);
+
+	std::vector<std::byte> encoded(GetMipSize(format, width, height));
+	auto* p_texels = reinterpret_cast<const uint8_t*>(p_rgba);
+
+	JobSystem::ParallelFor(blocks_y, BLOCK_ROWS_PER_JOB, [&](uint32_t begin, uint32_t end) {
+		uint8_t block[16 * 4];
+
+		for (uint32_t by = begin; by < end; by++) {
+			for (uint32_t bx = 0; bx < blocks_x; bx++) {
+				for (uint32_t y = 0; y < 4; y++) {
+					for (uint32_t x = 0; x < 4; x++) {
+						uint32_t src_x = glm::min(bx * 4 + x, width - 1);
+						uint32_t src_y = glm::min(by * 4 + y, height - 1);
+						std::memcpy(&block[(y * 4 + x) * 4], p_texels + ((size_t)src_y * width + src_x) * 4, 4);
+					}
+				}
+
+				encode_block(block, encoded.data() + ((size_t)by * blocks_x + bx) * block_size);
+			}
+		}
+		});
+
+	return encoded;
+}
+
+std::vector<std::vector<std::byte>> TextureEncoder::GenerateMips(const std::byte* p_rgba, uint32_t width, uint32_t height, Usage usage) {
+	uint32_t num_mips = GetNumMips(width, height);
+	std::vector<std::vector<std::byte>> mips(num_mips - 1);
+
+	const std::byte* p_src = p_rgba;
+	uint32_t src_width = width, src_height = height;
+
+	for (uint32_t i = 1; i < num_mips; i++) {
+		uint32_t mip_width = glm::max(src_width / 2, 1u);
+		uint32_t mip_height = glm::max(src_height / 2, 1u);
+
+		auto taps_x = ComputeMipFilterTaps(src_width, mip_width);
+		auto taps_y = ComputeMipFilterTaps(src_height, mip_height);
+		auto& mip = mips[i - 1];
+		mip.resize((size_t)mip_width * mip_height * 4);
+
+		// Separable, each output row is filtered vertically into a full width row then horizontally
+		// Each band of rows converts only the source rows its taps read, tap indices never decrease so they're those between its first and last
+		JobSystem::ParallelFor(mip_height, MIP_ROWS_PER_JOB, [&](uint32_t begin, uint32_t end) {
+			uint32_t first_src_row = taps_y[begin].front().index;
+			uint32_t last_src_row = taps_y[end - 1].back().index;
+
+			std::vector<glm::vec4> src_rows((size_t)(last_src_row - first_src_row + 1) * src_width);
+			ToLinear(p_src + (size_t)first_src_row * src_width * 4, src_rows.size(), usage, src_rows.data());
+
+			std::vector<glm::vec4> column_filtered(src_width);
+			std::vector<glm::vec4> out_row(mip_width);
+
+			for (uint32_t y = begin; y < end; y++) {
+				std::ranges::fill(column_filtered, glm::vec4{ 0.f });
+				for (auto& tap : taps_y[y]) {
+					const glm::vec4* p_row = &src_rows[(size_t)(tap.index - first_src_row) * src_width];
+					for (uint32_t x = 0; x < src_width; x++) {
+						MulAdd(column_filtered[x], p_row[x], tap.weight);
+					}
+				}
+
+				for (uint32_t x = 0; x < mip_width; x++) {
+					glm::vec4 acc{ 0.f };
+					for (auto& tap : taps_x[x]) {
+						MulAdd(acc, column_filtered[tap.index], tap.weight);
+					}
+
+					out_row[x] = acc;
+				}
+
+				FromLinear(out_row.data(), mip_width, usage, mip.data() + (size_t)y * mip_width * 4);
+			}
+			});
+
+		// Later levels are filtered from this one as stored, for NORMAL that's the renormalised vectors which are what's sampled
+		p_src = mip.data();
+		src_width = mip_width;
+		src_height = mip_height;
+	}
+
+	return mips;
+}
@@ -0,0 +1,267 @@
+#include "pch/pch.h"
+#include "assets/TextureResidencyManager.h"
+#include "assets/AssetManager.h"
+#include "assets/TextureEncoder.h"
+#include "core/VkContext.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+namespace {
+	// A frame in flight samples through a descriptor written on its own frame start, which may be up to MAX_FRAMES_IN_FLIGHT frames after the swap
+	constexpr uint64_t RETIRE_FRAMES = 2 * MAX_FRAMES_IN_FLIGHT + 1;
+}
+
+void TextureResidencyManager::I_Init() {
+	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		Update();
+	};
+
+	m_asset_event_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<AssetEvent const*>(p_event);
+		if (p_casted->type == AssetEventType::DESTROYED)
+			OnAssetDestroyed(p_casted->p_asset);
+	};
+
+	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+	EventManagerG::RegisterListener<AssetEvent>(m_asset_event_listener);
+}
+
+void TextureResidencyManager::Shutdown() {
+	auto& manager = Get();
+
+	while (true) {
+		{
+			std::scoped_lock l(manager.m_mux);
+			if (manager.m_num_reading == 0)
+				break;
+		}
+
+		std::this_thread::yield();
+	}
+
+	manager.m_loaded.clear();
+	manager.m_in_flight_batches.clear();
+	manager.m_retired.clear();
+	manager.m_textures.clear();
+	manager.m_textures_by_id.clear();
+	manager.m_policy = TextureResidencyPolicy{};
+}
+
+void TextureResidencyManager::Register(Texture2DAsset* p_tex, const std::string& filepath, const Image2DSpec& full_spec, uint32_t tail_top) {
+	auto& manager = Get();
+	SNK_ASSERT(!manager.m_textures.contains(p_tex));
+
+	std::vector<uint64_t> mip_sizes;
+	for (uint32_t i = 0; i < full_spec.mip_levels; i++) {
+		mip_sizes.push_back(TextureEncoder::GetMipSize(full_spec.format, glm::max(full_spec.size.x >> i, 1u), glm::max(full_spec.size.y >> i, 1u)));
+	}
+
+	auto id = manager.m_policy.AddTexture(mip_sizes, tail_top, manager.m_frame);
+	if (id >= manager.m_textures_by_id.size())
+		manager.m_textures_by_id.resize(id + 1, nullptr);
+
+	manager.m_textures_by_id[id] = p_tex;
+	manager.m_textures[p_tex] = ManagedTexture{ .filepath = filepath, .full_spec = full_spec, .id = id, .registration = manager.m_next_registration++ };
+}
+
+void TextureResidencyManager::RequestMip(Texture2DAsset* p_tex, uint32_t mip) {
+	auto& manager = Get();
+	if (auto it = manager.m_textures.find(p_tex); it != manager.m_textures.end())
+		manager.m_policy.Request(it->second.id, mip, manager.m_frame);
+}
+
+void TextureResidencyManager::RequestScreenCoverage(Texture2DAsset* p_tex, float pixels) {
+	auto& manager = Get();
+	auto it = manager.m_textures.find(p_tex);
+	if (it == manager.m_textures.end())
+		return;
+
+	auto& spec = it->second.full_spec;
+	uint32_t last_mip = spec.mip_levels - 1;
+	uint32_t mip = last_mip;
+
+	// Rounded down, a texture between two levels gets the finer one
+	if (pixels > 0.f) {
+		float texels = (float)glm::max(spec.size.x, spec.size.y);
+		mip = (uint32_t)glm::clamp(glm::floor(glm::log2(texels / pixels)), 0.f, (float)last_mip);
+	}
+
+	manager.m_policy.Request(it->second.id, mip, manager.m_frame);
+}
+
+uint32_t TextureResidencyManager::GetTailTop(const Image2DSpec& full_spec) {
+	uint32_t top = 0;
+	while (top + 1 < full_spec.mip_levels && glm::max(full_spec.size.x >> top, full_spec.size.y >> top) > MAX_TAIL_SIZE) {
+		top++;
+	}
+
+	return top;
+}
+
+Image2DSpec TextureResidencyManager::GetResidentSpec(const Image2DSpec& full_spec, uint32_t top) {
+	SNK_ASSERT(top < full_spec.mip_levels);
+
+	auto spec = full_spec;
+	spec.size = glm::max(full_spec.size >> top, glm::uvec2(1));
+	spec.mip_levels = full_spec.mip_levels - top;
+	return spec;
+}
+
+void TextureResidencyManager::Update() {
+	PollInFlightBatches();
+	ApplyLoadedMips();
+
+	std::erase_if(m_retired, [this](const RetiredImage& retired) { return m_frame >= retired.frame + RETIRE_FRAMES; });
+
+	for (auto change : m_policy.Update(m_frame)) {
+		auto* p_tex = m_textures_by_id[change.id];
+		StartRead(p_tex, m_textures.at(p_tex), change.top_mip);
+	}
+
+	m_stats.num_textures = m_policy.GetNumTextures();
+	m_stats.resident_bytes = m_policy.GetResidentBytes();
+	m_frame++;
+}
+
+void TextureResidencyManager::StartRead(Texture2DAsset* p_tex, const ManagedTexture& managed, uint32_t top_mip) {
+	{
+		std::scoped_lock l(m_mux);
+		m_num_reading++;
+	}
+
+	auto* p_job = JobSystem::CreateJob();
+	p_job->func = [this, p_tex, registration = managed.registration, filepath = managed.filepath, full_spec = managed.full_spec, top_mip]([[maybe_unused]] Job const* p_this) {
+		auto loaded = ReadMips(filepath, full_spec, top_mip);
+		loaded.p_tex = p_tex;
+		loaded.registration = registration;
+
+		std::scoped_lock l(m_mux);
+		m_loaded.push_back(std::move(loaded));
+		m_num_reading--;
+	};
+
+	JobSystem::Execute(p_job);
+}
+
+TextureResidencyManager::LoadedMips TextureResidencyManager::ReadMips(const std::string& filepath, const Image2DSpec& full_spec, uint32_t top_mip) {
+	LoadedMips loaded;
+	loaded.top_mip = top_mip;
+
+	uint64_t uuid;
+	std::string name;
+	Image2DSpec spec;
+	if (!AssetLoader::ReadTexture2DFile(filepath, uuid, name, spec, &loaded.contents))
+		return loaded;
+
+	if (loaded.contents.mips.size() != full_spec.mip_levels || spec.size != full_spec.size || spec.format != full_spec.format) {
+		SNK_CORE_ERROR("TextureResidencyManager failed to read mips, '{}' has changed since it was loaded", filepath);
+		return loaded;
+	}
+
+	// Same as AssetStreamer, the file is read here rather than on the main thread when staging
+	volatile std::byte sink;
+	for (uint32_t i = top_mip; i < loaded.contents.mips.size(); i++) {
+		auto mip = loaded.contents.mips[i];
+		for (size_t j = 0; j < mip.size(); j += 4096) {
+			sink = mip[j];
+		}
+	}
+
+	loaded.success = true;
+	return loaded;
+}
+
+void TextureResidencyManager::ApplyLoadedMips() {
+	std::vector<LoadedMips> loaded;
+	{
+		std::scoped_lock l(m_mux);
+		if (m_loaded.empty())
+			return;
+
+		std::swap(loaded, m_loaded);
+	}
+
+	struct StagedImage {
+		Texture2DAsset* p_tex;
+		TextureResidencyPolicy::TextureID id;
+		uint32_t top_mip;
+		std::unique_ptr<Image2D> p_image;
+	};
+
+	auto p_batch = std::make_unique<UploadBatch>();
+	std::vector<StagedImage> staged;
+
+	for (auto& mips : loaded) {
+		// Dropped if the texture was deleted while its mips were read
+		auto it = m_textures.find(mips.p_tex);
+		if (it == m_textures.end() || it->second.registration != mips.registration)
+			continue;
+
+		auto& managed = it->second;
+		if (!mips.success) {
+			// The image still holds what it did before the change
+			m_policy.CompleteChange(managed.id, managed.full_spec.mip_levels - mips.p_tex->image.GetSpec().mip_levels);
+			m_stats.num_failed++;
+			continue;
+		}
+
+		auto spec = GetResidentSpec(managed.full_spec, mips.top_mip);
+		auto p_image = std::make_unique<Image2D>(spec);
+		p_image->CreateImage();
+
+		for (uint32_t i = 0; i < spec.mip_levels; i++) {
+			auto data = mips.contents.mips[mips.top_mip + i];
+			p_batch->AddImageCopy(p_image->GetImage(), i, glm::max(spec.size.x >> i, 1u), glm::max(spec.size.y >> i, 1u), data.data(), data.size(),
+				vk::ImageLayout::eShaderReadOnlyOptimal);
+
+			m_stats.bytes_uploaded += data.size();
+		}
+
+		if (spec.mip_levels > mips.p_tex->image.GetSpec().mip_levels)
+			m_stats.num_streamed_in++;
+		else
+			m_stats.num_evicted++;
+
+		staged.push_back(StagedImage{ mips.p_tex, managed.id, mips.top_mip, std::move(p_image) });
+	}
+
+	if (staged.empty())
+		return;
+
+	p_batch->Submit();
+	m_in_flight_batches.push_back(std::move(p_batch));
+
+	// The descriptor is rewritten at the texture's existing index, frames already recorded keep sampling the old image until it's retired
+	for (auto& image : staged) {
+		image.p_tex->image.Swap(*image.p_image);
+		m_retired.push_back(RetiredImage{ std::move(image.p_image), m_frame });
+
+		AssetManager::Get().m_global_tex_buffer_manager.RegisterTexture(image.p_tex);
+		m_policy.CompleteChange(image.id, image.top_mip);
+
+		// Anything else holding the old image's view (editor thumbnails) must recreate it before the image is retired
+		EventManagerG::DispatchEvent(AssetEvent{ AssetEventType::UPDATED, image.p_tex });
+	}
+}
+
+void TextureResidencyManager::PollInFlightBatches() {
+	std::erase_if(m_in_flight_batches, [](const std::unique_ptr<UploadBatch>& p_batch) { return p_batch->IsComplete(); });
+}
+
+void TextureResidencyManager::Unregister(Texture2DAsset* p_tex) {
+	auto& manager = Get();
+	auto it = manager.m_textures.find(p_tex);
+	if (it == manager.m_textures.end())
+		return;
+
+	// Reads in progress are dropped in ApplyLoadedMips once the registration is gone
+	manager.m_policy.RemoveTexture(it->second.id);
+	manager.m_textures_by_id[it->second.id] = nullptr;
+	manager.m_textures.erase(it);
+}
+
+void TextureResidencyManager::OnAssetDestroyed(Asset* p_asset) {
+	if (auto* p_tex = dynamic_cast<Texture2DAsset*>(p_asset))
+		Unregister(p_tex);
+}
@@ -0,0 +1,190 @@
+#include "pch/pch.h"
+#include "assets/TextureResidencyPolicy.h"
+
+using namespace SNAKE;
+
+TextureResidencyPolicy::TextureID TextureResidencyPolicy::AddTexture(const std::vector<uint64_t>& mip_sizes, uint32_t tail_top, uint64_t frame) {
+	SNK_ASSERT(!mip_sizes.empty() && tail_top < mip_sizes.size());
+
+	TextureID id;
+	if (m_free_ids.empty()) {
+		id = (TextureID)m_textures.size();
+		m_textures.emplace_back();
+	}
+	else {
+		id = m_free_ids.back();
+		m_free_ids.pop_back();
+	}
+
+	auto& tex = m_textures[id];
+	tex = Texture{};
+	tex.bytes_from.resize(mip_sizes.size() + 1, 0);
+	for (size_t i = mip_sizes.size(); i > 0; i--) {
+		tex.bytes_from[i - 1] = tex.bytes_from[i] + mip_sizes[i - 1];
+	}
+
+	tex.tail_top = tail_top;
+	tex.resident_top = tail_top;
+	tex.requested_top = tail_top;
+	tex.last_request_frame = frame;
+	tex.alive = true;
+
+	m_resident_bytes += tex.bytes_from[tail_top];
+	return id;
+}
+
+void TextureResidencyPolicy::RemoveTexture(TextureID id) {
+	auto& tex = m_textures[id];
+	SNK_ASSERT(tex.alive);
+
+	m_resident_bytes -= tex.bytes_from[tex.resident_top];
+	tex = Texture{};
+	m_free_ids.push_back(id);
+}
+
+void TextureResidencyPolicy::Request(TextureID id, uint32_t mip, uint64_t frame) {
+	auto& tex = m_textures[id];
+	mip = glm::min(mip, tex.tail_top);
+
+	if (tex.last_request_frame != frame || mip < tex.requested_top)
+		tex.requested_top = mip;
+
+	tex.last_request_frame = glm::max(tex.last_request_frame, frame);
+}
+
+void TextureResidencyPolicy::CompleteChange(TextureID id, uint32_t resident_top) {
+	auto& tex = m_textures[id];
+	tex.pending = false;
+
+	m_resident_bytes -= tex.bytes_from[tex.resident_top];
+	tex.resident_top = resident_top;
+	m_resident_bytes += tex.bytes_from[tex.resident_top];
+}
+
+uint32_t TextureResidencyPolicy::GetDesiredTop(const Texture& tex, uint64_t frame) const {
+	return frame - tex.last_request_frame < request_lifetime_frames ? tex.requested_top : tex.tail_top;
+}
+
+void TextureResidencyPolicy::SetResidentTop(TextureID id, uint32_t top, std::vector<Change>& changes) {
+	auto& tex = m_textures[id];
+	m_resident_bytes -= tex.bytes_from[tex.resident_top];
+	m_resident_bytes += tex.bytes_from[top];
+
+	tex.resident_top = top;
+	tex.pending = true;
+	changes.push_back(Change{ id, top });
+}
+
+uint64_t TextureResidencyPolicy::Evict(uint64_t needed, uint64_t frame, uint64_t protect_frame, TextureID exclude, std::vector<Change>& changes) {
+	auto can_evict = [&](TextureID id) {
+		auto& tex = m_textures[id];
+		return tex.alive && !tex.pending && id != exclude && tex.resident_top < tex.tail_top;
+	};
+
+	std::vector<TextureID> victims;
+	for (TextureID id = 0; id < m_textures.size(); id++) {
+		if (can_evict(id))
+			victims.push_back(id);
+	}
+
+	// Least recently requested first, the largest first between equals as fewer textures then lose detail
+	std::ranges::sort(victims, [&](TextureID a, TextureID b) {
+		auto& tex_a = m_textures[a];
+		auto& tex_b = m_textures[b];
+		if (tex_a.last_request_frame != tex_b.last_request_frame)
+			return tex_a.last_request_frame < tex_b.last_request_frame;
+
+		return tex_a.bytes_from[tex_a.resident_top] > tex_b.bytes_from[tex_b.resident_top];
+	});
+
+	uint64_t freed = 0;
+	auto drop_to = [&](TextureID id, uint32_t top) {
+		auto& tex = m_textures[id];
+		freed += tex.bytes_from[tex.resident_top] - tex.bytes_from[top];
+		SetResidentTop(id, top, changes);
+	};
+
+	// Mips finer than a texture's own request aren't sampled, dropping them costs nothing visible
+	for (auto id : victims) {
+		if (freed >= needed)
+			return freed;
+
+		uint32_t desired = GetDesiredTop(m_textures[id], frame);
+		if (m_textures[id].resident_top < desired)
+			drop_to(id, desired);
+	}
+
+	for (auto id : victims) {
+		if (freed >= needed)
+			break;
+
+		auto& tex = m_textures[id];
+		if (tex.pending || tex.last_request_frame >= protect_frame)
+			continue;
+
+		drop_to(id, tex.tail_top);
+	}
+
+	return freed;
+}
+
+std::vector<TextureResidencyPolicy::Change> TextureResidencyPolicy::Update(uint64_t frame) {
+	std::vector<Change> changes;
+
+	// The budget may have been lowered, or tails alone can exceed it, only textures not requested this frame are evicted for it
+	if (m_resident_bytes > budget_bytes)
+		Evict(m_resident_bytes - budget_bytes, frame, frame, std::numeric_limits<TextureID>::max(), changes);
+
+	std::vector<TextureID> candidates;
+	for (TextureID id = 0; id < m_textures.size(); id++) {
+		auto& tex = m_textures[id];
+		if (tex.alive && !tex.pending && GetDesiredTop(tex, frame) < tex.resident_top)
+			candidates.push_back(id);
+	}
+
+	// Most recently requested first, then whichever is furthest from its request
+	std::ranges::sort(candidates, [&](TextureID a, TextureID b) {
+		auto& tex_a = m_textures[a];
+		auto& tex_b = m_textures[b];
+		if (tex_a.last_request_frame != tex_b.last_request_frame)
+			return tex_a.last_request_frame > tex_b.last_request_frame;
+
+		uint32_t deficit_a = tex_a.resident_top - tex_a.requested_top;
+		uint32_t deficit_b = tex_b.resident_top - tex_b.requested_top;
+		if (deficit_a != deficit_b)
+			return deficit_a > deficit_b;
+
+		return a < b;
+	});
+
+	uint64_t streamed = 0;
+	for (auto id : candidates) {
+		auto& tex = m_textures[id];
+
+		// Evicted for an earlier candidate
+		if (tex.pending)
+			continue;
+
+		uint32_t target = GetDesiredTop(tex, frame);
+		uint64_t extra = tex.bytes_from[target] - tex.bytes_from[tex.resident_top];
+
+		if (streamed > 0 && streamed + extra > max_stream_bytes_per_update)
+			continue;
+
+		if (m_resident_bytes + extra > budget_bytes)
+			Evict(m_resident_bytes + extra - budget_bytes, frame, tex.last_request_frame, id, changes);
+
+		// Whatever fits if eviction couldn't free enough
+		while (target < tex.resident_top && m_resident_bytes + tex.bytes_from[target] - tex.bytes_from[tex.resident_top] > budget_bytes) {
+			target++;
+		}
+
+		if (target == tex.resident_top)
+			continue;
+
+		streamed += tex.bytes_from[target] - tex.bytes_from[tex.resident_top];
+		SetResidentTop(id, target, changes);
+	}
+
+	return changes;
+}
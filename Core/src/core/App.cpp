@@ -1,8 +1,12 @@
+#include "assets/AssetHotReloader.h"
 #include "assets/AssetManager.h"
+#include "assets/AssetStreamer.h"
+#include "assets/TextureResidencyManager.h"
 #include "core/Frametiming.h"
 #include "core/JobSystem.h"
 #include "core/VkContext.h"
 #include "core/VkCommon.h"
+#include "core/UploadEngine.h"
 #include "core/App.h"
 #include "events/EventManager.h"
 #include "events/EventsCommon.h"
@@ -73,10 +77,14 @@ void App::Init(const char* app_name) {
 	VkContext::CreateLogicalDevice(*window.GetVkContext().surface, required_device_extensions, create_device_func);
 	VkContext::InitVMA();
 	VkContext::CreateCommandPool(FindQueueFamilies(VkContext::GetPhysicalDevice().device, *window.GetVkContext().surface));
+	UploadEngine::Init();
 
 	window.CreateSwapchain();
 
 	AssetManager::Init();
+	AssetStreamer::Init();
+	TextureResidencyManager::Init();
+	AssetHotReloader::Init();
 	VkRenderer::Init();
 
 	layers.InitLayers();
@@ -95,21 +103,23 @@ void App::MainLoop() {
 		EventManagerG::DispatchEvent(FrameStartEvent{ });
 		layers.OnFrameStart();
 
-		Job* update_job = JobSystem::CreateJob();
+		Job* update_job = JobSystem::CreateWaitedOnJob();
 		update_job->func = [this]([[maybe_unused]] Job const* job) {
 			layers.OnUpdate();  
 			EventManagerG::DispatchEvent(EngineUpdateEvent{ });
 		};
 		JobSystem::Execute(update_job);
 
-		Job* render_job = JobSystem::CreateJob();
+		Job* render_job = JobSystem::CreateWaitedOnJob();
 		render_job->func = [this]([[maybe_unused]] Job const* job) {
 			layers.OnRender();
 			EventManagerG::DispatchEvent(EngineRenderEvent{ });
 		};
 		JobSystem::Execute(render_job);
 
-		JobSystem::WaitAll();
+		// Not WaitAll, that would also wait for background jobs like AssetStreamer loads
+		JobSystem::WaitOn(update_job);
+		JobSystem::WaitOn(render_job);
 		layers.OnImGuiRender();
 
 		EventManagerG::DispatchEvent(FrameEndEvent{});
@@ -127,7 +137,11 @@ void App::MainLoop() {
 	EventManagerG::DispatchEvent(EngineShutdownEvent{ });
 	layers.ShutdownLayers();
 	window.Shutdown();
+	AssetStreamer::Shutdown();
+	TextureResidencyManager::Shutdown();
+	AssetHotReloader::Shutdown();
 	AssetManager::Shutdown();
+	UploadEngine::Shutdown();
 	glfwTerminate();
 	SNK_CHECK_VK_RESULT(VkContext::GetLogicalDevice().device->waitIdle());
 
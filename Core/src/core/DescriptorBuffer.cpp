@@ -5,6 +5,30 @@
 
 using namespace SNAKE;
 
+namespace {
+	size_t GetDescriptorSize(vk::DescriptorType type) {
+		auto& descriptor_buffer_properties = VkContext::GetPhysicalDevice().buffer_properties;
+
+		switch (type) {
+		case vk::DescriptorType::eUniformBuffer:
+			return descriptor_buffer_properties.uniformBufferDescriptorSize;
+		case vk::DescriptorType::eCombinedImageSampler:
+			return descriptor_buffer_properties.combinedImageSamplerDescriptorSize;
+		case vk::DescriptorType::eStorageBuffer:
+			return descriptor_buffer_properties.storageBufferDescriptorSize;
+		case vk::DescriptorType::eAccelerationStructureKHR:
+			return descriptor_buffer_properties.accelerationStructureDescriptorSize;
+		case vk::DescriptorType::eStorageImage:
+			return descriptor_buffer_properties.storageImageDescriptorSize;
+		case vk::DescriptorType::eStorageBufferDynamic:
+			return descriptor_buffer_properties.storageBufferDescriptorSize;
+		default:
+			SNK_BREAK("GetDescriptorSize failed, unsupported descriptor type used");
+			return 0;
+		}
+	}
+}
+
 DescriptorBuffer::~DescriptorBuffer() {
 	for (auto& map : m_resource_link_infos) {
 		for (auto& [binding_idx, link_info] : map) {
@@ -13,7 +37,7 @@ DescriptorBuffer::~DescriptorBuffer() {
 	}
 }
 
-void DescriptorBuffer::CreateBuffer(uint32_t num_sets) {
+void DescriptorBuffer::CreateBuffer(uint32_t num_sets, std::optional<uint32_t> variable_descriptor_count) {
 	auto descriptor_spec = mp_descriptor_spec.lock();
 
 	SNK_ASSERT(descriptor_spec);
@@ -26,13 +50,36 @@ void DescriptorBuffer::CreateBuffer(uint32_t num_sets) {
 			m_usage_flags |= vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT;
 	}
 
-	descriptor_buffer.CreateBuffer(descriptor_spec->m_aligned_size * num_sets,
-		m_usage_flags | vk::BufferUsageFlagBits::eShaderDeviceAddress, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+	auto& last_binding = descriptor_spec->m_layout_bindings.back();
+	bool has_variable_count = (bool)(descriptor_spec->m_binding_flags.back() & vk::DescriptorBindingFlagBits::eVariableDescriptorCount);
+	m_variable_descriptor_count = has_variable_count ? glm::min(variable_descriptor_count.value_or(last_binding.descriptorCount), last_binding.descriptorCount) : 0;
+
+	m_num_sets = num_sets;
+	m_set_stride = descriptor_spec->GetAlignedSize(m_variable_descriptor_count);
+
+	// Transfer usage so GrowVariableDescriptorCount can resize it
+	descriptor_buffer.CreateBuffer(m_set_stride * num_sets,
+		m_usage_flags | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+		VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
 }
 
-void DescriptorBuffer::LinkResource(S_VkResource const* p_resource, DescriptorGetInfo& get_info, unsigned binding_idx, unsigned set_buffer_idx, uint32_t array_idx) {
-	auto& descriptor_buffer_properties = VkContext::GetPhysicalDevice().buffer_properties;
+void DescriptorBuffer::GrowVariableDescriptorCount(uint32_t count) {
+	auto descriptor_spec = mp_descriptor_spec.lock();
+	SNK_ASSERT(descriptor_spec);
+	SNK_ASSERT_ARG(m_num_sets == 1, "GrowVariableDescriptorCount failed, sets after the first would move");
+	SNK_ASSERT(count <= descriptor_spec->m_layout_bindings.back().descriptorCount);
+
+	if (count <= m_variable_descriptor_count)
+		return;
 
+	m_variable_descriptor_count = count;
+	m_set_stride = descriptor_spec->GetAlignedSize(count);
+
+	// Descriptors are plain data, copying them keeps every binding valid
+	descriptor_buffer.Resize(m_set_stride);
+}
+
+void DescriptorBuffer::LinkResource(S_VkResource const* p_resource, DescriptorGetInfo& get_info, unsigned binding_idx, unsigned set_buffer_idx, uint32_t array_idx) {
 	if (m_resource_link_infos.size() <= set_buffer_idx) {
 		m_resource_link_infos.resize(set_buffer_idx + 1);
 	}
@@ -59,38 +106,15 @@ void DescriptorBuffer::LinkResource(S_VkResource const* p_resource, DescriptorGe
 
 	get_info.Bind();
 
-	size_t size = 0;
 	auto descriptor_spec = mp_descriptor_spec.lock();
 	SNK_ASSERT(descriptor_spec);
 
-	auto descriptor_type = descriptor_spec->GetDescriptorTypeAtBinding(binding_idx);
-
-	switch (descriptor_type) {
-	case vk::DescriptorType::eUniformBuffer:
-		size = descriptor_buffer_properties.uniformBufferDescriptorSize;
-		break;
-	case vk::DescriptorType::eCombinedImageSampler:
-		size = descriptor_buffer_properties.combinedImageSamplerDescriptorSize;
-		break;
-	case vk::DescriptorType::eStorageBuffer:
-		size = descriptor_buffer_properties.storageBufferDescriptorSize;
-		break;
-	case vk::DescriptorType::eAccelerationStructureKHR:
-		size = descriptor_buffer_properties.accelerationStructureDescriptorSize;
-		break;
-	case vk::DescriptorType::eStorageImage:
-		size = descriptor_buffer_properties.storageImageDescriptorSize;
-		break;
-	case vk::DescriptorType::eStorageBufferDynamic:
-		size = descriptor_buffer_properties.storageBufferDescriptorSize;
-		break;
-	default:
-		SNK_BREAK("LinkResource failed, unsupported descriptor type used");
-		break;
-	}
+	size_t size = GetDescriptorSize(descriptor_spec->GetDescriptorTypeAtBinding(binding_idx));
+	size_t offset = descriptor_spec->GetBindingOffset(binding_idx) + size * array_idx + m_set_stride * set_buffer_idx;
+	SNK_ASSERT_ARG(offset + size <= m_set_stride * m_num_sets, "LinkResource failed, descriptor is outside the buffer");
 
 	VkContext::GetLogicalDevice().device->getDescriptorEXT(get_info.get_info, size,
-		reinterpret_cast<std::byte*>(descriptor_buffer.Map()) + descriptor_spec->GetBindingOffset(binding_idx) + size * array_idx + descriptor_spec->m_aligned_size * set_buffer_idx);
+		reinterpret_cast<std::byte*>(descriptor_buffer.Map()) + offset);
 }
 
 vk::DescriptorBufferBindingInfoEXT DescriptorBuffer::GetBindingInfo() {
@@ -113,6 +137,13 @@ DescriptorSetSpec& DescriptorSetSpec::GenDescriptorLayout() {
 	layout_info.bindingCount = (uint32_t)m_layout_bindings.size();
 	layout_info.pBindings = m_layout_bindings.data();
 	layout_info.flags = vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT;
+
+	vk::DescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+	if (std::ranges::any_of(m_binding_flags, [](auto flags) { return (bool)flags; })) {
+		binding_flags_info.bindingCount = (uint32_t)m_binding_flags.size();
+		binding_flags_info.pBindingFlags = m_binding_flags.data();
+		layout_info.pNext = &binding_flags_info;
+	}
 	auto [res, val] = VkContext::GetLogicalDevice().device->createDescriptorSetLayoutUnique(layout_info);
 	SNK_CHECK_VK_RESULT(res);
 	m_layout = std::move(val);
@@ -138,6 +169,16 @@ size_t DescriptorSetSpec::GetSize() {
 	return m_size;
 }
 
+size_t DescriptorSetSpec::GetAlignedSize(uint32_t variable_descriptor_count) const {
+	if (m_binding_flags.empty() || !(m_binding_flags.back() & vk::DescriptorBindingFlagBits::eVariableDescriptorCount))
+		return m_aligned_size;
+
+	// The layout's size assumes the most descriptors the variable count binding can hold
+	auto& binding = m_layout_bindings.back();
+	size_t size = GetBindingOffset(binding.binding) + GetDescriptorSize(binding.descriptorType) * variable_descriptor_count;
+	return aligned_size(size, VkContext::GetPhysicalDevice().buffer_properties.descriptorBufferOffsetAlignment);
+}
+
 bool DescriptorSetSpec::IsBindingPointOccupied(unsigned binding) const {
 	return std::ranges::find_if(m_layout_bindings, [binding](const auto& p) {return p.binding == binding; }) != m_layout_bindings.end();
 }
@@ -149,7 +190,8 @@ vk::DescriptorType DescriptorSetSpec::GetDescriptorTypeAtBinding(unsigned bindin
 	return it->descriptorType;
 }
 
-DescriptorSetSpec& DescriptorSetSpec::AddDescriptor(unsigned binding_point, vk::DescriptorType type, vk::ShaderStageFlags flags, uint32_t descriptor_count) {
+DescriptorSetSpec& DescriptorSetSpec::AddDescriptor(unsigned binding_point, vk::DescriptorType type, vk::ShaderStageFlags flags, uint32_t descriptor_count,
+	vk::DescriptorBindingFlags binding_flags) {
 	vk::DescriptorSetLayoutBinding layout_binding{};
 	layout_binding.binding = binding_point;
 	layout_binding.descriptorType = type;
@@ -157,6 +199,7 @@ DescriptorSetSpec& DescriptorSetSpec::AddDescriptor(unsigned binding_point, vk::
 	layout_binding.stageFlags = flags;
 
 	m_layout_bindings.push_back(layout_binding);
+	m_binding_flags.push_back(binding_flags);
 
 	return *this;
 }
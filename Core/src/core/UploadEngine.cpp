@@ -0,0 +1,168 @@
+#include "pch/pch.h"
+#include "core/UploadEngine.h"
+
+using namespace SNAKE;
+
+void UploadEngine::IInit() {
+	auto& device = VkContext::GetLogicalDevice();
+
+	vk::SemaphoreTypeCreateInfo type_info{};
+	type_info.semaphoreType = vk::SemaphoreType::eTimeline;
+	type_info.initialValue = 0;
+
+	vk::SemaphoreCreateInfo semaphore_info{};
+	semaphore_info.pNext = &type_info;
+
+	auto [semaphore_res, semaphore] = device.device->createSemaphoreUnique(semaphore_info);
+	SNK_CHECK_VK_RESULT(semaphore_res);
+	m_timeline = std::move(semaphore);
+
+	if (device.HasDedicatedTransferQueue()) {
+		auto [transfer_semaphore_res, transfer_semaphore] = device.device->createSemaphoreUnique(semaphore_info);
+		SNK_CHECK_VK_RESULT(transfer_semaphore_res);
+		m_transfer_timeline = std::move(transfer_semaphore);
+	}
+
+	vk::CommandPoolCreateInfo pool_info{};
+	pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
+	pool_info.queueFamilyIndex = device.GetGraphicsFamily();
+
+	auto [graphics_pool_res, graphics_pool] = device.device->createCommandPoolUnique(pool_info);
+	SNK_CHECK_VK_RESULT(graphics_pool_res);
+	m_graphics_pool = std::move(graphics_pool);
+
+	if (device.HasDedicatedTransferQueue()) {
+		pool_info.queueFamilyIndex = device.GetTransferFamily();
+		auto [transfer_pool_res, transfer_pool] = device.device->createCommandPoolUnique(pool_info);
+		SNK_CHECK_VK_RESULT(transfer_pool_res);
+		m_transfer_pool = std::move(transfer_pool);
+	}
+}
+
+void UploadEngine::IShutdown() {
+	Wait(UploadTicket{ m_last_submitted_value });
+
+	std::scoped_lock l(m_mux);
+	m_in_flight.clear();
+	m_transfer_pool.reset();
+	m_graphics_pool.reset();
+	m_timeline.reset();
+	m_transfer_timeline.reset();
+}
+
+vk::UniqueCommandBuffer UploadEngine::AllocateCommandBuffer(vk::CommandPool pool) {
+	vk::CommandBufferAllocateInfo alloc_info{};
+	alloc_info.level = vk::CommandBufferLevel::ePrimary;
+	alloc_info.commandPool = pool;
+	alloc_info.commandBufferCount = 1;
+
+	auto [res, bufs] = VkContext::GetLogicalDevice().device->allocateCommandBuffersUnique(alloc_info);
+	SNK_CHECK_VK_RESULT(res);
+
+	vk::CommandBufferBeginInfo begin_info{};
+	begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+	SNK_CHECK_VK_RESULT(bufs[0]->begin(begin_info));
+
+	return std::move(bufs[0]);
+}
+
+UploadTicket UploadEngine::Submit(const RecordFunc& record_transfer, const RecordFunc& record_acquire) {
+	auto& device = VkContext::GetLogicalDevice();
+	bool dedicated = device.HasDedicatedTransferQueue();
+
+	std::scoped_lock l(m_mux);
+	CollectCompleted();
+
+	InFlightSubmission submission;
+	submission.value = ++m_last_submitted_value;
+	submission.transfer_cmd = AllocateCommandBuffer(dedicated ? *m_transfer_pool : *m_graphics_pool);
+	record_transfer(*submission.transfer_cmd);
+
+	// Makes the copies visible to all later work on the graphics queue, done by the acquire submission below with a dedicated queue
+	vk::MemoryBarrier barrier{};
+	barrier.srcAccessMask = vk::AccessFlagBits::eMemoryWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+	if (!dedicated)
+		submission.transfer_cmd->pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {}, barrier, {}, {});
+
+	SNK_CHECK_VK_RESULT(submission.transfer_cmd->end());
+
+	vk::TimelineSemaphoreSubmitInfo signal_timeline_info{};
+	signal_timeline_info.signalSemaphoreValueCount = 1;
+	signal_timeline_info.pSignalSemaphoreValues = &submission.value;
+
+	vk::SubmitInfo transfer_submit_info{};
+	transfer_submit_info.pNext = &signal_timeline_info;
+	transfer_submit_info.commandBufferCount = 1;
+	transfer_submit_info.pCommandBuffers = &*submission.transfer_cmd;
+	transfer_submit_info.signalSemaphoreCount = 1;
+	transfer_submit_info.pSignalSemaphores = dedicated ? &*m_transfer_timeline : &*m_timeline;
+
+	if (!dedicated) {
+		device.SubmitGraphics(transfer_submit_info);
+		m_in_flight.push_back(std::move(submission));
+		return UploadTicket{ m_last_submitted_value };
+	}
+
+	device.SubmitTransfer(transfer_submit_info);
+
+	// The wait only blocks this submission, the barrier after it extends the dependency to every later graphics queue submission
+	submission.acquire_cmd = AllocateCommandBuffer(*m_graphics_pool);
+	if (record_acquire)
+		record_acquire(*submission.acquire_cmd);
+
+	submission.acquire_cmd->pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {}, barrier, {}, {});
+	SNK_CHECK_VK_RESULT(submission.acquire_cmd->end());
+
+	// The ticket's value is signalled from the graphics queue, so every value is signalled in submission order
+	vk::TimelineSemaphoreSubmitInfo wait_timeline_info{};
+	wait_timeline_info.waitSemaphoreValueCount = 1;
+	wait_timeline_info.pWaitSemaphoreValues = &submission.value;
+	wait_timeline_info.signalSemaphoreValueCount = 1;
+	wait_timeline_info.pSignalSemaphoreValues = &submission.value;
+
+	vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eAllCommands;
+	vk::SubmitInfo acquire_submit_info{};
+	acquire_submit_info.pNext = &wait_timeline_info;
+	acquire_submit_info.commandBufferCount = 1;
+	acquire_submit_info.pCommandBuffers = &*submission.acquire_cmd;
+	acquire_submit_info.waitSemaphoreCount = 1;
+	acquire_submit_info.pWaitSemaphores = &*m_transfer_timeline;
+	acquire_submit_info.pWaitDstStageMask = &wait_stage;
+	acquire_submit_info.signalSemaphoreCount = 1;
+	acquire_submit_info.pSignalSemaphores = &*m_timeline;
+	device.SubmitGraphics(acquire_submit_info);
+
+	m_in_flight.push_back(std::move(submission));
+	return UploadTicket{ m_last_submitted_value };
+}
+
+void UploadEngine::CollectCompleted() {
+	if (m_in_flight.empty())
+		return;
+
+	auto [res, completed_value] = VkContext::GetLogicalDevice().device->getSemaphoreCounterValue(*m_timeline);
+	SNK_CHECK_VK_RESULT(res);
+
+	std::erase_if(m_in_flight, [&](const InFlightSubmission& submission) { return submission.value <= completed_value; });
+}
+
+bool UploadEngine::IsComplete(UploadTicket ticket) const {
+	if (ticket.value == 0)
+		return true;
+
+	auto [res, completed_value] = VkContext::GetLogicalDevice().device->getSemaphoreCounterValue(*m_timeline);
+	SNK_CHECK_VK_RESULT(res);
+	return completed_value >= ticket.value;
+}
+
+void UploadEngine::Wait(UploadTicket ticket) const {
+	if (ticket.value == 0)
+		return;
+
+	vk::SemaphoreWaitInfo wait_info{};
+	wait_info.semaphoreCount = 1;
+	wait_info.pSemaphores = &*m_timeline;
+	wait_info.pValues = &ticket.value;
+	SNK_CHECK_VK_RESULT(VkContext::GetLogicalDevice().device->waitSemaphores(wait_info, UINT64_MAX));
+}
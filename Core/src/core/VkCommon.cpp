@@ -123,6 +123,7 @@ namespace SNAKE {
 		std::vector<vk::QueueFamilyProperties> queue_families(qf_count);
 		device.getQueueFamilyProperties(&qf_count, queue_families.data(), VULKAN_HPP_DEFAULT_DISPATCHER);
 
+		QueueFamilyIndices ret;
 		for (uint32_t i = 0; i < queue_families.size(); i++) {
 			QueueFamilyIndices indices;
 			if (queue_families[i].queueFlags & vk::QueueFlagBits::eGraphics && queue_families[i].queueFlags & vk::QueueFlagBits::eCompute)
@@ -132,11 +133,25 @@ namespace SNAKE {
 			if (present_support)
 				indices.present_family = i;
 
-			if (indices.IsComplete())
-				return indices;
+			if (indices.IsComplete()) {
+				ret = indices;
+				break;
+			}
+		}
+
+		if (!ret.IsComplete())
+			return QueueFamilyIndices{};
+
+		// Transfer-only families map to the DMA engines on discrete GPUs, copies there run alongside graphics work
+		for (uint32_t i = 0; i < queue_families.size(); i++) {
+			auto flags = queue_families[i].queueFlags;
+			if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics) && !(flags & vk::QueueFlagBits::eCompute)) {
+				ret.transfer_family = i;
+				break;
+			}
 		}
 
-		return QueueFamilyIndices{};
+		return ret;
 	}
 
 	bool CheckDeviceExtensionSupport(vk::PhysicalDevice device, const std::vector<const char*>& required_extensions_vec) {
@@ -70,7 +70,8 @@ bool VkContext::IsDeviceSuitable(vk::PhysicalDevice device, vk::SurfaceKHR surfa
 
 	vk::PhysicalDeviceFeatures device_features = device.getFeatures();
 
-	return properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu && qf_indices.IsComplete() && swapchain_valid && device_features.samplerAnisotropy;
+	return properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu && qf_indices.IsComplete() && swapchain_valid && device_features.samplerAnisotropy &&
+		device_features.textureCompressionBC;
 }
 
 
@@ -80,6 +81,8 @@ void VkContext::ICreateLogicalDevice(vk::SurfaceKHR surface, const std::vector<c
 
 	std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
 	std::set<uint32_t> unique_queue_families = { indices.graphics_family.value(), indices.present_family.value() };
+	if (indices.transfer_family.has_value())
+		unique_queue_families.insert(indices.transfer_family.value());
 
 	for (uint32_t queue_family : unique_queue_families) {
 		vk::DeviceQueueCreateInfo queue_create_info{
@@ -96,6 +99,10 @@ void VkContext::ICreateLogicalDevice(vk::SurfaceKHR surface, const std::vector<c
 	// Features
 	vk::PhysicalDeviceFeatures device_features{};
 	device_features.samplerAnisotropy = true;
+	device_features.multiDrawIndirect = true;
+	device_features.drawIndirectFirstInstance = true;
+	// Imported textures are stored BC1/BC3/BC5/BC7
+	device_features.textureCompressionBC = true;
 
 	vk::PhysicalDeviceDescriptorBufferFeaturesEXT descriptor_buffer_features{};
 	descriptor_buffer_features.descriptorBuffer = true;
@@ -116,7 +123,10 @@ void VkContext::ICreateLogicalDevice(vk::SurfaceKHR surface, const std::vector<c
 	features_12.scalarBlockLayout = true;
 	features_12.pNext = &rtp_features;
 	features_12.descriptorIndexing = true;
+	features_12.runtimeDescriptorArray = true;
+	features_12.descriptorBindingVariableDescriptorCount = true;
 	features_12.bufferDeviceAddress = true;
+	features_12.timelineSemaphore = true;
 
 	vk::PhysicalDeviceFeatures2 f;
 	vk::PhysicalDeviceRobustness2FeaturesEXT f2;
@@ -146,6 +156,13 @@ void VkContext::ICreateLogicalDevice(vk::SurfaceKHR surface, const std::vector<c
 
 	m_device.m_graphics_queue = m_device.device->getQueue(indices.graphics_family.value(), 0, VULKAN_HPP_DEFAULT_DISPATCHER);
 	m_device.m_presentation_queue = m_device.device->getQueue(indices.present_family.value(), 0, VULKAN_HPP_DEFAULT_DISPATCHER);
+	m_device.m_graphics_family = indices.graphics_family.value();
+
+	if (indices.transfer_family.has_value()) {
+		m_device.m_transfer_queue = m_device.device->getQueue(indices.transfer_family.value(), 0, VULKAN_HPP_DEFAULT_DISPATCHER);
+		m_device.m_transfer_family = indices.transfer_family;
+		SNK_CORE_INFO("Using dedicated transfer queue family {}", indices.transfer_family.value());
+	}
 }
 
 void VkContext::ICreateInstance(const char* app_name, PFN_vkCreateInstance create_instance_func) {
@@ -0,0 +1,141 @@
+#include "pch/pch.h"
+#include "rendering/FrustumCulling.h"
+#include "core/JobSystem.h"
+
+#include <bit>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define SNK_CULLING_SSE
+#include <immintrin.h>
+#endif
+
+using namespace SNAKE;
+
+void CullingBoundsSoA::Resize(uint32_t count) {
+	m_count = count;
+	size_t padded_count = (count + 3) & ~3u;
+
+	// Padding boxes have negative extents so they can never intersect a frustum
+	center_x.resize(padded_count, 0.f);
+	center_y.resize(padded_count, 0.f);
+	center_z.resize(padded_count, 0.f);
+	extent_x.resize(padded_count, -std::numeric_limits<float>::max());
+	extent_y.resize(padded_count, -std::numeric_limits<float>::max());
+	extent_z.resize(padded_count, -std::numeric_limits<float>::max());
+}
+
+void FrustumCuller::CullRange(const CullingBoundsSoA& bounds, const FrustumPlanes& planes, uint32_t begin, uint32_t end, std::vector<uint32_t>& out_visible) {
+	SNK_DBG_ASSERT(begin % 4 == 0);
+	SNK_DBG_ASSERT(end <= bounds.GetCount());
+
+#ifdef SNK_CULLING_SSE
+	__m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+	__m128 abs_plane_x[6], abs_plane_y[6], abs_plane_z[6];
+
+	for (int p = 0; p < 6; p++) {
+		plane_x[p] = _mm_set1_ps(planes[p].x);
+		plane_y[p] = _mm_set1_ps(planes[p].y);
+		plane_z[p] = _mm_set1_ps(planes[p].z);
+		plane_w[p] = _mm_set1_ps(planes[p].w);
+		abs_plane_x[p] = _mm_set1_ps(glm::abs(planes[p].x));
+		abs_plane_y[p] = _mm_set1_ps(glm::abs(planes[p].y));
+		abs_plane_z[p] = _mm_set1_ps(glm::abs(planes[p].z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = begin; i < end; i += 4) {
+		__m128 cx = _mm_loadu_ps(&bounds.center_x[i]);
+		__m128 cy = _mm_loadu_ps(&bounds.center_y[i]);
+		__m128 cz = _mm_loadu_ps(&bounds.center_z[i]);
+		__m128 ex = _mm_loadu_ps(&bounds.extent_x[i]);
+		__m128 ey = _mm_loadu_ps(&bounds.extent_y[i]);
+		__m128 ez = _mm_loadu_ps(&bounds.extent_z[i]);
+
+		__m128 outside = zero;
+
+		for (int p = 0; p < 6; p++) {
+			// Signed distance of the box center to the plane
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, plane_x[p]), _mm_mul_ps(cy, plane_y[p])), _mm_add_ps(_mm_mul_ps(cz, plane_z[p]), plane_w[p]));
+			// Projected radius of the box onto the plane normal
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, abs_plane_x[p]), _mm_mul_ps(ey, abs_plane_y[p])), _mm_mul_ps(ez, abs_plane_z[p]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		}
+
+		unsigned visible_mask = ~(unsigned)_mm_movemask_ps(outside) & 0xFu;
+
+		while (visible_mask) {
+			uint32_t idx = i + std::countr_zero(visible_mask);
+			if (idx < end)
+				out_visible.push_back(idx);
+
+			visible_mask &= visible_mask - 1;
+		}
+	}
+#else
+	CullRangeScalar(bounds, planes, begin, end, out_visible);
+#endif
+}
+
+void FrustumCuller::CullRangeScalar(const CullingBoundsSoA& bounds, const FrustumPlanes& planes, uint32_t begin, uint32_t end, std::vector<uint32_t>& out_visible) {
+	SNK_DBG_ASSERT(end <= bounds.GetCount());
+
+	for (uint32_t i = begin; i < end; i++) {
+		bool visible = true;
+
+		// Summed and compared as in the SSE path so both round identically and agree on NaN bounds
+		for (int p = 0; p < 6 && visible; p++) {
+			auto& plane = planes[p];
+			float dist = (bounds.center_x[i] * plane.x + bounds.center_y[i] * plane.y) + (bounds.center_z[i] * plane.z + plane.w);
+			float radius = (bounds.extent_x[i] * glm::abs(plane.x) + bounds.extent_y[i] * glm::abs(plane.y)) + bounds.extent_z[i] * glm::abs(plane.z);
+			visible = !(dist + radius < 0.f);
+		}
+
+		if (visible)
+			out_visible.push_back(i);
+	}
+}
+
+void FrustumCuller::CullParallel(const CullingBoundsSoA& bounds, const std::vector<FrustumPlanes>& views, std::vector<std::vector<uint32_t>>& out_visible) {
+	uint32_t count = bounds.GetCount();
+	uint32_t num_chunks = (count + JOB_CHUNK_SIZE - 1) / JOB_CHUNK_SIZE;
+
+	out_visible.resize(views.size());
+	for (auto& visible : out_visible) {
+		visible.clear();
+	}
+
+	if (num_chunks <= 1) {
+		for (size_t v = 0; v < views.size(); v++) {
+			CullRange(bounds, views[v], 0, count, out_visible[v]);
+		}
+		return;
+	}
+
+	// Work is split per (view, chunk), each writes to its own output so results can be concatenated in order afterwards
+	std::vector<std::vector<uint32_t>> chunk_results(views.size() * num_chunks);
+
+	JobSystem::ParallelFor((uint32_t)chunk_results.size(), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			uint32_t view_idx = i / num_chunks;
+			uint32_t chunk_begin = (i % num_chunks) * JOB_CHUNK_SIZE;
+
+			chunk_results[i].reserve(JOB_CHUNK_SIZE);
+			CullRange(bounds, views[view_idx], chunk_begin, glm::min(chunk_begin + JOB_CHUNK_SIZE, count), chunk_results[i]);
+		}
+	});
+
+	for (size_t v = 0; v < views.size(); v++) {
+		size_t total = 0;
+		for (uint32_t c = 0; c < num_chunks; c++) {
+			total += chunk_results[v * num_chunks + c].size();
+		}
+
+		out_visible[v].reserve(total);
+		for (uint32_t c = 0; c < num_chunks; c++) {
+			auto& result = chunk_results[v * num_chunks + c];
+			out_visible[v].insert(out_visible[v].end(), result.begin(), result.end());
+		}
+	}
+}
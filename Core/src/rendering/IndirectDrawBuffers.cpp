@@ -0,0 +1,65 @@
+#include "pch/pch.h"
+#include "rendering/IndirectDrawBuffers.h"
+#include "scene/SceneSnapshotSystem.h"
+#include "assets/AssetManager.h"
+
+using namespace SNAKE;
+
+static_assert(sizeof(DrawIndexedCommand) == sizeof(vk::DrawIndexedIndirectCommand));
+static_assert(offsetof(DrawIndexedCommand, first_index) == offsetof(VkDrawIndexedIndirectCommand, firstIndex));
+static_assert(offsetof(DrawIndexedCommand, vertex_offset) == offsetof(VkDrawIndexedIndirectCommand, vertexOffset));
+static_assert(offsetof(DrawIndexedCommand, first_instance) == offsetof(VkDrawIndexedIndirectCommand, firstInstance));
+
+void IndirectDrawBuffers::Init() {
+	for (FrameInFlightIndex i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		m_command_buffers[i].CreateBuffer(sizeof(vk::DrawIndexedIndirectCommand) * INITIAL_CAPACITY, vk::BufferUsageFlagBits::eIndirectBuffer |
+			vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+
+		m_instance_buffers[i].CreateBuffer(sizeof(DrawInstanceData) * INITIAL_CAPACITY, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+			vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+	}
+}
+
+void IndirectDrawBuffers::Upload(const IndirectDrawBuilder& builder, FrameInFlightIndex fif) {
+	auto& commands = builder.GetCommands();
+	auto& instance_data = builder.GetInstanceData();
+
+	size_t commands_size = commands.size() * sizeof(vk::DrawIndexedIndirectCommand);
+	size_t instance_data_size = instance_data.size() * sizeof(DrawInstanceData);
+
+	// Resizing dispatches a resource event so any descriptor buffers linked to the instance buffer are updated
+	if (commands_size > m_command_buffers[fif].alloc_info.size)
+		m_command_buffers[fif].Resize(glm::max(commands_size, (size_t)m_command_buffers[fif].alloc_info.size * 2));
+
+	if (instance_data_size > m_instance_buffers[fif].alloc_info.size)
+		m_instance_buffers[fif].Resize(glm::max(instance_data_size, (size_t)m_instance_buffers[fif].alloc_info.size * 2));
+
+	if (commands_size > 0) {
+		memcpy(m_command_buffers[fif].Map(), commands.data(), commands_size);
+		memcpy(m_instance_buffers[fif].Map(), instance_data.data(), instance_data_size);
+	}
+
+	m_draw_counts[fif] = (uint32_t)commands.size();
+}
+
+void IndirectDrawBuffers::ResolveMeshSources(const SceneSnapshotData& snapshot, const CullingSystem::VisibleList& visible, std::vector<IndirectDrawBuilder::MeshDrawSource>& sources) {
+	auto& mesh_buffer_manager = AssetManager::Get().mesh_buffer_manager;
+	sources.assign(snapshot.mesh_ranges.size(), {});
+
+	for (size_t r = 0; r < snapshot.mesh_ranges.size(); r++) {
+		if (visible.range_starts[r] == visible.range_starts[r + 1])
+			continue;
+
+		auto* p_mesh_data = AssetManager::Resolve(snapshot.mesh_ranges[r].mesh)->data.get();
+		auto& entry = mesh_buffer_manager.GetEntryData(p_mesh_data);
+
+		sources[r] = IndirectDrawBuilder::MeshDrawSource{
+			.submeshes = p_mesh_data->submeshes,
+			.lods = p_mesh_data->lods,
+			.meshlets = p_mesh_data->meshlets,
+			.data_start_indices_idx = entry.data_start_indices_idx,
+			.data_start_vertex_idx = entry.data_start_vertex_idx,
+			.quantisation_start_idx = entry.quantisation_start_idx
+		};
+	}
+}
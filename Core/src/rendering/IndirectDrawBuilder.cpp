@@ -0,0 +1,110 @@
+#include "pch/pch.h"
+#include "rendering/IndirectDrawBuilder.h"
+#include "scene/SceneSnapshotSystem.h"
+
+using namespace SNAKE;
+
+void IndirectDrawBuilder::Reset() {
+	m_commands.clear();
+	m_instance_data.clear();
+}
+
+void IndirectDrawBuilder::AddDraw(const SubmeshDrawInfo& submesh, uint32_t transform_idx, uint32_t material_idx) {
+	if (!m_commands.empty()) {
+		auto& last = m_commands.back();
+		if (last.first_index == submesh.first_index && last.index_count == submesh.index_count && last.vertex_offset == submesh.vertex_offset) {
+			last.instance_count++;
+			m_instance_data.push_back(DrawInstanceData{ transform_idx, material_idx, submesh.quantisation_idx });
+			return;
+		}
+	}
+
+	m_commands.push_back(DrawIndexedCommand{
+		.index_count = submesh.index_count,
+		.instance_count = 1,
+		.first_index = submesh.first_index,
+		.vertex_offset = submesh.vertex_offset,
+		.first_instance = (uint32_t)m_instance_data.size()
+	});
+	m_instance_data.push_back(DrawInstanceData{ transform_idx, material_idx, submesh.quantisation_idx });
+}
+
+void IndirectDrawBuilder::AddVisibleItems(const SceneSnapshotData& snapshot, std::span<const MeshDrawSource> meshes, const std::vector<CullingSystem::DrawItem>& draw_items,
+	const CullingSystem::VisibleList& visible) {
+	SNK_ASSERT(meshes.size() == snapshot.mesh_ranges.size());
+
+	for (size_t r = 0; r < snapshot.mesh_ranges.size(); r++) {
+		uint32_t begin = visible.range_starts[r];
+		uint32_t end = visible.range_starts[r + 1];
+		if (begin == end)
+			continue;
+
+		auto& range = snapshot.mesh_ranges[r];
+		auto& mesh = meshes[r];
+		auto& submeshes = mesh.submeshes;
+		auto& lods = mesh.lods;
+
+		// Counting sort of the range's items by (submesh, lod), visible items are ordered by instance so each bucket stays ordered by instance
+		uint32_t num_levels = (uint32_t)lods.size() + 1;
+		auto get_bucket = [&](uint32_t i) {
+			return draw_items[visible.items[i]].submesh_idx * num_levels + visible.lods[i];
+		};
+
+		m_bucket_offsets.assign(submeshes.size() * num_levels + 1, 0);
+		for (uint32_t i = begin; i < end; i++) {
+			m_bucket_offsets[get_bucket(i) + 1]++;
+		}
+
+		for (size_t b = 1; b < m_bucket_offsets.size(); b++) {
+			m_bucket_offsets[b] += m_bucket_offsets[b - 1];
+		}
+
+		// Stores positions in the visible list rather than draw item indices so each item's lod can still be read
+		m_sorted_items.resize(end - begin);
+		for (uint32_t i = begin; i < end; i++) {
+			m_sorted_items[m_bucket_offsets[get_bucket(i)]++] = i;
+		}
+
+		for (auto visible_idx : m_sorted_items) {
+			auto& item = draw_items[visible.items[visible_idx]];
+			auto& submesh = submeshes[item.submesh_idx];
+
+			unsigned base_index = submesh.base_index;
+			unsigned num_indices = submesh.num_indices;
+			if (uint8_t lod = visible.lods[visible_idx]; lod > 0) {
+				base_index = lods[lod - 1].submeshes[item.submesh_idx].base_index;
+				num_indices = lods[lod - 1].submeshes[item.submesh_idx].num_indices;
+			}
+
+			SubmeshDrawInfo info{
+				.first_index = mesh.data_start_indices_idx + base_index,
+				.index_count = num_indices,
+				.vertex_offset = (int32_t)(mesh.data_start_vertex_idx + submesh.base_vertex),
+				.quantisation_idx = mesh.quantisation_start_idx + item.submesh_idx
+			};
+
+			uint32_t transform_idx = snapshot.static_mesh_data[item.instance_idx].transform_buffer_idx;
+			uint32_t material_idx = snapshot.GetMaterialIdx(range, submesh.material_index);
+
+			auto meshlet_range = visible.meshlet_ranges[visible_idx];
+			if (meshlet_range.start == CullingSystem::VisibleList::WHOLE_ITEM) {
+				AddDraw(info, transform_idx, material_idx);
+				continue;
+			}
+
+			// Meshlets are consecutive index ranges, so each run of consecutive visible meshlets is drawn as one range
+			uint32_t meshlets_end = meshlet_range.start + meshlet_range.count;
+			for (uint32_t m = meshlet_range.start; m < meshlets_end;) {
+				auto& first_meshlet = mesh.meshlets[visible.meshlets[m]];
+				info.first_index = mesh.data_start_indices_idx + first_meshlet.base_index;
+				info.index_count = first_meshlet.num_indices;
+
+				for (m++; m < meshlets_end && visible.meshlets[m] == visible.meshlets[m - 1] + 1; m++) {
+					info.index_count += mesh.meshlets[visible.meshlets[m]].num_indices;
+				}
+
+				AddDraw(info, transform_idx, material_idx);
+			}
+		}
+	}
+}
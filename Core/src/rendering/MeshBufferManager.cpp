@@ -7,71 +7,173 @@
 using namespace SNAKE;
 
 void MeshBufferManager::Init() {
-	m_position_buf.CreateBuffer(256, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
-		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc);
-	m_normal_buf.CreateBuffer(256, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
-		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc);
-	m_tangent_buf.CreateBuffer(256, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
-		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc);
-	m_tex_coord_buf.CreateBuffer(256, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
-		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc);
-	m_index_buf.CreateBuffer(256, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
-		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc);
+	m_compact_vertex_format = use_compact_vertex_format;
+
+	auto alignment = VkContext::GetPhysicalDevice().buffer_properties.descriptorBufferOffsetAlignment;
+	auto vertex_buf_size = aligned_size(INITIAL_VERTEX_CAPACITY * sizeof(aiVector3D), alignment);
+	auto vertex_usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc;
+
+	// Shared with the transfer queue so queued uploads can write them while they're in use by rendering
+	m_position_buf.CreateBuffer(vertex_buf_size, vertex_usage, 0, true);
+	if (m_compact_vertex_format) {
+		m_compact_vertex_buf.CreateBuffer(aligned_size(INITIAL_VERTEX_CAPACITY * sizeof(CompactVertex), alignment), vertex_usage, 0, true);
+	}
+	else {
+		m_normal_buf.CreateBuffer(vertex_buf_size, vertex_usage, 0, true);
+		m_tangent_buf.CreateBuffer(vertex_buf_size, vertex_usage, 0, true);
+		m_tex_coord_buf.CreateBuffer(aligned_size(INITIAL_VERTEX_CAPACITY * sizeof(aiVector2D), alignment), vertex_usage, 0, true);
+	}
+
+	m_index_buf.CreateBuffer(aligned_size(INITIAL_INDEX_CAPACITY * sizeof(unsigned), alignment), vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc, 0, true);
+
+	m_quantisation_buf.CreateBuffer(aligned_size(INITIAL_SUBMESH_CAPACITY * sizeof(SubmeshQuantisation), alignment), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+		vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc, 0, true);
+	m_meshlet_buf.CreateBuffer(aligned_size(INITIAL_MESHLET_CAPACITY * sizeof(Meshlet), alignment), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+		vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc, 0, true);
+
+	m_vertex_allocator.Init(INITIAL_VERTEX_CAPACITY);
+	m_index_allocator.Init(INITIAL_INDEX_CAPACITY);
+	m_quantisation_allocator.Init(INITIAL_SUBMESH_CAPACITY);
+	m_meshlet_allocator.Init(INITIAL_MESHLET_CAPACITY);
+
+	m_asset_event_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<AssetEvent const*>(p_event);
+		if (auto* p_mesh_data = dynamic_cast<MeshDataAsset*>(p_casted->p_asset); p_mesh_data && p_casted->type == AssetEventType::DESTROYED) {
+			UnloadMesh(p_mesh_data);
+		}
+	};
+
+	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		PollInFlightBatches();
+		FlushQueuedUploads();
+		ProcessPendingReleases();
+
+		if (defragmentation_enabled)
+			Defragment(DEFRAG_MOVES_PER_FRAME);
+	};
+
+	EventManagerG::RegisterListener<AssetEvent>(m_asset_event_listener);
+	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
 }
 
-void MeshBufferManager::LoadMeshFromData(MeshDataAsset* p_mesh_data_asset, MeshData& data) {
-	p_mesh_data_asset->submeshes = data.submeshes;
-	p_mesh_data_asset->num_indices = data.num_indices;
-	p_mesh_data_asset->num_vertices = data.num_vertices;
+void MeshBufferManager::GrowVertexBuffers(uint32_t min_capacity) {
+	WaitForBufferCopies();
 
-	p_mesh_data_asset->submesh_blas_array.resize(p_mesh_data_asset->submeshes.size(), nullptr);
-	for (size_t i = 0; i < p_mesh_data_asset->submeshes.size(); i++) {
-		p_mesh_data_asset->submesh_blas_array[i] = new BLAS();
-		p_mesh_data_asset->submesh_blas_array[i]->GenerateFromMeshData(data, (uint32_t)i);
+	uint32_t new_capacity = glm::max(m_vertex_allocator.GetCapacity() * 2, min_capacity);
+	auto alignment = VkContext::GetPhysicalDevice().buffer_properties.descriptorBufferOffsetAlignment;
+
+	for (auto [p_buf, element_size] : GetVertexStreams()) {
+		m_stats.bytes_copied_on_grow += p_buf->alloc_info.size;
+		p_buf->Resize(aligned_size(new_capacity * element_size, alignment));
 	}
 
-	S_VkBuffer staging_buf{};
+	m_stats.num_grows++;
+	m_vertex_allocator.Grow(new_capacity);
+}
 
-	uint32_t prev_total_indices = m_total_indices;
-	uint32_t prev_total_vertices = m_total_vertices;
-	m_total_indices += data.num_indices;
-	m_total_vertices += data.num_vertices;
+void MeshBufferManager::GrowIndexBuffer(uint32_t min_capacity) {
+	WaitForBufferCopies();
 
+	uint32_t new_capacity = glm::max(m_index_allocator.GetCapacity() * 2, min_capacity);
 	auto alignment = VkContext::GetPhysicalDevice().buffer_properties.descriptorBufferOffsetAlignment;
-	auto aligned_vertex_size = aligned_size(m_total_vertices * sizeof(aiVector3D), alignment);
 
-	// Create and fill staging buffer with mesh data
-	staging_buf.CreateBuffer(glm::max(data.num_vertices * sizeof(aiVector3D), data.num_indices * sizeof(unsigned)),
-		vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
-	auto* p_staging_data = staging_buf.Map();
-	memcpy(p_staging_data, data.positions, data.num_vertices * sizeof(aiVector3D));
+	m_stats.bytes_copied_on_grow += m_index_buf.alloc_info.size;
+	m_stats.num_grows++;
 
-	m_position_buf.Resize(aligned_vertex_size);
-	m_normal_buf.Resize(aligned_vertex_size);
-	m_tangent_buf.Resize(aligned_vertex_size);
-	m_tex_coord_buf.Resize(aligned_size(m_total_vertices * sizeof(aiVector2D), alignment));
-	m_index_buf.Resize(aligned_size(m_total_indices * sizeof(unsigned), alignment));
+	m_index_buf.Resize(aligned_size(new_capacity * sizeof(unsigned), alignment));
+	m_index_allocator.Grow(new_capacity);
+}
+
+void MeshBufferManager::GrowQuantisationBuffer(uint32_t min_capacity) {
+	WaitForBufferCopies();
+
+	uint32_t new_capacity = glm::max(m_quantisation_allocator.GetCapacity() * 2, min_capacity);
+	auto alignment = VkContext::GetPhysicalDevice().buffer_properties.descriptorBufferOffsetAlignment;
+
+	m_stats.bytes_copied_on_grow += m_quantisation_buf.alloc_info.size;
+	m_stats.num_grows++;
+
+	m_quantisation_buf.Resize(aligned_size(new_capacity * sizeof(SubmeshQuantisation), alignment));
+	m_quantisation_allocator.Grow(new_capacity);
+}
+
+void MeshBufferManager::GrowMeshletBuffer(uint32_t min_capacity) {
+	WaitForBufferCopies();
 
+	uint32_t new_capacity = glm::max(m_meshlet_allocator.GetCapacity() * 2, min_capacity);
+	auto alignment = VkContext::GetPhysicalDevice().buffer_properties.descriptorBufferOffsetAlignment;
 
-	// Copy data from newly loaded mesh into new buffer
-	memcpy(p_staging_data, data.positions, data.num_vertices * sizeof(aiVector3D));
-	CopyBuffer(staging_buf.buffer, m_position_buf.buffer, data.num_vertices * sizeof(aiVector3D), 0, prev_total_vertices * sizeof(aiVector3D));
+	m_stats.bytes_copied_on_grow += m_meshlet_buf.alloc_info.size;
+	m_stats.num_grows++;
 
-	memcpy(p_staging_data, data.normals, data.num_vertices * sizeof(aiVector3D));
-	CopyBuffer(staging_buf.buffer, m_normal_buf.buffer, data.num_vertices * sizeof(aiVector3D), 0, prev_total_vertices * sizeof(aiVector3D));
+	m_meshlet_buf.Resize(aligned_size(new_capacity * sizeof(Meshlet), alignment));
+	m_meshlet_allocator.Grow(new_capacity);
+}
 
-	memcpy(p_staging_data, data.tangents, data.num_vertices * sizeof(aiVector3D));
-	CopyBuffer(staging_buf.buffer, m_tangent_buf.buffer, data.num_vertices * sizeof(aiVector3D), 0, prev_total_vertices * sizeof(aiVector3D));
+void MeshBufferManager::WaitForBufferCopies() {
+	for (auto& p_batch : m_in_flight_batches) {
+		p_batch->Wait();
+	}
 
-	memcpy(p_staging_data, data.tex_coords, data.num_vertices * sizeof(aiVector2D));
-	CopyBuffer(staging_buf.buffer, m_tex_coord_buf.buffer, data.num_vertices * sizeof(aiVector2D), 0, prev_total_vertices * sizeof(aiVector2D));
+	m_in_flight_batches.clear();
+	UploadEngine::Get().Wait(m_defrag_ticket);
+}
 
-	memcpy(p_staging_data, data.indices, data.num_indices * sizeof(unsigned));
-	CopyBuffer(staging_buf.buffer, m_index_buf.buffer, data.num_indices * sizeof(unsigned), 0, prev_total_indices * sizeof(unsigned));
-	
-	staging_buf.Unmap();
+std::vector<std::pair<S_VkBuffer*, uint32_t>> MeshBufferManager::GetVertexStreams() {
+	if (m_compact_vertex_format)
+		return { { &m_position_buf, (uint32_t)sizeof(aiVector3D) }, { &m_compact_vertex_buf, (uint32_t)sizeof(CompactVertex) } };
 
-	for (auto mat_uuid : data.materials) {
+	return { { &m_position_buf, (uint32_t)sizeof(aiVector3D) }, { &m_normal_buf, (uint32_t)sizeof(aiVector3D) }, { &m_tangent_buf, (uint32_t)sizeof(aiVector3D) },
+		{ &m_tex_coord_buf, (uint32_t)sizeof(aiVector2D) } };
+}
+
+uint64_t MeshBufferManager::GetGPUSize(const MeshEntryData& entry) const {
+	return (uint64_t)entry.num_vertices * GetStoredVertexSize() + (uint64_t)entry.num_indices * sizeof(unsigned) +
+		entry.num_submeshes * sizeof(SubmeshQuantisation) + entry.num_meshlets * sizeof(Meshlet);
+}
+
+std::vector<CompactVertex> MeshBufferManager::EncodeCompactVertices(const MeshData& data, const std::vector<ExtraMath::AABB>& submesh_aabbs) {
+	std::vector<CompactVertex> compact_vertices(data.num_vertices);
+
+	for (size_t i = 0; i < data.submeshes.size(); i++) {
+		auto& submesh = data.submeshes[i];
+		auto quantisation = VertexEncoding::GetQuantisation(submesh_aabbs[i]);
+
+		for (unsigned v = submesh.base_vertex; v < submesh.base_vertex + submesh.num_vertices; v++) {
+			auto& p = data.positions[v];
+			auto& n = data.normals[v];
+			auto& t = data.tangents[v];
+			auto& uv = data.tex_coords[v];
+
+			// Bitangents aren't imported, shaders have always used cross(n, t) so the sign is positive
+			compact_vertices[v] = VertexEncoding::Encode({ p.x, p.y, p.z }, { n.x, n.y, n.z }, { t.x, t.y, t.z }, 1.f, { uv.x, uv.y }, quantisation);
+		}
+	}
+
+	return compact_vertices;
+}
+
+void MeshBufferManager::PrepareMeshAsset(MeshDataAsset* p_mesh_data_asset, const MeshData& data, std::vector<ExtraMath::AABB>&& submesh_aabbs, OccluderMeshData&& occluder_mesh,
+	uint64_t content_hash) {
+	p_mesh_data_asset->submeshes = data.submeshes;
+	p_mesh_data_asset->num_indices = data.num_indices;
+	p_mesh_data_asset->num_vertices = data.num_vertices;
+	p_mesh_data_asset->submesh_aabbs = std::move(submesh_aabbs);
+	p_mesh_data_asset->lods = data.lods;
+	p_mesh_data_asset->meshlets = data.meshlets;
+	p_mesh_data_asset->submesh_meshlets = data.submesh_meshlets;
+	p_mesh_data_asset->occluder_mesh = std::move(occluder_mesh);
+	AssetManager::SetContentHash(p_mesh_data_asset, content_hash);
+	ResolveMaterials(p_mesh_data_asset, data.materials);
+}
+
+void MeshBufferManager::ResolveMaterials(MeshDataAsset* p_mesh_data_asset, const std::vector<uint64_t>& material_uuids) {
+	// Streamed meshes have their materials resolved when they're created, before their data is loaded
+	p_mesh_data_asset->materials.clear();
+
+	for (auto mat_uuid : material_uuids) {
 		auto mat = AssetManager::GetAsset<MaterialAsset>(mat_uuid);
 		if (!mat) {
 			SNK_CORE_ERROR("LoadMeshFromData error: attempted to load material uuid '{}' which doesn't exist", mat_uuid);
@@ -79,16 +181,432 @@ void MeshBufferManager::LoadMeshFromData(MeshDataAsset* p_mesh_data_asset, MeshD
 		}
 		p_mesh_data_asset->materials.push_back(mat);
 	}
+}
+
+bool MeshBufferManager::AllocateMesh(MeshDataAsset* p_mesh_data_asset, MeshData& data, uint64_t content_hash) {
+	SNK_ASSERT(!m_entries.contains(p_mesh_data_asset));
+
+	auto& users = m_shared_data[content_hash];
+	if (!users.empty()) {
+		auto* p_source = users.front();
+		auto& entry = m_entries[p_mesh_data_asset];
+		entry = m_entries[p_source];
+		p_mesh_data_asset->submesh_blas_array = p_source->submesh_blas_array;
+		users.push_back(p_mesh_data_asset);
+
+		m_stats.num_meshes = (uint32_t)m_entries.size();
+		m_stats.num_shared_meshes++;
+		m_stats.bytes_shared += GetGPUSize(entry);
+		return false;
+	}
+
+	users.push_back(p_mesh_data_asset);
+	BuildSubmeshBLAS(p_mesh_data_asset, data);
+
+	// Growing leaves a free range at the end at least as large as the request, so the second allocation can't fail
+	uint32_t vertex_offset = m_vertex_allocator.Allocate(data.num_vertices);
+	if (vertex_offset == RangeAllocator::INVALID_OFFSET) {
+		GrowVertexBuffers(m_vertex_allocator.GetCapacity() + data.num_vertices);
+		vertex_offset = m_vertex_allocator.Allocate(data.num_vertices);
+	}
+
+	uint32_t index_offset = m_index_allocator.Allocate(data.num_indices);
+	if (index_offset == RangeAllocator::INVALID_OFFSET) {
+		GrowIndexBuffer(m_index_allocator.GetCapacity() + data.num_indices);
+		index_offset = m_index_allocator.Allocate(data.num_indices);
+	}
+
+	uint32_t num_submeshes = (uint32_t)p_mesh_data_asset->submeshes.size();
+	uint32_t quantisation_offset = m_quantisation_allocator.Allocate(num_submeshes);
+	if (quantisation_offset == RangeAllocator::INVALID_OFFSET) {
+		GrowQuantisationBuffer(m_quantisation_allocator.GetCapacity() + num_submeshes);
+		quantisation_offset = m_quantisation_allocator.Allocate(num_submeshes);
+	}
+
+	uint32_t num_meshlets = (uint32_t)data.meshlets.size();
+	uint32_t meshlet_offset = m_meshlet_allocator.Allocate(num_meshlets);
+	if (meshlet_offset == RangeAllocator::INVALID_OFFSET) {
+		GrowMeshletBuffer(m_meshlet_allocator.GetCapacity() + num_meshlets);
+		meshlet_offset = m_meshlet_allocator.Allocate(num_meshlets);
+	}
+
+	SNK_ASSERT(vertex_offset != RangeAllocator::INVALID_OFFSET && index_offset != RangeAllocator::INVALID_OFFSET && quantisation_offset != RangeAllocator::INVALID_OFFSET &&
+		meshlet_offset != RangeAllocator::INVALID_OFFSET);
 
 	auto& entry = m_entries[p_mesh_data_asset];
-	entry.data_start_indices_idx = prev_total_indices;
-	entry.data_start_vertex_idx = prev_total_vertices;
+	entry.data_start_indices_idx = index_offset;
+	entry.data_start_vertex_idx = vertex_offset;
 	entry.num_indices = data.num_indices;
-	entry.num_indices = data.num_vertices;
+	entry.num_vertices = data.num_vertices;
+	entry.quantisation_start_idx = quantisation_offset;
+	entry.num_submeshes = num_submeshes;
+	entry.meshlet_start_idx = meshlet_offset;
+	entry.num_meshlets = num_meshlets;
+	entry.content_hash = content_hash;
+	m_stats.num_meshes = (uint32_t)m_entries.size();
+	return true;
+}
+
+void MeshBufferManager::BuildSubmeshBLAS(MeshDataAsset* p_mesh_data_asset, MeshData& data) {
+	p_mesh_data_asset->submesh_blas_array.resize(p_mesh_data_asset->submeshes.size(), nullptr);
+	for (size_t i = 0; i < p_mesh_data_asset->submeshes.size(); i++) {
+		p_mesh_data_asset->submesh_blas_array[i] = new BLAS();
+		p_mesh_data_asset->submesh_blas_array[i]->GenerateFromMeshData(data, (uint32_t)i);
+	}
 }
 
+void MeshBufferManager::StageMesh(UploadBatch& batch, MeshDataAsset* p_mesh_data_asset, const MeshData& data, const std::vector<CompactVertex>& compact_vertices) {
+	const auto& entry = GetEntryData(p_mesh_data_asset);
+	uint32_t vertex_offset = entry.data_start_vertex_idx;
+	uint32_t index_offset = entry.data_start_indices_idx;
+
+	batch.AddBufferCopy(m_position_buf.buffer, vertex_offset * sizeof(aiVector3D), data.positions, data.num_vertices * sizeof(aiVector3D));
+	if (m_compact_vertex_format) {
+		SNK_ASSERT(compact_vertices.size() == data.num_vertices);
+		batch.AddBufferCopy(m_compact_vertex_buf.buffer, vertex_offset * sizeof(CompactVertex), compact_vertices.data(), compact_vertices.size() * sizeof(CompactVertex));
+	}
+	else {
+		batch.AddBufferCopy(m_normal_buf.buffer, vertex_offset * sizeof(aiVector3D), data.normals, data.num_vertices * sizeof(aiVector3D));
+		batch.AddBufferCopy(m_tangent_buf.buffer, vertex_offset * sizeof(aiVector3D), data.tangents, data.num_vertices * sizeof(aiVector3D));
+		batch.AddBufferCopy(m_tex_coord_buf.buffer, vertex_offset * sizeof(aiVector2D), data.tex_coords, data.num_vertices * sizeof(aiVector2D));
+	}
+	batch.AddBufferCopy(m_index_buf.buffer, index_offset * sizeof(unsigned), data.indices, data.num_indices * sizeof(unsigned));
+
+	std::vector<SubmeshQuantisation> quantisation;
+	for (auto& aabb : p_mesh_data_asset->submesh_aabbs) {
+		quantisation.push_back(VertexEncoding::GetQuantisation(aabb));
+	}
+	batch.AddBufferCopy(m_quantisation_buf.buffer, entry.quantisation_start_idx * sizeof(SubmeshQuantisation), quantisation.data(), quantisation.size() * sizeof(SubmeshQuantisation));
+
+	batch.AddBufferCopy(m_meshlet_buf.buffer, entry.meshlet_start_idx * sizeof(Meshlet), data.meshlets.data(), data.meshlets.size() * sizeof(Meshlet));
 
+	m_stats.bytes_staged += GetGPUSize(entry);
+}
+
+void MeshBufferManager::LoadMeshFromData(MeshDataAsset* p_mesh_data_asset, MeshData& data) {
+	uint64_t content_hash = data.CalculateContentHash();
+	PrepareMeshAsset(p_mesh_data_asset, data, data.CalculateSubmeshAABBs(), data.GenerateOccluderMesh(), content_hash);
+
+	// Meshes sharing loaded data have nothing to copy, the default ticket is already complete
+	UploadTicket ticket;
+	if (AllocateMesh(p_mesh_data_asset, data, content_hash)) {
+		auto p_batch = std::make_unique<UploadBatch>();
+		StageMesh(*p_batch, p_mesh_data_asset, data, m_compact_vertex_format ? EncodeCompactVertices(data, p_mesh_data_asset->submesh_aabbs) : std::vector<CompactVertex>{});
+		p_batch->Submit();
+		m_stats.num_upload_batches++;
+
+		ticket = p_batch->GetTicket();
+		m_in_flight_batches.push_back(std::move(p_batch));
+	}
+
+	m_pending_loaded_events.push_back(PendingLoadedEvent{ p_mesh_data_asset, ticket });
+}
+
+PreparedMeshUpload MeshBufferManager::PrepareMeshUpload(std::unique_ptr<MeshData> p_data) const {
+	PreparedMeshUpload upload;
+	upload.submesh_aabbs = p_data->CalculateSubmeshAABBs();
+	upload.occluder_mesh = p_data->GenerateOccluderMesh();
+	if (m_compact_vertex_format)
+		upload.compact_vertices = EncodeCompactVertices(*p_data, upload.submesh_aabbs);
+
+	upload.content_hash = p_data->CalculateContentHash();
+	upload.p_data = std::move(p_data);
+	return upload;
+}
 
-void MeshBufferManager::UnloadMesh([[maybe_unused]] MeshDataAsset* p_mesh_data_asset) {
-	// TODO: Implement
-}
\ No newline at end of file
+uint64_t MeshBufferManager::GetUploadSize(const PreparedMeshUpload& upload) const {
+	auto& data = *upload.p_data;
+	return (uint64_t)data.num_vertices * GetStoredVertexSize() + (uint64_t)data.num_indices * sizeof(unsigned) +
+		data.submeshes.size() * sizeof(SubmeshQuantisation) + data.meshlets.size() * sizeof(Meshlet);
+}
+
+void MeshBufferManager::QueueMeshUpload(MeshDataAsset* p_mesh_data_asset, std::unique_ptr<MeshData> p_data) {
+	// Derived CPU data is generated on the calling thread, the asset itself is only written at frame start on the main thread
+	QueueMeshUpload(p_mesh_data_asset, PrepareMeshUpload(std::move(p_data)));
+}
+
+void MeshBufferManager::QueueMeshUpload(MeshDataAsset* p_mesh_data_asset, PreparedMeshUpload&& upload) {
+	std::scoped_lock l(m_queued_uploads_mux);
+	m_queued_uploads.push_back(QueuedUpload{ p_mesh_data_asset, std::move(upload) });
+}
+
+void MeshBufferManager::QueueMeshReload(MeshDataAsset* p_mesh_data_asset, PreparedMeshUpload&& upload) {
+	std::scoped_lock l(m_queued_uploads_mux);
+
+	// Only the latest data is kept, earlier data would be allocated and released again in the same batch
+	std::erase_if(m_queued_uploads, [&](const QueuedUpload& queued) { return queued.p_mesh_data_asset == p_mesh_data_asset; });
+	m_queued_uploads.push_back(QueuedUpload{ p_mesh_data_asset, std::move(upload), true });
+}
+
+bool MeshBufferManager::IsMeshLoaded(MeshDataAsset* p_mesh_data_asset) const {
+	return m_entries.contains(p_mesh_data_asset);
+}
+
+void MeshBufferManager::FlushQueuedUploads() {
+	// Reloads release ranges defragmentation copies may still be writing, uploads stay queued until they're complete
+	if (!UploadEngine::Get().IsComplete(m_defrag_ticket))
+		return;
+
+	std::vector<QueuedUpload> uploads;
+	{
+		std::scoped_lock l(m_queued_uploads_mux);
+		std::swap(uploads, m_queued_uploads);
+	}
+
+	if (uploads.empty())
+		return;
+
+	std::vector<MeshDataAsset*> loaded_meshes;
+	loaded_meshes.reserve(uploads.size());
+
+	// Reloaded meshes, given fresh ranges
+	std::vector<MeshDataAsset*> moved_meshes;
+
+	// Every mesh is allocated before any copies are staged, growing a buffer recreates it and would leave earlier copies targeting the old one
+	// Meshes sharing data that's already loaded or earlier in this batch have nothing to stage
+	std::erase_if(uploads, [&](QueuedUpload& queued) {
+		auto* p_mesh_data = queued.p_mesh_data_asset;
+		auto& upload = queued.upload;
+
+		bool is_reload = queued.reload && m_entries.contains(p_mesh_data);
+		if (is_reload && m_entries.at(p_mesh_data).content_hash == upload.content_hash)
+			return true;
+
+		PrepareMeshAsset(p_mesh_data, *upload.p_data, std::move(upload.submesh_aabbs), std::move(upload.occluder_mesh), upload.content_hash);
+		loaded_meshes.push_back(p_mesh_data);
+
+		// Frames in flight may still be drawing from the old ranges, they're released once those frames finish rather than written over
+		if (is_reload) {
+			m_stats.num_reloads++;
+			ReleaseMeshData(p_mesh_data);
+			moved_meshes.push_back(p_mesh_data);
+		}
+
+		return !AllocateMesh(p_mesh_data, *upload.p_data, upload.content_hash);
+	});
+
+	if (!uploads.empty()) {
+		auto p_batch = std::make_unique<UploadBatch>();
+		for (auto& queued : uploads) {
+			StageMesh(*p_batch, queued.p_mesh_data_asset, *queued.upload.p_data, queued.upload.compact_vertices);
+		}
+
+		p_batch->Submit();
+		m_stats.num_upload_batches++;
+		m_in_flight_batches.push_back(std::move(p_batch));
+	}
+
+	// Only after submitting, anything recorded from here on sees the copies
+	for (auto* p_mesh_data : loaded_meshes) {
+		EventManagerG::DispatchEvent(MeshDataLoadedEvent{ p_mesh_data });
+	}
+
+	for (auto* p_mesh_data : moved_meshes) {
+		EventManagerG::DispatchEvent(MeshDataMovedEvent{ p_mesh_data });
+	}
+}
+
+void MeshBufferManager::PollInFlightBatches() {
+	std::erase_if(m_in_flight_batches, [](const std::unique_ptr<UploadBatch>& p_batch) { return p_batch->IsComplete(); });
+
+	// Collected first, listeners may load more meshes
+	std::vector<MeshDataAsset*> loaded_meshes;
+	std::erase_if(m_pending_loaded_events, [&](const PendingLoadedEvent& pending) {
+		if (!UploadEngine::Get().IsComplete(pending.ticket))
+			return false;
+
+		loaded_meshes.push_back(pending.p_mesh_data_asset);
+		return true;
+	});
+
+	for (auto* p_mesh_data : loaded_meshes) {
+		EventManagerG::DispatchEvent(MeshDataLoadedEvent{ p_mesh_data });
+	}
+}
+
+void MeshBufferManager::UnloadMesh(MeshDataAsset* p_mesh_data_asset) {
+	{
+		std::scoped_lock l(m_queued_uploads_mux);
+		std::erase_if(m_queued_uploads, [&](const QueuedUpload& upload) { return upload.p_mesh_data_asset == p_mesh_data_asset; });
+	}
+
+	std::erase_if(m_pending_loaded_events, [&](const PendingLoadedEvent& pending) { return pending.p_mesh_data_asset == p_mesh_data_asset; });
+	ReleaseMeshData(p_mesh_data_asset);
+}
+
+void MeshBufferManager::ReleaseMeshData(MeshDataAsset* p_mesh_data_asset) {
+	auto it = m_entries.find(p_mesh_data_asset);
+	if (it == m_entries.end())
+		return;
+
+	auto& entry = it->second;
+	auto& users = m_shared_data[entry.content_hash];
+	std::erase(users, p_mesh_data_asset);
+
+	// Other meshes still use the data, only this asset's references to it are dropped
+	if (!users.empty()) {
+		m_stats.num_shared_meshes--;
+		m_stats.bytes_shared -= GetGPUSize(entry);
+		p_mesh_data_asset->submesh_blas_array.clear();
+		m_entries.erase(it);
+		m_stats.num_meshes = (uint32_t)m_entries.size();
+		return;
+	}
+
+	m_shared_data.erase(entry.content_hash);
+	m_pending_releases.push_back(PendingRelease{
+		.vertex_offset = entry.data_start_vertex_idx,
+		.num_vertices = entry.num_vertices,
+		.index_offset = entry.data_start_indices_idx,
+		.num_indices = entry.num_indices,
+		.quantisation_offset = entry.quantisation_start_idx,
+		.num_submeshes = entry.num_submeshes,
+		.meshlet_offset = entry.meshlet_start_idx,
+		.num_meshlets = entry.num_meshlets,
+		.blas_array = std::move(p_mesh_data_asset->submesh_blas_array)
+	});
+
+	p_mesh_data_asset->submesh_blas_array.clear();
+	m_entries.erase(it);
+	m_stats.num_meshes = (uint32_t)m_entries.size();
+}
+
+void MeshBufferManager::ProcessPendingReleases() {
+	std::erase_if(m_pending_releases, [this](PendingRelease& release) {
+		if (release.frames_remaining > 0)
+			release.frames_remaining--;
+
+		if (release.frames_remaining > 0 || !UploadEngine::Get().IsComplete(release.ticket))
+			return false;
+
+		m_vertex_allocator.Free(release.vertex_offset, release.num_vertices);
+		m_index_allocator.Free(release.index_offset, release.num_indices);
+		m_quantisation_allocator.Free(release.quantisation_offset, release.num_submeshes);
+		m_meshlet_allocator.Free(release.meshlet_offset, release.num_meshlets);
+
+		for (auto* p_blas : release.blas_array) {
+			delete p_blas;
+		}
+
+		return true;
+	});
+}
+
+void MeshBufferManager::ReleasePendingNow() {
+	WaitForBufferCopies();
+
+	for (auto& release : m_pending_releases) {
+		release.frames_remaining = 1;
+	}
+
+	ProcessPendingReleases();
+}
+
+void MeshBufferManager::Defragment(uint32_t max_moves) {
+	if (max_moves == 0 || m_entries.empty())
+		return;
+
+	// Uploads in flight may still be writing ranges a move would read, and a mesh moved by the last pass may be picked again before its copy lands
+	if (!m_in_flight_batches.empty() || !UploadEngine::Get().IsComplete(m_defrag_ticket))
+		return;
+
+	// Allocator state when planning last found nothing to move, planning is skipped until it changes
+	auto get_state = [](const RangeAllocator& allocator) {
+		return std::make_tuple(allocator.GetCapacity(), allocator.GetUsed(), allocator.GetNumFreeRanges());
+	};
+
+	bool vertices_fragmented = !m_vertex_allocator.IsCompact() && get_state(m_vertex_allocator) != m_defrag_stalled_vertex_state;
+	bool indices_fragmented = !m_index_allocator.IsCompact() && get_state(m_index_allocator) != m_defrag_stalled_index_state;
+	if (!vertices_fragmented && !indices_fragmented)
+		return;
+
+	struct Move {
+		MeshDataAsset* p_mesh_data;
+		uint32_t src;
+		uint32_t dst;
+		uint32_t count;
+	};
+
+	std::vector<Move> vertex_moves;
+	std::vector<Move> index_moves;
+
+	// Ranges nearest the end are moved into the lowest free range below them that fits
+	// Shared ranges are planned once, through the first mesh using them
+	auto plan_moves = [&](RangeAllocator& allocator, auto get_offset, auto get_count, std::vector<Move>& moves) {
+		std::vector<std::pair<uint32_t, MeshDataAsset*>> by_offset;
+		by_offset.reserve(m_shared_data.size());
+		for (auto& [content_hash, users] : m_shared_data) {
+			by_offset.emplace_back(get_offset(m_entries[users.front()]), users.front());
+		}
+		std::ranges::sort(by_offset, std::greater{});
+
+		for (auto [offset, p_mesh_data] : by_offset) {
+			if (moves.size() >= max_moves)
+				break;
+
+			uint32_t count = get_count(m_entries[p_mesh_data]);
+			uint32_t dst = allocator.AllocateBelow(count, offset);
+			if (dst != RangeAllocator::INVALID_OFFSET)
+				moves.push_back(Move{ p_mesh_data, offset, dst, count });
+		}
+	};
+
+	if (vertices_fragmented)
+		plan_moves(m_vertex_allocator, [](const MeshEntryData& e) { return e.data_start_vertex_idx; }, [](const MeshEntryData& e) { return e.num_vertices; }, vertex_moves);
+
+	if (indices_fragmented)
+		plan_moves(m_index_allocator, [](const MeshEntryData& e) { return e.data_start_indices_idx; }, [](const MeshEntryData& e) { return e.num_indices; }, index_moves);
+
+	if (vertices_fragmented && vertex_moves.empty())
+		m_defrag_stalled_vertex_state = get_state(m_vertex_allocator);
+
+	if (indices_fragmented && index_moves.empty())
+		m_defrag_stalled_index_state = get_state(m_index_allocator);
+
+	if (vertex_moves.empty() && index_moves.empty())
+		return;
+
+	// Destination ranges were free for at least MAX_FRAMES_IN_FLIGHT frames so nothing in flight reads them, source and destination never overlap
+	// The buffers are shared with the transfer queue, and frames recorded after this are ordered after the copies by the UploadEngine
+	auto vertex_streams = GetVertexStreams();
+	m_defrag_ticket = UploadEngine::Get().Submit([&](vk::CommandBuffer cmd) {
+		for (auto [p_buf, element_size] : vertex_streams) {
+			for (auto& move : vertex_moves) {
+				CopyBuffer(p_buf->buffer, p_buf->buffer, move.count * element_size, move.src * element_size, move.dst * element_size, cmd);
+			}
+		}
+
+		for (auto& move : index_moves) {
+			CopyBuffer(m_index_buf.buffer, m_index_buf.buffer, move.count * sizeof(unsigned), move.src * sizeof(unsigned), move.dst * sizeof(unsigned), cmd);
+		}
+	});
+
+	auto get_users = [this](MeshDataAsset* p_mesh_data) -> std::vector<MeshDataAsset*>& {
+		return m_shared_data[m_entries[p_mesh_data].content_hash];
+	};
+
+	// Frames in flight were recorded with the old offsets, so the old ranges are released like an unloaded mesh
+	for (auto& move : vertex_moves) {
+		for (auto* p_user : get_users(move.p_mesh_data)) {
+			m_entries[p_user].data_start_vertex_idx = move.dst;
+		}
+		m_pending_releases.push_back(PendingRelease{ .vertex_offset = move.src, .num_vertices = move.count, .ticket = m_defrag_ticket });
+	}
+
+	for (auto& move : index_moves) {
+		for (auto* p_user : get_users(move.p_mesh_data)) {
+			m_entries[p_user].data_start_indices_idx = move.dst;
+		}
+		m_pending_releases.push_back(PendingRelease{ .index_offset = move.src, .num_indices = move.count, .ticket = m_defrag_ticket });
+	}
+
+	std::set<MeshDataAsset*> moved_meshes;
+	for (auto& move : vertex_moves) std::ranges::copy(get_users(move.p_mesh_data), std::inserter(moved_meshes, moved_meshes.end()));
+	for (auto& move : index_moves) std::ranges::copy(get_users(move.p_mesh_data), std::inserter(moved_meshes, moved_meshes.end()));
+
+	for (auto* p_mesh_data : moved_meshes) {
+		EventManagerG::DispatchEvent(MeshDataMovedEvent{ p_mesh_data });
+	}
+
+	m_stats.num_defrag_moves += (uint32_t)(vertex_moves.size() + index_moves.size());
+}
@@ -0,0 +1,254 @@
+#include "pch/pch.h"
+#include "rendering/OcclusionCulling.h"
+#include "core/JobSystem.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define SNK_OCCLUSION_SSE
+#include <immintrin.h>
+#endif
+
+using namespace SNAKE;
+
+void OcclusionBuffer::Init(uint32_t width, uint32_t height) {
+	SNK_DBG_ASSERT(width > 0 && height > 0);
+	m_width = (width + 3) & ~3u;
+	m_height = height;
+
+	m_level_sizes.clear();
+	m_hiz.clear();
+
+	glm::uvec2 size{ m_width, m_height };
+	while (true) {
+		m_level_sizes.push_back(size);
+		m_hiz.emplace_back((size_t)size.x * size.y, 1.f);
+
+		if (size.x == 1 && size.y == 1)
+			break;
+
+		size = glm::max((size + 1u) / 2u, glm::uvec2(1));
+	}
+}
+
+void OcclusionBuffer::Clear() {
+	m_triangles.clear();
+	std::ranges::fill(m_hiz[0], 1.f);
+}
+
+void OcclusionBuffer::AddOccluder(const glm::mat4& proj_view_model, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+	std::vector<glm::vec4> clip_positions(positions.size());
+	for (size_t i = 0; i < positions.size(); i++) {
+		clip_positions[i] = proj_view_model * glm::vec4(positions[i], 1.f);
+	}
+
+	glm::vec2 screen_size{ (float)m_width, (float)m_height };
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		ScreenTriangle tri;
+		bool crosses_near = false;
+
+		for (int k = 0; k < 3; k++) {
+			auto& clip = clip_positions[indices[i + k]];
+			if (clip.w <= 1e-5f || clip.z < 0.f) {
+				crosses_near = true;
+				break;
+			}
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			tri.v[k] = glm::vec3((glm::vec2(ndc) * 0.5f + 0.5f) * screen_size, ndc.z);
+		}
+
+		if (crosses_near)
+			continue;
+
+		float area = (tri.v[1].x - tri.v[0].x) * (tri.v[2].y - tri.v[0].y) - (tri.v[1].y - tri.v[0].y) * (tri.v[2].x - tri.v[0].x);
+		if (glm::abs(area) < 1e-8f)
+			continue;
+
+		// Both windings are kept so occluders don't need consistent facing, flip to a single orientation for the edge tests
+		if (area < 0.f)
+			std::swap(tri.v[1], tri.v[2]);
+
+		float min_x = glm::min(tri.v[0].x, glm::min(tri.v[1].x, tri.v[2].x));
+		float max_x = glm::max(tri.v[0].x, glm::max(tri.v[1].x, tri.v[2].x));
+		tri.min_y = glm::min(tri.v[0].y, glm::min(tri.v[1].y, tri.v[2].y));
+		tri.max_y = glm::max(tri.v[0].y, glm::max(tri.v[1].y, tri.v[2].y));
+
+		if (max_x < 0.f || min_x >= screen_size.x || tri.max_y < 0.f || tri.min_y >= screen_size.y)
+			continue;
+
+		m_triangles.push_back(tri);
+	}
+}
+
+void OcclusionBuffer::Rasterize() {
+	uint32_t num_bands = (m_height + JOB_ROW_COUNT - 1) / JOB_ROW_COUNT;
+
+	JobSystem::ParallelFor(num_bands, 1, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t band = begin; band < end; band++) {
+			RasterizeRows(band * JOB_ROW_COUNT, glm::min((band + 1) * JOB_ROW_COUNT, m_height));
+		}
+	});
+
+	BuildHiZ();
+}
+
+void OcclusionBuffer::RasterizeRows(uint32_t row_begin, uint32_t row_end) {
+	auto& depth = m_hiz[0];
+
+	for (auto& tri : m_triangles) {
+		// Pixel centers are at +0.5
+		if (tri.max_y < (float)row_begin + 0.5f || tri.min_y > (float)row_end - 0.5f)
+			continue;
+
+		auto& v0 = tri.v[0];
+		auto& v1 = tri.v[1];
+		auto& v2 = tri.v[2];
+
+		// Edge functions in the form w = a * x + b * y + c, positive inside, w_i is the weight of vertex i
+		float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+		float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+		float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+
+		float inv_area = 1.f / (c0 + c1 + c2);
+		float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inv_area;
+		float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inv_area;
+		float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * inv_area;
+
+		uint32_t min_x = (uint32_t)glm::max(glm::min(v0.x, glm::min(v1.x, v2.x)), 0.f) & ~3u;
+		uint32_t max_x = (uint32_t)glm::min(glm::max(v0.x, glm::max(v1.x, v2.x)), (float)m_width - 1.f);
+		uint32_t min_y = glm::max((uint32_t)glm::max(tri.min_y, 0.f), row_begin);
+		uint32_t max_y = glm::min((uint32_t)glm::min(tri.max_y, (float)m_height - 1.f) + 1, row_end);
+
+		for (uint32_t y = min_y; y < max_y; y++) {
+			float py = (float)y + 0.5f;
+			float* p_row = &depth[(size_t)y * m_width];
+
+#ifdef SNK_OCCLUSION_SSE
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)min_x + 0.5f), _mm_setr_ps(0.f, 1.f, 2.f, 3.f));
+			__m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(b0 * py + c0));
+			__m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(b1 * py + c1));
+			__m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(b2 * py + c2));
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zb * py + zc));
+
+			__m128 w0_step = _mm_set1_ps(a0 * 4.f);
+			__m128 w1_step = _mm_set1_ps(a1 * 4.f);
+			__m128 w2_step = _mm_set1_ps(a2 * 4.f);
+			__m128 z_step = _mm_set1_ps(za * 4.f);
+			const __m128 zero = _mm_setzero_ps();
+
+			for (uint32_t x = min_x; x <= max_x; x += 4) {
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+
+				if (_mm_movemask_ps(inside)) {
+					__m128 current = _mm_loadu_ps(p_row + x);
+					__m128 nearest = _mm_min_ps(current, z);
+					_mm_storeu_ps(p_row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+
+				w0 = _mm_add_ps(w0, w0_step);
+				w1 = _mm_add_ps(w1, w1_step);
+				w2 = _mm_add_ps(w2, w2_step);
+				z = _mm_add_ps(z, z_step);
+			}
+#else
+			for (uint32_t x = min_x; x <= max_x; x++) {
+				float px = (float)x + 0.5f;
+				if (a0 * px + b0 * py + c0 >= 0.f && a1 * px + b1 * py + c1 >= 0.f && a2 * px + b2 * py + c2 >= 0.f)
+					p_row[x] = glm::min(p_row[x], za * px + zb * py + zc);
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionBuffer::BuildHiZ() {
+	for (size_t level = 1; level < m_hiz.size(); level++) {
+		auto& src = m_hiz[level - 1];
+		auto& dst = m_hiz[level];
+		glm::uvec2 src_size = m_level_sizes[level - 1];
+		glm::uvec2 dst_size = m_level_sizes[level];
+
+		for (uint32_t y = 0; y < dst_size.y; y++) {
+			uint32_t y0 = y * 2;
+			uint32_t y1 = glm::min(y0 + 1, src_size.y - 1);
+
+			for (uint32_t x = 0; x < dst_size.x; x++) {
+				uint32_t x0 = x * 2;
+				uint32_t x1 = glm::min(x0 + 1, src_size.x - 1);
+
+				dst[y * dst_size.x + x] = glm::max(glm::max(src[y0 * src_size.x + x0], src[y0 * src_size.x + x1]),
+					glm::max(src[y1 * src_size.x + x0], src[y1 * src_size.x + x1]));
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsVisible(const glm::mat4& proj_view, const glm::vec3& center, const glm::vec3& extents) const {
+	glm::vec2 min_ndc{ std::numeric_limits<float>::max() };
+	glm::vec2 max_ndc{ std::numeric_limits<float>::lowest() };
+	float min_z = std::numeric_limits<float>::max();
+
+	for (int i = 0; i < 8; i++) {
+		glm::vec3 corner = center + extents * glm::vec3(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f);
+		glm::vec4 clip = proj_view * glm::vec4(corner, 1.f);
+
+		// Box touches the near plane, can't be tested reliably
+		if (clip.w <= 1e-5f)
+			return true;
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		min_ndc = glm::min(min_ndc, glm::vec2(ndc));
+		max_ndc = glm::max(max_ndc, glm::vec2(ndc));
+		min_z = glm::min(min_z, ndc.z);
+	}
+
+	if (min_z <= 0.f)
+		return true;
+
+	glm::vec2 screen_size{ (float)m_width, (float)m_height };
+	glm::vec2 min_px = (min_ndc * 0.5f + 0.5f) * screen_size;
+	glm::vec2 max_px = (max_ndc * 0.5f + 0.5f) * screen_size;
+
+	// Off screen boxes are left to frustum culling
+	if (max_px.x < 0.f || max_px.y < 0.f || min_px.x >= screen_size.x || min_px.y >= screen_size.y)
+		return true;
+
+	glm::uvec2 min_texel = glm::uvec2(glm::max(min_px, glm::vec2(0.f)));
+	glm::uvec2 max_texel = glm::uvec2(glm::min(max_px, screen_size - 1.f));
+
+	// Pick the first level where the box covers at most 2x2 texels
+	uint32_t level = 0;
+	while (level + 1 < m_hiz.size() && ((max_texel.x >> level) - (min_texel.x >> level) > 1 || (max_texel.y >> level) - (min_texel.y >> level) > 1)) {
+		level++;
+	}
+
+	auto& hiz = m_hiz[level];
+	uint32_t level_width = m_level_sizes[level].x;
+
+	for (uint32_t y = min_texel.y >> level; y <= (max_texel.y >> level); y++) {
+		for (uint32_t x = min_texel.x >> level; x <= (max_texel.x >> level); x++) {
+			if (min_z <= hiz[y * level_width + x])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void OcclusionBuffer::TestVisible(const CullingBoundsSoA& bounds, const glm::mat4& proj_view, const std::vector<uint32_t>& in, std::vector<uint32_t>& out) const {
+	std::vector<uint8_t> visible(in.size());
+
+	JobSystem::ParallelFor((uint32_t)in.size(), FrustumCuller::JOB_CHUNK_SIZE / 4, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			uint32_t idx = in[i];
+			visible[i] = IsVisible(proj_view, { bounds.center_x[idx], bounds.center_y[idx], bounds.center_z[idx] },
+				{ bounds.extent_x[idx], bounds.extent_y[idx], bounds.extent_z[idx] });
+		}
+	});
+
+	out.reserve(out.size() + in.size());
+	for (size_t i = 0; i < in.size(); i++) {
+		if (visible[i])
+			out.push_back(in[i]);
+	}
+}
@@ -73,9 +73,9 @@ void RT::InitDescriptorBuffers(Image2D& output_image, Scene& scene, RaytracingRe
 		.AddDescriptor(1, vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eRaygenKHR) // Output image
 		.AddDescriptor(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex position buffer
 		.AddDescriptor(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex index buffer
-		.AddDescriptor(4, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex normal buffer
-		.AddDescriptor(5, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex tex coord buffer
-		.AddDescriptor(6, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex tangent buffer
+		.AddDescriptor(4, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex normal buffer, or the CompactVertex buffer in compact mode
+		.AddDescriptor(5, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex tex coord buffer, unused in compact mode
+		.AddDescriptor(6, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Vertex tangent buffer, unused in compact mode
 		.AddDescriptor(7, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eAll) // Raytracing instance buffer
 		.AddDescriptor(8, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR)  // Light buffer
 		.AddDescriptor(9, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eRaygenKHR) // Input gbuffer albedo sampler
@@ -103,9 +103,6 @@ void RT::InitDescriptorBuffers(Image2D& output_image, Scene& scene, RaytracingRe
 		auto get_info_image = output_image.CreateDescriptorGetInfo(vk::ImageLayout::eGeneral, vk::DescriptorType::eStorageImage);
 		auto get_info_position_buf = mesh_buffers.position_buf.CreateDescriptorGetInfo();
 		auto get_info_index_buf = mesh_buffers.indices_buf.CreateDescriptorGetInfo();
-		auto get_info_normal_buf = mesh_buffers.normal_buf.CreateDescriptorGetInfo();
-		auto get_info_tex_coord_buf = mesh_buffers.tex_coord_buf.CreateDescriptorGetInfo();
-		auto get_info_tangent_buf = mesh_buffers.tangent_buf.CreateDescriptorGetInfo();
 		auto get_info_instance_buf = scene.GetSystem<RaytracingInstanceBufferSystem>()->GetInstanceStorageBuffer(i).CreateDescriptorGetInfo();
 		auto get_info_emissive_idx_buf = scene.GetSystem<RaytracingInstanceBufferSystem>()->GetEmissiveIdxStorageBuffer(i).CreateDescriptorGetInfo();
 		auto get_info_light_buf = scene.GetSystem<LightBufferSystem>()->light_ssbos[i].CreateDescriptorGetInfo();
@@ -126,9 +123,21 @@ void RT::InitDescriptorBuffers(Image2D& output_image, Scene& scene, RaytracingRe
 		rt_descriptor_buffers[i].LinkResource(&output_image, get_info_image, 1, 0);
 		rt_descriptor_buffers[i].LinkResource(&mesh_buffers.position_buf, get_info_position_buf, 2, 0);
 		rt_descriptor_buffers[i].LinkResource(&mesh_buffers.indices_buf, get_info_index_buf, 3, 0);
-		rt_descriptor_buffers[i].LinkResource(&mesh_buffers.normal_buf, get_info_normal_buf, 4, 0);
-		rt_descriptor_buffers[i].LinkResource(&mesh_buffers.tex_coord_buf, get_info_tex_coord_buf, 5, 0);
-		rt_descriptor_buffers[i].LinkResource(&mesh_buffers.tangent_buf, get_info_tangent_buf, 6, 0);
+
+		// The float streams besides positions aren't created in compact mode, the shaders decode them from the CompactVertex stream
+		if (AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat()) {
+			auto get_info_compact_vertex_buf = mesh_buffers.compact_vertex_buf.CreateDescriptorGetInfo();
+			rt_descriptor_buffers[i].LinkResource(&mesh_buffers.compact_vertex_buf, get_info_compact_vertex_buf, 4, 0);
+		}
+		else {
+			auto get_info_normal_buf = mesh_buffers.normal_buf.CreateDescriptorGetInfo();
+			auto get_info_tex_coord_buf = mesh_buffers.tex_coord_buf.CreateDescriptorGetInfo();
+			auto get_info_tangent_buf = mesh_buffers.tangent_buf.CreateDescriptorGetInfo();
+			rt_descriptor_buffers[i].LinkResource(&mesh_buffers.normal_buf, get_info_normal_buf, 4, 0);
+			rt_descriptor_buffers[i].LinkResource(&mesh_buffers.tex_coord_buf, get_info_tex_coord_buf, 5, 0);
+			rt_descriptor_buffers[i].LinkResource(&mesh_buffers.tangent_buf, get_info_tangent_buf, 6, 0);
+		}
+
 		rt_descriptor_buffers[i].LinkResource(&scene.GetSystem<RaytracingInstanceBufferSystem>()->GetInstanceStorageBuffer(i), get_info_instance_buf, 7, 0);
 		rt_descriptor_buffers[i].LinkResource(&scene.GetSystem<LightBufferSystem>()->light_ssbos[i], get_info_light_buf, 8, 0);
 		rt_descriptor_buffers[i].LinkResource(&output_resources.albedo_image, get_info_albedo_gbuffer_image, 9, 0);
@@ -148,11 +157,13 @@ void RT::InitDescriptorBuffers(Image2D& output_image, Scene& scene, RaytracingRe
 }
 
 void RT::InitPipeline(std::weak_ptr<const DescriptorSetSpec> common_ubo_set) {
+	bool compact_vertices = AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat();
+
 	RtPipelineBuilder pipeline_builder{};
-	pipeline_builder.AddShader(vk::ShaderStageFlagBits::eRaygenKHR, "res/shaders/RayGenrgen_00000000.spv")
+	pipeline_builder.AddShader(vk::ShaderStageFlagBits::eRaygenKHR, compact_vertices ? "res/shaders/RayGenrgen_10000000.spv" : "res/shaders/RayGenrgen_00000000.spv")
 		.AddShader(vk::ShaderStageFlagBits::eMissKHR, "res/shaders/RayMissrmiss_00000000.spv")
 		.AddShader(vk::ShaderStageFlagBits::eMissKHR, "res/shaders/Shadowrmiss_00000000.spv")
-		.AddShader(vk::ShaderStageFlagBits::eClosestHitKHR, "res/shaders/RayClosestHitrchit_00000000.spv")
+		.AddShader(vk::ShaderStageFlagBits::eClosestHitKHR, compact_vertices ? "res/shaders/RayClosestHitrchit_10000000.spv" : "res/shaders/RayClosestHitrchit_00000000.spv")
 		.AddShaderGroup(vk::RayTracingShaderGroupTypeKHR::eGeneral, 0, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR)
 		.AddShaderGroup(vk::RayTracingShaderGroupTypeKHR::eGeneral, 1, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR)
 		.AddShaderGroup(vk::RayTracingShaderGroupTypeKHR::eGeneral, 2, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR)
@@ -0,0 +1,184 @@
+#include "pch/pch.h"
+#include "rendering/UploadBatch.h"
+#include "core/VkCommon.h"
+
+using namespace SNAKE;
+
+UploadBatch::~UploadBatch() {
+	// Staging memory can't be freed while the GPU is still reading it
+	if (m_submitted)
+		Wait();
+}
+
+UploadBatch::StagingLocation UploadBatch::Stage(const void* p_data, vk::DeviceSize size) {
+	// 16 covers the texel block size of every format, buffer image copy offsets must be a multiple of it
+	vk::DeviceSize offset = m_staging_buffers.empty() ? 0 : aligned_size(m_staging_buffers.back().used, 16);
+
+	if (m_staging_buffers.empty() || offset + size > m_staging_buffers.back().size) {
+		vk::DeviceSize buffer_size = std::max({ size, MIN_STAGING_BUFFER_SIZE, m_staging_buffers.empty() ? m_staging_size_hint : m_staging_buffers.back().size * 2 });
+
+		auto& staging = m_staging_buffers.emplace_back();
+		staging.p_buf = std::make_unique<S_VkBuffer>();
+		staging.p_buf->CreateBuffer(buffer_size, vk::BufferUsageFlagBits::eTransferSrc, VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+		staging.p_mapped = reinterpret_cast<std::byte*>(staging.p_buf->Map());
+		staging.size = buffer_size;
+		offset = 0;
+	}
+
+	auto& staging = m_staging_buffers.back();
+	memcpy(staging.p_mapped + offset, p_data, size);
+	staging.used = offset + size;
+	m_staged_size += size;
+
+	return StagingLocation{ staging.p_buf->buffer, offset };
+}
+
+void UploadBatch::AddBufferCopy(vk::Buffer dst, vk::DeviceSize dst_offset, const void* p_data, vk::DeviceSize size) {
+	SNK_ASSERT(!m_submitted);
+	if (size == 0)
+		return;
+
+	auto staged = Stage(p_data, size);
+	m_copies.push_back(Copy{ staged.buffer, dst, vk::BufferCopy{ staged.offset, dst_offset, size } });
+}
+
+void UploadBatch::AddImageCopy(vk::Image dst, uint32_t mip_level, uint32_t width, uint32_t height, const void* p_data, vk::DeviceSize size, vk::ImageLayout final_layout) {
+	SNK_ASSERT(!m_submitted);
+	SNK_ASSERT(std::ranges::all_of(m_image_copies, [&](const ImageCopy& copy) { return copy.dst != dst || copy.final_layout == final_layout; }));
+
+	auto staged = Stage(p_data, size);
+
+	vk::BufferImageCopy region{};
+	region.bufferOffset = staged.offset;
+	region.bufferRowLength = 0; // pixels tightly packed
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+	region.imageSubresource.mipLevel = mip_level;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = vk::Offset3D{ 0, 0, 0 };
+	region.imageExtent = vk::Extent3D{ width, height, 1 };
+
+	m_image_copies.push_back(ImageCopy{ staged.buffer, dst, region, final_layout });
+}
+
+void UploadBatch::RecordCopies(vk::CommandBuffer cmd) {
+	// Copies to the same buffer from the same staging buffer are recorded as one command with multiple regions
+	std::ranges::stable_sort(m_copies, [](const Copy& a, const Copy& b) {
+		return std::pair((VkBuffer)a.dst, (VkBuffer)a.src) < std::pair((VkBuffer)b.dst, (VkBuffer)b.src);
+		});
+
+	std::vector<vk::BufferCopy> regions;
+	for (size_t i = 0; i < m_copies.size();) {
+		regions.clear();
+		vk::Buffer dst = m_copies[i].dst;
+		vk::Buffer src = m_copies[i].src;
+		for (; i < m_copies.size() && m_copies[i].dst == dst && m_copies[i].src == src; i++) {
+			regions.push_back(m_copies[i].region);
+		}
+
+		cmd.copyBuffer(src, dst, regions);
+	}
+
+	if (m_image_copies.empty())
+		return;
+
+	std::ranges::stable_sort(m_image_copies, [](const ImageCopy& a, const ImageCopy& b) {
+		return std::pair((VkImage)a.dst, (VkBuffer)a.src) < std::pair((VkImage)b.dst, (VkBuffer)b.src);
+		});
+
+	std::vector<vk::ImageMemoryBarrier> to_transfer_dst;
+	for (size_t i = 0; i < m_image_copies.size(); i++) {
+		if (i > 0 && m_image_copies[i].dst == m_image_copies[i - 1].dst)
+			continue;
+
+		auto& barrier = to_transfer_dst.emplace_back();
+		barrier.oldLayout = vk::ImageLayout::eUndefined;
+		barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+		barrier.srcQueueFamilyIndex = vk::QueueFamilyIgnored;
+		barrier.dstQueueFamilyIndex = vk::QueueFamilyIgnored;
+		barrier.image = m_image_copies[i].dst;
+		barrier.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, vk::RemainingMipLevels, 0, 1 };
+		barrier.srcAccessMask = vk::AccessFlagBits::eNone;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+	}
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, to_transfer_dst);
+
+	std::vector<vk::BufferImageCopy> image_regions;
+	for (size_t i = 0; i < m_image_copies.size();) {
+		image_regions.clear();
+		vk::Image dst = m_image_copies[i].dst;
+		vk::Buffer src = m_image_copies[i].src;
+		for (; i < m_image_copies.size() && m_image_copies[i].dst == dst && m_image_copies[i].src == src; i++) {
+			image_regions.push_back(m_image_copies[i].region);
+		}
+
+		cmd.copyBufferToImage(src, dst, vk::ImageLayout::eTransferDstOptimal, image_regions);
+	}
+
+	RecordImageFinalBarriers(cmd, false);
+}
+
+void UploadBatch::RecordImageFinalBarriers(vk::CommandBuffer cmd, bool acquire) {
+	auto& device = VkContext::GetLogicalDevice();
+	bool ownership_transfer = device.HasDedicatedTransferQueue();
+
+	std::vector<vk::ImageMemoryBarrier> barriers;
+	for (size_t i = 0; i < m_image_copies.size(); i++) {
+		if (i > 0 && m_image_copies[i].dst == m_image_copies[i - 1].dst)
+			continue;
+
+		// Both halves of an ownership transfer must specify the same layouts and queue families
+		auto& barrier = barriers.emplace_back();
+		barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+		barrier.newLayout = m_image_copies[i].final_layout;
+		barrier.srcQueueFamilyIndex = ownership_transfer ? device.GetTransferFamily() : vk::QueueFamilyIgnored;
+		barrier.dstQueueFamilyIndex = ownership_transfer ? device.GetGraphicsFamily() : vk::QueueFamilyIgnored;
+		barrier.image = m_image_copies[i].dst;
+		barrier.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, vk::RemainingMipLevels, 0, 1 };
+		barrier.srcAccessMask = acquire ? vk::AccessFlagBits::eNone : vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = (ownership_transfer && !acquire) ? vk::AccessFlagBits::eNone : vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+	}
+
+	if (!ownership_transfer)
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, barriers);
+	else if (acquire)
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, barriers);
+	else
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, barriers);
+}
+
+void UploadBatch::Submit() {
+	SNK_ASSERT(!m_submitted);
+	if (IsEmpty())
+		return;
+
+	// Sequential write memory isn't always host coherent
+	for (auto& staging : m_staging_buffers) {
+		SNK_CHECK_VK_RESULT(vmaFlushAllocation(VkContext::GetAllocator(), staging.p_buf->allocation, 0, staging.used));
+		staging.p_buf->Unmap();
+		staging.p_mapped = nullptr;
+	}
+
+	m_ticket = UploadEngine::Get().Submit(
+		[this](vk::CommandBuffer cmd) { RecordCopies(cmd); },
+		[this](vk::CommandBuffer cmd) { if (!m_image_copies.empty()) RecordImageFinalBarriers(cmd, true); }
+	);
+
+	m_submitted = true;
+}
+
+bool UploadBatch::IsComplete() const {
+	if (!m_submitted)
+		return IsEmpty();
+
+	return UploadEngine::Get().IsComplete(m_ticket);
+}
+
+void UploadBatch::Wait() const {
+	if (!m_submitted)
+		return;
+
+	UploadEngine::Get().Wait(m_ticket);
+}
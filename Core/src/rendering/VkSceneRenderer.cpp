@@ -11,7 +11,7 @@ using namespace SNAKE;
 void VkSceneRenderer::Init(Scene* p_scene) {
 	mp_scene = p_scene;
 
-	m_shadow_pass.Init();
+	m_shadow_pass.Init(*p_scene);
 	m_forward_pass.Init();
 }
 
@@ -7,6 +7,7 @@
 #include "scene/SceneInfoBufferSystem.h"
 #include "scene/TransformBufferSystem.h"
 #include "scene/SceneSnapshotSystem.h"
+#include "scene/CullingSystem.h"
 
 namespace SNAKE {
 
@@ -19,17 +20,29 @@ namespace SNAKE {
 		// Create graphics pipeline
 		auto binding_desc = Vertex::GetBindingDescription();
 		auto attribute_desc = Vertex::GetAttributeDescriptions();
+		auto compact_attribute_desc = CompactVertex::GetAttributeDescriptions(1);
+		bool compact_vertices = AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat();
 
 		GraphicsPipelineBuilder graphics_builder{};
-		graphics_builder.AddShader(vk::ShaderStageFlagBits::eVertex, "res/shaders/Forwardvert_00000000.spv")
+		graphics_builder.AddShader(vk::ShaderStageFlagBits::eVertex, compact_vertices ? "res/shaders/Forwardvert_10000000.spv" : "res/shaders/Forwardvert_00000000.spv")
 			.AddShader(vk::ShaderStageFlagBits::eFragment, "res/shaders/Forwardfrag_00000000.spv")
 			.AddVertexBinding(attribute_desc[0], binding_desc[0])
-			.AddVertexBinding(attribute_desc[1], binding_desc[1])
-			.AddVertexBinding(attribute_desc[2], binding_desc[2])
-			.AddVertexBinding(attribute_desc[3], binding_desc[3])
 			.AddColourAttachment(vk::Format::eR8G8B8A8Srgb)
-			.AddDepthAttachment(FindDepthFormat())
-			.Build();
+			.AddDepthAttachment(FindDepthFormat());
+
+		// In compact mode everything but the position is read from the CompactVertex stream bound after the positions
+		if (compact_vertices) {
+			graphics_builder.AddVertexBinding(compact_attribute_desc[1], CompactVertex::GetBindingDescription(1))
+				.AddVertexAttribute(compact_attribute_desc[2])
+				.AddVertexAttribute(compact_attribute_desc[3]);
+		}
+		else {
+			graphics_builder.AddVertexBinding(attribute_desc[1], binding_desc[1])
+				.AddVertexBinding(attribute_desc[2], binding_desc[2])
+				.AddVertexBinding(attribute_desc[3], binding_desc[3]);
+		}
+
+		graphics_builder.Build();
 
 		m_graphics_pipeline.Init(graphics_builder);
 	}
@@ -109,26 +122,45 @@ namespace SNAKE {
 		auto& asset_manager = AssetManager::Get();
 		auto buffers = asset_manager.mesh_buffer_manager.GetMeshBuffers();
 
-		std::vector<vk::Buffer> vert_buffers = { buffers.position_buf.buffer, buffers.normal_buf.buffer, buffers.tex_coord_buf.buffer, buffers.tangent_buf.buffer };
+		bool compact_vertices = asset_manager.mesh_buffer_manager.UsesCompactVertexFormat();
+		std::vector<vk::Buffer> vert_buffers = compact_vertices ? std::vector<vk::Buffer>{ buffers.position_buf.buffer, buffers.compact_vertex_buf.buffer } :
+			std::vector<vk::Buffer>{ buffers.position_buf.buffer, buffers.normal_buf.buffer, buffers.tex_coord_buf.buffer, buffers.tangent_buf.buffer };
 		std::vector<vk::Buffer> index_buffers = { buffers.indices_buf.buffer };
 
-		for (auto& range : snapshot.mesh_ranges) {
-			auto mesh_asset = AssetManager::GetAssetRaw<StaticMeshAsset>(range.mesh_uuid);
+		auto* p_culling_system = scene.GetSystem<CullingSystem>();
+		const auto& draw_items = p_culling_system->GetDrawItems();
+		const auto& visible = p_culling_system->GetVisibleList(CullingSystem::CullView::CAMERA);
+
+		for (size_t r = 0; r < snapshot.mesh_ranges.size(); r++) {
+			auto& range = snapshot.mesh_ranges[r];
+			if (visible.range_starts[r] == visible.range_starts[r + 1])
+				continue;
+
+			auto mesh_asset = AssetManager::Resolve(range.mesh);
 			auto& mesh_buffer_entry_data = asset_manager.mesh_buffer_manager.GetEntryData(mesh_asset->data.get());
 
-			std::vector<vk::DeviceSize> offsets = { mesh_buffer_entry_data.data_start_vertex_idx, mesh_buffer_entry_data.data_start_vertex_idx, 
-				mesh_buffer_entry_data.data_start_vertex_idx, mesh_buffer_entry_data.data_start_vertex_idx };
+			vk::DeviceSize vertex_idx = mesh_buffer_entry_data.data_start_vertex_idx;
+			std::vector<vk::DeviceSize> offsets = compact_vertices ? std::vector<vk::DeviceSize>{ vertex_idx * sizeof(glm::vec3), vertex_idx * sizeof(CompactVertex) } :
+				std::vector<vk::DeviceSize>{ vertex_idx * sizeof(glm::vec3), vertex_idx * sizeof(glm::vec3), vertex_idx * sizeof(glm::vec2), vertex_idx * sizeof(glm::vec3) };
 
-			cmd_buffer.bindVertexBuffers(0, 4, vert_buffers.data(), offsets.data());
-			cmd_buffer.bindIndexBuffer(index_buffers[0], mesh_buffer_entry_data.data_start_indices_idx, vk::IndexType::eUint32);
+			cmd_buffer.bindVertexBuffers(0, (uint32_t)vert_buffers.size(), vert_buffers.data(), offsets.data());
+			cmd_buffer.bindIndexBuffer(index_buffers[0], mesh_buffer_entry_data.data_start_indices_idx * sizeof(uint32_t), vk::IndexType::eUint32);
 
-			for (uint32_t i = range.start_idx; i < range.start_idx + range.count; i++) {
-				cmd_buffer.pushConstants(m_graphics_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAllGraphics, 0, sizeof(uint32_t), &i);
-				for (auto& submesh : mesh_asset->data->submeshes) {
-					uint32_t mat_index = (snapshot.static_mesh_data[i].material_vec)[submesh.material_index]->GetGlobalBufferIndex();
-					cmd_buffer.pushConstants(m_graphics_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAllGraphics, sizeof(uint32_t), sizeof(uint32_t), &mat_index);
-					cmd_buffer.drawIndexed(submesh.num_indices, 1, submesh.base_index, submesh.base_vertex, 0);
+			uint32_t current_instance = std::numeric_limits<uint32_t>::max();
+			for (uint32_t i = visible.range_starts[r]; i < visible.range_starts[r + 1]; i++) {
+				auto& item = draw_items[visible.items[i]];
+
+				// Forward.vert indexes the transform buffer, not the snapshot's instances
+				if (item.instance_idx != current_instance) {
+					current_instance = item.instance_idx;
+					uint32_t transform_idx = snapshot.static_mesh_data[item.instance_idx].transform_buffer_idx;
+					cmd_buffer.pushConstants(m_graphics_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAllGraphics, 0, sizeof(uint32_t), &transform_idx);
 				}
+
+				auto& submesh = mesh_asset->data->submeshes[item.submesh_idx];
+				uint32_t mat_index = snapshot.GetMaterialIdx(range, submesh.material_index);
+				cmd_buffer.pushConstants(m_graphics_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAllGraphics, sizeof(uint32_t), sizeof(uint32_t), &mat_index);
+				cmd_buffer.drawIndexed(submesh.num_indices, 1, submesh.base_index, submesh.base_vertex, 0);
 			}
 		}
 		
@@ -3,6 +3,7 @@
 #include "scene/SceneInfoBufferSystem.h"
 #include "scene/TransformBufferSystem.h"
 #include "scene/SceneSnapshotSystem.h"
+#include "scene/CullingSystem.h"
 #include "scene/ParticleSystem.h"
 
 using namespace SNAKE;
@@ -10,23 +11,38 @@ using namespace SNAKE;
 void GBufferPass::Init(Scene& scene, GBufferResources& output) {
 	auto binding_desc = Vertex::GetBindingDescription();
 	auto attribute_desc = Vertex::GetAttributeDescriptions();
+	auto compact_attribute_descs = CompactVertex::GetAttributeDescriptions();
+	bool compact_vertices = AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat();
 
 	GraphicsPipelineBuilder gp_builder_mesh{};
 	GraphicsPipelineBuilder gp_builder_ptcl{};
 
+	// Vertex inputs of the format MeshBufferManager stores, the compact one is read from the CompactVertex stream alone
+	auto add_vertex_inputs = [&](GraphicsPipelineBuilder& builder) {
+		if (compact_vertices) {
+			builder.AddVertexBinding(compact_attribute_descs[0], CompactVertex::GetBindingDescription())
+				.AddVertexAttribute(compact_attribute_descs[1])
+				.AddVertexAttribute(compact_attribute_descs[2])
+				.AddVertexAttribute(compact_attribute_descs[3]);
+		}
+		else {
+			builder.AddVertexBinding(attribute_desc[0], binding_desc[0])
+				.AddVertexBinding(attribute_desc[1], binding_desc[1])
+				.AddVertexBinding(attribute_desc[2], binding_desc[2])
+				.AddVertexBinding(attribute_desc[3], binding_desc[3]);
+		}
+	};
+
 	gp_builder_mesh.AddColourAttachment(output.albedo_image.GetSpec().format)
 		.AddColourAttachment(output.normal_image.GetSpec().format)
 		.AddColourAttachment(output.rma_image.GetSpec().format)
 		.AddColourAttachment(output.pixel_motion_image.GetSpec().format)
 		.AddColourAttachment(output.mat_flag_image.GetSpec().format)
 		.AddDepthAttachment(output.depth_image.GetSpec().format)
-		.AddShader(vk::ShaderStageFlagBits::eVertex, "res/shaders/GBuffervert_10000000.spv")
-		.AddShader(vk::ShaderStageFlagBits::eFragment, "res/shaders/GBufferfrag_10000000.spv")
-		.AddVertexBinding(attribute_desc[0], binding_desc[0])
-		.AddVertexBinding(attribute_desc[1], binding_desc[1])
-		.AddVertexBinding(attribute_desc[2], binding_desc[2])
-		.AddVertexBinding(attribute_desc[3], binding_desc[3])
-		.Build();
+		.AddShader(vk::ShaderStageFlagBits::eVertex, compact_vertices ? "res/shaders/GBuffervert_10100000.spv" : "res/shaders/GBuffervert_10000000.spv")
+		.AddShader(vk::ShaderStageFlagBits::eFragment, "res/shaders/GBufferfrag_10000000.spv");
+	add_vertex_inputs(gp_builder_mesh);
+	gp_builder_mesh.Build();
 
 	gp_builder_ptcl.AddColourAttachment(output.albedo_image.GetSpec().format)
 		.AddColourAttachment(output.normal_image.GetSpec().format)
@@ -34,16 +50,14 @@ void GBufferPass::Init(Scene& scene, GBufferResources& output) {
 		.AddColourAttachment(output.pixel_motion_image.GetSpec().format)
 		.AddColourAttachment(output.mat_flag_image.GetSpec().format)
 		.AddDepthAttachment(output.depth_image.GetSpec().format)
-		.AddShader(vk::ShaderStageFlagBits::eVertex, "res/shaders/GBuffervert_01000000.spv")
-		.AddShader(vk::ShaderStageFlagBits::eFragment, "res/shaders/GBufferfrag_01000000.spv")
-		.AddVertexBinding(attribute_desc[0], binding_desc[0])
-		.AddVertexBinding(attribute_desc[1], binding_desc[1])
-		.AddVertexBinding(attribute_desc[2], binding_desc[2])
-		.AddVertexBinding(attribute_desc[3], binding_desc[3])
-		.Build();
+		.AddShader(vk::ShaderStageFlagBits::eVertex, compact_vertices ? "res/shaders/GBuffervert_01100000.spv" : "res/shaders/GBuffervert_01000000.spv")
+		.AddShader(vk::ShaderStageFlagBits::eFragment, "res/shaders/GBufferfrag_01000000.spv");
+	add_vertex_inputs(gp_builder_ptcl);
+	gp_builder_ptcl.Build();
 
 	m_mesh_pipeline.Init(gp_builder_mesh);
 	m_particle_pipeline.Init(gp_builder_ptcl);
+	m_draw_buffers.Init();
 
 	for (FrameInFlightIndex i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		m_descriptor_buffers[i].SetDescriptorSpec(m_mesh_pipeline.pipeline_layout.GetDescriptorSetLayout(2));
@@ -63,6 +77,12 @@ void GBufferPass::Init(Scene& scene, GBufferResources& output) {
 		m_descriptor_buffers[i].LinkResource(&p_transform_system->GetLastFramesTransformStorageBuffer(i), prev_frame_transform_get_info, 1, 0);
 		m_descriptor_buffers[i].LinkResource(&ptcl_buf, ptcl_buf_get_info, 2, 0);
 		m_descriptor_buffers[i].LinkResource(&ptcl_buf_prev_frame, ptcl_buf_prev_frame_get_info, 3, 0);
+
+		auto instance_buf_get_info = m_draw_buffers.GetInstanceBuffer(i).CreateDescriptorGetInfo();
+		m_descriptor_buffers[i].LinkResource(&m_draw_buffers.GetInstanceBuffer(i), instance_buf_get_info, 4, 0);
+
+		auto& quantisation_buf = AssetManager::Get().mesh_buffer_manager.GetMeshBuffers().quantisation_buf;
+		m_descriptor_buffers[i].LinkResource(&quantisation_buf, quantisation_buf.CreateDescriptorGetInfo(), 5, 0);
 	}
 }
 
@@ -98,6 +118,9 @@ void GBufferPass::RecordCommandBuffer(GBufferResources& output, Scene& scene, gl
 		render_info
 	);
 
+	auto& asset_manager = AssetManager::Get();
+	bool compact_vertices = asset_manager.mesh_buffer_manager.UsesCompactVertexFormat();
+
 	// Binds shaders and sets all state like rasterizer, blend, multisampling etc
 	cmd_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_mesh_pipeline.GetPipeline());
 
@@ -124,7 +147,6 @@ void GBufferPass::RecordCommandBuffer(GBufferResources& output, Scene& scene, gl
 
 	cmd_buffer.setDescriptorBufferOffsetsEXT(vk::PipelineBindPoint::eGraphics, m_mesh_pipeline.pipeline_layout.GetPipelineLayout(), 0, buffer_indices, buffer_offsets);
 
-	auto& asset_manager = AssetManager::Get();
 	auto buffers = asset_manager.mesh_buffer_manager.GetMeshBuffers();
 
 	std::vector<vk::Buffer> vert_buffers = { buffers.position_buf.buffer, buffers.normal_buf.buffer, buffers.tex_coord_buf.buffer, buffers.tangent_buf.buffer };
@@ -139,32 +161,25 @@ void GBufferPass::RecordCommandBuffer(GBufferResources& output, Scene& scene, gl
 	}
 
 	const auto& snapshot = scene.GetSystem<SceneSnapshotSystem>()->GetSnapshotData();
-	// Draw all meshes in scene snapshot data
-	for (auto& range : snapshot.mesh_ranges) {
-		auto mesh_asset = AssetManager::GetAssetRaw<StaticMeshAsset>(range.mesh_uuid);
-		auto& mesh_buffer_entry_data = asset_manager.mesh_buffer_manager.GetEntryData(mesh_asset->data.get());
-
-		std::vector<vk::DeviceSize> offsets = {
-			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3),
-			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3),
-			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec2),
-			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3)
-		};
-
-		cmd_buffer.bindVertexBuffers(0, 4, vert_buffers.data(), offsets.data());
-		cmd_buffer.bindIndexBuffer(index_buffers[0], mesh_buffer_entry_data.data_start_indices_idx * sizeof(uint32_t), vk::IndexType::eUint32);
-
-
-		for (uint32_t i = range.start_idx; i < range.start_idx + range.count; i++) {
-			pc.transform_idx = snapshot.static_mesh_data[i].transform_buffer_idx;
-			cmd_buffer.pushConstants(m_mesh_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAll, 0, sizeof(uint32_t), &pc.transform_idx);
-
-			for (auto& submesh : mesh_asset->data->submeshes) {
-				pc.material_idx = (snapshot.static_mesh_data[i].material_vec)[submesh.material_index]->GetGlobalBufferIndex();
-				cmd_buffer.pushConstants(m_mesh_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAll, sizeof(uint32_t), sizeof(uint32_t), &pc.material_idx);
-				cmd_buffer.drawIndexed(submesh.num_indices, 1, submesh.base_index, submesh.base_vertex, 0);
-			}
-		}
+	auto* p_culling_system = scene.GetSystem<CullingSystem>();
+	const auto& draw_items = p_culling_system->GetDrawItems();
+	const auto& visible = p_culling_system->GetVisibleList(CullingSystem::CullView::CAMERA);
+
+	// Draw all meshes in scene snapshot data that survived culling, transform/material indices are read from the instance buffer
+	IndirectDrawBuffers::ResolveMeshSources(snapshot, visible, m_mesh_sources);
+	m_draw_builder.Reset();
+	m_draw_builder.AddVisibleItems(snapshot, m_mesh_sources, draw_items, visible);
+	m_draw_buffers.Upload(m_draw_builder, frame_idx);
+
+	if (uint32_t draw_count = m_draw_buffers.GetDrawCount(frame_idx)) {
+		std::array<vk::DeviceSize, 4> offsets = { 0, 0, 0, 0 };
+		if (compact_vertices)
+			cmd_buffer.bindVertexBuffers(0, 1, &buffers.compact_vertex_buf.buffer, offsets.data());
+		else
+			cmd_buffer.bindVertexBuffers(0, 4, vert_buffers.data(), offsets.data());
+
+		cmd_buffer.bindIndexBuffer(index_buffers[0], 0, vk::IndexType::eUint32);
+		cmd_buffer.drawIndexedIndirect(m_draw_buffers.GetCommandBuffer(frame_idx).buffer, 0, draw_count, sizeof(vk::DrawIndexedIndirectCommand));
 	}
 
 	// Particles
@@ -174,15 +189,24 @@ void GBufferPass::RecordCommandBuffer(GBufferResources& output, Scene& scene, gl
 	auto& ptcl_mesh = AssetManager::GetAsset<StaticMeshAsset>(AssetManager::CoreAssetIDs::CUBE_MESH).get()->data;
 	auto& mesh_buffer_entry_data = asset_manager.mesh_buffer_manager.GetEntryData(ptcl_mesh.get());
 
-	std::vector<vk::DeviceSize> offsets = {
-		mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3),
-		mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3),
-		mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec2),
-		mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3)
-	};
+	if (compact_vertices) {
+		vk::DeviceSize offset = mesh_buffer_entry_data.data_start_vertex_idx * sizeof(CompactVertex);
+		pc.quantisation_idx = mesh_buffer_entry_data.quantisation_start_idx;
+		cmd_buffer.bindVertexBuffers(0, 1, &buffers.compact_vertex_buf.buffer, &offset);
+		cmd_buffer.pushConstants(m_particle_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAll, 0, sizeof(uint32_t), &pc.quantisation_idx);
+	}
+	else {
+		std::vector<vk::DeviceSize> offsets = {
+			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3),
+			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3),
+			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec2),
+			mesh_buffer_entry_data.data_start_vertex_idx * sizeof(glm::vec3)
+		};
+		cmd_buffer.bindVertexBuffers(0, 4, vert_buffers.data(), offsets.data());
+	}
 
-	//pc.material_idx = AssetManager::GetAsset<MaterialAsset>(AssetManager::CoreAssetIDs::MATERIAL)->GetGlobalBufferIndex();
-	cmd_buffer.bindVertexBuffers(0, 4, vert_buffers.data(), offsets.data());
+	// Previously this inherited the last mesh draw's material, meshes no longer push one
+	pc.material_idx = AssetManager::GetAsset<MaterialAsset>(AssetManager::CoreAssetIDs::MATERIAL)->GetGlobalBufferIndex();
 	cmd_buffer.bindIndexBuffer(index_buffers[0], mesh_buffer_entry_data.data_start_indices_idx * sizeof(uint32_t), vk::IndexType::eUint32);
 	cmd_buffer.pushConstants(m_particle_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAll, sizeof(uint32_t), sizeof(uint32_t), &pc.material_idx);
 	cmd_buffer.pushConstants(m_particle_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAll, sizeof(uint32_t) * 2, sizeof(uint32_t) * 2, &pc.render_resolution);
@@ -5,9 +5,10 @@
 #include "scene/LightBufferSystem.h"
 #include "scene/TransformBufferSystem.h"
 #include "scene/SceneSnapshotSystem.h"
+#include "scene/CullingSystem.h"
 
 namespace SNAKE {
-	void ShadowPass::Init() {
+	void ShadowPass::Init(Scene& scene) {
 		Image2DSpec shadow_spec;
 		shadow_spec.size = { 4096, 4096 };
 		shadow_spec.format = vk::Format::eD16Unorm;
@@ -28,17 +29,39 @@ namespace SNAKE {
 
 		auto vert_binding_descs = Vertex::GetBindingDescription();
 		auto vert_attr_descs = Vertex::GetAttributeDescriptions();
+		auto compact_attr_descs = CompactVertex::GetAttributeDescriptions(1);
+		bool compact_vertices = AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat();
 
+		// Positions and normals, in compact mode normals are read from the CompactVertex stream bound after the positions
 		GraphicsPipelineBuilder builder{};
 		builder.AddDepthAttachment(vk::Format::eD16Unorm)
-			.AddShader(vk::ShaderStageFlagBits::eVertex, "res/shaders/Depthvert_00000000.spv")
+			.AddShader(vk::ShaderStageFlagBits::eVertex, compact_vertices ? "res/shaders/Depthvert_10000000.spv" : "res/shaders/Depthvert_00000000.spv")
 			.AddShader(vk::ShaderStageFlagBits::eFragment, "res/shaders/Depthfrag_00000000.spv")
-			.AddVertexBinding(vert_attr_descs[0], vert_binding_descs[0])
-			.AddVertexBinding(vert_attr_descs[1], vert_binding_descs[1])
-			.AddVertexBinding(vert_attr_descs[2], vert_binding_descs[2])
-			.Build();
+			.AddVertexBinding(vert_attr_descs[0], vert_binding_descs[0]);
+
+		if (compact_vertices)
+			builder.AddVertexBinding(compact_attr_descs[1], CompactVertex::GetBindingDescription(1));
+		else
+			builder.AddVertexBinding(vert_attr_descs[1], vert_binding_descs[1]);
+
+		builder.Build();
 
 		m_pipeline.Init(builder);
+		m_draw_buffers.Init();
+
+		auto* p_transform_system = scene.GetSystem<TransformBufferSystem>();
+		for (FrameInFlightIndex i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			m_descriptor_buffers[i].SetDescriptorSpec(m_pipeline.pipeline_layout.GetDescriptorSetLayout(0));
+			m_descriptor_buffers[i].CreateBuffer(1);
+
+			auto transform_get_info = p_transform_system->GetTransformStorageBuffer(i).CreateDescriptorGetInfo();
+			auto prev_frame_transform_get_info = p_transform_system->GetLastFramesTransformStorageBuffer(i).CreateDescriptorGetInfo();
+			auto instance_buf_get_info = m_draw_buffers.GetInstanceBuffer(i).CreateDescriptorGetInfo();
+
+			m_descriptor_buffers[i].LinkResource(&p_transform_system->GetTransformStorageBuffer(i), transform_get_info, 0, 0);
+			m_descriptor_buffers[i].LinkResource(&p_transform_system->GetLastFramesTransformStorageBuffer(i), prev_frame_transform_get_info, 1, 0);
+			m_descriptor_buffers[i].LinkResource(&m_draw_buffers.GetInstanceBuffer(i), instance_buf_get_info, 2, 0);
+		}
 
 		for (auto& buf : m_cmd_buffers) {
 			buf.Init(vk::CommandBufferLevel::ePrimary);
@@ -92,44 +115,39 @@ namespace SNAKE {
 		scissor.extent = vk::Extent2D(4096, 4096);
 		cmd.setScissor(0, 1, &scissor);
 
-		vk::DescriptorBufferBindingInfoEXT light_buffer_binding_info{};
-		light_buffer_binding_info.address = scene.GetSystem<LightBufferSystem>()->light_descriptor_buffers[frame_idx].descriptor_buffer.GetDeviceAddress();
-		light_buffer_binding_info.usage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT;
-
-		vk::DescriptorBufferBindingInfoEXT transform_binding_info{};
-		transform_binding_info.address = scene.GetSystem<TransformBufferSystem>()->GetTransformStorageBuffer(VkContext::GetCurrentFIF()).GetDeviceAddress();
-		transform_binding_info.usage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT;
-
-		auto binding_infos = util::array(transform_binding_info, light_buffer_binding_info);
-
-		cmd.bindDescriptorBuffersEXT(light_buffer_binding_info);
-		std::array<uint32_t, 2> buffer_indices = { 0, 1 };
-		std::array<vk::DeviceSize, 2> buffer_offsets = { 0, 0 };
-
-		cmd.setDescriptorBufferOffsetsEXT(vk::PipelineBindPoint::eGraphics, m_pipeline.pipeline_layout.GetPipelineLayout(), (uint32_t)DescriptorSetIndices::LIGHTS, buffer_indices, buffer_offsets);
-		
 		auto& asset_manager = AssetManager::Get();
 		auto buffers = asset_manager.mesh_buffer_manager.GetMeshBuffers();
 
-		std::vector<vk::Buffer> vert_buffers = { buffers.position_buf.buffer, buffers.normal_buf.buffer, buffers.tex_coord_buf.buffer, buffers.tangent_buf.buffer };
+		auto normal_source = asset_manager.mesh_buffer_manager.UsesCompactVertexFormat() ? buffers.compact_vertex_buf.buffer : buffers.normal_buf.buffer;
+		std::vector<vk::Buffer> vert_buffers = { buffers.position_buf.buffer, normal_source };
 		std::vector<vk::Buffer> index_buffers = { buffers.indices_buf.buffer };
 
-		for (auto& range : snapshot.mesh_ranges) {
-			auto mesh_asset = AssetManager::GetAsset<StaticMeshAsset>(range.mesh_uuid);
-			auto& mesh_buffer_entry_data = asset_manager.mesh_buffer_manager.GetEntryData(mesh_asset->data.get());
+		auto* p_culling_system = scene.GetSystem<CullingSystem>();
+		const auto& visible = p_culling_system->GetVisibleList(CullingSystem::CullView::DIR_LIGHT);
+		IndirectDrawBuffers::ResolveMeshSources(snapshot, visible, m_mesh_sources);
+		m_draw_builder.Reset();
+		m_draw_builder.AddVisibleItems(snapshot, m_mesh_sources, p_culling_system->GetDrawItems(), visible);
+		m_draw_buffers.Upload(m_draw_builder, frame_idx);
+
+		auto binding_infos = util::array(
+			scene.GetSystem<LightBufferSystem>()->light_descriptor_buffers[frame_idx].GetBindingInfo(),
+			m_descriptor_buffers[frame_idx].GetBindingInfo()
+		);
 
-			std::vector<vk::DeviceSize> offsets = { mesh_buffer_entry_data.data_start_vertex_idx, mesh_buffer_entry_data.data_start_vertex_idx,
-				mesh_buffer_entry_data.data_start_vertex_idx, mesh_buffer_entry_data.data_start_vertex_idx };
+		cmd.bindDescriptorBuffersEXT(binding_infos);
 
-			cmd.bindVertexBuffers(0, 3, vert_buffers.data(), offsets.data());
-			cmd.bindIndexBuffer(index_buffers[0], mesh_buffer_entry_data.data_start_indices_idx, vk::IndexType::eUint32);
+		// Set 0 = transforms + instance data, set 2 = lights
+		uint32_t instance_buffer_idx = 1;
+		uint32_t light_buffer_idx = 0;
+		vk::DeviceSize offset = 0;
+		cmd.setDescriptorBufferOffsetsEXT(vk::PipelineBindPoint::eGraphics, m_pipeline.pipeline_layout.GetPipelineLayout(), 0, 1, &instance_buffer_idx, &offset);
+		cmd.setDescriptorBufferOffsetsEXT(vk::PipelineBindPoint::eGraphics, m_pipeline.pipeline_layout.GetPipelineLayout(), (uint32_t)DescriptorSetIndices::LIGHTS, 1, &light_buffer_idx, &offset);
 
-			for (uint32_t i = range.start_idx; i < range.start_idx + range.count; i++) {
-				cmd.pushConstants(m_pipeline.pipeline_layout.GetPipelineLayout(), vk::ShaderStageFlagBits::eAllGraphics, 0, sizeof(unsigned), &i);
-				for (auto& submesh : mesh_asset->data->submeshes) {
-					cmd.drawIndexed(submesh.num_indices, 1, submesh.base_index, submesh.base_vertex, 0);
-				}
-			}
+		if (uint32_t draw_count = m_draw_buffers.GetDrawCount(frame_idx)) {
+			std::array<vk::DeviceSize, 2> offsets = { 0, 0 };
+			cmd.bindVertexBuffers(0, 2, vert_buffers.data(), offsets.data());
+			cmd.bindIndexBuffer(index_buffers[0], 0, vk::IndexType::eUint32);
+			cmd.drawIndexedIndirect(m_draw_buffers.GetCommandBuffer(frame_idx).buffer, 0, draw_count, sizeof(vk::DrawIndexedIndirectCommand));
 		}
 	
 		cmd.endRenderingKHR();
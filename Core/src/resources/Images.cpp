@@ -120,12 +120,21 @@ void Image2D::CreateImage(VmaAllocationCreateFlags flags) {
 	DispatchResourceEvent(S_VkResourceEvent::ResourceEventType::CREATE);
 }
 
-void Image2D::GenerateMipmaps(vk::ImageLayout start_layout) {
-	auto cmd = BeginSingleTimeCommands();
+void Image2D::GenerateMipmaps(vk::ImageLayout start_layout, vk::CommandBuffer buf) {
+	bool temporary_buf = !buf;
+	vk::UniqueCommandBuffer temp_handle;
+
+	if (temporary_buf) {
+		temp_handle = BeginSingleTimeCommands();
+		buf = *temp_handle;
+	}
+
 	for (uint32_t i = 1; i < m_spec.mip_levels; i++) {
-		BlitTo(*this, i, i - 1, start_layout, start_layout, start_layout, start_layout, vk::Filter::eLinear, std::nullopt, *cmd);
+		BlitTo(*this, i, i - 1, start_layout, start_layout, start_layout, start_layout, vk::Filter::eLinear, std::nullopt, buf);
 	}
-	EndSingleTimeCommands(*cmd);
+
+	if (temporary_buf)
+		EndSingleTimeCommands(buf);
 }
 
 void Image2D::DestroyImage() {
@@ -143,6 +152,15 @@ void Image2D::DestroyImage() {
 	DispatchResourceEvent(S_VkResourceEvent::ResourceEventType::DELETE);
 }
 
+void Image2D::Swap(Image2D& other) {
+	SNK_ASSERT(m_owns_image && other.m_owns_image);
+	std::swap(m_spec, other.m_spec);
+	std::swap(m_image, other.m_image);
+	std::swap(m_allocation, other.m_allocation);
+	std::swap(m_view, other.m_view);
+	std::swap(m_sampler, other.m_sampler);
+}
+
 void Image2D::RefreshDescriptorGetInfo(DescriptorGetInfo& info) const {
 	auto& image_info = std::get<vk::DescriptorImageInfo>(info.resource_info);
 	image_info.imageView = *m_view;
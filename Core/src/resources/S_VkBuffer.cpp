@@ -2,14 +2,23 @@
 #include "core/VkCommon.h"
 
 namespace SNAKE {
-	void S_VkBuffer::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags flags) {
+	void S_VkBuffer::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags flags, bool transfer_queue_shared) {
 		m_usage = usage;
 		m_alloc_create_flags = flags;
+		m_transfer_queue_shared = transfer_queue_shared;
 
 		vk::BufferCreateInfo buffer_info{};
 		buffer_info.size = size;
 		buffer_info.usage = usage;
 
+		auto& device = VkContext::GetLogicalDevice();
+		std::array<uint32_t, 2> queue_families = { device.GetGraphicsFamily(), device.GetTransferFamily() };
+		if (transfer_queue_shared && device.HasDedicatedTransferQueue()) {
+			buffer_info.sharingMode = vk::SharingMode::eConcurrent;
+			buffer_info.queueFamilyIndexCount = (uint32_t)queue_families.size();
+			buffer_info.pQueueFamilyIndices = queue_families.data();
+		}
+
 		VmaAllocationCreateInfo alloc_create_info{};
 		alloc_create_info.usage = VMA_MEMORY_USAGE_AUTO;
 		alloc_create_info.flags = flags;
@@ -31,7 +40,7 @@ namespace SNAKE {
 		SNK_ASSERT(this->buffer != VK_NULL_HANDLE);
 
 		S_VkBuffer other;
-		other.CreateBuffer(new_size, this->m_usage, this->m_alloc_create_flags);
+		other.CreateBuffer(new_size, this->m_usage, this->m_alloc_create_flags, this->m_transfer_queue_shared);
 		CopyBuffer(this->buffer, other.buffer, this->alloc_info.size, 0, 0);
 
 		if (this->p_data) this->Unmap();
@@ -0,0 +1,397 @@
+#include "pch/pch.h"
+#include "scene/CullingSystem.h"
+#include "scene/SceneSnapshotSystem.h"
+#include "scene/CameraSystem.h"
+#include "scene/LightBufferSystem.h"
+#include "scene/Scene.h"
+#include "components/Components.h"
+#include "core/JobSystem.h"
+#include "assets/TextureResidencyManager.h"
+#include "util/ExtraMath.h"
+
+#include <numeric>
+
+using namespace SNAKE;
+
+void CullingSystem::OnSystemAdd() {
+	m_occlusion_buffers[(size_t)CullView::CAMERA].Init(CAMERA_OCCLUSION_RES.x, CAMERA_OCCLUSION_RES.y);
+	m_occlusion_buffers[(size_t)CullView::DIR_LIGHT].Init(DIR_LIGHT_OCCLUSION_RES.x, DIR_LIGHT_OCCLUSION_RES.y);
+
+	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
+		// Last frame's occlusion job still reads the draw items, bounds and visible lists rewritten below if nothing waited on it
+		WaitForOcclusion();
+
+		auto* p_snapshot_system = p_scene->GetSystem<SceneSnapshotSystem>();
+		if (!p_snapshot_system)
+			return;
+
+		const auto& snapshot = p_snapshot_system->GetSnapshotData();
+		if (snapshot.version != m_snapshot_version)
+			RebuildDrawItems(snapshot);
+
+		auto start_time = std::chrono::steady_clock::now();
+		UpdateBounds(snapshot);
+		auto bounds_time = std::chrono::steady_clock::now();
+		UpdateViewMatrices();
+		Cull();
+		RequestTextureMips(snapshot);
+		auto end_time = std::chrono::steady_clock::now();
+
+		m_stats.bounds_update_ms = std::chrono::duration_cast<std::chrono::microseconds>(bounds_time - start_time).count() / 1000.f;
+		m_stats.cull_ms = std::chrono::duration_cast<std::chrono::microseconds>(end_time - bounds_time).count() / 1000.f;
+
+		DispatchOcclusionJob(snapshot);
+	};
+
+	m_swapchain_invalidate_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<SwapchainInvalidateEvent const*>(p_event);
+		m_view_height = p_casted->new_swapchain_extents.y;
+	};
+
+	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+	EventManagerG::RegisterListener<SwapchainInvalidateEvent>(m_swapchain_invalidate_listener);
+}
+
+void CullingSystem::OnSystemRemove() {
+	EventManagerG::DeregisterListener(m_frame_start_listener);
+	EventManagerG::DeregisterListener(m_swapchain_invalidate_listener);
+	WaitForOcclusion();
+}
+
+void CullingSystem::RebuildDrawItems(const SceneSnapshotData& snapshot) {
+	m_draw_items.clear();
+	m_range_item_starts.clear();
+	m_range_item_starts.reserve(snapshot.mesh_ranges.size() + 1);
+
+	for (auto& range : snapshot.mesh_ranges) {
+		m_range_item_starts.push_back((uint32_t)m_draw_items.size());
+		auto* p_mesh = AssetManager::Resolve(range.mesh);
+		uint32_t num_submeshes = (uint32_t)p_mesh->data->submeshes.size();
+
+		for (uint32_t i = range.start_idx; i < range.start_idx + range.count; i++) {
+			for (uint32_t j = 0; j < num_submeshes; j++) {
+				m_draw_items.push_back(DrawItem{ i, j });
+			}
+		}
+	}
+
+	m_range_item_starts.push_back((uint32_t)m_draw_items.size());
+	m_bounds.Resize((uint32_t)m_draw_items.size());
+	m_range_meshes.resize(snapshot.mesh_ranges.size());
+	m_instance_scales.resize(snapshot.static_mesh_data.size());
+	m_instance_transforms.resize(snapshot.static_mesh_data.size());
+
+	m_occluders.clear();
+	for (uint32_t i = 0; i < snapshot.static_mesh_data.size(); i++) {
+		auto* p_mesh_comp = snapshot.static_mesh_data[i].p_entity->GetComponent<StaticMeshComponent>();
+		auto& occluder_mesh = p_mesh_comp->GetMeshAsset()->data->occluder_mesh;
+
+		if (p_mesh_comp->IsOccluder() && !occluder_mesh.indices.empty())
+			m_occluders.push_back(OccluderInstance{ i, &occluder_mesh, glm::mat4(1) });
+	}
+	m_snapshot_version = snapshot.version;
+}
+
+void CullingSystem::UpdateBounds(const SceneSnapshotData& snapshot) {
+	// Ranges are independent so each job can resolve its mesh once and walk its instances in order
+	JobSystem::ParallelFor((uint32_t)snapshot.mesh_ranges.size(), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t r = begin; r < end; r++) {
+			auto& range = snapshot.mesh_ranges[r];
+			m_range_meshes[r] = AssetManager::Resolve(range.mesh)->data.get();
+			auto& aabbs = m_range_meshes[r]->submesh_aabbs;
+			uint32_t item_idx = m_range_item_starts[r];
+
+			for (uint32_t i = range.start_idx; i < range.start_idx + range.count; i++) {
+				const auto& transform = snapshot.static_mesh_data[i].p_entity->GetComponent<TransformComponent>()->GetMatrix();
+				m_instance_transforms[i] = transform;
+				m_instance_scales[i] = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+				for (auto& aabb : aabbs) {
+					glm::vec3 center, extents;
+					ExtraMath::TransformAABB(transform, aabb.GetCenter(), aabb.GetExtents(), center, extents);
+					m_bounds.Set(item_idx++, center, extents);
+				}
+			}
+		}
+	});
+}
+
+void CullingSystem::UpdateViewMatrices() {
+	m_view_valid.fill(false);
+
+	auto* p_cam_system = p_scene->GetSystem<CameraSystem>();
+	if (auto* p_cam = p_cam_system ? p_cam_system->GetActiveCam() : nullptr) {
+		auto view = p_cam->GetViewMatrix();
+		m_view_matrices[(size_t)CullView::CAMERA] = p_cam->GetProjectionMatrix() * view;
+		m_camera_position = glm::vec3(glm::inverse(view)[3]);
+		m_view_valid[(size_t)CullView::CAMERA] = true;
+	}
+
+	if (auto* p_light_system = p_scene->GetSystem<LightBufferSystem>()) {
+		m_view_matrices[(size_t)CullView::DIR_LIGHT] = p_light_system->GetDirLightTransform();
+		m_view_valid[(size_t)CullView::DIR_LIGHT] = true;
+	}
+}
+
+std::vector<FrustumPlanes> CullingSystem::GetViewPlanes() const {
+	std::vector<FrustumPlanes> planes((size_t)CullView::COUNT);
+
+	for (size_t v = 0; v < (size_t)CullView::COUNT; v++) {
+		// Without a valid view (e.g. no active camera) nothing is rendered from it, planes with w = -1 reject everything
+		if (m_view_valid[v])
+			planes[v] = ExtraMath::ExtractFrustumPlanes(m_view_matrices[v]);
+		else
+			planes[v].fill(glm::vec4(0, 0, 0, -1));
+	}
+
+	return planes;
+}
+
+void CullingSystem::ComputeRangeStarts(VisibleList& list) const {
+	size_t num_ranges = m_range_item_starts.size() - 1;
+	list.range_starts.resize(num_ranges + 1);
+
+	// Items are ascending so each range's visible items are contiguous
+	uint32_t current = 0;
+	for (size_t r = 0; r < num_ranges; r++) {
+		list.range_starts[r] = current;
+		while (current < list.items.size() && list.items[current] < m_range_item_starts[r + 1])
+			current++;
+	}
+	list.range_starts[num_ranges] = current;
+}
+
+void CullingSystem::SelectLODs(CullView view, VisibleList& list) {
+	list.lods.assign(list.items.size(), 0);
+	if (!lod_selection_enabled || !m_view_valid[(size_t)view])
+		return;
+
+	const auto& proj_view = m_view_matrices[(size_t)view];
+
+	// Clip-space y change per world unit in the worst direction, dividing by w gives the NDC error for both perspective and orthographic views
+	float ndc_per_unit = glm::length(glm::vec3(proj_view[0][1], proj_view[1][1], proj_view[2][1]));
+	float w_per_unit = glm::length(glm::vec3(proj_view[0][3], proj_view[1][3], proj_view[2][3]));
+	float max_ndc_error = lod_screen_error * 2.f;
+
+	uint32_t num_simplified = 0;
+	for (size_t r = 0; r < m_range_meshes.size(); r++) {
+		auto& lods = m_range_meshes[r]->lods;
+		if (lods.empty())
+			continue;
+
+		for (uint32_t i = list.range_starts[r]; i < list.range_starts[r + 1]; i++) {
+			uint32_t item_idx = list.items[i];
+			glm::vec4 clip = proj_view * glm::vec4(m_bounds.center_x[item_idx], m_bounds.center_y[item_idx], m_bounds.center_z[item_idx], 1.f);
+
+			// Measured at the nearest point of the box's bounding sphere so large items aren't simplified based on their distant center
+			float radius = glm::length(glm::vec3(m_bounds.extent_x[item_idx], m_bounds.extent_y[item_idx], m_bounds.extent_z[item_idx]));
+			float w = clip.w - radius * w_per_unit;
+
+			// Intersecting the camera plane, keep full detail
+			if (w <= 1e-4f)
+				continue;
+
+			float world_to_ndc = m_instance_scales[m_draw_items[item_idx].instance_idx] * ndc_per_unit / w;
+
+			// Errors increase with each level, find the coarsest that is still acceptable
+			for (size_t l = lods.size(); l > 0; l--) {
+				if (lods[l - 1].error * world_to_ndc <= max_ndc_error) {
+					list.lods[i] = (uint8_t)l;
+					num_simplified++;
+					break;
+				}
+			}
+		}
+	}
+
+	m_stats.num_simplified[(size_t)view] = num_simplified;
+}
+
+void CullingSystem::CullMeshlets(CullView view, VisibleList& list) {
+	list.meshlet_ranges.assign(list.items.size(), VisibleList::MeshletRange{ VisibleList::WHOLE_ITEM, 0 });
+	list.meshlets.clear();
+
+	uint32_t num_tested = 0;
+	uint32_t num_culled = 0;
+	uint32_t num_triangles_culled = 0;
+
+	if (enabled && meshlet_culling_enabled && m_view_valid[(size_t)view]) {
+		auto planes = ExtraMath::ExtractFrustumPlanes(m_view_matrices[(size_t)view]);
+
+		// Cones are tested against a view position, the directional light's view is orthographic so only the camera uses them
+		bool cone_culling = view == CullView::CAMERA;
+
+		for (size_t r = 0; r < m_range_meshes.size(); r++) {
+			auto* p_mesh = m_range_meshes[r];
+			if (p_mesh->meshlets.empty())
+				continue;
+
+			for (uint32_t i = list.range_starts[r]; i < list.range_starts[r + 1]; i++) {
+				// LOD index ranges aren't split into meshlets
+				if (list.lods[i] != 0)
+					continue;
+
+				auto& item = m_draw_items[list.items[i]];
+				auto& submesh_meshlets = p_mesh->submesh_meshlets[item.submesh_idx];
+				if (submesh_meshlets.num_meshlets < MIN_MESHLETS_FOR_CULLING)
+					continue;
+
+				const auto& transform = m_instance_transforms[item.instance_idx];
+				float scale = m_instance_scales[item.instance_idx];
+
+				// Affine transforms preserve which side of a triangle a point is on, so cones are tested in object space
+				// Mirroring transforms flip the winding the rasterizer sees, cones are skipped for them
+				bool test_cones = cone_culling && glm::determinant(glm::mat3(transform)) > 0.f;
+				glm::vec3 local_camera = test_cones ? glm::vec3(glm::inverse(transform) * glm::vec4(m_camera_position, 1.f)) : glm::vec3(0);
+
+				auto& range = list.meshlet_ranges[i];
+				range.start = (uint32_t)list.meshlets.size();
+
+				for (uint32_t m = submesh_meshlets.first_meshlet; m < submesh_meshlets.first_meshlet + submesh_meshlets.num_meshlets; m++) {
+					auto& meshlet = p_mesh->meshlets[m];
+					num_tested++;
+
+					glm::vec3 center = glm::vec3(transform * glm::vec4(meshlet.center, 1.f));
+					float radius = meshlet.radius * scale;
+					bool visible = std::ranges::all_of(planes, [&](const glm::vec4& plane) { return glm::dot(glm::vec3(plane), center) + plane.w >= -radius; });
+
+					if (visible && test_cones && meshlet.cone_cutoff <= 1.f) {
+						glm::vec3 apex_dir = meshlet.cone_apex - local_camera;
+						float apex_dist = glm::length(apex_dir);
+						visible = apex_dist <= 0.f || glm::dot(apex_dir / apex_dist, meshlet.cone_axis) < meshlet.cone_cutoff;
+					}
+
+					if (visible) {
+						list.meshlets.push_back(m);
+					}
+					else {
+						num_culled++;
+						num_triangles_culled += meshlet.num_indices / 3;
+					}
+				}
+
+				range.count = (uint32_t)list.meshlets.size() - range.start;
+			}
+		}
+	}
+
+	m_stats.num_meshlets_tested[(size_t)view] = num_tested;
+	m_stats.num_meshlets_culled[(size_t)view] = num_culled;
+	m_stats.num_meshlet_triangles_culled[(size_t)view] = num_triangles_culled;
+}
+
+void CullingSystem::Cull() {
+	uint32_t num_items = (uint32_t)m_draw_items.size();
+
+	if (enabled) {
+		FrustumCuller::CullParallel(m_bounds, GetViewPlanes(), m_cull_output);
+	}
+	else {
+		m_cull_output.resize((size_t)CullView::COUNT);
+		for (auto& output : m_cull_output) {
+			output.resize(num_items);
+			std::iota(output.begin(), output.end(), 0u);
+		}
+	}
+
+	m_stats.num_tested = num_items;
+
+	for (size_t v = 0; v < (size_t)CullView::COUNT; v++) {
+		auto& list = m_visible_lists[v];
+		std::swap(list.items, m_cull_output[v]);
+		m_stats.num_visible[v] = (uint32_t)list.items.size();
+		m_stats.num_occluded[v] = 0;
+		ComputeRangeStarts(list);
+		SelectLODs((CullView)v, list);
+		CullMeshlets((CullView)v, list);
+	}
+}
+
+void CullingSystem::RequestTextureMips(const SceneSnapshotData& snapshot) {
+	constexpr size_t CAMERA = (size_t)CullView::CAMERA;
+	if (!texture_streaming_requests || !m_view_valid[CAMERA])
+		return;
+
+	const auto& list = m_visible_lists[CAMERA];
+	const auto& proj_view = m_view_matrices[CAMERA];
+
+	// Same projection as SelectLODs, NDC spans 2 across the view's height so the sphere's diameter covers radius * ndc_per_unit / w of it
+	float ndc_per_unit = glm::length(glm::vec3(proj_view[0][1], proj_view[1][1], proj_view[2][1]));
+	float w_per_unit = glm::length(glm::vec3(proj_view[0][3], proj_view[1][3], proj_view[2][3]));
+
+	for (uint32_t r = 0; r < snapshot.mesh_ranges.size(); r++) {
+		auto& range = snapshot.mesh_ranges[r];
+		auto& submeshes = m_range_meshes[r]->submeshes;
+
+		for (uint32_t i = list.range_starts[r]; i < list.range_starts[r + 1]; i++) {
+			uint32_t item_idx = list.items[i];
+			auto& item = m_draw_items[item_idx];
+			auto* p_mat = AssetManager::Resolve(snapshot.GetMaterial(range, submeshes[item.submesh_idx].material_index));
+			if (!p_mat)
+				continue;
+
+			glm::vec4 clip = proj_view * glm::vec4(m_bounds.center_x[item_idx], m_bounds.center_y[item_idx], m_bounds.center_z[item_idx], 1.f);
+			float radius = glm::length(glm::vec3(m_bounds.extent_x[item_idx], m_bounds.extent_y[item_idx], m_bounds.extent_z[item_idx]));
+			float w = clip.w - radius * w_per_unit;
+
+			// Intersecting the camera plane, full detail
+			float pixels = w <= 1e-4f ? std::numeric_limits<float>::infinity() : radius * ndc_per_unit * m_view_height / w;
+
+			for (auto* p_tex : { p_mat->albedo_tex.get(), p_mat->normal_tex.get(), p_mat->roughness_tex.get(), p_mat->metallic_tex.get(), p_mat->ao_tex.get() }) {
+				if (p_tex)
+					TextureResidencyManager::RequestScreenCoverage(p_tex, pixels);
+			}
+		}
+	}
+}
+
+void CullingSystem::DispatchOcclusionJob(const SceneSnapshotData& snapshot) {
+	m_stats.num_occluder_triangles = 0;
+	m_stats.occlusion_ms = 0.f;
+
+	if (!enabled || !occlusion_enabled || m_occluders.empty())
+		return;
+
+	for (auto& occluder : m_occluders) {
+		occluder.transform = snapshot.static_mesh_data[occluder.instance_idx].p_entity->GetComponent<TransformComponent>()->GetMatrix();
+	}
+
+	m_occlusion_ready.store(false, std::memory_order_release);
+
+	// Only reads data captured above or owned by this system, so it can run while the update job modifies the scene
+	auto* p_job = JobSystem::CreateJob();
+	p_job->func = [this]([[maybe_unused]] Job const* p_this) {
+		auto start_time = std::chrono::steady_clock::now();
+		uint32_t num_triangles = 0;
+
+		for (size_t v = 0; v < (size_t)CullView::COUNT; v++) {
+			if (!m_view_valid[v])
+				continue;
+
+			auto& buffer = m_occlusion_buffers[v];
+			buffer.Clear();
+			for (auto& occluder : m_occluders) {
+				buffer.AddOccluder(m_view_matrices[v] * occluder.transform, occluder.p_mesh->positions, occluder.p_mesh->indices);
+			}
+			buffer.Rasterize();
+			num_triangles += buffer.GetNumTriangles();
+
+			auto& list = m_visible_lists[v];
+			std::vector<uint32_t> unoccluded;
+			buffer.TestVisible(m_bounds, m_view_matrices[v], list.items, unoccluded);
+
+			m_stats.num_occluded[v] = (uint32_t)(list.items.size() - unoccluded.size());
+			m_stats.num_visible[v] = (uint32_t)unoccluded.size();
+			list.items = std::move(unoccluded);
+			ComputeRangeStarts(list);
+			SelectLODs((CullView)v, list);
+			CullMeshlets((CullView)v, list);
+		}
+
+		m_stats.num_occluder_triangles = num_triangles;
+		m_stats.occlusion_ms = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count() / 1000.f;
+		m_occlusion_ready.store(true, std::memory_order_release);
+	};
+
+	JobSystem::Execute(p_job);
+}
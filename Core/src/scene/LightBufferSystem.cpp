@@ -62,6 +62,13 @@ namespace SNAKE {
 	};
 
 
+	glm::mat4 LightBufferSystem::GetDirLightTransform() const {
+		glm::vec3 dir = glm::normalize(ExtraMath::SphericalToCartesian(1.f, p_scene->directional_light.spherical_coords.x, p_scene->directional_light.spherical_coords.y));
+		auto ortho = glm::ortho(-100.f, 100.f, -100.f, 100.f, 0.1f, 100.f);
+		auto view = glm::lookAt(dir * 50.f, glm::vec3(0), glm::vec3{0, 1, 0});
+		return ortho * view;
+	}
+
 	void LightBufferSystem::UpdateLightSSBO() {
 		auto frame_idx = VkContext::GetCurrentFIF();
 		size_t current_shader_offset = 0;
@@ -70,9 +77,7 @@ namespace SNAKE {
 		DirLightData dir_data;
 		dir_data.colour = glm::vec4(p_scene->directional_light.colour, 1.f);
 		dir_data.dir = glm::vec4(glm::normalize(ExtraMath::SphericalToCartesian(1.f, p_scene->directional_light.spherical_coords.x, p_scene->directional_light.spherical_coords.y)), 1.f);
-		auto ortho = glm::ortho(-100.f, 100.f, -100.f, 100.f, 0.1f, 100.f);
-		auto view = glm::lookAt(glm::vec3(dir_data.dir) * 50.f, glm::vec3(0), glm::vec3{0, 1, 0});
-		dir_data.transform = ortho * view;
+		dir_data.transform = GetDirLightTransform();
 		memcpy(light_ssbos[frame_idx].Map(), &dir_data, directional_light_shader_size);
 		current_shader_offset += directional_light_shader_size;
 
@@ -59,7 +59,8 @@ void ParticleSystem::InitPipelines() {
 	RtPipelineBuilder rt_builder{};
 	rt_builder.AddShader(vk::ShaderStageFlagBits::eRaygenKHR, "res/shaders/ParticleUpdatergen_00000000.spv")
 		.AddShader(vk::ShaderStageFlagBits::eMissKHR, "res/shaders/ParticleUpdatermiss_00000000.spv")
-		.AddShader(vk::ShaderStageFlagBits::eClosestHitKHR, "res/shaders/ParticleUpdaterchit_00000000.spv")
+		.AddShader(vk::ShaderStageFlagBits::eClosestHitKHR, AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat() ?
+			"res/shaders/ParticleUpdaterchit_10000000.spv" : "res/shaders/ParticleUpdaterchit_00000000.spv")
 		.AddShaderGroup(vk::RayTracingShaderGroupTypeKHR::eGeneral, 0, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR)
 		.AddShaderGroup(vk::RayTracingShaderGroupTypeKHR::eGeneral, 1, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR)
 		.AddShaderGroup(vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup, VK_SHADER_UNUSED_KHR, 2, VK_SHADER_UNUSED_KHR, VK_SHADER_UNUSED_KHR);
@@ -68,7 +69,7 @@ void ParticleSystem::InitPipelines() {
 	mp_ptcl_rt_descriptor_spec->AddDescriptor(0, vk::DescriptorType::eAccelerationStructureKHR, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR)
 		.AddDescriptor(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // Particles
 		.AddDescriptor(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // Indices
-		.AddDescriptor(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // Normals
+		.AddDescriptor(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // Normals, or the CompactVertex buffer in compact mode
 		.AddDescriptor(4, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // RT instance buffer
 		.AddDescriptor(5, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // Transforms
 		.AddDescriptor(6, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eRaygenKHR) // Transforms (previous frame)
@@ -116,7 +117,8 @@ void ParticleSystem::InitParticles() {
 
 		auto mesh_buffers = AssetManager::Get().mesh_buffer_manager.GetMeshBuffers();
 		auto index_buf_get_info = mesh_buffers.indices_buf.CreateDescriptorGetInfo();
-		auto normal_buf_get_info = mesh_buffers.normal_buf.CreateDescriptorGetInfo();
+		auto& normal_source_buf = AssetManager::Get().mesh_buffer_manager.UsesCompactVertexFormat() ? mesh_buffers.compact_vertex_buf : mesh_buffers.normal_buf;
+		auto normal_buf_get_info = normal_source_buf.CreateDescriptorGetInfo();
 		auto position_buf_get_info = mesh_buffers.position_buf.CreateDescriptorGetInfo();
 		auto& tlas = p_scene->GetSystem<TlasSystem>()->GetTlas(i);
 		auto tlas_get_info = tlas.CreateDescriptorGetInfo();
@@ -130,7 +132,7 @@ void ParticleSystem::InitParticles() {
 		m_ptcl_rt_descriptor_buffers[i].LinkResource(&tlas, tlas_get_info, 0, 0);
 		m_ptcl_rt_descriptor_buffers[i].LinkResource(&m_ptcl_buffers[i], ptcl_buf_get_info, 1, 0);
 		m_ptcl_rt_descriptor_buffers[i].LinkResource(&mesh_buffers.indices_buf, index_buf_get_info, 2, 0);
-		m_ptcl_rt_descriptor_buffers[i].LinkResource(&mesh_buffers.normal_buf, normal_buf_get_info, 3, 0);
+		m_ptcl_rt_descriptor_buffers[i].LinkResource(&normal_source_buf, normal_buf_get_info, 3, 0);
 		m_ptcl_rt_descriptor_buffers[i].LinkResource(&p_rt_buf_system->GetInstanceStorageBuffer(i), rt_instance_buf_get_info, 4, 0);
 		m_ptcl_rt_descriptor_buffers[i].LinkResource(&p_transform_buffer_system->GetTransformStorageBuffer(i), transform_buf_get_info, 5, 0);
 		m_ptcl_rt_descriptor_buffers[i].LinkResource(&p_transform_buffer_system->GetLastFramesTransformStorageBuffer(i), transform_buf_prev_frame_get_info, 6, 0);
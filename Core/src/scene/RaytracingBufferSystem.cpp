@@ -47,6 +47,16 @@ void RaytracingInstanceBufferSystem::OnSystemAdd() {
 		}
 	};
 
+	// Instance data stores mesh buffer offsets, refresh every instance of a mesh that defragmentation moved
+	m_mesh_data_moved_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<MeshDataMovedEvent const*>(p_event);
+
+		for (auto [entity, mesh_comp] : p_scene->GetRegistry().view<StaticMeshComponent>().each()) {
+			if (mesh_comp.GetMeshAsset()->data.get() == p_casted->p_mesh_data && p_scene->GetRegistry().all_of<RaytracingInstanceBufferIdxComponent>(entity))
+				m_instances_to_update.push_back(std::make_pair(entity, 0));
+		}
+	};
+
 	m_frame_start_event_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
 		UpdateInstanceBuffer();
 		UpdateEmissiveIdxBuffer();
@@ -55,6 +65,7 @@ void RaytracingInstanceBufferSystem::OnSystemAdd() {
 	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_event_listener);
 	EventManagerG::RegisterListener<ComponentEvent<TransformComponent>>(m_transform_event_listener);
 	EventManagerG::RegisterListener<ComponentEvent<StaticMeshComponent>>(m_mesh_event_listener);
+	EventManagerG::RegisterListener<MeshDataMovedEvent>(m_mesh_data_moved_listener);
 
 	for (FrameInFlightIndex i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		m_storage_buffers_instances[i].CreateBuffer(sizeof(InstanceData) * 4096, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
@@ -79,6 +90,14 @@ void RaytracingInstanceBufferSystem::UpdateInstanceBuffer() {
 
 		auto& mesh_comp = reg.get<StaticMeshComponent>(ent);
 		auto* p_mesh_asset = mesh_comp.GetMeshAsset();
+
+		// Streamed meshes have no slots until loaded, they're re-added through a component update then
+		if (!mesh_buffer_manager.IsMeshLoaded(p_mesh_asset->data.get())) {
+			m_instances_to_update.erase(m_instances_to_update.begin() + i);
+			i--;
+			continue;
+		}
+
 		auto& mesh_buffer_entry_data = mesh_buffer_manager.GetEntryData(p_mesh_asset->data.get());
 
 		InstanceData instance_data{
@@ -6,6 +6,7 @@
 #include "scene/RaytracingBufferSystem.h"
 #include "scene/TransformBufferSystem.h"
 #include "scene/SceneSnapshotSystem.h"
+#include "scene/CullingSystem.h"
 #include "scene/ParticleSystem.h"
 #include "components/Components.h"
 
@@ -26,6 +27,7 @@ void Scene::AddDefaultSystems() {
 	AddSystem<TransformBufferSystem>();
 	AddSystem<RaytracingInstanceBufferSystem>();
 	AddSystem<SceneSnapshotSystem>();
+	AddSystem<CullingSystem>();
 }
 
 Entity* Scene::GetEntity(entt::entity handle) {
@@ -72,11 +72,8 @@ void SceneInfoBufferSystem::UpdateUBO(FrameInFlightIndex frame_idx) {
 	if (!p_cam_comp)
 		return;
 
-	auto* p_cam_ent = p_cam_comp->GetEntity();
-	auto* p_transform = p_cam_ent->GetComponent<TransformComponent>();
-
 	s_ubo.frame_idx = VkContext::GetCurrentFrameIdx();
-	s_ubo.view = glm::lookAt(p_transform->GetPosition(), p_transform->GetPosition() + p_transform->forward, glm::vec3(0.f, 1.f, 0.f));
+	s_ubo.view = p_cam_comp->GetViewMatrix();
 	s_ubo.proj = p_cam_comp->GetProjectionMatrix();
 	s_ubo.proj_view = s_ubo.proj * s_ubo.view;
 	s_ubo.app_time_elapsed = FrameTiming::GetTotalElapsedTime();
@@ -67,6 +67,7 @@ json SceneSerializer::SerializeEntity(Entity& ent, Scene& scene) {
 			material_uuids.push_back(p_mesh->materials[i]->uuid());
 		}
 		j["StaticMesh"]["Materials"] = material_uuids;
+		j["StaticMesh"]["Occluder"] = p_mesh->occluder;
 	}
 
 	if (auto* p_pl = ent.GetComponent<PointlightComponent>()) {
@@ -140,6 +141,11 @@ void SceneSerializer::DeserializeEntity(Entity& ent, json& j) {
 
 			p_mesh->materials[i] = mat;
 		}
+
+		if (m.contains("Occluder"))
+			m.at("Occluder").get_to(p_mesh->occluder);
+
+		EventManagerG::DispatchEvent(ComponentEvent<StaticMeshComponent>(p_mesh, ComponentEventType::UPDATED));
 	}
 	
 }
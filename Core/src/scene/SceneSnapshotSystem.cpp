@@ -1,6 +1,7 @@
 #include "scene/SceneSnapshotSystem.h"
 #include "scene/TransformBufferSystem.h"
 #include "components/Components.h"
+#include "assets/AssetManager.h"
 
 using namespace SNAKE;
 
@@ -8,40 +9,149 @@ void SceneSnapshotSystem::OnSystemAdd() {
 	m_frame_start_listener.callback = [this]([[maybe_unused]] Event const* p_event) {
 		TakeSceneSnapshot();
 	};
+
+	m_mesh_event_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<ComponentEvent<StaticMeshComponent> const*>(p_event);
+		auto* p_ent = p_casted->p_component->GetEntity();
+
+		// Listener is global, ignore components from other scenes
+		if (p_ent->GetScene() != p_scene)
+			return;
+
+		switch (p_casted->event_type) {
+		case ComponentEventType::ADDED:
+			AddInstance(p_casted->p_component);
+			break;
+		case ComponentEventType::UPDATED:
+			// Mesh or material set may have changed so the instance may belong to a different batch now
+			RemoveInstance(p_ent);
+			AddInstance(p_casted->p_component);
+			break;
+		case ComponentEventType::REMOVED:
+			RemoveInstance(p_ent);
+			break;
+		}
+	};
+
+	// Streamed meshes have no submeshes until their data is loaded, their components are updated so every system rebuilds what it derived from them
+	m_mesh_data_loaded_listener.callback = [this](Event const* p_event) {
+		auto* p_casted = dynamic_cast<MeshDataLoadedEvent const*>(p_event);
+
+		for (auto [entity, mesh] : p_scene->GetRegistry().view<StaticMeshComponent>().each()) {
+			if (mesh.GetMeshAsset()->data.get() == p_casted->p_mesh_data)
+				EventManagerG::DispatchEvent(ComponentEvent<StaticMeshComponent>(&mesh, ComponentEventType::UPDATED));
+		}
+	};
+
 	EventManagerG::RegisterListener<FrameStartEvent>(m_frame_start_listener);
+	EventManagerG::RegisterListener<ComponentEvent<StaticMeshComponent>>(m_mesh_event_listener);
+	EventManagerG::RegisterListener<MeshDataLoadedEvent>(m_mesh_data_loaded_listener);
+
+	// Pick up any meshes that existed before this system was added
+	for (auto [entity, mesh] : p_scene->GetRegistry().view<StaticMeshComponent>().each()) {
+		AddInstance(&mesh);
+	}
 }
 
-void SceneSnapshotSystem::TakeSceneSnapshot() {
-	m_snapshot_data.Reset();
+void SceneSnapshotSystem::OnSystemRemove() {
+	EventManagerG::DeregisterListener(m_frame_start_listener);
+	EventManagerG::DeregisterListener(m_mesh_event_listener);
+	EventManagerG::DeregisterListener(m_mesh_data_loaded_listener);
+}
 
-	std::vector<StaticMeshComponent*> comps;
+void SceneSnapshotSystem::AddInstance(StaticMeshComponent* p_mesh) {
+	auto* p_ent = p_mesh->GetEntity();
+	SNK_DBG_ASSERT(!m_instance_locations.contains(p_ent));
 
-	for (auto [entity, mesh] : p_scene->GetRegistry().view<StaticMeshComponent>().each()) {
-		comps.push_back(&mesh);
+	BatchKey key{ .mesh = AssetManager::GetHandle(p_mesh->GetMeshAsset()) };
+	const auto& materials = p_mesh->GetMaterials();
+	key.material_indices.reserve(materials.size());
+	for (const auto& mat : materials) {
+		key.material_indices.push_back(mat->GetGlobalBufferIndex());
 	}
 
-	// Order meshes based on their data
-	std::ranges::sort(comps, [](const auto& mesh0, const auto& mesh1) -> bool { return mesh0->GetMeshAsset()->uuid() < mesh1->GetMeshAsset()->uuid(); });
+	uint32_t batch_idx;
+	if (auto it = m_batch_lookup.find(key); it != m_batch_lookup.end()) {
+		batch_idx = it->second;
+	}
+	else {
+		batch_idx = (uint32_t)m_batches.size();
+		m_batch_lookup[key] = batch_idx;
 
-	StaticMeshAsset* p_current_mesh = comps.empty() ? nullptr : comps[0]->GetMeshAsset();
-	uint32_t mesh_change_index = 0;
-	uint32_t same_mesh_count = 0;
+		auto& batch = m_batches.emplace_back();
+		batch.key = std::move(key);
+		for (const auto& mat : materials) {
+			batch.materials.push_back(AssetManager::GetHandle(mat.get()));
+		}
+	}
 
-	for (uint32_t i = 0; i < comps.size(); i++) {
-		auto* p_mesh = comps[i];
+	auto& batch = m_batches[batch_idx];
+	m_instance_locations[p_ent] = InstanceLocation{ batch_idx, (uint32_t)batch.entities.size() };
+	batch.transform_indices.push_back(p_ent->GetComponent<TransformBufferIdxComponent>()->idx);
+	batch.entities.push_back(p_ent);
 
-		if (auto* p_new_mesh = p_mesh->GetMeshAsset(); p_new_mesh != p_current_mesh) {
-			m_snapshot_data.mesh_ranges.emplace_back(p_current_mesh->uuid(), mesh_change_index, same_mesh_count);
-			p_current_mesh = p_new_mesh;
-			same_mesh_count = 0;
-			mesh_change_index = i;
+	m_dirty = true;
+}
+
+void SceneSnapshotSystem::RemoveInstance(Entity* p_entity) {
+	auto loc_it = m_instance_locations.find(p_entity);
+	if (loc_it == m_instance_locations.end())
+		return;
+
+	auto [batch_idx, slot] = loc_it->second;
+	m_instance_locations.erase(loc_it);
+
+	// Swap-remove the instance from its batch
+	auto& batch = m_batches[batch_idx];
+	uint32_t last_slot = (uint32_t)batch.entities.size() - 1;
+	if (slot != last_slot) {
+		batch.transform_indices[slot] = batch.transform_indices[last_slot];
+		batch.entities[slot] = batch.entities[last_slot];
+		m_instance_locations[batch.entities[slot]].slot = slot;
+	}
+	batch.transform_indices.pop_back();
+	batch.entities.pop_back();
+
+	// Swap-remove the batch itself once empty
+	if (batch.entities.empty()) {
+		m_batch_lookup.erase(batch.key);
+		uint32_t last_batch_idx = (uint32_t)m_batches.size() - 1;
+
+		if (batch_idx != last_batch_idx) {
+			m_batches[batch_idx] = std::move(m_batches[last_batch_idx]);
+			m_batch_lookup[m_batches[batch_idx].key] = batch_idx;
+
+			for (auto* p_moved_ent : m_batches[batch_idx].entities) {
+				m_instance_locations[p_moved_ent].batch_idx = batch_idx;
+			}
 		}
 
-		same_mesh_count++;
-		m_snapshot_data.static_mesh_data.emplace_back(p_mesh->GetMaterials(), p_mesh->GetEntity()->GetComponent<TransformBufferIdxComponent>()->idx);
+		m_batches.pop_back();
 	}
 
-	if (p_current_mesh)
-		m_snapshot_data.mesh_ranges.emplace_back(p_current_mesh->uuid(), mesh_change_index, same_mesh_count);
+	m_dirty = true;
 }
 
+void SceneSnapshotSystem::TakeSceneSnapshot() {
+	if (!m_dirty)
+		return;
+
+	m_snapshot_data.Reset();
+
+	for (const auto& batch : m_batches) {
+		uint32_t start_idx = (uint32_t)m_snapshot_data.static_mesh_data.size();
+		uint32_t material_start_idx = (uint32_t)m_snapshot_data.material_indices.size();
+
+		m_snapshot_data.material_indices.insert(m_snapshot_data.material_indices.end(), batch.key.material_indices.begin(), batch.key.material_indices.end());
+		m_snapshot_data.materials.insert(m_snapshot_data.materials.end(), batch.materials.begin(), batch.materials.end());
+
+		for (size_t i = 0; i < batch.transform_indices.size(); i++) {
+			m_snapshot_data.static_mesh_data.emplace_back(batch.transform_indices[i], batch.entities[i]);
+		}
+
+		m_snapshot_data.mesh_ranges.emplace_back(batch.key.mesh, start_idx, (uint32_t)batch.transform_indices.size(), material_start_idx);
+	}
+
+	m_snapshot_data.version++;
+	m_dirty = false;
+}
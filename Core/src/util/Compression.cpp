@@ -0,0 +1,333 @@
+#include "pch/pch.h"
+#include "util/Compression.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+namespace {
+	constexpr size_t MIN_MATCH = 4;
+	// The format requires the last 5 bytes to be literals and the last match to start at least 12 bytes before the end
+	constexpr size_t LAST_LITERALS = 5;
+	constexpr size_t MF_LIMIT = 12;
+	constexpr size_t MAX_OFFSET = 65535;
+
+	constexpr uint32_t HASH_LOG = 14;
+
+	// Decoding copies this many bytes at a time where the buffers have room, so short copies don't go through a variable size memcpy
+	constexpr size_t WILD_COPY_SIZE = 16;
+
+	constexpr size_t CHUNKED_HEADER_SIZE = sizeof(uint64_t) + sizeof(uint32_t) * 2;
+
+	uint32_t Read32(const std::byte* p) {
+		uint32_t val;
+		std::memcpy(&val, p, sizeof(uint32_t));
+		return val;
+	}
+
+	uint32_t HashSequence(uint32_t seq) {
+		return (seq * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	// Worst case size of a length written as a token nibble followed by 255-continuation bytes
+	size_t ExtraLengthBytes(size_t len) {
+		return len >= 15 ? (len - 15) / 255 + 1 : 0;
+	}
+
+	void WriteExtraLength(std::byte*& p_out, size_t len) {
+		len -= 15;
+		for (; len >= 255; len -= 255) {
+			*p_out++ = std::byte{ 255 };
+		}
+		*p_out++ = (std::byte)len;
+	}
+
+	bool ReadExtraLength(const std::byte*& p_in, const std::byte* p_end, size_t& len) {
+		uint8_t b;
+		do {
+			if (p_in >= p_end)
+				return false;
+
+			b = (uint8_t)*p_in++;
+			len += b;
+		} while (b == 255);
+
+		return true;
+	}
+
+	struct ChunkedHeader {
+		uint64_t uncompressed_size;
+		uint32_t chunk_size;
+		uint32_t num_chunks;
+	};
+
+	ChunkedHeader ReadChunkedHeader(const std::byte* p_src) {
+		ChunkedHeader header;
+		std::memcpy(&header.uncompressed_size, p_src, sizeof(uint64_t));
+		std::memcpy(&header.chunk_size, p_src + sizeof(uint64_t), sizeof(uint32_t));
+		std::memcpy(&header.num_chunks, p_src + sizeof(uint64_t) + sizeof(uint32_t), sizeof(uint32_t));
+		return header;
+	}
+}
+
+size_t Compression::CompressBound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+size_t Compression::CompressBlock(const std::byte* p_src, size_t src_size, std::byte* p_dst, size_t dst_capacity) {
+	std::byte* p_out = p_dst;
+	std::byte* p_out_end = p_dst + dst_capacity;
+
+	auto emit_sequence = [&](size_t literal_start, size_t literal_len, size_t offset, size_t match_len) -> bool {
+		size_t required = 1 + ExtraLengthBytes(literal_len) + literal_len + (match_len ? 2 + ExtraLengthBytes(match_len - MIN_MATCH) : 0);
+		if ((size_t)(p_out_end - p_out) < required)
+			return false;
+
+		std::byte* p_token = p_out++;
+		uint8_t token = (uint8_t)(std::min<size_t>(literal_len, 15) << 4);
+		if (literal_len >= 15)
+			WriteExtraLength(p_out, literal_len);
+
+		if (literal_len > 0)
+			std::memcpy(p_out, p_src + literal_start, literal_len);
+
+		p_out += literal_len;
+
+		if (match_len) {
+			*p_out++ = (std::byte)(offset & 0xFF);
+			*p_out++ = (std::byte)(offset >> 8);
+
+			size_t stored_len = match_len - MIN_MATCH;
+			token |= (uint8_t)std::min<size_t>(stored_len, 15);
+			if (stored_len >= 15)
+				WriteExtraLength(p_out, stored_len);
+		}
+
+		*p_token = (std::byte)token;
+		return true;
+	};
+
+	size_t anchor = 0;
+
+	if (src_size > MF_LIMIT) {
+		// Positions + 1 so 0 means empty
+		std::vector<uint32_t> table(1 << HASH_LOG, 0);
+
+		size_t match_start_limit = src_size - MF_LIMIT;
+		size_t match_end_limit = src_size - LAST_LITERALS;
+		size_t pos = 0;
+		uint32_t misses = 0;
+
+		while (pos <= match_start_limit) {
+			uint32_t seq = Read32(p_src + pos);
+			uint32_t& slot = table[HashSequence(seq)];
+			size_t candidate = slot;
+			slot = (uint32_t)pos + 1;
+
+			if (candidate == 0 || pos + 1 - candidate > MAX_OFFSET || Read32(p_src + candidate - 1) != seq) {
+				// Step faster through data that isn't compressing so incompressible chunks don't cost much
+				pos += 1 + (misses++ >> 6);
+				continue;
+			}
+
+			misses = 0;
+			candidate--;
+
+			while (pos > anchor && candidate > 0 && p_src[pos - 1] == p_src[candidate - 1]) {
+				pos--;
+				candidate--;
+			}
+
+			size_t match_len = MIN_MATCH;
+			while (pos + match_len < match_end_limit && p_src[pos + match_len] == p_src[candidate + match_len]) {
+				match_len++;
+			}
+
+			if (!emit_sequence(anchor, pos - anchor, pos - candidate, match_len))
+				return 0;
+
+			pos += match_len;
+			anchor = pos;
+
+			if (pos - 2 <= match_start_limit)
+				table[HashSequence(Read32(p_src + pos - 2))] = (uint32_t)(pos - 2) + 1;
+		}
+	}
+
+	if (!emit_sequence(anchor, src_size - anchor, 0, 0))
+		return 0;
+
+	return p_out - p_dst;
+}
+
+bool Compression::DecompressBlock(const std::byte* p_src, size_t src_size, std::byte* p_dst, size_t dst_size) {
+	const std::byte* p_in = p_src;
+	const std::byte* p_in_end = p_src + src_size;
+	size_t out_pos = 0;
+
+	while (true) {
+		if (p_in >= p_in_end)
+			return false;
+
+		uint8_t token = (uint8_t)*p_in++;
+
+		size_t literal_len = token >> 4;
+		if (literal_len == 15 && !ReadExtraLength(p_in, p_in_end, literal_len))
+			return false;
+
+		if (literal_len > (size_t)(p_in_end - p_in) || literal_len > dst_size - out_pos)
+			return false;
+
+		// Fixed size copies compile to a couple of vector moves, short runs are the common case
+		if (literal_len <= WILD_COPY_SIZE && p_in_end - p_in >= (ptrdiff_t)WILD_COPY_SIZE && dst_size - out_pos >= WILD_COPY_SIZE)
+			std::memcpy(p_dst + out_pos, p_in, WILD_COPY_SIZE);
+		else if (literal_len > 0)
+			std::memcpy(p_dst + out_pos, p_in, literal_len);
+
+		p_in += literal_len;
+		out_pos += literal_len;
+
+		// The last sequence only has literals
+		if (p_in == p_in_end)
+			return out_pos == dst_size;
+
+		if (p_in_end - p_in < 2)
+			return false;
+
+		size_t offset = (size_t)p_in[0] | ((size_t)p_in[1] << 8);
+		p_in += 2;
+
+		if (offset == 0 || offset > out_pos)
+			return false;
+
+		size_t match_len = token & 15;
+		if (match_len == 15 && !ReadExtraLength(p_in, p_in_end, match_len))
+			return false;
+
+		match_len += MIN_MATCH;
+		if (match_len > dst_size - out_pos)
+			return false;
+
+		std::byte* p_match = p_dst + out_pos - offset;
+		std::byte* p_out = p_dst + out_pos;
+
+		if (offset >= WILD_COPY_SIZE && dst_size - out_pos >= match_len + WILD_COPY_SIZE) {
+			// Each step reads bytes written at least WILD_COPY_SIZE earlier so steps never overlap, may write past the match into bytes decoded later
+			for (size_t i = 0; i < match_len; i += WILD_COPY_SIZE) {
+				std::memcpy(p_out + i, p_match + i, WILD_COPY_SIZE);
+			}
+		}
+		else if (offset >= match_len) {
+			std::memcpy(p_out, p_match, match_len);
+		}
+		else {
+			// Overlapping match repeats the last 'offset' bytes
+			for (size_t i = 0; i < match_len; i++) {
+				p_out[i] = p_match[i];
+			}
+		}
+
+		out_pos += match_len;
+	}
+}
+
+std::vector<std::byte> Compression::CompressChunked(const std::byte* p_src, size_t src_size, uint32_t chunk_size) {
+	SNK_ASSERT(chunk_size > 0);
+
+	uint32_t num_chunks = (uint32_t)((src_size + chunk_size - 1) / chunk_size);
+	std::vector<std::vector<std::byte>> chunks(num_chunks);
+
+	JobSystem::ParallelFor(num_chunks, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			size_t offset = (size_t)i * chunk_size;
+			size_t raw_size = std::min<size_t>(chunk_size, src_size - offset);
+
+			auto& chunk = chunks[i];
+			chunk.resize(CompressBound(raw_size));
+			size_t compressed_size = CompressBlock(p_src + offset, raw_size, chunk.data(), chunk.size());
+
+			if (compressed_size == 0 || compressed_size >= raw_size) {
+				chunk.resize(raw_size);
+				std::memcpy(chunk.data(), p_src + offset, raw_size);
+			}
+			else {
+				chunk.resize(compressed_size);
+			}
+		}
+		});
+
+	size_t total_size = CHUNKED_HEADER_SIZE + num_chunks * sizeof(uint32_t);
+	for (auto& chunk : chunks) {
+		total_size += chunk.size();
+	}
+
+	std::vector<std::byte> output(total_size);
+	std::byte* p_out = output.data();
+
+	uint64_t uncompressed_size = src_size;
+	std::memcpy(p_out, &uncompressed_size, sizeof(uint64_t));
+	std::memcpy(p_out + sizeof(uint64_t), &chunk_size, sizeof(uint32_t));
+	std::memcpy(p_out + sizeof(uint64_t) + sizeof(uint32_t), &num_chunks, sizeof(uint32_t));
+	p_out += CHUNKED_HEADER_SIZE;
+
+	for (auto& chunk : chunks) {
+		uint32_t stored_size = (uint32_t)chunk.size();
+		std::memcpy(p_out, &stored_size, sizeof(uint32_t));
+		p_out += sizeof(uint32_t);
+	}
+
+	for (auto& chunk : chunks) {
+		std::memcpy(p_out, chunk.data(), chunk.size());
+		p_out += chunk.size();
+	}
+
+	return output;
+}
+
+uint64_t Compression::GetChunkedUncompressedSize(const std::byte* p_src, size_t src_size) {
+	if (src_size < CHUNKED_HEADER_SIZE)
+		return 0;
+
+	return ReadChunkedHeader(p_src).uncompressed_size;
+}
+
+bool Compression::DecompressChunked(const std::byte* p_src, size_t src_size, std::byte* p_dst, size_t dst_size) {
+	if (src_size < CHUNKED_HEADER_SIZE)
+		return false;
+
+	auto header = ReadChunkedHeader(p_src);
+	if (header.uncompressed_size != dst_size || header.chunk_size == 0 ||
+		header.num_chunks != (dst_size + header.chunk_size - 1) / header.chunk_size ||
+		(src_size - CHUNKED_HEADER_SIZE) / sizeof(uint32_t) < header.num_chunks)
+		return false;
+
+	const std::byte* p_table = p_src + CHUNKED_HEADER_SIZE;
+
+	// Chunk data offsets from the start of src, validated up front so chunks can decode independently
+	std::vector<size_t> chunk_offsets(header.num_chunks + 1);
+	chunk_offsets[0] = CHUNKED_HEADER_SIZE + header.num_chunks * sizeof(uint32_t);
+
+	for (uint32_t i = 0; i < header.num_chunks; i++) {
+		size_t stored_size = Read32(p_table + i * sizeof(uint32_t));
+		if (stored_size > src_size - chunk_offsets[i])
+			return false;
+
+		chunk_offsets[i + 1] = chunk_offsets[i] + stored_size;
+	}
+
+	std::atomic_bool success = true;
+
+	JobSystem::ParallelFor(header.num_chunks, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			size_t dst_offset = (size_t)i * header.chunk_size;
+			size_t raw_size = std::min<size_t>(header.chunk_size, dst_size - dst_offset);
+			size_t stored_size = chunk_offsets[i + 1] - chunk_offsets[i];
+
+			if (stored_size == raw_size)
+				std::memcpy(p_dst + dst_offset, p_src + chunk_offsets[i], raw_size);
+			else if (!DecompressBlock(p_src + chunk_offsets[i], stored_size, p_dst + dst_offset, raw_size))
+				success = false;
+		}
+		});
+
+	return success;
+}
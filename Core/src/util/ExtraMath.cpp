@@ -23,6 +23,35 @@ namespace SNAKE {
 		return rot_matrix;
 	}
 
+	void ExtraMath::TransformAABB(const glm::mat4& m, const glm::vec3& center, const glm::vec3& extents, glm::vec3& out_center, glm::vec3& out_extents) {
+		out_center = glm::vec3(m * glm::vec4(center, 1.f));
+
+		// Arvo's method, extents are projected onto each axis with the absolute rotation/scale part of the matrix
+		for (int i = 0; i < 3; i++) {
+			out_extents[i] = glm::abs(m[0][i]) * extents.x + glm::abs(m[1][i]) * extents.y + glm::abs(m[2][i]) * extents.z;
+		}
+	}
+
+	std::array<glm::vec4, 6> ExtraMath::ExtractFrustumPlanes(const glm::mat4& proj_view) {
+		auto row = [&](int i) { return glm::vec4(proj_view[0][i], proj_view[1][i], proj_view[2][i], proj_view[3][i]); };
+		glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+		std::array<glm::vec4, 6> planes = {
+			r3 + r0,
+			r3 - r0,
+			r3 + r1,
+			r3 - r1,
+			r2,
+			r3 - r2
+		};
+
+		for (auto& plane : planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return planes;
+	}
+
 	glm::vec3 ExtraMath::CartesianToSpherical(glm::vec3 vec) {
 		auto l = vec.length();
 		return { l, atan2f(vec.y, vec.x), acosf(vec.z / l) };
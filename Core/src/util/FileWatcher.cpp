@@ -0,0 +1,174 @@
+#include "pch/pch.h"
+#include "util/FileWatcher.h"
+#include "util/util.h"
+
+#if defined (__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace SNAKE;
+
+bool FileWatcher::Watch(const std::string& directory) {
+	Stop();
+
+	std::error_code ec;
+	if (!std::filesystem::is_directory(directory, ec)) {
+		SNK_CORE_ERROR("FileWatcher::Watch failed, '{}' isn't a directory", directory);
+		return false;
+	}
+
+#if defined (__linux__)
+	m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotify_fd < 0) {
+		SNK_CORE_ERROR("FileWatcher::Watch failed, inotify_init1 error {}", errno);
+		return false;
+	}
+#endif
+
+	m_directory = directory;
+	AddDirectory(directory, nullptr);
+
+#if !defined (__linux__)
+	m_last_scan = std::chrono::steady_clock::now();
+#endif
+	return true;
+}
+
+void FileWatcher::Stop() {
+#if defined (__linux__)
+	if (m_inotify_fd >= 0)
+		close(m_inotify_fd);
+
+	m_inotify_fd = -1;
+	m_watched_directories.clear();
+#else
+	m_write_times.clear();
+#endif
+
+	m_directory.clear();
+}
+
+#if defined (__linux__)
+
+void FileWatcher::AddDirectory(const std::filesystem::path& directory, std::vector<std::string>* p_changed) {
+	std::vector<std::filesystem::path> directories{ directory };
+
+	while (!directories.empty()) {
+		auto dir = std::move(directories.back());
+		directories.pop_back();
+
+		// Added before listing so nothing written to the directory meanwhile is missed, files listed and written are reported twice at worst
+		int wd = inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+		if (wd < 0) {
+			SNK_CORE_ERROR("FileWatcher couldn't watch '{}', inotify_add_watch error {}", dir.string(), errno);
+			continue;
+		}
+
+		m_watched_directories[wd] = dir;
+
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+			if (entry.is_directory(ec))
+				directories.push_back(entry.path());
+			else if (p_changed)
+				p_changed->push_back(entry.path().string());
+		}
+	}
+}
+
+std::vector<std::string> FileWatcher::Poll() {
+	std::vector<std::string> changed;
+	if (m_inotify_fd < 0)
+		return changed;
+
+	alignas(inotify_event) char buffer[16 * 1024];
+
+	while (true) {
+		ssize_t len = read(m_inotify_fd, buffer, sizeof(buffer));
+		if (len <= 0) {
+			if (len < 0 && errno != EAGAIN && errno != EINTR)
+				SNK_CORE_ERROR("FileWatcher::Poll failed reading events for '{}', error {}", m_directory, errno);
+
+			break;
+		}
+
+		for (char* p = buffer; p < buffer + len; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len) {
+			auto* p_event = reinterpret_cast<inotify_event*>(p);
+
+			if (p_event->mask & IN_Q_OVERFLOW) {
+				SNK_CORE_WARN("FileWatcher event queue overflowed for '{}', some changes were missed", m_directory);
+				continue;
+			}
+
+			// The directory was deleted or moved away, its watch is already gone
+			if (p_event->mask & IN_IGNORED) {
+				m_watched_directories.erase(p_event->wd);
+				continue;
+			}
+
+			auto it = m_watched_directories.find(p_event->wd);
+			if (it == m_watched_directories.end() || p_event->len == 0)
+				continue;
+
+			auto path = it->second / p_event->name;
+			if (p_event->mask & IN_ISDIR) {
+				// Anything written into a new directory before its watch was added is found by listing it
+				if (p_event->mask & (IN_CREATE | IN_MOVED_TO))
+					AddDirectory(path, &changed);
+			}
+			else if (p_event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+				changed.push_back(path.string());
+			}
+		}
+	}
+
+	std::ranges::sort(changed);
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+	return changed;
+}
+
+#else
+
+void FileWatcher::AddDirectory(const std::filesystem::path& directory, std::vector<std::string>* p_changed) {
+	std::error_code ec;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, ec);
+		it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+		if (ec)
+			break;
+
+		if (!it->is_regular_file(ec))
+			continue;
+
+		auto write_time = it->last_write_time(ec);
+		if (ec)
+			continue;
+
+		auto [entry, inserted] = m_write_times.try_emplace(it->path().string(), write_time);
+		if (!inserted && entry->second != write_time) {
+			entry->second = write_time;
+			if (p_changed)
+				p_changed->push_back(entry->first);
+		}
+		else if (inserted && p_changed) {
+			p_changed->push_back(entry->first);
+		}
+	}
+}
+
+std::vector<std::string> FileWatcher::Poll() {
+	std::vector<std::string> changed;
+	if (m_directory.empty())
+		return changed;
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - m_last_scan < SCAN_INTERVAL)
+		return changed;
+
+	m_last_scan = now;
+	AddDirectory(m_directory, &changed);
+	return changed;
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "pch/pch.h"
+#include "util/Hash.h"
+#include <bit>
+
+using namespace SNAKE;
+
+namespace {
+	constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+	constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+	constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+	uint64_t Read64(const std::byte* p) {
+		uint64_t val;
+		std::memcpy(&val, p, sizeof(uint64_t));
+		return val;
+	}
+
+	uint32_t Read32(const std::byte* p) {
+		uint32_t val;
+		std::memcpy(&val, p, sizeof(uint32_t));
+		return val;
+	}
+
+	uint64_t Round(uint64_t acc, uint64_t input) {
+		acc += input * PRIME_2;
+		acc = std::rotl(acc, 31);
+		return acc * PRIME_1;
+	}
+
+	uint64_t MergeRound(uint64_t acc, uint64_t val) {
+		acc ^= Round(0, val);
+		return acc * PRIME_1 + PRIME_4;
+	}
+}
+
+Hasher::Hasher(uint64_t seed) : m_seed(seed) {
+	m_accumulators = { seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1 };
+}
+
+void Hasher::Update(const void* p_data, size_t size) {
+	auto* p_bytes = reinterpret_cast<const std::byte*>(p_data);
+	m_total_size += size;
+
+	auto consume_stripe = [this](const std::byte* p_stripe) {
+		for (uint32_t i = 0; i < 4; i++) {
+			m_accumulators[i] = Round(m_accumulators[i], Read64(p_stripe + i * 8));
+		}
+	};
+
+	if (m_buffer_size + size < m_buffer.size()) {
+		if (size > 0)
+			std::memcpy(m_buffer.data() + m_buffer_size, p_bytes, size);
+
+		m_buffer_size += (uint32_t)size;
+		return;
+	}
+
+	if (m_buffer_size > 0) {
+		size_t fill = m_buffer.size() - m_buffer_size;
+		std::memcpy(m_buffer.data() + m_buffer_size, p_bytes, fill);
+		consume_stripe(m_buffer.data());
+		p_bytes += fill;
+		size -= fill;
+		m_buffer_size = 0;
+	}
+
+	for (; size >= m_buffer.size(); p_bytes += m_buffer.size(), size -= m_buffer.size()) {
+		consume_stripe(p_bytes);
+	}
+
+	if (size > 0)
+		std::memcpy(m_buffer.data(), p_bytes, size);
+
+	m_buffer_size = (uint32_t)size;
+}
+
+uint64_t Hasher::Digest() const {
+	uint64_t h;
+
+	if (m_total_size >= m_buffer.size()) {
+		auto& acc = m_accumulators;
+		h = std::rotl(acc[0], 1) + std::rotl(acc[1], 7) + std::rotl(acc[2], 12) + std::rotl(acc[3], 18);
+		for (auto a : acc) {
+			h = MergeRound(h, a);
+		}
+	}
+	else {
+		h = m_seed + PRIME_5;
+	}
+
+	h += m_total_size;
+
+	const std::byte* p = m_buffer.data();
+	const std::byte* p_end = p + m_buffer_size;
+
+	for (; p + 8 <= p_end; p += 8) {
+		h ^= Round(0, Read64(p));
+		h = std::rotl(h, 27) * PRIME_1 + PRIME_4;
+	}
+
+	if (p + 4 <= p_end) {
+		h ^= (uint64_t)Read32(p) * PRIME_1;
+		h = std::rotl(h, 23) * PRIME_2 + PRIME_3;
+		p += 4;
+	}
+
+	for (; p < p_end; p++) {
+		h ^= (uint64_t)*p * PRIME_5;
+		h = std::rotl(h, 11) * PRIME_1;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME_2;
+	h ^= h >> 29;
+	h *= PRIME_3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+uint64_t Hasher::Hash(const void* p_data, size_t size, uint64_t seed) {
+	Hasher hasher{ seed };
+	hasher.Update(p_data, size);
+	return hasher.Digest();
+}
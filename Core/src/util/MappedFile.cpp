@@ -0,0 +1,98 @@
+#include "pch/pch.h"
+#include "util/MappedFile.h"
+#include "util/util.h"
+
+#if defined (_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SNAKE;
+
+bool MappedFile::Open(const std::string& filepath) {
+	Close();
+
+#if defined (_WIN32)
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		SNK_CORE_ERROR("MappedFile::Open failed, couldn't open '{}' (error {})", filepath, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		SNK_CORE_ERROR("MappedFile::Open failed, '{}' is empty or its size couldn't be read", filepath);
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!mapping) {
+		SNK_CORE_ERROR("MappedFile::Open failed, couldn't create mapping of '{}' (error {})", filepath, GetLastError());
+		CloseHandle(file);
+		return false;
+	}
+
+	void* p_view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!p_view) {
+		SNK_CORE_ERROR("MappedFile::Open failed, couldn't map view of '{}' (error {})", filepath, GetLastError());
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mp_file_handle = file;
+	mp_mapping_handle = mapping;
+	mp_data = reinterpret_cast<std::byte*>(p_view);
+	m_size = (size_t)file_size.QuadPart;
+#else
+	int fd = open(filepath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		SNK_CORE_ERROR("MappedFile::Open failed, couldn't open '{}'", filepath);
+		return false;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+		SNK_CORE_ERROR("MappedFile::Open failed, '{}' is empty or its size couldn't be read", filepath);
+		close(fd);
+		return false;
+	}
+
+	void* p_view = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	// The mapping keeps the file referenced
+	close(fd);
+
+	if (p_view == MAP_FAILED) {
+		SNK_CORE_ERROR("MappedFile::Open failed, couldn't map '{}'", filepath);
+		return false;
+	}
+
+	mp_data = reinterpret_cast<std::byte*>(p_view);
+	m_size = (size_t)file_stat.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close() {
+	if (!mp_data)
+		return;
+
+#if defined (_WIN32)
+	UnmapViewOfFile(mp_data);
+	CloseHandle(mp_mapping_handle);
+	CloseHandle(mp_file_handle);
+#else
+	munmap(mp_data, m_size);
+#endif
+
+	mp_data = nullptr;
+	m_size = 0;
+	mp_file_handle = nullptr;
+	mp_mapping_handle = nullptr;
+}
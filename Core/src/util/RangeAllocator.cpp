@@ -0,0 +1,110 @@
+#include "pch/pch.h"
+#include "util/RangeAllocator.h"
+#include "util/util.h"
+
+namespace SNAKE {
+	void RangeAllocator::Init(uint32_t capacity) {
+		m_free_by_offset.clear();
+		m_free_by_size.clear();
+		m_capacity = capacity;
+		m_used = 0;
+
+		if (capacity > 0)
+			InsertFreeRange(0, capacity);
+	}
+
+	uint32_t RangeAllocator::Allocate(uint32_t count) {
+		if (count == 0)
+			return 0;
+
+		// Smallest free range that fits, the lowest of those with equal size
+		auto size_it = m_free_by_size.lower_bound({ count, 0 });
+		if (size_it == m_free_by_size.end())
+			return INVALID_OFFSET;
+
+		auto [free_count, offset] = *size_it;
+		EraseFreeRange(m_free_by_offset.find(offset));
+
+		if (free_count > count)
+			InsertFreeRange(offset + count, free_count - count);
+
+		m_used += count;
+		return offset;
+	}
+
+	uint32_t RangeAllocator::AllocateBelow(uint32_t count, uint32_t limit) {
+		if (count == 0)
+			return 0;
+
+		for (auto it = m_free_by_offset.begin(); it != m_free_by_offset.end() && it->first + count <= limit; it++) {
+			if (it->second < count)
+				continue;
+
+			uint32_t offset = it->first;
+			uint32_t free_count = it->second;
+			EraseFreeRange(it);
+
+			if (free_count > count)
+				InsertFreeRange(offset + count, free_count - count);
+
+			m_used += count;
+			return offset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void RangeAllocator::Free(uint32_t offset, uint32_t count) {
+		if (count == 0)
+			return;
+
+		SNK_ASSERT(offset + count <= m_capacity);
+		SNK_ASSERT(m_used >= count);
+		m_used -= count;
+
+		// Merge with the free range directly after
+		if (auto next = m_free_by_offset.find(offset + count); next != m_free_by_offset.end()) {
+			count += next->second;
+			EraseFreeRange(next);
+		}
+
+		// Merge with the free range directly before
+		if (auto next = m_free_by_offset.lower_bound(offset); next != m_free_by_offset.begin()) {
+			auto prev = std::prev(next);
+			SNK_DBG_ASSERT(prev->first + prev->second <= offset);
+
+			if (prev->first + prev->second == offset) {
+				offset = prev->first;
+				count += prev->second;
+				EraseFreeRange(prev);
+			}
+		}
+
+		InsertFreeRange(offset, count);
+	}
+
+	void RangeAllocator::Grow(uint32_t new_capacity) {
+		SNK_ASSERT(new_capacity >= m_capacity);
+		if (new_capacity == m_capacity)
+			return;
+
+		uint32_t old_capacity = m_capacity;
+		m_capacity = new_capacity;
+
+		// Free treats the new space as a previously used range, so it's counted as used first
+		m_used += new_capacity - old_capacity;
+		Free(old_capacity, new_capacity - old_capacity);
+	}
+
+	void RangeAllocator::InsertFreeRange(uint32_t offset, uint32_t count) {
+		m_free_by_offset[offset] = count;
+		m_free_by_size.emplace(count, offset);
+	}
+
+	void RangeAllocator::EraseFreeRange(std::map<uint32_t, uint32_t>::iterator it) {
+		[[maybe_unused]] size_t num_erased = m_free_by_size.erase({ it->second, it->first });
+		SNK_DBG_ASSERT(num_erased == 1);
+
+		m_free_by_offset.erase(it);
+	}
+}
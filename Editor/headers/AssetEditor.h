@@ -37,6 +37,9 @@ namespace SNAKE {
 		void OnRequestTextureAssetAddFromFile(const std::string& filepath);
 		bool OnRequestMeshAssetAddFromFile(const std::string& filepath, const std::string& name);
 
+		// True if the materials created by importing 'data' match the existing mesh's, so the import created nothing new
+		static bool ImportedMaterialsMatch(const MeshData& data, const MeshDataAsset& existing);
+
 		bool RenderMaterialEditor();
 
 		VkSceneRenderer renderer;
@@ -56,8 +59,19 @@ namespace SNAKE {
 		bool AddAssetButton();
 		bool RenderBaseAssetEditor();
 
+		// Stops using the cached image of p_asset, it's freed once no frame in flight can be drawing it
+		void DropAssetImage(Asset* p_asset);
+		void FreeRetiredAssetImages();
+
 		std::unordered_map<Asset*, vk::DescriptorSet> asset_images;
 
+		struct RetiredAssetImage {
+			vk::DescriptorSet set;
+			unsigned frame;
+		};
+
+		std::vector<RetiredAssetImage> retired_asset_images;
+
 		EventListener asset_deletion_listener;
 
 		Asset* p_selected_asset = nullptr;
@@ -7,6 +7,8 @@
 #include "util/UI.h"
 #include "util/FileUtil.h"
 #include "assets/AssetLoader.h"
+#include "assets/AssetStreamer.h"
+#include "core/Frametiming.h"
 #include "util/ByteSerializer.h"
 
 #include <backends/imgui_impl_vulkan.h>
@@ -18,8 +20,8 @@ void AssetEditor::Init() {
 	asset_deletion_listener.callback = [this](Event const* _event) {
 		auto* p_casted = dynamic_cast<AssetEvent const*>(_event);
 
-		if (asset_images.contains(p_casted->p_asset))
-			asset_images.erase(p_casted->p_asset);
+		// Also on UPDATED, the cached set was written with an image view that's about to be destroyed
+		DropAssetImage(p_casted->p_asset);
 
 		if (p_selected_asset == p_casted->p_asset)
 			p_selected_asset = nullptr;
@@ -108,7 +110,7 @@ bool AssetEditor::RenderBaseAssetEditor() {
 					// Rename and recreate serialized file to reflect asset name update
 					files::FileCopy(p_selected_asset->filepath, new_path);
 					files::FileDelete(p_selected_asset->filepath);
-					p_selected_asset->filepath = new_path;
+					AssetManager::SetFilepath(p_selected_asset, new_path);
 					SerializeAllAssets();
 				}
 			}
@@ -308,7 +310,8 @@ enum class AssetType {
 
 vk::DescriptorSet AssetEditor::GetOrCreateAssetImage(Asset* _asset) {
 	if (auto* p_asset = dynamic_cast<MaterialAsset*>(_asset)) {
-		if (!p_asset->albedo_tex)
+		// Streamed textures have no image until they're loaded
+		if (!p_asset->albedo_tex || !p_asset->albedo_tex->image.ImageIsCreated())
 			return GetOrCreateAssetImage(AssetManager::GetAssetRaw<Texture2DAsset>(AssetManager::CoreAssetIDs::TEXTURE));
 
 		if (!asset_images.contains(p_asset->albedo_tex.get()))
@@ -317,6 +320,9 @@ vk::DescriptorSet AssetEditor::GetOrCreateAssetImage(Asset* _asset) {
 		return asset_images[p_asset->albedo_tex.get()];
 	}
 	else if (auto* p_asset = dynamic_cast<Texture2DAsset*>(_asset)) {
+		if (!p_asset->image.ImageIsCreated())
+			return GetOrCreateAssetImage(AssetManager::GetAssetRaw<Texture2DAsset>(AssetManager::CoreAssetIDs::TEXTURE));
+
 		if (!asset_images.contains(p_asset))
 			asset_images[p_asset] = ImGui_ImplVulkan_AddTexture(p_asset->image.GetSampler(), p_asset->image.GetImageView(), (VkImageLayout)vk::ImageLayout::eShaderReadOnlyOptimal);
 
@@ -327,15 +333,84 @@ vk::DescriptorSet AssetEditor::GetOrCreateAssetImage(Asset* _asset) {
 	}
 }
 
+void AssetEditor::DropAssetImage(Asset* p_asset) {
+	auto it = asset_images.find(p_asset);
+	if (it == asset_images.end())
+		return;
+
+	retired_asset_images.push_back(RetiredAssetImage{ it->second, FrameTiming::GetFrameCount() });
+	asset_images.erase(it);
+}
+
+void AssetEditor::FreeRetiredAssetImages() {
+	std::erase_if(retired_asset_images, [](const RetiredAssetImage& retired) {
+		if (FrameTiming::GetFrameCount() < retired.frame + MAX_FRAMES_IN_FLIGHT + 1)
+			return false;
+
+		ImGui_ImplVulkan_RemoveTexture(retired.set);
+		return true;
+	});
+}
+
+bool AssetEditor::ImportedMaterialsMatch(const MeshData& data, const MeshDataAsset& existing) {
+	if (data.materials.size() != existing.materials.size())
+		return false;
+
+	for (size_t i = 0; i < data.materials.size(); i++) {
+		auto* p_imported = AssetManager::GetAssetRaw<MaterialAsset>(data.materials[i]);
+		auto* p_existing = existing.materials[i].get();
+		if (p_imported == p_existing)
+			continue;
+
+		if (!p_imported || !p_existing)
+			return false;
+
+		// Textures are deduplicated by content on import, so identical textures are the same asset
+		bool textures_match = p_imported->albedo_tex.get() == p_existing->albedo_tex.get() && p_imported->normal_tex.get() == p_existing->normal_tex.get() &&
+			p_imported->roughness_tex.get() == p_existing->roughness_tex.get() && p_imported->metallic_tex.get() == p_existing->metallic_tex.get() &&
+			p_imported->ao_tex.get() == p_existing->ao_tex.get();
+
+		bool properties_match = p_imported->albedo == p_existing->albedo && p_imported->emissive == p_existing->emissive && p_imported->roughness == p_existing->roughness &&
+			p_imported->metallic == p_existing->metallic && p_imported->ao == p_existing->ao && p_imported->flags == p_existing->flags;
+
+		if (!textures_match || !properties_match)
+			return false;
+	}
+
+	return true;
+}
+
 bool AssetEditor::OnRequestMeshAssetAddFromFile(const std::string& filepath, const std::string& name) {
 	bool ret = false;
 
 	if (!filepath.empty()) {
-		auto mesh_data = AssetManager::CreateAsset<MeshDataAsset>();
-		mesh_data->name = name;
-		mesh_data->filepath = filepath;
-
 		if (auto p_data = AssetLoader::LoadMeshDataFromRawFile(filepath)) {
+			// Re-importing identical geometry and materials reuses the existing asset and its file, the materials this import created are dropped
+			// Identical geometry with different materials gets its own asset, MeshBufferManager still shares the GPU data
+			auto* p_existing = AssetManager::FindAssetByContentHash<MeshDataAsset>(p_data->CalculateContentHash());
+			if (p_existing && ImportedMaterialsMatch(*p_data, *p_existing)) {
+				for (auto mat_uuid : p_data->materials) {
+					if (mat_uuid != AssetManager::CoreAssetIDs::MATERIAL)
+						AssetManager::DeleteAsset(mat_uuid);
+				}
+
+				for (auto tex_uuid : p_data->textures) {
+					AssetManager::DeleteAsset(tex_uuid);
+				}
+
+				std::error_code err;
+				auto file_size = std::filesystem::file_size(p_existing->filepath, err);
+
+				auto& stats = AssetManager::GetContentDedupStats();
+				stats.num_meshes++;
+				stats.disk_bytes_saved += err ? 0 : file_size;
+				SNK_CORE_INFO("Mesh '{}' is identical to already imported mesh '{}', reusing it", filepath, p_existing->name);
+				return true;
+			}
+
+			auto mesh_data = AssetManager::CreateAsset<MeshDataAsset>();
+			mesh_data->name = name;
+			AssetManager::SetFilepath(mesh_data.get(), filepath);
 			AssetManager::Get().mesh_buffer_manager.LoadMeshFromData(mesh_data.get(), *p_data);
 
 			// Serialize the mesh as well as any new textures/materials created from it
@@ -350,14 +425,14 @@ bool AssetEditor::OnRequestMeshAssetAddFromFile(const std::string& filepath, con
 			for (auto tex_uuid : p_data->textures) {
 				auto tex = AssetManager::GetAsset<Texture2DAsset>(tex_uuid);
 				// tex->filepath is still the path to the raw image file, will change to new serialized path after this function
-				AssetLoader::SerializeTexture2DBinaryFromRawFile(p_editor->project.directory + "/res/textures/" + AssetLoader::GenAssetFilename(tex.get(), "tex2d"), *tex.get(), tex->filepath);
+				AssetLoader::SerializeTexture2DBinaryFromRawFile(p_editor->project.directory + "/res/textures/" + AssetLoader::GenAssetFilename(tex.get(), "tex2d"), *tex.get(), tex->filepath,
+					AssetLoader::FindTextureUsage(*tex.get()));
 			}
 
 			AssetLoader::SerializeMeshDataBinary(p_editor->project.directory + "/res/meshes/" + AssetLoader::GenAssetFilename(mesh_data.get(), "meshdata"), *p_data, *mesh_data.get());
 			ret = true;
 		}
 		else {
-			DeleteAsset(mesh_data.get());
 			p_editor->ErrorMessagePopup(std::format("Failed to load mesh file '{}', check logs for more info", filepath));
 		}
 	}
@@ -410,9 +485,7 @@ bool AssetEditor::AddAssetButton() {
 void AssetEditor::DeleteAsset(Asset* p_asset) {
 	SNK_ASSERT(files::PathExists(p_asset->filepath));
 	asset_deletion_queue.push_back(p_asset);
-
-	if (asset_images.contains(p_asset))
-		asset_images.erase(p_asset);
+	DropAssetImage(p_asset);
 
 	files::FileDelete(p_asset->filepath);
 }
@@ -438,13 +511,14 @@ void AssetEditor::SerializeAllAssets() {
 }
 
 void AssetEditor::DeserializeAllAssetsFromActiveProject() {
+	// Textures and mesh data are created from their headers here and load in the background, see AssetStreamer
 	for (const auto& entry : std::filesystem::recursive_directory_iterator(p_editor->project.directory + "/res/textures/")) {
 		std::string path = entry.path().string();
 
 		if (!path.ends_with(".tex2d"))
 			continue;
 
-		AssetLoader::DeserializeTexture2D(path);
+		AssetStreamer::RequestTexture2D(path, AssetStreamer::BACKGROUND);
 	}
 
 	for (const auto& entry : std::filesystem::recursive_directory_iterator(p_editor->project.directory + "/res/materials/")) {
@@ -462,7 +536,7 @@ void AssetEditor::DeserializeAllAssetsFromActiveProject() {
 		if (!path.ends_with(".meshdata"))
 			continue;
 
-		AssetLoader::DeserializeMeshData(path);
+		AssetStreamer::RequestMeshData(path, AssetStreamer::BACKGROUND);
 	}
 
 	for (const auto& entry : std::filesystem::recursive_directory_iterator(p_editor->project.directory + "/res/meshes/")) {
@@ -477,30 +551,32 @@ void AssetEditor::DeserializeAllAssetsFromActiveProject() {
 
 
 void AssetEditor::OnRequestTextureAssetAddFromFile(const std::string& filepath) {
-	static vk::Format load_format = vk::Format::eR8G8B8A8Srgb;
+	static int usage = (int)TextureEncoder::Usage::ALBEDO;
 
 	auto* p_box = p_editor->CreateDialogBox();
 	p_box->block_other_window_input = true;
 	p_box->name = "Texture settings";
 
 	p_box->imgui_render_cb = [filepath, this, p_box] {
-		static bool format_is_srgb = false;
-		format_is_srgb = load_format == vk::Format::eR8G8B8A8Srgb;
 		ImGui::SameLine(ImGui::GetContentRegionAvail().x - 25); if (ImGui::Button("X")) p_box->close = true;
 		ImGui::Text(std::format("Selected file: '{}'", filepath).c_str());
-		if (ImGui::Checkbox("SRGB (select for albedo textures)", &format_is_srgb))
-			load_format = format_is_srgb ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+
+		// Order matches TextureEncoder::Usage, decides the compressed format the texture is stored in
+		const char* usages[] = { "Albedo (sRGB, BC7)", "Normal map (BC5)", "Mask, roughness/metallic/AO (BC1/BC3)" };
+		ImGui::Combo("Usage", &usage, usages, IM_ARRAYSIZE(usages));
 
 		if (ImGui::Button("Load")) {
 			if (!filepath.empty()) {
-				auto tex = AssetManager::CreateAsset<Texture2DAsset>();
-				tex->filepath = filepath;
-				if (!AssetLoader::LoadTextureFromFile(tex, load_format)) {
-					DeleteAsset(tex.get());
+				auto [tex, is_newly_created] = AssetLoader::CreateOrGetTextureFromFile(filepath, (TextureEncoder::Usage)usage);
+				if (!tex) {
 					p_editor->ErrorMessagePopup(std::format("Failed to load texture file '{}', check logs for more info", filepath));
 				}
+				else if (!is_newly_created) {
+					SNK_CORE_INFO("Texture '{}' is identical to already imported texture '{}', reusing it", filepath, tex->name);
+				}
 				else {
-					AssetLoader::SerializeTexture2DBinaryFromRawFile(p_editor->project.directory + "/res/textures/" + AssetLoader::GenAssetFilename(tex.get(), "tex2d"), *tex.get(), filepath);
+					AssetLoader::SerializeTexture2DBinaryFromRawFile(p_editor->project.directory + "/res/textures/" + AssetLoader::GenAssetFilename(tex.get(), "tex2d"), *tex.get(), filepath,
+						(TextureEncoder::Usage)usage);
 				}
 
 			}
@@ -521,6 +597,8 @@ bool AssetEditor::RenderImGui() {
 	}
 	asset_deletion_queue.clear();
 
+	FreeRetiredAssetImages();
+
 	bool ret = false;
 
 	ret |= RenderBaseAssetEditor();
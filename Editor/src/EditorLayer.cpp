@@ -1,3 +1,6 @@
+#include "assets/AssetHotReloader.h"
+#include "assets/AssetStreamer.h"
+#include "assets/TextureResidencyManager.h"
 #include "components/Components.h"
 #include "EditorLayer.h"
 #include "events/EventsCommon.h"
@@ -9,6 +12,7 @@
 #include "scene/SceneInfoBufferSystem.h"
 #include "scene/CameraSystem.h"
 #include "scene/ParticleSystem.h"
+#include "scene/CullingSystem.h"
 #include "scene/TlasSystem.h"
 #include "util/FileUtil.h"
 #include "util/UI.h"
@@ -163,6 +167,12 @@ void EditorLayer::LoadProject(const std::string& project_path) {
 
 		asset_editor.DeserializeAllAssetsFromActiveProject();
 		SceneSerializer::DeserializeScene(project.active_scene_path, scene);
+
+		// Edits made to the project's asset files outside the editor are picked up from here on
+		AssetHotReloader::WatchDirectory(project.directory + "/res");
+
+		// Everything else keeps loading after these
+		AssetStreamer::PrioritiseScene(scene);
 	}
 	catch (std::exception& e) {
 		scene.name = "Unnamed scene";
@@ -867,6 +877,92 @@ void EditorLayer::RendererSettingsWindow() {
 
 		if (ImGui::InputInt("MQP", &m_render_settings.dlss_quality_preset))
 			m_render_settings.realloc_render_resources = true;
+
+		if (auto* p_culling_system = scene.GetSystem<CullingSystem>(); p_culling_system && ImGui::TreeNode("Culling")) {
+			auto& stats = p_culling_system->GetStats();
+			ImGui::Checkbox("Frustum culling", &p_culling_system->enabled);
+			ImGui::Checkbox("Occlusion culling", &p_culling_system->occlusion_enabled);
+			ImGui::Checkbox("LOD selection", &p_culling_system->lod_selection_enabled);
+			ImGui::DragFloat("LOD screen error", &p_culling_system->lod_screen_error, 0.0001f, 0.f, 0.1f, "%.4f");
+			ImGui::Checkbox("Meshlet culling", &p_culling_system->meshlet_culling_enabled);
+			ImGui::Checkbox("Texture streaming requests", &p_culling_system->texture_streaming_requests);
+			ImGui::Text("Draw items tested: %u", stats.num_tested);
+			ImGui::Text("Visible (camera): %u", stats.num_visible[(size_t)CullingSystem::CullView::CAMERA]);
+			ImGui::Text("Visible (directional light): %u", stats.num_visible[(size_t)CullingSystem::CullView::DIR_LIGHT]);
+			ImGui::Text("Occluded (camera): %u", stats.num_occluded[(size_t)CullingSystem::CullView::CAMERA]);
+			ImGui::Text("Occluded (directional light): %u", stats.num_occluded[(size_t)CullingSystem::CullView::DIR_LIGHT]);
+			ImGui::Text("Simplified LODs (camera): %u", stats.num_simplified[(size_t)CullingSystem::CullView::CAMERA]);
+			ImGui::Text("Simplified LODs (directional light): %u", stats.num_simplified[(size_t)CullingSystem::CullView::DIR_LIGHT]);
+			ImGui::Text("Meshlets culled (camera): %u / %u, %u triangles", stats.num_meshlets_culled[(size_t)CullingSystem::CullView::CAMERA],
+				stats.num_meshlets_tested[(size_t)CullingSystem::CullView::CAMERA], stats.num_meshlet_triangles_culled[(size_t)CullingSystem::CullView::CAMERA]);
+			ImGui::Text("Meshlets culled (directional light): %u / %u, %u triangles", stats.num_meshlets_culled[(size_t)CullingSystem::CullView::DIR_LIGHT],
+				stats.num_meshlets_tested[(size_t)CullingSystem::CullView::DIR_LIGHT], stats.num_meshlet_triangles_culled[(size_t)CullingSystem::CullView::DIR_LIGHT]);
+			ImGui::Text("Occluder triangles: %u", stats.num_occluder_triangles);
+			ImGui::Text("Bounds update: %.3fms", stats.bounds_update_ms);
+			ImGui::Text("Cull: %.3fms", stats.cull_ms);
+			ImGui::Text("Occlusion: %.3fms", stats.occlusion_ms);
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNode("Mesh buffers")) {
+			auto& mesh_buffer_manager = AssetManager::Get().mesh_buffer_manager;
+			auto& stats = mesh_buffer_manager.GetStats();
+			auto& vertex_allocator = mesh_buffer_manager.GetVertexAllocator();
+			auto& index_allocator = mesh_buffer_manager.GetIndexAllocator();
+			ImGui::Checkbox("Defragmentation", &mesh_buffer_manager.defragmentation_enabled);
+			ImGui::Text("Vertex format: %s, %u bytes stored per vertex", mesh_buffer_manager.UsesCompactVertexFormat() ? "compact" : "float",
+				mesh_buffer_manager.GetStoredVertexSize());
+			ImGui::Text("Vertex fetch: %u bytes float, %u bytes compact (%.0f%% less)", MeshBufferManager::FLOAT_VERTEX_SIZE, MeshBufferManager::COMPACT_VERTEX_SIZE,
+				100.0 * (1.0 - (double)MeshBufferManager::COMPACT_VERTEX_SIZE / MeshBufferManager::FLOAT_VERTEX_SIZE));
+			ImGui::Text("Meshes: %u", stats.num_meshes);
+			ImGui::Text("Vertices: %u / %u (%u free ranges)", vertex_allocator.GetUsed(), vertex_allocator.GetCapacity(), vertex_allocator.GetNumFreeRanges());
+			ImGui::Text("Indices: %u / %u (%u free ranges)", index_allocator.GetUsed(), index_allocator.GetCapacity(), index_allocator.GetNumFreeRanges());
+			ImGui::Text("Buffer grows: %u (%.2fMB copied)", stats.num_grows, stats.bytes_copied_on_grow / (1024.0 * 1024.0));
+			ImGui::Text("Defragmentation moves: %u", stats.num_defrag_moves);
+			ImGui::Text("Upload batches: %u (%.2fMB staged)", stats.num_upload_batches, stats.bytes_staged / (1024.0 * 1024.0));
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNode("Content deduplication")) {
+			auto& stats = AssetManager::GetContentDedupStats();
+			auto& mesh_stats = AssetManager::Get().mesh_buffer_manager.GetStats();
+			ImGui::Text("Duplicate textures: %u (%.2fMB GPU saved)", stats.num_textures, stats.texture_bytes_saved / (1024.0 * 1024.0));
+			ImGui::Text("Duplicate mesh imports: %u", stats.num_meshes);
+			ImGui::Text("Shared mesh data: %u (%.2fMB GPU saved)", mesh_stats.num_shared_meshes, mesh_stats.bytes_shared / (1024.0 * 1024.0));
+			ImGui::Text("Disk: %.2fMB saved", stats.disk_bytes_saved / (1024.0 * 1024.0));
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNode("Asset streaming")) {
+			auto& stats = AssetStreamer::GetStats();
+			ImGui::Text("Resident: %u / %u (%u pending, %u failed)", stats.num_resident, stats.num_requests, AssetStreamer::GetNumPending(), stats.num_failed);
+			ImGui::Text("Uploaded: %.2fMB", stats.bytes_uploaded / (1024.0 * 1024.0));
+			ImGui::Text("Budget limited frames: %u", stats.num_budget_limited_frames);
+			ImGui::Text("Duplicates merged: %u", stats.num_deduplicated);
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNode("Hot reloading")) {
+			auto& stats = AssetHotReloader::GetStats();
+			auto& mesh_stats = AssetManager::Get().mesh_buffer_manager.GetStats();
+			ImGui::Checkbox("Enabled", &AssetHotReloader::enabled);
+			ImGui::Text("Reloaded: %u (%u unchanged, %u failed)", stats.num_reloaded, stats.num_unchanged, stats.num_failed);
+			ImGui::Text("Meshes reloaded: %u", mesh_stats.num_reloads);
+			ImGui::Text("Uploaded: %.2fMB", stats.bytes_uploaded / (1024.0 * 1024.0));
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNode("Texture residency")) {
+			auto& stats = TextureResidencyManager::GetStats();
+			int budget_mb = (int)(TextureResidencyManager::GetBudget() / (1024 * 1024));
+			if (ImGui::DragInt("Budget (MB)", &budget_mb, 8.f, 16, 16384))
+				TextureResidencyManager::SetBudget((uint64_t)budget_mb * 1024 * 1024);
+
+			ImGui::Text("Resident: %.2fMB across %u textures", stats.resident_bytes / (1024.0 * 1024.0), stats.num_textures);
+			ImGui::Text("Streamed in: %u, evicted: %u, failed: %u", stats.num_streamed_in, stats.num_evicted, stats.num_failed);
+			ImGui::Text("Uploaded: %.2fMB", stats.bytes_uploaded / (1024.0 * 1024.0));
+			ImGui::TreePop();
+		}
 	}
 	ImGui::End();
 }
@@ -118,6 +118,11 @@ bool EntityEditor::StaticMeshCompEditor(StaticMeshComponent* p_comp) {
 		ImGui::EndDragDropTarget();
 	}
 
+	if (bool occluder = p_comp->IsOccluder(); ImGui::Checkbox("Occluder", &occluder)) {
+		p_comp->SetOccluder(occluder);
+		ret = true;
+	}
+
 	ImGui::SeparatorText("Materials");
 	if (ImGui::BeginTable("##materials", (int)p_comp->materials.size(), ImGuiTableFlags_Borders)) {
 		for (uint32_t i = 0; i < p_comp->materials.size(); i++) {
@@ -0,0 +1,149 @@
+#pragma once
+#include "assets/AssetLoader.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+
+namespace SNAKE {
+	struct AssetImportSettings {
+		// Scanned recursively for model files assimp supports and image files
+		std::string source_directory;
+
+		// .meshdata files are written to 'meshes', .mat to 'materials' and .tex2d to 'textures' below it, as in a project's res directory
+		std::string output_directory;
+
+		// Imports every input even if it's unchanged since the last run
+		bool force = false;
+
+		// See AssetLoader::SerializeMeshDataBinary
+		bool compress = false;
+	};
+
+	/*
+	Imports a directory of source models and images to engine asset files without a Vulkan device, nothing is created in AssetManager.
+	Models are imported with AssetLoader::ImportModelFile, each writing a .meshdata and a .mat per material that sets properties,
+	the images their materials reference are encoded to .tex2d for the slot's usage. Images no model references are imported on their own.
+	Imports and writes run in parallel on the JobSystem, which must be initialised.
+
+	MANIFEST_FILENAME in the output directory records each input's content hash and the UUIDs and files it was written to.
+	An input whose hash matches and whose files still exist is skipped, anything imported again keeps its UUIDs so
+	references to it stay valid and a running editor hot reloads it in place.
+	*/
+	class AssetImporter {
+	public:
+		// Returns false if any input failed to import, the manifest is still written for those that succeeded
+		bool Run(const AssetImportSettings& settings);
+
+		inline static const std::string MANIFEST_FILENAME = "import_manifest.json";
+
+		// Written to the manifest, a manifest from another version is ignored so everything is imported again
+		inline static constexpr uint32_t MANIFEST_VERSION = 1;
+
+	private:
+		enum class ImportStatus {
+			IMPORTED,
+			SKIPPED,
+			FAILED,
+		};
+
+		struct TextureKey {
+			// Relative to the source directory, '/' separated
+			std::string source;
+			TextureEncoder::Usage usage = TextureEncoder::Usage::ALBEDO;
+
+			bool operator==(const TextureKey& other) const = default;
+		};
+
+		struct TextureKeyHash {
+			size_t operator()(const TextureKey& key) const {
+				return std::hash<std::string>()(key.source) ^ ((size_t)key.usage << 1);
+			}
+		};
+
+		struct ModelImport {
+			std::string source;
+			uint64_t source_hash = 0;
+			bool read = false;
+			ImportStatus status = ImportStatus::SKIPPED;
+
+			uint64_t mesh_data_uuid = 0;
+
+			// One per model material, AssetManager::CoreAssetIDs::MATERIAL for those that set no properties
+			std::vector<uint64_t> material_uuids;
+			std::vector<TextureKey> textures;
+
+			// Relative to the output directory, the .meshdata file first
+			std::vector<std::string> outputs;
+
+			// Aligned with 'materials', empty for those using the core material
+			std::vector<std::string> material_outputs;
+
+			std::unique_ptr<MeshData> p_data;
+			std::vector<AssetLoader::ImportedMaterial> materials;
+
+			std::chrono::duration<double, std::milli> time{ 0 };
+			uint64_t output_size = 0;
+		};
+
+		struct TextureImport {
+			TextureKey key;
+			uint64_t source_hash = 0;
+			bool read = false;
+			ImportStatus status = ImportStatus::SKIPPED;
+
+			uint64_t uuid = 0;
+			std::string name;
+			std::string output;
+
+			std::chrono::duration<double, std::milli> time{ 0 };
+			uint64_t output_size = 0;
+		};
+
+		void ScanSourceDirectory(std::vector<std::string>& models, std::vector<std::string>& images) const;
+
+		void ReadManifest();
+		void WriteManifest() const;
+
+		// Hashes the file at 'source', seeded with whatever else its output depends on, false if it couldn't be read
+		bool HashSource(const std::string& source, uint64_t seed, uint64_t& hash) const;
+
+		// Run on a worker, fills model.p_data and model.materials
+		void ImportModel(ModelImport& model) const;
+
+		// Gives an imported model's assets their UUIDs and files, keeping those the manifest recorded, and finds the textures it references
+		// Called on the thread running Run as UUID generation isn't thread safe
+		void AssignModelUUIDs(ModelImport& model);
+
+		// Run on a worker, writes the .meshdata and .mat files of an imported model
+		void WriteModel(ModelImport& model) const;
+
+		// Run on a worker, encodes and writes the .tex2d file
+		void ImportTexture(TextureImport& texture) const;
+
+		std::string GetSourcePath(const std::string& source) const;
+		std::string GetOutputPath(const std::string& output) const;
+
+		// True if the manifest recorded 'hash' and every output it lists exists
+		bool IsUpToDate(uint64_t recorded_hash, uint64_t hash, const std::vector<std::string>& outputs) const;
+
+		void ReportResults() const;
+
+		// Replaces anything that isn't alphanumeric, '_' or '-' so names can be used in filenames
+		static std::string SanitiseName(const std::string& name);
+
+		static const char* GetUsageName(TextureEncoder::Usage usage);
+		static TextureEncoder::Usage ParseUsageName(const std::string& name);
+
+		// Usage for an image no model references, guessed from suffixes like "_normal" or "_rough" in its filename
+		static TextureEncoder::Usage GuessImageUsage(const std::string& source);
+
+		AssetImportSettings m_settings;
+
+		// From the previous run
+		nlohmann::json m_manifest;
+
+		std::vector<ModelImport> m_models;
+		std::vector<TextureImport> m_textures;
+
+		std::chrono::duration<double, std::milli> m_total_time{ 0 };
+	};
+}
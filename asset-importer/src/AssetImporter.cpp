@@ -0,0 +1,534 @@
+#include "pch/pch.h"
+#include "AssetImporter.h"
+#include "assets/AssetManager.h"
+#include "core/JobSystem.h"
+#include "util/Hash.h"
+#include "util/FileUtil.h"
+#include <unordered_set>
+
+using namespace SNAKE;
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// Extensions stb_image decodes
+	const std::set<std::string> IMAGE_EXTENSIONS = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".gif", ".hdr", ".pic", ".pnm", ".ppm", ".pgm" };
+
+	constexpr TextureEncoder::Usage USAGES[] = { TextureEncoder::Usage::ALBEDO, TextureEncoder::Usage::NORMAL, TextureEncoder::Usage::MASK };
+
+	std::string ToLower(std::string str) {
+		std::ranges::transform(str, str.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+		return str;
+	}
+
+	// Relative to 'directory', '/' separated so manifests are the same on every platform
+	std::string GetRelativePath(const std::string& path, const std::string& directory) {
+		return std::filesystem::path(path).lexically_normal().lexically_relative(directory).generic_string();
+	}
+}
+
+bool AssetImporter::Run(const AssetImportSettings& settings) {
+	auto start = Clock::now();
+
+	m_settings = settings;
+	m_models.clear();
+	m_textures.clear();
+
+	std::error_code ec;
+	if (!std::filesystem::is_directory(m_settings.source_directory, ec)) {
+		SNK_CORE_ERROR("AssetImporter::Run failed, source directory '{}' doesn't exist", m_settings.source_directory);
+		return false;
+	}
+
+	// Absolute so paths built from the ones assimp gives for textures compare equal
+	m_settings.source_directory = std::filesystem::absolute(m_settings.source_directory).lexically_normal().string();
+	m_settings.output_directory = std::filesystem::absolute(m_settings.output_directory).lexically_normal().string();
+
+	for (const char* p_dir : { "meshes", "materials", "textures" }) {
+		std::filesystem::create_directories(GetOutputPath(p_dir), ec);
+		if (ec) {
+			SNK_CORE_ERROR("AssetImporter::Run failed, couldn't create output directory '{}': '{}'", GetOutputPath(p_dir), ec.message());
+			return false;
+		}
+	}
+
+	ReadManifest();
+
+	std::vector<std::string> model_sources;
+	std::vector<std::string> image_sources;
+	ScanSourceDirectory(model_sources, image_sources);
+
+	for (auto& source : model_sources) {
+		m_models.emplace_back().source = source;
+	}
+
+	// Models are hashed with the settings that change their output
+	JobSystem::ParallelFor((uint32_t)m_models.size(), 1, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			m_models[i].read = HashSource(m_models[i].source, m_settings.compress, m_models[i].source_hash);
+		}
+		});
+
+	auto recorded_models = m_manifest.value("Models", nlohmann::json::object());
+	std::vector<uint32_t> to_import;
+
+	for (uint32_t i = 0; i < m_models.size(); i++) {
+		auto& model = m_models[i];
+		if (!model.read) {
+			model.status = ImportStatus::FAILED;
+			continue;
+		}
+
+		// Assets imported before keep their UUIDs, unchanged models keep the textures they referenced so those are still checked
+		uint64_t recorded_hash = 0;
+		if (auto it = recorded_models.find(model.source); it != recorded_models.end()) {
+			recorded_hash = it->value("SourceHash", 0ull);
+			model.mesh_data_uuid = it->value("MeshDataUUID", 0ull);
+			model.material_uuids = it->value("MaterialUUIDs", std::vector<uint64_t>{});
+			model.outputs = it->value("Outputs", std::vector<std::string>{});
+
+			for (const auto& texture : it->value("Textures", nlohmann::json::array())) {
+				model.textures.push_back(TextureKey{ texture.value("Source", ""), ParseUsageName(texture.value("Usage", "")) });
+			}
+		}
+
+		if (m_settings.force || !IsUpToDate(recorded_hash, model.source_hash, model.outputs))
+			to_import.push_back(i);
+	}
+
+	JobSystem::ParallelFor((uint32_t)to_import.size(), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			ImportModel(m_models[to_import[i]]);
+		}
+		});
+
+	for (auto i : to_import) {
+		if (m_models[i].status != ImportStatus::FAILED)
+			AssignModelUUIDs(m_models[i]);
+	}
+
+	// Every texture a model references, then images no model references with a usage guessed from their name
+	std::unordered_map<TextureKey, uint32_t, TextureKeyHash> texture_indices;
+	std::unordered_set<std::string> referenced_images;
+	for (auto& model : m_models) {
+		if (model.status == ImportStatus::FAILED)
+			continue;
+
+		for (auto& key : model.textures) {
+			if (texture_indices.try_emplace(key, (uint32_t)m_textures.size()).second)
+				m_textures.emplace_back().key = key;
+
+			referenced_images.insert(key.source);
+		}
+	}
+
+	for (auto& source : image_sources) {
+		TextureKey key{ source, GuessImageUsage(source) };
+		if (!referenced_images.contains(source) && texture_indices.try_emplace(key, (uint32_t)m_textures.size()).second)
+			m_textures.emplace_back().key = key;
+	}
+
+	JobSystem::ParallelFor((uint32_t)m_textures.size(), 1, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			m_textures[i].read = HashSource(m_textures[i].key.source, 0, m_textures[i].source_hash);
+		}
+		});
+
+	auto recorded_textures = m_manifest.value("Textures", nlohmann::json::object());
+	std::vector<uint32_t> to_encode;
+
+	for (uint32_t i = 0; i < m_textures.size(); i++) {
+		auto& texture = m_textures[i];
+		if (!texture.read) {
+			texture.status = ImportStatus::FAILED;
+			continue;
+		}
+
+		uint64_t recorded_hash = 0;
+		if (auto it = recorded_textures.find(texture.key.source); it != recorded_textures.end() && it->contains(GetUsageName(texture.key.usage))) {
+			const auto& entry = it->at(GetUsageName(texture.key.usage));
+			recorded_hash = entry.value("SourceHash", 0ull);
+			texture.uuid = entry.value("UUID", 0ull);
+			texture.output = entry.value("Output", "");
+		}
+
+		texture.name = SanitiseName(std::filesystem::path(texture.key.source).stem().string());
+		if (texture.uuid == UUID<uint64_t>::INVALID_UUID)
+			texture.uuid = UUID<uint64_t>()();
+
+		if (texture.output.empty())
+			texture.output = "textures/" + AssetLoader::GenAssetFilename(texture.name, texture.uuid, "tex2d");
+
+		if (m_settings.force || !IsUpToDate(recorded_hash, texture.source_hash, { texture.output }))
+			to_encode.push_back(i);
+	}
+
+	// Texture UUIDs are all known now, so materials can be written while the textures they reference are encoded
+	for (auto i : to_import) {
+		auto& model = m_models[i];
+		if (model.status == ImportStatus::FAILED)
+			continue;
+
+		for (auto& material : model.materials) {
+			if (!material.properties_set)
+				continue;
+
+			for (size_t slot = 0; slot < material.textures.size(); slot++) {
+				auto& load = material.textures[slot];
+				if (load.filepath.empty())
+					continue;
+
+				auto& texture = m_textures[texture_indices.at(TextureKey{ GetRelativePath(load.filepath, m_settings.source_directory), load.usage })];
+				material.contents.texture_uuids[slot] = texture.status == ImportStatus::FAILED ? UUID<uint64_t>::INVALID_UUID : texture.uuid;
+			}
+		}
+
+		for (auto& key : model.textures) {
+			auto& texture = m_textures[texture_indices.at(key)];
+			if (texture.status != ImportStatus::FAILED)
+				model.p_data->textures.push_back(texture.uuid);
+		}
+	}
+
+	// Models and textures are written in one batch so a few large textures don't leave workers idle while models wait
+	struct WriteTask {
+		bool is_texture;
+		uint32_t index;
+	};
+
+	std::vector<WriteTask> tasks;
+	for (auto i : to_import) {
+		if (m_models[i].status != ImportStatus::FAILED)
+			tasks.push_back(WriteTask{ false, i });
+	}
+
+	for (auto i : to_encode) {
+		tasks.push_back(WriteTask{ true, i });
+	}
+
+	JobSystem::ParallelFor((uint32_t)tasks.size(), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (tasks[i].is_texture)
+				ImportTexture(m_textures[tasks[i].index]);
+			else
+				WriteModel(m_models[tasks[i].index]);
+		}
+		});
+
+	WriteManifest();
+
+	m_total_time = Clock::now() - start;
+	ReportResults();
+
+	return std::ranges::none_of(m_models, [](auto& model) { return model.status == ImportStatus::FAILED; }) &&
+		std::ranges::none_of(m_textures, [](auto& texture) { return texture.status == ImportStatus::FAILED; });
+}
+
+void AssetImporter::ScanSourceDirectory(std::vector<std::string>& models, std::vector<std::string>& images) const {
+	Assimp::Importer importer;
+	std::error_code ec;
+
+	for (auto it = std::filesystem::recursive_directory_iterator(m_settings.source_directory, std::filesystem::directory_options::skip_permission_denied, ec);
+		it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+		if (ec)
+			break;
+
+		// The output directory may be inside the source directory
+		if (it->is_directory(ec) && std::filesystem::equivalent(it->path(), m_settings.output_directory, ec)) {
+			it.disable_recursion_pending();
+			continue;
+		}
+
+		if (!it->is_regular_file(ec))
+			continue;
+
+		auto extension = ToLower(it->path().extension().string());
+		auto source = GetRelativePath(it->path().string(), m_settings.source_directory);
+
+		if (IMAGE_EXTENSIONS.contains(extension))
+			images.push_back(std::move(source));
+		else if (!extension.empty() && importer.IsExtensionSupported(extension))
+			models.push_back(std::move(source));
+	}
+
+	std::ranges::sort(models);
+	std::ranges::sort(images);
+}
+
+void AssetImporter::ReadManifest() {
+	m_manifest = nlohmann::json::object();
+
+	auto path = GetOutputPath(MANIFEST_FILENAME);
+	if (!files::PathExists(path))
+		return;
+
+	auto manifest = nlohmann::json::parse(files::ReadTextFile(path), nullptr, false);
+	if (manifest.is_discarded() || !manifest.is_object()) {
+		SNK_CORE_WARN("AssetImporter couldn't parse manifest '{}', importing everything", path);
+		return;
+	}
+
+	if (manifest.value("Version", 0u) != MANIFEST_VERSION) {
+		SNK_CORE_INFO("AssetImporter manifest '{}' is from another version, importing everything", path);
+		return;
+	}
+
+	m_manifest = std::move(manifest);
+}
+
+void AssetImporter::WriteManifest() const {
+	// Entries for inputs that are gone or failed are kept, their files aren't deleted as assets may still reference them
+	auto manifest = m_manifest;
+	manifest["Version"] = MANIFEST_VERSION;
+
+	for (auto& model : m_models) {
+		if (model.status != ImportStatus::IMPORTED)
+			continue;
+
+		auto textures = nlohmann::json::array();
+		for (auto& key : model.textures) {
+			textures.push_back({ { "Source", key.source }, { "Usage", GetUsageName(key.usage) } });
+		}
+
+		manifest["Models"][model.source] = {
+			{ "SourceHash", model.source_hash },
+			{ "MeshDataUUID", model.mesh_data_uuid },
+			{ "MaterialUUIDs", model.material_uuids },
+			{ "Textures", textures },
+			{ "Outputs", model.outputs },
+		};
+	}
+
+	for (auto& texture : m_textures) {
+		if (texture.status != ImportStatus::IMPORTED)
+			continue;
+
+		manifest["Textures"][texture.key.source][GetUsageName(texture.key.usage)] = {
+			{ "SourceHash", texture.source_hash },
+			{ "UUID", texture.uuid },
+			{ "Output", texture.output },
+		};
+	}
+
+	files::WriteTextFile(GetOutputPath(MANIFEST_FILENAME), manifest.dump(4));
+}
+
+bool AssetImporter::HashSource(const std::string& source, uint64_t seed, uint64_t& hash) const {
+	std::vector<std::byte> data;
+	if (!files::ReadBinaryFile(GetSourcePath(source), data))
+		return false;
+
+	hash = Hasher::Hash(data.data(), data.size(), seed);
+	return true;
+}
+
+void AssetImporter::ImportModel(ModelImport& model) const {
+	auto start = Clock::now();
+
+	model.p_data = AssetLoader::ImportModelFile(GetSourcePath(model.source), &model.materials);
+	model.status = model.p_data ? ImportStatus::IMPORTED : ImportStatus::FAILED;
+
+	model.time += Clock::now() - start;
+}
+
+void AssetImporter::AssignModelUUIDs(ModelImport& model) {
+	if (model.mesh_data_uuid == UUID<uint64_t>::INVALID_UUID)
+		model.mesh_data_uuid = UUID<uint64_t>()();
+
+	auto name = SanitiseName(std::filesystem::path(model.source).stem().string());
+	auto previous_outputs = std::move(model.outputs);
+	auto previous_material_uuids = std::move(model.material_uuids);
+
+	model.outputs = { "meshes/" + AssetLoader::GenAssetFilename(name, model.mesh_data_uuid, "meshdata") };
+	model.material_outputs.assign(model.materials.size(), "");
+	model.material_uuids.clear();
+	model.textures.clear();
+
+	// As LoadMeshDataFromRawFile, materials that set no properties use the core material and load none of their textures
+	for (size_t i = 0; i < model.materials.size(); i++) {
+		auto& material = model.materials[i];
+		if (!material.properties_set) {
+			model.material_uuids.push_back(AssetManager::CoreAssetIDs::MATERIAL);
+			continue;
+		}
+
+		// Matched by index, so reordering a model's materials gives them each other's UUIDs
+		uint64_t uuid = i < previous_material_uuids.size() ? previous_material_uuids[i] : UUID<uint64_t>::INVALID_UUID;
+		if (uuid == UUID<uint64_t>::INVALID_UUID || uuid == AssetManager::CoreAssetIDs::MATERIAL)
+			uuid = UUID<uint64_t>()();
+
+		auto material_name = material.contents.name.empty() ? std::format("{}_material{}", name, i) : SanitiseName(name + "_" + material.contents.name);
+		material.contents.name = material_name;
+
+		model.material_uuids.push_back(uuid);
+		model.material_outputs[i] = "materials/" + AssetLoader::GenAssetFilename(material_name, uuid, "mat");
+		model.outputs.push_back(model.material_outputs[i]);
+
+		for (auto& load : material.textures) {
+			TextureKey key{ GetRelativePath(load.filepath, m_settings.source_directory), load.usage };
+			if (!load.filepath.empty() && std::ranges::find(model.textures, key) == model.textures.end())
+				model.textures.push_back(std::move(key));
+		}
+	}
+
+	if (model.material_uuids.empty())
+		model.material_uuids.push_back(AssetManager::CoreAssetIDs::MATERIAL);
+
+	// A renamed material would otherwise leave a second file with its UUID for the project to load
+	for (auto& output : previous_outputs) {
+		if (std::ranges::find(model.outputs, output) == model.outputs.end())
+			files::TryFileDelete(GetOutputPath(output));
+	}
+}
+
+void AssetImporter::WriteModel(ModelImport& model) const {
+	auto start = Clock::now();
+
+	auto& data = *model.p_data;
+	data.materials = model.material_uuids;
+
+	AssetLoader::WriteMeshDataFile(GetOutputPath(model.outputs[0]), data, model.mesh_data_uuid,
+		SanitiseName(std::filesystem::path(model.source).stem().string()), m_settings.compress);
+
+	for (size_t i = 0; i < model.materials.size(); i++) {
+		if (!model.material_outputs[i].empty())
+			AssetLoader::WriteMaterialFile(GetOutputPath(model.material_outputs[i]), model.material_uuids[i], model.materials[i].contents);
+	}
+
+	// Nothing reads the imported data again
+	model.p_data.reset();
+
+	std::error_code ec;
+	for (auto& output : model.outputs) {
+		auto size = std::filesystem::file_size(GetOutputPath(output), ec);
+		model.output_size += ec ? 0 : size;
+	}
+
+	model.time += Clock::now() - start;
+}
+
+void AssetImporter::ImportTexture(TextureImport& texture) const {
+	auto start = Clock::now();
+
+	// Hashed as the editor hashes the image when importing it directly, so it's found as a duplicate of either
+	bool written = AssetLoader::WriteTexture2DFileFromRawFile(GetOutputPath(texture.output), texture.uuid, texture.name, GetSourcePath(texture.key.source),
+		texture.key.usage, TextureEncoder::GetSourceFormat(texture.key.usage));
+
+	texture.status = written ? ImportStatus::IMPORTED : ImportStatus::FAILED;
+
+	std::error_code ec;
+	auto size = std::filesystem::file_size(GetOutputPath(texture.output), ec);
+	texture.output_size = written && !ec ? size : 0;
+
+	texture.time = Clock::now() - start;
+}
+
+std::string AssetImporter::GetSourcePath(const std::string& source) const {
+	return (std::filesystem::path(m_settings.source_directory) / source).string();
+}
+
+std::string AssetImporter::GetOutputPath(const std::string& output) const {
+	return (std::filesystem::path(m_settings.output_directory) / output).string();
+}
+
+bool AssetImporter::IsUpToDate(uint64_t recorded_hash, uint64_t hash, const std::vector<std::string>& outputs) const {
+	if (recorded_hash != hash || outputs.empty())
+		return false;
+
+	return std::ranges::all_of(outputs, [this](const std::string& output) { return !output.empty() && files::PathExists(GetOutputPath(output)); });
+}
+
+void AssetImporter::ReportResults() const {
+	struct Row {
+		const char* p_type;
+		const std::string* p_source;
+		ImportStatus status;
+		double ms;
+		uint64_t output_size;
+	};
+
+	std::vector<Row> rows;
+	for (auto& model : m_models) {
+		rows.push_back(Row{ "Model", &model.source, model.status, model.time.count(), model.output_size });
+	}
+
+	for (auto& texture : m_textures) {
+		rows.push_back(Row{ GetUsageName(texture.key.usage), &texture.key.source, texture.status, texture.time.count(), texture.output_size });
+	}
+
+	// Slowest first, that's what's worth looking at
+	std::ranges::sort(rows, std::greater{}, &Row::ms);
+
+	uint32_t num_imported = 0;
+	uint32_t num_skipped = 0;
+	uint32_t num_failed = 0;
+	double total_asset_ms = 0.0;
+
+	for (auto& row : rows) {
+		total_asset_ms += row.ms;
+
+		if (row.status == ImportStatus::SKIPPED) {
+			num_skipped++;
+			continue;
+		}
+
+		if (row.status == ImportStatus::IMPORTED) {
+			num_imported++;
+			SNK_CORE_INFO("{:>10.2f} ms  {:<7} {:>10} KB  {}", row.ms, row.p_type, row.output_size / 1024, *row.p_source);
+		}
+		else {
+			num_failed++;
+			SNK_CORE_ERROR("{:>10.2f} ms  {:<7} {:>10}     {}", row.ms, row.p_type, "FAILED", *row.p_source);
+		}
+	}
+
+	// Summed asset time over wall time is roughly how many workers were kept busy
+	SNK_CORE_INFO("Imported {} assets, skipped {} unchanged, {} failed in {:.2f} ms ({:.2f} ms of asset work, {:.2f}x parallel)",
+		num_imported, num_skipped, num_failed, m_total_time.count(), total_asset_ms, m_total_time.count() > 0.0 ? total_asset_ms / m_total_time.count() : 0.0);
+}
+
+std::string AssetImporter::SanitiseName(const std::string& name) {
+	std::string sanitised = name;
+	for (auto& c : sanitised) {
+		if (!std::isalnum((unsigned char)c) && c != '_' && c != '-')
+			c = '_';
+	}
+
+	return sanitised.empty() ? "unnamed" : sanitised;
+}
+
+const char* AssetImporter::GetUsageName(TextureEncoder::Usage usage) {
+	switch (usage) {
+	case TextureEncoder::Usage::ALBEDO:
+		return "Albedo";
+	case TextureEncoder::Usage::NORMAL:
+		return "Normal";
+	default:
+		return "Mask";
+	}
+}
+
+TextureEncoder::Usage AssetImporter::ParseUsageName(const std::string& name) {
+	for (auto usage : USAGES) {
+		if (name == GetUsageName(usage))
+			return usage;
+	}
+
+	return TextureEncoder::Usage::ALBEDO;
+}
+
+TextureEncoder::Usage AssetImporter::GuessImageUsage(const std::string& source) {
+	auto stem = ToLower(std::filesystem::path(source).stem().string());
+
+	auto has_suffix = [&](std::initializer_list<const char*> suffixes) {
+		return std::ranges::any_of(suffixes, [&](const char* p_suffix) { return stem.ends_with(std::string("_") + p_suffix); });
+	};
+
+	if (has_suffix({ "normal", "normals", "norm", "nrm", "n" }))
+		return TextureEncoder::Usage::NORMAL;
+
+	if (has_suffix({ "rough", "roughness", "metal", "metallic", "metalness", "ao", "occlusion", "orm", "mask", "height", "disp", "displacement" }))
+		return TextureEncoder::Usage::MASK;
+
+	return TextureEncoder::Usage::ALBEDO;
+}
@@ -0,0 +1,47 @@
+#include "pch/pch.h"
+#include "AssetImporter.h"
+#include "core/JobSystem.h"
+#include "util/Logger.h"
+
+using namespace SNAKE;
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+// Nothing here creates a Vulkan instance or device, the importer runs on machines without a GPU
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	AssetImportSettings settings;
+	std::vector<std::string> directories;
+	bool valid_args = true;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--force")
+			settings.force = true;
+		else if (arg == "--compress")
+			settings.compress = true;
+		else if (arg.starts_with("--"))
+			valid_args = false;
+		else
+			directories.push_back(arg);
+	}
+
+	if (!valid_args || directories.size() != 2) {
+		SNK_CORE_ERROR("Usage: {} <source directory> <output directory> [--force] [--compress]", argc > 0 ? argv[0] : "SNAKE_VK_ASSET_IMPORTER");
+		SNK_CORE_ERROR("  --force        import every input even if it's unchanged since the last run");
+		SNK_CORE_ERROR("  --compress     store .meshdata sections compressed, only worth it for assets read from slow disks");
+		return 1;
+	}
+
+	settings.source_directory = directories[0];
+	settings.output_directory = directories[1];
+
+	JobSystem::Init();
+
+	AssetImporter importer;
+	bool success = importer.Run(settings);
+
+	JobSystem::Shutdown();
+	return success ? 0 : 1;
+}
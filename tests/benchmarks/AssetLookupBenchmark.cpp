@@ -0,0 +1,269 @@
+#include "TestCommon.h"
+#include "assets/AssetManager.h"
+#include "assets/AssetTypeList.h"
+#include <unordered_set>
+
+using namespace SNAKE;
+
+/*
+Indexes 50,000 assets, each with a file on disk, the way AssetManager does and times finding them by path and by type.
+AssetManager needs a device, so its structures are driven directly: AssetTypeList and a multimap keyed by AssetManager::CanonicalisePath.
+The linear scans AssetManager did before, std::filesystem::equivalent against every asset and dynamic_cast of every asset into a vector,
+are timed alongside for comparison.
+Random creation and deletion, core assets included, checks each type list stays consistent with the assets that exist.
+*/
+namespace {
+	constexpr uint32_t NUM_ASSETS = 50'000;
+	constexpr uint32_t NUM_CHURN_OPS = 200'000;
+
+	// Linear path lookups take tens of milliseconds each at NUM_ASSETS, so far fewer are timed
+	constexpr uint32_t NUM_LINEAR_PATH_LOOKUPS = 20;
+	constexpr uint32_t NUM_INDEXED_PATH_LOOKUPS = 20'000;
+	constexpr uint32_t VIEW_REPEATS = 100;
+
+	struct PropAsset : public Asset {
+		using Asset::Asset;
+	};
+
+	struct LightAsset : public Asset {
+		using Asset::Asset;
+	};
+
+	// What AssetManager keeps per asset, minus the content index and handles
+	struct Index {
+		std::unordered_map<uint64_t, Asset*> assets;
+		std::unordered_multimap<std::string, Asset*> path_index;
+		AssetTypeList<PropAsset> props;
+		AssetTypeList<LightAsset> lights;
+
+		template<std::derived_from<Asset> T>
+		AssetTypeList<T>& GetTypeList() {
+			if constexpr (std::same_as<T, PropAsset>)
+				return props;
+			else
+				return lights;
+		}
+
+		template<std::derived_from<Asset> T>
+		T* Create(uint64_t uuid) {
+			auto* p_asset = new T(uuid);
+			assets.emplace(uuid, p_asset);
+			GetTypeList<T>().Add(p_asset, AssetManager::IsCoreAssetUUID(uuid));
+			return p_asset;
+		}
+
+		void SetFilepath(Asset* p_asset, const std::string& filepath) {
+			p_asset->filepath = filepath;
+			path_index.emplace(AssetManager::CanonicalisePath(filepath), p_asset);
+		}
+
+		void Delete(Asset* p_asset) {
+			if (dynamic_cast<PropAsset*>(p_asset))
+				props.Remove(p_asset);
+			else
+				lights.Remove(p_asset);
+
+			assets.erase(p_asset->uuid());
+			delete p_asset;
+		}
+
+		void Clear() {
+			for (auto [uuid, p_asset] : assets) {
+				delete p_asset;
+			}
+
+			assets.clear();
+			path_index.clear();
+			props.assets.clear();
+			props.num_core = 0;
+			lights.assets.clear();
+			lights.num_core = 0;
+		}
+
+		// AssetManager::GetAsset<T>(filepath)
+		template<std::derived_from<Asset> T>
+		T* FindIndexed(const std::string& filepath) const {
+			auto [begin, end] = path_index.equal_range(AssetManager::CanonicalisePath(filepath));
+			for (auto it = begin; it != end; it++) {
+				if (auto* p_casted = dynamic_cast<T*>(it->second))
+					return p_casted;
+			}
+
+			return nullptr;
+		}
+
+		// GetAsset<T>(filepath) before the path index
+		template<std::derived_from<Asset> T>
+		T* FindLinear(const std::string& filepath) const {
+			for (auto [uuid, p_asset] : assets) {
+				if (std::filesystem::equivalent(p_asset->filepath, filepath))
+					return dynamic_cast<T*>(p_asset);
+			}
+
+			return nullptr;
+		}
+
+		// AssetManager::GetView<T, IncludeCoreAssets>
+		template<std::derived_from<Asset> T, bool IncludeCoreAssets>
+		std::span<T* const> View() {
+			auto& list = GetTypeList<T>();
+			std::span<T* const> view = list.assets;
+			if constexpr (!IncludeCoreAssets)
+				view = view.subspan(list.num_core);
+
+			return view;
+		}
+
+		// GetView<T, IncludeCoreAssets> before the type lists
+		template<std::derived_from<Asset> T, bool IncludeCoreAssets>
+		std::vector<T*> ViewLinear() const {
+			std::vector<T*> ret;
+			for (auto [uuid, p_asset] : assets) {
+				if constexpr (!IncludeCoreAssets) {
+					if (AssetManager::IsCoreAssetUUID(uuid))
+						continue;
+				}
+				if (auto* p_casted = dynamic_cast<T*>(p_asset))
+					ret.push_back(p_casted);
+			}
+			return ret;
+		}
+	};
+
+	// Every asset of type T is listed once, core assets first
+	template<std::derived_from<Asset> T>
+	bool IsConsistent(const Index& index, const AssetTypeList<T>& list) {
+		if (list.num_core > list.assets.size())
+			return false;
+
+		std::unordered_set<T*> listed;
+		for (uint32_t i = 0; i < list.assets.size(); i++) {
+			T* p_asset = list.assets[i];
+			auto it = index.assets.find(p_asset->uuid());
+			if (it == index.assets.end() || it->second != p_asset || AssetManager::IsCoreAssetUUID(p_asset->uuid()) != (i < list.num_core))
+				return false;
+
+			listed.insert(p_asset);
+		}
+
+		size_t num_of_type = std::ranges::count_if(index.assets, [](const auto& pair) { return dynamic_cast<T*>(pair.second) != nullptr; });
+		return listed.size() == list.assets.size() && listed.size() == num_of_type;
+	}
+
+	volatile uint64_t visited_sum = 0;
+}
+
+static void TestChurn() {
+	Index index;
+	std::vector<Asset*> live;
+	std::mt19937_64 rng(46);
+	bool consistent = true;
+
+	for (uint32_t i = 0; i < NUM_CHURN_OPS; i++) {
+		if (live.empty() || rng() % 3) {
+			// Core UUIDs are taken and freed again like any other here, so core assets are removed from the front of lists too
+			uint64_t uuid = rng() % 20 == 0 ? 1 + rng() % AssetManager::NUM_CORE_ASSETS : AssetManager::NUM_CORE_ASSETS + 1 + rng() % 1'000'000;
+			if (index.assets.contains(uuid))
+				continue;
+
+			live.push_back(rng() % 2 ? (Asset*)index.Create<PropAsset>(uuid) : (Asset*)index.Create<LightAsset>(uuid));
+		}
+		else {
+			size_t idx = rng() % live.size();
+			index.Delete(live[idx]);
+			live[idx] = live.back();
+			live.pop_back();
+		}
+
+		if (i % 5000 == 0)
+			consistent &= IsConsistent(index, index.props) && IsConsistent(index, index.lights);
+	}
+
+	SNK_CHECK(consistent);
+	SNK_CHECK(IsConsistent(index, index.props) && IsConsistent(index, index.lights));
+
+	for (auto* p_asset : live) {
+		index.Delete(p_asset);
+	}
+	SNK_CHECK(index.props.assets.empty() && index.props.num_core == 0 && index.lights.assets.empty() && index.lights.num_core == 0);
+}
+
+static void BenchmarkLookups() {
+	const std::filesystem::path dir = "asset_lookup_benchmark";
+	std::filesystem::create_directories(dir);
+
+	Index index;
+	std::vector<std::string> paths;
+	for (uint32_t i = 0; i < NUM_ASSETS; i++) {
+		auto path = (dir / ("asset_" + std::to_string(i) + ".bin")).string();
+		std::ofstream(path) << i;
+
+		// The core asset UUIDs are included so views with and without them differ
+		uint64_t uuid = i + 1;
+		Asset* p_asset = i % 2 ? (Asset*)index.Create<PropAsset>(uuid) : (Asset*)index.Create<LightAsset>(uuid);
+		index.SetFilepath(p_asset, path);
+		paths.push_back(path);
+	}
+
+	std::mt19937 rng(7);
+	bool lookups_match = true;
+	for (uint32_t i = 0; i < 10; i++) {
+		auto& path = paths[rng() % NUM_ASSETS];
+		lookups_match &= index.FindIndexed<Asset>(path) == index.FindLinear<Asset>(path) && index.FindIndexed<Asset>(path) != nullptr;
+	}
+	SNK_CHECK(lookups_match);
+
+	// A relative path with redundant components resolves to the same key
+	auto* p_first = index.FindIndexed<LightAsset>((dir / "." / "asset_0.bin").string());
+	SNK_CHECK(p_first && p_first->uuid() == 1);
+	SNK_CHECK(index.FindIndexed<PropAsset>((dir / "missing.bin").string()) == nullptr);
+
+	double linear_ms = Test::TimeMs([&] {
+		for (uint32_t i = 0; i < NUM_LINEAR_PATH_LOOKUPS; i++) {
+			index.FindLinear<Asset>(paths[rng() % NUM_ASSETS]);
+		}
+	});
+	double indexed_ms = Test::TimeMs([&] {
+		for (uint32_t i = 0; i < NUM_INDEXED_PATH_LOOKUPS; i++) {
+			index.FindIndexed<Asset>(paths[rng() % NUM_ASSETS]);
+		}
+	});
+
+	double linear_lookup_us = linear_ms * 1000.0 / NUM_LINEAR_PATH_LOOKUPS;
+	double indexed_lookup_us = indexed_ms * 1000.0 / NUM_INDEXED_PATH_LOOKUPS;
+	SNK_CORE_INFO("Path lookup among {} assets: linear {:.1f} us, indexed {:.2f} us", NUM_ASSETS, linear_lookup_us, indexed_lookup_us);
+	SNK_CHECK(indexed_lookup_us < linear_lookup_us);
+
+	auto prop_view = index.View<PropAsset, false>();
+	auto prop_view_linear = index.ViewLinear<PropAsset, false>();
+	std::unordered_set<PropAsset*> prop_set(prop_view.begin(), prop_view.end());
+	SNK_CHECK(prop_set.size() == prop_view.size() && prop_set == std::unordered_set<PropAsset*>(prop_view_linear.begin(), prop_view_linear.end()));
+	auto lights_with_core = index.View<LightAsset, true>();
+	auto lights_without_core = index.View<LightAsset, false>();
+	SNK_CHECK(index.props.assets.size() == NUM_ASSETS / 2 && lights_with_core.size() - lights_without_core.size() == index.lights.num_core);
+	SNK_CHECK(index.lights.num_core + index.props.num_core == AssetManager::NUM_CORE_ASSETS);
+
+	// The old view was built every call, so it's timed together with walking it
+	auto walk = [](auto&& view) {
+		uint64_t sum = 0;
+		for (auto* p_asset : view) {
+			sum += p_asset->uuid();
+		}
+		visited_sum = sum;
+	};
+
+	double view_linear_ms = Test::TimeMs([&] { walk(index.ViewLinear<PropAsset, false>()); }, VIEW_REPEATS);
+	double view_ms = Test::TimeMs([&] { walk(index.View<PropAsset, false>()); }, VIEW_REPEATS);
+	SNK_CORE_INFO("View of {} assets: built by scanning {:.3f} ms, type list {:.3f} ms", prop_view.size(), view_linear_ms, view_ms);
+	SNK_CHECK(view_ms < view_linear_ms);
+
+	index.Clear();
+	std::filesystem::remove_all(dir);
+}
+
+int main() {
+	Test::Init();
+	TestChurn();
+	BenchmarkLookups();
+	return Test::Finish("ASSET_LOOKUP_BENCHMARK");
+}
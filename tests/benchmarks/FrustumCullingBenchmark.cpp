@@ -0,0 +1,80 @@
+#include "TestCommon.h"
+#include "rendering/FrustumCulling.h"
+#include "util/ExtraMath.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+/*
+Culls 1,000,000 boxes scattered over a 2 km square with FrustumCuller, timing the SSE and scalar paths on one thread and CullParallel
+with the camera alone and with the camera and directional light views CullingSystem culls every frame.
+*/
+namespace {
+	constexpr uint32_t NUM_BOXES = 1'000'000;
+	constexpr uint32_t REPEATS = 10;
+
+	CullingBoundsSoA GenerateBounds() {
+		std::mt19937 rng(27);
+		std::uniform_real_distribution<float> xz_dist(-1000.f, 1000.f);
+		std::uniform_real_distribution<float> y_dist(0.f, 100.f);
+		std::uniform_real_distribution<float> size_dist(0.5f, 5.f);
+
+		CullingBoundsSoA bounds;
+		bounds.Resize(NUM_BOXES);
+		for (uint32_t i = 0; i < NUM_BOXES; i++) {
+			bounds.Set(i, { xz_dist(rng), y_dist(rng), xz_dist(rng) }, { size_dist(rng), size_dist(rng), size_dist(rng) });
+		}
+
+		return bounds;
+	}
+
+	double NsPerBox(double ms, size_t num_views = 1) {
+		return ms * 1e6 / (NUM_BOXES * (double)num_views);
+	}
+}
+
+int main() {
+	Test::Init();
+	JobSystem::Init();
+
+	auto bounds = GenerateBounds();
+
+	auto camera = ExtraMath::ExtractFrustumPlanes(glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 1000.f) *
+		glm::lookAt(glm::vec3{ 0, 20, 0 }, glm::vec3{ 100, 10, 100 }, glm::vec3{ 0, 1, 0 }));
+
+	// Orthographic light covering most of the world, as the directional light's shadow view does
+	auto dir_light = ExtraMath::ExtractFrustumPlanes(glm::ortho(-600.f, 600.f, -600.f, 600.f, 0.1f, 2000.f) *
+		glm::lookAt(glm::vec3{ 500, 800, 500 }, glm::vec3{ 0, 0, 0 }, glm::vec3{ 0, 1, 0 }));
+
+	std::vector<uint32_t> sse_visible, scalar_visible;
+	sse_visible.reserve(NUM_BOXES);
+	scalar_visible.reserve(NUM_BOXES);
+
+	double sse_ms = Test::TimeMs([&] { sse_visible.clear(); FrustumCuller::CullRange(bounds, camera, 0, NUM_BOXES, sse_visible); }, REPEATS);
+	double scalar_ms = Test::TimeMs([&] { scalar_visible.clear(); FrustumCuller::CullRangeScalar(bounds, camera, 0, NUM_BOXES, scalar_visible); }, REPEATS);
+
+	SNK_CORE_INFO("{} boxes, {} visible to the camera", NUM_BOXES, sse_visible.size());
+	SNK_CORE_INFO("One thread: SSE {:.2f} ms ({:.2f} ns/box), scalar {:.2f} ms ({:.2f} ns/box)", sse_ms, NsPerBox(sse_ms), scalar_ms, NsPerBox(scalar_ms));
+	SNK_CHECK(sse_visible == scalar_visible);
+	SNK_CHECK(!sse_visible.empty() && sse_visible.size() < NUM_BOXES);
+
+	std::vector<std::vector<uint32_t>> parallel_visible;
+	std::vector<FrustumPlanes> single_view{ camera };
+	double single_view_ms = Test::TimeMs([&] { FrustumCuller::CullParallel(bounds, single_view, parallel_visible); }, REPEATS);
+	SNK_CHECK(parallel_visible.size() == 1 && parallel_visible[0] == sse_visible);
+
+	std::vector<FrustumPlanes> multi_view{ camera, dir_light };
+	double multi_view_ms = Test::TimeMs([&] { FrustumCuller::CullParallel(bounds, multi_view, parallel_visible); }, REPEATS);
+
+	std::vector<uint32_t> dir_light_visible;
+	FrustumCuller::CullRange(bounds, dir_light, 0, NUM_BOXES, dir_light_visible);
+	SNK_CHECK(parallel_visible.size() == 2 && parallel_visible[0] == sse_visible && parallel_visible[1] == dir_light_visible);
+
+	size_t num_threads = JobSystem::GetThreadIDs().size();
+	SNK_CORE_INFO("CullParallel on {} threads, camera: {:.2f} ms ({:.2f} ns/box)", num_threads, single_view_ms, NsPerBox(single_view_ms));
+	SNK_CORE_INFO("CullParallel on {} threads, camera and directional light ({} visible): {:.2f} ms ({:.2f} ns/box/view)", num_threads,
+		dir_light_visible.size(), multi_view_ms, NsPerBox(multi_view_ms, multi_view.size()));
+
+	JobSystem::Shutdown();
+	return Test::Finish("FRUSTUM_CULLING_BENCHMARK");
+}
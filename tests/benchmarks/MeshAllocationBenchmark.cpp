@@ -0,0 +1,184 @@
+#include "TestCommon.h"
+#include "util/RangeAllocator.h"
+#include "rendering/MeshBufferManager.h"
+
+using namespace SNAKE;
+
+/*
+Loads 1,000 meshes through the allocation policy MeshBufferManager uses, unloads a random half and defragments until the buffers are compact.
+Only RangeAllocator runs as the buffers need a device, bytes the GPU would copy are counted instead.
+Per-mesh resizing, what MeshBufferManager did before sub-allocation, is counted alongside for comparison.
+*/
+namespace {
+	constexpr uint32_t NUM_MESHES = 1000;
+
+	struct Mesh {
+		uint32_t num_vertices;
+		uint32_t num_indices;
+		uint32_t vertex_offset = RangeAllocator::INVALID_OFFSET;
+		uint32_t index_offset = RangeAllocator::INVALID_OFFSET;
+		bool loaded = false;
+	};
+
+	struct PendingRelease {
+		uint32_t vertex_offset = 0;
+		uint32_t num_vertices = 0;
+		uint32_t index_offset = 0;
+		uint32_t num_indices = 0;
+		uint32_t frames_remaining = MAX_FRAMES_IN_FLIGHT;
+	};
+
+	constexpr uint64_t VERTEX_SIZE = MeshBufferManager::FLOAT_VERTEX_SIZE;
+
+	RangeAllocator vertex_allocator;
+	RangeAllocator index_allocator;
+	std::vector<PendingRelease> pending_releases;
+
+	uint64_t bytes_copied_on_grow = 0;
+	uint32_t num_grows = 0;
+
+	uint32_t Allocate(RangeAllocator& allocator, uint32_t count, uint64_t element_size) {
+		uint32_t offset = allocator.Allocate(count);
+		if (offset != RangeAllocator::INVALID_OFFSET)
+			return offset;
+
+		bytes_copied_on_grow += allocator.GetCapacity() * element_size;
+		num_grows++;
+		allocator.Grow(std::max(allocator.GetCapacity() * 2, allocator.GetCapacity() + count));
+		return allocator.Allocate(count);
+	}
+
+	void ProcessPendingReleases() {
+		std::erase_if(pending_releases, [](PendingRelease& release) {
+			if (--release.frames_remaining > 0)
+				return false;
+
+			vertex_allocator.Free(release.vertex_offset, release.num_vertices);
+			index_allocator.Free(release.index_offset, release.num_indices);
+			return true;
+		});
+	}
+
+	// Same planning as MeshBufferManager::Defragment, returns the bytes its copies would move
+	uint64_t Defragment(std::vector<Mesh>& meshes, uint32_t max_moves, uint32_t& num_moves) {
+		uint64_t bytes_moved = 0;
+		auto plan_moves = [&](RangeAllocator& allocator, uint32_t Mesh::* offset_member, uint32_t Mesh::* count_member, uint64_t element_size) {
+			if (allocator.IsCompact())
+				return;
+
+			std::vector<std::pair<uint32_t, Mesh*>> by_offset;
+			for (auto& mesh : meshes) {
+				if (mesh.loaded)
+					by_offset.emplace_back(mesh.*offset_member, &mesh);
+			}
+			std::ranges::sort(by_offset, std::greater{});
+
+			uint32_t moves = 0;
+			for (auto [offset, p_mesh] : by_offset) {
+				if (moves >= max_moves)
+					break;
+
+				uint32_t count = p_mesh->*count_member;
+				uint32_t dst = allocator.AllocateBelow(count, offset);
+				if (dst == RangeAllocator::INVALID_OFFSET)
+					continue;
+
+				p_mesh->*offset_member = dst;
+				pending_releases.push_back(offset_member == &Mesh::vertex_offset ? PendingRelease{ .vertex_offset = offset, .num_vertices = count } :
+					PendingRelease{ .index_offset = offset, .num_indices = count });
+
+				bytes_moved += count * element_size;
+				moves++;
+			}
+
+			num_moves += moves;
+		};
+
+		plan_moves(vertex_allocator, &Mesh::vertex_offset, &Mesh::num_vertices, VERTEX_SIZE);
+		plan_moves(index_allocator, &Mesh::index_offset, &Mesh::num_indices, sizeof(unsigned));
+		return bytes_moved;
+	}
+}
+
+int main() {
+	Test::Init();
+
+	std::mt19937 rng(31);
+	std::vector<Mesh> meshes;
+	for (uint32_t i = 0; i < NUM_MESHES; i++) {
+		// Mostly small props with the odd large mesh
+		uint32_t num_vertices = 256 + rng() % (rng() % 10 == 0 ? 200'000 : 8'000);
+		meshes.push_back(Mesh{ num_vertices, num_vertices * 3 });
+	}
+
+	vertex_allocator.Init(MeshBufferManager::INITIAL_VERTEX_CAPACITY);
+	index_allocator.Init(MeshBufferManager::INITIAL_INDEX_CAPACITY);
+
+	uint64_t bytes_loaded = 0;
+	double load_ms = Test::TimeMs([&] {
+		for (auto& mesh : meshes) {
+			mesh.vertex_offset = Allocate(vertex_allocator, mesh.num_vertices, VERTEX_SIZE);
+			mesh.index_offset = Allocate(index_allocator, mesh.num_indices, sizeof(unsigned));
+			mesh.loaded = true;
+			bytes_loaded += mesh.num_vertices * VERTEX_SIZE + mesh.num_indices * sizeof(unsigned);
+		}
+	});
+
+	// Resizing to fit every mesh copies everything loaded before it
+	uint64_t bytes_copied_per_mesh_resize = 0;
+	uint64_t bytes_so_far = 0;
+	for (auto& mesh : meshes) {
+		bytes_copied_per_mesh_resize += bytes_so_far;
+		bytes_so_far += mesh.num_vertices * VERTEX_SIZE + mesh.num_indices * sizeof(unsigned);
+	}
+
+	SNK_CORE_INFO("Loaded {} meshes, {:.1f} MB in {:.3f} ms", NUM_MESHES, bytes_loaded / 1e6, load_ms);
+	SNK_CORE_INFO("Grows: {}, copied {:.1f} MB, per-mesh resizing would copy {:.1f} MB", num_grows, bytes_copied_on_grow / 1e6, bytes_copied_per_mesh_resize / 1e6);
+	SNK_CHECK(bytes_copied_on_grow < bytes_loaded * 2);
+
+	std::vector<uint32_t> unload_order(NUM_MESHES);
+	std::iota(unload_order.begin(), unload_order.end(), 0);
+	std::ranges::shuffle(unload_order, rng);
+	for (uint32_t i = 0; i < NUM_MESHES / 2; i++) {
+		auto& mesh = meshes[unload_order[i]];
+		mesh.loaded = false;
+		pending_releases.push_back(PendingRelease{ mesh.vertex_offset, mesh.num_vertices, mesh.index_offset, mesh.num_indices });
+	}
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		ProcessPendingReleases();
+	}
+
+	SNK_CORE_INFO("Unloaded {} meshes, {} free vertex ranges and {} free index ranges", NUM_MESHES / 2, vertex_allocator.GetNumFreeRanges(), index_allocator.GetNumFreeRanges());
+
+	// One pass per frame start as in MeshBufferManager, until nothing more can move
+	uint32_t num_frames = 0;
+	uint32_t num_moves = 0;
+	uint64_t bytes_moved = 0;
+	double plan_ms = 0;
+	double slowest_plan_ms = 0;
+	for (uint32_t idle_frames = 0; idle_frames <= MAX_FRAMES_IN_FLIGHT; num_frames++) {
+		ProcessPendingReleases();
+
+		uint64_t frame_bytes = 0;
+		double ms = Test::TimeMs([&] { frame_bytes = Defragment(meshes, MeshBufferManager::DEFRAG_MOVES_PER_FRAME, num_moves); });
+		plan_ms += ms;
+		slowest_plan_ms = std::max(slowest_plan_ms, ms);
+		bytes_moved += frame_bytes;
+		idle_frames = frame_bytes == 0 && pending_releases.empty() ? idle_frames + 1 : 0;
+	}
+
+	SNK_CORE_INFO("Defragmented in {} frames, {} moves copying {:.1f} MB", num_frames, num_moves, bytes_moved / 1e6);
+	SNK_CORE_INFO("Planning took {:.3f} ms in total, {:.3f} ms at most in one frame", plan_ms, slowest_plan_ms);
+	SNK_CORE_INFO("Vertex free ranges: {}, largest {}, index free ranges: {}, largest {}", vertex_allocator.GetNumFreeRanges(), vertex_allocator.GetLargestFreeRange(),
+		index_allocator.GetNumFreeRanges(), index_allocator.GetLargestFreeRange());
+
+	uint32_t used_vertices = 0;
+	for (auto& mesh : meshes) {
+		if (mesh.loaded)
+			used_vertices += mesh.num_vertices;
+	}
+	SNK_CHECK(vertex_allocator.GetUsed() == used_vertices);
+
+	return Test::Finish("MESH_ALLOCATION_BENCHMARK");
+}
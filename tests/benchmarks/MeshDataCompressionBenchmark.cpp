@@ -0,0 +1,154 @@
+#include "TestCommon.h"
+#include "assets/AssetLoader.h"
+#include "assets/MeshletBuilder.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+/*
+Writes a generated mesh as .meshdata with and without compressed sections and times loading both with AssetLoader::ReadMeshDataFile.
+Files are read from the page cache, so a cold load at a given disk bandwidth is estimated by adding the time to read each file's size.
+Compression only pays off where the disk read it saves outweighs decompressing, which is why AssetImporter leaves it off by default.
+*/
+namespace {
+	constexpr uint32_t GRID_SIZE = 1024;
+	constexpr uint32_t LOAD_REPEATS = 15;
+
+	// Sphere-like grid of GRID_SIZE^2 vertices, 'shuffled' scatters vertex order and adds noise, the worst case for compression
+	std::unique_ptr<MeshData> GenerateMesh(bool shuffled) {
+		auto p_data = std::make_unique<MeshData>();
+		auto& data = *p_data;
+		data.num_vertices = GRID_SIZE * GRID_SIZE;
+		data.num_indices = (GRID_SIZE - 1) * (GRID_SIZE - 1) * 6;
+		data.positions = new aiVector3D[data.num_vertices];
+		data.normals = new aiVector3D[data.num_vertices];
+		data.tangents = new aiVector3D[data.num_vertices];
+		data.tex_coords = new aiVector2D[data.num_vertices];
+		data.indices = new unsigned[data.num_indices];
+		data.submeshes.push_back(Submesh{ data.num_indices, data.num_vertices, 0, 0, 0 });
+		data.materials.push_back(0);
+
+		std::mt19937 rng(5);
+		std::vector<unsigned> remap(data.num_vertices);
+		std::iota(remap.begin(), remap.end(), 0);
+		if (shuffled)
+			std::ranges::shuffle(remap, rng);
+
+		for (uint32_t y = 0; y < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x < GRID_SIZE; x++) {
+				float u = x / float(GRID_SIZE - 1);
+				float v = y / float(GRID_SIZE - 1);
+				float theta = u * glm::two_pi<float>();
+				float phi = v * glm::pi<float>();
+				float radius = 1.f + 0.05f * glm::sin(theta * 9.f) * glm::cos(phi * 7.f) + (shuffled ? 0.002f * (rng() / float(UINT32_MAX)) : 0.f);
+
+				unsigned i = remap[y * GRID_SIZE + x];
+				data.normals[i] = { glm::sin(phi) * glm::cos(theta), glm::cos(phi), glm::sin(phi) * glm::sin(theta) };
+				data.positions[i] = { data.normals[i].x * radius, data.normals[i].y * radius, data.normals[i].z * radius };
+				data.tangents[i] = { -glm::sin(theta), 0.f, glm::cos(theta) };
+				data.tex_coords[i] = { u, v };
+			}
+		}
+
+		unsigned* p_index = data.indices;
+		for (uint32_t y = 0; y + 1 < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x + 1 < GRID_SIZE; x++) {
+				unsigned a = remap[y * GRID_SIZE + x], b = remap[y * GRID_SIZE + x + 1];
+				unsigned c = remap[(y + 1) * GRID_SIZE + x], d = remap[(y + 1) * GRID_SIZE + x + 1];
+				for (unsigned idx : { a, c, b, b, c, d }) {
+					*p_index++ = idx;
+				}
+			}
+		}
+
+		MeshletBuilder::BuildMeshlets(data);
+		return p_data;
+	}
+
+	bool Load(const std::string& filepath, MeshData& data) {
+		auto p_file = std::make_unique<MappedFile>();
+		if (!p_file->Open(filepath))
+			return false;
+
+		uint64_t uuid;
+		std::string name;
+		return AssetLoader::ReadMeshDataFile(std::move(p_file), filepath, data, uuid, name);
+	}
+
+	// Reads a byte of every cache line of the streams, standing in for the staging copy so mapped pages are actually read
+	uint64_t TouchStreams(const MeshData& data) {
+		uint64_t sum = 0;
+		auto touch = [&](const void* p_data, size_t size) {
+			auto* p_bytes = static_cast<const uint8_t*>(p_data);
+			for (size_t i = 0; i < size; i += 64) {
+				sum += p_bytes[i];
+			}
+		};
+
+		touch(data.positions, data.num_vertices * sizeof(aiVector3D));
+		touch(data.normals, data.num_vertices * sizeof(aiVector3D));
+		touch(data.tangents, data.num_vertices * sizeof(aiVector3D));
+		touch(data.tex_coords, data.num_vertices * sizeof(aiVector2D));
+		touch(data.indices, data.num_indices * sizeof(unsigned));
+		return sum;
+	}
+
+	bool StreamsEqual(const MeshData& a, const MeshData& b) {
+		return a.num_vertices == b.num_vertices && a.num_indices == b.num_indices &&
+			std::memcmp(a.positions, b.positions, a.num_vertices * sizeof(aiVector3D)) == 0 &&
+			std::memcmp(a.normals, b.normals, a.num_vertices * sizeof(aiVector3D)) == 0 &&
+			std::memcmp(a.tangents, b.tangents, a.num_vertices * sizeof(aiVector3D)) == 0 &&
+			std::memcmp(a.tex_coords, b.tex_coords, a.num_vertices * sizeof(aiVector2D)) == 0 &&
+			std::memcmp(a.indices, b.indices, a.num_indices * sizeof(unsigned)) == 0 &&
+			a.meshlets.size() == b.meshlets.size() && std::memcmp(a.meshlets.data(), b.meshlets.data(), a.meshlets.size() * sizeof(Meshlet)) == 0;
+	}
+
+	volatile uint64_t touched_sum = 0;
+}
+
+static void BenchmarkMesh(const char* p_name, bool shuffled) {
+	auto p_data = GenerateMesh(shuffled);
+	const std::string raw_path = "compression_benchmark_raw.meshdata";
+	const std::string compressed_path = "compression_benchmark_compressed.meshdata";
+
+	double raw_write_ms = Test::TimeMs([&] { AssetLoader::WriteMeshDataFile(raw_path, *p_data, 1, "benchmark", false); }, 3);
+	double compressed_write_ms = Test::TimeMs([&] { AssetLoader::WriteMeshDataFile(compressed_path, *p_data, 1, "benchmark", true); }, 3);
+
+	size_t num_decompressed_sections = 0;
+	{
+		MeshData raw, compressed;
+		SNK_CHECK(Load(raw_path, raw) && StreamsEqual(*p_data, raw));
+		SNK_CHECK(Load(compressed_path, compressed) && StreamsEqual(*p_data, compressed));
+		num_decompressed_sections = compressed.decompressed_sections.size();
+	}
+
+	double raw_load_ms = Test::TimeMs([&] { MeshData data; Load(raw_path, data); touched_sum = TouchStreams(data); }, LOAD_REPEATS);
+	double compressed_load_ms = Test::TimeMs([&] { MeshData data; Load(compressed_path, data); touched_sum = TouchStreams(data); }, LOAD_REPEATS);
+
+	double raw_mb = std::filesystem::file_size(raw_path) / 1e6;
+	double compressed_mb = std::filesystem::file_size(compressed_path) / 1e6;
+
+	SNK_CORE_INFO("[{}] raw {:.2f} MB, compressed {:.2f} MB ({:.1f}%), {} sections decompressed", p_name, raw_mb, compressed_mb, 100.0 * compressed_mb / raw_mb,
+		num_decompressed_sections);
+	SNK_CORE_INFO("  write: raw {:.2f} ms, compressed {:.2f} ms", raw_write_ms, compressed_write_ms);
+	SNK_CORE_INFO("  warm load: raw {:.2f} ms, compressed {:.2f} ms", raw_load_ms, compressed_load_ms);
+
+	for (double disk_mb_per_s : { 100.0, 500.0, 3000.0 }) {
+		SNK_CORE_INFO("  estimated cold load at {:.0f} MB/s: raw {:.1f} ms, compressed {:.1f} ms", disk_mb_per_s, raw_load_ms + raw_mb / disk_mb_per_s * 1000.0,
+			compressed_load_ms + compressed_mb / disk_mb_per_s * 1000.0);
+	}
+
+	std::filesystem::remove(raw_path);
+	std::filesystem::remove(compressed_path);
+}
+
+int main() {
+	Test::Init();
+	JobSystem::Init();
+
+	BenchmarkMesh("optimised vertex order", false);
+	BenchmarkMesh("shuffled vertex order", true);
+
+	JobSystem::Shutdown();
+	return Test::Finish("MESH_DATA_COMPRESSION_BENCHMARK");
+}
@@ -0,0 +1,96 @@
+#include "TestCommon.h"
+#include "rendering/OcclusionCulling.h"
+#include "util/ExtraMath.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+/*
+Rasterises 400 building sized box occluders into a 320x180 OcclusionBuffer, CullingSystem's camera resolution, and tests the frustum
+visible share of 100,000 prop sized boxes against it, timing each stage the way CullingSystem's occlusion job runs them every frame.
+*/
+namespace {
+	constexpr uint32_t NUM_OCCLUDERS = 400;
+	constexpr uint32_t NUM_INSTANCES = 100'000;
+	constexpr glm::uvec2 RESOLUTION{ 320, 180 };
+	constexpr uint32_t REPEATS = 20;
+
+	// Unit cube, [-1, 1] on every axis
+	const std::vector<glm::vec3> BOX_POSITIONS{ { -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 }, { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } };
+	const std::vector<uint32_t> BOX_INDICES{ 0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5 };
+
+	// Buildings on a 20x20 grid of 40 unit blocks
+	std::vector<glm::mat4> GenerateOccluders(std::mt19937& rng) {
+		std::uniform_real_distribution<float> width_dist(5.f, 15.f);
+		std::uniform_real_distribution<float> height_dist(10.f, 40.f);
+
+		std::vector<glm::mat4> transforms;
+		for (uint32_t i = 0; i < NUM_OCCLUDERS; i++) {
+			glm::vec3 half_size{ width_dist(rng), height_dist(rng), width_dist(rng) };
+			glm::vec3 center{ (i % 20) * 40.f - 380.f, half_size.y, (i / 20) * 40.f - 380.f };
+			transforms.push_back(glm::scale(glm::translate(glm::mat4(1.f), center), half_size));
+		}
+
+		return transforms;
+	}
+
+	// Props scattered over the streets and between the buildings
+	CullingBoundsSoA GenerateInstances(std::mt19937& rng) {
+		std::uniform_real_distribution<float> xz_dist(-400.f, 400.f);
+		std::uniform_real_distribution<float> y_dist(0.f, 5.f);
+		std::uniform_real_distribution<float> size_dist(0.25f, 2.f);
+
+		CullingBoundsSoA bounds;
+		bounds.Resize(NUM_INSTANCES);
+		for (uint32_t i = 0; i < NUM_INSTANCES; i++) {
+			bounds.Set(i, { xz_dist(rng), y_dist(rng), xz_dist(rng) }, { size_dist(rng), size_dist(rng), size_dist(rng) });
+		}
+
+		return bounds;
+	}
+}
+
+int main() {
+	Test::Init();
+	JobSystem::Init();
+
+	std::mt19937 rng(28);
+	auto occluders = GenerateOccluders(rng);
+	auto bounds = GenerateInstances(rng);
+
+	// Street level camera at the edge of the city looking down a street between two columns of buildings
+	auto proj_view = glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 1000.f) *
+		glm::lookAt(glm::vec3{ -360, 2, -420 }, glm::vec3{ -300, 2, 0 }, glm::vec3{ 0, 1, 0 });
+
+	std::vector<uint32_t> frustum_visible;
+	FrustumCuller::CullRange(bounds, ExtraMath::ExtractFrustumPlanes(proj_view), 0, NUM_INSTANCES, frustum_visible);
+
+	OcclusionBuffer buffer;
+	buffer.Init(RESOLUTION.x, RESOLUTION.y);
+
+	double setup_ms = Test::TimeMs([&] {
+		buffer.Clear();
+		for (auto& transform : occluders) {
+			buffer.AddOccluder(proj_view * transform, BOX_POSITIONS, BOX_INDICES);
+		}
+	}, REPEATS);
+	double rasterize_ms = Test::TimeMs([&] { buffer.Rasterize(); }, REPEATS);
+
+	std::vector<uint32_t> unoccluded;
+	double test_ms = Test::TimeMs([&] { unoccluded.clear(); buffer.TestVisible(bounds, proj_view, frustum_visible, unoccluded); }, REPEATS);
+
+	size_t num_threads = JobSystem::GetThreadIDs().size();
+	SNK_CORE_INFO("{}x{} buffer, {} occluder triangles on screen, {} threads", buffer.GetWidth(), buffer.GetHeight(), buffer.GetNumTriangles(), num_threads);
+	SNK_CORE_INFO("Clear + AddOccluder {:.3f} ms, Rasterize {:.3f} ms", setup_ms, rasterize_ms);
+	SNK_CORE_INFO("TestVisible: {} of {} frustum visible instances occluded in {:.3f} ms ({:.1f} ns/instance)", frustum_visible.size() - unoccluded.size(),
+		frustum_visible.size(), test_ms, test_ms * 1e6 / glm::max(frustum_visible.size(), (size_t)1));
+	SNK_CORE_INFO("Occlusion total {:.3f} ms", setup_ms + rasterize_ms + test_ms);
+
+	// Buildings hide a good share of what the frustum lets through, never anything outside it
+	SNK_CHECK(buffer.GetNumTriangles() > 0);
+	SNK_CHECK(!unoccluded.empty() && unoccluded.size() < frustum_visible.size() / 2);
+	SNK_CHECK(std::ranges::includes(frustum_visible, unoccluded));
+
+	JobSystem::Shutdown();
+	return Test::Finish("OCCLUSION_CULLING_BENCHMARK");
+}
@@ -0,0 +1,160 @@
+#include "TestCommon.h"
+#include "scene/SceneSnapshotSystem.h"
+#include "scene/TransformBufferSystem.h"
+#include "components/Components.h"
+
+using namespace SNAKE;
+
+/*
+Builds a scene of 100,000 StaticMeshComponents and times SceneSnapshotSystem's frame start snapshot with no changes, with a single instance
+added, removed and given a new material each frame, and rebuilding the draw list from the whole scene as it was before the persistent batches.
+AssetManager isn't initialised, so assets are created without GPU resources and no system but SceneSnapshotSystem listens to the scene.
+Materials aren't registered with the global material buffer without a device, so they share a buffer index and batches differ by mesh only.
+*/
+namespace {
+	constexpr uint32_t NUM_INSTANCES = 100'000;
+	constexpr uint32_t NUM_MESHES = 1'000;
+	constexpr uint32_t NUM_MATERIALS = 8;
+	constexpr uint32_t STEADY_FRAMES = 1'000;
+	constexpr uint32_t CHURN_FRAMES = 100;
+
+	uint32_t next_transform_idx = 0;
+
+	void FrameStart() {
+		EventManagerG::DispatchEvent(FrameStartEvent{});
+	}
+
+	Entity* AddMeshEntity(Scene& scene, AssetRef<StaticMeshAsset> mesh) {
+		auto& ent = scene.CreateEntity();
+
+		// Normally added by TransformBufferSystem, which needs a device
+		ent.AddComponent<TransformBufferIdxComponent>(next_transform_idx++);
+		ent.AddComponent<StaticMeshComponent>()->SetMeshAsset(mesh);
+		return &ent;
+	}
+
+	// Every instance with a mesh is in exactly one range, the range of its mesh, with its own transform index
+	bool IsSnapshotConsistent(const SceneSnapshotData& snapshot, size_t num_mesh_entities) {
+		if (snapshot.static_mesh_data.size() != num_mesh_entities)
+			return false;
+
+		uint32_t next_start_idx = 0;
+		for (const auto& range : snapshot.mesh_ranges) {
+			if (range.start_idx != next_start_idx)
+				return false;
+
+			for (uint32_t i = range.start_idx; i < range.start_idx + range.count; i++) {
+				auto* p_ent = snapshot.static_mesh_data[i].p_entity;
+				auto* p_mesh = p_ent->GetComponent<StaticMeshComponent>();
+				if (!p_mesh || AssetManager::GetHandle(p_mesh->GetMeshAsset()) != range.mesh ||
+					snapshot.static_mesh_data[i].transform_buffer_idx != p_ent->GetComponent<TransformBufferIdxComponent>()->idx)
+					return false;
+			}
+
+			next_start_idx += range.count;
+		}
+
+		return next_start_idx == num_mesh_entities;
+	}
+}
+
+int main() {
+	Test::Init();
+
+	std::vector<AssetRef<MaterialAsset>> materials;
+	for (uint32_t i = 0; i < NUM_MATERIALS; i++) {
+		materials.push_back(AssetManager::CreateAsset<MaterialAsset>(i == 0 ? (uint64_t)AssetManager::MATERIAL : 0));
+	}
+
+	// StaticMeshComponent starts out with the core sphere mesh
+	auto create_mesh = [&](uint64_t uuid, uint64_t data_uuid, AssetRef<MaterialAsset> material) {
+		auto mesh = AssetManager::CreateAsset<StaticMeshAsset>(uuid);
+		mesh->data = AssetManager::CreateAsset<MeshDataAsset>(data_uuid);
+		mesh->data->materials.push_back(material);
+		return mesh;
+	};
+
+	create_mesh(AssetManager::SPHERE_MESH, AssetManager::SPHERE_MESH_DATA, materials[0]);
+
+	std::vector<AssetRef<StaticMeshAsset>> meshes;
+	for (uint32_t i = 0; i < NUM_MESHES; i++) {
+		meshes.push_back(create_mesh(0, 0, materials[i % NUM_MATERIALS]));
+	}
+
+	std::mt19937 rng(26);
+	std::vector<Entity*> mesh_entities;
+	{
+		Scene scene;
+		scene.RegisterComponent<StaticMeshComponent>();
+
+		for (uint32_t i = 0; i < NUM_INSTANCES; i++) {
+			mesh_entities.push_back(AddMeshEntity(scene, meshes[rng() % NUM_MESHES]));
+		}
+
+		SceneSnapshotSystem* p_system = nullptr;
+		double initial_ms = Test::TimeMs([&] {
+			p_system = scene.AddSystem<SceneSnapshotSystem>();
+			FrameStart();
+		});
+
+		const auto& snapshot = p_system->GetSnapshotData();
+		SNK_CORE_INFO("Initial snapshot of {} instances in {} ranges: {:.2f} ms", snapshot.static_mesh_data.size(), snapshot.mesh_ranges.size(), initial_ms);
+		SNK_CHECK(IsSnapshotConsistent(snapshot, mesh_entities.size()));
+
+		// Nothing changed, the snapshot isn't rebuilt
+		uint64_t version = snapshot.version;
+		double steady_ms = Test::TimeMs([&] {
+			for (uint32_t i = 0; i < STEADY_FRAMES; i++) {
+				FrameStart();
+			}
+		}) / STEADY_FRAMES;
+		SNK_CORE_INFO("Steady state frame start: {:.5f} ms", steady_ms);
+		SNK_CHECK(snapshot.version == version);
+
+		// One instance added, one removed and one given a different material every frame
+		double events_ms = 0.0;
+		double snapshot_ms = 0.0;
+		bool churn_consistent = true;
+		for (uint32_t frame = 0; frame < CHURN_FRAMES; frame++) {
+			events_ms += Test::TimeMs([&] {
+				mesh_entities.push_back(AddMeshEntity(scene, meshes[rng() % NUM_MESHES]));
+
+				size_t removed_idx = rng() % mesh_entities.size();
+				mesh_entities[removed_idx]->RemoveComponent<StaticMeshComponent>();
+				mesh_entities[removed_idx] = mesh_entities.back();
+				mesh_entities.pop_back();
+
+				mesh_entities[rng() % mesh_entities.size()]->GetComponent<StaticMeshComponent>()->SetMaterial(0, materials[rng() % NUM_MATERIALS]);
+			});
+
+			snapshot_ms += Test::TimeMs(FrameStart);
+
+			if (frame % 10 == 0)
+				churn_consistent &= IsSnapshotConsistent(snapshot, mesh_entities.size());
+		}
+
+		events_ms /= CHURN_FRAMES;
+		snapshot_ms /= CHURN_FRAMES;
+		SNK_CORE_INFO("Churn per frame: events {:.4f} ms, snapshot {:.3f} ms", events_ms, snapshot_ms);
+		SNK_CHECK(churn_consistent && IsSnapshotConsistent(snapshot, mesh_entities.size()));
+		SNK_CHECK(snapshot.version == version + CHURN_FRAMES);
+
+		// Every instance regrouped from the scene, what each frame cost before the persistent draw list
+		size_t rebuilt_size = 0;
+		double rebuild_ms = Test::TimeMs([&] {
+			SceneSnapshotSystem rebuilt;
+			rebuilt.p_scene = &scene;
+			rebuilt.OnSystemAdd();
+			FrameStart();
+			rebuilt_size = rebuilt.GetSnapshotData().static_mesh_data.size();
+			rebuilt.OnSystemRemove();
+		}, 3);
+
+		SNK_CORE_INFO("Full rebuild: {:.2f} ms", rebuild_ms);
+		SNK_CHECK(rebuilt_size == mesh_entities.size());
+		SNK_CHECK(steady_ms < rebuild_ms / 100.0);
+		SNK_CHECK(events_ms + snapshot_ms < rebuild_ms);
+	}
+
+	return Test::Finish("SCENE_SNAPSHOT_BENCHMARK");
+}
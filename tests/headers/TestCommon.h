@@ -0,0 +1,50 @@
+#pragma once
+#include "pch/pch.h"
+#include "util/Logger.h"
+
+// Every test and benchmark is a single source file, each includes this once
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace SNAKE::Test {
+	inline uint32_t num_checks = 0;
+	inline uint32_t num_failures = 0;
+
+	inline void Init() {
+		Logger::Init();
+	}
+
+	// Returns the process exit code
+	inline int Finish(const char* name) {
+		if (num_failures == 0)
+			SNK_CORE_INFO("{}: {} checks passed", name, num_checks);
+		else
+			SNK_CORE_ERROR("{}: {} of {} checks failed", name, num_failures, num_checks);
+
+		Logger::Flush();
+		return num_failures == 0 ? 0 : 1;
+	}
+
+	inline void Check(bool passed, const char* expr, const char* file, int line) {
+		num_checks++;
+		if (passed)
+			return;
+
+		num_failures++;
+		SNK_CORE_ERROR("{}:{} check failed: '{}'", file, line, expr);
+	}
+
+	// Milliseconds taken by 'fn', the fastest of 'repeats' runs
+	template<typename Fn>
+	double TimeMs(Fn&& fn, uint32_t repeats = 1) {
+		double best = std::numeric_limits<double>::max();
+		for (uint32_t i = 0; i < repeats; i++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			fn();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		return best;
+	}
+}
+
+#define SNK_CHECK(x) SNAKE::Test::Check(static_cast<bool>(x), #x, __FILE__, __LINE__)
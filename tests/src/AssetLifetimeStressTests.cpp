@@ -0,0 +1,176 @@
+#include "TestCommon.h"
+#include "assets/AssetTable.h"
+#include "assets/DeferredDeletionQueue.h"
+#include "core/VkContext.h"
+
+using namespace SNAKE;
+
+/*
+Stress test of the threading contract AssetManager documents, run on the AssetTable, DeferredDeletionQueue and AssetRef it's built from,
+as AssetManager itself needs a device. The main thread creates and deletes assets and runs frame starts, deleted assets are destroyed
+MAX_FRAMES_IN_FLIGHT frame starts later.
+Workers look assets up and copy AssetRefs to them the whole time, using what they found until their pass ends like render data recorded for a frame.
+No worker may see a destroyed asset and every reference count must return to its starting value.
+*/
+namespace {
+	struct TestAsset : public Asset {
+		TestAsset(uint64_t uuid) : Asset(uuid) {}
+		~TestAsset() override { canary = 0; }
+
+		uint64_t canary = CANARY;
+		inline static constexpr uint64_t CANARY = 0xC0FFEE;
+	};
+
+	constexpr uint32_t NUM_WORKERS = 4;
+	constexpr uint32_t NUM_FRAMES = 200;
+	constexpr uint32_t CHANGES_PER_FRAME = 256;
+	constexpr uint64_t FIRST_UUID = 1000;
+	constexpr uint64_t UUID_RANGE = 4096;
+
+	// Never deleted, workers copy references to them
+	constexpr uint64_t NUM_SHARED = 64;
+
+	AssetTable table;
+	DeferredDeletionQueue deleted{ MAX_FRAMES_IN_FLIGHT };
+
+	// As AssetManager::DeleteAsset and DestroyDeletedAssets use them
+	void DeleteAsset(Asset* p_asset) {
+		table.Erase(p_asset->uuid());
+		deleted.Push(p_asset);
+	}
+
+	void FrameStart() {
+		for (auto* p_asset : deleted.AdvanceFrame()) {
+			delete p_asset;
+		}
+	}
+}
+
+static void TestDeletionDelay() {
+	DeferredDeletionQueue queue{ MAX_FRAMES_IN_FLIGHT };
+	TestAsset a{ 1 }, b{ 2 };
+
+	// Each asset comes back on exactly the frame start MAX_FRAMES_IN_FLIGHT after it was pushed, 'b' one frame after 'a'
+	queue.Push(&a);
+	bool delayed = true;
+	for (uint32_t f = 1; f < MAX_FRAMES_IN_FLIGHT; f++) {
+		delayed &= queue.AdvanceFrame().empty();
+		if (f == 1)
+			queue.Push(&b);
+	}
+	auto first = queue.AdvanceFrame();
+	auto second = queue.AdvanceFrame();
+
+	SNK_CHECK(delayed);
+	SNK_CHECK(first == std::vector<Asset*>{ &a } && second == std::vector<Asset*>{ &b });
+	SNK_CHECK(queue.Size() == 0 && queue.GetFrame() == MAX_FRAMES_IN_FLIGHT + 1);
+
+	// Taking everything ignores the delay
+	queue.Push(&a);
+	queue.Push(&b);
+	SNK_CHECK(queue.TakeAll().size() == 2 && queue.Size() == 0 && queue.AdvanceFrame().empty());
+}
+
+static void TestConcurrentLookupsDuringLifecycle() {
+	std::vector<AssetRef<TestAsset>> shared;
+	for (uint64_t uuid = 1; uuid <= NUM_SHARED; uuid++) {
+		auto* p_asset = new TestAsset(uuid);
+		table.Insert(uuid, p_asset);
+		shared.emplace_back(p_asset);
+	}
+
+	// Frame each worker's current pass started in, UINT64_MAX between passes
+	std::array<std::atomic<uint64_t>, NUM_WORKERS> worker_frames;
+	std::atomic<uint64_t> published_frame = 0;
+	std::atomic<bool> stop = false;
+	std::atomic<uint64_t> num_found = 0;
+	std::atomic<bool> saw_destroyed = false;
+
+	std::vector<std::thread> workers;
+	for (uint32_t w = 0; w < NUM_WORKERS; w++) {
+		worker_frames[w] = UINT64_MAX;
+		workers.emplace_back([&, w] {
+			std::mt19937_64 rng(w);
+			while (!stop) {
+				// Rechecked so the main thread can't miss a pass starting as it advances the frame
+				uint64_t pass_frame;
+				do {
+					pass_frame = published_frame.load();
+					worker_frames[w].store(pass_frame);
+				} while (published_frame.load() != pass_frame);
+
+				std::vector<TestAsset*> found;
+				for (int i = 0; i < 64; i++) {
+					if (auto* p_asset = static_cast<TestAsset*>(table.Find(FIRST_UUID + rng() % UUID_RANGE)))
+						found.push_back(p_asset);
+				}
+
+				for (auto* p_asset : found) {
+					AssetRef<TestAsset> ref(p_asset);
+					AssetRef<TestAsset> copy = ref;
+					copy = AssetRef<TestAsset>(shared[rng() % shared.size()].get());
+
+					if (p_asset->canary != TestAsset::CANARY)
+						saw_destroyed = true;
+				}
+
+				num_found.fetch_add(found.size(), std::memory_order_relaxed);
+				worker_frames[w].store(UINT64_MAX);
+			}
+		});
+	}
+
+	std::mt19937_64 rng(99);
+	for (uint32_t f = 0; f < NUM_FRAMES; f++) {
+		FrameStart();
+		uint64_t frame = deleted.GetFrame();
+		published_frame.store(frame);
+
+		for (uint32_t i = 0; i < CHANGES_PER_FRAME; i++) {
+			uint64_t uuid = FIRST_UUID + rng() % UUID_RANGE;
+			if (auto* p_asset = table.Find(uuid))
+				DeleteAsset(p_asset);
+			else
+				table.Insert(uuid, new TestAsset(uuid));
+		}
+
+		// Stands in for the frame fence, passes started MAX_FRAMES_IN_FLIGHT - 1 frames ago must end before the next frame start
+		for (auto& worker_frame : worker_frames) {
+			while (worker_frame.load() != UINT64_MAX && worker_frame.load() + MAX_FRAMES_IN_FLIGHT - 1 <= frame) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	stop = true;
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	SNK_CHECK(!saw_destroyed);
+	SNK_CHECK(num_found > 0);
+	SNK_CHECK(std::ranges::all_of(shared, [](const AssetRef<TestAsset>& ref) { return ref->GetRefCount() == 1; }));
+
+	uint64_t leaked_refs = 0;
+	table.ForEach([&](uint64_t uuid, Asset* p_asset) { leaked_refs += p_asset->GetRefCount() - (uuid <= NUM_SHARED ? 1 : 0); });
+	SNK_CHECK(leaked_refs == 0);
+
+	shared.clear();
+	std::vector<Asset*> remaining;
+	table.ForEach([&]([[maybe_unused]] uint64_t uuid, Asset* p_asset) { remaining.push_back(p_asset); });
+	for (auto* p_asset : remaining) {
+		table.Erase(p_asset->uuid());
+		delete p_asset;
+	}
+
+	for (auto* p_asset : deleted.TakeAll()) {
+		delete p_asset;
+	}
+}
+
+int main() {
+	Test::Init();
+	TestDeletionDelay();
+	TestConcurrentLookupsDuringLifecycle();
+	return Test::Finish("ASSET_LIFETIME_STRESS_TESTS");
+}
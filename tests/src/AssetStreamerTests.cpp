@@ -0,0 +1,28 @@
+#include "TestCommon.h"
+#include "assets/AssetStreamer.h"
+
+using namespace SNAKE;
+
+static void TestBudgetSelection() {
+	constexpr uint64_t MB = 1024 * 1024;
+
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({}, 64 * MB) == 0);
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({ 16 * MB, 16 * MB, 16 * MB }, 64 * MB) == 3);
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({ 32 * MB, 32 * MB, 1 }, 64 * MB) == 2);
+
+	// Exactly filling the budget still fits
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({ 48 * MB, 16 * MB }, 64 * MB) == 2);
+
+	// An asset larger than the budget is still uploaded on its own so it can't block the queue forever
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({ 256 * MB, 1 }, 64 * MB) == 1);
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({ 1, 256 * MB }, 64 * MB) == 1);
+
+	// Selection stops at the first asset that doesn't fit so priority order is kept, smaller ones behind it wait
+	SNK_CHECK(AssetStreamer::GetNumWithinBudget({ 40 * MB, 40 * MB, 1 }, 64 * MB) == 1);
+}
+
+int main() {
+	Test::Init();
+	TestBudgetSelection();
+	return Test::Finish("ASSET_STREAMER_TESTS");
+}
@@ -0,0 +1,190 @@
+#include "TestCommon.h"
+#include "rendering/FrustumCulling.h"
+#include "util/ExtraMath.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+/*
+Checks FrustumCuller against boxes placed inside, outside and across frustum planes, and that its SSE and scalar paths and CullParallel
+report the same visible boxes.
+*/
+namespace {
+	// Axis aligned frustum of [-1, 1] on every axis, so distances to its planes are exact
+	FrustumPlanes GetUnitCubePlanes() {
+		return { glm::vec4{ 1, 0, 0, 1 }, glm::vec4{ -1, 0, 0, 1 }, glm::vec4{ 0, 1, 0, 1 }, glm::vec4{ 0, -1, 0, 1 }, glm::vec4{ 0, 0, 1, 1 },
+			glm::vec4{ 0, 0, -1, 1 } };
+	}
+
+	glm::mat4 GetCameraProjView(glm::vec3 position, glm::vec3 target) {
+		return glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 500.f) * glm::lookAt(position, target, glm::vec3{ 0, 1, 0 });
+	}
+
+	// Boxes with centers in [-extent, extent]^3 and half sizes up to max_half_size
+	CullingBoundsSoA GenerateBounds(uint32_t count, float extent, float max_half_size, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> center_dist(-extent, extent);
+		std::uniform_real_distribution<float> size_dist(0.f, max_half_size);
+
+		CullingBoundsSoA bounds;
+		bounds.Resize(count);
+		for (uint32_t i = 0; i < count; i++) {
+			bounds.Set(i, { center_dist(rng), center_dist(rng), center_dist(rng) }, { size_dist(rng), size_dist(rng), size_dist(rng) });
+		}
+
+		return bounds;
+	}
+
+	std::vector<uint32_t> Cull(const CullingBoundsSoA& bounds, const FrustumPlanes& planes, bool scalar, uint32_t begin = 0, uint32_t end = UINT32_MAX) {
+		std::vector<uint32_t> visible;
+		end = glm::min(end, bounds.GetCount());
+		if (scalar)
+			FrustumCuller::CullRangeScalar(bounds, planes, begin, end, visible);
+		else
+			FrustumCuller::CullRange(bounds, planes, begin, end, visible);
+
+		return visible;
+	}
+}
+
+static void TestKnownBoxes() {
+	auto planes = GetUnitCubePlanes();
+
+	struct Case {
+		glm::vec3 center;
+		glm::vec3 extents;
+		bool visible;
+	};
+
+	std::vector<Case> cases = {
+		{ { 0, 0, 0 }, { 0.5f, 0.5f, 0.5f }, true },
+		// Contains the whole frustum
+		{ { 0, 0, 0 }, { 10, 10, 10 }, true },
+		// Across one plane and across a corner
+		{ { 1.2f, 0, 0 }, { 0.5f, 0.5f, 0.5f }, true },
+		{ { -1.2f, 1.2f, 1.2f }, { 0.5f, 0.5f, 0.5f }, true },
+		// Touching a plane from outside counts as visible
+		{ { 1.5f, 0, 0 }, { 0.5f, 0.5f, 0.5f }, true },
+		{ { 0, -1.5f, 0 }, { 0.5f, 0.5f, 0.5f }, true },
+		// Just outside each plane
+		{ { 1.5f, 0, 0 }, { 0.49f, 0.5f, 0.5f }, false },
+		{ { -1.5f, 0, 0 }, { 0.49f, 0.5f, 0.5f }, false },
+		{ { 0, 1.5f, 0 }, { 0.5f, 0.49f, 0.5f }, false },
+		{ { 0, -1.5f, 0 }, { 0.5f, 0.49f, 0.5f }, false },
+		{ { 0, 0, 1.5f }, { 0.5f, 0.5f, 0.49f }, false },
+		{ { 0, 0, -1.5f }, { 0.5f, 0.5f, 0.49f }, false },
+		// Degenerate boxes are points
+		{ { 1, 1, 1 }, { 0, 0, 0 }, true },
+		{ { 1.001f, 0, 0 }, { 0, 0, 0 }, false },
+	};
+
+	CullingBoundsSoA bounds;
+	bounds.Resize((uint32_t)cases.size());
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < cases.size(); i++) {
+		bounds.Set(i, cases[i].center, cases[i].extents);
+		if (cases[i].visible)
+			expected.push_back(i);
+	}
+
+	SNK_CHECK(Cull(bounds, planes, false) == expected);
+	SNK_CHECK(Cull(bounds, planes, true) == expected);
+
+	// Padding boxes after the last real one are never reported, even when the range ends mid group
+	SNK_CHECK(bounds.center_x.size() % 4 == 0 && bounds.center_x.size() > cases.size());
+	auto first_five = Cull(bounds, planes, false, 0, 5);
+	SNK_CHECK(first_five == std::vector<uint32_t>(expected.begin(), std::ranges::find_if(expected, [](uint32_t idx) { return idx >= 5; })));
+}
+
+static void TestCameraFrustum() {
+	// A box around the camera crosses the near plane and is visible, one just behind the camera isn't
+	glm::vec3 position{ 0, 2, 10 };
+	auto planes = ExtraMath::ExtractFrustumPlanes(GetCameraProjView(position, glm::vec3{ 0, 2, 0 }));
+
+	CullingBoundsSoA bounds;
+	bounds.Resize(4);
+	bounds.Set(0, position, glm::vec3(1.f));
+	bounds.Set(1, position + glm::vec3{ 0, 0, 2 }, glm::vec3(0.5f));
+	bounds.Set(2, glm::vec3{ 0, 2, 0 }, glm::vec3(1.f));
+	bounds.Set(3, glm::vec3{ 0, 2, -600 }, glm::vec3(1.f));
+
+	std::vector<uint32_t> expected{ 0, 2 };
+	SNK_CHECK(Cull(bounds, planes, false) == expected);
+	SNK_CHECK(Cull(bounds, planes, true) == expected);
+}
+
+static void TestSSEMatchesScalar() {
+	// Boxes sized so a large share of them straddle the planes of the views
+	auto bounds = GenerateBounds(100'003, 60.f, 4.f, 1);
+
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<float> dist(-30.f, 30.f);
+
+	bool all_match = true;
+	size_t num_visible = 0;
+	for (uint32_t view = 0; view < 16; view++) {
+		auto planes = ExtraMath::ExtractFrustumPlanes(GetCameraProjView({ dist(rng), dist(rng), dist(rng) }, { dist(rng), dist(rng), dist(rng) }));
+		auto sse = Cull(bounds, planes, false);
+		all_match &= sse == Cull(bounds, planes, true);
+		num_visible += sse.size();
+
+		// Sub-ranges, ending at counts that aren't multiples of 4
+		uint32_t begin = (rng() % 1000) * 4;
+		uint32_t end = begin + rng() % 50'000 + 1;
+		all_match &= Cull(bounds, planes, false, begin, end) == Cull(bounds, planes, true, begin, end);
+	}
+
+	// Boxes exactly touching the unit frustum's planes, which are exact in float
+	CullingBoundsSoA touching;
+	touching.Resize(6 * 256);
+	for (uint32_t i = 0; i < 6 * 256; i++) {
+		uint32_t axis = (i / 256) % 3;
+		float sign = i / 256 < 3 ? 1.f : -1.f;
+		float half_size = (i % 256) / 128.f;
+
+		glm::vec3 center{ 0.f };
+		center[axis] = sign * (1.f + half_size);
+		touching.Set(i, center, glm::vec3(half_size) - (i % 2 ? 0.f : 1.f / 1024.f));
+	}
+	all_match &= Cull(touching, GetUnitCubePlanes(), false) == Cull(touching, GetUnitCubePlanes(), true);
+
+	SNK_CHECK(all_match);
+	SNK_CHECK(num_visible > 0);
+}
+
+static void TestParallelMatchesRange() {
+	auto bounds = GenerateBounds(FrustumCuller::JOB_CHUNK_SIZE * 5 + 13, 200.f, 2.f, 3);
+
+	std::vector<FrustumPlanes> views;
+	for (uint32_t v = 0; v < 4; v++) {
+		float angle = v * glm::half_pi<float>();
+		views.push_back(ExtraMath::ExtractFrustumPlanes(GetCameraProjView(glm::vec3(0.f), { glm::cos(angle), 0.f, glm::sin(angle) })));
+	}
+
+	std::vector<std::vector<uint32_t>> parallel;
+	FrustumCuller::CullParallel(bounds, views, parallel);
+
+	bool all_match = parallel.size() == views.size();
+	for (size_t v = 0; v < views.size() && all_match; v++) {
+		all_match &= parallel[v] == Cull(bounds, views[v], false);
+	}
+	SNK_CHECK(all_match);
+
+	// A single chunk takes the path without jobs
+	auto small_bounds = GenerateBounds(100, 20.f, 2.f, 4);
+	FrustumCuller::CullParallel(small_bounds, views, parallel);
+	SNK_CHECK(parallel[0] == Cull(small_bounds, views[0], false));
+}
+
+int main() {
+	Test::Init();
+	JobSystem::Init();
+
+	TestKnownBoxes();
+	TestCameraFrustum();
+	TestSSEMatchesScalar();
+	TestParallelMatchesRange();
+
+	JobSystem::Shutdown();
+	return Test::Finish("FRUSTUM_CULLING_TESTS");
+}
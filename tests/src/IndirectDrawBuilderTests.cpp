@@ -0,0 +1,321 @@
+#include "TestCommon.h"
+#include "rendering/IndirectDrawBuilder.h"
+#include "scene/SceneSnapshotSystem.h"
+
+using namespace SNAKE;
+
+/*
+Builds indirect draws from hand made snapshots, visible lists and mesh sources and checks how IndirectDrawBuilder batches instances into
+commands, the instance data each command's firstInstance points at, merging of draws of the same submesh and the index ranges drawn
+for each level of detail and run of visible meshlets. Meshes are described by MeshDrawSource directly, so no device or assets are needed.
+*/
+namespace {
+	using DrawItem = CullingSystem::DrawItem;
+	using VisibleList = CullingSystem::VisibleList;
+	using MeshDrawSource = IndirectDrawBuilder::MeshDrawSource;
+
+	// Two submeshes of 36 and 72 indices, the second using material slot 1, each with two simplified levels and four meshlets
+	struct TestMesh {
+		std::vector<Submesh> submeshes{
+			{ .num_indices = 36, .num_vertices = 12, .base_vertex = 0, .base_index = 0, .material_index = 0 },
+			{ .num_indices = 72, .num_vertices = 24, .base_vertex = 12, .base_index = 36, .material_index = 1 },
+		};
+
+		// LOD indices follow every full detail submesh
+		std::vector<MeshLOD> lods{
+			{ .error = 0.1f, .submeshes = { { 108, 18 }, { 126, 36 } } },
+			{ .error = 0.2f, .submeshes = { { 162, 6 }, { 168, 12 } } },
+		};
+
+		std::vector<Meshlet> meshlets;
+
+		TestMesh() {
+			for (uint32_t s = 0; s < submeshes.size(); s++) {
+				for (uint32_t m = 0; m < 4; m++) {
+					Meshlet meshlet;
+					meshlet.num_indices = submeshes[s].num_indices / 4;
+					meshlet.base_index = submeshes[s].base_index + m * meshlet.num_indices;
+					meshlet.submesh_idx = s;
+					meshlets.push_back(meshlet);
+				}
+			}
+		}
+
+		MeshDrawSource GetSource(uint32_t start_index, uint32_t start_vertex, uint32_t start_quantisation) const {
+			return { submeshes, lods, meshlets, start_index, start_vertex, start_quantisation };
+		}
+	};
+
+	// What CullingSystem and SceneSnapshotSystem would hand the builder for a frame
+	struct Frame {
+		SceneSnapshotData snapshot;
+		std::vector<DrawItem> draw_items;
+		VisibleList visible;
+
+		// Adds a range of 'num_instances' instances with transform indices from 'first_transform' and every submesh as a draw item
+		void AddRange(uint32_t num_instances, uint32_t num_submeshes, uint32_t first_transform, std::vector<uint32_t> material_indices) {
+			uint32_t start_idx = (uint32_t)snapshot.static_mesh_data.size();
+			snapshot.mesh_ranges.emplace_back(AssetHandle<StaticMeshAsset>{}, start_idx, num_instances, (uint32_t)snapshot.material_indices.size());
+			snapshot.material_indices.insert(snapshot.material_indices.end(), material_indices.begin(), material_indices.end());
+
+			for (uint32_t i = 0; i < num_instances; i++) {
+				snapshot.static_mesh_data.emplace_back(first_transform + i, nullptr);
+				for (uint32_t s = 0; s < num_submeshes; s++) {
+					draw_items.push_back(DrawItem{ start_idx + i, s });
+				}
+			}
+		}
+
+		// Items must be added in ascending order, a range ends where the next begins
+		void AddVisible(uint32_t item, uint8_t lod = 0, std::vector<uint32_t> meshlets = {}) {
+			visible.items.push_back(item);
+			visible.lods.push_back(lod);
+
+			if (meshlets.empty()) {
+				visible.meshlet_ranges.push_back({ VisibleList::WHOLE_ITEM, 0 });
+			}
+			else {
+				visible.meshlet_ranges.push_back({ (uint32_t)visible.meshlets.size(), (uint32_t)meshlets.size() });
+				visible.meshlets.insert(visible.meshlets.end(), meshlets.begin(), meshlets.end());
+			}
+		}
+
+		void AddAllVisible() {
+			for (uint32_t i = 0; i < draw_items.size(); i++) {
+				AddVisible(i);
+			}
+		}
+
+		// Computes range_starts from the instances of each range, as CullingSystem does
+		void FinishVisible() {
+			visible.range_starts.assign(snapshot.mesh_ranges.size() + 1, 0);
+			uint32_t item = 0;
+			for (size_t r = 0; r < snapshot.mesh_ranges.size(); r++) {
+				visible.range_starts[r] = item;
+				auto& range = snapshot.mesh_ranges[r];
+				while (item < visible.items.size() && draw_items[visible.items[item]].instance_idx < range.start_idx + range.count) {
+					item++;
+				}
+			}
+			visible.range_starts.back() = item;
+		}
+
+		IndirectDrawBuilder Build(std::span<const MeshDrawSource> sources) {
+			FinishVisible();
+			IndirectDrawBuilder builder;
+			builder.AddVisibleItems(snapshot, sources, draw_items, visible);
+			return builder;
+		}
+	};
+
+	// Commands read consecutive, non overlapping runs of the instance data, together covering all of it
+	bool AreInstancesContiguous(const IndirectDrawBuilder& builder) {
+		uint32_t next_instance = 0;
+		for (auto& cmd : builder.GetCommands()) {
+			if (cmd.first_instance != next_instance || cmd.instance_count == 0)
+				return false;
+
+			next_instance += cmd.instance_count;
+		}
+
+		return next_instance == builder.GetInstanceData().size();
+	}
+
+	bool CommandEquals(const DrawIndexedCommand& cmd, uint32_t first_index, uint32_t index_count, int32_t vertex_offset, uint32_t first_instance, uint32_t instance_count) {
+		return cmd.first_index == first_index && cmd.index_count == index_count && cmd.vertex_offset == vertex_offset && cmd.first_instance == first_instance &&
+			cmd.instance_count == instance_count;
+	}
+
+	bool InstanceEquals(const DrawInstanceData& data, uint32_t transform_idx, uint32_t material_idx, uint32_t quantisation_idx) {
+		return data.transform_idx == transform_idx && data.material_idx == material_idx && data.quantisation_idx == quantisation_idx;
+	}
+}
+
+static void TestInstanceBatching() {
+	TestMesh mesh;
+	Frame frame;
+	frame.AddRange(4, 2, 100, { 7, 8 });
+	frame.AddAllVisible();
+
+	// Items are interleaved by instance, the builder groups them by submesh
+	std::vector<MeshDrawSource> sources{ mesh.GetSource(1000, 500, 20) };
+	auto builder = frame.Build(sources);
+	auto& commands = builder.GetCommands();
+	auto& instances = builder.GetInstanceData();
+
+	SNK_CHECK(commands.size() == 2);
+	SNK_CHECK(CommandEquals(commands[0], 1000, 36, 500, 0, 4));
+	SNK_CHECK(CommandEquals(commands[1], 1036, 72, 512, 4, 4));
+	SNK_CHECK(AreInstancesContiguous(builder));
+
+	// Instances of each command stay in instance order, with the material of their submesh's slot and the submesh's quantisation
+	bool instances_match = instances.size() == 8;
+	for (uint32_t i = 0; i < 4 && instances_match; i++) {
+		instances_match &= InstanceEquals(instances[i], 100 + i, 7, 20);
+		instances_match &= InstanceEquals(instances[4 + i], 100 + i, 8, 21);
+	}
+	SNK_CHECK(instances_match);
+
+	// Only the visible items are drawn
+	Frame partial;
+	partial.AddRange(4, 2, 100, { 7, 8 });
+	partial.AddVisible(1);
+	partial.AddVisible(2);
+	partial.AddVisible(7);
+	auto partial_builder = partial.Build(sources);
+	SNK_CHECK(partial_builder.GetCommands().size() == 2 && AreInstancesContiguous(partial_builder));
+	SNK_CHECK(CommandEquals(partial_builder.GetCommands()[0], 1000, 36, 500, 0, 1) && CommandEquals(partial_builder.GetCommands()[1], 1036, 72, 512, 1, 2));
+	SNK_CHECK(InstanceEquals(partial_builder.GetInstanceData()[0], 101, 7, 20) && InstanceEquals(partial_builder.GetInstanceData()[2], 103, 8, 21));
+}
+
+static void TestInstanceOffsets() {
+	TestMesh mesh;
+	Frame frame;
+
+	// Three ranges, the middle one with nothing visible, so its source is never read
+	frame.AddRange(3, 2, 0, { 1, 2 });
+	frame.AddRange(2, 2, 10, { 3, 4 });
+	frame.AddRange(5, 2, 20, { 5, 6 });
+	for (uint32_t i = 0; i < frame.draw_items.size(); i++) {
+		uint32_t instance_idx = frame.draw_items[i].instance_idx;
+		if (instance_idx < 3 || instance_idx >= 5)
+			frame.AddVisible(i);
+	}
+
+	std::vector<MeshDrawSource> sources{ mesh.GetSource(0, 0, 0), {}, mesh.GetSource(2000, 800, 40) };
+	auto builder = frame.Build(sources);
+	auto& commands = builder.GetCommands();
+	auto& instances = builder.GetInstanceData();
+
+	SNK_CHECK(commands.size() == 4);
+	SNK_CHECK(AreInstancesContiguous(builder));
+	SNK_CHECK(CommandEquals(commands[2], 2000, 36, 800, 6, 5) && CommandEquals(commands[3], 2036, 72, 812, 11, 5));
+
+	// Each command's firstInstance indexes its own instances in the instance data
+	bool offsets_match = true;
+	for (auto& cmd : commands) {
+		bool second_range = cmd.first_index >= 2000;
+		uint32_t submesh_idx = cmd.index_count == 72;
+		for (uint32_t i = 0; i < cmd.instance_count; i++) {
+			auto& data = instances[cmd.first_instance + i];
+			offsets_match &= data.transform_idx == (second_range ? 20 : 0) + i;
+			offsets_match &= data.material_idx == (second_range ? 5 : 1) + submesh_idx;
+			offsets_match &= data.quantisation_idx == (second_range ? 40 : 0) + submesh_idx;
+		}
+	}
+	SNK_CHECK(offsets_match);
+
+	// Reset empties the builder, adding again starts from instance 0
+	builder.Reset();
+	SNK_CHECK(builder.GetCommands().empty() && builder.GetInstanceData().empty());
+	builder.AddVisibleItems(frame.snapshot, sources, frame.draw_items, frame.visible);
+	SNK_CHECK(builder.GetCommands().size() == 4 && builder.GetCommands()[0].first_instance == 0 && AreInstancesContiguous(builder));
+}
+
+static void TestMerging() {
+	IndirectDrawBuilder builder;
+	IndirectDrawBuilder::SubmeshDrawInfo a{ .first_index = 0, .index_count = 30, .vertex_offset = 0, .quantisation_idx = 0 };
+	IndirectDrawBuilder::SubmeshDrawInfo b{ .first_index = 30, .index_count = 60, .vertex_offset = 12, .quantisation_idx = 1 };
+
+	// Different materials and transforms don't split a command, a different submesh does
+	builder.AddDraw(a, 0, 0);
+	builder.AddDraw(a, 1, 5);
+	builder.AddDraw(b, 2, 0);
+	builder.AddDraw(a, 3, 0);
+	builder.AddDraw(a, 4, 0);
+
+	auto& commands = builder.GetCommands();
+	SNK_CHECK(commands.size() == 3);
+	SNK_CHECK(CommandEquals(commands[0], 0, 30, 0, 0, 2) && CommandEquals(commands[1], 30, 60, 12, 2, 1) && CommandEquals(commands[2], 0, 30, 0, 3, 2));
+	SNK_CHECK(InstanceEquals(builder.GetInstanceData()[1], 1, 5, 0) && AreInstancesContiguous(builder));
+
+	// The same index range at another vertex offset is another submesh
+	auto c = a;
+	c.vertex_offset = 100;
+	builder.AddDraw(c, 5, 0);
+	SNK_CHECK(commands.size() == 4);
+
+	// Ranges of meshes sharing their data, such as the same mesh with different material sets, merge across the range boundary
+	TestMesh mesh;
+	Frame frame;
+	frame.AddRange(2, 1, 0, { 1 });
+	frame.AddRange(3, 1, 10, { 2 });
+	frame.AddAllVisible();
+
+	std::vector<MeshDrawSource> shared_sources{ mesh.GetSource(300, 50, 3), mesh.GetSource(300, 50, 3) };
+	auto shared = frame.Build(shared_sources);
+	SNK_CHECK(shared.GetCommands().size() == 1 && CommandEquals(shared.GetCommands()[0], 300, 36, 50, 0, 5));
+	SNK_CHECK(InstanceEquals(shared.GetInstanceData()[1], 1, 1, 3) && InstanceEquals(shared.GetInstanceData()[2], 10, 2, 3));
+}
+
+static void TestLODRanges() {
+	TestMesh mesh;
+	Frame frame;
+	frame.AddRange(4, 2, 0, { 0, 1 });
+
+	// Instance 0 at LOD 2, 1 full detail, 2 and 3 at LOD 1 for submesh 0, and all of submesh 1 at LOD 1
+	std::array<uint8_t, 4> submesh_0_lods{ 2, 0, 1, 1 };
+	for (uint32_t i = 0; i < frame.draw_items.size(); i++) {
+		auto& item = frame.draw_items[i];
+		frame.AddVisible(i, item.submesh_idx == 0 ? submesh_0_lods[item.instance_idx] : 1);
+	}
+
+	std::vector<MeshDrawSource> sources{ mesh.GetSource(1000, 500, 0) };
+	auto builder = frame.Build(sources);
+	auto& commands = builder.GetCommands();
+	auto& instances = builder.GetInstanceData();
+
+	// One command per (submesh, lod) in that order, the vertex offset of every level is the submesh's
+	SNK_CHECK(commands.size() == 4);
+	SNK_CHECK(CommandEquals(commands[0], 1000, 36, 500, 0, 1));
+	SNK_CHECK(CommandEquals(commands[1], 1108, 18, 500, 1, 2));
+	SNK_CHECK(CommandEquals(commands[2], 1162, 6, 500, 3, 1));
+	SNK_CHECK(CommandEquals(commands[3], 1126, 36, 512, 4, 4));
+	SNK_CHECK(AreInstancesContiguous(builder));
+
+	std::vector<uint32_t> transform_order;
+	for (auto& data : instances) {
+		transform_order.push_back(data.transform_idx);
+	}
+	SNK_CHECK(transform_order == std::vector<uint32_t>({ 1, 2, 3, 0, 0, 1, 2, 3 }));
+}
+
+static void TestMeshletRanges() {
+	TestMesh mesh;
+	Frame frame;
+	frame.AddRange(3, 1, 0, { 4 });
+
+	// Instance 0 drawn whole, 1 with meshlets 0, 1 and 3 of submesh 0 (two runs), 2 with all four (one run)
+	frame.AddVisible(0);
+	frame.AddVisible(1, 0, { 0, 1, 3 });
+	frame.AddVisible(2, 0, { 0, 1, 2, 3 });
+
+	std::vector<MeshDrawSource> sources{ mesh.GetSource(1000, 500, 9) };
+	auto builder = frame.Build(sources);
+	auto& commands = builder.GetCommands();
+	auto& instances = builder.GetInstanceData();
+
+	// The full run of instance 2 covers the same indices as instance 0's whole draw but follows other commands, so it isn't merged back into it
+	uint32_t meshlet_indices = mesh.submeshes[0].num_indices / 4;
+	SNK_CHECK(commands.size() == 4);
+	SNK_CHECK(CommandEquals(commands[0], 1000, 36, 500, 0, 1));
+	SNK_CHECK(CommandEquals(commands[1], 1000, meshlet_indices * 2, 500, 1, 1));
+	SNK_CHECK(CommandEquals(commands[2], 1000 + meshlet_indices * 3, meshlet_indices, 500, 2, 1));
+	SNK_CHECK(CommandEquals(commands[3], 1000, meshlet_indices * 4, 500, 3, 1));
+
+	// Every run of an item carries that item's instance data
+	SNK_CHECK(InstanceEquals(instances[1], 1, 4, 9) && InstanceEquals(instances[2], 1, 4, 9) && InstanceEquals(instances[3], 2, 4, 9));
+	SNK_CHECK(AreInstancesContiguous(builder));
+}
+
+int main() {
+	Test::Init();
+
+	TestInstanceBatching();
+	TestInstanceOffsets();
+	TestMerging();
+	TestLODRanges();
+	TestMeshletRanges();
+
+	return Test::Finish("INDIRECT_DRAW_BUILDER_TESTS");
+}
@@ -0,0 +1,242 @@
+#include "TestCommon.h"
+#include "assets/MeshOptimizer.h"
+
+using namespace SNAKE;
+
+/*
+Optimises a mesh of two grids whose triangles and vertices are shuffled, with LOD levels sharing ranges the way MeshSimplifier leaves them,
+and checks every range still draws the same triangles, shared ranges are remapped once, the cache miss ratio doesn't get worse and
+vertices end up in the order they are first used.
+*/
+namespace {
+	constexpr uint32_t GRID_SIZE = 48;
+
+	// A triangle's vertex positions, rotated so the smallest comes first, winding is kept
+	using TrianglePositions = std::array<float, 9>;
+
+	struct TestSubmesh {
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+
+		// Every other triangle, stands in for a simplified level
+		std::vector<uint32_t> lod_indices;
+	};
+
+	// Grid in the xy plane at 'z', vertex and triangle order shuffled, the last vertex is referenced by no triangle
+	TestSubmesh GenerateShuffledGrid(float z, std::mt19937& rng) {
+		TestSubmesh grid;
+		std::vector<uint32_t> vertex_order;
+		for (uint32_t v = 0; v < GRID_SIZE * GRID_SIZE; v++) {
+			vertex_order.push_back(v);
+		}
+		std::ranges::shuffle(vertex_order, rng);
+
+		grid.positions.resize(vertex_order.size());
+		for (uint32_t v = 0; v < vertex_order.size(); v++) {
+			grid.positions[vertex_order[v]] = glm::vec3(v % GRID_SIZE, v / GRID_SIZE, z);
+		}
+		grid.positions.emplace_back(-1, -1, z);
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (uint32_t y = 0; y + 1 < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x + 1 < GRID_SIZE; x++) {
+				uint32_t a = y * GRID_SIZE + x;
+				triangles.push_back({ vertex_order[a], vertex_order[a + 1], vertex_order[a + GRID_SIZE + 1] });
+				triangles.push_back({ vertex_order[a], vertex_order[a + GRID_SIZE + 1], vertex_order[a + GRID_SIZE] });
+			}
+		}
+		std::ranges::shuffle(triangles, rng);
+
+		for (size_t t = 0; t < triangles.size(); t++) {
+			grid.indices.insert(grid.indices.end(), triangles[t].begin(), triangles[t].end());
+			if (t % 2 == 0)
+				grid.lod_indices.insert(grid.lod_indices.end(), triangles[t].begin(), triangles[t].end());
+		}
+
+		return grid;
+	}
+
+	// Normals are derived from positions so the test can tell every vertex stream was permuted the same way
+	glm::vec3 NormalFromPosition(const aiVector3D& p) {
+		return glm::vec3(p.y, p.z, p.x * 0.5f);
+	}
+
+	// Level 0 has its own range, level 1 shares level 0's and level 2 shares full detail, as levels that couldn't be reduced further do
+	void BuildMeshData(MeshData& data, const std::vector<TestSubmesh>& submeshes) {
+		for (auto& submesh : submeshes) {
+			data.submeshes.push_back(Submesh{ .num_indices = (unsigned)submesh.indices.size(), .num_vertices = (unsigned)submesh.positions.size(),
+				.base_vertex = data.num_vertices, .base_index = data.num_indices, .material_index = 0 });
+			data.num_vertices += (unsigned)submesh.positions.size();
+			data.num_indices += (unsigned)submesh.indices.size();
+		}
+
+		data.lods.resize(3);
+		for (size_t s = 0; s < submeshes.size(); s++) {
+			SubmeshLOD lod_range{ data.num_indices, (unsigned)submeshes[s].lod_indices.size() };
+			data.lods[0].submeshes.push_back(lod_range);
+			data.lods[1].submeshes.push_back(lod_range);
+			data.lods[2].submeshes.push_back(SubmeshLOD{ data.submeshes[s].base_index, data.submeshes[s].num_indices });
+			data.num_indices += lod_range.num_indices;
+		}
+
+		data.positions = new aiVector3D[data.num_vertices];
+		data.normals = new aiVector3D[data.num_vertices];
+		data.indices = new unsigned[data.num_indices];
+		for (size_t s = 0; s < submeshes.size(); s++) {
+			auto& submesh = data.submeshes[s];
+			for (size_t v = 0; v < submeshes[s].positions.size(); v++) {
+				auto& p = submeshes[s].positions[v];
+				data.positions[submesh.base_vertex + v] = aiVector3D(p.x, p.y, p.z);
+
+				auto n = NormalFromPosition(data.positions[submesh.base_vertex + v]);
+				data.normals[submesh.base_vertex + v] = aiVector3D(n.x, n.y, n.z);
+			}
+
+			std::ranges::copy(submeshes[s].indices, data.indices + submesh.base_index);
+			std::ranges::copy(submeshes[s].lod_indices, data.indices + data.lods[0].submeshes[s].base_index);
+		}
+	}
+
+	// Sorted so two ranges drawing the same triangles compare equal whatever order they're in
+	std::vector<TrianglePositions> GetTriangles(const MeshData& data, uint32_t submesh_idx, unsigned base_index, unsigned num_indices) {
+		std::vector<TrianglePositions> triangles;
+		for (unsigned i = base_index; i < base_index + num_indices; i += 3) {
+			std::array<aiVector3D, 3> corners;
+			for (uint32_t k = 0; k < 3; k++) {
+				corners[k] = data.positions[data.submeshes[submesh_idx].base_vertex + data.indices[i + k]];
+			}
+
+			auto less = [](const aiVector3D& a, const aiVector3D& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+			std::ranges::rotate(corners, std::ranges::min_element(corners, less));
+
+			TrianglePositions triangle;
+			for (uint32_t k = 0; k < 3; k++) {
+				triangle[k * 3] = corners[k].x;
+				triangle[k * 3 + 1] = corners[k].y;
+				triangle[k * 3 + 2] = corners[k].z;
+			}
+			triangles.push_back(triangle);
+		}
+
+		std::ranges::sort(triangles);
+		return triangles;
+	}
+
+	// Full detail, then each level's range
+	std::vector<std::vector<TrianglePositions>> GetAllTriangles(const MeshData& data, uint32_t submesh_idx) {
+		auto& submesh = data.submeshes[submesh_idx];
+		std::vector<std::vector<TrianglePositions>> ranges{ GetTriangles(data, submesh_idx, submesh.base_index, submesh.num_indices) };
+		for (auto& lod : data.lods) {
+			ranges.push_back(GetTriangles(data, submesh_idx, lod.submeshes[submesh_idx].base_index, lod.submeshes[submesh_idx].num_indices));
+		}
+		return ranges;
+	}
+
+	std::vector<TestSubmesh> GenerateSubmeshes() {
+		std::mt19937 rng{ 7 };
+		return { GenerateShuffledGrid(0.f, rng), GenerateShuffledGrid(1.f, rng) };
+	}
+}
+
+static void TestTrianglesPreserved() {
+	auto submeshes = GenerateSubmeshes();
+	MeshData data;
+	BuildMeshData(data, submeshes);
+
+	std::vector<std::vector<std::vector<TrianglePositions>>> before;
+	for (uint32_t s = 0; s < data.submeshes.size(); s++) {
+		before.push_back(GetAllTriangles(data, s));
+	}
+
+	MeshOptimizer::OptimizeMesh(data);
+
+	// A shared range remapped twice would have its indices pointing at the wrong vertices, changing the positions it draws
+	bool triangles_preserved = true;
+	bool ranges_unchanged = true;
+	bool streams_consistent = true;
+	for (uint32_t s = 0; s < data.submeshes.size(); s++) {
+		triangles_preserved &= GetAllTriangles(data, s) == before[s];
+
+		ranges_unchanged &= data.lods[1].submeshes[s].base_index == data.lods[0].submeshes[s].base_index;
+		ranges_unchanged &= data.lods[2].submeshes[s].base_index == data.submeshes[s].base_index;
+
+		auto& submesh = data.submeshes[s];
+		for (unsigned v = submesh.base_vertex; v < submesh.base_vertex + submesh.num_vertices; v++) {
+			auto expected = NormalFromPosition(data.positions[v]);
+			streams_consistent &= data.normals[v].x == expected.x && data.normals[v].y == expected.y && data.normals[v].z == expected.z;
+		}
+	}
+
+	SNK_CHECK(triangles_preserved);
+	SNK_CHECK(ranges_unchanged);
+	SNK_CHECK(streams_consistent);
+}
+
+static void TestVertexCacheImproved() {
+	auto submeshes = GenerateSubmeshes();
+	MeshData data;
+	BuildMeshData(data, submeshes);
+
+	MeshOptimizer::VertexCacheStats shuffled;
+	for (auto& submesh : data.submeshes) {
+		shuffled += MeshOptimizer::AnalyzeVertexCache(data.indices + submesh.base_index, submesh.num_indices, submesh.num_vertices);
+	}
+
+	auto report = MeshOptimizer::OptimizeMesh(data);
+	SNK_CHECK(report.before.GetACMR() == shuffled.GetACMR());
+	SNK_CHECK(report.after.GetACMR() <= report.before.GetACMR());
+
+	// Shuffled triangles miss on nearly every vertex, a cache ordered grid transforms each vertex about once
+	SNK_CHECK(report.before.GetACMR() > 2.f && report.after.GetACMR() < 1.f && report.after.GetATVR() < 1.5f);
+
+	// The cache order on its own, before overdraw clustering trades some of it away
+	auto& grid = submeshes[0];
+	auto cache_ordered = MeshOptimizer::OptimizeVertexCache(grid.indices.data(), (uint32_t)grid.indices.size(), (uint32_t)grid.positions.size());
+	auto cache_ordered_stats = MeshOptimizer::AnalyzeVertexCache(cache_ordered.data(), (uint32_t)cache_ordered.size(), (uint32_t)grid.positions.size());
+	auto grid_stats = MeshOptimizer::AnalyzeVertexCache(grid.indices.data(), (uint32_t)grid.indices.size(), (uint32_t)grid.positions.size());
+	SNK_CHECK(cache_ordered_stats.GetACMR() <= grid_stats.GetACMR());
+
+	SNK_CORE_INFO("Shuffled {}x{} grids, ACMR {:.3f} -> {:.3f} (cache order only {:.3f}), ATVR {:.3f} -> {:.3f}", GRID_SIZE, GRID_SIZE, report.before.GetACMR(),
+		report.after.GetACMR(), cache_ordered_stats.GetACMR(), report.before.GetATVR(), report.after.GetATVR());
+}
+
+static void TestVertexFetchOrder() {
+	auto submeshes = GenerateSubmeshes();
+	MeshData data;
+	BuildMeshData(data, submeshes);
+	MeshOptimizer::OptimizeVertexFetch(data);
+
+	// Walking full detail then each distinct level range, every vertex not seen yet must be the next one in memory
+	bool first_use_order = true;
+	bool unreferenced_last = true;
+	for (uint32_t s = 0; s < data.submeshes.size(); s++) {
+		auto& submesh = data.submeshes[s];
+		std::vector<SubmeshLOD> ranges{ SubmeshLOD{ submesh.base_index, submesh.num_indices }, data.lods[0].submeshes[s] };
+
+		uint32_t next_vertex = 0;
+		for (auto& range : ranges) {
+			for (unsigned i = range.base_index; i < range.base_index + range.num_indices; i++) {
+				if (data.indices[i] == next_vertex)
+					next_vertex++;
+				else
+					first_use_order &= data.indices[i] < next_vertex;
+			}
+		}
+
+		auto& unreferenced = data.positions[submesh.base_vertex + submesh.num_vertices - 1];
+		unreferenced_last &= next_vertex == submesh.num_vertices - 1 && unreferenced.x == -1.f && unreferenced.y == -1.f;
+	}
+
+	SNK_CHECK(first_use_order);
+	SNK_CHECK(unreferenced_last);
+}
+
+int main() {
+	Test::Init();
+
+	TestTrianglesPreserved();
+	TestVertexCacheImproved();
+	TestVertexFetchOrder();
+
+	return Test::Finish("MESH_OPTIMIZER_TESTS");
+}
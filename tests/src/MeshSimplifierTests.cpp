@@ -0,0 +1,250 @@
+#include "TestCommon.h"
+#include "assets/MeshSimplifier.h"
+
+using namespace SNAKE;
+
+/*
+Generates LODs for a procedural UV sphere with a split seam and a bumpy open grid, and checks every level meets its triangle target, errors
+grow with each level and stay small next to the mesh bounds, seam and border vertices are never collapsed and no triangle faces inwards.
+*/
+namespace {
+	constexpr uint32_t SPHERE_SEGMENTS = 96;
+	constexpr uint32_t SPHERE_RINGS = 32;
+	constexpr uint32_t GRID_SIZE = 40;
+	constexpr float REDUCTION = 0.5f;
+
+	struct TestSubmesh {
+		std::vector<glm::vec3> positions;
+
+		// Local to the submesh's vertices
+		std::vector<uint32_t> indices;
+
+		// Vertices on the seam or open border
+		std::vector<uint32_t> locked;
+	};
+
+	// Unit sphere around the origin, the first and last column of each ring are split vertices at the same position, as a UV seam leaves them
+	TestSubmesh GenerateSphere() {
+		TestSubmesh sphere;
+		auto vertex_idx = [](uint32_t ring, uint32_t segment) {
+			return 1 + (ring - 1) * (SPHERE_SEGMENTS + 1) + segment;
+		};
+
+		sphere.positions.emplace_back(0, 1, 0);
+		for (uint32_t ring = 1; ring < SPHERE_RINGS; ring++) {
+			float theta = glm::pi<float>() * ring / SPHERE_RINGS;
+			for (uint32_t segment = 0; segment <= SPHERE_SEGMENTS; segment++) {
+				float phi = glm::two_pi<float>() * (segment % SPHERE_SEGMENTS) / SPHERE_SEGMENTS;
+				sphere.positions.emplace_back(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+			}
+		}
+		sphere.positions.emplace_back(0, -1, 0);
+		uint32_t bottom = (uint32_t)sphere.positions.size() - 1;
+
+		// Counter-clockwise seen from outside
+		for (uint32_t segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+			sphere.indices.insert(sphere.indices.end(), { 0, vertex_idx(1, segment + 1), vertex_idx(1, segment) });
+			sphere.indices.insert(sphere.indices.end(), { bottom, vertex_idx(SPHERE_RINGS - 1, segment), vertex_idx(SPHERE_RINGS - 1, segment + 1) });
+
+			for (uint32_t ring = 1; ring + 1 < SPHERE_RINGS; ring++) {
+				uint32_t a = vertex_idx(ring, segment), b = vertex_idx(ring, segment + 1);
+				uint32_t c = vertex_idx(ring + 1, segment), d = vertex_idx(ring + 1, segment + 1);
+				sphere.indices.insert(sphere.indices.end(), { a, b, d, a, d, c });
+			}
+		}
+
+		sphere.locked = { 0, bottom };
+		for (uint32_t ring = 1; ring < SPHERE_RINGS; ring++) {
+			sphere.locked.push_back(vertex_idx(ring, 0));
+			sphere.locked.push_back(vertex_idx(ring, SPHERE_SEGMENTS));
+		}
+
+		return sphere;
+	}
+
+	// Height field over [2, 4] x [-1, 1] facing +z, its open border is locked
+	TestSubmesh GenerateGrid() {
+		TestSubmesh grid;
+		for (uint32_t y = 0; y < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x < GRID_SIZE; x++) {
+				glm::vec2 uv = glm::vec2(x, y) / (GRID_SIZE - 1.f);
+				grid.positions.emplace_back(2.f + uv.x * 2.f, uv.y * 2.f - 1.f, 0.05f * glm::sin(uv.x * 9.f) * glm::cos(uv.y * 7.f));
+
+				if (x == 0 || y == 0 || x == GRID_SIZE - 1 || y == GRID_SIZE - 1)
+					grid.locked.push_back(y * GRID_SIZE + x);
+			}
+		}
+
+		for (uint32_t y = 0; y + 1 < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x + 1 < GRID_SIZE; x++) {
+				uint32_t a = y * GRID_SIZE + x;
+				grid.indices.insert(grid.indices.end(), { a, a + 1, a + GRID_SIZE + 1, a, a + GRID_SIZE + 1, a + GRID_SIZE });
+			}
+		}
+
+		return grid;
+	}
+
+	void BuildMeshData(MeshData& data, const std::vector<TestSubmesh>& submeshes) {
+		for (auto& submesh : submeshes) {
+			data.submeshes.push_back(Submesh{ .num_indices = (unsigned)submesh.indices.size(), .num_vertices = (unsigned)submesh.positions.size(),
+				.base_vertex = data.num_vertices, .base_index = data.num_indices, .material_index = 0 });
+			data.num_vertices += (unsigned)submesh.positions.size();
+			data.num_indices += (unsigned)submesh.indices.size();
+		}
+
+		data.positions = new aiVector3D[data.num_vertices];
+		data.indices = new unsigned[data.num_indices];
+		for (size_t s = 0; s < submeshes.size(); s++) {
+			auto& submesh = data.submeshes[s];
+			for (size_t v = 0; v < submeshes[s].positions.size(); v++) {
+				auto& p = submeshes[s].positions[v];
+				data.positions[submesh.base_vertex + v] = aiVector3D(p.x, p.y, p.z);
+			}
+			std::ranges::copy(submeshes[s].indices, data.indices + submesh.base_index);
+		}
+	}
+
+	std::vector<uint32_t> GetLODIndices(const MeshData& data, uint32_t level, uint32_t submesh_idx) {
+		auto& range = data.lods[level].submeshes[submesh_idx];
+		return std::vector<uint32_t>(data.indices + range.base_index, data.indices + range.base_index + range.num_indices);
+	}
+
+	// Edges used by exactly one triangle, as (min, max) vertex pairs
+	std::set<std::pair<uint32_t, uint32_t>> GetOpenEdges(const std::vector<uint32_t>& indices) {
+		std::map<std::pair<uint32_t, uint32_t>, uint32_t> counts;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (uint32_t e = 0; e < 3; e++) {
+				uint32_t a = indices[i + e], b = indices[i + (e + 1) % 3];
+				counts[{ glm::min(a, b), glm::max(a, b) }]++;
+			}
+		}
+
+		std::set<std::pair<uint32_t, uint32_t>> open;
+		for (auto [edge, count] : counts) {
+			if (count == 1)
+				open.insert(edge);
+		}
+		return open;
+	}
+}
+
+static void TestLODs() {
+	std::vector<TestSubmesh> submeshes{ GenerateSphere(), GenerateGrid() };
+	MeshData data;
+	BuildMeshData(data, submeshes);
+	unsigned full_num_indices = data.num_indices;
+
+	MeshSimplifier::GenerateLODs(data, REDUCTION);
+	SNK_CHECK(data.lods.size() == MeshData::MAX_LODS);
+
+	// Full detail indices are untouched, every level's indices are appended after them
+	bool full_detail_kept = true;
+	for (size_t s = 0; s < submeshes.size(); s++) {
+		full_detail_kept &= std::equal(submeshes[s].indices.begin(), submeshes[s].indices.end(), data.indices + data.submeshes[s].base_index);
+	}
+	SNK_CHECK(full_detail_kept);
+
+	glm::vec3 bounds_min{ std::numeric_limits<float>::max() }, bounds_max{ std::numeric_limits<float>::lowest() };
+	for (auto& submesh : submeshes) {
+		for (auto& p : submesh.positions) {
+			bounds_min = glm::min(bounds_min, p);
+			bounds_max = glm::max(bounds_max, p);
+		}
+	}
+	float bounds_diagonal = glm::length(bounds_max - bounds_min);
+
+	bool meets_targets = true;
+	bool ranges_valid = true;
+	bool errors_monotonic = true;
+	bool errors_bounded = true;
+	bool locked_kept = true;
+	bool no_flips = true;
+	bool error_bounds_sphere = true;
+	uint32_t prev_level_indices = full_num_indices;
+
+	for (uint32_t level = 0; level < data.lods.size(); level++) {
+		auto& lod = data.lods[level];
+		uint32_t level_indices = 0;
+
+		for (uint32_t s = 0; s < submeshes.size(); s++) {
+			auto& source = submeshes[s];
+			auto indices = GetLODIndices(data, level, s);
+			level_indices += (uint32_t)indices.size();
+
+			// Each level targets REDUCTION times the triangles of the level before, measured from full detail
+			uint32_t target = (uint32_t)(source.indices.size() * glm::pow(REDUCTION, (float)level + 1.f)) / 3 * 3;
+			meets_targets &= indices.size() <= target;
+
+			ranges_valid &= lod.submeshes[s].base_index >= full_num_indices && lod.submeshes[s].base_index + indices.size() <= data.num_indices &&
+				indices.size() % 3 == 0 && std::ranges::all_of(indices, [&](uint32_t idx) { return idx < source.positions.size(); });
+			if (!ranges_valid)
+				continue;
+
+			// Seam and border vertices are never collapsed, so the open edges around them are exactly those of full detail
+			std::set<uint32_t> used(indices.begin(), indices.end());
+			locked_kept &= std::ranges::all_of(source.locked, [&](uint32_t v) { return used.contains(v); });
+			locked_kept &= GetOpenEdges(indices) == GetOpenEdges(source.indices);
+
+			// The sphere's triangles face away from its center, the grid's towards +z
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				glm::vec3 p0 = source.positions[indices[i]], p1 = source.positions[indices[i + 1]], p2 = source.positions[indices[i + 2]];
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				glm::vec3 expected = s == 0 ? (p0 + p1 + p2) / 3.f : glm::vec3(0, 0, 1);
+				no_flips &= glm::dot(normal, expected) > 0.f;
+
+				// Vertices stay on the unit sphere, so how far inside it a triangle's center sinks is how far the level strays from the surface
+				if (s == 0)
+					error_bounds_sphere &= 1.f - glm::length((p0 + p1 + p2) / 3.f) <= lod.error;
+			}
+		}
+
+		meets_targets &= level_indices <= prev_level_indices * MeshSimplifier::MAX_LOD_TRIANGLE_RATIO;
+		errors_monotonic &= lod.error > 0.f && (level == 0 || lod.error >= data.lods[level - 1].error);
+		errors_bounded &= lod.error < (level == 0 ? 0.005f : 0.1f) * bounds_diagonal;
+		prev_level_indices = level_indices;
+	}
+
+	SNK_CHECK(meets_targets);
+	SNK_CHECK(ranges_valid);
+	SNK_CHECK(errors_monotonic);
+	SNK_CHECK(errors_bounded && error_bounds_sphere);
+	SNK_CHECK(locked_kept);
+	SNK_CHECK(no_flips);
+}
+
+static void TestSimplifyLimits() {
+	auto grid = GenerateGrid();
+	std::vector<aiVector3D> positions;
+	for (auto& p : grid.positions) {
+		positions.emplace_back(p.x, p.y, p.z);
+	}
+
+	// A target above the input leaves it unchanged with no error
+	float error = -1.f;
+	auto unchanged = MeshSimplifier::Simplify(positions.data(), (uint32_t)positions.size(), grid.indices.data(), (uint32_t)grid.indices.size(),
+		(uint32_t)grid.indices.size(), std::numeric_limits<float>::max(), &error);
+	SNK_CHECK(unchanged == grid.indices && error == 0.f);
+
+	// max_error stops simplification before the target once every remaining collapse costs more
+	float max_error = 1e-3f;
+	auto limited = MeshSimplifier::Simplify(positions.data(), (uint32_t)positions.size(), grid.indices.data(), (uint32_t)grid.indices.size(), 0, max_error, &error);
+	SNK_CHECK(!limited.empty() && limited.size() < grid.indices.size() && error <= max_error);
+
+	// A flat grid simplifies down to its locked border without error
+	for (auto& p : positions) {
+		p.z = 0.f;
+	}
+	auto flat = MeshSimplifier::Simplify(positions.data(), (uint32_t)positions.size(), grid.indices.data(), (uint32_t)grid.indices.size(), 0, 0.f, &error);
+	SNK_CHECK(flat.size() < grid.indices.size() / 10 && error == 0.f);
+	SNK_CHECK(GetOpenEdges(flat) == GetOpenEdges(grid.indices));
+}
+
+int main() {
+	Test::Init();
+
+	TestLODs();
+	TestSimplifyLimits();
+
+	return Test::Finish("MESH_SIMPLIFIER_TESTS");
+}
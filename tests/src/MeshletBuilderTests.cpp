@@ -0,0 +1,269 @@
+#include "TestCommon.h"
+#include "assets/MeshletBuilder.h"
+
+using namespace SNAKE;
+
+/*
+Builds meshlets for a UV sphere, a bumpy grid with degenerate triangles, a soup of random triangles and a patch drawn several times over, and checks every triangle lands in
+exactly one meshlet in its original order within the vertex and triangle limits, bounding spheres contain their vertices and the normal cone
+never rejects a meshlet with a front facing triangle from any of a set of random viewpoints.
+*/
+namespace {
+	constexpr uint32_t SPHERE_SEGMENTS = 48;
+	constexpr uint32_t SPHERE_RINGS = 24;
+	constexpr uint32_t GRID_SIZE = 40;
+	constexpr uint32_t NUM_RANDOM_TRIANGLES = 600;
+	constexpr uint32_t PATCH_SIZE = 6;
+	constexpr uint32_t NUM_PATCH_LAYERS = 5;
+	constexpr uint32_t NUM_VIEWPOINTS = 256;
+
+	struct TestSubmesh {
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// Unit sphere around the origin, counter-clockwise seen from outside
+	TestSubmesh GenerateSphere() {
+		TestSubmesh sphere;
+		auto vertex_idx = [](uint32_t ring, uint32_t segment) {
+			return 1 + (ring - 1) * SPHERE_SEGMENTS + segment % SPHERE_SEGMENTS;
+		};
+
+		sphere.positions.emplace_back(0, 1, 0);
+		for (uint32_t ring = 1; ring < SPHERE_RINGS; ring++) {
+			float theta = glm::pi<float>() * ring / SPHERE_RINGS;
+			for (uint32_t segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+				float phi = glm::two_pi<float>() * segment / SPHERE_SEGMENTS;
+				sphere.positions.emplace_back(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+			}
+		}
+		sphere.positions.emplace_back(0, -1, 0);
+		uint32_t bottom = (uint32_t)sphere.positions.size() - 1;
+
+		for (uint32_t segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+			sphere.indices.insert(sphere.indices.end(), { 0, vertex_idx(1, segment + 1), vertex_idx(1, segment) });
+			for (uint32_t ring = 1; ring + 1 < SPHERE_RINGS; ring++) {
+				uint32_t a = vertex_idx(ring, segment), b = vertex_idx(ring, segment + 1);
+				uint32_t c = vertex_idx(ring + 1, segment), d = vertex_idx(ring + 1, segment + 1);
+				sphere.indices.insert(sphere.indices.end(), { a, b, d, a, d, c });
+			}
+			sphere.indices.insert(sphere.indices.end(), { bottom, vertex_idx(SPHERE_RINGS - 1, segment), vertex_idx(SPHERE_RINGS - 1, segment + 1) });
+		}
+
+		return sphere;
+	}
+
+	// Height field over [2, 4] x [-1, 1] facing +z, every 50th triangle is followed by a degenerate one repeating a vertex
+	TestSubmesh GenerateGrid() {
+		TestSubmesh grid;
+		for (uint32_t y = 0; y < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x < GRID_SIZE; x++) {
+				glm::vec2 uv = glm::vec2(x, y) / (GRID_SIZE - 1.f);
+				grid.positions.emplace_back(2.f + uv.x * 2.f, uv.y * 2.f - 1.f, 0.2f * glm::sin(uv.x * 9.f) * glm::cos(uv.y * 7.f));
+			}
+		}
+
+		uint32_t num_triangles = 0;
+		for (uint32_t y = 0; y + 1 < GRID_SIZE; y++) {
+			for (uint32_t x = 0; x + 1 < GRID_SIZE; x++) {
+				uint32_t a = y * GRID_SIZE + x;
+				grid.indices.insert(grid.indices.end(), { a, a + 1, a + GRID_SIZE + 1, a, a + GRID_SIZE + 1, a + GRID_SIZE });
+
+				if (++num_triangles % 50 == 0)
+					grid.indices.insert(grid.indices.end(), { a, a, a + 1 });
+			}
+		}
+
+		return grid;
+	}
+
+	// Unconnected triangles in random orientations inside [-1, 1] around (0, 0, -4), most meshlets of these can never be cone culled
+	TestSubmesh GenerateSoup(std::mt19937& rng) {
+		TestSubmesh soup;
+		std::uniform_real_distribution<float> dist{ -1.f, 1.f };
+		for (uint32_t t = 0; t < NUM_RANDOM_TRIANGLES; t++) {
+			glm::vec3 center{ dist(rng), dist(rng), dist(rng) - 4.f };
+			for (uint32_t k = 0; k < 3; k++) {
+				soup.indices.push_back((uint32_t)soup.positions.size());
+				soup.positions.push_back(center + glm::vec3(dist(rng), dist(rng), dist(rng)) * 0.1f);
+			}
+		}
+
+		return soup;
+	}
+
+	// The same small grid drawn several times over, few enough vertices that meshlets are limited by triangles instead
+	TestSubmesh GenerateLayeredPatch() {
+		TestSubmesh patch;
+		for (uint32_t y = 0; y < PATCH_SIZE; y++) {
+			for (uint32_t x = 0; x < PATCH_SIZE; x++) {
+				patch.positions.emplace_back(x, y, 5.f);
+			}
+		}
+
+		for (uint32_t layer = 0; layer < NUM_PATCH_LAYERS; layer++) {
+			for (uint32_t y = 0; y + 1 < PATCH_SIZE; y++) {
+				for (uint32_t x = 0; x + 1 < PATCH_SIZE; x++) {
+					uint32_t a = y * PATCH_SIZE + x;
+					patch.indices.insert(patch.indices.end(), { a, a + 1, a + PATCH_SIZE + 1, a, a + PATCH_SIZE + 1, a + PATCH_SIZE });
+				}
+			}
+		}
+
+		return patch;
+	}
+
+	void BuildMeshData(MeshData& data, const std::vector<TestSubmesh>& submeshes) {
+		for (auto& submesh : submeshes) {
+			data.submeshes.push_back(Submesh{ .num_indices = (unsigned)submesh.indices.size(), .num_vertices = (unsigned)submesh.positions.size(),
+				.base_vertex = data.num_vertices, .base_index = data.num_indices, .material_index = 0 });
+			data.num_vertices += (unsigned)submesh.positions.size();
+			data.num_indices += (unsigned)submesh.indices.size();
+		}
+
+		data.positions = new aiVector3D[data.num_vertices];
+		data.indices = new unsigned[data.num_indices];
+		for (size_t s = 0; s < submeshes.size(); s++) {
+			auto& submesh = data.submeshes[s];
+			for (size_t v = 0; v < submeshes[s].positions.size(); v++) {
+				auto& p = submeshes[s].positions[v];
+				data.positions[submesh.base_vertex + v] = aiVector3D(p.x, p.y, p.z);
+			}
+			std::ranges::copy(submeshes[s].indices, data.indices + submesh.base_index);
+		}
+	}
+
+	glm::vec3 GetPosition(const MeshData& data, const Meshlet& meshlet, uint32_t i) {
+		auto& p = data.positions[data.submeshes[meshlet.submesh_idx].base_vertex + data.indices[i]];
+		return { p.x, p.y, p.z };
+	}
+
+	bool IsConeCulled(const Meshlet& meshlet, glm::vec3 view_pos) {
+		return glm::dot(glm::normalize(meshlet.cone_apex - view_pos), meshlet.cone_axis) >= meshlet.cone_cutoff;
+	}
+
+	// Front facing by more than 'margin', so triangles seen almost edge-on don't fail the test on rounding
+	bool HasFrontFacingTriangle(const MeshData& data, const Meshlet& meshlet, glm::vec3 view_pos, float margin) {
+		for (uint32_t i = meshlet.base_index; i < meshlet.base_index + meshlet.num_indices; i += 3) {
+			glm::vec3 p0 = GetPosition(data, meshlet, i), p1 = GetPosition(data, meshlet, i + 1), p2 = GetPosition(data, meshlet, i + 2);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float len = glm::length(normal);
+			if (len > 0.f && glm::dot(normal / len, glm::normalize(view_pos - p0)) > margin)
+				return true;
+		}
+
+		return false;
+	}
+}
+
+static void TestCoverage() {
+	std::mt19937 rng{ 3 };
+	std::vector<TestSubmesh> submeshes{ GenerateSphere(), GenerateGrid(), GenerateSoup(rng), GenerateLayeredPatch() };
+	MeshData data;
+	BuildMeshData(data, submeshes);
+
+	std::vector<unsigned> source_indices(data.indices, data.indices + data.num_indices);
+	MeshletBuilder::BuildMeshlets(data);
+
+	SNK_CHECK(data.submesh_meshlets.size() == submeshes.size());
+	SNK_CHECK(std::equal(source_indices.begin(), source_indices.end(), data.indices));
+
+	// Each submesh's meshlets are consecutive and their ranges follow on from each other, so every triangle is in exactly one, in order
+	bool ranges_contiguous = true;
+	bool within_limits = true;
+	bool vertex_counts_match = true;
+	uint32_t next_meshlet = 0;
+	for (uint32_t s = 0; s < data.submeshes.size(); s++) {
+		auto& submesh = data.submeshes[s];
+		auto& range = data.submesh_meshlets[s];
+		ranges_contiguous &= range.first_meshlet == next_meshlet && range.num_meshlets > 0;
+		next_meshlet += range.num_meshlets;
+
+		uint32_t next_index = submesh.base_index;
+		for (uint32_t m = range.first_meshlet; m < range.first_meshlet + range.num_meshlets && m < data.meshlets.size(); m++) {
+			auto& meshlet = data.meshlets[m];
+			ranges_contiguous &= meshlet.submesh_idx == s && meshlet.base_index == next_index && meshlet.num_indices > 0 && meshlet.num_indices % 3 == 0;
+			next_index = meshlet.base_index + meshlet.num_indices;
+
+			std::set<uint32_t> vertices(data.indices + meshlet.base_index, data.indices + meshlet.base_index + meshlet.num_indices);
+			within_limits &= vertices.size() <= MeshletBuilder::MAX_VERTICES && meshlet.num_indices / 3 <= MeshletBuilder::MAX_TRIANGLES;
+			vertex_counts_match &= meshlet.num_vertices == vertices.size();
+		}
+
+		ranges_contiguous &= next_index == submesh.base_index + submesh.num_indices;
+	}
+
+	SNK_CHECK(ranges_contiguous && next_meshlet == data.meshlets.size());
+	SNK_CHECK(within_limits);
+	SNK_CHECK(vertex_counts_match);
+
+	// The soup's triangles share no vertices, so its meshlets are limited by vertices rather than triangles
+	uint32_t soup_triangles_per_meshlet = MeshletBuilder::MAX_VERTICES / 3;
+	SNK_CHECK(data.submesh_meshlets[2].num_meshlets == (NUM_RANDOM_TRIANGLES + soup_triangles_per_meshlet - 1) / soup_triangles_per_meshlet);
+
+	// And the patch's by triangles, every meshlet but the last is full
+	uint32_t num_patch_triangles = (uint32_t)submeshes[3].indices.size() / 3;
+	auto& patch_range = data.submesh_meshlets[3];
+	SNK_CHECK(patch_range.num_meshlets == (num_patch_triangles + MeshletBuilder::MAX_TRIANGLES - 1) / MeshletBuilder::MAX_TRIANGLES &&
+		data.meshlets[patch_range.first_meshlet].num_indices == MeshletBuilder::MAX_TRIANGLES * 3);
+}
+
+static void TestBounds() {
+	std::mt19937 rng{ 5 };
+	std::vector<TestSubmesh> submeshes{ GenerateSphere(), GenerateGrid(), GenerateSoup(rng) };
+	MeshData data;
+	BuildMeshData(data, submeshes);
+	MeshletBuilder::BuildMeshlets(data);
+
+	bool vertices_inside = true;
+	for (auto& meshlet : data.meshlets) {
+		for (uint32_t i = meshlet.base_index; i < meshlet.base_index + meshlet.num_indices; i++) {
+			vertices_inside &= glm::distance(GetPosition(data, meshlet, i), meshlet.center) <= meshlet.radius * (1.f + 1e-5f) + 1e-6f;
+		}
+	}
+	SNK_CHECK(vertices_inside);
+
+	// Viewpoints from inside the meshlets' spheres out to well past the meshes, a cone may only reject a meshlet if none of its triangles face the viewpoint
+	std::uniform_real_distribution<float> dist{ -6.f, 6.f };
+	bool cones_conservative = true;
+	uint32_t num_culled = 0;
+	uint32_t num_cullable = 0;
+	for (uint32_t v = 0; v < NUM_VIEWPOINTS; v++) {
+		glm::vec3 view_pos{ dist(rng), dist(rng), dist(rng) };
+		for (auto& meshlet : data.meshlets) {
+			if (!IsConeCulled(meshlet, view_pos))
+				continue;
+
+			num_culled++;
+			cones_conservative &= !HasFrontFacingTriangle(data, meshlet, view_pos, 1e-4f);
+		}
+
+		for (auto& meshlet : data.meshlets) {
+			num_cullable += !HasFrontFacingTriangle(data, meshlet, view_pos, 0.f);
+		}
+	}
+
+	SNK_CHECK(cones_conservative);
+
+	// The cones are useful too, not just never wrong, a fair share of the meshlets with nothing facing the viewpoint are rejected
+	SNK_CHECK(num_culled > num_cullable / 4);
+	SNK_CORE_INFO("{} meshlets, cones rejected {} of the {} meshlet/viewpoint pairs with no front facing triangle", data.meshlets.size(), num_culled, num_cullable);
+
+	// A flat meshlet has a cone of zero width, it's culled from exactly the half space behind it
+	std::vector<TestSubmesh> flat{ TestSubmesh{ { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } }, { 0, 1, 2, 0, 2, 3 } } };
+	MeshData flat_data;
+	BuildMeshData(flat_data, flat);
+	MeshletBuilder::BuildMeshlets(flat_data);
+	auto& flat_meshlet = flat_data.meshlets[0];
+	SNK_CHECK(flat_data.meshlets.size() == 1 && flat_meshlet.cone_cutoff < 1e-3f && glm::dot(flat_meshlet.cone_axis, glm::vec3(0, 0, 1)) > 0.999f);
+	SNK_CHECK(IsConeCulled(flat_meshlet, glm::vec3(0.5f, 0.5f, -1.f)) && !IsConeCulled(flat_meshlet, glm::vec3(0.5f, 0.5f, 1.f)));
+}
+
+int main() {
+	Test::Init();
+
+	TestCoverage();
+	TestBounds();
+
+	return Test::Finish("MESHLET_BUILDER_TESTS");
+}
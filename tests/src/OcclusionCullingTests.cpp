@@ -0,0 +1,300 @@
+#include "TestCommon.h"
+#include "rendering/OcclusionCulling.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+/*
+Rasterises known occluder quads into OcclusionBuffer and checks the depth written, that every Hi-Z level is at least the max depth of
+the pixels it covers, and which boxes TestVisible keeps behind, in front of, beside and across the near plane of an occluding wall.
+*/
+namespace {
+	// Positions are passed straight through as clip space, so NDC is the position itself
+	const glm::mat4 IDENTITY{ 1.f };
+
+	const std::vector<uint32_t> QUAD_INDICES{ 0, 1, 2, 0, 2, 3 };
+
+	std::vector<glm::vec3> GetQuad(glm::vec2 min, glm::vec2 max, float min_x_z, float max_x_z) {
+		return { { min.x, min.y, min_x_z }, { max.x, min.y, max_x_z }, { max.x, max.y, max_x_z }, { min.x, max.y, min_x_z } };
+	}
+
+	glm::mat4 GetCameraProjView() {
+		return glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 100.f) * glm::lookAt(glm::vec3{ 0, 0, 0 }, glm::vec3{ 0, 0, -1 }, glm::vec3{ 0, 1, 0 });
+	}
+
+	// Wall of [-5, 5] on x and y, 10 units in front of GetCameraProjView
+	void AddWall(OcclusionBuffer& buffer, const glm::mat4& proj_view) {
+		buffer.AddOccluder(proj_view, GetQuad({ -5, -5 }, { 5, 5 }, -10.f, -10.f), QUAD_INDICES);
+	}
+
+	// Pixel 'x' of 'size' pixels in NDC
+	float PixelToNDC(uint32_t x, uint32_t size) {
+		return ((float)x + 0.5f) / (float)size * 2.f - 1.f;
+	}
+
+	// Independent of the Hi-Z pyramid: a box must be visible if any point sampled over its faces is nearer than the depth at its pixel
+	bool HasVisibleSample(const OcclusionBuffer& buffer, const glm::mat4& proj_view, glm::vec3 center, glm::vec3 extents) {
+		constexpr int SAMPLES = 6;
+		auto& depth = buffer.GetDepth();
+
+		for (int axis = 0; axis < 3; axis++) {
+			for (float side : { -1.f, 1.f }) {
+				for (int i = 0; i < SAMPLES; i++) {
+					for (int j = 0; j < SAMPLES; j++) {
+						glm::vec3 offset;
+						offset[axis] = side;
+						offset[(axis + 1) % 3] = i / (SAMPLES - 1.f) * 2.f - 1.f;
+						offset[(axis + 2) % 3] = j / (SAMPLES - 1.f) * 2.f - 1.f;
+
+						glm::vec4 clip = proj_view * glm::vec4(center + offset * extents, 1.f);
+						if (clip.w <= 1e-5f)
+							return true;
+
+						glm::vec3 ndc = glm::vec3(clip) / clip.w;
+						glm::vec2 px = (glm::vec2(ndc) * 0.5f + 0.5f) * glm::vec2(buffer.GetWidth(), buffer.GetHeight());
+						if (px.x < 0.f || px.y < 0.f || px.x >= buffer.GetWidth() || px.y >= buffer.GetHeight())
+							continue;
+
+						if (ndc.z < depth[(uint32_t)px.y * buffer.GetWidth() + (uint32_t)px.x])
+							return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+}
+
+static void TestKnownQuad() {
+	OcclusionBuffer buffer;
+	buffer.Init(62, 32);
+	SNK_CHECK(buffer.GetWidth() == 64 && buffer.GetHeight() == 32);
+
+	// [-0.5, 0.5] in NDC is pixels [16, 48) by [8, 24), no pixel center lies on an edge
+	buffer.AddOccluder(IDENTITY, GetQuad({ -0.5f, -0.5f }, { 0.5f, 0.5f }, 0.25f, 0.25f), QUAD_INDICES);
+	SNK_CHECK(buffer.GetNumTriangles() == 2);
+	buffer.Rasterize();
+
+	bool depth_matches = true;
+	uint32_t num_covered = 0;
+	for (uint32_t y = 0; y < 32; y++) {
+		for (uint32_t x = 0; x < 64; x++) {
+			bool inside = x >= 16 && x < 48 && y >= 8 && y < 24;
+			float d = buffer.GetDepth()[y * 64 + x];
+			depth_matches &= inside ? glm::abs(d - 0.25f) < 1e-6f : d == 1.f;
+			num_covered += d < 1.f;
+		}
+	}
+	SNK_CHECK(depth_matches);
+
+	// The diagonal shared by both triangles leaves no gaps
+	SNK_CHECK(num_covered == 32 * 16);
+
+	// Full screen quad sloping from 0.2 to 0.8 across x, wound clockwise this time, with a nearer quad over part of it
+	buffer.Clear();
+	SNK_CHECK(buffer.GetNumTriangles() == 0 && std::ranges::all_of(buffer.GetDepth(), [](float d) { return d == 1.f; }));
+
+	buffer.AddOccluder(IDENTITY, GetQuad({ -1, -1 }, { 1, 1 }, 0.2f, 0.8f), { 0, 2, 1, 0, 3, 2 });
+	buffer.AddOccluder(IDENTITY, GetQuad({ 0, -1 }, { 1, 0 }, 0.1f, 0.1f), QUAD_INDICES);
+	buffer.Rasterize();
+
+	bool slope_matches = true;
+	for (uint32_t y = 0; y < 32; y++) {
+		for (uint32_t x = 0; x < 64; x++) {
+			float expected = x >= 32 && y < 16 ? 0.1f : 0.2f + 0.3f * (PixelToNDC(x, 64) + 1.f);
+			slope_matches &= glm::abs(buffer.GetDepth()[y * 64 + x] - expected) < 1e-5f;
+		}
+	}
+	SNK_CHECK(slope_matches);
+
+	// Triangles with a vertex in front of the near plane or behind the eye are dropped, as are off screen and degenerate ones
+	buffer.Clear();
+	buffer.AddOccluder(IDENTITY, GetQuad({ -0.5f, -0.5f }, { 0.5f, 0.5f }, -0.1f, 0.5f), QUAD_INDICES);
+	buffer.AddOccluder(GetCameraProjView(), GetQuad({ -5, -5 }, { 5, 5 }, 1.f, -10.f), QUAD_INDICES);
+	buffer.AddOccluder(IDENTITY, GetQuad({ 1.5f, -0.5f }, { 2.f, 0.5f }, 0.5f, 0.5f), QUAD_INDICES);
+	buffer.AddOccluder(IDENTITY, { { 0, 0, 0.5f }, { 0.5f, 0.5f, 0.5f }, { 1, 1, 0.5f } }, { 0, 1, 2 });
+	SNK_CHECK(buffer.GetNumTriangles() == 0);
+}
+
+static void TestHiZConservative() {
+	// Odd sizes so the last row and column of each level are clamped
+	OcclusionBuffer buffer;
+	buffer.Init(100, 37);
+
+	std::mt19937 rng(28);
+	std::uniform_real_distribution<float> xy_dist(-1.2f, 1.2f);
+	std::uniform_real_distribution<float> z_dist(0.01f, 0.99f);
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	for (uint32_t i = 0; i < 40 * 3; i++) {
+		positions.emplace_back(xy_dist(rng), xy_dist(rng), z_dist(rng));
+		indices.push_back(i);
+	}
+
+	buffer.AddOccluder(IDENTITY, positions, indices);
+	buffer.Rasterize();
+
+	glm::uvec2 base_size = buffer.GetLevelSize(0);
+	auto& depth = buffer.GetDepth();
+	bool never_under_reports = true;
+
+	for (uint32_t level = 1; level < buffer.GetNumLevels(); level++) {
+		glm::uvec2 size = buffer.GetLevelSize(level);
+		auto& hiz = buffer.GetLevel(level);
+
+		for (uint32_t y = 0; y < size.y; y++) {
+			for (uint32_t x = 0; x < size.x; x++) {
+				// Every full resolution pixel this texel covers
+				float max_depth = 0.f;
+				for (uint32_t py = y << level; py < glm::min((y + 1) << level, base_size.y); py++) {
+					for (uint32_t px = x << level; px < glm::min((x + 1) << level, base_size.x); px++) {
+						max_depth = glm::max(max_depth, depth[py * base_size.x + px]);
+					}
+				}
+
+				never_under_reports &= hiz[y * size.x + x] >= max_depth;
+			}
+		}
+	}
+	SNK_CHECK(never_under_reports);
+
+	auto last_size = buffer.GetLevelSize(buffer.GetNumLevels() - 1);
+	SNK_CHECK(last_size.x == 1 && last_size.y == 1);
+	SNK_CHECK(buffer.GetLevel(buffer.GetNumLevels() - 1)[0] == std::ranges::max(depth));
+
+	// Some pixels were covered and some weren't, so the test isn't trivially passed by a cleared buffer
+	SNK_CHECK(std::ranges::min(depth) < 1.f && std::ranges::max(depth) == 1.f);
+}
+
+static void TestKnownBoxes() {
+	auto proj_view = GetCameraProjView();
+
+	OcclusionBuffer buffer;
+	buffer.Init(320, 180);
+	AddWall(buffer, proj_view);
+	buffer.Rasterize();
+
+	struct Case {
+		glm::vec3 center;
+		glm::vec3 extents;
+		bool visible;
+	};
+
+	std::vector<Case> cases = {
+		// Behind the wall
+		{ { 0, 0, -20 }, glm::vec3(1.f), false },
+		{ { 2, -2, -40 }, glm::vec3(3.f), false },
+		// In front of the wall
+		{ { 0, 0, -5 }, glm::vec3(1.f), true },
+		// Beside it, and behind it but reaching past its edge
+		{ { 15, 0, -20 }, glm::vec3(1.f), true },
+		{ { 14, 0, -24 }, glm::vec3(2.f), true },
+		// Through the wall
+		{ { 0, 0, -10 }, { 1, 1, 3 }, true },
+		// Across the near plane, around the eye and entirely behind the eye are left to frustum culling
+		{ { 0, 0, -0.1f }, glm::vec3(0.5f), true },
+		{ { 0, 0, 0 }, glm::vec3(1.f), true },
+		{ { 0, 0, 20 }, glm::vec3(1.f), true },
+	};
+
+	CullingBoundsSoA bounds;
+	bounds.Resize((uint32_t)cases.size());
+
+	// Tested in reverse so the output is checked to follow 'in' rather than the bounds
+	std::vector<uint32_t> in;
+	std::vector<uint32_t> expected{ UINT32_MAX };
+	for (uint32_t i = 0; i < cases.size(); i++) {
+		bounds.Set(i, cases[i].center, cases[i].extents);
+		in.insert(in.begin(), i);
+	}
+	for (uint32_t i : in) {
+		if (cases[i].visible)
+			expected.push_back(i);
+	}
+
+	// Existing contents of 'out' are kept
+	std::vector<uint32_t> out{ UINT32_MAX };
+	buffer.TestVisible(bounds, proj_view, in, out);
+	SNK_CHECK(out == expected);
+
+	bool matches_is_visible = true;
+	for (auto& c : cases) {
+		matches_is_visible &= buffer.IsVisible(proj_view, c.center, c.extents) == c.visible;
+	}
+	SNK_CHECK(matches_is_visible);
+
+	// The same wall crossing the near plane is dropped, so nothing is occluded
+	OcclusionBuffer crossing;
+	crossing.Init(320, 180);
+	crossing.AddOccluder(proj_view, GetQuad({ -5, -5 }, { 5, 5 }, 1.f, -10.f), QUAD_INDICES);
+	crossing.Rasterize();
+
+	out.clear();
+	crossing.TestVisible(bounds, proj_view, in, out);
+	SNK_CHECK(out == in);
+}
+
+static void TestRandomBoxes() {
+	auto proj_view = GetCameraProjView();
+
+	// Walls at different depths and offsets, some overlapping
+	OcclusionBuffer buffer;
+	buffer.Init(320, 180);
+	std::mt19937 rng(29);
+	std::uniform_real_distribution<float> offset_dist(-8.f, 8.f);
+	std::uniform_real_distribution<float> depth_dist(-30.f, -5.f);
+	for (uint32_t i = 0; i < 12; i++) {
+		glm::vec2 offset{ offset_dist(rng), offset_dist(rng) };
+		float z = depth_dist(rng);
+		buffer.AddOccluder(proj_view, GetQuad(offset - 3.f, offset + 3.f, z, z + offset_dist(rng) * 0.25f), QUAD_INDICES);
+	}
+	buffer.Rasterize();
+
+	// More boxes than one TestVisible job takes
+	constexpr uint32_t NUM_BOXES = FrustumCuller::JOB_CHUNK_SIZE;
+	std::uniform_real_distribution<float> xy_dist(-25.f, 25.f);
+	std::uniform_real_distribution<float> z_dist(-60.f, 2.f);
+	std::uniform_real_distribution<float> size_dist(0.05f, 2.f);
+
+	CullingBoundsSoA bounds;
+	bounds.Resize(NUM_BOXES);
+	std::vector<uint32_t> in(NUM_BOXES);
+	for (uint32_t i = 0; i < NUM_BOXES; i++) {
+		bounds.Set(i, { xy_dist(rng), xy_dist(rng), z_dist(rng) }, { size_dist(rng), size_dist(rng), size_dist(rng) });
+		in[i] = i;
+	}
+
+	std::vector<uint32_t> out;
+	buffer.TestVisible(bounds, proj_view, in, out);
+
+	std::vector<uint32_t> expected;
+	bool never_hides_visible = true;
+	for (uint32_t i = 0; i < NUM_BOXES; i++) {
+		glm::vec3 center{ bounds.center_x[i], bounds.center_y[i], bounds.center_z[i] };
+		glm::vec3 extents{ bounds.extent_x[i], bounds.extent_y[i], bounds.extent_z[i] };
+
+		if (buffer.IsVisible(proj_view, center, extents))
+			expected.push_back(i);
+		else
+			never_hides_visible &= !HasVisibleSample(buffer, proj_view, center, extents);
+	}
+
+	SNK_CHECK(out == expected);
+	SNK_CHECK(never_hides_visible);
+	SNK_CHECK(!out.empty() && out.size() < NUM_BOXES);
+}
+
+int main() {
+	Test::Init();
+	JobSystem::Init();
+
+	TestKnownQuad();
+	TestHiZConservative();
+	TestKnownBoxes();
+	TestRandomBoxes();
+
+	JobSystem::Shutdown();
+	return Test::Finish("OCCLUSION_CULLING_TESTS");
+}
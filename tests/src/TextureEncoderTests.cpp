@@ -0,0 +1,383 @@
+#include "TestCommon.h"
+#include "assets/TextureEncoder.h"
+#include "core/JobSystem.h"
+
+using namespace SNAKE;
+
+/*
+Encodes generated images with TextureEncoder, decodes them again with the reference decoders below and checks the PSNR of every format SelectFormat can return.
+Only the BC7 mode the encoder writes (mode 6) is decoded, any other mode fails the test.
+Noise is incompressible so it only checks blocks decode, sizes that aren't a multiple of 4 check edge blocks.
+*/
+namespace {
+	enum class Image {
+		GRADIENT,
+		NATURAL,
+		NOISE,
+		NORMAL_MAP,
+	};
+
+	std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height, Image kind) {
+		std::vector<uint8_t> rgba(width * height * 4);
+		std::mt19937 rng(7);
+
+		for (uint32_t y = 0; y < height; y++) {
+			for (uint32_t x = 0; x < width; x++) {
+				uint8_t* p = &rgba[(y * width + x) * 4];
+				switch (kind) {
+				case Image::GRADIENT:
+					p[0] = (uint8_t)(x * 255 / std::max(width - 1, 1u));
+					p[1] = (uint8_t)(y * 255 / std::max(height - 1, 1u));
+					p[2] = (uint8_t)((x + y) * 127 / (width + height));
+					p[3] = (uint8_t)(255 - x * 200 / width);
+					break;
+				case Image::NATURAL: {
+					// Smooth shading with hard edges and a little grain
+					float v = 0.5f + 0.25f * std::sin(x * 0.13f) + 0.25f * std::cos(y * 0.07f + x * 0.02f);
+					int edge = ((x / 23 + y / 17) & 1) * 60;
+					p[0] = (uint8_t)std::clamp((int)(v * 180) + edge, 0, 255);
+					p[1] = (uint8_t)std::clamp((int)(v * 140) + edge / 2 + 20, 0, 255);
+					p[2] = (uint8_t)std::clamp((int)(v * 90) + (int)(rng() % 8), 0, 255);
+					p[3] = 255;
+					break;
+				}
+				case Image::NOISE:
+					for (int c = 0; c < 4; c++) {
+						p[c] = (uint8_t)rng();
+					}
+					break;
+				case Image::NORMAL_MAP: {
+					float nx = 0.4f * std::sin(x * 0.1f);
+					float ny = 0.4f * std::cos(y * 0.08f);
+					float nz = std::sqrt(1.f - nx * nx - ny * ny);
+					p[0] = (uint8_t)((nx * 0.5f + 0.5f) * 255.f + 0.5f);
+					p[1] = (uint8_t)((ny * 0.5f + 0.5f) * 255.f + 0.5f);
+					p[2] = (uint8_t)((nz * 0.5f + 0.5f) * 255.f + 0.5f);
+					p[3] = 255;
+					break;
+				}
+				}
+			}
+		}
+
+		return rgba;
+	}
+
+	void Decode565(uint16_t c, int* p_out) {
+		int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+		p_out[0] = (r << 3) | (r >> 2);
+		p_out[1] = (g << 2) | (g >> 4);
+		p_out[2] = (b << 3) | (b >> 2);
+	}
+
+	// BC3 colour blocks always use four colours, 'bc3' forces it
+	void DecodeBlockBC1(const uint8_t* p_block, uint8_t* p_texels, bool bc3) {
+		uint16_t c0, c1;
+		uint32_t indices;
+		std::memcpy(&c0, p_block, 2);
+		std::memcpy(&c1, p_block + 2, 2);
+		std::memcpy(&indices, p_block + 4, 4);
+
+		int palette[4][4];
+		Decode565(c0, palette[0]);
+		Decode565(c1, palette[1]);
+		for (auto& colour : palette) {
+			colour[3] = 255;
+		}
+
+		for (int c = 0; c < 3; c++) {
+			if (c0 > c1 || bc3) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+				palette[3][3] = 0;
+			}
+		}
+
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				p_texels[i * 4 + c] = (uint8_t)palette[(indices >> (2 * i)) & 3][c];
+			}
+		}
+	}
+
+	// One BC4 channel, as used for BC3 alpha and both BC5 channels
+	void DecodeBlockBC4(const uint8_t* p_block, uint8_t* p_texels, int channel) {
+		int a0 = p_block[0], a1 = p_block[1];
+		uint64_t bits;
+		std::memcpy(&bits, p_block, 8);
+		bits >>= 16;
+
+		int palette[8] = { a0, a1 };
+		if (a0 > a1) {
+			for (int i = 2; i < 8; i++) {
+				palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+			}
+		}
+		else {
+			for (int i = 2; i < 6; i++) {
+				palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			p_texels[i * 4 + channel] = (uint8_t)palette[(bits >> (3 * i)) & 7];
+		}
+	}
+
+	struct BitReader {
+		const uint8_t* p_data;
+		uint32_t pos = 0;
+
+		uint32_t Read(uint32_t num_bits) {
+			uint32_t v = 0;
+			for (uint32_t i = 0; i < num_bits; i++, pos++) {
+				v |= ((p_data[pos / 8] >> (pos % 8)) & 1) << i;
+			}
+			return v;
+		}
+	};
+
+	bool DecodeBlockBC7Mode6(const uint8_t* p_block, uint8_t* p_texels) {
+		BitReader reader{ p_block };
+		if (reader.Read(7) != 0b1000000)
+			return false;
+
+		int endpoints[2][4];
+		for (int c = 0; c < 4; c++) {
+			for (auto& endpoint : endpoints) {
+				endpoint[c] = (int)reader.Read(7);
+			}
+		}
+
+		for (auto& endpoint : endpoints) {
+			uint32_t p_bit = reader.Read(1);
+			for (int& channel : endpoint) {
+				channel = (channel << 1) | (int)p_bit;
+			}
+		}
+
+		constexpr std::array<int, 16> WEIGHTS = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for (int i = 0; i < 16; i++) {
+			// The anchor index drops its top bit
+			int weight = WEIGHTS[reader.Read(i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; c++) {
+				p_texels[i * 4 + c] = (uint8_t)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+			}
+		}
+
+		return reader.pos == 128;
+	}
+
+	// Empty if any block fails to decode
+	std::vector<uint8_t> Decode(const std::vector<std::byte>& encoded, uint32_t width, uint32_t height, vk::Format format) {
+		std::vector<uint8_t> rgba(width * height * 4);
+		uint32_t blocks_x = (width + 3) / 4;
+		uint32_t blocks_y = (height + 3) / 4;
+		uint64_t block_size = TextureEncoder::GetMipSize(format, 4, 4);
+
+		for (uint32_t by = 0; by < blocks_y; by++) {
+			for (uint32_t bx = 0; bx < blocks_x; bx++) {
+				auto* p_block = reinterpret_cast<const uint8_t*>(encoded.data()) + (by * blocks_x + bx) * block_size;
+				std::array<uint8_t, 64> texels;
+				texels.fill(255);
+
+				switch (format) {
+				case vk::Format::eBc1RgbUnormBlock:
+					DecodeBlockBC1(p_block, texels.data(), false);
+					break;
+				case vk::Format::eBc3UnormBlock:
+					DecodeBlockBC1(p_block + 8, texels.data(), true);
+					DecodeBlockBC4(p_block, texels.data(), 3);
+					break;
+				case vk::Format::eBc5UnormBlock:
+					DecodeBlockBC4(p_block, texels.data(), 0);
+					DecodeBlockBC4(p_block + 8, texels.data(), 1);
+					break;
+				default:
+					if (!DecodeBlockBC7Mode6(p_block, texels.data()))
+						return {};
+				}
+
+				for (uint32_t y = 0; y < 4; y++) {
+					for (uint32_t x = 0; x < 4; x++) {
+						uint32_t px = bx * 4 + x, py = by * 4 + y;
+						if (px < width && py < height)
+							std::memcpy(&rgba[(py * width + px) * 4], &texels[(y * 4 + x) * 4], 4);
+					}
+				}
+			}
+		}
+
+		return rgba;
+	}
+
+	// Of the channels the format stores, BC1 has no alpha and BC5 only RG
+	double PSNR(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, vk::Format format) {
+		uint32_t num_channels = format == vk::Format::eBc1RgbUnormBlock ? 3 : format == vk::Format::eBc5UnormBlock ? 2 : 4;
+		double squared_error = 0.0;
+		uint64_t count = 0;
+		for (size_t i = 0; i < a.size(); i += 4) {
+			for (uint32_t c = 0; c < num_channels; c++) {
+				double d = (double)a[i + c] - (double)b[i + c];
+				squared_error += d * d;
+				count++;
+			}
+		}
+
+		double mse = squared_error / (double)count;
+		return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+	const char* GetImageName(Image image) {
+		switch (image) {
+		case Image::GRADIENT: return "gradient";
+		case Image::NATURAL: return "natural";
+		case Image::NOISE: return "noise";
+		default: return "normal map";
+		}
+	}
+
+	const char* GetFormatName(vk::Format format) {
+		switch (format) {
+		case vk::Format::eBc1RgbUnormBlock: return "BC1";
+		case vk::Format::eBc3UnormBlock: return "BC3";
+		case vk::Format::eBc5UnormBlock: return "BC5";
+		default: return "BC7";
+		}
+	}
+}
+
+static void TestFormats() {
+	SNK_CHECK(TextureEncoder::SelectFormat(TextureEncoder::Usage::ALBEDO, true) == vk::Format::eBc7SrgbBlock);
+	SNK_CHECK(TextureEncoder::SelectFormat(TextureEncoder::Usage::NORMAL, false) == vk::Format::eBc5UnormBlock);
+	SNK_CHECK(TextureEncoder::SelectFormat(TextureEncoder::Usage::MASK, false) == vk::Format::eBc1RgbUnormBlock);
+	SNK_CHECK(TextureEncoder::SelectFormat(TextureEncoder::Usage::MASK, true) == vk::Format::eBc3UnormBlock);
+
+	// .tex2d headers with any other format are rejected
+	for (auto format : { vk::Format::eBc7SrgbBlock, vk::Format::eBc5UnormBlock, vk::Format::eBc1RgbUnormBlock, vk::Format::eBc3UnormBlock }) {
+		SNK_CHECK(TextureEncoder::IsSelectableFormat(format));
+	}
+	for (auto format : { vk::Format::eUndefined, vk::Format::eR8G8B8A8Unorm, vk::Format::eR8G8B8A8Srgb, vk::Format::eBc1RgbSrgbBlock, vk::Format::eBc4UnormBlock,
+		vk::Format::eBc6HUfloatBlock, vk::Format::eR32G32B32A32Sfloat }) {
+		SNK_CHECK(!TextureEncoder::IsSelectableFormat(format));
+	}
+
+	SNK_CHECK(TextureEncoder::GetMipSize(vk::Format::eBc1RgbUnormBlock, 5, 1) == 2 * 8);
+	SNK_CHECK(TextureEncoder::GetMipSize(vk::Format::eBc7SrgbBlock, 5, 9) == 2 * 3 * 16);
+	SNK_CHECK(TextureEncoder::GetMipSize(vk::Format::eR8G8B8A8Srgb, 5, 9) == 5 * 9 * 4);
+}
+
+static void TestPSNR() {
+	struct Case {
+		Image image;
+		vk::Format format;
+		double min_psnr;
+	};
+
+	// Thresholds sit a few dB under what the encoder reaches, noise has none
+	const std::array cases = {
+		Case{ Image::GRADIENT, vk::Format::eBc1RgbUnormBlock, 32.0 },
+		Case{ Image::GRADIENT, vk::Format::eBc3UnormBlock, 33.0 },
+		Case{ Image::GRADIENT, vk::Format::eBc7SrgbBlock, 32.0 },
+		Case{ Image::NATURAL, vk::Format::eBc1RgbUnormBlock, 36.0 },
+		Case{ Image::NATURAL, vk::Format::eBc3UnormBlock, 37.0 },
+		Case{ Image::NATURAL, vk::Format::eBc7SrgbBlock, 42.0 },
+		Case{ Image::NORMAL_MAP, vk::Format::eBc5UnormBlock, 50.0 },
+		Case{ Image::NOISE, vk::Format::eBc1RgbUnormBlock, 0.0 },
+		Case{ Image::NOISE, vk::Format::eBc3UnormBlock, 0.0 },
+		Case{ Image::NOISE, vk::Format::eBc5UnormBlock, 0.0 },
+		Case{ Image::NOISE, vk::Format::eBc7SrgbBlock, 0.0 },
+	};
+
+	for (auto [width, height] : { std::pair{ 256u, 256u }, std::pair{ 37u, 19u } }) {
+		for (auto& c : cases) {
+			auto rgba = MakeImage(width, height, c.image);
+			auto encoded = TextureEncoder::Encode(reinterpret_cast<const std::byte*>(rgba.data()), width, height, c.format);
+			SNK_CHECK(encoded.size() == TextureEncoder::GetMipSize(c.format, width, height));
+
+			auto decoded = Decode(encoded, width, height, c.format);
+			SNK_CHECK(!decoded.empty());
+			if (decoded.empty())
+				continue;
+
+			double psnr = PSNR(rgba, decoded, c.format);
+			SNK_CORE_INFO("{}x{} {} {}: {} dB", width, height, GetImageName(c.image), GetFormatName(c.format), psnr);
+			SNK_CHECK(psnr >= c.min_psnr);
+		}
+	}
+}
+
+static void TestSmallAndSolid() {
+	// Sizes smaller than a block repeat the last row/column into the padding
+	for (auto [width, height] : { std::pair{ 1u, 1u }, std::pair{ 2u, 3u }, std::pair{ 5u, 1u } }) {
+		auto rgba = MakeImage(width, height, Image::NATURAL);
+		for (auto format : { vk::Format::eBc1RgbUnormBlock, vk::Format::eBc3UnormBlock, vk::Format::eBc5UnormBlock, vk::Format::eBc7SrgbBlock }) {
+			auto encoded = TextureEncoder::Encode(reinterpret_cast<const std::byte*>(rgba.data()), width, height, format);
+			SNK_CHECK(encoded.size() == TextureEncoder::GetMipSize(format, width, height));
+			auto decoded = Decode(encoded, width, height, format);
+			SNK_CHECK(!decoded.empty() && PSNR(rgba, decoded, format) >= 38.0);
+		}
+	}
+
+	// A single colour is reproduced to within the precision of the endpoints
+	std::vector<uint8_t> solid(16 * 16 * 4);
+	for (size_t i = 0; i < solid.size(); i += 4) {
+		solid[i] = 200;
+		solid[i + 1] = 13;
+		solid[i + 2] = 77;
+		solid[i + 3] = 128;
+	}
+
+	for (auto format : { vk::Format::eBc1RgbUnormBlock, vk::Format::eBc3UnormBlock, vk::Format::eBc5UnormBlock, vk::Format::eBc7SrgbBlock }) {
+		auto decoded = Decode(TextureEncoder::Encode(reinterpret_cast<const std::byte*>(solid.data()), 16, 16, format), 16, 16, format);
+		SNK_CHECK(!decoded.empty() && PSNR(solid, decoded, format) >= 40.0);
+	}
+}
+
+static void TestMips() {
+	constexpr uint32_t WIDTH = 37;
+	constexpr uint32_t HEIGHT = 19;
+	SNK_CHECK(TextureEncoder::GetNumMips(WIDTH, HEIGHT) == 6);
+
+	auto rgba = MakeImage(WIDTH, HEIGHT, Image::GRADIENT);
+	auto mips = TextureEncoder::GenerateMips(reinterpret_cast<const std::byte*>(rgba.data()), WIDTH, HEIGHT, TextureEncoder::Usage::MASK);
+	SNK_CHECK(mips.size() == TextureEncoder::GetNumMips(WIDTH, HEIGHT) - 1);
+
+	bool sizes_match = true;
+	for (uint32_t i = 0; i < mips.size(); i++) {
+		sizes_match &= mips[i].size() == (size_t)std::max(WIDTH >> (i + 1), 1u) * std::max(HEIGHT >> (i + 1), 1u) * 4;
+	}
+	SNK_CHECK(sizes_match);
+
+	// Flat normals stay flat through filtering and renormalisation
+	std::vector<uint8_t> flat(64 * 64 * 4);
+	for (size_t i = 0; i < flat.size(); i += 4) {
+		flat[i] = 128;
+		flat[i + 1] = 128;
+		flat[i + 2] = 255;
+		flat[i + 3] = 255;
+	}
+
+	auto normal_mips = TextureEncoder::GenerateMips(reinterpret_cast<const std::byte*>(flat.data()), 64, 64, TextureEncoder::Usage::NORMAL);
+	auto* p_last = reinterpret_cast<const uint8_t*>(normal_mips.back().data());
+	SNK_CHECK(normal_mips.back().size() == 4 && std::abs(p_last[0] - 128) <= 1 && std::abs(p_last[1] - 128) <= 1 && p_last[2] >= 254);
+}
+
+int main() {
+	Test::Init();
+	JobSystem::Init();
+
+	TestFormats();
+	TestPSNR();
+	TestSmallAndSolid();
+	TestMips();
+
+	JobSystem::Shutdown();
+	return Test::Finish("TEXTURE_ENCODER_TESTS");
+}
@@ -0,0 +1,233 @@
+#include "TestCommon.h"
+#include "assets/TextureResidencyPolicy.h"
+
+using namespace SNAKE;
+using Policy = TextureResidencyPolicy;
+
+namespace {
+	// Level sizes of a square BC7 texture, finest first
+	std::vector<uint64_t> GetBC7MipSizes(uint32_t size) {
+		std::vector<uint64_t> sizes;
+		for (uint32_t s = size;; s /= 2) {
+			uint64_t blocks = (s + 3) / 4;
+			sizes.push_back(blocks * blocks * 16);
+			if (s == 1)
+				break;
+		}
+
+		return sizes;
+	}
+
+	uint64_t SumFrom(const std::vector<uint64_t>& sizes, size_t first) {
+		return std::accumulate(sizes.begin() + first, sizes.end(), uint64_t(0));
+	}
+
+	// Changes are applied straight away, TextureResidencyManager does so once their mips have been read
+	void Apply(Policy& policy, const std::vector<Policy::Change>& changes) {
+		for (auto change : changes) {
+			policy.CompleteChange(change.id, change.top_mip);
+		}
+	}
+}
+
+static void TestStreamsUpToRequest() {
+	Policy policy;
+	policy.budget_bytes = 1ull << 30;
+
+	// 12 levels, the tail starts at 128x128
+	auto sizes = GetBC7MipSizes(2048);
+	auto id = policy.AddTexture(sizes, 4, 0);
+	SNK_CHECK(policy.GetResidentTop(id) == 4);
+	SNK_CHECK(policy.GetResidentBytes() == SumFrom(sizes, 4));
+
+	// The finest request in a frame wins
+	policy.Request(id, 1, 1);
+	policy.Request(id, 3, 1);
+	auto changes = policy.Update(1);
+	SNK_CHECK(changes.size() == 1 && changes[0].top_mip == 1);
+	SNK_CHECK(policy.IsChangePending(id));
+
+	// Nothing more is planned for a texture with a change in flight
+	policy.Request(id, 0, 2);
+	SNK_CHECK(policy.Update(2).empty());
+
+	Apply(policy, changes);
+	changes = policy.Update(2);
+	SNK_CHECK(changes.size() == 1 && changes[0].top_mip == 0);
+	Apply(policy, changes);
+	SNK_CHECK(policy.GetResidentBytes() == SumFrom(sizes, 0));
+
+	// A coarser request doesn't evict anything while under budget
+	policy.Request(id, 9, 3);
+	SNK_CHECK(policy.Update(3).empty());
+
+	policy.RemoveTexture(id);
+	SNK_CHECK(policy.GetResidentBytes() == 0 && policy.GetNumTextures() == 0);
+}
+
+static void TestEvictsLeastRecentlyRequested() {
+	Policy policy;
+	auto sizes = GetBC7MipSizes(2048);
+	uint64_t full = SumFrom(sizes, 0);
+	uint64_t tail = SumFrom(sizes, 4);
+
+	// 8 textures with room for 3 at full resolution
+	policy.budget_bytes = 3 * full + 5 * tail;
+	std::vector<Policy::TextureID> ids;
+	for (int i = 0; i < 8; i++) {
+		ids.push_back(policy.AddTexture(sizes, 4, 0));
+	}
+
+	for (int i = 0; i < 3; i++) {
+		policy.Request(ids[i], 0, 1);
+	}
+
+	auto changes = policy.Update(1);
+	SNK_CHECK(changes.size() == 3);
+	Apply(policy, changes);
+	SNK_CHECK(policy.GetResidentBytes() <= policy.budget_bytes);
+
+	for (int i = 1; i <= 4; i++) {
+		policy.Request(ids[i], 0, 10);
+	}
+
+	// ids[0] is least recently requested so it's evicted to make room for ids[3]
+	changes = policy.Update(10);
+	SNK_CHECK(std::ranges::any_of(changes, [&](Policy::Change change) { return change.id == ids[0] && change.top_mip == 4; }));
+	Apply(policy, changes);
+
+	SNK_CHECK(policy.GetResidentBytes() <= policy.budget_bytes);
+	SNK_CHECK(policy.GetResidentTop(ids[1]) == 0 && policy.GetResidentTop(ids[2]) == 0 && policy.GetResidentTop(ids[3]) == 0);
+
+	// Textures requested this frame aren't evicted for it, so ids[4] only gets what fits
+	SNK_CHECK(policy.GetResidentTop(ids[4]) > 0);
+}
+
+static void TestDropsOverResidentMipsFirst() {
+	Policy policy;
+	auto sizes = GetBC7MipSizes(1024);
+	uint64_t full = SumFrom(sizes, 0);
+	policy.budget_bytes = 2 * full + SumFrom(sizes, 3) + full / 16;
+
+	auto a = policy.AddTexture(sizes, 3, 0);
+	auto b = policy.AddTexture(sizes, 3, 0);
+	auto c = policy.AddTexture(sizes, 3, 0);
+	policy.Request(a, 0, 1);
+	policy.Request(b, 0, 1);
+	Apply(policy, policy.Update(1));
+
+	// 'a' now only needs mip 2, 'b' was requested less recently but its request hasn't expired
+	policy.Request(a, 2, 5);
+	policy.Request(c, 0, 5);
+	Apply(policy, policy.Update(5));
+
+	SNK_CHECK(policy.GetResidentTop(a) == 2);
+	SNK_CHECK(policy.GetResidentTop(b) == 0);
+	SNK_CHECK(policy.GetResidentTop(c) == 0);
+}
+
+static void TestStreamLimitPerUpdate() {
+	Policy policy;
+	policy.budget_bytes = 1ull << 40;
+	policy.max_stream_bytes_per_update = 20 * 1024 * 1024;
+
+	// Each is over 20MB at full resolution, so one streams in per update
+	auto sizes = GetBC7MipSizes(4096);
+	std::vector<Policy::TextureID> ids;
+	for (int i = 0; i < 10; i++) {
+		ids.push_back(policy.AddTexture(sizes, 5, 0));
+		policy.Request(ids.back(), 0, 1);
+	}
+
+	uint32_t num_updates = 0;
+	for (uint64_t frame = 1;; frame++) {
+		auto changes = policy.Update(frame);
+		if (changes.empty())
+			break;
+
+		Apply(policy, changes);
+		num_updates++;
+
+		for (auto id : ids) {
+			policy.Request(id, 0, frame + 1);
+		}
+	}
+
+	SNK_CHECK(num_updates == 10);
+}
+
+static void TestLoweredBudgetEvictsExpired() {
+	Policy policy;
+	policy.budget_bytes = 1ull << 40;
+	policy.request_lifetime_frames = 10;
+
+	auto sizes = GetBC7MipSizes(2048);
+	auto a = policy.AddTexture(sizes, 4, 0);
+	auto b = policy.AddTexture(sizes, 4, 0);
+	policy.Request(a, 0, 1);
+	policy.Request(b, 0, 1);
+	Apply(policy, policy.Update(1));
+
+	policy.budget_bytes = policy.GetResidentBytes() - 1;
+	policy.Request(b, 0, 50);
+	Apply(policy, policy.Update(50));
+
+	SNK_CHECK(policy.GetResidentTop(a) == 4 && policy.GetResidentTop(b) == 0);
+	SNK_CHECK(policy.GetResidentBytes() <= policy.budget_bytes);
+}
+
+// Random requests over a moving window of textures, resident bytes must always match the levels actually resident
+static void TestRandomSoak() {
+	Policy policy;
+	policy.budget_bytes = 256ull * 1024 * 1024;
+	policy.max_stream_bytes_per_update = 32 * 1024 * 1024;
+
+	std::mt19937 rng(1);
+	std::vector<Policy::TextureID> ids;
+	std::vector<std::vector<uint64_t>> sizes;
+	for (int i = 0; i < 200; i++) {
+		uint32_t size = 1u << (6 + rng() % 7);
+		uint32_t tail_top = 0;
+		while ((size >> tail_top) > 128) {
+			tail_top++;
+		}
+
+		sizes.push_back(GetBC7MipSizes(size));
+		ids.push_back(policy.AddTexture(sizes.back(), tail_top, 0));
+	}
+
+	// Changes complete a frame after they're planned, as they do in TextureResidencyManager
+	std::vector<Policy::Change> in_flight;
+	for (uint64_t frame = 1; frame < 2000; frame++) {
+		uint32_t window_start = (uint32_t)((frame / 100 * 17) % 150);
+		for (int i = 0; i < 30; i++) {
+			policy.Request(ids[window_start + rng() % 50], rng() % 3, frame);
+		}
+
+		Apply(policy, in_flight);
+		in_flight = policy.Update(frame);
+
+		uint64_t resident = 0;
+		for (size_t i = 0; i < ids.size(); i++) {
+			resident += SumFrom(sizes[i], policy.GetResidentTop(ids[i]));
+		}
+
+		if (resident != policy.GetResidentBytes()) {
+			SNK_CHECK(resident == policy.GetResidentBytes());
+			return;
+		}
+	}
+
+	SNK_CHECK(policy.GetResidentBytes() <= policy.budget_bytes);
+}
+
+int main() {
+	Test::Init();
+	TestStreamsUpToRequest();
+	TestEvictsLeastRecentlyRequested();
+	TestDropsOverResidentMipsFirst();
+	TestStreamLimitPerUpdate();
+	TestLoweredBudgetEvictsExpired();
+	TestRandomSoak();
+	return Test::Finish("TEXTURE_RESIDENCY_POLICY_TESTS");
+}
@@ -0,0 +1,147 @@
+#include "TestCommon.h"
+#include "util/VertexEncoding.h"
+
+using namespace SNAKE;
+
+/*
+Round trips vertices through CompactVertex, checking the decoded attributes stay within the precision of their encodings.
+Shaders read the stream both as vertex inputs and as CompactVertexData storage in "VertexEncoding.glsl", the storage layout is checked here too.
+*/
+namespace {
+	constexpr uint32_t NUM_VERTICES = 200'000;
+
+	float AngleDegrees(glm::vec3 a, glm::vec3 b) {
+		return glm::degrees(std::acos(glm::clamp(glm::dot(a, b), -1.f, 1.f)));
+	}
+
+	// GLSL unpackSnorm2x16/unpackHalf2x16 of one word of CompactVertexData, the low 16 bits are the first component
+	glm::vec2 UnpackSnorm2x16(uint32_t word) {
+		return { VertexEncoding::UnpackSnorm16((int16_t)(word & 0xFFFF)), VertexEncoding::UnpackSnorm16((int16_t)(word >> 16)) };
+	}
+
+	glm::vec2 UnpackHalf2x16(uint32_t word) {
+		return { VertexEncoding::UnpackHalf((uint16_t)(word & 0xFFFF)), VertexEncoding::UnpackHalf((uint16_t)(word >> 16)) };
+	}
+
+	bool IsHalfNaN(uint16_t h) {
+		return ((h >> 10) & 0x1F) == 0x1F && (h & 0x3FF);
+	}
+}
+
+static void TestRoundTrip() {
+	ExtraMath::AABB aabb{ { -3.f, -1.f, -7.f }, { 5.f, 2.f, 9.f } };
+	auto quantisation = VertexEncoding::GetQuantisation(aabb);
+	glm::vec3 extent = aabb.max - aabb.min;
+
+	std::mt19937 rng(1);
+	std::normal_distribution<float> normal_dist;
+	std::uniform_real_distribution<float> unit_dist(0.f, 1.f);
+	std::uniform_real_distribution<float> uv_dist(-20.f, 20.f);
+
+	float max_normal_error = 0.f;
+	float max_tangent_error = 0.f;
+	float max_position_error = 0.f;
+	bool uvs_within_half_precision = true;
+	bool signs_match = true;
+
+	for (uint32_t i = 0; i < NUM_VERTICES; i++) {
+		glm::vec3 n = glm::normalize(glm::vec3{ normal_dist(rng), normal_dist(rng), normal_dist(rng) });
+		glm::vec3 t = glm::normalize(glm::vec3{ normal_dist(rng), normal_dist(rng), normal_dist(rng) });
+		glm::vec3 p = aabb.min + extent * glm::vec3{ unit_dist(rng), unit_dist(rng), unit_dist(rng) };
+		glm::vec2 uv{ uv_dist(rng), uv_dist(rng) };
+		float tangent_sign = i % 2 ? 1.f : -1.f;
+
+		auto decoded = VertexEncoding::Decode(VertexEncoding::Encode(p, n, t, tangent_sign, uv, quantisation), quantisation);
+
+		max_normal_error = glm::max(max_normal_error, AngleDegrees(n, decoded.normal));
+		max_tangent_error = glm::max(max_tangent_error, AngleDegrees(t, decoded.tangent));
+		glm::vec3 position_error = glm::abs(decoded.position - p) / extent;
+		max_position_error = std::max({ max_position_error, position_error.x, position_error.y, position_error.z });
+		signs_match &= decoded.tangent_sign == tangent_sign;
+
+		// Half keeps 11 significant bits
+		glm::vec2 uv_error = glm::abs(decoded.tex_coord - uv);
+		uvs_within_half_precision &= uv_error.x <= glm::abs(uv.x) / 2048.f + 1e-7f && uv_error.y <= glm::abs(uv.y) / 2048.f + 1e-7f;
+	}
+
+	SNK_CORE_INFO("Max error: normal {} deg, tangent {} deg, position {} of the extent", max_normal_error, max_tangent_error, max_position_error);
+
+	SNK_CHECK(max_normal_error < 0.1f);
+	SNK_CHECK(max_tangent_error < 0.1f);
+
+	// Half a unorm16 step, plus float rounding
+	SNK_CHECK(max_position_error < 1.f / 65535.f);
+	SNK_CHECK(uvs_within_half_precision);
+	SNK_CHECK(signs_match);
+}
+
+static void TestAxisNormalsExact() {
+	for (glm::vec3 axis : { glm::vec3{ 1, 0, 0 }, glm::vec3{ -1, 0, 0 }, glm::vec3{ 0, 1, 0 }, glm::vec3{ 0, -1, 0 }, glm::vec3{ 0, 0, 1 }, glm::vec3{ 0, 0, -1 } }) {
+		SNK_CHECK(VertexEncoding::OctDecode(VertexEncoding::OctEncode(axis)) == axis);
+	}
+}
+
+static void TestHalfConversion() {
+	// Every half that isn't NaN survives a round trip through float bit for bit
+	uint32_t num_mismatches = 0;
+	for (uint32_t h = 0; h <= std::numeric_limits<uint16_t>::max(); h++) {
+		if (!IsHalfNaN((uint16_t)h) && VertexEncoding::PackHalf(VertexEncoding::UnpackHalf((uint16_t)h)) != h)
+			num_mismatches++;
+	}
+	SNK_CHECK(num_mismatches == 0);
+	SNK_CHECK(IsHalfNaN(VertexEncoding::PackHalf(std::numeric_limits<float>::quiet_NaN())));
+
+	// Largest half, rounding to it and overflowing past it
+	SNK_CHECK(VertexEncoding::UnpackHalf(VertexEncoding::PackHalf(65504.f)) == 65504.f);
+	SNK_CHECK(VertexEncoding::UnpackHalf(VertexEncoding::PackHalf(65519.f)) == 65504.f);
+	SNK_CHECK(std::isinf(VertexEncoding::UnpackHalf(VertexEncoding::PackHalf(65520.f))));
+
+	// Smallest subnormal, and values rounding to it or to zero
+	float min_subnormal = VertexEncoding::UnpackHalf(1);
+	SNK_CHECK(min_subnormal == std::ldexp(1.f, -24));
+	SNK_CHECK(VertexEncoding::PackHalf(3e-8f) == 1);
+	SNK_CHECK(VertexEncoding::PackHalf(2.98e-8f) == 0);
+	SNK_CHECK(VertexEncoding::PackHalf(-1e-8f) == 0x8000);
+}
+
+static void TestStorageLayout() {
+	// Zero vectors have no direction, they still have to decode to a unit vector
+	auto quantisation = VertexEncoding::GetQuantisation(ExtraMath::AABB{ glm::vec3(0.f), glm::vec3(0.f) });
+	auto zero = VertexEncoding::Decode(VertexEncoding::Encode(glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f), 1.f, glm::vec2(0.f), quantisation), quantisation);
+	SNK_CHECK(glm::abs(glm::length(zero.normal) - 1.f) < 1e-5f && glm::abs(glm::length(zero.tangent) - 1.f) < 1e-5f);
+	SNK_CHECK(!glm::any(glm::isnan(zero.position)));
+
+	// CompactVertexData is five words, position xy, position zw, normal, tex coord and tangent
+	static_assert(sizeof(CompactVertex) == 5 * sizeof(uint32_t));
+	static_assert(offsetof(CompactVertex, normal) == 2 * sizeof(uint32_t));
+	static_assert(offsetof(CompactVertex, tex_coord) == 3 * sizeof(uint32_t));
+	static_assert(offsetof(CompactVertex, tangent) == 4 * sizeof(uint32_t));
+
+	ExtraMath::AABB aabb{ { -1.f, -1.f, -1.f }, { 1.f, 1.f, 1.f } };
+	quantisation = VertexEncoding::GetQuantisation(aabb);
+
+	std::mt19937 rng(2);
+	std::normal_distribution<float> normal_dist;
+	bool storage_matches = true;
+	for (uint32_t i = 0; i < 1000; i++) {
+		glm::vec3 n = glm::normalize(glm::vec3{ normal_dist(rng), normal_dist(rng), normal_dist(rng) });
+		glm::vec2 uv{ normal_dist(rng), normal_dist(rng) };
+		auto v = VertexEncoding::Encode(glm::vec3(0.f), n, n, 1.f, uv, quantisation);
+		auto decoded = VertexEncoding::Decode(v, quantisation);
+
+		std::array<uint32_t, 5> words;
+		std::memcpy(words.data(), &v, sizeof(CompactVertex));
+		storage_matches &= VertexEncoding::OctDecode(UnpackSnorm2x16(words[2])) == decoded.normal;
+		storage_matches &= UnpackHalf2x16(words[3]) == decoded.tex_coord;
+	}
+	SNK_CHECK(storage_matches);
+}
+
+int main() {
+	Test::Init();
+	TestRoundTrip();
+	TestAxisNormalsExact();
+	TestHalfConversion();
+	TestStorageLayout();
+	return Test::Finish("VERTEX_ENCODING_TESTS");
+}